@@ -28,6 +28,22 @@ const PALConfig pal_default_config = {
 };
 #endif
 
+#if HAL_USE_MMC_SPI
+/* Board-related functions related to the MMC_SPI driver, the simulated card
+   is always inserted and writable.*/
+bool_t mmc_lld_is_card_inserted(MMCDriver *mmcp) {
+
+  (void)mmcp;
+  return TRUE;
+}
+
+bool_t mmc_lld_is_write_protected(MMCDriver *mmcp) {
+
+  (void)mmcp;
+  return FALSE;
+}
+#endif
+
 /*
  * Board-specific initialization code.
  */
@@ -232,6 +232,19 @@
 #define CH_USE_EVENTS_TIMEOUT           TRUE
 #endif
 
+/**
+ * @brief   Multiple objects wait APIs.
+ * @details If enabled then semaphores, mailboxes and I/O queues embed an
+ *          event source broadcasting their readiness and the
+ *          @p chWOWaitTimeout() API is included in the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_EVENTS.
+ */
+#if !defined(CH_USE_WAITOBJECTS) || defined(__DOXYGEN__)
+#define CH_USE_WAITOBJECTS              TRUE
+#endif
+
 /**
  * @brief   Synchronous Messages APIs.
  * @details If enabled then the synchronous messages APIs are included
@@ -19,6 +19,9 @@
 #include "fs.hpp"
 #include "fatfs_fsimpl.hpp"
 #include "test.h"
+#include "bmkstreams.hpp"
+#include "bmkstatic.hpp"
+#include "bmkcoop.hpp"
 
 using namespace chibios_rt;
 using namespace chibios_fatfs;
@@ -191,6 +194,9 @@ int main(void) {
     if (palReadPad(GPIOA, GPIOA_BUTTON)) {
       tester.start(NORMALPRIO);
       tester.wait();
+      bmkStreamsExecute((BaseSequentialStream *)&SD2);
+      bmkStaticExecute((BaseSequentialStream *)&SD2);
+      bmkCoopExecute((BaseSequentialStream *)&SD2);
     };
     BaseThread::sleep(MS2ST(500));
   }
@@ -0,0 +1,97 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ch.hpp"
+#include "hal.h"
+#include "bmkstreams.hpp"
+#include "bmkstatic.hpp"
+#include "bmkcoop.hpp"
+
+using namespace chibios_rt;
+
+/*
+ * Console stream, it implements the virtual interface so it can be passed
+ * to chprintf() as a BaseSequentialStream.
+ */
+class ConsoleStream : public BaseSequentialStreamInterface {
+public:
+  virtual size_t write(const uint8_t *bp, size_t n) {
+
+    return fwrite(bp, 1, n, stdout);
+  }
+
+  virtual size_t read(uint8_t *bp, size_t n) {
+
+    (void)bp;
+    (void)n;
+    return 0;
+  }
+
+  virtual msg_t put(uint8_t b) {
+
+    return putchar(b) == EOF ? Q_RESET : Q_OK;
+  }
+
+  virtual msg_t get(void) {
+
+    return Q_RESET;
+  }
+};
+
+static ConsoleStream console;
+
+/*------------------------------------------------------------------------*
+ * Simulator main.                                                        *
+ *------------------------------------------------------------------------*/
+int main(void) {
+  bool result;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  System::init();
+
+  /*
+   * Streams benchmark, it compares the C++ queue wrappers and the virtual
+   * stream interface against the statically dispatched templates.
+   */
+  result = bmkStreamsExecute((BaseSequentialStream *)&console);
+
+  /*
+   * Static system description benchmark, it compares the startup cost and
+   * the memory footprint of the C++ wrappers constructors against the
+   * statically initialized objects.
+   */
+  result = bmkStaticExecute((BaseSequentialStream *)&console) && result;
+
+  /*
+   * Cooperative tasks benchmark, it compares the memory footprint and the
+   * switch cost of stackless tasks against real threads.
+   */
+  result = bmkCoopExecute((BaseSequentialStream *)&console) && result;
+  fflush(stdout);
+
+  return result ? 0 : 1;
+}
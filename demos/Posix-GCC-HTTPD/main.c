@@ -0,0 +1,514 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simsdc.h"
+
+#include "ff.h"
+#include "httpd.h"
+#include "lwipthread.h"
+
+#include "lwip/api.h"
+#include "simtest.h"
+
+/*
+ * Disk image size.
+ */
+#define IMAGE_SIZE          (16 * 1024 * 1024)
+
+/*
+ * Benchmark parameters.
+ */
+#define N_KEEPALIVE         1000
+#define N_PIPELINED         16
+#define N_CONNECTIONS       200
+#define N_BULK              4
+
+/*
+ * Content of the disk, the files data is a pattern depending on a seed.
+ */
+static const struct {
+  const char    *path;
+  DWORD         size;
+  unsigned      seed;
+} files[] = {
+  {"/index.html",       1500,               1},
+  {"/index.html.gz",    700,                2},
+  {"/app.js",           30000,              3},
+  {"/app.js.gz",        9000,               4},
+  {"/big.bin",          4 * 1024 * 1024,    5},
+  {"/img",              0,                  0},
+  {"/img/logo.png",     5000,               6},
+};
+
+#define INDEX_HTML          0
+#define INDEX_HTML_GZ       1
+#define APP_JS_GZ           3
+#define BIG_BIN             4
+#define LOGO_PNG            6
+
+static char wire[64], image[80];
+static pid_t parent;
+static volatile bool_t terminate;
+
+static uint8_t server_mac[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x46};
+static uint8_t client_mac[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x47};
+
+static struct lwipthread_opts opts;
+
+static uint8_t buffer[8192];
+
+static uint32_t ip4(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+  struct ip_addr ip;
+
+  IP4_ADDR(&ip, a, b, c, d);
+  return ip.addr;
+}
+
+static uint8_t pattern(unsigned seed, uint32_t i) {
+
+  return (uint8_t)(seed * 37 + i + (i >> 8) * 3);
+}
+
+/*===========================================================================*/
+/* Server.                                                                   */
+/*===========================================================================*/
+
+static SimSDCard sdc;
+static const SPIConfig hs_spicfg = {NULL, (SPISlaveModel *)&sdc};
+static const SPIConfig ls_spicfg = {NULL, (SPISlaveModel *)&sdc};
+static const MMCConfig mmccfg = {&SPID1, &ls_spicfg, &hs_spicfg};
+MMCDriver MMCD1;
+
+static FATFS fs;
+
+static void sigterm(int sig) {
+
+  (void)sig;
+  terminate = TRUE;
+}
+
+/*
+ * Formats the disk and writes the content.
+ */
+static bool_t make_content(void) {
+  unsigned i;
+  FIL fil;
+
+  if ((f_mount(0, &fs) != FR_OK) || (f_mkfs(0, 1, 0) != FR_OK))
+    return CH_FAILED;
+  for (i = 0; i < sizeof files / sizeof files[0]; i++) {
+    DWORD pos;
+
+    if (files[i].seed == 0) {
+      if (f_mkdir(files[i].path) != FR_OK)
+        return CH_FAILED;
+      continue;
+    }
+    if (f_open(&fil, files[i].path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+      return CH_FAILED;
+    for (pos = 0; pos < files[i].size; ) {
+      UINT j, n, bw;
+
+      n = files[i].size - pos < sizeof buffer ? files[i].size - pos :
+                                                sizeof buffer;
+      for (j = 0; j < n; j++)
+        buffer[j] = pattern(files[i].seed, pos + j);
+      if ((f_write(&fil, buffer, n, &bw) != FR_OK) || (bw != n))
+        return CH_FAILED;
+      pos += n;
+    }
+    if (f_close(&fil) != FR_OK)
+      return CH_FAILED;
+  }
+  return CH_SUCCESS;
+}
+
+static void server(void) {
+  FILE *f;
+  HTTPDStats stats;
+
+  signal(SIGTERM, sigterm);
+
+  /* File backed disk.*/
+  f = fopen(image, "wb");
+  simtest_check((f == NULL) || (ftruncate(fileno(f), IMAGE_SIZE) != 0),
+                "Image creation");
+  fclose(f);
+  simsdcObjectInit(&sdc);
+  simtest_check(simsdcOpen(&sdc, image), "Card insertion");
+  mmcObjectInit(&MMCD1);
+  mmcStart(&MMCD1, &mmccfg);
+  simtest_check(mmcConnect(&MMCD1), "Card connection");
+  simtest_check(make_content(), "File system creation");
+  simtest_check(httpdIndexBuild(""), "Content index");
+
+  opts.macaddress = server_mac;
+  opts.address    = ip4(192, 168, 1, 20);
+  opts.netmask    = ip4(255, 255, 255, 0);
+  opts.gateway    = ip4(192, 168, 1, 1);
+  macSimSetWire(&ETHD1, wire, 0);
+  chThdCreateStatic(wa_lwip_thread, sizeof(wa_lwip_thread), NORMALPRIO + 1,
+                    lwip_thread, &opts);
+  chThdCreateStatic(wa_httpd_server, sizeof(wa_httpd_server), NORMALPRIO + 1,
+                    httpd_server, NULL);
+
+  /* A forked server terminates with the client.*/
+  while (!terminate && ((parent == 0) || (getppid() == parent)))
+    chThdSleepMilliseconds(100);
+
+  httpdGetStats(&stats);
+  printf("Server statistics\n");
+  printf("  %-38s: %u/%u\n", "Connections/requests",
+         stats.connections, stats.requests);
+  printf("  %-38s: %u\n", "Requests on persistent connections",
+         stats.reused);
+  printf("  %-38s: %u/%u/%u/%u\n", "Ranges/compressed/not modified/errors",
+         stats.ranges, stats.compressed, stats.notmodified, stats.errors);
+  printf("  %-38s: %u\n", "Bytes passed by reference", stats.bytes);
+  printf("  %-38s: %u\n", "Waits for acknowledged buffers", stats.bufwaits);
+  printf("  %-38s: %u\n", "Blocks read by the card",
+         (unsigned)sdc.blocks_read);
+  simsdcClose(&sdc);
+  unlink(image);
+  exit(0);
+}
+
+/*===========================================================================*/
+/* Client.                                                                   */
+/*===========================================================================*/
+
+/*
+ * Connection with a partially consumed received netbuf.
+ */
+typedef struct {
+  struct netconn    *conn;
+  struct netbuf     *nb;
+  u16_t             off;
+} client_t;
+
+/*
+ * Response fields.
+ */
+typedef struct {
+  unsigned          status;
+  DWORD             length;
+  DWORD             first;
+  bool_t            gzip;
+  bool_t            close;
+  char              etag[16];
+} response_t;
+
+static bool_t client_open(client_t *cp) {
+  struct ip_addr ip;
+  unsigned i;
+
+  ip.addr = ip4(192, 168, 1, 20);
+  cp->nb = NULL;
+  for (i = 0; i < 50; i++) {
+    cp->conn = netconn_new(NETCONN_TCP);
+    if (netconn_connect(cp->conn, &ip, HTTPD_PORT) == ERR_OK)
+      return CH_SUCCESS;
+    netconn_delete(cp->conn);
+    chThdSleepMilliseconds(100);
+  }
+  return CH_FAILED;
+}
+
+static void client_close(client_t *cp) {
+
+  if (cp->nb != NULL)
+    netbuf_delete(cp->nb);
+  netconn_close(cp->conn);
+  netconn_delete(cp->conn);
+}
+
+/*
+ * Reads up to n bytes, at least one, returns zero on failure.
+ */
+static size_t client_read(client_t *cp, uint8_t *p, size_t n) {
+  u16_t len;
+
+  if (cp->nb == NULL) {
+    if (netconn_recv(cp->conn, &cp->nb) != ERR_OK) {
+      cp->nb = NULL;
+      return 0;
+    }
+    cp->off = 0;
+  }
+  len = netbuf_copy_partial(cp->nb, p, n > 0xFFFF ? 0xFFFF : n, cp->off);
+  cp->off += len;
+  if (cp->off >= netbuf_len(cp->nb)) {
+    netbuf_delete(cp->nb);
+    cp->nb = NULL;
+  }
+  return len;
+}
+
+static bool_t client_send(client_t *cp, const char *request) {
+
+  return netconn_write(cp->conn, request, strlen(request),
+                       NETCONN_COPY) != ERR_OK;
+}
+
+/*
+ * Receives a response header.
+ */
+static bool_t receive_header(client_t *cp, response_t *rp) {
+  static char header[512];
+  char *p;
+  size_t n = 0;
+
+  memset(rp, 0, sizeof *rp);
+  while ((n < 4) || (memcmp(&header[n - 4], "\r\n\r\n", 4) != 0)) {
+    if ((n >= sizeof header - 1) ||
+        (client_read(cp, (uint8_t *)&header[n], 1) == 0))
+      return CH_FAILED;
+    n++;
+  }
+  header[n] = '\0';
+  if (strncmp(header, "HTTP/1.1 ", 9) != 0)
+    return CH_FAILED;
+  rp->status = atoi(header + 9);
+  if ((p = strstr(header, "Content-Length: ")) != NULL)
+    rp->length = strtoul(p + 16, NULL, 10);
+  if ((p = strstr(header, "Content-Range: bytes ")) != NULL)
+    rp->first = strtoul(p + 21, NULL, 10);
+  if ((p = strstr(header, "ETag: ")) != NULL)
+    sscanf(p + 6, "%15s", rp->etag);
+  rp->gzip = strstr(header, "Content-Encoding: gzip") != NULL;
+  rp->close = strstr(header, "Connection: close") != NULL;
+  return CH_SUCCESS;
+}
+
+/*
+ * Receives a response content and compares it with a file pattern.
+ */
+static bool_t receive_content(client_t *cp, response_t *rp, unsigned seed) {
+  DWORD pos = 0;
+  bool_t failed = FALSE;
+
+  while (pos < rp->length) {
+    size_t i, n = rp->length - pos;
+
+    n = client_read(cp, buffer, n < sizeof buffer ? n : sizeof buffer);
+    if (n == 0)
+      return CH_FAILED;
+    for (i = 0; i < n; i++)
+      failed |= buffer[i] != pattern(seed, rp->first + pos + i);
+    pos += n;
+  }
+  return failed;
+}
+
+/*
+ * Sends a request and receives the response.
+ */
+static bool_t get(client_t *cp, const char *request, response_t *rp,
+                  unsigned status, unsigned file) {
+
+  if (client_send(cp, request) || receive_header(cp, rp) ||
+      (rp->status != status))
+    return CH_FAILED;
+  if (strncmp(request, "HEAD", 4) == 0)
+    return CH_SUCCESS;
+  if ((status == 200) && (rp->length != files[file].size))
+    return CH_FAILED;
+  return receive_content(cp, rp, files[file].seed);
+}
+
+static void client(void) {
+  static char request[256];
+  client_t c;
+  response_t r;
+  uint64_t start, elapsed;
+  unsigned i, reconnections;
+  bool_t failed;
+
+  opts.macaddress = client_mac;
+  opts.address    = ip4(192, 168, 1, 21);
+  opts.netmask    = ip4(255, 255, 255, 0);
+  opts.gateway    = ip4(192, 168, 1, 1);
+  macSimSetWire(&ETHD1, wire, 1);
+  chThdCreateStatic(wa_lwip_thread, sizeof(wa_lwip_thread), NORMALPRIO + 1,
+                    lwip_thread, &opts);
+
+  /*
+   * Functional checks on a persistent connection.
+   */
+  simtest_check(client_open(&c), "Connection to the server");
+  simtest_check(get(&c, "GET / HTTP/1.1\r\nHost: test\r\n\r\n",
+                    &r, 200, INDEX_HTML) || r.close || r.gzip, "Index page");
+  simtest_check(get(&c, "GET /index.html HTTP/1.1\r\n"
+                        "Accept-Encoding: gzip, deflate\r\n\r\n",
+                    &r, 200, INDEX_HTML_GZ) || !r.gzip,
+                "Precompressed variant");
+  simtest_check(get(&c, "GET /img/logo.png HTTP/1.1\r\n\r\n",
+                    &r, 200, LOGO_PNG), "File in a subdirectory");
+  simtest_check(get(&c, "GET /app.js HTTP/1.1\r\n"
+                        "Accept-Encoding: gzip\r\n"
+                        "Range: bytes=1000-2999\r\n\r\n",
+                    &r, 206, APP_JS_GZ) || (r.first != 1000) ||
+                (r.length != 2000),
+                "Range of the precompressed variant");
+  simtest_check(get(&c, "GET /big.bin HTTP/1.1\r\nRange: bytes=100001-\r\n\r\n",
+                    &r, 206, BIG_BIN) || (r.first != 100001) ||
+                (r.length != files[BIG_BIN].size - 100001), "Open ended range");
+  simtest_check(get(&c, "GET /big.bin HTTP/1.1\r\nRange: bytes=-777\r\n\r\n",
+                    &r, 206, BIG_BIN) || (r.length != 777), "Suffix range");
+  simtest_check(get(&c, "GET /big.bin HTTP/1.1\r\n"
+                        "Range: bytes=99999999-\r\n\r\n", &r, 416, BIG_BIN),
+                "Unsatisfiable range");
+  simtest_check(get(&c, "HEAD /index.html HTTP/1.1\r\n\r\n",
+                    &r, 200, INDEX_HTML) ||
+                (r.length != files[INDEX_HTML].size), "HEAD request");
+  snprintf(request, sizeof request,
+           "GET /index.html HTTP/1.1\r\nIf-None-Match: %s\r\n\r\n", r.etag);
+  simtest_check(get(&c, request, &r, 304, INDEX_HTML), "Not modified");
+  simtest_check(get(&c, "GET /missing.html HTTP/1.1\r\n\r\n",
+                    &r, 404, INDEX_HTML), "Missing file");
+  simtest_check(get(&c, "GET /index.html HTTP/1.1\r\nConnection: close\r\n\r\n",
+                    &r, 200, INDEX_HTML) || !r.close, "Connection close");
+  client_close(&c);
+
+  /*
+   * Small file requests on persistent connections, the server closes a
+   * connection after HTTPD_MAX_REQUESTS requests.
+   */
+  simtest_check(client_open(&c), "Connection to the server");
+  failed = FALSE;
+  reconnections = 0;
+  start = simtest_now_ns();
+  for (i = 0; (i < N_KEEPALIVE) && !failed; i++) {
+    failed = get(&c, "GET /index.html HTTP/1.1\r\n\r\n", &r, 200, INDEX_HTML);
+    if (!failed && r.close) {
+      client_close(&c);
+      failed = client_open(&c);
+      reconnections++;
+    }
+  }
+  elapsed = simtest_now_ns() - start;
+  printf("Persistent connections\n");
+  printf("  %-38s: %u/%u\n", "Requests/connections",
+         N_KEEPALIVE, reconnections + 1);
+  printf("  %-38s: %u requests/s\n", "Rate",
+         (unsigned)(N_KEEPALIVE * 1000000000ULL / elapsed));
+  simtest_check(failed, "  Responses");
+
+  /*
+   * Pipelined requests, all the requests are sent before reading the
+   * responses.
+   */
+  start = simtest_now_ns();
+  failed = FALSE;
+  for (i = 0; i < N_PIPELINED; i++)
+    failed |= client_send(&c, "GET /img/logo.png HTTP/1.1\r\n\r\n");
+  for (i = 0; (i < N_PIPELINED) && !failed; i++)
+    failed = receive_header(&c, &r) || (r.status != 200) ||
+             receive_content(&c, &r, files[LOGO_PNG].seed);
+  elapsed = simtest_now_ns() - start;
+  printf("Pipelined requests\n");
+  printf("  %-38s: %u\n", "Requests", N_PIPELINED);
+  printf("  %-38s: %u us\n", "Time", (unsigned)(elapsed / 1000));
+  simtest_check(failed, "  Responses");
+
+  /*
+   * Large file transfers.
+   */
+  failed = FALSE;
+  start = simtest_now_ns();
+  for (i = 0; (i < N_BULK) && !failed; i++)
+    failed = get(&c, "GET /big.bin HTTP/1.1\r\n\r\n", &r, 200, BIG_BIN);
+  elapsed = simtest_now_ns() - start;
+  client_close(&c);
+  printf("Large file\n");
+  printf("  %-38s: %u bytes\n", "Transferred",
+         (unsigned)(N_BULK * files[BIG_BIN].size));
+  printf("  %-38s: %u Mbit/s\n", "Throughput",
+         (unsigned)((uint64_t)N_BULK * files[BIG_BIN].size * 8000 / elapsed));
+  simtest_check(failed, "  Content");
+
+  /*
+   * A connection for each request.
+   */
+  failed = FALSE;
+  start = simtest_now_ns();
+  for (i = 0; (i < N_CONNECTIONS) && !failed; i++) {
+    failed = client_open(&c) ||
+             get(&c, "GET /index.html HTTP/1.0\r\n\r\n", &r, 200, INDEX_HTML) ||
+             !r.close;
+    client_close(&c);
+  }
+  elapsed = simtest_now_ns() - start;
+  printf("Connection for each request\n");
+  printf("  %-38s: %u\n", "Requests", N_CONNECTIONS);
+  printf("  %-38s: %u requests/s\n", "Rate",
+         (unsigned)(N_CONNECTIONS * 1000000000ULL / elapsed));
+  simtest_check(failed, "  Responses");
+}
+
+/*
+ * Application entry point.
+ */
+int main(int argc, char *argv[]) {
+  pid_t pid;
+
+  /*
+   * Without arguments the program forks into a server and a client
+   * attached to the two endpoints of a private wire, the server disk
+   * image is placed next to the wire sockets.
+   */
+  if (argc > 1) {
+    strncpy(wire, SIM_MAC1_WIRE, sizeof (wire) - 1);
+    strncpy(image, "httpd.img", sizeof (image) - 1);
+    pid = strcmp(argv[1], "server") == 0 ? 0 : -1;
+  }
+  else {
+    parent = getpid();
+    snprintf(wire, sizeof (wire), "/tmp/chibios-httpd-%u", (unsigned)parent);
+    snprintf(image, sizeof (image), "%s.img", wire);
+    pid = fork();
+  }
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  if (pid == 0)
+    server();
+  client();
+
+  if (pid > 0) {
+    fflush(stdout);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -0,0 +1,503 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "lwipthread.h"
+
+#include "lwip/api.h"
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+#include "simtest.h"
+
+/*
+ * Services ports.
+ */
+#define ECHO_PORT           7
+#define SINK_PORT           9
+
+/*
+ * Benchmark parameters.
+ */
+#define N_PINGS             1000
+#define PING_SIZE           64
+#define BULK_SIZE           (16 * 1024 * 1024)
+#define BULK_CHUNK          8192
+#define CHURN_ROUNDS        20
+#define CHURN_THREADS       4
+#define CHURN_CONNECTIONS   10
+
+static char wire1[64], wire2[64];
+static pid_t parent;
+
+static uint8_t server_mac1[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x46};
+static uint8_t server_mac2[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x56};
+static uint8_t client_mac1[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x47};
+static uint8_t client_mac2[6] = {0xC2, 0xAF, 0x51, 0x03, 0xCF, 0x57};
+
+static struct lwipthread_opts opts1, opts2;
+
+/*
+ * The server receives the frames of each interface by a dedicated input
+ * thread, the client receives the frames of both interfaces by the LWIP
+ * thread.
+ */
+static WORKING_AREA(waInput1, 8192);
+static WORKING_AREA(waInput2, 8192);
+
+static const LWIPInterfaceConfig server_if1 = {
+  &ETHD1, &opts1, waInput1, sizeof(waInput1), NORMALPRIO + 1
+};
+static const LWIPInterfaceConfig server_if2 = {
+  &ETHD2, &opts2, waInput2, sizeof(waInput2), NORMALPRIO + 1
+};
+static const LWIPInterfaceConfig client_if1 = {&ETHD1, &opts1, NULL, 0, 0};
+static const LWIPInterfaceConfig client_if2 = {&ETHD2, &opts2, NULL, 0, 0};
+
+static LWIPInterface interfaces[2];
+static const LWIPThreadConfig lwip_config = {interfaces, 2};
+
+static uint8_t bulk[BULK_CHUNK];
+
+static uint32_t ip4(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+  struct ip_addr ip;
+
+  IP4_ADDR(&ip, a, b, c, d);
+  return ip.addr;
+}
+
+/*
+ * Interfaces setup, the interface 1 is on the 192.168.1.0 network and the
+ * interface 2 is on the 192.168.2.0 network.
+ */
+static void start_lwip(uint8_t *mac1, uint8_t *mac2, uint8_t host,
+                       unsigned end) {
+
+  opts1.macaddress = mac1;
+  opts1.address    = ip4(192, 168, 1, host);
+  opts1.netmask    = ip4(255, 255, 255, 0);
+  opts1.gateway    = ip4(192, 168, 1, 1);
+  opts2.macaddress = mac2;
+  opts2.address    = ip4(192, 168, 2, host);
+  opts2.netmask    = ip4(255, 255, 255, 0);
+  opts2.gateway    = ip4(192, 168, 2, 1);
+  macSimSetWire(&ETHD1, wire1, end);
+  macSimSetWire(&ETHD2, wire2, end);
+  chThdCreateStatic(wa_lwip_thread, sizeof(wa_lwip_thread), NORMALPRIO + 1,
+                    lwip_multi_thread, (void *)&lwip_config);
+}
+
+/*
+ * Echo connection, the received data is sent back. Each connection is
+ * served by a thread created by sys_thread_new(), its working area is
+ * reused by the following connections.
+ */
+static void EchoConnection(void *arg) {
+  struct netconn *conn = arg;
+  struct netbuf *buf;
+
+  while (netconn_recv(conn, &buf) == ERR_OK) {
+    do {
+      void *data;
+      u16_t len;
+
+      netbuf_data(buf, &data, &len);
+      netconn_write(conn, data, len, NETCONN_COPY);
+    } while (netbuf_next(buf) >= 0);
+    netbuf_delete(buf);
+  }
+  netconn_close(conn);
+  netconn_delete(conn);
+}
+
+/*
+ * Echo service.
+ */
+static WORKING_AREA(waEcho, 8192);
+static msg_t Echo(void *arg) {
+  struct netconn *conn, *newconn;
+
+  (void)arg;
+  chRegSetThreadName("echo");
+  conn = netconn_new(NETCONN_TCP);
+  netconn_bind(conn, NULL, ECHO_PORT);
+  netconn_listen(conn);
+  while (TRUE) {
+    if (netconn_accept(conn, &newconn) != ERR_OK)
+      continue;
+    if (sys_thread_new("echoconn", EchoConnection, newconn,
+                       DEFAULT_THREAD_STACKSIZE, NORMALPRIO) == NULL) {
+      netconn_close(newconn);
+      netconn_delete(newconn);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Sink service, the data size is received first then the data is counted
+ * and the count is sent back when the whole data has been received.
+ */
+static WORKING_AREA(waSink, 8192);
+static msg_t Sink(void *arg) {
+  struct netconn *conn, *newconn;
+
+  (void)arg;
+  chRegSetThreadName("sink");
+  conn = netconn_new(NETCONN_TCP);
+  netconn_bind(conn, NULL, SINK_PORT);
+  netconn_listen(conn);
+  while (TRUE) {
+    struct netbuf *buf;
+    uint32_t size = 0, count = 0;
+
+    if (netconn_accept(conn, &newconn) != ERR_OK)
+      continue;
+    while ((count < size + sizeof (size)) &&
+           (netconn_recv(newconn, &buf) == ERR_OK)) {
+      if (count == 0)
+        netbuf_copy(buf, &size, sizeof (size));
+      count += netbuf_len(buf);
+      netbuf_delete(buf);
+    }
+    count -= sizeof (size);
+    netconn_write(newconn, &count, sizeof (count), NETCONN_COPY);
+    netconn_close(newconn);
+    netconn_delete(newconn);
+  }
+  return 0;
+}
+
+/*
+ * Receives exactly n bytes from a connection.
+ */
+static bool_t receive(struct netconn *conn, uint8_t *p, size_t n) {
+  struct netbuf *buf;
+
+  while (n > 0) {
+    u16_t len;
+
+    if (netconn_recv(conn, &buf) != ERR_OK)
+      return FALSE;
+    len = netbuf_copy(buf, p, n);
+    netbuf_delete(buf);
+    p += len;
+    n -= len;
+  }
+  return TRUE;
+}
+
+static struct netconn *open_service(uint8_t net, uint16_t port) {
+  struct netconn *conn;
+  struct ip_addr ip;
+  unsigned i;
+
+  ip.addr = ip4(192, 168, net, 20);
+  for (i = 0; i < 50; i++) {
+    conn = netconn_new(NETCONN_TCP);
+    if (netconn_connect(conn, &ip, port) == ERR_OK)
+      return conn;
+    netconn_delete(conn);
+    chThdSleepMilliseconds(100);
+  }
+  return NULL;
+}
+
+static void server(void) {
+
+  interfaces[0].config = &server_if1;
+  interfaces[1].config = &server_if2;
+  start_lwip(server_mac1, server_mac2, 20, 0);
+
+  chThdCreateStatic(waEcho, sizeof(waEcho), NORMALPRIO, Echo, NULL);
+  chThdCreateStatic(waSink, sizeof(waSink), NORMALPRIO, Sink, NULL);
+
+  /* A forked server terminates with the client.*/
+  while ((parent == 0) || (getppid() == parent))
+    chThdSleepMilliseconds(500);
+  exit(0);
+}
+
+/*
+ * Round trip latency through the echo service.
+ */
+static bool_t echo(uint8_t net, uint64_t *average, uint64_t *best) {
+  static uint8_t ping[PING_SIZE], pong[PING_SIZE];
+  struct netconn *conn;
+  uint64_t elapsed;
+  bool_t failed;
+  unsigned i;
+
+  conn = open_service(net, ECHO_PORT);
+  if (conn == NULL)
+    return TRUE;
+  failed = FALSE;
+  elapsed = 0;
+  *best = ~0ULL;
+  for (i = 0; i < N_PINGS; i++) {
+    uint64_t t = simtest_now_ns();
+
+    memset(ping, i, sizeof (ping));
+    if ((netconn_write(conn, ping, sizeof (ping), NETCONN_COPY) != ERR_OK) ||
+        !receive(conn, pong, sizeof (pong)) ||
+        (memcmp(ping, pong, sizeof (ping)) != 0)) {
+      failed = TRUE;
+      break;
+    }
+    t = simtest_now_ns() - t;
+    elapsed += t;
+    if (t < *best)
+      *best = t;
+  }
+  *average = elapsed / N_PINGS;
+  netconn_close(conn);
+  netconn_delete(conn);
+  return failed;
+}
+
+/*
+ * Bulk transfer to the sink service.
+ */
+static bool_t transfer(uint8_t net, uint64_t *elapsed) {
+  struct netconn *conn;
+  uint64_t start;
+  uint32_t count;
+  bool_t failed;
+  unsigned i;
+
+  conn = open_service(net, SINK_PORT);
+  if (conn == NULL)
+    return TRUE;
+  count = BULK_SIZE;
+  failed = netconn_write(conn, &count, sizeof (count), NETCONN_COPY) != ERR_OK;
+  start = simtest_now_ns();
+  for (i = 0; i < BULK_SIZE / BULK_CHUNK; i++)
+    if (netconn_write(conn, bulk, sizeof (bulk), NETCONN_NOCOPY) != ERR_OK) {
+      failed = TRUE;
+      break;
+    }
+  failed |= !receive(conn, (uint8_t *)&count, sizeof (count));
+  *elapsed = simtest_now_ns() - start;
+  netconn_close(conn);
+  netconn_delete(conn);
+  return failed || (count != BULK_SIZE);
+}
+
+/*
+ * Bulk transfer on the interface 1 running concurrently with the echo
+ * test on the interface 2.
+ */
+static uint64_t bulk_elapsed;
+static WORKING_AREA(waBulk, 8192);
+static msg_t Bulk(void *arg) {
+
+  (void)arg;
+  chRegSetThreadName("bulk");
+  return (msg_t)transfer(1, &bulk_elapsed);
+}
+
+/*
+ * Connections churn, short lived threads open and close connections to
+ * the echo service.
+ */
+static SEMAPHORE_DECL(churn_sem, 0);
+static bool_t churn_failed;
+
+static void ChurnThread(void *arg) {
+  struct netconn *conn;
+  uint8_t ping = 0x55, pong;
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < CHURN_CONNECTIONS; i++) {
+    conn = open_service(2, ECHO_PORT);
+    if (conn == NULL) {
+      churn_failed = TRUE;
+      break;
+    }
+    if ((netconn_write(conn, &ping, 1, NETCONN_COPY) != ERR_OK) ||
+        !receive(conn, &pong, 1) || (pong != ping))
+      churn_failed = TRUE;
+    netconn_close(conn);
+    netconn_delete(conn);
+  }
+  chSemSignal(&churn_sem);
+}
+
+static void churn(void) {
+  unsigned i, n = 0;
+
+  for (i = 0; i < CHURN_THREADS; i++) {
+    if (sys_thread_new("churn", ChurnThread, NULL,
+                       DEFAULT_THREAD_STACKSIZE, NORMALPRIO) != NULL)
+      n++;
+    else
+      churn_failed = TRUE;
+  }
+  while (n--)
+    chSemWait(&churn_sem);
+}
+
+static void print_interface(const char *name, LWIPInterface *ifp,
+                            MACDriver *macp) {
+  LWIPInterfaceStats stats;
+
+  lwipGetInterfaceStats(ifp, &stats);
+  printf("%s\n", name);
+  printf("  %-38s: %u/%u\n", "Frames transmitted/received",
+         stats.txframes, stats.rxframes);
+  printf("  %-38s: %u/%u\n", "Receive wakeups/max queue depth",
+         stats.rxbatches, stats.rxbatchmax);
+  printf("  %-38s: %u/%u/%u\n", "Dropped nomem/queue full/tx timeout",
+         stats.rxnomem, stats.rxqueuefull, stats.txtimeouts);
+  printf("  %-38s: %u\n", "MAC receive frames lost", macp->rxlost);
+}
+
+static void client(void) {
+  Thread *tp;
+  uint64_t average, best, elapsed;
+  bool_t failed;
+  unsigned i;
+
+  interfaces[0].config = &client_if1;
+  interfaces[1].config = &client_if2;
+  start_lwip(client_mac1, client_mac2, 21, 1);
+
+  failed = echo(2, &average, &best);
+  printf("TCP echo on interface 2\n");
+  printf("  %-38s: %u us\n", "Average round trip",
+         (unsigned)(average / 1000));
+  printf("  %-38s: %u us\n", "Best round trip", (unsigned)(best / 1000));
+  simtest_check(failed, "  Echoed data");
+
+  failed = transfer(1, &elapsed);
+  printf("TCP bulk transfer on interface 1\n");
+  printf("  %-38s: %u bytes\n", "Transferred", BULK_SIZE);
+  printf("  %-38s: %u Mbit/s\n", "Throughput",
+         (unsigned)(((uint64_t)BULK_SIZE * 8000) / elapsed));
+  simtest_check(failed, "  Bytes received by the sink");
+
+  tp = chThdCreateStatic(waBulk, sizeof(waBulk), NORMALPRIO, Bulk, NULL);
+  failed = echo(2, &average, &best);
+  printf("TCP echo on interface 2 during the bulk transfer\n");
+  printf("  %-38s: %u us\n", "Average round trip",
+         (unsigned)(average / 1000));
+  printf("  %-38s: %u us\n", "Best round trip", (unsigned)(best / 1000));
+  simtest_check(failed, "  Echoed data");
+  failed = (bool_t)chThdWait(tp);
+  printf("  %-38s: %u Mbit/s\n", "Bulk throughput",
+         (unsigned)(((uint64_t)BULK_SIZE * 8000) / bulk_elapsed));
+  simtest_check(failed, "  Bytes received by the sink");
+
+  /*
+   * The memory used by semaphores, mailboxes and threads working areas
+   * must not grow after the first round.
+   */
+  {
+    size_t core;
+    unsigned sems, mboxes;
+
+    churn();
+    core = chCoreStatus();
+    sems = lwip_stats.sys.sem.used;
+    mboxes = lwip_stats.sys.mbox.used;
+    for (i = 1; i < CHURN_ROUNDS; i++)
+      churn();
+    printf("Connections churn\n");
+    printf("  %-38s: %u\n", "Connections",
+           CHURN_ROUNDS * CHURN_THREADS * CHURN_CONNECTIONS);
+    printf("  %-38s: %u/%u\n", "Core free after first/last round",
+           (unsigned)core, (unsigned)chCoreStatus());
+    printf("  %-38s: %u/%u/%u\n", "Semaphores used/max/errors",
+           lwip_stats.sys.sem.used, lwip_stats.sys.sem.max,
+           lwip_stats.sys.sem.err);
+    printf("  %-38s: %u/%u/%u\n", "Mailboxes used/max/errors",
+           lwip_stats.sys.mbox.used, lwip_stats.sys.mbox.max,
+           lwip_stats.sys.mbox.err);
+    simtest_check(churn_failed, "  Echoed data");
+    simtest_check((chCoreStatus() != core) ||
+                  (lwip_stats.sys.sem.used != sems) ||
+                  (lwip_stats.sys.mbox.used != mboxes),
+                  "  Flat memory profile");
+  }
+
+  /*
+   * Statistics useful for the pbufs and buffers tuning.
+   */
+  printf("Statistics\n");
+  printf("  %-38s: %u/%u\n", "Link frames transmitted/received",
+         lwip_stats.link.xmit, lwip_stats.link.recv);
+  printf("  %-38s: %u\n", "Link frames dropped", lwip_stats.link.drop);
+  printf("  %-38s: %u/%u\n", "PBUF_POOL max used/size",
+         lwip_stats.memp[MEMP_PBUF_POOL].max, PBUF_POOL_SIZE);
+  printf("  %-38s: %u\n", "PBUF_POOL allocation failures",
+         lwip_stats.memp[MEMP_PBUF_POOL].err);
+  print_interface("Interface 1", &interfaces[0], &ETHD1);
+  print_interface("Interface 2", &interfaces[1], &ETHD2);
+}
+
+/*
+ * Application entry point.
+ */
+int main(int argc, char *argv[]) {
+  pid_t pid;
+
+  /*
+   * Without arguments the program forks into a server and a client
+   * attached to the endpoints of two private wires.
+   */
+  if (argc > 1) {
+    strncpy(wire1, SIM_MAC1_WIRE, sizeof (wire1) - 1);
+    strncpy(wire2, SIM_MAC2_WIRE, sizeof (wire2) - 1);
+    pid = strcmp(argv[1], "server") == 0 ? 0 : -1;
+  }
+  else {
+    parent = getpid();
+    snprintf(wire1, sizeof (wire1), "/tmp/chibios-lwip-%u-1",
+             (unsigned)parent);
+    snprintf(wire2, sizeof (wire2), "/tmp/chibios-lwip-%u-2",
+             (unsigned)parent);
+    pid = fork();
+  }
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  if (pid == 0)
+    server();
+  client();
+
+  if (pid > 0) {
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+  }
+  return 0;
+}
@@ -79,6 +79,13 @@
 #define HAL_USE_I2C                 FALSE
 #endif
 
+/**
+ * @brief   Enables the I2S subsystem.
+ */
+#if !defined(HAL_USE_I2S) || defined(__DOXYGEN__)
+#define HAL_USE_I2S                 FALSE
+#endif
+
 /**
  * @brief   Enables the ICU subsystem.
  */
@@ -135,6 +142,13 @@
 #define HAL_USE_SERIAL_USB          FALSE
 #endif
 
+/**
+ * @brief   Enables the SERIAL over UART subsystem.
+ */
+#if !defined(HAL_USE_SERIAL_UART) || defined(__DOXYGEN__)
+#define HAL_USE_SERIAL_UART         FALSE
+#endif
+
 /**
  * @brief   Enables the SPI subsystem.
  */
@@ -46,6 +46,16 @@ static void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[]) {
   chprintf(chp, "heap free total  : %u bytes\r\n", size);
 }
 
+/*
+ * Saved stack pointer of a thread, the field name depends on the simulator
+ * port in use.
+ */
+#if defined(CH_ARCHITECTURE_SIMX64)
+#define THD_SAVED_SP(tp) ((tp)->p_ctx.rsp)
+#else
+#define THD_SAVED_SP(tp) ((tp)->p_ctx.esp)
+#endif
+
 static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   static const char *states[] = {THD_STATE_NAMES};
   Thread *tp;
@@ -59,7 +69,7 @@ static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   tp = chRegFirstThread();
   do {
     chprintf(chp, "%.8lx %.8lx %4lu %4lu %9s %lu\r\n",
-            (uint32_t)tp, (uint32_t)tp->p_ctx.esp,
+            (unsigned long)tp, (unsigned long)THD_SAVED_SP(tp),
             (uint32_t)tp->p_prio, (uint32_t)(tp->p_refs - 1),
             states[tp->p_state], (uint32_t)tp->p_time);
     tp = chRegNextThread(tp);
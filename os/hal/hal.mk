@@ -7,6 +7,7 @@ HALSRC = ${CHIBIOS}/os/hal/src/hal.c \
          ${CHIBIOS}/os/hal/src/ext.c \
          ${CHIBIOS}/os/hal/src/gpt.c \
          ${CHIBIOS}/os/hal/src/i2c.c \
+         ${CHIBIOS}/os/hal/src/i2s.c \
          ${CHIBIOS}/os/hal/src/icu.c \
          ${CHIBIOS}/os/hal/src/mac.c \
          ${CHIBIOS}/os/hal/src/mmc_spi.c \
@@ -17,6 +18,7 @@ HALSRC = ${CHIBIOS}/os/hal/src/hal.c \
          ${CHIBIOS}/os/hal/src/sdc.c \
          ${CHIBIOS}/os/hal/src/serial.c \
          ${CHIBIOS}/os/hal/src/serial_usb.c \
+         ${CHIBIOS}/os/hal/src/serial_uart.c \
          ${CHIBIOS}/os/hal/src/spi.c \
          ${CHIBIOS}/os/hal/src/tm.c \
          ${CHIBIOS}/os/hal/src/uart.c \
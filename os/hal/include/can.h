@@ -66,6 +66,13 @@
  */
 #define CAN_ANY_MAILBOX             0
 
+/**
+ * @brief   Identifier type matching both standard and extended frames.
+ * @note    Only used in @p CANFilterMask objects produced by
+ *          @p canFiltersCover().
+ */
+#define CAN_FILTER_IDE_ANY          2
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -83,6 +90,54 @@
 #if !defined(CAN_USE_SLEEP_MODE) || defined(__DOXYGEN__)
 #define CAN_USE_SLEEP_MODE          TRUE
 #endif
+
+/**
+ * @brief   Size of the software receive FIFO in frames.
+ * @details If greater than zero the received frames are moved from the
+ *          hardware mailboxes into a software FIFO by the receive ISR, this
+ *          prevents frames losses when the hardware FIFOs are shallow and
+ *          the bus is heavily loaded.
+ * @note    The default is zero, the frames are fetched directly from the
+ *          hardware mailboxes.
+ */
+#if !defined(CAN_RX_FIFO_SIZE) || defined(__DOXYGEN__)
+#define CAN_RX_FIFO_SIZE            0
+#endif
+
+/**
+ * @brief   Size of the software transmit queue in frames.
+ * @details If greater than zero the frames transmitted on
+ *          @p CAN_ANY_MAILBOX are queued in software when the hardware
+ *          mailboxes are busy and are moved into the mailboxes by the
+ *          transmit ISR.
+ * @note    The default is zero, the frames are written directly in the
+ *          hardware mailboxes.
+ */
+#if !defined(CAN_TX_QUEUE_SIZE) || defined(__DOXYGEN__)
+#define CAN_TX_QUEUE_SIZE           0
+#endif
+
+/**
+ * @brief   Software acceptance filters APIs inclusion switch.
+ * @details If set to @p TRUE the @p canFilters*() APIs are included, a
+ *          set of identifier/mask rules is compiled into a hash table
+ *          and the received frames are routed to the matching rule
+ *          callbacks or mailboxes.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CAN_USE_SOFTWARE_FILTERS) || defined(__DOXYGEN__)
+#define CAN_USE_SOFTWARE_FILTERS    FALSE
+#endif
+
+/**
+ * @brief   Maximum number of distinct masks in a filters set.
+ * @details Rules sharing the same mask and identifier type are looked up
+ *          with a single hash probe, the lookup cost grows linearly with
+ *          the number of distinct masks.
+ */
+#if !defined(CAN_FILTERS_MAX_MASKS) || defined(__DOXYGEN__)
+#define CAN_FILTERS_MAX_MASKS       8
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -93,6 +148,10 @@
 #error "CAN driver requires CH_USE_SEMAPHORES and CH_USE_EVENTS"
 #endif
 
+#if CAN_USE_SOFTWARE_FILTERS && (!CH_USE_MAILBOXES || !CH_USE_MEMPOOLS)
+#error "CAN_USE_SOFTWARE_FILTERS requires CH_USE_MAILBOXES and CH_USE_MEMPOOLS"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -109,6 +168,117 @@ typedef enum {
 } canstate_t;
 #include "can_lld.h"
 
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a software acceptance rule.
+ */
+typedef struct CANFilterRule CANFilterRule;
+
+/**
+ * @brief   Rule match callback type.
+ *
+ * @param[in] rp        pointer to the matching rule
+ * @param[in] crfp      pointer to the received frame
+ */
+typedef void (*canrulecb_t)(const CANFilterRule *rp, const CANRxFrame *crfp);
+
+/**
+ * @brief   Software acceptance rule.
+ * @details A frame matches the rule if it has the same identifier type and
+ *          if the identifier bits selected by @p mask are equal to the
+ *          same bits of @p id.
+ */
+struct CANFilterRule {
+  /**
+   * @brief   Identifier to be matched.
+   */
+  uint32_t                  id;
+  /**
+   * @brief   Identifier bits to be compared, set bits are compared.
+   */
+  uint32_t                  mask;
+  /**
+   * @brief   Identifier type, @p CAN_IDE_STD or @p CAN_IDE_EXT.
+   */
+  uint8_t                   ide;
+  /**
+   * @brief   Callback invoked on match or @p NULL.
+   */
+  canrulecb_t               cb;
+  /**
+   * @brief   Mailbox receiving a copy of the matching frames or @p NULL.
+   * @details The posted messages are pointers to @p CANRxFrame objects
+   *          that must be returned using @p canFiltersReleaseFrame().
+   */
+  Mailbox                   *mbp;
+  /**
+   * @brief   Application defined argument.
+   */
+  void                      *arg;
+};
+
+/**
+ * @brief   Identifier/mask pair suitable for a hardware filter.
+ */
+typedef struct {
+  /**
+   * @brief   Identifier, only the bits selected by @p mask are meaningful.
+   */
+  uint32_t                  id;
+  /**
+   * @brief   Identifier bits to be compared.
+   */
+  uint32_t                  mask;
+  /**
+   * @brief   Identifier type, @p CAN_IDE_STD, @p CAN_IDE_EXT or
+   *          @p CAN_FILTER_IDE_ANY.
+   */
+  uint8_t                   ide;
+} CANFilterMask;
+
+/**
+ * @brief   Compiled set of software acceptance rules.
+ */
+typedef struct {
+  /**
+   * @brief   Rules array, the first matching rule has priority.
+   */
+  const CANFilterRule       *rules;
+  /**
+   * @brief   Number of rules.
+   */
+  size_t                    n;
+  /**
+   * @brief   Hash table of rule indexes.
+   */
+  uint16_t                  *slots;
+  /**
+   * @brief   Hash table size as a power of two exponent.
+   */
+  unsigned                  order;
+  /**
+   * @brief   Distinct masks and identifier types in the rules.
+   */
+  CANFilterMask             masks[CAN_FILTERS_MAX_MASKS];
+  /**
+   * @brief   Number of distinct masks.
+   */
+  unsigned                  nmasks;
+  /**
+   * @brief   Pool of the frames posted to the rules mailboxes.
+   */
+  MemoryPool                pool;
+  /**
+   * @brief   Frames not matching any rule.
+   */
+  uint32_t                  unmatched;
+  /**
+   * @brief   Frames lost because the pool or a mailbox was full.
+   */
+  uint32_t                  dropped;
+} CANFilterSet;
+#endif /* CAN_USE_SOFTWARE_FILTERS */
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -121,6 +291,38 @@ typedef enum {
  * @brief   Converts a mailbox index to a bit mask.
  */
 #define CAN_MAILBOX_TO_MASK(mbx) (1 << ((mbx) - 1))
+
+#if (CAN_RX_FIFO_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Frames lost because the software receive FIFO was full.
+ * @pre     The option @p CAN_RX_FIFO_SIZE must be greater than zero.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @special
+ */
+#define canGetRxOverflows(canp) ((canp)->rxoverflows)
+#endif
+
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Frames not matching any rule of a filters set.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ *
+ * @special
+ */
+#define canFiltersGetUnmatched(fsp) ((fsp)->unmatched)
+
+/**
+ * @brief   Matching frames lost because the pool or a mailbox was full.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ *
+ * @special
+ */
+#define canFiltersGetDropped(fsp) ((fsp)->dropped)
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -142,10 +344,35 @@ extern "C" {
                    canmbx_t mailbox,
                    CANRxFrame *crfp,
                    systime_t timeout);
+  size_t canReceiveBatch(CANDriver *canp,
+                         canmbx_t mailbox,
+                         CANRxFrame *crfp,
+                         size_t n,
+                         systime_t timeout);
 #if CAN_USE_SLEEP_MODE
   void canSleep(CANDriver *canp);
   void canWakeup(CANDriver *canp);
 #endif /* CAN_USE_SLEEP_MODE */
+#if CAN_RX_FIFO_SIZE > 0
+  void _can_rx_fifo_fill(CANDriver *canp, canmbx_t mailbox);
+#endif
+#if CAN_TX_QUEUE_SIZE > 0
+  void _can_tx_queue_flush(CANDriver *canp, flagsmask_t flags);
+#endif
+#if CAN_USE_SOFTWARE_FILTERS
+  void canFiltersObjectInit(CANFilterSet *fsp, CANRxFrame *frames, size_t n);
+  bool_t canFiltersCompile(CANFilterSet *fsp,
+                           const CANFilterRule *rules,
+                           size_t n,
+                           uint16_t *slots,
+                           size_t nslots);
+  const CANFilterRule *canFiltersLookup(CANFilterSet *fsp,
+                                        const CANRxFrame *crfp);
+  const CANFilterRule *canFiltersDispatch(CANFilterSet *fsp,
+                                          const CANRxFrame *crfp);
+  void canFiltersReleaseFrame(CANFilterSet *fsp, CANRxFrame *crfp);
+  size_t canFiltersCover(CANFilterSet *fsp, CANFilterMask *fmp, size_t max);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -51,6 +51,7 @@
 #include "ext.h"
 #include "gpt.h"
 #include "i2c.h"
+#include "i2s.h"
 #include "icu.h"
 #include "mac.h"
 #include "pwm.h"
@@ -64,6 +65,7 @@
 /* Complex drivers.*/
 #include "mmc_spi.h"
 #include "serial_usb.h"
+#include "serial_uart.h"
 
 /*===========================================================================*/
 /* Driver constants.                                                         */
@@ -54,6 +54,11 @@
 #define I2CD_SMB_ALERT              0x40   /**< @brief SMBus Alert.         */
 /** @} */
 
+/**
+ * @brief   Status of a queued transaction not yet completed.
+ */
+#define I2C_TRANSACTION_PENDING     1
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -65,6 +70,20 @@
 #define I2C_USE_MUTUAL_EXCLUSION    TRUE
 #endif
 
+/**
+ * @brief   Enables the transactions queue APIs.
+ * @details If set to @p TRUE the @p i2cQueue*() APIs are included, the
+ *          queued transactions are executed back to back by the driver
+ *          without involving the submitting thread.
+ * @note    The underlying implementation must support the queue, see
+ *          the macro @p I2C_SUPPORTS_QUEUE exported by the low level
+ *          driver.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(I2C_USE_QUEUE) || defined(__DOXYGEN__)
+#define I2C_USE_QUEUE               FALSE
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -73,6 +92,10 @@
 #error "I2C_USE_MUTUAL_EXCLUSION requires CH_USE_MUTEXES and/or CH_USE_SEMAPHORES"
 #endif
 
+#if I2C_USE_QUEUE && (!CH_USE_SEMAPHORES || !CH_USE_EVENTS)
+#error "I2C_USE_QUEUE requires CH_USE_SEMAPHORES and CH_USE_EVENTS"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -89,8 +112,78 @@ typedef enum {
   I2C_LOCKED = 5                            /**> Bus or driver locked.      */
 } i2cstate_t;
 
+/**
+ * @brief   Type of an I2C transaction descriptor.
+ */
+typedef struct I2CTransaction I2CTransaction;
+
 #include "i2c_lld.h"
 
+#if I2C_USE_QUEUE && !I2C_SUPPORTS_QUEUE
+#error "I2C transactions queue not supported in this architecture"
+#endif
+
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Transaction completion callback type.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] itp       pointer to the completed transaction
+ */
+typedef void (*i2ccallback_t)(I2CDriver *i2cp, I2CTransaction *itp);
+
+/**
+ * @brief   I2C transaction descriptor.
+ * @details A transaction is a write if @p rxbytes is zero, a read if
+ *          @p txbytes is zero or a write followed by a read using a
+ *          repeated start condition.
+ */
+struct I2CTransaction {
+  /**
+   * @brief   Next transaction in the queue.
+   */
+  I2CTransaction            *next;
+  /**
+   * @brief   Slave device address (7 bits) without R/W bit.
+   */
+  i2caddr_t                 addr;
+  /**
+   * @brief   Pointer to the transmit buffer.
+   */
+  const uint8_t             *txbuf;
+  /**
+   * @brief   Number of bytes to be transmitted.
+   */
+  size_t                    txbytes;
+  /**
+   * @brief   Pointer to the receive buffer.
+   */
+  uint8_t                   *rxbuf;
+  /**
+   * @brief   Number of bytes to be received.
+   */
+  size_t                    rxbytes;
+  /**
+   * @brief   Completion callback or @p NULL.
+   */
+  i2ccallback_t             callback;
+  /**
+   * @brief   Application defined argument.
+   */
+  void                      *arg;
+  /**
+   * @brief   Transaction status.
+   * @details It is @p I2C_TRANSACTION_PENDING while the transaction is
+   *          queued, @p RDY_OK or @p RDY_RESET after completion.
+   */
+  msg_t                     status;
+  /**
+   * @brief   Errors mask of the completed transaction.
+   */
+  i2cflags_t                errors;
+};
+#endif /* I2C_USE_QUEUE */
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -110,6 +203,24 @@ typedef enum {
 #define i2cMasterReceive(i2cp, addr, rxbuf, rxbytes)                        \
   (i2cMasterReceiveTimeout(i2cp, addr, rxbuf, rxbytes, TIME_INFINITE))
 
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Static initializer for an @p I2CTransaction object.
+ *
+ * @param[in] addr      slave device address (7 bits) without R/W bit
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] callback  completion callback or @p NULL
+ * @param[in] arg       application defined argument
+ */
+#define _I2C_TRANSACTION_DATA(addr, txbuf, txbytes, rxbuf, rxbytes,         \
+                              callback, arg)                                \
+  {NULL, addr, txbuf, txbytes, rxbuf, rxbytes, callback, arg, RDY_OK,       \
+   I2CD_NO_ERROR}
+#endif
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -135,6 +246,12 @@ extern "C" {
   void i2cAcquireBus(I2CDriver *i2cp);
   void i2cReleaseBus(I2CDriver *i2cp);
 #endif /* I2C_USE_MUTUAL_EXCLUSION */
+#if I2C_USE_QUEUE
+  void i2cQueueSubmitI(I2CDriver *i2cp, I2CTransaction *itp, size_t n);
+  void i2cQueueSubmit(I2CDriver *i2cp, I2CTransaction *itp, size_t n);
+  msg_t i2cQueueWait(I2CDriver *i2cp, systime_t timeout);
+  void _i2c_queue_complete(I2CDriver *i2cp, msg_t msg);
+#endif /* I2C_USE_QUEUE */
 
 #ifdef __cplusplus
 }
@@ -86,24 +86,31 @@ typedef struct I2SDriver I2SDriver;
  */
 /**
  * @brief   Starts a I2S data exchange.
+ * @details The buffers are exchanged once, the callback is invoked after
+ *          each half and the driver returns to the @p I2S_READY state.
  *
  * @param[in] i2sp      pointer to the @p I2SDriver object
  *
  * @iclass
  */
 #define i2sStartExchangeI(i2sp) {                                           \
+  _i2s_reset_accounting(i2sp);                                              \
   i2s_lld_start_exchange(i2sp);                                             \
   (i2sp)->state = I2S_ACTIVE;                                               \
 }
 
 /**
  * @brief   Starts a I2S data exchange in continuous mode.
+ * @details The buffers are exchanged circularly, the callback is invoked
+ *          each time an half buffer has been transmitted and/or received
+ *          and can be refilled and/or read while the other half is in use.
  *
  * @param[in] i2sp      pointer to the @p I2SDriver object
  *
  * @iclass
  */
 #define i2sStartExchangeContinuousI(i2sp) {                                 \
+  _i2s_reset_accounting(i2sp);                                              \
   i2s_lld_start_exchange_continuous(i2sp);                                  \
   (i2sp)->state = I2S_ACTIVE;                                               \
 }
@@ -122,6 +129,135 @@ typedef struct I2SDriver I2SDriver;
   (i2sp)->state = I2S_READY;                                                \
 }
 
+/**
+ * @brief   Releases the last half buffer notified by the callback.
+ * @details In continuous mode the application must release each half
+ *          buffer after having refilled and/or read it, an half buffer
+ *          reused by the hardware before being released is accounted as
+ *          an underrun if transmitting and as an overrun if receiving.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @iclass
+ */
+#define i2sReleaseBufferI(i2sp) ((i2sp)->pending = FALSE)
+
+/**
+ * @brief   Number of transmit underruns since the exchange start.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @special
+ */
+#define i2sGetUnderruns(i2sp) ((i2sp)->underruns)
+
+/**
+ * @brief   Number of receive overruns since the exchange start.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @special
+ */
+#define i2sGetOverruns(i2sp) ((i2sp)->overruns)
+/** @} */
+
+/**
+ * @name    Low Level driver helper macros
+ * @{
+ */
+/**
+ * @brief   Resets the underruns and overruns accounting.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+#define _i2s_reset_accounting(i2sp) {                                       \
+  (i2sp)->pending   = FALSE;                                                \
+  (i2sp)->underruns = 0;                                                    \
+  (i2sp)->overruns  = 0;                                                    \
+}
+
+/**
+ * @brief   Accounts an half buffer event.
+ * @details The half buffer notified by the previous event is reused by the
+ *          hardware from now on, it must have been released.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+#define _i2s_isr_account(i2sp) {                                            \
+  if ((i2sp)->pending) {                                                    \
+    if ((i2sp)->config->tx_buffer != NULL)                                  \
+      (i2sp)->underruns++;                                                  \
+    if ((i2sp)->config->rx_buffer != NULL)                                  \
+      (i2sp)->overruns++;                                                   \
+  }                                                                         \
+  (i2sp)->pending = TRUE;                                                   \
+}
+
+/**
+ * @brief   Common ISR code, first half buffer event.
+ * @details This code handles the portable part of the ISR code:
+ *          - Underruns and overruns accounting.
+ *          - Callback invocation.
+ *          .
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+#define _i2s_isr_half_code(i2sp) {                                          \
+  _i2s_isr_account(i2sp);                                                   \
+  if ((i2sp)->config->end_cb != NULL)                                       \
+    (i2sp)->config->end_cb(i2sp, 0, (i2sp)->config->size / 2);             \
+}
+
+/**
+ * @brief   Common ISR code, second half buffer event in continuous mode.
+ * @details This code handles the portable part of the ISR code:
+ *          - Underruns and overruns accounting.
+ *          - Callback invocation.
+ *          .
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+#define _i2s_isr_full_code(i2sp) {                                          \
+  _i2s_isr_account(i2sp);                                                   \
+  if ((i2sp)->config->end_cb != NULL)                                       \
+    (i2sp)->config->end_cb(i2sp, (i2sp)->config->size / 2,                  \
+                           (i2sp)->config->size / 2);                       \
+}
+
+/**
+ * @brief   Common ISR code, end of a single exchange.
+ * @details This code handles the portable part of the ISR code:
+ *          - Callback invocation.
+ *          - Driver state transitions.
+ *          .
+ * @note    This macro is meant to be used in the low level drivers
+ *          implementation only.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+#define _i2s_isr_complete_code(i2sp) {                                      \
+  i2s_lld_stop_exchange(i2sp);                                              \
+  (i2sp)->state = I2S_COMPLETE;                                             \
+  if ((i2sp)->config->end_cb != NULL)                                       \
+    (i2sp)->config->end_cb(i2sp, (i2sp)->config->size / 2,                  \
+                           (i2sp)->config->size / 2);                       \
+  if ((i2sp)->state == I2S_COMPLETE)                                        \
+    (i2sp)->state = I2S_READY;                                              \
+}
 /** @} */
 
 /*===========================================================================*/
@@ -136,7 +272,9 @@ extern "C" {
   void i2sStart(I2SDriver *i2sp, const I2SConfig *config);
   void i2sStop(I2SDriver *i2sp);
   void i2sStartExchange(I2SDriver *i2sp);
+  void i2sStartExchangeContinuous(I2SDriver *i2sp);
   void i2sStopExchange(I2SDriver *i2sp);
+  void i2sReleaseBuffer(I2SDriver *i2sp);
 #ifdef __cplusplus
 }
 #endif
@@ -59,6 +59,35 @@
 #if !defined(MMC_NICE_WAITING) || defined(__DOXYGEN__)
 #define MMC_NICE_WAITING            TRUE
 #endif
+
+/**
+ * @brief   Enables the CRC on the data blocks.
+ * @details If enabled the CRC of the read blocks is verified, the CRC of
+ *          the written blocks is calculated and the card is asked to check
+ *          the CRCs.
+ */
+#if !defined(MMC_USE_CRC) || defined(__DOXYGEN__)
+#define MMC_USE_CRC                 TRUE
+#endif
+
+/**
+ * @brief   Number of frames received by each polling transfer.
+ * @details The data tokens and the end of the busy condition are polled
+ *          receiving this number of frames at time, larger values reduce
+ *          the number of SPI transactions.
+ */
+#if !defined(MMC_POLL_BURST) || defined(__DOXYGEN__)
+#define MMC_POLL_BURST              8
+#endif
+
+/**
+ * @brief   Uses the CRC library instead of the driver local tables.
+ * @note    The library must be included in the build, see
+ *          @p os/various/crc/crc.mk.
+ */
+#if !defined(MMC_USE_CRC_LIBRARY) || defined(__DOXYGEN__)
+#define MMC_USE_CRC_LIBRARY         FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -69,6 +98,10 @@
 #error "MMC_SPI driver requires HAL_USE_SPI and SPI_USE_WAIT"
 #endif
 
+#if (MMC_POLL_BURST < 1) || (MMC_POLL_BURST > 64)
+#error "invalid MMC_POLL_BURST value"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -127,6 +160,14 @@ typedef struct {
   bool_t                block_addresses;
 } MMCDriver;
 
+/**
+ * @brief   Block read notification callback type.
+ *
+ * @param[in] mmcp      pointer to the @p MMCDriver object
+ * @param[in] buffer    pointer to the verified block
+ */
+typedef void (*mmcreadcb_t)(MMCDriver *mmcp, const uint8_t *buffer);
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
@@ -179,9 +220,13 @@ extern "C" {
   bool_t mmcDisconnect(MMCDriver *mmcp);
   bool_t mmcStartSequentialRead(MMCDriver *mmcp, uint32_t startblk);
   bool_t mmcSequentialRead(MMCDriver *mmcp, uint8_t *buffer);
+  bool_t mmcSequentialReadBlocks(MMCDriver *mmcp, uint8_t *buffer, uint32_t n,
+                                 mmcreadcb_t cb);
   bool_t mmcStopSequentialRead(MMCDriver *mmcp);
   bool_t mmcStartSequentialWrite(MMCDriver *mmcp, uint32_t startblk);
   bool_t mmcSequentialWrite(MMCDriver *mmcp, const uint8_t *buffer);
+  bool_t mmcSequentialWriteBlocks(MMCDriver *mmcp, const uint8_t *buffer,
+                                  uint32_t n);
   bool_t mmcStopSequentialWrite(MMCDriver *mmcp);
   bool_t mmcSync(MMCDriver *mmcp);
   bool_t mmcGetInfo(MMCDriver *mmcp, BlockDeviceInfo *bdip);
@@ -0,0 +1,216 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    serial_uart.h
+ * @brief   Serial over UART Driver macros and structures.
+ *
+ * @addtogroup SERIAL_UART
+ * @{
+ */
+
+#ifndef _SERIAL_UART_H_
+#define _SERIAL_UART_H_
+
+#if HAL_USE_SERIAL_UART || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Serial over UART status flags
+ * @details The values are the same of the @p SerialDriver flags, the UART
+ *          driver error flags are shifted into these positions.
+ * @{
+ */
+#define SDUART_PARITY_ERROR     32  /**< @brief Parity error happened.      */
+#define SDUART_FRAMING_ERROR    64  /**< @brief Framing error happened.     */
+#define SDUART_OVERRUN_ERROR    128 /**< @brief Overflow happened.          */
+#define SDUART_NOISE_ERROR      256 /**< @brief Noise on the line.          */
+#define SDUART_BREAK_DETECTED   512 /**< @brief Break detected.             */
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    SERIAL_UART configuration options
+ * @{
+ */
+/**
+ * @brief   Serial over UART queues size.
+ * @details Configuration parameter, you can change the depth of the queue
+ *          buffers depending on the requirements of your application.
+ * @note    The default is 256 bytes for both the transmission and receive
+ *          queues.
+ */
+#if !defined(SERIAL_UART_BUFFERS_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_UART_BUFFERS_SIZE    256
+#endif
+
+/**
+ * @brief   Size of each half of the receive double buffer.
+ * @details The receiver alternates on two buffers of this size, a full
+ *          buffer is moved into the input queue while the other one is
+ *          being filled.
+ */
+#if !defined(SERIAL_UART_RX_CHUNK_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_UART_RX_CHUNK_SIZE   32
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if !HAL_USE_UART || !CH_USE_QUEUES || !CH_USE_EVENTS
+#error "Serial over UART Driver requires HAL_USE_UART, CH_USE_QUEUES, "
+       "CH_USE_EVENTS"
+#endif
+
+#if SERIAL_UART_RX_CHUNK_SIZE > SERIAL_UART_BUFFERS_SIZE
+#error "SERIAL_UART_RX_CHUNK_SIZE larger than SERIAL_UART_BUFFERS_SIZE"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief Driver state machine possible states.
+ */
+typedef enum {
+  SDUART_UNINIT = 0,                /**< Not initialized.                   */
+  SDUART_STOP = 1,                  /**< Stopped.                           */
+  SDUART_READY = 2                  /**< Ready.                             */
+} sduartstate_t;
+
+/**
+ * @brief   Structure representing a serial over UART driver.
+ */
+typedef struct SerialUARTDriver SerialUARTDriver;
+
+/**
+ * @brief   Serial over UART Driver configuration structure.
+ * @details An instance of this structure must be passed to @p sduartStart()
+ *          in order to configure and start the driver operations.
+ */
+typedef struct {
+  /**
+   * @brief   UART driver to use.
+   */
+  UARTDriver                *uartp;
+  /**
+   * @brief   UART driver configuration.
+   * @details The architecture dependent fields are used as they are, the
+   *          callbacks are replaced by the serial driver ones.
+   */
+  const UARTConfig          *uartcfg;
+  /**
+   * @brief   Receive idle time.
+   * @details A partially filled receive buffer is moved into the input
+   *          queue after this time without buffer completions.
+   */
+  systime_t                 idle_time;
+} SerialUARTConfig;
+
+/**
+ * @brief   @p SerialUARTDriver specific data.
+ */
+#define _serial_uart_driver_data                                            \
+  _base_asynchronous_channel_data                                           \
+  /* Driver state.*/                                                        \
+  sduartstate_t             state;                                          \
+  /* Input queue.*/                                                         \
+  InputQueue                iqueue;                                         \
+  /* Output queue.*/                                                        \
+  OutputQueue               oqueue;                                         \
+  /* Input buffer.*/                                                        \
+  uint8_t                   ib[SERIAL_UART_BUFFERS_SIZE];                   \
+  /* Output buffer.*/                                                       \
+  uint8_t                   ob[SERIAL_UART_BUFFERS_SIZE];                   \
+  /* End of the mandatory fields.*/                                         \
+  /* Current configuration data.*/                                          \
+  const SerialUARTConfig    *config;                                        \
+  /* Configuration of the underlying UART driver.*/                         \
+  UARTConfig                uartcfg;                                        \
+  /* Receive double buffer.*/                                               \
+  uint8_t                   rxbuf[2][SERIAL_UART_RX_CHUNK_SIZE];            \
+  /* Index of the receive buffer being filled.*/                            \
+  unsigned                  rxidx;                                          \
+  /* Receive idle timer.*/                                                  \
+  VirtualTimer              rxvt;                                           \
+  /* Bytes being transmitted from the output queue.*/                       \
+  size_t                    txn;
+
+/**
+ * @brief   @p SerialUARTDriver specific methods.
+ */
+#define _serial_uart_driver_methods                                         \
+  _base_asynchronous_channel_methods
+
+/**
+ * @extends BaseAsynchronousChannelVMT
+ *
+ * @brief   @p SerialUARTDriver virtual methods table.
+ */
+struct SerialUARTDriverVMT {
+  _serial_uart_driver_methods
+};
+
+/**
+ * @extends BaseAsynchronousChannel
+ *
+ * @brief   Full duplex serial driver class over an UART driver.
+ * @details This class extends @p BaseAsynchronousChannel by adding physical
+ *          I/O queues.
+ */
+struct SerialUARTDriver {
+  /** @brief Virtual Methods Table.*/
+  const struct SerialUARTDriverVMT *vmt;
+  _serial_uart_driver_data
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void sduartInit(void);
+  void sduartObjectInit(SerialUARTDriver *sdup);
+  void sduartStart(SerialUARTDriver *sdup, const SerialUARTConfig *config);
+  void sduartStop(SerialUARTDriver *sdup);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_SERIAL_UART */
+
+#endif /* _SERIAL_UART_H_ */
+
+/** @} */
@@ -112,6 +112,44 @@
 #define SERIAL_USB_BUFFERS_SIZE       1536
 #endif
 #endif
+
+/**
+ * @brief   Linear transfer buffers.
+ * @details If enabled the data is moved between the queues and two linear
+ *          buffers and each bulk transfer carries up to
+ *          @p SERIAL_USB_TRANSFER_SIZE bytes in multiple packets, the
+ *          application keeps using the queues while a transfer is in
+ *          progress. If disabled the transfers are performed directly on
+ *          the queues.
+ */
+#if !defined(SERIAL_USB_USE_LINEAR_TRANSFERS) || defined(__DOXYGEN__)
+#define SERIAL_USB_USE_LINEAR_TRANSFERS     FALSE
+#endif
+
+/**
+ * @brief   Linear transfer buffers size.
+ * @details Configuration parameter, the buffer size must be a multiple of
+ *          the USB data endpoint maximum packet size.
+ * @note    Transmit transfers cannot be larger than the data in the output
+ *          queue so the queues should not be smaller than the transfer
+ *          buffers.
+ */
+#if !defined(SERIAL_USB_TRANSFER_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_USB_TRANSFER_SIZE            4096
+#endif
+
+/**
+ * @brief   Linear transfer buffers copy block size.
+ * @details The data is moved between the queues and the linear buffers in
+ *          blocks of up to this size, the kernel lock is released between
+ *          the blocks so this is the longest copy performed inside a
+ *          critical zone. The received data is also moved only when there
+ *          is space for a whole block in the input queue, or for all the
+ *          pending data.
+ */
+#if !defined(SERIAL_USB_COPY_BLOCK_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_USB_COPY_BLOCK_SIZE          256
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -123,6 +161,16 @@
        "CH_USE_EVENTS"
 #endif
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS && ((SERIAL_USB_TRANSFER_SIZE % 64) != 0)
+#error "SERIAL_USB_TRANSFER_SIZE must be a multiple of 64"
+#endif
+
+#if SERIAL_USB_USE_LINEAR_TRANSFERS &&                                      \
+    ((SERIAL_USB_COPY_BLOCK_SIZE == 0) ||                                   \
+     (SERIAL_USB_COPY_BLOCK_SIZE > SERIAL_USB_BUFFERS_SIZE))
+#error "SERIAL_USB_COPY_BLOCK_SIZE out of range"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -177,6 +225,27 @@ typedef struct {
 
 } SerialUSBConfig;
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS || defined(__DOXYGEN__)
+/**
+ * @brief   Linear transfer buffers data.
+ */
+#define _serial_usb_transfer_data                                           \
+  /* Transmit transfer buffer.*/                                            \
+  uint8_t                   txbuf[SERIAL_USB_TRANSFER_SIZE];                \
+  /* Receive transfer buffer.*/                                             \
+  uint8_t                   rxbuf[SERIAL_USB_TRANSFER_SIZE];                \
+  /* Received data not yet moved into the input queue.*/                    \
+  uint8_t                   *rxptr;                                         \
+  /* Size of the received data not yet moved into the input queue.*/        \
+  size_t                    rxlen;                                          \
+  /* Transmit buffer being filled.*/                                        \
+  bool_t                    txbusy;                                         \
+  /* Receive buffer being flushed.*/                                        \
+  bool_t                    rxbusy;
+#else
+#define _serial_usb_transfer_data
+#endif
+
 /**
  * @brief   @p SerialDriver specific data.
  */
@@ -195,6 +264,7 @@ typedef struct {
   /* End of the mandatory fields.*/                                         \
   /* Current configuration data.*/                                          \
   const SerialUSBConfig     *config;                                        \
+  _serial_usb_transfer_data                                                 \
 /*FIXME Remove these debug tracking variables*/ \
   volatile uint32_t inotify_count;\
   volatile uint32_t onotify_count;\
@@ -0,0 +1,317 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/adc_lld.c
+ * @brief   Posix low level simulated ADC driver code.
+ * @details The converter is fed by synthetic waveforms described in the
+ *          conversion group, the rows are produced at the group rate
+ *          measured on the host clock and written in the buffer like a
+ *          DMA would do, the half and full buffer events are served as
+ *          simulated interrupts.
+ *
+ * @addtogroup POSIX_ADC
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_ADC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define NS_PER_SECOND       1000000000ULL
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief ADC1 driver identifier.*/
+#if USE_SIM_ADC1 || defined(__DOXYGEN__)
+ADCDriver ADCD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   One period of a sine wave, Q15 format.
+ */
+static const int16_t sine_table[256] = {
+       0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+    6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+   12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+   18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+   23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+   27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+   30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+   32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+   32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+   32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+   30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+   27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+   23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+   18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+   12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+    6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+       0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+   -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+  -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+  -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+  -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+  -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+  -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+  -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+  -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+  -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+  -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+  -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+  -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+  -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+  -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+   -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Value of a simulated input.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] chp       pointer to the simulated input
+ * @param[in] k         row number since the conversion start
+ * @return              The sample value.
+ *
+ * @notapi
+ */
+static adcsample_t sample(ADCDriver *adcp, const ADCSimChannel *chp,
+                          uint64_t k) {
+  int32_t amp = (int32_t)chp->amplitude;
+  int32_t v;
+  uint32_t phase;
+
+  if ((chp->wave != ADC_SIM_NOISE) && (chp->period == 0))
+    v = 0;
+  else {
+    phase = (uint32_t)(k % chp->period);
+    switch (chp->wave) {
+    case ADC_SIM_SINE:
+      v = (amp * sine_table[((uint64_t)phase << 8) / chp->period] +
+           0x4000) >> 15;
+      break;
+    case ADC_SIM_SQUARE:
+      v = phase < chp->period / 2 ? amp : -amp;
+      break;
+    case ADC_SIM_TRIANGLE:
+      v = (int32_t)(((uint64_t)phase * 4 * amp) / chp->period);
+      v = v <= 2 * amp ? v - amp : 3 * amp - v;
+      break;
+    case ADC_SIM_SAWTOOTH:
+      v = (int32_t)(((uint64_t)phase * 2 * amp) / chp->period) - amp;
+      break;
+    case ADC_SIM_NOISE:
+      adcp->seed = adcp->seed * 1664525 + 1013904223;
+      v = (int32_t)((adcp->seed >> 16) % (uint32_t)(2 * amp + 1)) - amp;
+      break;
+    default:
+      v = 0;
+    }
+  }
+  v += (int32_t)chp->offset;
+  if (v < 0)
+    return 0;
+  if (v > ADC_SIM_MAX_VALUE)
+    return ADC_SIM_MAX_VALUE;
+  return (adcsample_t)v;
+}
+
+/**
+ * @brief   Serves the simulated interrupt sources of a driver.
+ * @details The rows due since the last invocation are converted up to the
+ *          next half or full buffer boundary, at most one event is served
+ *          for each invocation. If the simulation falls behind by more
+ *          than a whole buffer then the older buffers are skipped, like
+ *          a DMA overwriting data not yet handled.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t serve_interrupt(ADCDriver *adcp) {
+  const ADCConversionGroup *grpp = adcp->grpp;
+  adcsample_t *bp;
+  uint64_t due, ns;
+  size_t boundary, n;
+  adc_channels_num_t i;
+
+  if (adcp->state != ADC_ACTIVE)
+    return FALSE;
+
+  /* Next boundary generating an event.*/
+  if (grpp->circular && (adcp->depth > 1) && (adcp->row < adcp->depth / 2))
+    boundary = adcp->depth / 2;
+  else
+    boundary = adcp->depth;
+
+  /* Rows due at the current time.*/
+  if (grpp->frequency == 0)
+    due = adcp->converted + (boundary - adcp->row);
+  else {
+    ns = hal_lld_get_time_ns() - adcp->start_ns;
+    due = (ns / NS_PER_SECOND) * grpp->frequency +
+          ((ns % NS_PER_SECOND) * grpp->frequency) / NS_PER_SECOND;
+    if (due - adcp->converted > adcp->depth)
+      adcp->converted += ((due - adcp->converted) / adcp->depth - 1) *
+                         adcp->depth;
+  }
+  if (due <= adcp->converted)
+    return FALSE;
+
+  /* Conversion of the due rows.*/
+  n = boundary - adcp->row;
+  if (n > due - adcp->converted)
+    n = (size_t)(due - adcp->converted);
+  bp = adcp->samples + adcp->row * grpp->num_channels;
+  adcp->row += n;
+  while (n > 0) {
+    for (i = 0; i < grpp->num_channels; i++)
+      *bp++ = sample(adcp, &grpp->channels[i], adcp->converted);
+    adcp->converted++;
+    n--;
+  }
+
+  if (adcp->row < boundary)
+    return FALSE;
+
+  /* Events.*/
+  if (adcp->row == adcp->depth) {
+    adcp->row = 0;
+    _adc_isr_full_code(adcp);
+  }
+  else {
+    _adc_isr_half_code(adcp);
+  }
+  return TRUE;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level ADC driver initialization.
+ *
+ * @notapi
+ */
+void adc_lld_init(void) {
+
+#if USE_SIM_ADC1
+  adcObjectInit(&ADCD1);
+  ADCD1.seed = 0x12345678;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the ADC peripheral.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_start(ADCDriver *adcp) {
+
+  (void)adcp;
+}
+
+/**
+ * @brief   Deactivates the ADC peripheral.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_stop(ADCDriver *adcp) {
+
+  (void)adcp;
+}
+
+/**
+ * @brief   Starts an ADC conversion.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_start_conversion(ADCDriver *adcp) {
+
+  chDbgAssert(adcp->grpp->channels != NULL,
+              "adc_lld_start_conversion(), #1", "no simulated inputs");
+
+  adcp->start_ns = hal_lld_get_time_ns();
+  adcp->converted = 0;
+  adcp->row = 0;
+}
+
+/**
+ * @brief   Stops an ongoing conversion.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ *
+ * @notapi
+ */
+void adc_lld_stop_conversion(ADCDriver *adcp) {
+
+  adcp->row = 0;
+}
+
+/**
+ * @brief   Simulated ADC interrupt sources.
+ * @details Converts the rows due and invokes the driver callbacks.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no interrupt has been served.
+ * @retval TRUE         if at least an interrupt has been served.
+ *
+ * @notapi
+ */
+bool_t adc_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_ADC1
+  b = serve_interrupt(&ADCD1) || b;
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_ADC */
+
+/** @} */
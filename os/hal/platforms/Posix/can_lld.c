@@ -0,0 +1,615 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/can_lld.c
+ * @brief   Posix low level simulated CAN driver code.
+ * @details All the simulated controllers are connected to a single
+ *          simulated bus. When the bus is idle the pending frames of all
+ *          the nodes are arbitrated like on a real bus, the frame with the
+ *          lowest identifier wins, and it occupies the bus for its
+ *          duration at the bit rate of the transmitting node. At the end
+ *          of the frame it is stored in the receive FIFO of all the other
+ *          active nodes and the receive and transmit interrupts are served.
+ * @note    The bus time follows the system time, it is interpolated on the
+ *          host clock within a system tick but it never runs ahead of the
+ *          next tick. A suspended host process does not make the bus run
+ *          ahead of the simulated threads, the frames move in simulated
+ *          time.
+ * @note    The mailboxes of a node holding frames with the same identifier
+ *          are transmitted in request order.
+ * @note    Bit stuffing is not simulated and the frames are always
+ *          acknowledged.
+ *
+ * @addtogroup POSIX_CAN
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_CAN || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define NS_PER_SECOND       1000000000ULL
+#define NS_PER_TICK         (NS_PER_SECOND / CH_FREQUENCY)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief CAN1 driver identifier.*/
+#if USE_SIM_CAN1 || defined(__DOXYGEN__)
+CANDriver CAND1;
+#endif
+
+/** @brief CAN2 driver identifier.*/
+#if USE_SIM_CAN2 || defined(__DOXYGEN__)
+CANDriver CAND2;
+#endif
+
+/** @brief CAN3 driver identifier.*/
+#if USE_SIM_CAN3 || defined(__DOXYGEN__)
+CANDriver CAND3;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Nodes connected to the simulated bus.
+ */
+static CANDriver * const nodes[] = {
+#if USE_SIM_CAN1
+  &CAND1,
+#endif
+#if USE_SIM_CAN2
+  &CAND2,
+#endif
+#if USE_SIM_CAN3
+  &CAND3,
+#endif
+  NULL
+};
+
+/**
+ * @brief   Simulated bus state.
+ */
+static struct {
+  /**
+   * @brief   A frame is on the bus.
+   */
+  bool_t                    busy;
+  /**
+   * @brief   Node transmitting the frame on the bus.
+   */
+  CANDriver                 *txnode;
+  /**
+   * @brief   Transmit mailbox index of the frame on the bus.
+   */
+  unsigned                  txmbx;
+  /**
+   * @brief   Bus time of the end of the frame on the bus.
+   */
+  uint64_t                  end_ns;
+  /**
+   * @brief   System time of the last bus time update.
+   */
+  systime_t                 ticks;
+  /**
+   * @brief   Bus time of the system tick @p ticks.
+   */
+  uint64_t                  tick_ns;
+  /**
+   * @brief   Host time of the first bus time update in the tick @p ticks.
+   */
+  uint64_t                  tick_host_ns;
+  /**
+   * @brief   Frames transmitted on the bus.
+   */
+  uint64_t                  frames;
+  /**
+   * @brief   Bits transmitted on the bus.
+   */
+  uint64_t                  bits;
+} bus;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Bus time.
+ * @details The system ticks elapsed since the last update advance the bus
+ *          time, the host clock advances it within the current tick up to
+ *          the next tick.
+ *
+ * @return              The bus time in nanoseconds.
+ *
+ * @notapi
+ */
+static uint64_t bus_time(void) {
+  systime_t ticks = chTimeNow();
+  uint64_t host = hal_lld_get_time_ns();
+
+  if (ticks != bus.ticks) {
+    bus.tick_ns += (uint64_t)(systime_t)(ticks - bus.ticks) * NS_PER_TICK;
+    bus.ticks = ticks;
+    bus.tick_host_ns = host;
+  }
+  host -= bus.tick_host_ns;
+  if (host > NS_PER_TICK)
+    host = NS_PER_TICK;
+  return bus.tick_ns + host;
+}
+
+/**
+ * @brief   Arbitration field of a frame.
+ * @details The returned value compares like the arbitration field on the
+ *          bus, the lowest value wins. Standard frames win over extended
+ *          frames with the same base identifier and data frames win over
+ *          remote frames.
+ *
+ * @param[in] ctfp      pointer to the frame
+ * @return              The arbitration value.
+ *
+ * @notapi
+ */
+static uint32_t arbitration_field(const CANTxFrame *ctfp) {
+
+  if (ctfp->IDE)
+    return (((uint32_t)ctfp->EID >> 18) << 21) | (1U << 20) | (1U << 19) |
+           (((uint32_t)ctfp->EID & 0x3FFFF) << 1) | ctfp->RTR;
+  return ((uint32_t)ctfp->SID << 21) | ((uint32_t)ctfp->RTR << 20);
+}
+
+/**
+ * @brief   Length of a frame on the bus.
+ *
+ * @param[in] ctfp      pointer to the frame
+ * @return              The frame length in bits, including the interframe
+ *                      space.
+ *
+ * @notapi
+ */
+static uint32_t frame_bits(const CANTxFrame *ctfp) {
+  uint32_t n = ctfp->DLC > 8 ? 8 : ctfp->DLC;
+
+  if (ctfp->RTR)
+    n = 0;
+  return (ctfp->IDE ? 67 : 47) + n * 8;
+}
+
+/**
+ * @brief   Starts the transmission of the winning frame, if any.
+ *
+ * @param[in] start     bus time of the frame start
+ *
+ * @notapi
+ */
+static void arbitrate(uint64_t start) {
+  CANDriver * const *npp;
+  CANDriver *canp;
+  uint32_t field, best = 0;
+  unsigned i;
+
+  bus.txnode = NULL;
+  for (npp = nodes; (canp = *npp) != NULL; npp++) {
+    if ((canp->state != CAN_READY) || (canp->txpending == 0))
+      continue;
+    for (i = 0; i < CAN_TX_MAILBOXES; i++) {
+      if ((canp->txpending & (1U << i)) == 0)
+        continue;
+      field = arbitration_field(&canp->txmbx[i]);
+      if ((bus.txnode == NULL) || (field < best) ||
+          ((field == best) && (bus.txnode == canp) &&
+           ((int32_t)(canp->txorder[i] - canp->txorder[bus.txmbx]) < 0))) {
+        best = field;
+        bus.txnode = canp;
+        bus.txmbx = i;
+      }
+    }
+  }
+  if (bus.txnode != NULL) {
+    bus.busy = TRUE;
+    bus.end_ns = start +
+                 ((uint64_t)frame_bits(&bus.txnode->txmbx[bus.txmbx]) *
+                  NS_PER_SECOND) / bus.txnode->config->bitrate;
+  }
+}
+
+/**
+ * @brief   Applies the acceptance filters of a node to a frame.
+ *
+ * @param[in] canp      pointer to the receiving @p CANDriver object
+ * @param[in] ctfp      pointer to the frame
+ * @return              The frame acceptance state.
+ *
+ * @notapi
+ */
+static bool_t accept_frame(CANDriver *canp, const CANTxFrame *ctfp) {
+  uint32_t i, id = ctfp->IDE ? ctfp->EID : ctfp->SID;
+
+  if (canp->nfilters == 0)
+    return TRUE;
+  for (i = 0; i < canp->nfilters; i++) {
+    const CANFilter *cfp = &canp->filters[i];
+    if ((cfp->ide > CAN_IDE_EXT) ||
+        ((cfp->ide == ctfp->IDE) && (((id ^ cfp->id) & cfp->mask) == 0)))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * @brief   Stores a frame in the receive FIFO of a node.
+ *
+ * @param[in] canp      pointer to the receiving @p CANDriver object
+ * @param[in] ctfp      pointer to the frame
+ *
+ * @notapi
+ */
+static void receive_frame(CANDriver *canp, const CANTxFrame *ctfp) {
+  CANRxFrame *crfp;
+
+  if (!accept_frame(canp, ctfp)) {
+    canp->rxrejected++;
+    return;
+  }
+  if (canp->rxhwcnt >= CAN_SIM_RX_FIFO_DEPTH) {
+    canp->rxlost++;
+    chSysLockFromIsr();
+    chEvtBroadcastFlagsI(&canp->error_event, CAN_OVERFLOW_ERROR);
+    chSysUnlockFromIsr();
+    return;
+  }
+  crfp = &canp->rxhw[(canp->rxhwidx + canp->rxhwcnt) % CAN_SIM_RX_FIFO_DEPTH];
+  crfp->TIME = (uint16_t)(bus.end_ns / 1000);
+  crfp->DLC = ctfp->DLC;
+  crfp->RTR = ctfp->RTR;
+  crfp->IDE = ctfp->IDE;
+  if (ctfp->IDE)
+    crfp->EID = ctfp->EID;
+  else
+    crfp->SID = ctfp->SID;
+  crfp->data32[0] = ctfp->data32[0];
+  crfp->data32[1] = ctfp->data32[1];
+  canp->rxhwcnt++;
+  canp->rxframes++;
+
+  /* Receive interrupt.*/
+#if CAN_RX_FIFO_SIZE > 0
+  _can_rx_fifo_fill(canp, 1);
+#else
+  if (canp->rxie) {
+    /* No more receive events until the FIFO has been emptied.*/
+    canp->rxie = FALSE;
+    chSysLockFromIsr();
+    while (chSemGetCounterI(&canp->rxsem) < 0)
+      chSemSignalI(&canp->rxsem);
+    chEvtBroadcastFlagsI(&canp->rxfull_event, CAN_MAILBOX_TO_MASK(1));
+    chSysUnlockFromIsr();
+  }
+#endif
+}
+
+/**
+ * @brief   Completes the frame on the bus.
+ * @details The frame is received by all the other active nodes and the
+ *          transmit mailbox is released.
+ *
+ * @notapi
+ */
+static void complete_frame(void) {
+  CANDriver * const *npp;
+  CANDriver *canp, *txp = bus.txnode;
+  const CANTxFrame *ctfp = &txp->txmbx[bus.txmbx];
+
+  bus.busy = FALSE;
+  bus.frames++;
+  bus.bits += frame_bits(ctfp);
+  for (npp = nodes; (canp = *npp) != NULL; npp++) {
+    if ((canp != txp) && (canp->state == CAN_READY))
+      receive_frame(canp, ctfp);
+  }
+
+  /* Transmit interrupt.*/
+  txp->txpending &= ~(1U << bus.txmbx);
+  txp->txframes++;
+#if CAN_TX_QUEUE_SIZE > 0
+  _can_tx_queue_flush(txp, CAN_MAILBOX_TO_MASK(bus.txmbx + 1));
+#else
+  chSysLockFromIsr();
+  while (chSemGetCounterI(&txp->txsem) < 0)
+    chSemSignalI(&txp->txsem);
+  chEvtBroadcastFlagsI(&txp->txempty_event,
+                       CAN_MAILBOX_TO_MASK(bus.txmbx + 1));
+  chSysUnlockFromIsr();
+#endif
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level CAN driver initialization.
+ *
+ * @notapi
+ */
+void can_lld_init(void) {
+
+#if USE_SIM_CAN1
+  canObjectInit(&CAND1);
+#endif
+#if USE_SIM_CAN2
+  canObjectInit(&CAND2);
+#endif
+#if USE_SIM_CAN3
+  canObjectInit(&CAND3);
+#endif
+  bus.busy = FALSE;
+  bus.frames = 0;
+  bus.bits = 0;
+  bus.ticks = chTimeNow();
+  bus.tick_ns = 0;
+  bus.tick_host_ns = hal_lld_get_time_ns();
+}
+
+/**
+ * @brief   Configures and activates the CAN peripheral.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_start(CANDriver *canp) {
+
+  chDbgAssert((canp->config != NULL) && (canp->config->bitrate > 0),
+              "can_lld_start(), #1", "invalid bit rate");
+
+  canp->txpending = 0;
+  canp->txrequests = 0;
+  canp->rxhwidx = 0;
+  canp->rxhwcnt = 0;
+  canp->rxie = TRUE;
+  canp->txframes = 0;
+  canp->rxframes = 0;
+  canp->rxlost = 0;
+  canp->rxrejected = 0;
+}
+
+/**
+ * @brief   Deactivates the CAN peripheral.
+ * @details A frame being transmitted by the node is aborted.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_stop(CANDriver *canp) {
+
+  if (canp->state == CAN_READY) {
+    if (bus.busy && (bus.txnode == canp))
+      bus.busy = FALSE;
+    canp->txpending = 0;
+  }
+}
+
+/**
+ * @brief   Determines whether a frame can be transmitted.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @return              The queue space availability.
+ * @retval FALSE        no space in the transmit queue.
+ * @retval TRUE         transmit slot available.
+ *
+ * @notapi
+ */
+bool_t can_lld_is_tx_empty(CANDriver *canp, canmbx_t mailbox) {
+
+  if (mailbox == CAN_ANY_MAILBOX)
+    return canp->txpending != (1U << CAN_TX_MAILBOXES) - 1;
+  if (mailbox <= CAN_TX_MAILBOXES)
+    return (canp->txpending & (1U << (mailbox - 1))) == 0;
+  return FALSE;
+}
+
+/**
+ * @brief   Inserts a frame into the transmit queue.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] ctfp      pointer to the CAN frame to be transmitted
+ * @param[in] mailbox   mailbox number,  @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @notapi
+ */
+void can_lld_transmit(CANDriver *canp,
+                      canmbx_t mailbox,
+                      const CANTxFrame *ctfp) {
+  unsigned i;
+
+  if (mailbox == CAN_ANY_MAILBOX) {
+    for (i = 0; i < CAN_TX_MAILBOXES; i++)
+      if ((canp->txpending & (1U << i)) == 0)
+        break;
+  }
+  else
+    i = mailbox - 1;
+  if (i >= CAN_TX_MAILBOXES)
+    return;
+  canp->txmbx[i] = *ctfp;
+  canp->txorder[i] = canp->txrequests++;
+  canp->txpending |= 1U << i;
+}
+
+/**
+ * @brief   Determines whether a frame has been received.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ *
+ * @return              The queue space availability.
+ * @retval FALSE        no space in the transmit queue.
+ * @retval TRUE         transmit slot available.
+ *
+ * @notapi
+ */
+bool_t can_lld_is_rx_nonempty(CANDriver *canp, canmbx_t mailbox) {
+
+  if (mailbox > 1)
+    return FALSE;
+  return canp->rxhwcnt > 0;
+}
+
+/**
+ * @brief   Receives a frame from the input queue.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ * @param[out] crfp     pointer to the buffer where the CAN frame is copied
+ *
+ * @notapi
+ */
+void can_lld_receive(CANDriver *canp,
+                     canmbx_t mailbox,
+                     CANRxFrame *crfp) {
+
+  if ((mailbox > 1) || (canp->rxhwcnt == 0))
+    return;
+  *crfp = canp->rxhw[canp->rxhwidx];
+  canp->rxhwidx = (canp->rxhwidx + 1) % CAN_SIM_RX_FIFO_DEPTH;
+
+  /* If the FIFO is empty re-enables the interrupt in order to generate
+     events again.*/
+  if (--canp->rxhwcnt == 0)
+    canp->rxie = TRUE;
+}
+
+#if CAN_USE_SLEEP_MODE || defined(__DOXYGEN__)
+/**
+ * @brief   Enters the sleep mode.
+ * @details A sleeping node does not take part to the bus traffic.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_sleep(CANDriver *canp) {
+
+  (void)canp;
+}
+
+/**
+ * @brief   Enforces leaving the sleep mode.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+void can_lld_wakeup(CANDriver *canp) {
+
+  (void)canp;
+}
+#endif /* CAN_USE_SLEEP_MODE */
+
+/**
+ * @brief   Simulated CAN interrupt sources.
+ * @details Completes the frames on the bus whose time is elapsed then
+ *          arbitrates the next frame. A frame starts immediately after the
+ *          previous one if already pending.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no interrupt has been served.
+ * @retval TRUE         if at least an interrupt has been served.
+ *
+ * @notapi
+ */
+bool_t can_lld_interrupt_pending(void) {
+  uint64_t now;
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+  now = bus_time();
+  while (bus.busy && (now >= bus.end_ns)) {
+    complete_frame();
+    arbitrate(bus.end_ns);
+    b = TRUE;
+  }
+  if (!bus.busy)
+    arbitrate(now);
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+/**
+ * @brief   Simulated bus statistics.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[out] frames   frames transmitted on the bus
+ * @param[out] bits     bits transmitted on the bus
+ *
+ * @api
+ */
+void canSimGetBusStats(uint64_t *frames, uint64_t *bits) {
+
+  chSysLock();
+  *frames = bus.frames;
+  *bits = bus.bits;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Programs the acceptance filters of a node.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] num       number of entries in the filters array, if zero then
+ *                      all frames are accepted
+ * @param[in] cfp       pointer to the filters array, can be @p NULL if
+ *                      (num == 0)
+ *
+ * @api
+ */
+void canSimSetFilters(CANDriver *canp, uint32_t num, const CANFilter *cfp) {
+  uint32_t i;
+
+  chDbgCheck((canp != NULL) && (num <= CAN_SIM_MAX_FILTERS) &&
+             ((cfp != NULL) || (num == 0)), "canSimSetFilters");
+
+  chSysLock();
+  for (i = 0; i < num; i++)
+    canp->filters[i] = cfp[i];
+  canp->nfilters = num;
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_CAN */
+
+/** @} */
@@ -0,0 +1,414 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/can_lld.h
+ * @brief   Posix low level simulated CAN driver header.
+ *
+ * @addtogroup POSIX_CAN
+ * @{
+ */
+
+#ifndef _CAN_LLD_H_
+#define _CAN_LLD_H_
+
+#if HAL_USE_CAN || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This switch defines whether the driver implementation supports
+ *          a low power switch mode with automatic an wakeup feature.
+ */
+#define CAN_SUPPORTS_SLEEP          TRUE
+
+/**
+ * @brief   This implementation supports three transmit mailboxes.
+ */
+#define CAN_TX_MAILBOXES            3
+
+/**
+ * @brief   This implementation supports one receive mailbox.
+ */
+#define CAN_RX_MAILBOXES            1
+
+/**
+ * @brief   Depth of the simulated hardware receive FIFO.
+ */
+#define CAN_SIM_RX_FIFO_DEPTH       3
+
+/**
+ * @brief   Number of simulated hardware acceptance filters.
+ */
+#define CAN_SIM_MAX_FILTERS         14
+
+/**
+ * @name    CAN frames helper macros
+ * @{
+ */
+#define CAN_IDE_STD                 0           /**< @brief Standard id.    */
+#define CAN_IDE_EXT                 1           /**< @brief Extended id.    */
+
+#define CAN_RTR_DATA                0           /**< @brief Data frame.     */
+#define CAN_RTR_REMOTE              1           /**< @brief Remote frame.   */
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   CAND1 driver enable switch.
+ * @details If set to @p TRUE the support for CAND1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_CAN1) || defined(__DOXYGEN__)
+#define USE_SIM_CAN1                TRUE
+#endif
+
+/**
+ * @brief   CAND2 driver enable switch.
+ * @details If set to @p TRUE the support for CAND2 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_CAN2) || defined(__DOXYGEN__)
+#define USE_SIM_CAN2                TRUE
+#endif
+
+/**
+ * @brief   CAND3 driver enable switch.
+ * @details If set to @p TRUE the support for CAND3 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_CAN3) || defined(__DOXYGEN__)
+#define USE_SIM_CAN3                TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CAN_USE_SLEEP_MODE && !CAN_SUPPORTS_SLEEP
+#error "CAN sleep mode not supported in this architecture"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of a transmission mailbox index.
+ */
+typedef uint32_t canmbx_t;
+
+/**
+ * @brief   CAN transmission frame.
+ * @note    Accessing the frame data as word16 or word32 is not portable because
+ *          machine data endianness, it can be still useful for a quick filling.
+ */
+typedef struct {
+  struct {
+    uint8_t                 DLC:4;          /**< @brief Data length.        */
+    uint8_t                 RTR:1;          /**< @brief Frame type.         */
+    uint8_t                 IDE:1;          /**< @brief Identifier type.    */
+  };
+  union {
+    struct {
+      uint32_t              SID:11;         /**< @brief Standard identifier.*/
+    };
+    struct {
+      uint32_t              EID:29;         /**< @brief Extended identifier.*/
+    };
+  };
+  union {
+    uint8_t                 data8[8];       /**< @brief Frame data.         */
+    uint16_t                data16[4];      /**< @brief Frame data.         */
+    uint32_t                data32[2];      /**< @brief Frame data.         */
+  };
+} CANTxFrame;
+
+/**
+ * @brief   CAN received frame.
+ * @note    Accessing the frame data as word16 or word32 is not portable because
+ *          machine data endianness, it can be still useful for a quick filling.
+ */
+typedef struct {
+  struct {
+    uint16_t                TIME;           /**< @brief Time stamp.         */
+  };
+  struct {
+    uint8_t                 DLC:4;          /**< @brief Data length.        */
+    uint8_t                 RTR:1;          /**< @brief Frame type.         */
+    uint8_t                 IDE:1;          /**< @brief Identifier type.    */
+  };
+  union {
+    struct {
+      uint32_t              SID:11;         /**< @brief Standard identifier.*/
+    };
+    struct {
+      uint32_t              EID:29;         /**< @brief Extended identifier.*/
+    };
+  };
+  union {
+    uint8_t                 data8[8];       /**< @brief Frame data.         */
+    uint16_t                data16[4];      /**< @brief Frame data.         */
+    uint32_t                data32[2];      /**< @brief Frame data.         */
+  };
+} CANRxFrame;
+
+/**
+ * @brief   CAN filter.
+ * @details A frame is accepted if it has the same identifier type and if
+ *          the identifier bits selected by @p mask are equal to the same
+ *          bits of @p id.
+ */
+typedef struct {
+  /**
+   * @brief   Identifier to be matched.
+   */
+  uint32_t                  id;
+  /**
+   * @brief   Identifier bits to be compared.
+   */
+  uint32_t                  mask;
+  /**
+   * @brief   Identifier type, @p CAN_IDE_STD, @p CAN_IDE_EXT or any other
+   *          value for both types.
+   */
+  uint8_t                   ide;
+} CANFilter;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Bus bit rate in bits per second.
+   * @note    The bit rate of the transmitting node determines the frame
+   *          duration on the simulated bus.
+   */
+  uint32_t                  bitrate;
+} CANConfig;
+
+/**
+ * @brief   Structure representing an CAN driver.
+ */
+typedef struct {
+  /**
+   * @brief   Driver state.
+   */
+  canstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const CANConfig           *config;
+  /**
+   * @brief   Transmission queue semaphore.
+   */
+  Semaphore                 txsem;
+  /**
+   * @brief   Receive queue semaphore.
+   */
+  Semaphore                 rxsem;
+  /**
+   * @brief   One or more frames become available.
+   * @note    After broadcasting this event it will not be broadcasted again
+   *          until the received frames queue has been completely emptied. It
+   *          is <b>not</b> broadcasted for each received frame. It is
+   *          responsibility of the application to empty the queue by
+   *          repeatedly invoking @p chReceive() when listening to this event.
+   *          This behavior minimizes the interrupt served by the system
+   *          because CAN traffic.
+   * @note    The flags associated to the listeners will indicate which
+   *          receive mailboxes become non-empty.
+   */
+  EventSource               rxfull_event;
+  /**
+   * @brief   One or more transmission mailbox become available.
+   * @note    The flags associated to the listeners will indicate which
+   *          transmit mailboxes become empty.
+   *
+   */
+  EventSource               txempty_event;
+  /**
+   * @brief   A CAN bus error happened.
+   * @note    The flags associated to the listeners will indicate the
+   *          error(s) that have occurred.
+   */
+  EventSource               error_event;
+#if CAN_USE_SLEEP_MODE || defined (__DOXYGEN__)
+  /**
+   * @brief   Entering sleep state event.
+   */
+  EventSource               sleep_event;
+  /**
+   * @brief   Exiting sleep state event.
+   */
+  EventSource               wakeup_event;
+#endif /* CAN_USE_SLEEP_MODE */
+#if (CAN_RX_FIFO_SIZE > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief   Software receive FIFO.
+   */
+  CANRxFrame                rxfifo[CAN_RX_FIFO_SIZE];
+  /**
+   * @brief   Receive FIFO read index.
+   */
+  size_t                    rxrdidx;
+  /**
+   * @brief   Receive FIFO write index.
+   */
+  size_t                    rxwridx;
+  /**
+   * @brief   Frames in the receive FIFO.
+   */
+  size_t                    rxcnt;
+  /**
+   * @brief   Frames lost because the receive FIFO was full.
+   */
+  uint32_t                  rxoverflows;
+#endif /* CAN_RX_FIFO_SIZE > 0 */
+#if (CAN_TX_QUEUE_SIZE > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief   Software transmit queue.
+   */
+  CANTxFrame                txqueue[CAN_TX_QUEUE_SIZE];
+  /**
+   * @brief   Transmit queue read index.
+   */
+  size_t                    txrdidx;
+  /**
+   * @brief   Transmit queue write index.
+   */
+  size_t                    txwridx;
+  /**
+   * @brief   Frames in the transmit queue.
+   */
+  size_t                    txcnt;
+#endif /* CAN_TX_QUEUE_SIZE > 0 */
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Transmit mailboxes.
+   */
+  CANTxFrame                txmbx[CAN_TX_MAILBOXES];
+  /**
+   * @brief   Mask of the transmit mailboxes holding a frame.
+   */
+  uint32_t                  txpending;
+  /**
+   * @brief   Transmit requests order of the mailboxes.
+   */
+  uint32_t                  txorder[CAN_TX_MAILBOXES];
+  /**
+   * @brief   Transmit requests counter.
+   */
+  uint32_t                  txrequests;
+  /**
+   * @brief   Simulated hardware receive FIFO.
+   */
+  CANRxFrame                rxhw[CAN_SIM_RX_FIFO_DEPTH];
+  /**
+   * @brief   Hardware receive FIFO read index.
+   */
+  unsigned                  rxhwidx;
+  /**
+   * @brief   Frames in the hardware receive FIFO.
+   */
+  unsigned                  rxhwcnt;
+  /**
+   * @brief   Receive interrupt enabled.
+   */
+  bool_t                    rxie;
+  /**
+   * @brief   Frames transmitted on the bus.
+   */
+  uint32_t                  txframes;
+  /**
+   * @brief   Frames received from the bus.
+   */
+  uint32_t                  rxframes;
+  /**
+   * @brief   Frames lost because the hardware receive FIFO was full.
+   */
+  uint32_t                  rxlost;
+  /**
+   * @brief   Acceptance filters, all frames are accepted if zero.
+   */
+  uint32_t                  nfilters;
+  /**
+   * @brief   Acceptance filters.
+   */
+  CANFilter                 filters[CAN_SIM_MAX_FILTERS];
+  /**
+   * @brief   Frames rejected by the acceptance filters.
+   */
+  uint32_t                  rxrejected;
+} CANDriver;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_CAN1 && !defined(__DOXYGEN__)
+extern CANDriver CAND1;
+#endif
+
+#if USE_SIM_CAN2 && !defined(__DOXYGEN__)
+extern CANDriver CAND2;
+#endif
+
+#if USE_SIM_CAN3 && !defined(__DOXYGEN__)
+extern CANDriver CAND3;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void can_lld_init(void);
+  void can_lld_start(CANDriver *canp);
+  void can_lld_stop(CANDriver *canp);
+  bool_t can_lld_is_tx_empty(CANDriver *canp,
+                             canmbx_t mailbox);
+  void can_lld_transmit(CANDriver *canp,
+                        canmbx_t mailbox,
+                        const CANTxFrame *crfp);
+  bool_t can_lld_is_rx_nonempty(CANDriver *canp,
+                                canmbx_t mailbox);
+  void can_lld_receive(CANDriver *canp,
+                       canmbx_t mailbox,
+                       CANRxFrame *ctfp);
+#if CAN_USE_SLEEP_MODE
+  void can_lld_sleep(CANDriver *canp);
+  void can_lld_wakeup(CANDriver *canp);
+#endif /* CAN_USE_SLEEP_MODE */
+  bool_t can_lld_interrupt_pending(void);
+  void canSimGetBusStats(uint64_t *frames, uint64_t *bits);
+  void canSimSetFilters(CANDriver *canp, uint32_t num, const CANFilter *cfp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_CAN */
+
+#endif /* _CAN_LLD_H_ */
+
+/** @} */
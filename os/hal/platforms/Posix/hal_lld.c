@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "ch.h"
 #include "hal.h"
@@ -82,6 +83,94 @@ void ChkIntSources(void) {
   }
 #endif
 
+#if HAL_USE_SPI
+  /* Not returning here, a transfer is pending most of the time while the
+     SPI is in use and the system tick must not be starved.*/
+  if (spi_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_UART
+  /* Not returning here, a continuous stream must not starve the system
+     tick, the serial over UART driver relies on timeouts.*/
+  if (uart_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_ADC
+  /* Not returning here, at high rates an event is pending most of the
+     time and the system tick must not be starved.*/
+  if (adc_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_CAN
+  /* Not returning here, at full bus load a frame completes every few
+     microseconds and the system tick must not be starved.*/
+  if (can_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_I2C
+  /* Not returning here, queued transactions keep the bus busy and the
+     system tick must not be starved.*/
+  if (i2c_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_I2S
+  /* Not returning here, the sample clock must not starve the system
+     tick.*/
+  if (i2s_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_MAC
+  /* Not returning here, a frames stream must not starve the system
+     tick.*/
+  if (mac_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
+#if HAL_USE_USB
+  /* Not returning here, frames are executed back to back while the device
+     keeps up and the system tick must not be starved.*/
+  if (usb_lld_interrupt_pending()) {
+    dbg_check_lock();
+    if (chSchIsPreemptionRequired())
+      chSchDoReschedule();
+    dbg_check_unlock();
+  }
+#endif
+
   gettimeofday(&tv, NULL);
   if (timercmp(&tv, &nextcnt, >=)) {
     timeradd(&nextcnt, &tick, &nextcnt);
@@ -101,4 +190,33 @@ void ChkIntSources(void) {
   }
 }
 
+/**
+ * @brief   Realtime counter value.
+ * @details The host monotonic clock in nanoseconds, truncated to the
+ *          counter width.
+ *
+ * @return              The value of the free running counter.
+ *
+ * @notapi
+ */
+halrtcnt_t hal_lld_get_counter(void) {
+
+  return (halrtcnt_t)hal_lld_get_time_ns();
+}
+
+/**
+ * @brief   Host monotonic time.
+ * @details Common time base of the simulated peripherals.
+ *
+ * @return              The time in nanoseconds.
+ *
+ * @notapi
+ */
+uint64_t hal_lld_get_time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
 /** @} */
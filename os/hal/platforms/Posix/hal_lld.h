@@ -36,7 +36,7 @@
 /**
  * @brief   Defines the support for realtime counters in the HAL.
  */
-#define HAL_IMPLEMENTS_COUNTERS FALSE
+#define HAL_IMPLEMENTS_COUNTERS TRUE
 
 /**
  * @brief   Platform name.
@@ -58,10 +58,42 @@
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Type representing a system clock frequency.
+ */
+typedef uint32_t halclock_t;
+
+/**
+ * @brief   Type of the realtime free counter value.
+ */
+typedef uint32_t halrtcnt_t;
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Returns the current value of the system free running counter.
+ * @note    This service is implemented by reading the host monotonic clock,
+ *          the counter wraps every 4.29 seconds.
+ *
+ * @return              The value of the system free running counter of
+ *                      type halrtcnt_t.
+ *
+ * @notapi
+ */
+#define hal_lld_get_counter_value()         hal_lld_get_counter()
+
+/**
+ * @brief   Realtime counter frequency.
+ * @note    The host monotonic clock has nanoseconds resolution.
+ *
+ * @return              The realtime counter frequency of type halclock_t.
+ *
+ * @notapi
+ */
+#define hal_lld_get_counter_frequency()     1000000000UL
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -71,6 +103,8 @@ extern "C" {
 #endif
   void hal_lld_init(void);
   void ChkIntSources(void);
+  halrtcnt_t hal_lld_get_counter(void);
+  uint64_t hal_lld_get_time_ns(void);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,387 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/i2c_lld.c
+ * @brief   Posix low level simulated I2C driver code.
+ * @details The bytes are exchanged with the slave model attached at the
+ *          transfer address when the transfer starts, the transfer is
+ *          completed from the simulated interrupt sources polling after
+ *          the time required on the bus, nine clocks for each byte plus
+ *          the start, repeated start and stop conditions.
+ * @note    Clock stretching and multi-master arbitration are not
+ *          simulated.
+ *
+ * @addtogroup POSIX_I2C
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_I2C || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define NS_PER_SECOND       1000000000ULL
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief I2C1 driver identifier.*/
+#if USE_SIM_I2C1 || defined(__DOXYGEN__)
+I2CDriver I2CD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Finds the slave model attached at an address.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @return              The slave model or @p NULL.
+ *
+ * @notapi
+ */
+static I2CSlaveModel *find_slave(I2CDriver *i2cp, i2caddr_t addr) {
+  unsigned i;
+
+  for (i = 0; i < i2cp->nslaves; i++) {
+    if (i2cp->addresses[i] == addr)
+      return i2cp->slaves[i];
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Starts a transfer.
+ * @details The bytes are exchanged with the slave model and the transfer
+ *          end time is computed, a transfer started while completing the
+ *          previous one begins when the previous one ended.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ *
+ * @notapi
+ */
+static void start_transfer(I2CDriver *i2cp, i2caddr_t addr,
+                           const uint8_t *txbuf, size_t txbytes,
+                           uint8_t *rxbuf, size_t rxbytes) {
+  I2CSlaveModel *smp = find_slave(i2cp, addr);
+  bool_t ack = TRUE, addressed = FALSE;
+  uint64_t bits = 1;
+  size_t i;
+
+  if (txbytes > 0) {
+    bits += 9;
+    ack = (smp != NULL) && smp->vmt->start(smp, FALSE);
+    addressed = ack;
+    for (i = 0; ack && (i < txbytes); i++) {
+      bits += 9;
+      ack = smp->vmt->write(smp, txbuf[i]);
+    }
+  }
+  if (ack && (rxbytes > 0)) {
+    bits += txbytes > 0 ? 10 : 9;
+    ack = (smp != NULL) && smp->vmt->start(smp, TRUE);
+    addressed = addressed || ack;
+    for (i = 0; ack && (i < rxbytes); i++) {
+      bits += 9;
+      rxbuf[i] = smp->vmt->read(smp);
+    }
+  }
+  if (addressed)
+    smp->vmt->stop(smp);
+  bits += 1;
+
+  if (ack)
+    i2cp->result = RDY_OK;
+  else {
+    i2cp->errors |= I2CD_ACK_FAILURE;
+    i2cp->result = RDY_RESET;
+  }
+  i2cp->start_ns = i2cp->completing ? i2cp->end_ns : hal_lld_get_time_ns();
+  i2cp->end_ns = i2cp->start_ns +
+                 (bits * NS_PER_SECOND) / i2cp->config->clock_speed;
+  i2cp->busy = TRUE;
+}
+
+/**
+ * @brief   Completes the transfer on the bus.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+static void complete_transfer(I2CDriver *i2cp) {
+
+  i2cp->busy = FALSE;
+  i2cp->transfers++;
+  i2cp->busy_ns += i2cp->end_ns - i2cp->start_ns;
+  if (i2cp->thread != NULL) {
+    Thread *tp = i2cp->thread;
+
+    i2cp->thread = NULL;
+    chSysLockFromIsr();
+    tp->p_u.rdymsg = i2cp->result;
+    chSchReadyI(tp);
+    chSysUnlockFromIsr();
+  }
+#if I2C_USE_QUEUE
+  else {
+    i2cp->completing = TRUE;
+    _i2c_queue_complete(i2cp, i2cp->result);
+    i2cp->completing = FALSE;
+  }
+#endif
+}
+
+/**
+ * @brief   Starts a transfer and waits for its completion.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] timeout   the number of ticks before the operation timeouts
+ * @return              The operation status.
+ *
+ * @notapi
+ */
+static msg_t transfer_wait(I2CDriver *i2cp, i2caddr_t addr,
+                           const uint8_t *txbuf, size_t txbytes,
+                           uint8_t *rxbuf, size_t rxbytes,
+                           systime_t timeout) {
+  msg_t msg;
+
+  start_transfer(i2cp, addr, txbuf, txbytes, rxbuf, rxbytes);
+  i2cp->thread = chThdSelf();
+  msg = chSchGoSleepTimeoutS(THD_STATE_SUSPENDED, timeout);
+  if (msg == RDY_TIMEOUT) {
+    i2cp->thread = NULL;
+    i2cp->busy = FALSE;
+  }
+  return msg;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level I2C driver initialization.
+ *
+ * @notapi
+ */
+void i2c_lld_init(void) {
+
+#if USE_SIM_I2C1
+  i2cObjectInit(&I2CD1);
+  I2CD1.thread = NULL;
+  I2CD1.busy = FALSE;
+  I2CD1.completing = FALSE;
+  I2CD1.nslaves = 0;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the I2C peripheral.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+void i2c_lld_start(I2CDriver *i2cp) {
+
+  chDbgAssert(i2cp->config->clock_speed > 0,
+              "i2c_lld_start(), #1", "invalid clock speed");
+
+  i2cp->busy = FALSE;
+  i2cp->transfers = 0;
+  i2cp->busy_ns = 0;
+}
+
+/**
+ * @brief   Deactivates the I2C peripheral.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+void i2c_lld_stop(I2CDriver *i2cp) {
+
+  i2cp->busy = FALSE;
+}
+
+/**
+ * @brief   Receives data via the I2C bus as master.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the function succeeded.
+ * @retval RDY_RESET    if one or more I2C errors occurred, the errors can
+ *                      be retrieved using @p i2cGetErrors().
+ * @retval RDY_TIMEOUT  if a timeout occurred before operation end.
+ *
+ * @notapi
+ */
+msg_t i2c_lld_master_receive_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                     uint8_t *rxbuf, size_t rxbytes,
+                                     systime_t timeout) {
+
+  return transfer_wait(i2cp, addr, NULL, 0, rxbuf, rxbytes, timeout);
+}
+
+/**
+ * @brief   Transmits data via the I2C bus as master.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address
+ * @param[in] txbuf     pointer to the transmit buffer
+ * @param[in] txbytes   number of bytes to be transmitted
+ * @param[out] rxbuf    pointer to the receive buffer
+ * @param[in] rxbytes   number of bytes to be received
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the function succeeded.
+ * @retval RDY_RESET    if one or more I2C errors occurred, the errors can
+ *                      be retrieved using @p i2cGetErrors().
+ * @retval RDY_TIMEOUT  if a timeout occurred before operation end.
+ *
+ * @notapi
+ */
+msg_t i2c_lld_master_transmit_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                      const uint8_t *txbuf, size_t txbytes,
+                                      uint8_t *rxbuf, size_t rxbytes,
+                                      systime_t timeout) {
+
+  return transfer_wait(i2cp, addr, txbuf, txbytes, rxbuf, rxbytes, timeout);
+}
+
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Starts a queued transaction.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] itp       pointer to the transaction
+ *
+ * @notapi
+ */
+void i2c_lld_start_transaction(I2CDriver *i2cp, const I2CTransaction *itp) {
+
+  start_transfer(i2cp, itp->addr, itp->txbuf, itp->txbytes,
+                 itp->rxbuf, itp->rxbytes);
+}
+#endif /* I2C_USE_QUEUE */
+
+/**
+ * @brief   Simulated interrupt sources polling.
+ *
+ * @return              @p TRUE if an interrupt was served.
+ *
+ * @notapi
+ */
+bool_t i2c_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_I2C1
+  if (I2CD1.busy && (hal_lld_get_time_ns() >= I2CD1.end_ns)) {
+    complete_transfer(&I2CD1);
+    b = TRUE;
+  }
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+/**
+ * @brief   Attaches a slave model to the bus.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      slave device address (7 bits) without R/W bit
+ * @param[in] smp       pointer to the @p I2CSlaveModel object
+ *
+ * @api
+ */
+void i2cSimAttachSlave(I2CDriver *i2cp, i2caddr_t addr, I2CSlaveModel *smp) {
+
+  chDbgCheck((i2cp != NULL) && (smp != NULL) &&
+             (i2cp->nslaves < I2C_SIM_MAX_SLAVES), "i2cSimAttachSlave");
+
+  chSysLock();
+  i2cp->addresses[i2cp->nslaves] = addr;
+  i2cp->slaves[i2cp->nslaves] = smp;
+  i2cp->nslaves++;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Simulated bus statistics.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[out] transfers completed transfers
+ * @param[out] busy_ns  total bus busy time in nanoseconds
+ *
+ * @api
+ */
+void i2cSimGetBusStats(I2CDriver *i2cp, uint32_t *transfers,
+                       uint64_t *busy_ns) {
+
+  chSysLock();
+  *transfers = i2cp->transfers;
+  *busy_ns = i2cp->busy_ns;
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_I2C */
+
+/** @} */
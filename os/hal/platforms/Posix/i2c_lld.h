@@ -0,0 +1,275 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/i2c_lld.h
+ * @brief   Posix low level simulated I2C driver header.
+ *
+ * @addtogroup POSIX_I2C
+ * @{
+ */
+
+#ifndef _I2C_LLD_H_
+#define _I2C_LLD_H_
+
+#if HAL_USE_I2C || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This implementation supports the transactions queue.
+ */
+#define I2C_SUPPORTS_QUEUE          TRUE
+
+/**
+ * @brief   Maximum number of slave models attached to a bus.
+ */
+#define I2C_SIM_MAX_SLAVES          16
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   I2CD1 driver enable switch.
+ * @details If set to @p TRUE the support for I2CD1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_I2C1) || defined(__DOXYGEN__)
+#define USE_SIM_I2C1                TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type representing I2C address.
+ */
+typedef uint16_t i2caddr_t;
+
+/**
+ * @brief   Type of I2C Driver condition flags.
+ */
+typedef uint32_t i2cflags_t;
+
+/**
+ * @brief   @p I2CSlaveModel specific methods.
+ * @note    The methods are invoked from the simulated interrupt context.
+ */
+#define _i2c_slave_model_methods                                            \
+  /* Start or repeated start condition addressing the device, returns       \
+     FALSE in order to not acknowledge the address.*/                       \
+  bool_t (*start)(void *instance, bool_t read);                             \
+  /* Byte written by the master, returns FALSE in order to not              \
+     acknowledge the byte.*/                                                \
+  bool_t (*write)(void *instance, uint8_t b);                               \
+  /* Byte read by the master.*/                                             \
+  uint8_t (*read)(void *instance);                                          \
+  /* Stop condition after the device has been addressed.*/                  \
+  void (*stop)(void *instance);
+
+/**
+ * @brief   @p I2CSlaveModel specific data.
+ * @note    It is empty because @p I2CSlaveModel is only an interface
+ *          without implementation.
+ */
+#define _i2c_slave_model_data
+
+/**
+ * @brief   @p I2CSlaveModel virtual methods table.
+ */
+struct I2CSlaveModelVMT {
+  _i2c_slave_model_methods
+};
+
+/**
+ * @brief   Simulated I2C slave device.
+ * @details This class represents a device attached to a simulated I2C bus
+ *          at a given address, the model sees the start and stop
+ *          conditions and each transferred byte.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct I2CSlaveModelVMT *vmt;
+  _i2c_slave_model_data
+} I2CSlaveModel;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Bus clock speed in Hz.
+   */
+  uint32_t                  clock_speed;
+} I2CConfig;
+
+/**
+ * @brief   Type of a structure representing an I2C driver.
+ */
+typedef struct I2CDriver I2CDriver;
+
+/**
+ * @brief Structure representing an I2C driver.
+ */
+struct I2CDriver {
+  /**
+   * @brief   Driver state.
+   */
+  i2cstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const I2CConfig           *config;
+  /**
+   * @brief   Error flags.
+   */
+  i2cflags_t                errors;
+#if I2C_USE_MUTUAL_EXCLUSION || defined(__DOXYGEN__)
+#if CH_USE_MUTEXES || defined(__DOXYGEN__)
+  /**
+   * @brief   Mutex protecting the bus.
+   */
+  Mutex                     mutex;
+#elif CH_USE_SEMAPHORES
+  Semaphore                 semaphore;
+#endif
+#endif /* I2C_USE_MUTUAL_EXCLUSION */
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+  /**
+   * @brief   Transaction being executed, head of the queue.
+   */
+  I2CTransaction            *qhead;
+  /**
+   * @brief   Last queued transaction.
+   */
+  I2CTransaction            *qtail;
+  /**
+   * @brief   Threads waiting for the queue to become empty.
+   */
+  Semaphore                 qsem;
+  /**
+   * @brief   The transactions queue became empty.
+   */
+  EventSource               queue_event;
+#endif /* I2C_USE_QUEUE */
+#if defined(I2C_DRIVER_EXT_FIELDS)
+  I2C_DRIVER_EXT_FIELDS
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Thread waiting for a blocking transfer.
+   */
+  Thread                    *thread;
+  /**
+   * @brief   A transfer is in progress on the bus.
+   */
+  bool_t                    busy;
+  /**
+   * @brief   The completion of a transfer is being processed.
+   */
+  bool_t                    completing;
+  /**
+   * @brief   Result of the transfer in progress.
+   */
+  msg_t                     result;
+  /**
+   * @brief   Host time of the start of the transfer in progress.
+   */
+  uint64_t                  start_ns;
+  /**
+   * @brief   Host time of the end of the transfer in progress.
+   */
+  uint64_t                  end_ns;
+  /**
+   * @brief   Addresses of the attached slave models.
+   */
+  i2caddr_t                 addresses[I2C_SIM_MAX_SLAVES];
+  /**
+   * @brief   Attached slave models.
+   */
+  I2CSlaveModel             *slaves[I2C_SIM_MAX_SLAVES];
+  /**
+   * @brief   Number of attached slave models.
+   */
+  unsigned                  nslaves;
+  /**
+   * @brief   Completed transfers.
+   */
+  uint32_t                  transfers;
+  /**
+   * @brief   Total bus busy time in nanoseconds.
+   */
+  uint64_t                  busy_ns;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Get errors from I2C driver.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+#define i2c_lld_get_errors(i2cp) ((i2cp)->errors)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_I2C1 && !defined(__DOXYGEN__)
+extern I2CDriver I2CD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void i2c_lld_init(void);
+  void i2c_lld_start(I2CDriver *i2cp);
+  void i2c_lld_stop(I2CDriver *i2cp);
+  msg_t i2c_lld_master_transmit_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                        const uint8_t *txbuf, size_t txbytes,
+                                        uint8_t *rxbuf, size_t rxbytes,
+                                        systime_t timeout);
+  msg_t i2c_lld_master_receive_timeout(I2CDriver *i2cp, i2caddr_t addr,
+                                       uint8_t *rxbuf, size_t rxbytes,
+                                       systime_t timeout);
+#if I2C_USE_QUEUE
+  void i2c_lld_start_transaction(I2CDriver *i2cp, const I2CTransaction *itp);
+#endif
+  bool_t i2c_lld_interrupt_pending(void);
+  void i2cSimAttachSlave(I2CDriver *i2cp, i2caddr_t addr, I2CSlaveModel *smp);
+  void i2cSimGetBusStats(I2CDriver *i2cp, uint32_t *transfers,
+                         uint64_t *busy_ns);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_I2C */
+
+#endif /* _I2C_LLD_H_ */
+
+/** @} */
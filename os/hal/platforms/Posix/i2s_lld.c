@@ -0,0 +1,437 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/i2s_lld.c
+ * @brief   Posix low level simulated I2S driver code.
+ * @details The interface streams the transmitted samples to a file and
+ *          the received samples from a file, in WAV or raw format. The
+ *          half buffers are exchanged at the configured sample clock
+ *          measured on the host clock, like a DMA would do, and the half
+ *          and full buffer events are served as simulated interrupts.
+ * @note    The samples are stored in the files in the host byte order,
+ *          the simulator only runs on little endian hosts.
+ *
+ * @addtogroup POSIX_I2S
+ * @{
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_I2S || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define NS_PER_SECOND       1000000000ULL
+
+#define WAV_HEADER_SIZE     44
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief I2S1 driver identifier.*/
+#if USE_SIM_I2S1 || defined(__DOXYGEN__)
+I2SDriver I2SD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static void put16(uint8_t *p, uint16_t v) {
+
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+
+  put16(p, (uint16_t)v);
+  put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) {
+
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+
+  return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+/**
+ * @brief   Checks if a file name selects the WAV format.
+ *
+ * @param[in] name      the file name
+ * @return              The file format.
+ * @retval FALSE        raw samples.
+ * @retval TRUE         WAV file.
+ *
+ * @notapi
+ */
+static bool_t is_wav(const char *name) {
+  size_t n = strlen(name);
+
+  return (n >= 4) && (strcasecmp(name + n - 4, ".wav") == 0);
+}
+
+/**
+ * @brief   Writes the WAV header of the transmit file.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+static void write_wav_header(I2SDriver *i2sp) {
+  const I2SConfig *cfg = i2sp->config;
+  uint8_t h[WAV_HEADER_SIZE];
+
+  memcpy(&h[0], "RIFF", 4);
+  put32(&h[4], WAV_HEADER_SIZE - 8 + i2sp->txbytes);
+  memcpy(&h[8], "WAVEfmt ", 8);
+  put32(&h[16], 16);
+  put16(&h[20], 1);
+  put16(&h[22], cfg->channels);
+  put32(&h[24], cfg->rate);
+  put32(&h[28], cfg->rate * cfg->channels * sizeof(i2ssample_t));
+  put16(&h[32], cfg->channels * sizeof(i2ssample_t));
+  put16(&h[34], 16);
+  memcpy(&h[36], "data", 4);
+  put32(&h[40], i2sp->txbytes);
+  fseek(i2sp->txf, 0, SEEK_SET);
+  fwrite(h, 1, sizeof(h), i2sp->txf);
+}
+
+/**
+ * @brief   Locates the samples in a WAV receive file.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ * @return              The operation status.
+ * @retval FALSE        if the samples have been located.
+ * @retval TRUE         if the file is not a 16 bits PCM WAV file matching
+ *                      the configured channels.
+ *
+ * @notapi
+ */
+static bool_t read_wav_header(I2SDriver *i2sp) {
+  uint8_t h[16];
+  uint32_t size;
+  bool_t fmt = FALSE;
+
+  if ((fread(h, 1, 12, i2sp->rxf) != 12) ||
+      (memcmp(&h[0], "RIFF", 4) != 0) || (memcmp(&h[8], "WAVE", 4) != 0))
+    return TRUE;
+  while (fread(h, 1, 8, i2sp->rxf) == 8) {
+    size = get32(&h[4]);
+    if (memcmp(&h[0], "data", 4) == 0) {
+      i2sp->rxdata = ftell(i2sp->rxf);
+      return !fmt;
+    }
+    if (memcmp(&h[0], "fmt ", 4) == 0) {
+      if ((size < 16) || (fread(h, 1, 16, i2sp->rxf) != 16))
+        return TRUE;
+      if ((get16(&h[0]) != 1) || (get16(&h[14]) != 16) ||
+          (get16(&h[2]) != i2sp->config->channels))
+        return TRUE;
+      fmt = TRUE;
+      size -= 16;
+    }
+    /* Chunks are word aligned.*/
+    if (fseek(i2sp->rxf, (long)((size + 1) & ~1U), SEEK_CUR) != 0)
+      return TRUE;
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Opens the files associated to the configuration.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+static void open_files(I2SDriver *i2sp) {
+  const I2SConfig *cfg = i2sp->config;
+
+  i2sp->txbytes = 0;
+  i2sp->txwav = FALSE;
+  if (cfg->tx_file != NULL) {
+    i2sp->txf = fopen(cfg->tx_file, "wb");
+    chDbgAssert(i2sp->txf != NULL,
+                "open_files(), #1", "unable to create the TX file");
+    if ((i2sp->txf != NULL) && is_wav(cfg->tx_file)) {
+      i2sp->txwav = TRUE;
+      write_wav_header(i2sp);
+    }
+  }
+
+  i2sp->rxdata = 0;
+  if (cfg->rx_file != NULL) {
+    i2sp->rxf = fopen(cfg->rx_file, "rb");
+    if ((i2sp->rxf != NULL) && is_wav(cfg->rx_file) &&
+        read_wav_header(i2sp)) {
+      chDbgAssert(FALSE, "open_files(), #2", "invalid WAV file");
+      fclose(i2sp->rxf);
+      i2sp->rxf = NULL;
+    }
+  }
+}
+
+/**
+ * @brief   Closes the files, the WAV header is completed.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+static void close_files(I2SDriver *i2sp) {
+
+  if (i2sp->txf != NULL) {
+    if (i2sp->txwav)
+      write_wav_header(i2sp);
+    fclose(i2sp->txf);
+    i2sp->txf = NULL;
+  }
+  if (i2sp->rxf != NULL) {
+    fclose(i2sp->rxf);
+    i2sp->rxf = NULL;
+  }
+}
+
+/**
+ * @brief   Receives samples from the receive file.
+ * @details The file is read circularly, silence is received if there is
+ *          no file or if it is empty.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ * @param[out] bp       pointer to the samples buffer
+ * @param[in] n         number of samples to be received
+ *
+ * @notapi
+ */
+static void receive(I2SDriver *i2sp, i2ssample_t *bp, size_t n) {
+  size_t r;
+  bool_t rewound = FALSE;
+
+  while ((n > 0) && (i2sp->rxf != NULL)) {
+    r = fread(bp, sizeof(i2ssample_t), n, i2sp->rxf);
+    if (r == 0) {
+      if (rewound)
+        break;
+      fseek(i2sp->rxf, i2sp->rxdata, SEEK_SET);
+      rewound = TRUE;
+      continue;
+    }
+    rewound = FALSE;
+    bp += r;
+    n -= r;
+  }
+  memset(bp, 0, n * sizeof(i2ssample_t));
+}
+
+/**
+ * @brief   Serves the simulated interrupt sources of a driver.
+ * @details The transmit half buffer is written in the file and the
+ *          receive half buffer is filled from the file when the sample
+ *          clock reaches the half buffer boundary, at most one event is
+ *          served for each invocation.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t serve_interrupt(I2SDriver *i2sp) {
+  const I2SConfig *cfg = i2sp->config;
+  uint64_t due, ns;
+  size_t half, offset;
+
+  if (i2sp->state != I2S_ACTIVE)
+    return FALSE;
+
+  /* Half buffers due at the current time.*/
+  half = cfg->size / 2;
+  if (cfg->rate != 0) {
+    ns = hal_lld_get_time_ns() - i2sp->start_ns;
+    due = (ns / NS_PER_SECOND) * cfg->rate +
+          ((ns % NS_PER_SECOND) * cfg->rate) / NS_PER_SECOND;
+    if (due / (half / cfg->channels) <= i2sp->halves)
+      return FALSE;
+  }
+
+  /* Exchange of the half buffer.*/
+  offset = (i2sp->halves & 1) != 0 ? half : 0;
+  i2sp->halves++;
+  if ((cfg->tx_buffer != NULL) && (i2sp->txf != NULL)) {
+    fwrite((const i2ssample_t *)cfg->tx_buffer + offset,
+           sizeof(i2ssample_t), half, i2sp->txf);
+    i2sp->txbytes += half * sizeof(i2ssample_t);
+  }
+  if (cfg->rx_buffer != NULL)
+    receive(i2sp, (i2ssample_t *)cfg->rx_buffer + offset, half);
+
+  /* Events.*/
+  if (offset == 0) {
+    _i2s_isr_half_code(i2sp);
+  }
+  else if (i2sp->continuous) {
+    _i2s_isr_full_code(i2sp);
+  }
+  else {
+    _i2s_isr_complete_code(i2sp);
+  }
+  return TRUE;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level I2S driver initialization.
+ *
+ * @notapi
+ */
+void i2s_lld_init(void) {
+
+#if USE_SIM_I2S1
+  i2sObjectInit(&I2SD1);
+  I2SD1.txf = NULL;
+  I2SD1.rxf = NULL;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the I2S peripheral.
+ * @details The files of the previous configuration, if any, are closed
+ *          and the files of the new configuration are opened.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start(I2SDriver *i2sp) {
+
+  chDbgAssert((i2sp->config->channels > 0) &&
+              (i2sp->config->size > 0) &&
+              (i2sp->config->size % (2 * i2sp->config->channels) == 0),
+              "i2s_lld_start(), #1", "invalid buffer size");
+
+  if (i2sp->state == I2S_READY)
+    close_files(i2sp);
+  open_files(i2sp);
+}
+
+/**
+ * @brief   Deactivates the I2S peripheral.
+ * @details The files are closed.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_stop(I2SDriver *i2sp) {
+
+  if (i2sp->state == I2S_READY)
+    close_files(i2sp);
+}
+
+/**
+ * @brief   Starts a I2S data exchange.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start_exchange(I2SDriver *i2sp) {
+
+  i2sp->continuous = FALSE;
+  i2sp->halves = 0;
+  i2sp->start_ns = hal_lld_get_time_ns();
+}
+
+/**
+ * @brief   Starts a I2S data exchange in continuous mode.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start_exchange_continuous(I2SDriver *i2sp) {
+
+  i2s_lld_start_exchange(i2sp);
+  i2sp->continuous = TRUE;
+}
+
+/**
+ * @brief   Stops the ongoing data exchange.
+ * @details The transmitted samples are flushed to the file.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_stop_exchange(I2SDriver *i2sp) {
+
+  i2sp->continuous = FALSE;
+  if (i2sp->txf != NULL)
+    fflush(i2sp->txf);
+}
+
+/**
+ * @brief   Simulated I2S interrupt sources.
+ * @details Exchanges the half buffers due and invokes the driver
+ *          callbacks.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no interrupt has been served.
+ * @retval TRUE         if at least an interrupt has been served.
+ *
+ * @notapi
+ */
+bool_t i2s_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_I2S1
+  b = serve_interrupt(&I2SD1) || b;
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_I2S */
+
+/** @} */
@@ -0,0 +1,212 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/i2s_lld.h
+ * @brief   Posix low level simulated I2S driver header.
+ *
+ * @addtogroup POSIX_I2S
+ * @{
+ */
+
+#ifndef _I2S_LLD_H_
+#define _I2S_LLD_H_
+
+#if HAL_USE_I2S || defined(__DOXYGEN__)
+
+#include <stdio.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   I2SD1 driver enable switch.
+ * @details If set to @p TRUE the support for I2SD1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_I2S1) || defined(__DOXYGEN__)
+#define USE_SIM_I2S1                TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   I2S sample data type.
+ * @details The simulated interface exchanges 16 bits signed samples, the
+ *          channels are interleaved in the buffers.
+ */
+typedef int16_t i2ssample_t;
+
+/**
+ * @brief   I2S notification callback type.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object triggering the
+ *                      callback
+ * @param[in] offset    offset in samples of the half buffer just exchanged
+ * @param[in] n         number of samples in the half buffer
+ */
+typedef void (*i2scallback_t)(I2SDriver *i2sp, size_t offset, size_t n);
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   Transmission buffer pointer.
+   * @note    Can be @p NULL if TX is not required.
+   */
+  const void                *tx_buffer;
+  /**
+   * @brief   Receive buffer pointer.
+   * @note    Can be @p NULL if RX is not required.
+   */
+  void                      *rx_buffer;
+  /**
+   * @brief   TX and RX buffers size as number of samples.
+   * @note    Must be a multiple of twice the number of channels.
+   */
+  size_t                    size;
+  /**
+   * @brief   Callback function called after each half buffer.
+   */
+  i2scallback_t             end_cb;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Sample clock in frames per second.
+   * @note    Zero means free running, an half buffer is exchanged for each
+   *          simulated interrupt, this is meant for load testing.
+   */
+  uint32_t                  rate;
+  /**
+   * @brief   Number of interleaved channels in a frame.
+   */
+  uint16_t                  channels;
+  /**
+   * @brief   File receiving the transmitted samples or @p NULL.
+   * @details A name ending in ".wav" selects the WAV format, any other
+   *          name selects raw little endian samples.
+   */
+  const char                *tx_file;
+  /**
+   * @brief   File providing the received samples or @p NULL.
+   * @details A name ending in ".wav" selects the WAV format, any other
+   *          name selects raw little endian samples. The file is read
+   *          circularly, silence is received if it is missing or empty.
+   */
+  const char                *rx_file;
+} I2SConfig;
+
+/**
+ * @brief   Structure representing an I2S driver.
+ */
+struct I2SDriver {
+  /**
+   * @brief   Driver state.
+   */
+  i2sstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const I2SConfig           *config;
+  /**
+   * @brief   The last notified half buffer has not been released.
+   */
+  bool_t                    pending;
+  /**
+   * @brief   Transmit underruns counter.
+   */
+  uint32_t                  underruns;
+  /**
+   * @brief   Receive overruns counter.
+   */
+  uint32_t                  overruns;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Transmit file or @p NULL.
+   */
+  FILE                      *txf;
+  /**
+   * @brief   Receive file or @p NULL.
+   */
+  FILE                      *rxf;
+  /**
+   * @brief   The transmit file is in WAV format.
+   */
+  bool_t                    txwav;
+  /**
+   * @brief   Offset of the samples in the receive file.
+   */
+  long                      rxdata;
+  /**
+   * @brief   Bytes written in the transmit file.
+   */
+  uint32_t                  txbytes;
+  /**
+   * @brief   The exchange is circular.
+   */
+  bool_t                    continuous;
+  /**
+   * @brief   Host time of the exchange start in nanoseconds.
+   */
+  uint64_t                  start_ns;
+  /**
+   * @brief   Half buffers exchanged since the exchange start.
+   */
+  uint64_t                  halves;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_I2S1 && !defined(__DOXYGEN__)
+extern I2SDriver I2SD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void i2s_lld_init(void);
+  void i2s_lld_start(I2SDriver *i2sp);
+  void i2s_lld_stop(I2SDriver *i2sp);
+  void i2s_lld_start_exchange(I2SDriver *i2sp);
+  void i2s_lld_start_exchange_continuous(I2SDriver *i2sp);
+  void i2s_lld_stop_exchange(I2SDriver *i2sp);
+  bool_t i2s_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_I2S */
+
+#endif /* _I2S_LLD_H_ */
+
+/** @} */
@@ -0,0 +1,729 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/mac_lld.c
+ * @brief   Posix low level simulated MAC driver code.
+ * @details The driver is attached to one of the two endpoints of a virtual
+ *          wire, a pair of UNIX domain datagram sockets, each frame is
+ *          carried by a datagram. Another simulator instance, or another
+ *          driver of the same instance, is attached to the other endpoint.
+ *          The link is up when the other endpoint exists, zero sized
+ *          datagrams are used as link pulses.
+ * @note    Transmitted frames are handed to the host immediately, there
+ *          is no line rate simulation. Received frames are copied into
+ *          the receive descriptors from the simulated interrupt sources
+ *          polling and are lost if no descriptor is available.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sched.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief Ethernet driver 1.*/
+#if USE_SIM_MAC1 || defined(__DOXYGEN__)
+MACDriver ETHD1;
+#endif
+
+/** @brief Ethernet driver 2.*/
+#if USE_SIM_MAC2 || defined(__DOXYGEN__)
+MACDriver ETHD2;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static const uint8_t default_mac_address[] = {0xAA, 0x55, 0x13,
+                                              0x37, 0x01, 0x10};
+
+/**
+ * @brief   Buffer for the frames lost because the receive ring is full.
+ */
+static uint8_t discard_buffer[SIM_MAC_BUFFERS_SIZE];
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds the socket address of a wire endpoint.
+ *
+ * @param[out] sap      pointer to the socket address
+ * @param[in] wire      virtual wire path
+ * @param[in] end       wire endpoint
+ *
+ * @notapi
+ */
+static void wire_address(struct sockaddr_un *sap,
+                         const char *wire, unsigned end) {
+
+  memset(sap, 0, sizeof (*sap));
+  sap->sun_family = AF_UNIX;
+  snprintf(sap->sun_path, sizeof (sap->sun_path), "%s.%u", wire, end & 1);
+}
+
+/**
+ * @brief   Sends a datagram to the other endpoint of the wire.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] buf       pointer to the datagram data
+ * @param[in] n         datagram size, zero for a link pulse
+ * @return              The operation status.
+ * @retval RDY_OK       if the datagram has been sent.
+ * @retval RDY_TIMEOUT  if the other endpoint is not able to accept the
+ *                      datagram at this time.
+ * @retval RDY_RESET    if the other endpoint is not connected.
+ *
+ * @notapi
+ */
+static msg_t wire_send(MACDriver *macp, const void *buf, size_t n) {
+
+  if (macp->sock < 0)
+    return RDY_RESET;
+  if (sendto(macp->sock, buf, n, MSG_DONTWAIT,
+             (struct sockaddr *)&macp->peer, sizeof (macp->peer)) >= 0)
+    return RDY_OK;
+  if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS))
+    return RDY_TIMEOUT;
+  return RDY_RESET;
+}
+
+/**
+ * @brief   Destination address filter.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] frame     pointer to the frame data
+ * @param[in] n         frame size
+ * @return              The filter result.
+ * @retval TRUE         if the frame is addressed to this station or to a
+ *                      group address.
+ * @retval FALSE        if the frame must be discarded.
+ *
+ * @notapi
+ */
+static bool_t address_match(MACDriver *macp, const uint8_t *frame, size_t n) {
+
+  if (n < 14)
+    return FALSE;
+  return (frame[0] & 1) || (memcmp(frame, macp->address, 6) == 0);
+}
+
+/**
+ * @brief   Sends the frames in the transmit descriptors owned by the DMA.
+ * @details The transmission stops on the first descriptor not owned by
+ *          the DMA or if the other endpoint is busy, the remaining frames
+ *          are sent on the next invocation.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The descriptors release status.
+ * @retval TRUE         if one or more descriptors have been released.
+ * @retval FALSE        if no descriptors have been released.
+ *
+ * @notapi
+ */
+static bool_t dma_transmit(MACDriver *macp) {
+  bool_t released = FALSE;
+
+  while (macp->td[macp->txdma].flags & SIM_MAC_DESC_OWN) {
+    sim_mac_descriptor_t *tdes = &macp->td[macp->txdma];
+    msg_t msg = wire_send(macp, tdes->buffer, tdes->size);
+
+    if (msg == RDY_TIMEOUT)
+      break;
+    if (msg == RDY_OK)
+      macp->txframes++;
+    else {
+      /* No carrier, the frame is lost.*/
+      macp->txerrors++;
+      macp->link_up = FALSE;
+    }
+    tdes->flags = 0;
+    macp->txdma = (macp->txdma + 1) % SIM_MAC_TRANSMIT_BUFFERS;
+    released = TRUE;
+  }
+  return released;
+}
+
+/**
+ * @brief   Copies the frames waiting on the wire into the receive
+ *          descriptors owned by the DMA.
+ * @note    At most one ring worth of frames is served for each invocation.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The frames reception status.
+ * @retval TRUE         if one or more frames have been received.
+ * @retval FALSE        if no frames have been received.
+ *
+ * @notapi
+ */
+static bool_t dma_receive(MACDriver *macp) {
+  bool_t received = FALSE;
+  unsigned i;
+
+  for (i = 0; i < SIM_MAC_RECEIVE_BUFFERS; i++) {
+    sim_mac_descriptor_t *rdes = &macp->rd[macp->rxdma];
+    ssize_t n;
+
+    if (!(rdes->flags & SIM_MAC_DESC_OWN)) {
+      /* Receive ring full, the frame is lost.*/
+      n = recv(macp->sock, discard_buffer, sizeof (discard_buffer),
+               MSG_DONTWAIT);
+      if (n < 0)
+        break;
+      if (n > 0)
+        macp->rxlost++;
+      continue;
+    }
+
+    n = recv(macp->sock, rdes->buffer, SIM_MAC_BUFFERS_SIZE, MSG_DONTWAIT);
+    if (n < 0)
+      break;
+    if (n == 0) {
+      /* Link pulse.*/
+      continue;
+    }
+    if (!address_match(macp, rdes->buffer, (size_t)n)) {
+      macp->rxfiltered++;
+      continue;
+    }
+    rdes->size  = (size_t)n;
+    rdes->flags = 0;
+    macp->rxdma = (macp->rxdma + 1) % SIM_MAC_RECEIVE_BUFFERS;
+    macp->rxframes++;
+    received = TRUE;
+  }
+  return received;
+}
+
+/**
+ * @brief   Simulated DMA events handling.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The interrupt status.
+ * @retval TRUE         if an interrupt has been served.
+ * @retval FALSE        if no interrupt was pending.
+ *
+ * @notapi
+ */
+static bool_t serve_interrupt(MACDriver *macp) {
+  bool_t tx, rx;
+
+  if (macp->sock < 0)
+    return FALSE;
+
+  tx = dma_transmit(macp);
+  rx = dma_receive(macp);
+
+  chSysLockFromIsr();
+  if (tx) {
+    /* Data Transmitted.*/
+    chSemResetI(&macp->tdsem, 0);
+  }
+  if (rx) {
+    /* Data Received.*/
+    chSemResetI(&macp->rdsem, 0);
+#if MAC_USE_EVENTS
+    chEvtBroadcastI(&macp->rdevent);
+#endif
+  }
+  chSysUnlockFromIsr();
+
+  return tx || rx;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level MAC initialization.
+ *
+ * @notapi
+ */
+void mac_lld_init(void) {
+
+#if USE_SIM_MAC1
+  macObjectInit(&ETHD1);
+  ETHD1.link_up = FALSE;
+  ETHD1.wire    = SIM_MAC1_WIRE;
+  ETHD1.end     = SIM_MAC1_END;
+  ETHD1.sock    = -1;
+#endif
+
+#if USE_SIM_MAC2
+  macObjectInit(&ETHD2);
+  ETHD2.link_up = FALSE;
+  ETHD2.wire    = SIM_MAC2_WIRE;
+  ETHD2.end     = SIM_MAC2_END;
+  ETHD2.sock    = -1;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the MAC peripheral.
+ * @details The endpoint socket is bound to the wire, a stale socket left
+ *          by a previous instance is replaced.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_start(MACDriver *macp) {
+  struct sockaddr_un local;
+  unsigned i;
+
+  /* Wire specified in the configuration or driver default.*/
+  if (macp->config->wire != NULL) {
+    macp->wire = macp->config->wire;
+    macp->end  = macp->config->end;
+  }
+  wire_address(&local, macp->wire, macp->end);
+  wire_address(&macp->peer, macp->wire, macp->end + 1);
+
+  /* Resets the state of all descriptors.*/
+  for (i = 0; i < SIM_MAC_RECEIVE_BUFFERS; i++)
+    macp->rd[i].flags = SIM_MAC_DESC_OWN;
+  for (i = 0; i < SIM_MAC_TRANSMIT_BUFFERS; i++)
+    macp->td[i].flags = 0;
+  macp->rxptr = macp->rxdma = 0;
+  macp->txptr = macp->txdma = 0;
+
+  macp->txframes   = 0;
+  macp->txerrors   = 0;
+  macp->rxframes   = 0;
+  macp->rxlost     = 0;
+  macp->rxfiltered = 0;
+
+  /* MAC address setup.*/
+  if (macp->config->mac_address == NULL)
+    memcpy(macp->address, default_mac_address, 6);
+  else
+    memcpy(macp->address, macp->config->mac_address, 6);
+
+  /* Endpoint socket.*/
+  macp->sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+  chDbgAssert(macp->sock >= 0, "mac_lld_start(), #1", "socket failed");
+  unlink(local.sun_path);
+  if ((bind(macp->sock, (struct sockaddr *)&local, sizeof (local)) < 0) ||
+      (fcntl(macp->sock, F_SETFL, O_NONBLOCK) < 0)) {
+    chDbgAssert(FALSE, "mac_lld_start(), #2", "bind failed");
+    close(macp->sock);
+    macp->sock = -1;
+  }
+
+  /* Initial link status.*/
+  macp->link_up = wire_send(macp, NULL, 0) != RDY_RESET;
+}
+
+/**
+ * @brief   Deactivates the MAC peripheral.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ *
+ * @notapi
+ */
+void mac_lld_stop(MACDriver *macp) {
+
+  if ((macp->state != MAC_STOP) && (macp->sock >= 0)) {
+    struct sockaddr_un local;
+
+    close(macp->sock);
+    macp->sock = -1;
+    wire_address(&local, macp->wire, macp->end);
+    unlink(local.sun_path);
+  }
+  macp->link_up = FALSE;
+}
+
+/**
+ * @brief   Returns a transmission descriptor.
+ * @details One of the available transmission descriptors is locked and
+ *          returned.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] tdp      pointer to a @p MACTransmitDescriptor structure
+ * @return              The operation status.
+ * @retval RDY_OK       the descriptor has been obtained.
+ * @retval RDY_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                      MACTransmitDescriptor *tdp) {
+  sim_mac_descriptor_t *tdes;
+
+  if (!macp->link_up)
+    return RDY_TIMEOUT;
+
+  chSysLock();
+
+  /* Get Current TX descriptor.*/
+  tdes = &macp->td[macp->txptr];
+
+  /* Ensure that descriptor isn't owned by the DMA or locked by another
+     thread.*/
+  if (tdes->flags & (SIM_MAC_DESC_OWN | SIM_MAC_DESC_LOCKED)) {
+    chSysUnlock();
+    return RDY_TIMEOUT;
+  }
+
+  /* Marks the current descriptor as locked.*/
+  tdes->flags = SIM_MAC_DESC_LOCKED;
+
+  /* Next TX descriptor to use.*/
+  macp->txptr = (macp->txptr + 1) % SIM_MAC_TRANSMIT_BUFFERS;
+
+  chSysUnlock();
+
+  /* Set the buffer size and configuration.*/
+  tdp->offset   = 0;
+  tdp->size     = SIM_MAC_BUFFERS_SIZE;
+  tdp->physdesc = tdes;
+  tdp->macp     = macp;
+
+  return RDY_OK;
+}
+
+/**
+ * @brief   Releases a transmit descriptor and starts the transmission of the
+ *          enqueued data as a single frame.
+ * @details The simulated DMA is started immediately, the frames the other
+ *          endpoint is not able to accept are sent later from the
+ *          simulated interrupt sources polling.
+ *
+ * @param[in] tdp       the pointer to the @p MACTransmitDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp) {
+  MACDriver *macp = tdp->macp;
+
+  chDbgAssert(!(tdp->physdesc->flags & SIM_MAC_DESC_OWN),
+              "mac_lld_release_transmit_descriptor(), #1",
+              "attempt to release descriptor already owned by DMA");
+
+  chSysLock();
+
+  /* Unlocks the descriptor and returns it to the DMA engine.*/
+  tdp->physdesc->size  = tdp->offset;
+  tdp->physdesc->flags = SIM_MAC_DESC_OWN;
+
+  /* DMA restart.*/
+  if (dma_transmit(macp)) {
+    chSemResetI(&macp->tdsem, 0);
+    chSchRescheduleS();
+  }
+
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns a receive descriptor.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[out] rdp      pointer to a @p MACReceiveDescriptor structure
+ * @return              The operation status.
+ * @retval RDY_OK       the descriptor has been obtained.
+ * @retval RDY_TIMEOUT  descriptor not available.
+ *
+ * @notapi
+ */
+msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                     MACReceiveDescriptor *rdp) {
+  sim_mac_descriptor_t *rdes;
+
+  chSysLock();
+
+  /* Get Current RX descriptor.*/
+  rdes = &macp->rd[macp->rxptr];
+
+  /* Descriptors owned by the DMA or still locked by another thread are
+     not available.*/
+  if (rdes->flags & (SIM_MAC_DESC_OWN | SIM_MAC_DESC_LOCKED)) {
+    chSysUnlock();
+    return RDY_TIMEOUT;
+  }
+
+  /* Marks the current descriptor as locked.*/
+  rdes->flags = SIM_MAC_DESC_LOCKED;
+
+  /* Next RX descriptor to check.*/
+  macp->rxptr = (macp->rxptr + 1) % SIM_MAC_RECEIVE_BUFFERS;
+
+  chSysUnlock();
+
+  rdp->offset   = 0;
+  rdp->size     = rdes->size;
+  rdp->physdesc = rdes;
+
+  return RDY_OK;
+}
+
+/**
+ * @brief   Releases a receive descriptor.
+ * @details The descriptor and its buffer are made available for more incoming
+ *          frames.
+ *
+ * @param[in] rdp       the pointer to the @p MACReceiveDescriptor structure
+ *
+ * @notapi
+ */
+void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp) {
+
+  chDbgAssert(!(rdp->physdesc->flags & SIM_MAC_DESC_OWN),
+              "mac_lld_release_receive_descriptor(), #1",
+              "attempt to release descriptor already owned by DMA");
+
+  chSysLock();
+
+  /* Give buffer back to the DMA.*/
+  rdp->physdesc->flags = SIM_MAC_DESC_OWN;
+
+  chSysUnlock();
+}
+
+/**
+ * @brief   Updates and returns the link status.
+ * @details A link pulse is sent to the other endpoint, the link is up if
+ *          the other endpoint exists.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @return              The link status.
+ * @retval TRUE         if the link is active.
+ * @retval FALSE        if the link is down.
+ *
+ * @notapi
+ */
+bool_t mac_lld_poll_link_status(MACDriver *macp) {
+
+  return macp->link_up = wire_send(macp, NULL, 0) != RDY_RESET;
+}
+
+/**
+ * @brief   Writes to a transmit descriptor's stream.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] buf       pointer to the buffer containing the data to be
+ *                      written
+ * @param[in] size      number of bytes to be written
+ * @return              The number of bytes written into the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if the maximum
+ *                      frame size is reached.
+ *
+ * @notapi
+ */
+size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                         uint8_t *buf,
+                                         size_t size) {
+
+  chDbgAssert(!(tdp->physdesc->flags & SIM_MAC_DESC_OWN),
+              "mac_lld_write_transmit_descriptor(), #1",
+              "attempt to write descriptor already owned by DMA");
+
+  if (size > tdp->size - tdp->offset)
+    size = tdp->size - tdp->offset;
+
+  if (size > 0) {
+    memcpy(tdp->physdesc->buffer + tdp->offset, buf, size);
+    tdp->offset += size;
+  }
+  return size;
+}
+
+/**
+ * @brief   Reads from a receive descriptor's stream.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[in] buf       pointer to the buffer that will receive the read data
+ * @param[in] size      number of bytes to be read
+ * @return              The number of bytes read from the descriptor's
+ *                      stream, this value can be less than the amount
+ *                      specified in the parameter @p size if there are
+ *                      no more bytes to read.
+ *
+ * @notapi
+ */
+size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                       uint8_t *buf,
+                                       size_t size) {
+
+  chDbgAssert(!(rdp->physdesc->flags & SIM_MAC_DESC_OWN),
+              "mac_lld_read_receive_descriptor(), #1",
+              "attempt to read descriptor already owned by DMA");
+
+  if (size > rdp->size - rdp->offset)
+    size = rdp->size - rdp->offset;
+
+  if (size > 0) {
+    memcpy(buf, rdp->physdesc->buffer + rdp->offset, size);
+    rdp->offset += size;
+  }
+  return size;
+}
+
+#if MAC_USE_ZERO_COPY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns a pointer to the next transmit buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that enough buffers can be requested to fill
+ *          a whole frame.
+ *
+ * @param[in] tdp       pointer to a @p MACTransmitDescriptor structure
+ * @param[in] size      size of the requested buffer. Specify the frame size
+ *                      on the first call then scale the value down subtracting
+ *                      the amount of data already copied into the previous
+ *                      buffers.
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ *                      Note that a returned size lower than the amount
+ *                      requested means that more buffers must be requested
+ *                      in order to fill the frame data entirely.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                          size_t size,
+                                          size_t *sizep) {
+
+  if (tdp->offset == 0) {
+    *sizep      = tdp->size;
+    tdp->offset = size;
+    return tdp->physdesc->buffer;
+  }
+  *sizep = 0;
+  return NULL;
+}
+
+/**
+ * @brief   Returns a pointer to the next receive buffer in the descriptor
+ *          chain.
+ * @note    The API guarantees that the descriptor chain contains a whole
+ *          frame.
+ *
+ * @param[in] rdp       pointer to a @p MACReceiveDescriptor structure
+ * @param[out] sizep    pointer to variable receiving the buffer size, it is
+ *                      zero when the last buffer has already been returned.
+ * @return              Pointer to the returned buffer.
+ * @retval NULL         if the buffer chain has been entirely scanned.
+ *
+ * @notapi
+ */
+const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                               size_t *sizep) {
+
+  if (rdp->size > 0) {
+    *sizep      = rdp->size;
+    rdp->offset = rdp->size;
+    rdp->size   = 0;
+    return rdp->physdesc->buffer;
+  }
+  *sizep = 0;
+  return NULL;
+}
+#endif /* MAC_USE_ZERO_COPY */
+
+/**
+ * @brief   Simulated interrupt sources polling.
+ * @details Sends the frames the other endpoint was not able to accept and
+ *          receives the frames waiting on the wire.
+ *
+ * @return              The interrupt status.
+ * @retval TRUE         if an interrupt has been served.
+ * @retval FALSE        if no interrupt was pending.
+ *
+ * @notapi
+ */
+bool_t mac_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_MAC1
+  if (ETHD1.state == MAC_ACTIVE)
+    b |= serve_interrupt(&ETHD1);
+#endif
+
+#if USE_SIM_MAC2
+  if (ETHD2.state == MAC_ACTIVE)
+    b |= serve_interrupt(&ETHD2);
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  /* Nothing pending, the host CPU is yielded to the simulator instance
+     attached to the other end of the wire, it could share the same
+     core.*/
+  if (!b)
+    sched_yield();
+
+  return b;
+}
+
+/**
+ * @brief   Selects the virtual wire of a MAC driver.
+ * @details The wire is used by the next @p macStart() if the configuration
+ *          does not specify one, a simulator instance attached to the
+ *          other endpoint is the peer of the driver.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] macp      pointer to the @p MACDriver object
+ * @param[in] wire      virtual wire path, the endpoints are the sockets
+ *                      <tt>&lt;wire&gt;.0</tt> and <tt>&lt;wire&gt;.1</tt>
+ * @param[in] end       wire endpoint, zero or one
+ *
+ * @api
+ */
+void macSimSetWire(MACDriver *macp, const char *wire, unsigned end) {
+
+  chDbgCheck((macp != NULL) && (wire != NULL) && (end <= 1),
+             "macSimSetWire");
+  chDbgAssert(macp->state == MAC_STOP, "macSimSetWire(), #1",
+              "invalid state");
+
+  macp->wire = wire;
+  macp->end  = end;
+}
+
+#endif /* HAL_USE_MAC */
+
+/** @} */
@@ -0,0 +1,366 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/mac_lld.h
+ * @brief   Posix low level simulated MAC driver header.
+ *
+ * @addtogroup POSIX_MAC
+ * @{
+ */
+
+#ifndef _MAC_LLD_H_
+#define _MAC_LLD_H_
+
+#if HAL_USE_MAC || defined(__DOXYGEN__)
+
+#include <sys/un.h>
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   This implementation supports the zero-copy mode API.
+ */
+#define MAC_SUPPORTS_ZERO_COPY      TRUE
+
+/**
+ * @brief   Size of the frame buffers, a whole frame fits in a buffer.
+ */
+#define SIM_MAC_BUFFERS_SIZE        1536
+
+/**
+ * @name    Simulated descriptors flags
+ * @{
+ */
+#define SIM_MAC_DESC_OWN            0x80000000  /**< @brief Owned by DMA.   */
+#define SIM_MAC_DESC_LOCKED         0x40000000  /**< @brief Owned by thread.*/
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Configuration options
+ * @{
+ */
+/**
+ * @brief   ETHD1 driver enable switch.
+ * @details If set to @p TRUE the support for ETHD1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_MAC1) || defined(__DOXYGEN__)
+#define USE_SIM_MAC1                TRUE
+#endif
+
+/**
+ * @brief   ETHD2 driver enable switch.
+ * @details If set to @p TRUE the support for ETHD2 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_MAC2) || defined(__DOXYGEN__)
+#define USE_SIM_MAC2                TRUE
+#endif
+
+/**
+ * @brief   Number of available transmit buffers.
+ */
+#if !defined(SIM_MAC_TRANSMIT_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_TRANSMIT_BUFFERS    2
+#endif
+
+/**
+ * @brief   Number of available receive buffers.
+ */
+#if !defined(SIM_MAC_RECEIVE_BUFFERS) || defined(__DOXYGEN__)
+#define SIM_MAC_RECEIVE_BUFFERS     4
+#endif
+
+/**
+ * @brief   Default virtual wire of ETHD1.
+ * @details The endpoints of a wire are the UNIX domain sockets
+ *          <tt>&lt;wire&gt;.0</tt> and <tt>&lt;wire&gt;.1</tt>.
+ */
+#if !defined(SIM_MAC1_WIRE) || defined(__DOXYGEN__)
+#define SIM_MAC1_WIRE               "/tmp/chibios-eth1"
+#endif
+
+/**
+ * @brief   Default wire endpoint of ETHD1.
+ */
+#if !defined(SIM_MAC1_END) || defined(__DOXYGEN__)
+#define SIM_MAC1_END                0
+#endif
+
+/**
+ * @brief   Default virtual wire of ETHD2.
+ */
+#if !defined(SIM_MAC2_WIRE) || defined(__DOXYGEN__)
+#define SIM_MAC2_WIRE               "/tmp/chibios-eth2"
+#endif
+
+/**
+ * @brief   Default wire endpoint of ETHD2.
+ */
+#if !defined(SIM_MAC2_END) || defined(__DOXYGEN__)
+#define SIM_MAC2_END                0
+#endif
+/** @} */
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (SIM_MAC_TRANSMIT_BUFFERS < 1) || (SIM_MAC_RECEIVE_BUFFERS < 1)
+#error "invalid number of MAC buffers"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Simulated DMA descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Ownership flags.
+   */
+  uint32_t                  flags;
+  /**
+   * @brief   Frame size.
+   */
+  size_t                    size;
+  /**
+   * @brief   Frame buffer.
+   */
+  uint8_t                   buffer[SIM_MAC_BUFFERS_SIZE];
+} sim_mac_descriptor_t;
+
+/**
+ * @brief   Driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   MAC address.
+   */
+  uint8_t                   *mac_address;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Virtual wire path or @p NULL for the driver default.
+   */
+  const char                *wire;
+  /**
+   * @brief   Wire endpoint, zero or one.
+   * @note    Ignored if @p wire is @p NULL.
+   */
+  unsigned                  end;
+} MACConfig;
+
+/**
+ * @brief   Structure representing a MAC driver.
+ */
+struct MACDriver {
+  /**
+   * @brief   Driver state.
+   */
+  macstate_t                state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const MACConfig           *config;
+  /**
+   * @brief   Transmit semaphore.
+   */
+  Semaphore                 tdsem;
+  /**
+   * @brief   Receive semaphore.
+   */
+  Semaphore                 rdsem;
+#if MAC_USE_EVENTS || defined(__DOXYGEN__)
+  /**
+   * @brief   Receive event.
+   */
+  EventSource               rdevent;
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Link status flag.
+   */
+  bool_t                    link_up;
+  /**
+   * @brief   Virtual wire path.
+   */
+  const char                *wire;
+  /**
+   * @brief   Wire endpoint.
+   */
+  unsigned                  end;
+  /**
+   * @brief   Endpoint socket, negative if the driver is stopped.
+   */
+  int                       sock;
+  /**
+   * @brief   Address of the other endpoint of the wire.
+   */
+  struct sockaddr_un        peer;
+  /**
+   * @brief   Current MAC address.
+   */
+  uint8_t                   address[6];
+  /**
+   * @brief   Receive descriptors ring.
+   */
+  sim_mac_descriptor_t      rd[SIM_MAC_RECEIVE_BUFFERS];
+  /**
+   * @brief   Transmit descriptors ring.
+   */
+  sim_mac_descriptor_t      td[SIM_MAC_TRANSMIT_BUFFERS];
+  /**
+   * @brief   Next receive descriptor to be returned to the application.
+   */
+  unsigned                  rxptr;
+  /**
+   * @brief   Next transmit descriptor to be returned to the application.
+   */
+  unsigned                  txptr;
+  /**
+   * @brief   Next receive descriptor to be filled by the DMA.
+   */
+  unsigned                  rxdma;
+  /**
+   * @brief   Next transmit descriptor to be sent by the DMA.
+   */
+  unsigned                  txdma;
+  /**
+   * @brief   Frames transmitted on the wire.
+   */
+  uint32_t                  txframes;
+  /**
+   * @brief   Frames lost because the other endpoint was not connected.
+   */
+  uint32_t                  txerrors;
+  /**
+   * @brief   Frames received from the wire.
+   */
+  uint32_t                  rxframes;
+  /**
+   * @brief   Frames lost because no receive descriptor was available.
+   */
+  uint32_t                  rxlost;
+  /**
+   * @brief   Frames discarded by the destination address filter.
+   */
+  uint32_t                  rxfiltered;
+};
+
+/**
+ * @brief   Structure representing a transmit descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Current write offset.
+   */
+  size_t                    offset;
+  /**
+   * @brief   Available space size.
+   */
+  size_t                    size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Pointer to the physical descriptor.
+   */
+  sim_mac_descriptor_t      *physdesc;
+  /**
+   * @brief   Driver owning the descriptor.
+   */
+  MACDriver                 *macp;
+} MACTransmitDescriptor;
+
+/**
+ * @brief   Structure representing a receive descriptor.
+ */
+typedef struct {
+  /**
+   * @brief   Current read offset.
+   */
+  size_t                    offset;
+  /**
+   * @brief   Available data size.
+   */
+  size_t                    size;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Pointer to the physical descriptor.
+   */
+  sim_mac_descriptor_t      *physdesc;
+} MACReceiveDescriptor;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_MAC1 && !defined(__DOXYGEN__)
+extern MACDriver ETHD1;
+#endif
+
+#if USE_SIM_MAC2 && !defined(__DOXYGEN__)
+extern MACDriver ETHD2;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void mac_lld_init(void);
+  void mac_lld_start(MACDriver *macp);
+  void mac_lld_stop(MACDriver *macp);
+  msg_t mac_lld_get_transmit_descriptor(MACDriver *macp,
+                                        MACTransmitDescriptor *tdp);
+  void mac_lld_release_transmit_descriptor(MACTransmitDescriptor *tdp);
+  msg_t mac_lld_get_receive_descriptor(MACDriver *macp,
+                                       MACReceiveDescriptor *rdp);
+  void mac_lld_release_receive_descriptor(MACReceiveDescriptor *rdp);
+  bool_t mac_lld_poll_link_status(MACDriver *macp);
+  size_t mac_lld_write_transmit_descriptor(MACTransmitDescriptor *tdp,
+                                           uint8_t *buf,
+                                           size_t size);
+  size_t mac_lld_read_receive_descriptor(MACReceiveDescriptor *rdp,
+                                         uint8_t *buf,
+                                         size_t size);
+#if MAC_USE_ZERO_COPY
+  uint8_t *mac_lld_get_next_transmit_buffer(MACTransmitDescriptor *tdp,
+                                            size_t size,
+                                            size_t *sizep);
+  const uint8_t *mac_lld_get_next_receive_buffer(MACReceiveDescriptor *rdp,
+                                                 size_t *sizep);
+#endif /* MAC_USE_ZERO_COPY */
+  bool_t mac_lld_interrupt_pending(void);
+  void macSimSetWire(MACDriver *macp, const char *wire, unsigned end);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_MAC */
+
+#endif /* _MAC_LLD_H_ */
+
+/** @} */
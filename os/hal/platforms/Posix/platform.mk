@@ -1,7 +1,16 @@
 # List of all the Posix platform files.
 PLATFORMSRC = ${CHIBIOS}/os/hal/platforms/Posix/hal_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/adc_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/can_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/i2c_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/i2s_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/mac_lld.c \
               ${CHIBIOS}/os/hal/platforms/Posix/pal_lld.c \
-              ${CHIBIOS}/os/hal/platforms/Posix/serial_lld.c
+              ${CHIBIOS}/os/hal/platforms/Posix/serial_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/spi_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/uart_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/usb_lld.c \
+              ${CHIBIOS}/os/hal/platforms/Posix/simsdc.c
 
 # Required include directories
 PLATFORMINC = ${CHIBIOS}/os/hal/platforms/Posix
@@ -0,0 +1,520 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/simsdc.c
+ * @brief   Simulated SD card in SPI mode code.
+ *
+ * @addtogroup POSIX_SIMSDC
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simsdc.h"
+
+#if HAL_USE_SPI || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @name    R1 response bits
+ * @{
+ */
+#define R1_IDLE                     0x01
+#define R1_ILLEGAL_COMMAND          0x04
+#define R1_COM_CRC_ERROR            0x08
+#define R1_ADDRESS_ERROR            0x20
+#define R1_PARAMETER_ERROR          0x40
+/** @} */
+
+/**
+ * @name    Data tokens and responses
+ * @{
+ */
+#define TOKEN_START_BLOCK           0xFE
+#define TOKEN_START_MULTIPLE        0xFC
+#define TOKEN_STOP_TRAN             0xFD
+#define TOKEN_ERROR_OUT_OF_RANGE    0x08
+#define DATA_ACCEPTED               0xE5
+#define DATA_CRC_ERROR              0xEB
+#define DATA_WRITE_ERROR            0xED
+/** @} */
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static void simsdc_select(void *instance);
+static void simsdc_unselect(void *instance);
+static uint8_t simsdc_exchange(void *instance, uint8_t frame);
+
+static const struct SimSDCardVMT vmt = {
+  simsdc_select,
+  simsdc_unselect,
+  simsdc_exchange
+};
+
+/**
+ * @brief   CID register of the emulated card.
+ */
+static const uint8_t cid[16] = {
+  0x00, 'C', 'H', 'S', 'I', 'M', 'S', 'D',
+  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0xD1, 0x01
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static uint8_t crc7(const uint8_t *p, size_t n) {
+  uint8_t crc = 0;
+
+  while (n--) {
+    unsigned i;
+    uint8_t b = *p++;
+
+    for (i = 0; i < 8; i++) {
+      crc <<= 1;
+      if ((b ^ crc) & 0x80)
+        crc ^= 0x09;
+      b <<= 1;
+    }
+  }
+  return crc & 0x7F;
+}
+
+static uint16_t crc16(const uint8_t *p, size_t n) {
+  uint16_t crc = 0;
+
+  while (n--) {
+    unsigned i;
+
+    crc ^= (uint16_t)*p++ << 8;
+    for (i = 0; i < 8; i++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+static void reset(SimSDCard *sdcp) {
+
+  sdcp->idle        = TRUE;
+  sdcp->app_cmd     = FALSE;
+  sdcp->crc_enabled = FALSE;
+  sdcp->init_polls  = SIMSDC_INIT_POLLS;
+  sdcp->state       = SIMSDC_CMD;
+  sdcp->busy        = 0;
+  sdcp->cmd_n       = 0;
+  sdcp->obuf_n      = 0;
+  sdcp->obuf_i      = 0;
+}
+
+static void put(SimSDCard *sdcp, uint8_t b) {
+
+  chDbgAssert(sdcp->obuf_n < SIMSDC_OBUF_SIZE, "put(), #1", "overflow");
+  sdcp->obuf[sdcp->obuf_n++] = b;
+}
+
+/**
+ * @brief   Queues a data packet, the data token is preceded by the read
+ *          latency and followed by the CRC16.
+ */
+static void put_data(SimSDCard *sdcp, const uint8_t *p, size_t n) {
+  unsigned i;
+  uint16_t crc = crc16(p, n);
+
+  for (i = 0; i < SIMSDC_READ_LATENCY; i++)
+    put(sdcp, 0xFF);
+  put(sdcp, TOKEN_START_BLOCK);
+  memcpy(&sdcp->obuf[sdcp->obuf_n], p, n);
+  sdcp->obuf_n += n;
+  put(sdcp, (uint8_t)(crc >> 8));
+  put(sdcp, (uint8_t)crc);
+}
+
+/**
+ * @brief   Queues the current block and advances to the next one.
+ */
+static void put_block(SimSDCard *sdcp) {
+  uint8_t buf[SIMSDC_BLOCK_SIZE];
+
+  if ((sdcp->block >= sdcp->capacity) ||
+      (fseek(sdcp->file, (long)sdcp->block * SIMSDC_BLOCK_SIZE,
+             SEEK_SET) != 0) ||
+      (fread(buf, 1, SIMSDC_BLOCK_SIZE, sdcp->file) != SIMSDC_BLOCK_SIZE)) {
+    put(sdcp, 0xFF);
+    put(sdcp, TOKEN_ERROR_OUT_OF_RANGE);
+    sdcp->state = SIMSDC_CMD;
+    return;
+  }
+  put_data(sdcp, buf, SIMSDC_BLOCK_SIZE);
+  sdcp->block++;
+  sdcp->blocks_read++;
+}
+
+static bool_t write_block(SimSDCard *sdcp, uint32_t block, const uint8_t *p) {
+
+  if ((block >= sdcp->capacity) ||
+      (fseek(sdcp->file, (long)block * SIMSDC_BLOCK_SIZE, SEEK_SET) != 0) ||
+      (fwrite(p, 1, SIMSDC_BLOCK_SIZE, sdcp->file) != SIMSDC_BLOCK_SIZE))
+    return CH_FAILED;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Handles a received data block.
+ */
+static void data_received(SimSDCard *sdcp) {
+  uint16_t crc;
+
+  sdcp->state = sdcp->multiple ? SIMSDC_WAIT_TOKEN : SIMSDC_CMD;
+  crc = ((uint16_t)sdcp->data[SIMSDC_BLOCK_SIZE] << 8) |
+        sdcp->data[SIMSDC_BLOCK_SIZE + 1];
+  if (sdcp->crc_enabled && (crc != crc16(sdcp->data, SIMSDC_BLOCK_SIZE))) {
+    sdcp->crc_errors++;
+    put(sdcp, DATA_CRC_ERROR);
+    sdcp->state = SIMSDC_CMD;
+    return;
+  }
+  if (write_block(sdcp, sdcp->block, sdcp->data)) {
+    put(sdcp, DATA_WRITE_ERROR);
+    sdcp->state = SIMSDC_CMD;
+    return;
+  }
+  put(sdcp, DATA_ACCEPTED);
+  sdcp->block++;
+  sdcp->blocks_written++;
+  sdcp->busy = SIMSDC_WRITE_BUSY;
+}
+
+/**
+ * @brief   Executes a received command.
+ */
+static void command(SimSDCard *sdcp) {
+  uint8_t cmd = sdcp->cmd[0] & 0x3F;
+  uint32_t arg = ((uint32_t)sdcp->cmd[1] << 24) |
+                 ((uint32_t)sdcp->cmd[2] << 16) |
+                 ((uint32_t)sdcp->cmd[3] << 8)  |
+                 (uint32_t)sdcp->cmd[4];
+  bool_t app_cmd = sdcp->app_cmd;
+  uint8_t r1;
+  uint32_t i;
+
+  /* Any command aborts the output in progress, the response starts after
+     one stuff byte.*/
+  sdcp->obuf_n = 0;
+  sdcp->obuf_i = 0;
+  sdcp->app_cmd = FALSE;
+  put(sdcp, 0xFF);
+
+  /* CMD0 and CMD8 are always checked, the other commands only if the CRC
+     has been enabled.*/
+  if ((sdcp->crc_enabled || (cmd == 0) || (cmd == 8)) &&
+      ((sdcp->cmd[5] >> 1) != crc7(sdcp->cmd, 5))) {
+    sdcp->crc_errors++;
+    put(sdcp, R1_COM_CRC_ERROR | (sdcp->idle ? R1_IDLE : 0));
+    return;
+  }
+
+  if (cmd == 0) {
+    reset(sdcp);
+    put(sdcp, 0xFF);
+    put(sdcp, R1_IDLE);
+    return;
+  }
+
+  r1 = sdcp->idle ? R1_IDLE : 0;
+  if (sdcp->idle && (cmd != 1) && (cmd != 8) && (cmd != 55) &&
+      (cmd != 58) && (cmd != 59) && !(app_cmd && (cmd == 41))) {
+    put(sdcp, r1 | R1_ILLEGAL_COMMAND);
+    return;
+  }
+
+  switch (cmd) {
+  case 1:
+  case 41:
+    if ((cmd == 41) && !app_cmd)
+      goto illegal;
+    if (sdcp->idle && (--sdcp->init_polls == 0))
+      sdcp->idle = FALSE;
+    put(sdcp, sdcp->idle ? R1_IDLE : 0);
+    return;
+  case 8:
+    put(sdcp, r1);
+    put(sdcp, 0x00);
+    put(sdcp, 0x00);
+    put(sdcp, (uint8_t)((arg >> 8) & 0x0F));
+    put(sdcp, (uint8_t)arg);
+    return;
+  case 9:
+  case 10:
+    put(sdcp, r1);
+    put_data(sdcp, cmd == 9 ? sdcp->csd : cid, 16);
+    return;
+  case 12:
+    sdcp->state = SIMSDC_CMD;
+    put(sdcp, r1);
+    return;
+  case 13:
+    put(sdcp, r1);
+    put(sdcp, 0x00);
+    return;
+  case 16:
+    put(sdcp, arg == SIMSDC_BLOCK_SIZE ? r1 : r1 | R1_PARAMETER_ERROR);
+    return;
+  case 17:
+  case 18:
+    if (arg >= sdcp->capacity) {
+      put(sdcp, r1 | R1_ADDRESS_ERROR);
+      return;
+    }
+    put(sdcp, r1);
+    sdcp->block = arg;
+    sdcp->multiple = cmd == 18;
+    sdcp->state = sdcp->multiple ? SIMSDC_READING : SIMSDC_CMD;
+    put_block(sdcp);
+    return;
+  case 24:
+  case 25:
+    if (arg >= sdcp->capacity) {
+      put(sdcp, r1 | R1_ADDRESS_ERROR);
+      return;
+    }
+    put(sdcp, r1);
+    sdcp->block = arg;
+    sdcp->multiple = cmd == 25;
+    sdcp->state = SIMSDC_WAIT_TOKEN;
+    return;
+  case 32:
+  case 33:
+    if (arg >= sdcp->capacity) {
+      put(sdcp, r1 | R1_ADDRESS_ERROR);
+      return;
+    }
+    if (cmd == 32)
+      sdcp->erase_start = arg;
+    else
+      sdcp->erase_end = arg;
+    put(sdcp, r1);
+    return;
+  case 38:
+    memset(sdcp->data, 0, SIMSDC_BLOCK_SIZE);
+    for (i = sdcp->erase_start; i <= sdcp->erase_end; i++)
+      write_block(sdcp, i, sdcp->data);
+    put(sdcp, r1);
+    sdcp->busy = SIMSDC_WRITE_BUSY;
+    return;
+  case 55:
+    sdcp->app_cmd = TRUE;
+    put(sdcp, r1);
+    return;
+  case 58:
+    put(sdcp, r1);
+    put(sdcp, sdcp->idle ? 0x00 : 0xC0);
+    put(sdcp, 0xFF);
+    put(sdcp, 0x80);
+    put(sdcp, 0x00);
+    return;
+  case 59:
+    sdcp->crc_enabled = (arg & 1) != 0;
+    put(sdcp, r1);
+    return;
+  default:
+    break;
+  }
+illegal:
+  put(sdcp, r1 | R1_ILLEGAL_COMMAND);
+}
+
+static void simsdc_select(void *instance) {
+  SimSDCard *sdcp = (SimSDCard *)instance;
+
+  sdcp->selected = TRUE;
+}
+
+static void simsdc_unselect(void *instance) {
+  SimSDCard *sdcp = (SimSDCard *)instance;
+
+  /* Transfers are aborted, a pending busy period is preserved.*/
+  sdcp->selected = FALSE;
+  sdcp->state = SIMSDC_CMD;
+  sdcp->cmd_n = 0;
+  sdcp->obuf_n = 0;
+  sdcp->obuf_i = 0;
+}
+
+static uint8_t simsdc_exchange(void *instance, uint8_t frame) {
+  SimSDCard *sdcp = (SimSDCard *)instance;
+  uint8_t out;
+
+  if (!sdcp->selected || (sdcp->file == NULL))
+    return 0xFF;
+
+  /* Output frame.*/
+  if ((sdcp->obuf_i >= sdcp->obuf_n) && (sdcp->state == SIMSDC_READING)) {
+    sdcp->obuf_n = 0;
+    sdcp->obuf_i = 0;
+    put_block(sdcp);
+  }
+  if (sdcp->obuf_i < sdcp->obuf_n)
+    out = sdcp->obuf[sdcp->obuf_i++];
+  else if (sdcp->busy > 0) {
+    sdcp->busy--;
+    out = 0x00;
+  }
+  else
+    out = 0xFF;
+  if (sdcp->obuf_i >= sdcp->obuf_n)
+    sdcp->obuf_n = sdcp->obuf_i = 0;
+
+  /* Input frame.*/
+  switch (sdcp->state) {
+  case SIMSDC_RECEIVING:
+    sdcp->data[sdcp->data_n++] = frame;
+    if (sdcp->data_n >= sizeof(sdcp->data))
+      data_received(sdcp);
+    return out;
+  case SIMSDC_WAIT_TOKEN:
+    if (sdcp->busy > 0)
+      return out;
+    if (frame == (sdcp->multiple ? TOKEN_START_MULTIPLE : TOKEN_START_BLOCK)) {
+      sdcp->state = SIMSDC_RECEIVING;
+      sdcp->data_n = 0;
+      return out;
+    }
+    if (sdcp->multiple && (frame == TOKEN_STOP_TRAN)) {
+      sdcp->state = SIMSDC_CMD;
+      sdcp->busy = SIMSDC_WRITE_BUSY;
+      return out;
+    }
+    break;
+  default:
+    break;
+  }
+
+  /* Command bytes.*/
+  if (sdcp->cmd_n == 0) {
+    if ((frame & 0xC0) != 0x40)
+      return out;
+  }
+  sdcp->cmd[sdcp->cmd_n++] = frame;
+  if (sdcp->cmd_n >= sizeof(sdcp->cmd)) {
+    sdcp->cmd_n = 0;
+    command(sdcp);
+  }
+  return out;
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a simulated SD card object.
+ *
+ * @param[out] sdcp     pointer to the @p SimSDCard object
+ *
+ * @init
+ */
+void simsdcObjectInit(SimSDCard *sdcp) {
+
+  sdcp->vmt = &vmt;
+  sdcp->file = NULL;
+  sdcp->capacity = 0;
+  sdcp->selected = FALSE;
+  sdcp->blocks_read = 0;
+  sdcp->blocks_written = 0;
+  sdcp->crc_errors = 0;
+  reset(sdcp);
+}
+
+/**
+ * @brief   Inserts the card using an image file as content.
+ * @details The image must exist and be at least 512kB large.
+ *
+ * @param[in] sdcp      pointer to the @p SimSDCard object
+ * @param[in] path      path of the image file
+ * @return              The operation status.
+ * @retval CH_SUCCESS   if the operation succeeded.
+ * @retval CH_FAILED    if the image cannot be opened or it is too small.
+ *
+ * @api
+ */
+bool_t simsdcOpen(SimSDCard *sdcp, const char *path) {
+  long size;
+  uint32_t c_size;
+
+  chDbgCheck((sdcp != NULL) && (path != NULL), "simsdcOpen");
+
+  if ((sdcp->file = fopen(path, "r+b")) == NULL)
+    return CH_FAILED;
+  if ((fseek(sdcp->file, 0, SEEK_END) != 0) ||
+      ((size = ftell(sdcp->file)) < 1024L * SIMSDC_BLOCK_SIZE)) {
+    simsdcClose(sdcp);
+    return CH_FAILED;
+  }
+
+  /* CSD version 2.0, the capacity is (C_SIZE + 1) * 512kB.*/
+  c_size = (uint32_t)(size / (1024L * SIMSDC_BLOCK_SIZE)) - 1;
+  sdcp->capacity = (c_size + 1) * 1024;
+  memset(sdcp->csd, 0, sizeof(sdcp->csd));
+  sdcp->csd[0]  = 0x40;                     /* CSD_STRUCTURE.               */
+  sdcp->csd[1]  = 0x0E;                     /* TAAC.                        */
+  sdcp->csd[3]  = 0x32;                     /* TRAN_SPEED, 25MHz.           */
+  sdcp->csd[4]  = 0x5B;                     /* CCC.                         */
+  sdcp->csd[5]  = 0x59;                     /* CCC, READ_BL_LEN.            */
+  sdcp->csd[7]  = (uint8_t)((c_size >> 16) & 0x3F);
+  sdcp->csd[8]  = (uint8_t)(c_size >> 8);
+  sdcp->csd[9]  = (uint8_t)c_size;
+  sdcp->csd[10] = 0x7F;                     /* ERASE_BLK_EN, SECTOR_SIZE.   */
+  sdcp->csd[11] = 0x80;                     /* WP_GRP_SIZE.                 */
+  sdcp->csd[12] = 0x0A;                     /* R2W_FACTOR, WRITE_BL_LEN.    */
+  sdcp->csd[13] = 0x40;                     /* WRITE_BL_LEN.                */
+  sdcp->csd[15] = (uint8_t)((crc7(sdcp->csd, 15) << 1) | 1);
+  reset(sdcp);
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Removes the card.
+ *
+ * @param[in] sdcp      pointer to the @p SimSDCard object
+ *
+ * @api
+ */
+void simsdcClose(SimSDCard *sdcp) {
+
+  chDbgCheck(sdcp != NULL, "simsdcClose");
+
+  if (sdcp->file != NULL) {
+    fclose(sdcp->file);
+    sdcp->file = NULL;
+  }
+  sdcp->capacity = 0;
+}
+
+#endif /* HAL_USE_SPI */
+
+/** @} */
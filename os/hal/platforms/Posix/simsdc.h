@@ -0,0 +1,191 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/simsdc.h
+ * @brief   Simulated SD card in SPI mode header.
+ *
+ * @addtogroup POSIX_SIMSDC
+ * @{
+ */
+
+#ifndef _SIMSDC_H_
+#define _SIMSDC_H_
+
+#include <stdio.h>
+
+#if HAL_USE_SPI || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Block size of the emulated card.
+ */
+#define SIMSDC_BLOCK_SIZE           512
+
+/**
+ * @brief   Size of the output buffer, it must be able to contain a whole
+ *          data block with its prologue and CRC.
+ */
+#define SIMSDC_OBUF_SIZE            (SIMSDC_BLOCK_SIZE + 16 +               \
+                                     SIMSDC_READ_LATENCY)
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of idle frames before a data token.
+ */
+#if !defined(SIMSDC_READ_LATENCY) || defined(__DOXYGEN__)
+#define SIMSDC_READ_LATENCY         2
+#endif
+
+/**
+ * @brief   Number of busy frames after a block write or an erase.
+ */
+#if !defined(SIMSDC_WRITE_BUSY) || defined(__DOXYGEN__)
+#define SIMSDC_WRITE_BUSY           8
+#endif
+
+/**
+ * @brief   Number of initialization polls before the card becomes ready.
+ */
+#if !defined(SIMSDC_INIT_POLLS) || defined(__DOXYGEN__)
+#define SIMSDC_INIT_POLLS           2
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Card protocol states.
+ */
+typedef enum {
+  SIMSDC_CMD = 0,                   /**< Waiting for a command.             */
+  SIMSDC_READING = 1,               /**< Multiple blocks read.              */
+  SIMSDC_WAIT_TOKEN = 2,            /**< Waiting for a data token.          */
+  SIMSDC_RECEIVING = 3              /**< Receiving a data block.            */
+} simsdcstate_t;
+
+/**
+ * @brief   @p SimSDCard specific methods.
+ */
+#define _simsdc_methods                                                     \
+  _spi_slave_model_methods
+
+/**
+ * @extends SPISlaveModelVMT
+ *
+ * @brief   @p SimSDCard virtual methods table.
+ */
+struct SimSDCardVMT {
+  _simsdc_methods
+};
+
+/**
+ * @extends SPISlaveModel
+ *
+ * @brief   Simulated SDHC card in SPI mode.
+ * @details The card content is a host image file, the capacity is the
+ *          image size rounded down to a multiple of 512kB. The model
+ *          emulates the commands used by the MMC over SPI driver, the data
+ *          tokens, the CRCs, the read latency and the busy periods.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct SimSDCardVMT *vmt;
+  _spi_slave_model_data
+  /** @brief Image file or @p NULL.*/
+  FILE                      *file;
+  /** @brief Capacity in blocks.*/
+  uint32_t                  capacity;
+  /** @brief Slave select status.*/
+  bool_t                    selected;
+  /** @brief Card in idle state, not initialized.*/
+  bool_t                    idle;
+  /** @brief Next command is an application specific command.*/
+  bool_t                    app_cmd;
+  /** @brief CRC checks enabled using CMD59.*/
+  bool_t                    crc_enabled;
+  /** @brief Initialization polls still required.*/
+  unsigned                  init_polls;
+  /** @brief Protocol state.*/
+  simsdcstate_t             state;
+  /** @brief Multiple blocks transfer in progress.*/
+  bool_t                    multiple;
+  /** @brief Current block.*/
+  uint32_t                  block;
+  /** @brief First block to be erased.*/
+  uint32_t                  erase_start;
+  /** @brief Last block to be erased.*/
+  uint32_t                  erase_end;
+  /** @brief Remaining busy frames.*/
+  unsigned                  busy;
+  /** @brief Command being received.*/
+  uint8_t                   cmd[6];
+  /** @brief Number of received command bytes.*/
+  unsigned                  cmd_n;
+  /** @brief Data block being received, including its CRC.*/
+  uint8_t                   data[SIMSDC_BLOCK_SIZE + 2];
+  /** @brief Number of received data bytes.*/
+  size_t                    data_n;
+  /** @brief Output buffer.*/
+  uint8_t                   obuf[SIMSDC_OBUF_SIZE];
+  /** @brief Number of frames in the output buffer.*/
+  size_t                    obuf_n;
+  /** @brief Next frame to be output.*/
+  size_t                    obuf_i;
+  /** @brief CSD register.*/
+  uint8_t                   csd[16];
+  /** @brief Number of blocks read.*/
+  uint32_t                  blocks_read;
+  /** @brief Number of blocks written.*/
+  uint32_t                  blocks_written;
+  /** @brief Number of commands or data blocks with a CRC error.*/
+  uint32_t                  crc_errors;
+} SimSDCard;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void simsdcObjectInit(SimSDCard *sdcp);
+  bool_t simsdcOpen(SimSDCard *sdcp, const char *path);
+  void simsdcClose(SimSDCard *sdcp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_SPI */
+
+#endif /* _SIMSDC_H_ */
+
+/** @} */
@@ -0,0 +1,306 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/spi_lld.c
+ * @brief   Posix low level simulated SPI driver code.
+ * @details The transfers are started by the driver and completed from the
+ *          simulated interrupt sources polling, the frames are exchanged
+ *          with the slave model pointed by the current configuration.
+ *
+ * @addtogroup POSIX_SPI
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_SPI || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief SPI1 driver identifier.*/
+#if USE_SIM_SPI1 || defined(__DOXYGEN__)
+SPIDriver SPID1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Exchanges a frame with the slave model, if any.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] frame     the frame on the MOSI line
+ * @return              The frame on the MISO line.
+ *
+ * @notapi
+ */
+static uint8_t exchange_frame(SPIDriver *spip, uint8_t frame) {
+  SPISlaveModel *smp = spip->config->slave;
+
+  if (smp == NULL)
+    return SPI_SIM_IDLE_FRAME;
+  return smp->vmt->exchange(smp, frame);
+}
+
+/**
+ * @brief   Starts a transfer.
+ * @details The transfer is only recorded here, it is performed when the
+ *          simulated interrupt sources are polled.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of frames
+ * @param[in] txbuf     the pointer to the transmit buffer or @p NULL
+ * @param[out] rxbuf    the pointer to the receive buffer or @p NULL
+ *
+ * @notapi
+ */
+static void start_transfer(SPIDriver *spip, size_t n,
+                           const void *txbuf, void *rxbuf) {
+
+  spip->count = n;
+  spip->txptr = (const uint8_t *)txbuf;
+  spip->rxptr = (uint8_t *)rxbuf;
+}
+
+/**
+ * @brief   Performs the pending transfer, if any.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @return              The interrupt status.
+ * @retval FALSE        if there was not a pending transfer.
+ * @retval TRUE         if a transfer has been completed.
+ *
+ * @notapi
+ */
+static bool_t serve_interrupt(SPIDriver *spip) {
+  size_t n;
+
+  if ((spip->state != SPI_ACTIVE) || (spip->count == 0))
+    return FALSE;
+
+  /* All the frames are exchanged at once, it is like a DMA transfer.*/
+  for (n = 0; n < spip->count; n++) {
+    uint8_t b = exchange_frame(spip, spip->txptr != NULL ? spip->txptr[n]
+                                                         : 0xFF);
+    if (spip->rxptr != NULL)
+      spip->rxptr[n] = b;
+  }
+  spip->count = 0;
+
+  /* Portable SPI ISR code defined in the high level driver, note, it is
+     a macro.*/
+  _spi_isr_code(spip);
+  return TRUE;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level SPI driver initialization.
+ *
+ * @notapi
+ */
+void spi_lld_init(void) {
+
+#if USE_SIM_SPI1
+  spiObjectInit(&SPID1);
+  SPID1.count = 0;
+#endif /* USE_SIM_SPI1 */
+}
+
+/**
+ * @brief   Configures and activates the SPI peripheral.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_start(SPIDriver *spip) {
+
+  spip->count = 0;
+}
+
+/**
+ * @brief   Deactivates the SPI peripheral.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_stop(SPIDriver *spip) {
+
+  spip->count = 0;
+}
+
+/**
+ * @brief   Asserts the slave select signal and prepares for transfers.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_select(SPIDriver *spip) {
+  SPISlaveModel *smp = spip->config->slave;
+
+  if (smp != NULL)
+    smp->vmt->select(smp);
+}
+
+/**
+ * @brief   Deasserts the slave select signal.
+ * @details The previously selected peripheral is unselected.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+void spi_lld_unselect(SPIDriver *spip) {
+  SPISlaveModel *smp = spip->config->slave;
+
+  if (smp != NULL)
+    smp->vmt->unselect(smp);
+}
+
+/**
+ * @brief   Ignores data on the SPI bus.
+ * @details This asynchronous function starts the transmission of a series of
+ *          idle words on the SPI bus and ignores the received data.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to be ignored
+ *
+ * @notapi
+ */
+void spi_lld_ignore(SPIDriver *spip, size_t n) {
+
+  start_transfer(spip, n, NULL, NULL);
+}
+
+/**
+ * @brief   Exchanges data on the SPI bus.
+ * @details This asynchronous function starts a simultaneous transmit/receive
+ *          operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to be exchanged
+ * @param[in] txbuf     the pointer to the transmit buffer
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void spi_lld_exchange(SPIDriver *spip, size_t n,
+                      const void *txbuf, void *rxbuf) {
+
+  start_transfer(spip, n, txbuf, rxbuf);
+}
+
+/**
+ * @brief   Sends data over the SPI bus.
+ * @details This asynchronous function starts a transmit operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @notapi
+ */
+void spi_lld_send(SPIDriver *spip, size_t n, const void *txbuf) {
+
+  start_transfer(spip, n, txbuf, NULL);
+}
+
+/**
+ * @brief   Receives data from the SPI bus.
+ * @details This asynchronous function starts a receive operation.
+ * @post    At the end of the operation the configured callback is invoked.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] n         number of words to receive
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void spi_lld_receive(SPIDriver *spip, size_t n, void *rxbuf) {
+
+  start_transfer(spip, n, NULL, rxbuf);
+}
+
+/**
+ * @brief   Exchanges one frame using a polled wait.
+ * @details This synchronous function exchanges one frame using a polled
+ *          synchronization method. This function is useful when exchanging
+ *          small amount of data on high speed channels, usually in this
+ *          situation is much more efficient just wait for completion using
+ *          polling than suspending the thread waiting for an interrupt.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] frame     the data frame to send over the SPI bus
+ * @return              The received data frame from the SPI bus.
+ */
+uint16_t spi_lld_polled_exchange(SPIDriver *spip, uint16_t frame) {
+
+  return exchange_frame(spip, (uint8_t)frame);
+}
+
+/**
+ * @brief   Simulated SPI interrupt sources.
+ * @details Completes the pending transfers and invokes the driver ISR code.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no interrupt has been served.
+ * @retval TRUE         if at least an interrupt has been served.
+ *
+ * @notapi
+ */
+bool_t spi_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_SPI1
+  b = serve_interrupt(&SPID1);
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_SPI */
+
+/** @} */
@@ -0,0 +1,211 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/spi_lld.h
+ * @brief   Posix low level simulated SPI driver header.
+ *
+ * @addtogroup POSIX_SPI
+ * @{
+ */
+
+#ifndef _SPI_LLD_H_
+#define _SPI_LLD_H_
+
+#if HAL_USE_SPI || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Frame received when no slave model is driving the MISO line.
+ */
+#define SPI_SIM_IDLE_FRAME          0xFF
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   SPID1 driver enable switch.
+ * @details If set to @p TRUE the support for SPID1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_SPI1) || defined(__DOXYGEN__)
+#define USE_SIM_SPI1                TRUE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   @p SPISlaveModel specific methods.
+ * @note    The methods are invoked from the simulated interrupt context.
+ */
+#define _spi_slave_model_methods                                            \
+  /* Slave select line asserted.*/                                          \
+  void (*select)(void *instance);                                           \
+  /* Slave select line deasserted.*/                                        \
+  void (*unselect)(void *instance);                                         \
+  /* Exchanges one frame, the returned value is the frame on MISO.*/        \
+  uint8_t (*exchange)(void *instance, uint8_t frame);
+
+/**
+ * @brief   @p SPISlaveModel specific data.
+ * @note    It is empty because @p SPISlaveModel is only an interface
+ *          without implementation.
+ */
+#define _spi_slave_model_data
+
+/**
+ * @brief   @p SPISlaveModel virtual methods table.
+ */
+struct SPISlaveModelVMT {
+  _spi_slave_model_methods
+};
+
+/**
+ * @brief   Simulated SPI slave device.
+ * @details This class represents a device attached to a simulated SPI bus,
+ *          the model sees the slave select transitions and each exchanged
+ *          frame.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct SPISlaveModelVMT *vmt;
+  _spi_slave_model_data
+} SPISlaveModel;
+
+/**
+ * @brief   Type of a structure representing an SPI driver.
+ */
+typedef struct SPIDriver SPIDriver;
+
+/**
+ * @brief   SPI notification callback type.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object triggering the
+ *                      callback
+ */
+typedef void (*spicallback_t)(SPIDriver *spip);
+
+/**
+ * @brief   Driver configuration structure.
+ * @note    The simulated bus only supports 8 bits frames.
+ */
+typedef struct {
+  /**
+   * @brief Operation complete callback.
+   */
+  spicallback_t         end_cb;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Slave model selected by this configuration, it takes the
+   *        place of the chip select line of the real drivers.
+   * @note  Can be @p NULL, in this case the received frames have value
+   *        @p SPI_SIM_IDLE_FRAME.
+   */
+  SPISlaveModel         *slave;
+} SPIConfig;
+
+/**
+ * @brief   Structure representing an SPI driver.
+ */
+struct SPIDriver {
+  /**
+   * @brief Driver state.
+   */
+  spistate_t            state;
+  /**
+   * @brief Current configuration data.
+   */
+  const SPIConfig       *config;
+#if SPI_USE_WAIT || defined(__DOXYGEN__)
+  /**
+   * @brief Waiting thread.
+   */
+  Thread                *thread;
+#endif /* SPI_USE_WAIT */
+#if SPI_USE_MUTUAL_EXCLUSION || defined(__DOXYGEN__)
+#if CH_USE_MUTEXES || defined(__DOXYGEN__)
+  /**
+   * @brief Mutex protecting the bus.
+   */
+  Mutex                 mutex;
+#elif CH_USE_SEMAPHORES
+  Semaphore             semaphore;
+#endif
+#endif /* SPI_USE_MUTUAL_EXCLUSION */
+#if defined(SPI_DRIVER_EXT_FIELDS)
+  SPI_DRIVER_EXT_FIELDS
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Number of frames of the pending transfer.
+   */
+  size_t                count;
+  /**
+   * @brief Pointer to the transmit buffer or @p NULL.
+   */
+  const uint8_t         *txptr;
+  /**
+   * @brief Pointer to the receive buffer or @p NULL.
+   */
+  uint8_t               *rxptr;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_SPI1 && !defined(__DOXYGEN__)
+extern SPIDriver SPID1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void spi_lld_init(void);
+  void spi_lld_start(SPIDriver *spip);
+  void spi_lld_stop(SPIDriver *spip);
+  void spi_lld_select(SPIDriver *spip);
+  void spi_lld_unselect(SPIDriver *spip);
+  void spi_lld_ignore(SPIDriver *spip, size_t n);
+  void spi_lld_exchange(SPIDriver *spip, size_t n,
+                        const void *txbuf, void *rxbuf);
+  void spi_lld_send(SPIDriver *spip, size_t n, const void *txbuf);
+  void spi_lld_receive(SPIDriver *spip, size_t n, void *rxbuf);
+  uint16_t spi_lld_polled_exchange(SPIDriver *spip, uint16_t frame);
+  bool_t spi_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_SPI */
+
+#endif /* _SPI_LLD_H_ */
+
+/** @} */
@@ -0,0 +1,477 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/uart_lld.c
+ * @brief   Posix low level simulated UART driver code.
+ * @details The line is simulated by a TCP socket, the transfers behave
+ *          like DMA operations: a whole transmit buffer is sent at once
+ *          and the receive buffer is filled with the data available on
+ *          the socket, the callbacks are invoked when a buffer is complete.
+ *
+ * @addtogroup POSIX_UART
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_UART || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief UART1 driver identifier.*/
+#if USE_SIM_UART1 || defined(__DOXYGEN__)
+UARTDriver UARTD1;
+#endif
+
+/** @brief UART2 driver identifier.*/
+#if USE_SIM_UART2 || defined(__DOXYGEN__)
+UARTDriver UARTD2;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static u_long nb = 1;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Opens the listen socket of the simulated line.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @notapi
+ */
+static void init(UARTDriver *uartp) {
+  struct sockaddr_in sad;
+  struct protoent *prtp;
+  int sockval = 1;
+  socklen_t socklen = sizeof(sockval);
+
+  if ((prtp = getprotobyname("tcp")) == NULL) {
+    printf("%s: Error mapping protocol name to protocol number\n",
+           uartp->com_name);
+    goto abort;
+  }
+
+  uartp->com_listen = socket(PF_INET, SOCK_STREAM, prtp->p_proto);
+  if (uartp->com_listen == INVALID_SOCKET) {
+    printf("%s: Error creating simulator socket\n", uartp->com_name);
+    goto abort;
+  }
+
+  setsockopt(uartp->com_listen, SOL_SOCKET, SO_REUSEADDR, &sockval, socklen);
+
+  if (ioctl(uartp->com_listen, FIONBIO, &nb) != 0) {
+    printf("%s: Unable to setup non blocking mode on socket\n",
+           uartp->com_name);
+    goto abort;
+  }
+
+  memset(&sad, 0, sizeof(sad));
+  sad.sin_family = AF_INET;
+  sad.sin_addr.s_addr = INADDR_ANY;
+  sad.sin_port = htons(uartp->com_port);
+  if (bind(uartp->com_listen, (struct sockaddr *)&sad, sizeof(sad))) {
+    printf("%s: Error binding socket\n", uartp->com_name);
+    goto abort;
+  }
+
+  if (listen(uartp->com_listen, 1) != 0) {
+    printf("%s: Error listening socket\n", uartp->com_name);
+    goto abort;
+  }
+  printf("UART line %s listening on port %d\n", uartp->com_name,
+         uartp->com_port);
+  return;
+
+abort:
+  if (uartp->com_listen != INVALID_SOCKET)
+    close(uartp->com_listen);
+  exit(1);
+}
+
+/**
+ * @brief   Closes the data socket.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @notapi
+ */
+static void disconnect(UARTDriver *uartp) {
+
+  close(uartp->com_data);
+  uartp->com_data = INVALID_SOCKET;
+}
+
+/**
+ * @brief   Accepts a connection on the simulated line.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t connint(UARTDriver *uartp) {
+  struct sockaddr addr;
+  socklen_t addrlen = sizeof(addr);
+
+  if ((uartp->com_listen == INVALID_SOCKET) ||
+      (uartp->com_data != INVALID_SOCKET))
+    return FALSE;
+
+  if ((uartp->com_data = accept(uartp->com_listen, &addr,
+                                &addrlen)) == INVALID_SOCKET)
+    return FALSE;
+
+  if (ioctl(uartp->com_data, FIONBIO, &nb) != 0) {
+    printf("%s: Unable to setup non blocking mode on data socket\n",
+           uartp->com_name);
+    exit(1);
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Receive side of the simulated line.
+ * @details While a receive operation is active the data goes into the
+ *          receive buffer, else a callback is invoked for each character.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t inint(UARTDriver *uartp) {
+  uint8_t data[32], *p;
+  ssize_t n;
+
+  if (uartp->com_data == INVALID_SOCKET)
+    return FALSE;
+
+  if (uartp->rxstate == UART_RX_ACTIVE) {
+    /* The data is received straight into the buffer.*/
+    n = recv(uartp->com_data, uartp->rxptr, uartp->rxcnt, 0);
+    p = NULL;
+  }
+  else {
+    n = recv(uartp->com_data, data, sizeof(data), 0);
+    p = data;
+  }
+  if (n == 0) {
+    disconnect(uartp);
+    return FALSE;
+  }
+  if (n < 0) {
+    if (errno != EWOULDBLOCK)
+      disconnect(uartp);
+    return FALSE;
+  }
+
+  if (p == NULL) {
+    uartp->rxptr += n;
+    uartp->rxcnt -= n;
+    if (uartp->rxcnt == 0) {
+      uartp->rxstate = UART_RX_COMPLETE;
+      if (uartp->config->rxend_cb != NULL)
+        uartp->config->rxend_cb(uartp);
+
+      /* If the callback didn't explicitly change state then the receiver
+         automatically returns to the idle state.*/
+      if (uartp->rxstate == UART_RX_COMPLETE)
+        uartp->rxstate = UART_RX_IDLE;
+    }
+    return TRUE;
+  }
+
+  /* Receiver idle, a callback for each character, a receive operation
+     could be started by the callback itself.*/
+  while (n > 0) {
+    if (uartp->rxstate == UART_RX_ACTIVE) {
+      size_t k = (size_t)n < uartp->rxcnt ? (size_t)n : uartp->rxcnt;
+
+      memcpy(uartp->rxptr, p, k);
+      uartp->rxptr += k;
+      uartp->rxcnt -= k;
+      p += k;
+      n -= k;
+      if (uartp->rxcnt == 0) {
+        uartp->rxstate = UART_RX_COMPLETE;
+        if (uartp->config->rxend_cb != NULL)
+          uartp->config->rxend_cb(uartp);
+        if (uartp->rxstate == UART_RX_COMPLETE)
+          uartp->rxstate = UART_RX_IDLE;
+      }
+    }
+    else {
+      if (uartp->config->rxchar_cb != NULL)
+        uartp->config->rxchar_cb(uartp, *p);
+      p++;
+      n--;
+    }
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Transmit side of the simulated line.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t outint(UARTDriver *uartp) {
+  ssize_t n;
+
+  if (uartp->txstate != UART_TX_ACTIVE)
+    return FALSE;
+
+  /* Without a connection the data is lost, like on a disconnected line.*/
+  if (uartp->com_data == INVALID_SOCKET)
+    n = uartp->txcnt;
+  else {
+    n = send(uartp->com_data, uartp->txptr, uartp->txcnt, 0);
+    if (n < 0) {
+      if (errno != EWOULDBLOCK)
+        disconnect(uartp);
+      return FALSE;
+    }
+  }
+  uartp->txptr += n;
+  uartp->txcnt -= n;
+  if (uartp->txcnt > 0)
+    return FALSE;
+
+  /* A callback is generated, if enabled, after a completed transfer.*/
+  uartp->txstate = UART_TX_COMPLETE;
+  if (uartp->config->txend1_cb != NULL)
+    uartp->config->txend1_cb(uartp);
+
+  /* If the callback didn't explicitly change state then the transmitter
+     automatically returns to the idle state.*/
+  if (uartp->txstate == UART_TX_COMPLETE) {
+    uartp->txstate = UART_TX_IDLE;
+
+    /* The data is already on the socket, the physical end of transmission
+       is notified immediately.*/
+    if (uartp->config->txend2_cb != NULL)
+      uartp->config->txend2_cb(uartp);
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Serves the simulated interrupt sources of a driver.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @return              The interrupt status.
+ *
+ * @notapi
+ */
+static bool_t serve_interrupt(UARTDriver *uartp) {
+  bool_t b;
+
+  if (uartp->state != UART_READY)
+    return FALSE;
+
+  b = connint(uartp);
+  b = inint(uartp) || b;
+  b = outint(uartp) || b;
+  return b;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level UART driver initialization.
+ *
+ * @notapi
+ */
+void uart_lld_init(void) {
+
+#if USE_SIM_UART1
+  uartObjectInit(&UARTD1);
+  UARTD1.com_listen = INVALID_SOCKET;
+  UARTD1.com_data = INVALID_SOCKET;
+  UARTD1.com_name = "UART1";
+  UARTD1.com_port = SIM_UART1_PORT;
+#endif
+
+#if USE_SIM_UART2
+  uartObjectInit(&UARTD2);
+  UARTD2.com_listen = INVALID_SOCKET;
+  UARTD2.com_data = INVALID_SOCKET;
+  UARTD2.com_name = "UART2";
+  UARTD2.com_port = SIM_UART2_PORT;
+#endif
+}
+
+/**
+ * @brief   Configures and activates the UART peripheral.
+ * @details The listen socket is opened on the first activation, an
+ *          established connection survives a driver stop.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @notapi
+ */
+void uart_lld_start(UARTDriver *uartp) {
+
+  if (uartp->com_listen == INVALID_SOCKET)
+    init(uartp);
+  uartp->txcnt = 0;
+  uartp->rxcnt = 0;
+}
+
+/**
+ * @brief   Deactivates the UART peripheral.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @notapi
+ */
+void uart_lld_stop(UARTDriver *uartp) {
+
+  uartp->txcnt = 0;
+  uartp->rxcnt = 0;
+}
+
+/**
+ * @brief   Starts a transmission on the UART peripheral.
+ * @note    The buffers are organized as uint8_t arrays.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @param[in] n         number of data frames to send
+ * @param[in] txbuf     the pointer to the transmit buffer
+ *
+ * @notapi
+ */
+void uart_lld_start_send(UARTDriver *uartp, size_t n, const void *txbuf) {
+
+  uartp->txptr = (const uint8_t *)txbuf;
+  uartp->txcnt = n;
+}
+
+/**
+ * @brief   Stops any ongoing transmission.
+ * @note    Stopping a transmission also suppresses the transmission
+ *          callbacks.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @return              The number of data frames not transmitted by the
+ *                      stopped transmit operation.
+ *
+ * @notapi
+ */
+size_t uart_lld_stop_send(UARTDriver *uartp) {
+  size_t n = uartp->txcnt;
+
+  uartp->txcnt = 0;
+  return n;
+}
+
+/**
+ * @brief   Starts a receive operation on the UART peripheral.
+ * @note    The buffers are organized as uint8_t arrays.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ * @param[in] n         number of data frames to send
+ * @param[out] rxbuf    the pointer to the receive buffer
+ *
+ * @notapi
+ */
+void uart_lld_start_receive(UARTDriver *uartp, size_t n, void *rxbuf) {
+
+  uartp->rxptr = (uint8_t *)rxbuf;
+  uartp->rxcnt = n;
+}
+
+/**
+ * @brief   Stops any ongoing receive operation.
+ * @note    Stopping a receive operation also suppresses the receive
+ *          callbacks.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ *
+ * @return              The number of data frames not received by the
+ *                      stopped receive operation.
+ *
+ * @notapi
+ */
+size_t uart_lld_stop_receive(UARTDriver *uartp) {
+  size_t n = uartp->rxcnt;
+
+  uartp->rxcnt = 0;
+  return n;
+}
+
+/**
+ * @brief   Simulated UART interrupt sources.
+ * @details Moves the data between the sockets and the active buffers and
+ *          invokes the driver callbacks.
+ *
+ * @return              The interrupt status.
+ * @retval FALSE        if no interrupt has been served.
+ * @retval TRUE         if at least an interrupt has been served.
+ *
+ * @notapi
+ */
+bool_t uart_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_UART1
+  b = serve_interrupt(&UARTD1) || b;
+#endif
+#if USE_SIM_UART2
+  b = serve_interrupt(&UARTD2) || b;
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+#endif /* HAL_USE_UART */
+
+/** @} */
@@ -0,0 +1,233 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/uart_lld.h
+ * @brief   Posix low level simulated UART driver header.
+ *
+ * @addtogroup POSIX_UART
+ * @{
+ */
+
+#ifndef _UART_LLD_H_
+#define _UART_LLD_H_
+
+#if HAL_USE_UART || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   UARTD1 driver enable switch.
+ * @details If set to @p TRUE the support for UARTD1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_UART1) || defined(__DOXYGEN__)
+#define USE_SIM_UART1               TRUE
+#endif
+
+/**
+ * @brief   UARTD2 driver enable switch.
+ * @details If set to @p TRUE the support for UARTD2 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_UART2) || defined(__DOXYGEN__)
+#define USE_SIM_UART2               TRUE
+#endif
+
+/**
+ * @brief   Listen port for UARTD1.
+ */
+#if !defined(SIM_UART1_PORT) || defined(__DOXYGEN__)
+#define SIM_UART1_PORT              29011
+#endif
+
+/**
+ * @brief   Listen port for UARTD2.
+ */
+#if !defined(SIM_UART2_PORT) || defined(__DOXYGEN__)
+#define SIM_UART2_PORT              29012
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   UART driver condition flags type.
+ */
+typedef uint32_t uartflags_t;
+
+/**
+ * @brief   Type of structure representing an UART driver.
+ */
+typedef struct UARTDriver UARTDriver;
+
+/**
+ * @brief   Generic UART notification callback type.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object
+ */
+typedef void (*uartcb_t)(UARTDriver *uartp);
+
+/**
+ * @brief   Character received UART notification callback type.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object triggering the
+ *                      callback
+ * @param[in] c         received character
+ */
+typedef void (*uartccb_t)(UARTDriver *uartp, uint16_t c);
+
+/**
+ * @brief   Receive error UART notification callback type.
+ *
+ * @param[in] uartp     pointer to the @p UARTDriver object triggering the
+ *                      callback
+ * @param[in] e         receive error mask
+ */
+typedef void (*uartecb_t)(UARTDriver *uartp, uartflags_t e);
+
+/**
+ * @brief   Driver configuration structure.
+ * @note    It could be empty on some architectures.
+ */
+typedef struct {
+  /**
+   * @brief End of transmission buffer callback.
+   */
+  uartcb_t                  txend1_cb;
+  /**
+   * @brief Physical end of transmission callback.
+   */
+  uartcb_t                  txend2_cb;
+  /**
+   * @brief Receive buffer filled callback.
+   */
+  uartcb_t                  rxend_cb;
+  /**
+   * @brief Character received while out if the @p UART_RECEIVE state.
+   */
+  uartccb_t                 rxchar_cb;
+  /**
+   * @brief Receive error callback.
+   */
+  uartecb_t                 rxerr_cb;
+  /* End of the mandatory fields.*/
+} UARTConfig;
+
+/**
+ * @brief   Structure representing an UART driver.
+ */
+struct UARTDriver {
+  /**
+   * @brief Driver state.
+   */
+  uartstate_t               state;
+  /**
+   * @brief Transmitter state.
+   */
+  uarttxstate_t             txstate;
+  /**
+   * @brief Receiver state.
+   */
+  uartrxstate_t             rxstate;
+  /**
+   * @brief Current configuration data.
+   */
+  const UARTConfig          *config;
+#if defined(UART_DRIVER_EXT_FIELDS)
+  UART_DRIVER_EXT_FIELDS
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief Listen socket for the simulated line.
+   */
+  SOCKET                    com_listen;
+  /**
+   * @brief Data socket for the simulated line.
+   */
+  SOCKET                    com_data;
+  /**
+   * @brief Port readable name.
+   */
+  const char                *com_name;
+  /**
+   * @brief Listen port.
+   */
+  uint16_t                  com_port;
+  /**
+   * @brief Pointer to the data still to be transmitted.
+   */
+  const uint8_t             *txptr;
+  /**
+   * @brief Number of bytes still to be transmitted.
+   */
+  size_t                    txcnt;
+  /**
+   * @brief Pointer to the receive position.
+   */
+  uint8_t                   *rxptr;
+  /**
+   * @brief Number of bytes still to be received.
+   */
+  size_t                    rxcnt;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_UART1 && !defined(__DOXYGEN__)
+extern UARTDriver UARTD1;
+#endif
+#if USE_SIM_UART2 && !defined(__DOXYGEN__)
+extern UARTDriver UARTD2;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void uart_lld_init(void);
+  void uart_lld_start(UARTDriver *uartp);
+  void uart_lld_stop(UARTDriver *uartp);
+  void uart_lld_start_send(UARTDriver *uartp, size_t n, const void *txbuf);
+  size_t uart_lld_stop_send(UARTDriver *uartp);
+  void uart_lld_start_receive(UARTDriver *uartp, size_t n, void *rxbuf);
+  size_t uart_lld_stop_receive(UARTDriver *uartp);
+  bool_t uart_lld_interrupt_pending(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_UART */
+
+#endif /* _UART_LLD_H_ */
+
+/** @} */
@@ -0,0 +1,1026 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/usb_lld.c
+ * @brief   Posix low level simulated USB driver code.
+ * @details The device controller is connected to an in-process host, test
+ *          code running in threads acts as the host and issues control,
+ *          IN and OUT transfers using the @p usbSimHost functions. The
+ *          transfers are executed by the simulated interrupt sources
+ *          polling one (micro)frame at time, each frame carries a limited
+ *          number of transactions and the device NAKs the transactions
+ *          on endpoints without an active transfer. Frames moving data
+ *          follow each other immediately so the bus time measured in
+ *          frames only depends on the driver and the application, a frame
+ *          where all the transactions have been NAKed paces the bus on the
+ *          host clock.
+ * @note    The bus bandwidth is shared among all the endpoints, periodic
+ *          transfers scheduling and data toggles are not simulated.
+ *
+ * @addtogroup POSIX_USB
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_USB || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/* Transaction handshakes.*/
+#define PID_ACK             0
+#define PID_NAK             1
+#define PID_STALL           2
+#define PID_BABBLE          3
+
+/* Control transfer stages.*/
+#define STAGE_SETUP         0
+#define STAGE_DATA_IN       1
+#define STAGE_DATA_OUT      2
+#define STAGE_STATUS_IN     3
+#define STAGE_STATUS_OUT    4
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief USB1 driver identifier.*/
+#if USE_SIM_USB1 || defined(__DOXYGEN__)
+USBDriver USBD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   EP0 state.
+ * @note    It is an union because IN and OUT endpoints are never used at the
+ *          same time for EP0.
+ */
+static union {
+  /**
+   * @brief   IN EP0 state.
+   */
+  USBInEndpointState in;
+  /**
+   * @brief   OUT EP0 state.
+   */
+  USBOutEndpointState out;
+} ep0_state;
+
+/**
+ * @brief   Buffer for the EP0 setup packets.
+ */
+static uint8_t ep0setup_buffer[8];
+
+/**
+ * @brief   EP0 initialization structure.
+ */
+static const USBEndpointConfig ep0config = {
+  USB_EP_MODE_TYPE_CTRL,
+  _usb_ep0setup,
+  _usb_ep0in,
+  _usb_ep0out,
+  0x40,
+  0x40,
+  &ep0_state.in,
+  &ep0_state.out,
+  1,
+  ep0setup_buffer
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Completes a host transfer.
+ * @details The waiting host thread is resumed.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] xp        pointer to the @p USBSimTransfer object
+ * @param[in] msg       transfer result
+ *
+ * @notapi
+ */
+static void complete_transfer(USBDriver *usbp, USBSimTransfer *xp,
+                              msg_t msg) {
+  Thread *tp = xp->thread;
+
+  xp->thread = NULL;
+  if (msg == RDY_OK)
+    usbp->stats.transfers++;
+  chSysLockFromIsr();
+  tp->p_u.rdymsg = msg;
+  chSchReadyI(tp);
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Fails all the pending transfers.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+static void abort_transfers(USBDriver *usbp) {
+  unsigned i;
+
+  if (usbp->host_ctrl.thread != NULL)
+    complete_transfer(usbp, &usbp->host_ctrl, RDY_RESET);
+  for (i = 0; i < USB_MAX_ENDPOINTS; i++) {
+    if (usbp->host_in[i].thread != NULL)
+      complete_transfer(usbp, &usbp->host_in[i], RDY_RESET);
+    if (usbp->host_out[i].thread != NULL)
+      complete_transfer(usbp, &usbp->host_out[i], RDY_RESET);
+  }
+}
+
+/**
+ * @brief   Verifies if there are pending host requests.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The pending status.
+ *
+ * @notapi
+ */
+static bool_t host_pending(USBDriver *usbp) {
+  unsigned i;
+
+  if ((usbp->host_reset.thread != NULL) || (usbp->host_ctrl.thread != NULL))
+    return TRUE;
+  for (i = 0; i < USB_MAX_ENDPOINTS; i++)
+    if ((usbp->host_in[i].thread != NULL) ||
+        (usbp->host_out[i].thread != NULL))
+      return TRUE;
+  return FALSE;
+}
+
+/**
+ * @brief   Executes an IN transaction.
+ * @details The device sends the next packet of the transfer prepared on
+ *          the endpoint, the IN callback is invoked after the last one.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[out] buf      host buffer
+ * @param[in] n         space in the host buffer
+ * @param[out] np       bytes copied into the host buffer
+ * @return              The transaction handshake, @p PID_BABBLE if the
+ *                      packet was acknowledged but it did not fit the
+ *                      host buffer.
+ *
+ * @notapi
+ */
+static unsigned in_transaction(USBDriver *usbp, usbep_t ep,
+                               uint8_t *buf, size_t n, size_t *np) {
+  const USBEndpointConfig *epcp = usbp->epc[ep];
+  USBInEndpointState *isp;
+  size_t size;
+
+  /* A missing endpoint does not answer, it is reported as a stall.*/
+  if ((epcp == NULL) || (epcp->in_cb == NULL) ||
+      (usbp->stalled_in & (1 << ep)))
+    return PID_STALL;
+  if ((usbp->transmitting & (1 << ep)) == 0) {
+    usbp->stats.naks++;
+    return PID_NAK;
+  }
+
+  isp = epcp->in_state;
+  size = isp->txsize - isp->txcnt;
+  if (size > epcp->in_maxsize)
+    size = epcp->in_maxsize;
+  /* Babble, the bytes exceeding the host buffer are lost.*/
+  if (n > size)
+    n = size;
+
+  if (isp->txqueued) {
+    OutputQueue *oqp = isp->mode.queue.txqueue;
+    size_t i;
+
+    chSysLockFromIsr();
+    chOQReadI(oqp, buf, n);
+    for (i = n; i < size; i++)
+      (void)chOQGetI(oqp);
+    chSysUnlockFromIsr();
+  }
+  else if (n > 0)
+    memcpy(buf, isp->mode.linear.txbuf + isp->txcnt, n);
+
+  isp->txcnt += size;
+  usbp->stats.packets++;
+  usbp->stats.bytes += size;
+  *np = n;
+
+  /* Transfer complete after the last packet.*/
+  if (isp->txcnt >= isp->txsize)
+    _usb_isr_invoke_in_cb(usbp, ep);
+  if (n < size) {
+    usbp->stats.babbles++;
+    return PID_BABBLE;
+  }
+  return PID_ACK;
+}
+
+/**
+ * @brief   Executes an OUT transaction.
+ * @details The device receives a packet into the transfer prepared on the
+ *          endpoint, the OUT callback is invoked after a short packet or
+ *          when the transfer is full.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] buf       packet data
+ * @param[in] n         packet size
+ * @return              The transaction handshake.
+ *
+ * @notapi
+ */
+static unsigned out_transaction(USBDriver *usbp, usbep_t ep,
+                                const uint8_t *buf, size_t n) {
+  const USBEndpointConfig *epcp = usbp->epc[ep];
+  USBOutEndpointState *osp;
+  size_t size;
+
+  if ((epcp == NULL) || (epcp->out_cb == NULL) ||
+      (usbp->stalled_out & (1 << ep)))
+    return PID_STALL;
+  if ((usbp->receiving & (1 << ep)) == 0) {
+    usbp->stats.naks++;
+    return PID_NAK;
+  }
+
+  osp = epcp->out_state;
+  /* Overflow, the bytes exceeding the transfer size are lost.*/
+  size = osp->rxsize - osp->rxcnt;
+  if (size > n)
+    size = n;
+
+  if (osp->rxqueued) {
+    chSysLockFromIsr();
+    chIQWriteI(osp->mode.queue.rxqueue, buf, size);
+    chSysUnlockFromIsr();
+  }
+  else if (size > 0)
+    memcpy(osp->mode.linear.rxbuf + osp->rxcnt, buf, size);
+
+  osp->rxcnt += size;
+  usbp->stats.packets++;
+  usbp->stats.bytes += n;
+
+  /* Transfer complete after a short packet or when full.*/
+  if ((n < epcp->out_maxsize) || (osp->rxcnt >= osp->rxsize))
+    _usb_isr_invoke_out_cb(usbp, ep);
+  return PID_ACK;
+}
+
+/**
+ * @brief   Executes the next transaction of the pending control transfer.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The transaction handshake.
+ *
+ * @notapi
+ */
+static unsigned control_transaction(USBDriver *usbp) {
+  USBSimTransfer *xp = &usbp->host_ctrl;
+  size_t n;
+  unsigned pid;
+
+  switch (usbp->host_stage) {
+  case STAGE_SETUP:
+    if (usbp->epc[0] == NULL) {
+      pid = PID_STALL;
+      break;
+    }
+    /* Setup packets are always acknowledged and clear the stall
+       condition, an ongoing transfer is cancelled.*/
+    usbp->stalled_in &= ~1;
+    usbp->stalled_out &= ~1;
+    usbp->transmitting &= ~1;
+    usbp->receiving &= ~1;
+    usbp->stats.packets++;
+    if (xp->size == 0)
+      usbp->host_stage = STAGE_STATUS_IN;
+    else if (usbp->host_setup[0] & USB_RTYPE_DIR_DEV2HOST)
+      usbp->host_stage = STAGE_DATA_IN;
+    else
+      usbp->host_stage = STAGE_DATA_OUT;
+    _usb_isr_invoke_setup_cb(usbp, 0);
+    return PID_ACK;
+  case STAGE_DATA_IN:
+    pid = in_transaction(usbp, 0, xp->buf + xp->count,
+                         xp->size - xp->count, &n);
+    if ((pid == PID_ACK) || (pid == PID_BABBLE)) {
+      xp->count += n;
+      if ((xp->count >= xp->size) || (n < usbp->epc[0]->in_maxsize))
+        usbp->host_stage = STAGE_STATUS_OUT;
+    }
+    break;
+  case STAGE_DATA_OUT:
+    n = xp->size - xp->count;
+    if (n > usbp->epc[0]->out_maxsize)
+      n = usbp->epc[0]->out_maxsize;
+    pid = out_transaction(usbp, 0, xp->buf + xp->count, n);
+    if (pid == PID_ACK) {
+      xp->count += n;
+      if (xp->count >= xp->size)
+        usbp->host_stage = STAGE_STATUS_IN;
+    }
+    break;
+  case STAGE_STATUS_IN:
+    pid = in_transaction(usbp, 0, NULL, 0, &n);
+    if (pid == PID_ACK)
+      complete_transfer(usbp, xp, RDY_OK);
+    break;
+  default:
+    pid = out_transaction(usbp, 0, NULL, 0);
+    if (pid == PID_ACK)
+      complete_transfer(usbp, xp, RDY_OK);
+  }
+  /* The transfer fails on stall and on babble.*/
+  if ((pid == PID_STALL) || (pid == PID_BABBLE))
+    complete_transfer(usbp, xp, RDY_RESET);
+  return pid;
+}
+
+/**
+ * @brief   Executes the next transaction of a pending IN transfer.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The transaction handshake.
+ *
+ * @notapi
+ */
+static unsigned in_transfer(USBDriver *usbp, usbep_t ep) {
+  USBSimTransfer *xp = &usbp->host_in[ep - 1];
+  size_t n;
+  unsigned pid;
+
+  pid = in_transaction(usbp, ep, xp->buf + xp->count,
+                       xp->size - xp->count, &n);
+  if (pid == PID_ACK) {
+    xp->count += n;
+    /* The transfer ends when the buffer is full or with a short packet.*/
+    if ((xp->count >= xp->size) || (n < usbp->epc[ep]->in_maxsize))
+      complete_transfer(usbp, xp, RDY_OK);
+  }
+  else if (pid == PID_BABBLE) {
+    xp->count += n;
+    complete_transfer(usbp, xp, RDY_RESET);
+  }
+  else if (pid == PID_STALL)
+    complete_transfer(usbp, xp, RDY_RESET);
+  return pid;
+}
+
+/**
+ * @brief   Executes the next transaction of a pending OUT transfer.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The transaction handshake.
+ *
+ * @notapi
+ */
+static unsigned out_transfer(USBDriver *usbp, usbep_t ep) {
+  USBSimTransfer *xp = &usbp->host_out[ep - 1];
+  size_t n = 0;
+  unsigned pid;
+
+  if (usbp->epc[ep] == NULL)
+    pid = PID_STALL;
+  else {
+    n = xp->size - xp->count;
+    if (n > usbp->epc[ep]->out_maxsize)
+      n = usbp->epc[ep]->out_maxsize;
+    pid = out_transaction(usbp, ep, xp->buf + xp->count, n);
+  }
+  if (pid == PID_ACK) {
+    xp->count += n;
+    /* A zero sized transfer is a single zero sized packet.*/
+    if (xp->count >= xp->size)
+      complete_transfer(usbp, xp, RDY_OK);
+  }
+  else if (pid == PID_STALL)
+    complete_transfer(usbp, xp, RDY_RESET);
+  return pid;
+}
+
+/**
+ * @brief   Executes a (micro)frame.
+ * @details The pending transfers are served in round robin, one transaction
+ *          at time, until the frame is full or all the endpoints NAKed.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The frame status.
+ * @retval FALSE        no packets have been moved.
+ * @retval TRUE         at least a packet has been moved.
+ *
+ * @notapi
+ */
+static bool_t serve_frame(USBDriver *usbp) {
+  unsigned budget = USB_SIM_FRAME_PACKETS;
+  bool_t moved = FALSE, progress = TRUE;
+  usbep_t ep;
+
+  usbp->stats.frames++;
+  _usb_isr_invoke_sof_cb(usbp);
+
+  while (progress && (budget > 0)) {
+    progress = FALSE;
+    if (usbp->host_ctrl.thread != NULL) {
+      if (control_transaction(usbp) != PID_NAK) {
+        progress = TRUE;
+        budget--;
+      }
+    }
+    for (ep = 1; (ep <= USB_MAX_ENDPOINTS) && (budget > 0); ep++) {
+      if (usbp->host_in[ep - 1].thread != NULL) {
+        if (in_transfer(usbp, ep) != PID_NAK) {
+          progress = TRUE;
+          budget--;
+        }
+      }
+      if ((budget > 0) && (usbp->host_out[ep - 1].thread != NULL)) {
+        if (out_transfer(usbp, ep) != PID_NAK) {
+          progress = TRUE;
+          budget--;
+        }
+      }
+    }
+    moved = moved || progress;
+  }
+  return moved;
+}
+
+/**
+ * @brief   Serves the host requests.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The serving status.
+ * @retval FALSE        nothing to do.
+ * @retval TRUE         the bus activity may have resumed threads.
+ *
+ * @notapi
+ */
+static bool_t serve_bus(USBDriver *usbp) {
+
+  if (!host_pending(usbp))
+    return FALSE;
+
+  /* Transfers on a stopped or disconnected device fail.*/
+  if ((usbp->state == USB_STOP) || !usbp->connected) {
+    abort_transfers(usbp);
+    if (usbp->host_reset.thread != NULL)
+      complete_transfer(usbp, &usbp->host_reset, RDY_RESET);
+    return TRUE;
+  }
+
+  /* Bus reset, the device returns to the default state.*/
+  if (usbp->host_reset.thread != NULL) {
+    abort_transfers(usbp);
+    usbp->stalled_in = 0;
+    usbp->stalled_out = 0;
+    _usb_reset(usbp);
+    _usb_isr_invoke_event_cb(usbp, USB_EVENT_RESET);
+    complete_transfer(usbp, &usbp->host_reset, RDY_OK);
+    usbp->idle = FALSE;
+    return TRUE;
+  }
+
+  /* After a frame where the device NAKed everything the bus is paced by
+     the host clock.*/
+  if (usbp->idle && (hal_lld_get_time_ns() < usbp->next_ns))
+    return FALSE;
+  usbp->idle = !serve_frame(usbp);
+  if (usbp->idle)
+    usbp->next_ns = hal_lld_get_time_ns() + USB_SIM_FRAME_NS;
+  return TRUE;
+}
+
+/**
+ * @brief   Starts a host transfer and waits for its completion.
+ *
+ * @param[in] xp        pointer to the @p USBSimTransfer object
+ * @param[in] buf       host buffer
+ * @param[in,out] np    pointer to the requested size, on exit the
+ *                      transferred size
+ * @param[in] timeout   the number of ticks before the operation timeouts
+ * @return              The operation status.
+ *
+ * @sclass
+ */
+static msg_t host_transfer_wait(USBSimTransfer *xp, uint8_t *buf,
+                                size_t *np, systime_t timeout) {
+  msg_t msg;
+
+  chDbgAssert(xp->thread == NULL, "host_transfer_wait(), #1",
+              "transfer already pending");
+
+  xp->buf = buf;
+  xp->size = *np;
+  xp->count = 0;
+  xp->thread = chThdSelf();
+  msg = chSchGoSleepTimeoutS(THD_STATE_SUSPENDED, timeout);
+  xp->thread = NULL;
+  *np = xp->count;
+  return msg;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level USB driver initialization.
+ *
+ * @notapi
+ */
+void usb_lld_init(void) {
+
+#if USE_SIM_USB1
+  /* Driver initialization.*/
+  usbObjectInit(&USBD1);
+#endif
+}
+
+/**
+ * @brief   Configures and activates the USB peripheral.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_start(USBDriver *usbp) {
+
+  if (usbp->state == USB_STOP) {
+    usbp->stalled_in = 0;
+    usbp->stalled_out = 0;
+    /* Reset procedure enforced on driver start.*/
+    _usb_reset(usbp);
+  }
+  /* Configuration.*/
+}
+
+/**
+ * @brief   Deactivates the USB peripheral.
+ * @note    The pending host transfers fail at the next interrupt sources
+ *          polling.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_stop(USBDriver *usbp) {
+
+  usbp->connected = FALSE;
+}
+
+/**
+ * @brief   USB low level reset routine.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_reset(USBDriver *usbp) {
+
+  /* EP0 initialization.*/
+  usbp->epc[0] = &ep0config;
+  usb_lld_init_endpoint(usbp, 0);
+}
+
+/**
+ * @brief   Sets the USB address.
+ * @note    The simulated bus has a single device, the address is not used.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_set_address(USBDriver *usbp) {
+
+  (void)usbp;
+}
+
+/**
+ * @brief   Enables an endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_init_endpoint(USBDriver *usbp, usbep_t ep) {
+
+  usbp->stalled_in &= ~(1 << ep);
+  usbp->stalled_out &= ~(1 << ep);
+}
+
+/**
+ * @brief   Disables all the active endpoints except the endpoint zero.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ *
+ * @notapi
+ */
+void usb_lld_disable_endpoints(USBDriver *usbp) {
+
+  usbp->stalled_in &= 1;
+  usbp->stalled_out &= 1;
+}
+
+/**
+ * @brief   Returns the status of an OUT endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The endpoint status.
+ * @retval EP_STATUS_DISABLED The endpoint is not active.
+ * @retval EP_STATUS_STALLED  The endpoint is stalled.
+ * @retval EP_STATUS_ACTIVE   The endpoint is active.
+ *
+ * @notapi
+ */
+usbepstatus_t usb_lld_get_status_out(USBDriver *usbp, usbep_t ep) {
+
+  if ((ep > USB_MAX_ENDPOINTS) || (usbp->epc[ep] == NULL) ||
+      (usbp->epc[ep]->out_cb == NULL))
+    return EP_STATUS_DISABLED;
+  if (usbp->stalled_out & (1 << ep))
+    return EP_STATUS_STALLED;
+  return EP_STATUS_ACTIVE;
+}
+
+/**
+ * @brief   Returns the status of an IN endpoint.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              The endpoint status.
+ * @retval EP_STATUS_DISABLED The endpoint is not active.
+ * @retval EP_STATUS_STALLED  The endpoint is stalled.
+ * @retval EP_STATUS_ACTIVE   The endpoint is active.
+ *
+ * @notapi
+ */
+usbepstatus_t usb_lld_get_status_in(USBDriver *usbp, usbep_t ep) {
+
+  if ((ep > USB_MAX_ENDPOINTS) || (usbp->epc[ep] == NULL) ||
+      (usbp->epc[ep]->in_cb == NULL))
+    return EP_STATUS_DISABLED;
+  if (usbp->stalled_in & (1 << ep))
+    return EP_STATUS_STALLED;
+  return EP_STATUS_ACTIVE;
+}
+
+/**
+ * @brief   Reads a setup packet from the dedicated packet buffer.
+ * @details This function must be invoked in the context of the @p setup_cb
+ *          callback in order to read the received setup packet.
+ * @pre     In order to use this function the endpoint must have been
+ *          initialized as a control endpoint.
+ * @post    The endpoint is ready to accept another packet.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[out] buf      buffer where to copy the packet data
+ *
+ * @notapi
+ */
+void usb_lld_read_setup(USBDriver *usbp, usbep_t ep, uint8_t *buf) {
+
+  (void)ep;
+  memcpy(buf, usbp->host_setup, 8);
+}
+
+/**
+ * @brief   Prepares for a receive operation.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_prepare_receive(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Prepares for a transmit operation.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_prepare_transmit(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Starts a receive operation on an OUT endpoint.
+ * @note    The packets are moved by the simulated interrupt sources
+ *          polling, the @p receiving bit is the endpoint enable.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_start_out(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Starts a transmit operation on an IN endpoint.
+ * @note    The packets are moved by the simulated interrupt sources
+ *          polling, the @p transmitting bit is the endpoint enable.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_start_in(USBDriver *usbp, usbep_t ep) {
+
+  (void)usbp;
+  (void)ep;
+}
+
+/**
+ * @brief   Brings an OUT endpoint in the stalled state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_stall_out(USBDriver *usbp, usbep_t ep) {
+
+  usbp->stalled_out |= 1 << ep;
+}
+
+/**
+ * @brief   Brings an IN endpoint in the stalled state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_stall_in(USBDriver *usbp, usbep_t ep) {
+
+  usbp->stalled_in |= 1 << ep;
+}
+
+/**
+ * @brief   Brings an OUT endpoint in the active state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_clear_out(USBDriver *usbp, usbep_t ep) {
+
+  usbp->stalled_out &= ~(1 << ep);
+}
+
+/**
+ * @brief   Brings an IN endpoint in the active state.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ *
+ * @notapi
+ */
+void usb_lld_clear_in(USBDriver *usbp, usbep_t ep) {
+
+  usbp->stalled_in &= ~(1 << ep);
+}
+
+/**
+ * @brief   Simulated bus activity.
+ * @details Executes the pending bus reset or the next (micro)frame.
+ *
+ * @return              @p TRUE if the bus activity may have resumed
+ *                      threads.
+ *
+ * @notapi
+ */
+bool_t usb_lld_interrupt_pending(void) {
+  bool_t b = FALSE;
+
+  CH_IRQ_PROLOGUE();
+
+#if USE_SIM_USB1
+  b = serve_bus(&USBD1);
+#endif
+
+  CH_IRQ_EPILOGUE();
+
+  return b;
+}
+
+/**
+ * @brief   Host bus reset.
+ * @details The device returns to the default state, the pending transfers
+ *          are aborted.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The operation status.
+ * @retval RDY_OK       if the device has been reset.
+ * @retval RDY_RESET    if the device is stopped or not connected.
+ *
+ * @api
+ */
+msg_t usbSimHostReset(USBDriver *usbp) {
+  size_t n = 0;
+  msg_t msg;
+
+  chDbgCheck(usbp != NULL, "usbSimHostReset");
+
+  chSysLock();
+  msg = host_transfer_wait(&usbp->host_reset, NULL, &n, TIME_INFINITE);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Host control transfer on the endpoint zero.
+ * @details The data stage size and direction are specified in the setup
+ *          packet.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] setup     the setup packet
+ * @param[in,out] buf   buffer for the data stage, it can be @p NULL if
+ *                      there is no data stage
+ * @param[out] np       pointer to the data stage transferred size or
+ *                      @p NULL
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the transfer completed.
+ * @retval RDY_RESET    if the device stalled the request, it sent more
+ *                      data than requested or it is not connected.
+ * @retval RDY_TIMEOUT  if a timeout occurred.
+ *
+ * @api
+ */
+msg_t usbSimHostControl(USBDriver *usbp, const uint8_t *setup,
+                        uint8_t *buf, size_t *np, systime_t timeout) {
+  size_t n = usbFetchWord(&setup[6]);
+  msg_t msg;
+
+  chDbgCheck((usbp != NULL) && (setup != NULL) &&
+             ((buf != NULL) || (n == 0)), "usbSimHostControl");
+
+  chSysLock();
+  memcpy(usbp->host_setup, setup, 8);
+  usbp->host_stage = STAGE_SETUP;
+  msg = host_transfer_wait(&usbp->host_ctrl, buf, &n, timeout);
+  chSysUnlock();
+  if (np != NULL)
+    *np = n;
+  return msg;
+}
+
+/**
+ * @brief   Host IN transfer.
+ * @details The transfer ends when the buffer is full or after a short
+ *          packet.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[out] buf      buffer for the received data
+ * @param[in,out] np    pointer to the buffer size, on exit the received
+ *                      size
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the transfer completed.
+ * @retval RDY_RESET    if the endpoint is stalled, not enabled or the
+ *                      device is not connected. It is also returned when
+ *                      the device sent a packet larger than the space left
+ *                      in the buffer, the data fitting the buffer is
+ *                      reported.
+ * @retval RDY_TIMEOUT  if a timeout occurred, the data received so far
+ *                      is reported.
+ *
+ * @api
+ */
+msg_t usbSimHostIn(USBDriver *usbp, usbep_t ep, uint8_t *buf,
+                   size_t *np, systime_t timeout) {
+  msg_t msg;
+
+  chDbgCheck((usbp != NULL) && (ep > 0) && (ep <= USB_MAX_ENDPOINTS) &&
+             (buf != NULL) && (np != NULL), "usbSimHostIn");
+
+  chSysLock();
+  msg = host_transfer_wait(&usbp->host_in[ep - 1], buf, np, timeout);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Host OUT transfer.
+ * @details The data is sent in packets of the endpoint maximum size, a
+ *          zero sized transfer sends a zero sized packet.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @param[in] buf       buffer of the data to be sent
+ * @param[in,out] np    pointer to the data size, on exit the sent size
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the transfer completed.
+ * @retval RDY_RESET    if the endpoint is stalled, not enabled or the
+ *                      device is not connected.
+ * @retval RDY_TIMEOUT  if a timeout occurred, the data sent so far is
+ *                      reported.
+ *
+ * @api
+ */
+msg_t usbSimHostOut(USBDriver *usbp, usbep_t ep, const uint8_t *buf,
+                    size_t *np, systime_t timeout) {
+  msg_t msg;
+
+  chDbgCheck((usbp != NULL) && (ep > 0) && (ep <= USB_MAX_ENDPOINTS) &&
+             (np != NULL) && ((buf != NULL) || (*np == 0)), "usbSimHostOut");
+
+  chSysLock();
+  msg = host_transfer_wait(&usbp->host_out[ep - 1], (uint8_t *)buf, np,
+                           timeout);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Simulated bus statistics.
+ * @note    This is a Posix-specific API.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[out] ssp      pointer to a @p USBSimStats structure
+ *
+ * @api
+ */
+void usbSimGetBusStats(USBDriver *usbp, USBSimStats *ssp) {
+
+  chDbgCheck((usbp != NULL) && (ssp != NULL), "usbSimGetBusStats");
+
+  chSysLock();
+  *ssp = usbp->stats;
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_USB */
+
+/** @} */
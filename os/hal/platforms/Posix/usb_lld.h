@@ -0,0 +1,543 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    Posix/usb_lld.h
+ * @brief   Posix low level simulated USB driver header.
+ *
+ * @addtogroup POSIX_USB
+ * @{
+ */
+
+#ifndef _USB_LLD_H_
+#define _USB_LLD_H_
+
+#if HAL_USE_USB || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum endpoint address.
+ */
+#define USB_MAX_ENDPOINTS                   4
+
+/**
+ * @brief   Status stage handling method.
+ */
+#define USB_EP0_STATUS_STAGE                USB_EP0_STATUS_STAGE_SW
+
+/**
+ * @brief   This device requires the address change after the status packet.
+ */
+#define USB_SET_ADDRESS_MODE                USB_LATE_SET_ADDRESS
+
+/**
+ * @brief   The common USB code debug counters are not maintained.
+ */
+#define ENABLE_USB_OTG_DEBUG_COUNTERS       0
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   USBD1 driver enable switch.
+ * @details If set to @p TRUE the support for USBD1 is included.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(USE_SIM_USB1) || defined(__DOXYGEN__)
+#define USE_SIM_USB1                        TRUE
+#endif
+
+/**
+ * @brief   Simulated bus speed.
+ * @details If set to @p TRUE the bus runs at high speed, 125us micro-frames
+ *          carrying up to 13 bulk packets of 512 bytes, else it runs at
+ *          full speed, 1ms frames carrying up to 19 bulk packets of 64
+ *          bytes.
+ */
+#if !defined(USB_SIM_HIGH_SPEED) || defined(__DOXYGEN__)
+#define USB_SIM_HIGH_SPEED                  FALSE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if USB_SIM_HIGH_SPEED || defined(__DOXYGEN__)
+/**
+ * @brief   Simulated (micro)frame duration in nanoseconds.
+ */
+#define USB_SIM_FRAME_NS                    125000
+
+/**
+ * @brief   Transactions executed in a (micro)frame.
+ */
+#define USB_SIM_FRAME_PACKETS               13
+
+/**
+ * @brief   Shift from the (micro)frames count to the frame number.
+ */
+#define USB_SIM_FRAME_SHIFT                 3
+#else
+#define USB_SIM_FRAME_NS                    1000000
+#define USB_SIM_FRAME_PACKETS               19
+#define USB_SIM_FRAME_SHIFT                 0
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of an IN endpoint state structure.
+ */
+typedef struct {
+  /**
+   * @brief   Buffer mode, queue or linear.
+   */
+  bool_t                        txqueued;
+  /**
+   * @brief   Requested transmit transfer size.
+   */
+  size_t                        txsize;
+  /**
+   * @brief   Transmitted bytes so far.
+   */
+  size_t                        txcnt;
+  union {
+    struct {
+      /**
+       * @brief   Pointer to the transmission linear buffer.
+       */
+      const uint8_t             *txbuf;
+    } linear;
+    struct {
+      /**
+       * @brief   Pointer to the output queue.
+       */
+      OutputQueue               *txqueue;
+    } queue;
+    /* End of the mandatory fields.*/
+  } mode;
+} USBInEndpointState;
+
+/**
+ * @brief   Type of an OUT endpoint state structure.
+ */
+typedef struct {
+  /**
+   * @brief   Buffer mode, queue or linear.
+   */
+  bool_t                        rxqueued;
+  /**
+   * @brief   Requested receive transfer size.
+   */
+  size_t                        rxsize;
+  /**
+   * @brief   Received bytes so far.
+   */
+  size_t                        rxcnt;
+  union {
+    struct {
+      /**
+       * @brief   Pointer to the receive linear buffer.
+       */
+      uint8_t                   *rxbuf;
+    } linear;
+    struct {
+      /**
+       * @brief   Pointer to the input queue.
+       */
+      InputQueue               *rxqueue;
+    } queue;
+  } mode;
+  /* End of the mandatory fields.*/
+} USBOutEndpointState;
+
+/**
+ * @brief   Type of an USB endpoint configuration structure.
+ * @note    Platform specific restrictions may apply to endpoints.
+ */
+typedef struct {
+  /**
+   * @brief   Type and mode of the endpoint.
+   */
+  uint32_t                      ep_mode;
+  /**
+   * @brief   Setup packet notification callback.
+   * @details This callback is invoked when a setup packet has been
+   *          received.
+   * @post    The application must immediately call @p usbReadPacket() in
+   *          order to access the received packet.
+   * @note    This field is only valid for @p USB_EP_MODE_TYPE_CTRL
+   *          endpoints, it should be set to @p NULL for other endpoint
+   *          types.
+   */
+  usbepcallback_t               setup_cb;
+  /**
+   * @brief   IN endpoint notification callback.
+   * @details This field must be set to @p NULL if the IN endpoint is not
+   *          used.
+   */
+  usbepcallback_t               in_cb;
+  /**
+   * @brief   OUT endpoint notification callback.
+   * @details This field must be set to @p NULL if the OUT endpoint is not
+   *          used.
+   */
+  usbepcallback_t               out_cb;
+  /**
+   * @brief   IN endpoint maximum packet size.
+   * @details This field must be set to zero if the IN endpoint is not
+   *          used.
+   */
+  uint16_t                      in_maxsize;
+  /**
+   * @brief   OUT endpoint maximum packet size.
+   * @details This field must be set to zero if the OUT endpoint is not
+   *          used.
+   */
+  uint16_t                      out_maxsize;
+  /**
+   * @brief   @p USBEndpointState associated to the IN endpoint.
+   * @details This structure maintains the state of the IN endpoint.
+   */
+  USBInEndpointState            *in_state;
+  /**
+   * @brief   @p USBEndpointState associated to the OUT endpoint.
+   * @details This structure maintains the state of the OUT endpoint.
+   */
+  USBOutEndpointState           *out_state;
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   Reserved field, not currently used.
+   * @note    Initialize this field to 1 in order to be forward compatible.
+   */
+  uint16_t                      ep_buffers;
+  /**
+   * @brief   Pointer to a buffer for setup packets.
+   * @details Setup packets require a dedicated 8-bytes buffer, set this
+   *          field to @p NULL for non-control endpoints.
+   */
+  uint8_t                       *setup_buf;
+} USBEndpointConfig;
+
+/**
+ * @brief   Type of an USB driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief   USB events callback.
+   * @details This callback is invoked when an USB driver event is registered.
+   */
+  usbeventcb_t                  event_cb;
+  /**
+   * @brief   Device GET_DESCRIPTOR request callback.
+   * @note    This callback is mandatory and cannot be set to @p NULL.
+   */
+  usbgetdescriptor_t            get_descriptor_cb;
+  /**
+   * @brief   Requests hook callback.
+   * @details This hook allows to be notified of standard requests or to
+   *          handle non standard requests.
+   */
+  usbreqhandler_t               requests_hook_cb;
+  /**
+   * @brief   Start Of Frame callback.
+   */
+  usbcallback_t                 sof_cb;
+  /* End of the mandatory fields.*/
+} USBConfig;
+
+/**
+ * @brief   Simulated host transfer.
+ * @details A transfer is pending while a host thread waits for it.
+ */
+typedef struct {
+  /**
+   * @brief   Host thread waiting for the transfer, @p NULL if idle.
+   */
+  Thread                        *thread;
+  /**
+   * @brief   Host side data buffer.
+   */
+  uint8_t                       *buf;
+  /**
+   * @brief   Requested transfer size.
+   */
+  size_t                        size;
+  /**
+   * @brief   Transferred bytes so far.
+   */
+  size_t                        count;
+} USBSimTransfer;
+
+/**
+ * @brief   Simulated bus statistics.
+ */
+typedef struct {
+  /**
+   * @brief   Elapsed (micro)frames.
+   * @note    Frames are only counted while host transfers are pending.
+   */
+  uint32_t                      frames;
+  /**
+   * @brief   Acknowledged setup and data packets, zero sized included.
+   */
+  uint32_t                      packets;
+  /**
+   * @brief   Transactions not acknowledged because the device was not
+   *          ready.
+   */
+  uint32_t                      naks;
+  /**
+   * @brief   IN packets larger than the space left in the host buffer.
+   */
+  uint32_t                      babbles;
+  /**
+   * @brief   Completed host transfers.
+   */
+  uint32_t                      transfers;
+  /**
+   * @brief   Data bytes moved on the bus.
+   */
+  uint64_t                      bytes;
+} USBSimStats;
+
+/**
+ * @brief   Structure representing an USB driver.
+ */
+struct USBDriver {
+  /**
+   * @brief   Driver state.
+   */
+  usbstate_t                    state;
+  /**
+   * @brief   Current configuration data.
+   */
+  const USBConfig               *config;
+  /**
+   * @brief   Bit map of the transmitting IN endpoints.
+   */
+  uint16_t                      transmitting;
+  /**
+   * @brief   Bit map of the receiving OUT endpoints.
+   */
+  uint16_t                      receiving;
+  /**
+   * @brief   Active endpoints configurations.
+   */
+  const USBEndpointConfig       *epc[USB_MAX_ENDPOINTS + 1];
+  /**
+   * @brief   Fields available to user, it can be used to associate an
+   *          application-defined handler to an IN endpoint.
+   * @note    The base index is one, the endpoint zero does not have a
+   *          reserved element in this array.
+   */
+  void                          *in_params[USB_MAX_ENDPOINTS];
+  /**
+   * @brief   Fields available to user, it can be used to associate an
+   *          application-defined handler to an OUT endpoint.
+   * @note    The base index is one, the endpoint zero does not have a
+   *          reserved element in this array.
+   */
+  void                          *out_params[USB_MAX_ENDPOINTS];
+  /**
+   * @brief   Endpoint 0 state.
+   */
+  usbep0state_t                 ep0state;
+  /**
+   * @brief   Next position in the buffer to be transferred through endpoint 0.
+   */
+  uint8_t                       *ep0next;
+  /**
+   * @brief   Number of bytes yet to be transferred through endpoint 0.
+   */
+  size_t                        ep0n;
+  /**
+   * @brief   Endpoint 0 end transaction callback.
+   */
+  usbcallback_t                 ep0endcb;
+  /**
+   * @brief   Setup packet buffer.
+   */
+  uint8_t                       setup[8];
+  /**
+   * @brief   Current USB device status.
+   */
+  uint16_t                      status;
+  /**
+   * @brief   Assigned USB address.
+   */
+  uint8_t                       address;
+  /**
+   * @brief   Current USB device configuration.
+   */
+  uint8_t                       configuration;
+#if defined(USB_DRIVER_EXT_FIELDS)
+  USB_DRIVER_EXT_FIELDS
+#endif
+  /* End of the mandatory fields.*/
+  /**
+   * @brief   The low level driver was started successfully.
+   */
+  uint32_t                      usb_start_success;
+  /**
+   * @brief   The device is connected to the bus.
+   */
+  bool_t                        connected;
+  /**
+   * @brief   Bit map of the stalled IN endpoints.
+   */
+  uint16_t                      stalled_in;
+  /**
+   * @brief   Bit map of the stalled OUT endpoints.
+   */
+  uint16_t                      stalled_out;
+  /**
+   * @brief   Pending bus reset.
+   */
+  USBSimTransfer                host_reset;
+  /**
+   * @brief   Setup packet of the pending control transfer.
+   */
+  uint8_t                       host_setup[8];
+  /**
+   * @brief   Stage of the pending control transfer.
+   */
+  uint8_t                       host_stage;
+  /**
+   * @brief   Pending control transfer.
+   */
+  USBSimTransfer                host_ctrl;
+  /**
+   * @brief   Pending IN transfers, the base index is one.
+   */
+  USBSimTransfer                host_in[USB_MAX_ENDPOINTS];
+  /**
+   * @brief   Pending OUT transfers, the base index is one.
+   */
+  USBSimTransfer                host_out[USB_MAX_ENDPOINTS];
+  /**
+   * @brief   The last (micro)frame did not move any packet.
+   */
+  bool_t                        idle;
+  /**
+   * @brief   Host time of the next (micro)frame after an idle one.
+   */
+  uint64_t                      next_ns;
+  /**
+   * @brief   Bus statistics.
+   */
+  USBSimStats                   stats;
+};
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the current frame number.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @return              The current frame number.
+ *
+ * @notapi
+ */
+#define usb_lld_get_frame_number(usbp)                                      \
+  (((usbp)->stats.frames >> USB_SIM_FRAME_SHIFT) & 0x7FF)
+
+/**
+ * @brief   Returns the exact size of a receive transaction.
+ * @details The received size can be different from the size specified in
+ *          @p usbStartReceiveI() because the last packet could have a size
+ *          different from the expected one.
+ * @pre     The OUT endpoint must have been configured in transaction mode
+ *          in order to use this function.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] ep        endpoint number
+ * @return              Received data size.
+ *
+ * @notapi
+ */
+#define usb_lld_get_transaction_size(usbp, ep)                              \
+  ((usbp)->epc[ep]->out_state->rxcnt)
+
+/**
+ * @brief   Connects the USB device.
+ *
+ * @api
+ */
+#define usb_lld_connect_bus(usbp) ((usbp)->connected = TRUE)
+
+/**
+ * @brief   Disconnect the USB device.
+ *
+ * @api
+ */
+#define usb_lld_disconnect_bus(usbp) ((usbp)->connected = FALSE)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#if USE_SIM_USB1 && !defined(__DOXYGEN__)
+extern USBDriver USBD1;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void usb_lld_init(void);
+  void usb_lld_start(USBDriver *usbp);
+  void usb_lld_stop(USBDriver *usbp);
+  void usb_lld_reset(USBDriver *usbp);
+  void usb_lld_set_address(USBDriver *usbp);
+  void usb_lld_init_endpoint(USBDriver *usbp, usbep_t ep);
+  void usb_lld_disable_endpoints(USBDriver *usbp);
+  usbepstatus_t usb_lld_get_status_in(USBDriver *usbp, usbep_t ep);
+  usbepstatus_t usb_lld_get_status_out(USBDriver *usbp, usbep_t ep);
+  void usb_lld_read_setup(USBDriver *usbp, usbep_t ep, uint8_t *buf);
+  void usb_lld_prepare_receive(USBDriver *usbp, usbep_t ep);
+  void usb_lld_prepare_transmit(USBDriver *usbp, usbep_t ep);
+  void usb_lld_start_out(USBDriver *usbp, usbep_t ep);
+  void usb_lld_start_in(USBDriver *usbp, usbep_t ep);
+  void usb_lld_stall_out(USBDriver *usbp, usbep_t ep);
+  void usb_lld_stall_in(USBDriver *usbp, usbep_t ep);
+  void usb_lld_clear_out(USBDriver *usbp, usbep_t ep);
+  void usb_lld_clear_in(USBDriver *usbp, usbep_t ep);
+  bool_t usb_lld_interrupt_pending(void);
+  msg_t usbSimHostReset(USBDriver *usbp);
+  msg_t usbSimHostControl(USBDriver *usbp, const uint8_t *setup,
+                          uint8_t *buf, size_t *np, systime_t timeout);
+  msg_t usbSimHostIn(USBDriver *usbp, usbep_t ep, uint8_t *buf,
+                     size_t *np, systime_t timeout);
+  msg_t usbSimHostOut(USBDriver *usbp, usbep_t ep, const uint8_t *buf,
+                      size_t *np, systime_t timeout);
+  void usbSimGetBusStats(USBDriver *usbp, USBSimStats *ssp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_USE_USB */
+
+#endif /* _USB_LLD_H_ */
+
+/** @} */
@@ -178,9 +178,7 @@ static void usb_packet_read_to_queue(USBDriver *usbp, usbep_t ep, InputQueue *iq
 
   /* Updating queue.*/
   chSysLockFromIsr();
-  iqp->q_counter += n;
-  while (notempty(&iqp->q_waiting))
-    chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+  chIQCommitI(iqp, n);
   chSysUnlockFromIsr();
 }
 
@@ -249,17 +247,13 @@ static void usb_packet_write_from_queue(USBDriver *usbp, usbep_t ep,
     dbg_enter_lock();
     chSysLock();
 
-    oqp->q_counter += n;
-    while (notempty(&oqp->q_waiting))
-      chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+    chOQReleaseI(oqp, n);
 
     chSysUnlock();
     dbg_leave_lock();
   }
   else {
-    oqp->q_counter += n;
-    while (notempty(&oqp->q_waiting))
-      chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+    chOQReleaseI(oqp, n);
   }
 }
 
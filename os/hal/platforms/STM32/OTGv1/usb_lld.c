@@ -355,9 +355,7 @@ static void otg_fifo_write_from_queue(volatile uint32_t *fifop,
 
   /* Updating queue.*/
   chSysLock();
-  oqp->q_counter += n;
-  while (notempty(&oqp->q_waiting))
-    chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+  chOQReleaseI(oqp, n);
   chSchRescheduleS();
   chSysUnlock();
 }
@@ -438,7 +436,7 @@ static void otg_fifo_read_to_queue(volatile uint32_t *fifop,
 
     if (nw > 0) {
       size_t streak;
-      uint32_t nw2end = (iqp->q_wrptr - iqp->q_wrptr) / 4;
+      uint32_t nw2end = (iqp->q_top - iqp->q_wrptr) / 4;
 
       ntogo -= (streak = nw <= nw2end ? nw : nw2end) * 4;
       iqp->q_wrptr = otg_do_pop(fifop, iqp->q_wrptr, streak);
@@ -467,9 +465,7 @@ static void otg_fifo_read_to_queue(volatile uint32_t *fifop,
 
   /* Updating queue.*/
   chSysLock();
-  iqp->q_counter += n;
-  while (notempty(&iqp->q_waiting))
-    chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+  chIQCommitI(iqp, n);
   chSchRescheduleS();
   chSysUnlock();
 }
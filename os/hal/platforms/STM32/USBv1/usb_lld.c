@@ -177,9 +177,7 @@ static void usb_packet_read_to_queue(stm32_usb_descriptor_t *udp,
 
   /* Updating queue.*/
   chSysLockFromIsr();
-  iqp->q_counter += n;
-  while (notempty(&iqp->q_waiting))
-    chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+  chIQCommitI(iqp, n);
   chSysUnlockFromIsr();
 }
 
@@ -252,9 +250,7 @@ static void usb_packet_write_from_queue(stm32_usb_descriptor_t *udp,
   port_lock();
   dbg_enter_lock();
 
-  oqp->q_counter += n;
-  while (notempty(&oqp->q_waiting))
-    chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+  chOQReleaseI(oqp, n);
 
   dbg_leave_lock();
   port_unlock();
@@ -130,11 +130,16 @@ static void can_lld_tx_handler(CANDriver *canp) {
 
   /* No more events until a message is transmitted.*/
   canp->can->TSR = CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2;
+#if CAN_TX_QUEUE_SIZE > 0
+  /* Refilling the mailboxes from the software queue.*/
+  _can_tx_queue_flush(canp, CAN_MAILBOX_TO_MASK(1));
+#else
   chSysLockFromIsr();
   while (chSemGetCounterI(&canp->txsem) < 0)
     chSemSignalI(&canp->txsem);
   chEvtBroadcastFlagsI(&canp->txempty_event, CAN_MAILBOX_TO_MASK(1));
   chSysUnlockFromIsr();
+#endif
 }
 
 /**
@@ -149,6 +154,11 @@ static void can_lld_rx0_handler(CANDriver *canp) {
 
   rf0r = canp->can->RF0R;
   if ((rf0r & CAN_RF0R_FMP0) > 0) {
+#if CAN_RX_FIFO_SIZE > 0
+    /* The frames are moved into the software FIFO, the interrupt source
+       stays enabled.*/
+    _can_rx_fifo_fill(canp, 1);
+#else
     /* No more receive events until the queue 0 has been emptied.*/
     canp->can->IER &= ~CAN_IER_FMPIE0;
     chSysLockFromIsr();
@@ -156,6 +166,7 @@ static void can_lld_rx0_handler(CANDriver *canp) {
       chSemSignalI(&canp->rxsem);
     chEvtBroadcastFlagsI(&canp->rxfull_event, CAN_MAILBOX_TO_MASK(1));
     chSysUnlockFromIsr();
+#endif
   }
   if ((rf0r & CAN_RF0R_FOVR0) > 0) {
     /* Overflow events handling.*/
@@ -178,6 +189,11 @@ static void can_lld_rx1_handler(CANDriver *canp) {
 
   rf1r = canp->can->RF1R;
   if ((rf1r & CAN_RF1R_FMP1) > 0) {
+#if CAN_RX_FIFO_SIZE > 0
+    /* The frames are moved into the software FIFO, the interrupt source
+       stays enabled.*/
+    _can_rx_fifo_fill(canp, 2);
+#else
     /* No more receive events until the queue 0 has been emptied.*/
     canp->can->IER &= ~CAN_IER_FMPIE1;
     chSysLockFromIsr();
@@ -185,6 +201,7 @@ static void can_lld_rx1_handler(CANDriver *canp) {
       chSemSignalI(&canp->rxsem);
     chEvtBroadcastFlagsI(&canp->rxfull_event, CAN_MAILBOX_TO_MASK(2));
     chSysUnlockFromIsr();
+#endif
   }
   if ((rf1r & CAN_RF1R_FOVR1) > 0) {
     /* Overflow events handling.*/
@@ -698,7 +715,7 @@ void can_lld_wakeup(CANDriver *canp) {
 void canSTM32SetFilters(uint32_t can2sb, uint32_t num, const CANFilter *cfp) {
 
   chDbgCheck((can2sb > 1) && (can2sb < STM32_CAN_MAX_FILTERS) &&
-             (num < STM32_CAN_MAX_FILTERS),
+             (num <= STM32_CAN_MAX_FILTERS),
              "canSTM32SetFilters");
 
 #if STM32_CAN_USE_CAN1
@@ -713,6 +730,68 @@ void canSTM32SetFilters(uint32_t can2sb, uint32_t num, const CANFilter *cfp) {
   can_lld_set_filters(can2sb, num, cfp);
 }
 
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Programs the CAN1 filters from identifier/mask pairs.
+ * @details Each pair is programmed as a 32 bits mask mode filter starting
+ *          from filter zero, the pairs are usually computed by
+ *          @p canFiltersCover(). On devices with CAN2 the filter
+ *          @p can2sb is programmed to accept all frames on CAN2.
+ * @note    This is an STM32-specific API.
+ *
+ * @param[in] can2sb    number of the first filter assigned to CAN2
+ * @param[in] num       number of identifier/mask pairs, it must not be
+ *                      greater than @p can2sb
+ * @param[in] fmp       pointer to the identifier/mask pairs array
+ *
+ * @api
+ */
+void canSTM32SetMaskFilters(uint32_t can2sb,
+                            uint32_t num,
+                            const CANFilterMask *fmp) {
+  CANFilter filters[STM32_CAN_MAX_FILTERS];
+  uint32_t i;
+
+  chDbgCheck((num > 0) && (num <= can2sb) &&
+             (can2sb < STM32_CAN_MAX_FILTERS) && (fmp != NULL),
+             "canSTM32SetMaskFilters");
+
+  for (i = 0; i < num; i++) {
+    filters[i].filter = i;
+    filters[i].mode = 0;
+    filters[i].scale = 1;
+    filters[i].assignment = 0;
+    switch (fmp[i].ide) {
+    case CAN_IDE_STD:
+      filters[i].register1 = fmp[i].id << 21;
+      filters[i].register2 = (fmp[i].mask << 21) | CAN_RI0R_IDE;
+      break;
+    case CAN_IDE_EXT:
+      filters[i].register1 = (fmp[i].id << 3) | CAN_RI0R_IDE;
+      filters[i].register2 = (fmp[i].mask << 3) | CAN_RI0R_IDE;
+      break;
+    default:
+      filters[i].register1 = 0;
+      filters[i].register2 = 0;
+    }
+  }
+#if STM32_HAS_CAN2
+  /* The catch-all filter of CAN2 only exists if there is space for it,
+     num is not greater than can2sb so the array index is in range.*/
+  if (can2sb < STM32_CAN_MAX_FILTERS) {
+    filters[num].filter = can2sb;
+    filters[num].mode = 0;
+    filters[num].scale = 1;
+    filters[num].assignment = 0;
+    filters[num].register1 = 0;
+    filters[num].register2 = 0;
+    num++;
+  }
+#endif
+  canSTM32SetFilters(can2sb, num, filters);
+}
+#endif /* CAN_USE_SOFTWARE_FILTERS */
+
 #endif /* HAL_USE_CAN */
 
 /** @} */
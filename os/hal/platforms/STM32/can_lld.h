@@ -310,6 +310,46 @@ typedef struct {
    */
   EventSource               wakeup_event;
 #endif /* CAN_USE_SLEEP_MODE */
+#if (CAN_RX_FIFO_SIZE > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief   Software receive FIFO.
+   */
+  CANRxFrame                rxfifo[CAN_RX_FIFO_SIZE];
+  /**
+   * @brief   Receive FIFO read index.
+   */
+  size_t                    rxrdidx;
+  /**
+   * @brief   Receive FIFO write index.
+   */
+  size_t                    rxwridx;
+  /**
+   * @brief   Frames in the receive FIFO.
+   */
+  size_t                    rxcnt;
+  /**
+   * @brief   Frames lost because the receive FIFO was full.
+   */
+  uint32_t                  rxoverflows;
+#endif /* CAN_RX_FIFO_SIZE > 0 */
+#if (CAN_TX_QUEUE_SIZE > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief   Software transmit queue.
+   */
+  CANTxFrame                txqueue[CAN_TX_QUEUE_SIZE];
+  /**
+   * @brief   Transmit queue read index.
+   */
+  size_t                    txrdidx;
+  /**
+   * @brief   Transmit queue write index.
+   */
+  size_t                    txwridx;
+  /**
+   * @brief   Frames in the transmit queue.
+   */
+  size_t                    txcnt;
+#endif /* CAN_TX_QUEUE_SIZE > 0 */
   /* End of the mandatory fields.*/
   /**
    * @brief   Pointer to the CAN registers.
@@ -354,6 +394,11 @@ extern "C" {
   void can_lld_wakeup(CANDriver *canp);
 #endif /* CAN_USE_SLEEP_MODE */
   void canSTM32SetFilters(uint32_t can2sb, uint32_t num, const CANFilter *cfp);
+#if CAN_USE_SOFTWARE_FILTERS
+  void canSTM32SetMaskFilters(uint32_t can2sb,
+                              uint32_t num,
+                              const CANFilterMask *fmp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,23 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Empty hash table slot marker.
+ */
+#define FILTERS_EMPTY_SLOT          0xFFFF
+
+/**
+ * @brief   Identifier bits of the standard and extended frames.
+ */
+#define FILTERS_ID_BITS(ide)        ((ide) == 0 ? 11 : 29)
+
+/**
+ * @brief   Identifier mask of the standard and extended frames.
+ */
+#define FILTERS_ID_MASK(ide)        ((ide) == 0 ? 0x7FFU : 0x1FFFFFFFU)
+#endif /* CAN_USE_SOFTWARE_FILTERS */
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -47,6 +64,175 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Resets the software queues, the queued frames are discarded.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+static void can_reset_queues(CANDriver *canp) {
+
+#if CAN_RX_FIFO_SIZE > 0
+  canp->rxrdidx = 0;
+  canp->rxwridx = 0;
+  canp->rxcnt = 0;
+  canp->rxoverflows = 0;
+#endif
+#if CAN_TX_QUEUE_SIZE > 0
+  canp->txrdidx = 0;
+  canp->txwridx = 0;
+  canp->txcnt = 0;
+#endif
+  (void)canp;
+}
+
+/**
+ * @brief   Determines whether a frame can be fetched.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ * @return              The frame availability.
+ *
+ * @notapi
+ */
+static bool_t can_is_rx_nonempty(CANDriver *canp, canmbx_t mailbox) {
+
+#if CAN_RX_FIFO_SIZE > 0
+  (void)mailbox;
+  return canp->rxcnt > 0;
+#else
+  return can_lld_is_rx_nonempty(canp, mailbox);
+#endif
+}
+
+/**
+ * @brief   Fetches a frame.
+ * @pre     A frame must be available.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ * @param[out] crfp     pointer to the buffer where the CAN frame is copied
+ *
+ * @notapi
+ */
+static void can_receive(CANDriver *canp, canmbx_t mailbox, CANRxFrame *crfp) {
+
+#if CAN_RX_FIFO_SIZE > 0
+  (void)mailbox;
+  *crfp = canp->rxfifo[canp->rxrdidx];
+  if (++canp->rxrdidx >= CAN_RX_FIFO_SIZE)
+    canp->rxrdidx = 0;
+  canp->rxcnt--;
+#else
+  can_lld_receive(canp, mailbox, crfp);
+#endif
+}
+
+#if (CAN_TX_QUEUE_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Moves the queued frames into the free transmit mailboxes.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ *
+ * @notapi
+ */
+static void can_tx_queue_move(CANDriver *canp) {
+
+  while ((canp->txcnt > 0) && (canp->state == CAN_READY) &&
+         can_lld_is_tx_empty(canp, CAN_ANY_MAILBOX)) {
+    can_lld_transmit(canp, CAN_ANY_MAILBOX, &canp->txqueue[canp->txrdidx]);
+    if (++canp->txrdidx >= CAN_TX_QUEUE_SIZE)
+      canp->txrdidx = 0;
+    canp->txcnt--;
+  }
+}
+#endif /* CAN_TX_QUEUE_SIZE > 0 */
+
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Hash table index of a masked identifier.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[in] group     index of the mask the identifier belongs to
+ * @param[in] key       masked identifier
+ * @return              The hash table index.
+ *
+ * @notapi
+ */
+static unsigned filters_hash(CANFilterSet *fsp, unsigned group, uint32_t key) {
+
+  key ^= (uint32_t)group * 0x85EBCA6BU;
+  return (unsigned)((key * 0x9E3779B1U) >> (32 - fsp->order));
+}
+
+/**
+ * @brief   Number of identifiers accepted by a mask.
+ *
+ * @param[in] fmp       pointer to the @p CANFilterMask object
+ * @return              The number of accepted identifiers.
+ *
+ * @notapi
+ */
+static uint32_t filters_accepted(const CANFilterMask *fmp) {
+  uint32_t m = fmp->mask;
+  unsigned bits;
+
+  if (fmp->ide == CAN_FILTER_IDE_ANY)
+    return 0x80000000U;
+  bits = FILTERS_ID_BITS(fmp->ide);
+  while (m != 0) {
+    bits--;
+    m &= m - 1;
+  }
+  return 1U << bits;
+}
+
+/**
+ * @brief   Determines whether a mask accepts all the identifiers accepted
+ *          by another mask.
+ *
+ * @param[in] fmp1      pointer to the covering @p CANFilterMask object
+ * @param[in] fmp2      pointer to the covered @p CANFilterMask object
+ * @return              The coverage state.
+ *
+ * @notapi
+ */
+static bool_t filters_covers(const CANFilterMask *fmp1,
+                             const CANFilterMask *fmp2) {
+
+  if (fmp1->ide == CAN_FILTER_IDE_ANY)
+    return TRUE;
+  return (fmp1->ide == fmp2->ide) &&
+         ((fmp1->mask & ~fmp2->mask) == 0) &&
+         ((fmp2->id & fmp1->mask) == fmp1->id);
+}
+
+/**
+ * @brief   Computes the narrowest mask covering two masks.
+ *
+ * @param[out] fmp      pointer to the resulting @p CANFilterMask object
+ * @param[in] fmp1      pointer to the first @p CANFilterMask object
+ * @param[in] fmp2      pointer to the second @p CANFilterMask object
+ *
+ * @notapi
+ */
+static void filters_merge(CANFilterMask *fmp,
+                          const CANFilterMask *fmp1,
+                          const CANFilterMask *fmp2) {
+
+  if ((fmp1->ide != fmp2->ide) || (fmp1->ide == CAN_FILTER_IDE_ANY)) {
+    fmp->id = 0;
+    fmp->mask = 0;
+    fmp->ide = CAN_FILTER_IDE_ANY;
+    return;
+  }
+  fmp->mask = fmp1->mask & fmp2->mask & ~(fmp1->id ^ fmp2->id);
+  fmp->id = fmp1->id & fmp->mask;
+  fmp->ide = fmp1->ide;
+}
+#endif /* CAN_USE_SOFTWARE_FILTERS */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -83,6 +269,7 @@ void canObjectInit(CANDriver *canp) {
   chEvtInit(&canp->sleep_event);
   chEvtInit(&canp->wakeup_event);
 #endif /* CAN_USE_SLEEP_MODE */
+  can_reset_queues(canp);
 }
 
 /**
@@ -132,6 +319,7 @@ void canStop(CANDriver *canp) {
               "canStop(), #1", "invalid state");
   can_lld_stop(canp);
   canp->state  = CAN_STOP;
+  can_reset_queues(canp);
   chSemResetI(&canp->rxsem, 0);
   chSemResetI(&canp->txsem, 0);
   chSchRescheduleS();
@@ -142,6 +330,10 @@ void canStop(CANDriver *canp) {
  * @brief   Can frame transmission.
  * @details The specified frame is queued for transmission, if the hardware
  *          queue is full then the invoking thread is queued.
+ * @note    If @p CAN_TX_QUEUE_SIZE is greater than zero then the frames
+ *          transmitted on @p CAN_ANY_MAILBOX are placed in the software
+ *          transmit queue and the invoking thread is queued only if the
+ *          software queue is full.
  * @note    Trying to transmit while in sleep mode simply enqueues the thread.
  *
  * @param[in] canp      pointer to the @p CANDriver object
@@ -170,6 +362,24 @@ msg_t canTransmit(CANDriver *canp,
   chSysLock();
   chDbgAssert((canp->state == CAN_READY) || (canp->state == CAN_SLEEP),
               "canTransmit(), #1", "invalid state");
+#if CAN_TX_QUEUE_SIZE > 0
+  if (mailbox == CAN_ANY_MAILBOX) {
+    while ((canp->state == CAN_SLEEP) || (canp->txcnt >= CAN_TX_QUEUE_SIZE)) {
+      msg_t msg = chSemWaitTimeoutS(&canp->txsem, timeout);
+      if (msg != RDY_OK) {
+        chSysUnlock();
+        return msg;
+      }
+    }
+    canp->txqueue[canp->txwridx] = *ctfp;
+    if (++canp->txwridx >= CAN_TX_QUEUE_SIZE)
+      canp->txwridx = 0;
+    canp->txcnt++;
+    can_tx_queue_move(canp);
+    chSysUnlock();
+    return RDY_OK;
+  }
+#endif /* CAN_TX_QUEUE_SIZE > 0 */
   while ((canp->state == CAN_SLEEP) || !can_lld_is_tx_empty(canp, mailbox)) {
     msg_t msg = chSemWaitTimeoutS(&canp->txsem, timeout);
     if (msg != RDY_OK) {
@@ -185,6 +395,10 @@ msg_t canTransmit(CANDriver *canp,
 /**
  * @brief   Can frame receive.
  * @details The function waits until a frame is received.
+ * @note    If @p CAN_RX_FIFO_SIZE is greater than zero then the frames are
+ *          fetched from the software receive FIFO, the frames of all the
+ *          receive mailboxes are merged and @p mailbox must be
+ *          @p CAN_ANY_MAILBOX.
  * @note    Trying to receive while in sleep mode simply enqueues the thread.
  *
  * @param[in] canp      pointer to the @p CANDriver object
@@ -209,24 +423,81 @@ msg_t canReceive(CANDriver *canp,
                  CANRxFrame *crfp,
                  systime_t timeout) {
 
-  chDbgCheck((canp != NULL) && (crfp != NULL) && (mailbox < CAN_RX_MAILBOXES),
+  chDbgCheck((canp != NULL) && (crfp != NULL) && (mailbox < CAN_RX_MAILBOXES) &&
+             ((CAN_RX_FIFO_SIZE == 0) || (mailbox == CAN_ANY_MAILBOX)),
              "canReceive");
 
   chSysLock();
   chDbgAssert((canp->state == CAN_READY) || (canp->state == CAN_SLEEP),
               "canReceive(), #1", "invalid state");
-  while ((canp->state == CAN_SLEEP) || !can_lld_is_rx_nonempty(canp, mailbox)) {
+  while ((canp->state == CAN_SLEEP) || !can_is_rx_nonempty(canp, mailbox)) {
     msg_t msg = chSemWaitTimeoutS(&canp->rxsem, timeout);
     if (msg != RDY_OK) {
       chSysUnlock();
       return msg;
     }
   }
-  can_lld_receive(canp, mailbox, crfp);
+  can_receive(canp, mailbox, crfp);
   chSysUnlock();
   return RDY_OK;
 }
 
+/**
+ * @brief   Can frames batch receive.
+ * @details The function waits until at least a frame is received then
+ *          fetches all the available frames, up to @p n, in a single
+ *          critical section.
+ * @note    If @p CAN_RX_FIFO_SIZE is greater than zero then the frames are
+ *          fetched from the software receive FIFO, the frames of all the
+ *          receive mailboxes are merged and @p mailbox must be
+ *          @p CAN_ANY_MAILBOX.
+ * @note    The critical section duration is proportional to @p n.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   mailbox number, @p CAN_ANY_MAILBOX for any mailbox
+ * @param[out] crfp     pointer to the array where the CAN frames are copied
+ * @param[in] n         maximum number of frames to be fetched
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of frames fetched, zero if the operation
+ *                      timed out or if the driver has been stopped while
+ *                      waiting.
+ *
+ * @api
+ */
+size_t canReceiveBatch(CANDriver *canp,
+                       canmbx_t mailbox,
+                       CANRxFrame *crfp,
+                       size_t n,
+                       systime_t timeout) {
+  size_t i;
+
+  chDbgCheck((canp != NULL) && (crfp != NULL) && (n > 0) &&
+             (mailbox < CAN_RX_MAILBOXES) &&
+             ((CAN_RX_FIFO_SIZE == 0) || (mailbox == CAN_ANY_MAILBOX)),
+             "canReceiveBatch");
+
+  chSysLock();
+  chDbgAssert((canp->state == CAN_READY) || (canp->state == CAN_SLEEP),
+              "canReceiveBatch(), #1", "invalid state");
+  while ((canp->state == CAN_SLEEP) || !can_is_rx_nonempty(canp, mailbox)) {
+    if (chSemWaitTimeoutS(&canp->rxsem, timeout) != RDY_OK) {
+      chSysUnlock();
+      return 0;
+    }
+  }
+  i = 0;
+  do {
+    can_receive(canp, mailbox, crfp++);
+    i++;
+  } while ((i < n) && can_is_rx_nonempty(canp, mailbox));
+  chSysUnlock();
+  return i;
+}
+
 #if CAN_USE_SLEEP_MODE || defined(__DOXYGEN__)
 /**
  * @brief   Enters the sleep mode.
@@ -280,6 +551,393 @@ void canWakeup(CANDriver *canp) {
 }
 #endif /* CAN_USE_SLEEP_MODE */
 
+#if (CAN_RX_FIFO_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Receive ISR code.
+ * @details This function must be invoked by the low level driver receive
+ *          ISR, the frames are moved from the hardware mailbox into the
+ *          software FIFO, the waiting threads are awakened and the
+ *          @p rxfull_event is broadcasted if the FIFO was empty. If the
+ *          FIFO is full then the frames are discarded and the
+ *          @p error_event is broadcasted with @p CAN_OVERFLOW_ERROR.
+ * @pre     The option @p CAN_RX_FIFO_SIZE must be greater than zero.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] mailbox   receive mailbox number
+ *
+ * @notapi
+ */
+void _can_rx_fifo_fill(CANDriver *canp, canmbx_t mailbox) {
+  CANRxFrame discarded;
+  bool_t empty, overflow = FALSE;
+
+  chSysLockFromIsr();
+  empty = canp->rxcnt == 0;
+  while (can_lld_is_rx_nonempty(canp, mailbox)) {
+    if (canp->rxcnt >= CAN_RX_FIFO_SIZE) {
+      can_lld_receive(canp, mailbox, &discarded);
+      canp->rxoverflows++;
+      overflow = TRUE;
+      continue;
+    }
+    can_lld_receive(canp, mailbox, &canp->rxfifo[canp->rxwridx]);
+    if (++canp->rxwridx >= CAN_RX_FIFO_SIZE)
+      canp->rxwridx = 0;
+    canp->rxcnt++;
+  }
+  if (canp->rxcnt > 0) {
+    while (chSemGetCounterI(&canp->rxsem) < 0)
+      chSemSignalI(&canp->rxsem);
+    if (empty)
+      chEvtBroadcastFlagsI(&canp->rxfull_event, CAN_MAILBOX_TO_MASK(mailbox));
+  }
+  if (overflow)
+    chEvtBroadcastFlagsI(&canp->error_event, CAN_OVERFLOW_ERROR);
+  chSysUnlockFromIsr();
+}
+#endif /* CAN_RX_FIFO_SIZE > 0 */
+
+#if (CAN_TX_QUEUE_SIZE > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Transmit ISR code.
+ * @details This function must be invoked by the low level driver transmit
+ *          ISR, the queued frames are moved into the free mailboxes, the
+ *          waiting threads are awakened and the @p txempty_event is
+ *          broadcasted when the software queue has space.
+ * @pre     The option @p CAN_TX_QUEUE_SIZE must be greater than zero.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] flags     mask of the transmit mailboxes become empty
+ *
+ * @notapi
+ */
+void _can_tx_queue_flush(CANDriver *canp, flagsmask_t flags) {
+
+  chSysLockFromIsr();
+  can_tx_queue_move(canp);
+  if (canp->txcnt < CAN_TX_QUEUE_SIZE) {
+    while (chSemGetCounterI(&canp->txsem) < 0)
+      chSemSignalI(&canp->txsem);
+    chEvtBroadcastFlagsI(&canp->txempty_event, flags);
+  }
+  chSysUnlockFromIsr();
+}
+#endif /* CAN_TX_QUEUE_SIZE > 0 */
+
+#if CAN_USE_SOFTWARE_FILTERS || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a @p CANFilterSet object.
+ * @details The frames array is used as a pool for the frames posted to the
+ *          rules mailboxes, it can be @p NULL if no rule has a mailbox.
+ *
+ * @param[out] fsp      pointer to the @p CANFilterSet object
+ * @param[in] frames    pointer to the frames pool storage or @p NULL
+ * @param[in] n         number of frames in the pool storage
+ *
+ * @init
+ */
+void canFiltersObjectInit(CANFilterSet *fsp, CANRxFrame *frames, size_t n) {
+
+  chDbgCheck(fsp != NULL, "canFiltersObjectInit");
+
+  fsp->rules = NULL;
+  fsp->n = 0;
+  fsp->slots = NULL;
+  fsp->order = 0;
+  fsp->nmasks = 0;
+  fsp->unmatched = 0;
+  fsp->dropped = 0;
+  chPoolInit(&fsp->pool, sizeof (CANRxFrame), NULL);
+  if (frames != NULL)
+    chPoolLoadArray(&fsp->pool, frames, n);
+}
+
+/**
+ * @brief   Compiles a set of rules.
+ * @details The rules are grouped by mask and identifier type, each group
+ *          is indexed in a shared open addressing hash table keyed by the
+ *          masked identifier. A lookup costs one hash probe for each
+ *          distinct mask regardless of the number of rules. When more
+ *          rules match a frame the one with the lowest index has priority,
+ *          exactly as in a linear scan of the rules array.
+ * @note    The rules array and the table are not copied, they must stay
+ *          valid while the filters set is in use.
+ * @note    The rules set must not be replaced while a lookup or dispatch
+ *          operation is in progress.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[in] rules     pointer to the rules array
+ * @param[in] n         number of rules
+ * @param[in] slots     pointer to the hash table storage
+ * @param[in] nslots    number of hash table slots, it must be a power of two
+ *                      greater than @p n, twice @p n keeps the probe chains
+ *                      short
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the rules have been compiled.
+ * @retval CH_FAILED    the rules have more than @p CAN_FILTERS_MAX_MASKS
+ *                      distinct masks.
+ *
+ * @api
+ */
+bool_t canFiltersCompile(CANFilterSet *fsp,
+                         const CANFilterRule *rules,
+                         size_t n,
+                         uint16_t *slots,
+                         size_t nslots) {
+  size_t i;
+  unsigned g;
+
+  chDbgCheck((fsp != NULL) && ((rules != NULL) || (n == 0)) &&
+             (n < FILTERS_EMPTY_SLOT) && (slots != NULL) && (nslots > n) &&
+             (nslots >= 2) && ((nslots & (nslots - 1)) == 0),
+             "canFiltersCompile");
+
+  fsp->rules = rules;
+  fsp->n = 0;
+  fsp->slots = slots;
+  fsp->nmasks = 0;
+  for (fsp->order = 0; (1U << fsp->order) < nslots; fsp->order++)
+    ;
+  for (i = 0; i < nslots; i++)
+    slots[i] = FILTERS_EMPTY_SLOT;
+
+  for (i = 0; i < n; i++) {
+    const CANFilterRule *rp = &rules[i];
+    uint32_t mask, key;
+    unsigned h;
+
+    chDbgCheck(rp->ide <= 1, "canFiltersCompile");
+
+    /* Finding or creating the rule group.*/
+    mask = rp->mask & FILTERS_ID_MASK(rp->ide);
+    for (g = 0; g < fsp->nmasks; g++) {
+      if ((fsp->masks[g].mask == mask) && (fsp->masks[g].ide == rp->ide))
+        break;
+    }
+    if (g == fsp->nmasks) {
+      if (fsp->nmasks >= CAN_FILTERS_MAX_MASKS) {
+        fsp->nmasks = 0;
+        return CH_FAILED;
+      }
+      fsp->masks[g].id = 0;
+      fsp->masks[g].mask = mask;
+      fsp->masks[g].ide = rp->ide;
+      fsp->nmasks++;
+    }
+
+    /* Inserting the rule, a rule with the same group and key already in
+       the table shadows this one.*/
+    key = rp->id & mask;
+    h = filters_hash(fsp, g, key);
+    while (slots[h] != FILTERS_EMPTY_SLOT) {
+      const CANFilterRule *orp = &rules[slots[h]];
+      if ((orp->ide == rp->ide) &&
+          ((orp->mask & FILTERS_ID_MASK(orp->ide)) == mask) &&
+          ((orp->id & mask) == key))
+        break;
+      h = (h + 1) & (nslots - 1);
+    }
+    if (slots[h] == FILTERS_EMPTY_SLOT)
+      slots[h] = (uint16_t)i;
+  }
+  fsp->n = n;
+  return CH_SUCCESS;
+}
+
+/**
+ * @brief   Finds the rule matching a frame.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[in] crfp      pointer to the received frame
+ * @return              The matching rule with the lowest index.
+ * @retval NULL         if no rule matches the frame.
+ *
+ * @api
+ */
+const CANFilterRule *canFiltersLookup(CANFilterSet *fsp,
+                                      const CANRxFrame *crfp) {
+  size_t best = FILTERS_EMPTY_SLOT;
+  uint8_t ide;
+  uint32_t id;
+  unsigned g, mask;
+
+  chDbgCheck((fsp != NULL) && (crfp != NULL), "canFiltersLookup");
+
+  ide = crfp->IDE;
+  id = ide ? crfp->EID : crfp->SID;
+  mask = (1U << fsp->order) - 1;
+  for (g = 0; g < fsp->nmasks; g++) {
+    const CANFilterMask *fmp = &fsp->masks[g];
+    uint32_t key;
+    unsigned h;
+
+    if (fmp->ide != ide)
+      continue;
+    key = id & fmp->mask;
+    h = filters_hash(fsp, g, key);
+    while (fsp->slots[h] != FILTERS_EMPTY_SLOT) {
+      const CANFilterRule *rp = &fsp->rules[fsp->slots[h]];
+      if ((rp->ide == ide) &&
+          ((rp->mask & FILTERS_ID_MASK(ide)) == fmp->mask) &&
+          ((rp->id & fmp->mask) == key)) {
+        if (fsp->slots[h] < best)
+          best = fsp->slots[h];
+        break;
+      }
+      h = (h + 1) & mask;
+    }
+  }
+  return best < fsp->n ? &fsp->rules[best] : NULL;
+}
+
+/**
+ * @brief   Routes a frame to the matching rule.
+ * @details If the matching rule has a mailbox then a copy of the frame is
+ *          allocated from the pool and posted to the mailbox without
+ *          waiting, if the pool or the mailbox are full then the frame is
+ *          dropped and counted. If the rule has a callback then the
+ *          callback is invoked after posting the frame.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[in] crfp      pointer to the received frame
+ * @return              The matching rule.
+ * @retval NULL         if no rule matches the frame.
+ *
+ * @api
+ */
+const CANFilterRule *canFiltersDispatch(CANFilterSet *fsp,
+                                        const CANRxFrame *crfp) {
+  const CANFilterRule *rp;
+
+  rp = canFiltersLookup(fsp, crfp);
+  if (rp == NULL) {
+    chSysLock();
+    fsp->unmatched++;
+    chSysUnlock();
+    return NULL;
+  }
+  if (rp->mbp != NULL) {
+    CANRxFrame *fp;
+
+    chSysLock();
+    fp = chPoolAllocI(&fsp->pool);
+    if (fp == NULL)
+      fsp->dropped++;
+    else {
+      *fp = *crfp;
+      if (chMBPostI(rp->mbp, (msg_t)fp) != RDY_OK) {
+        chPoolFreeI(&fsp->pool, fp);
+        fsp->dropped++;
+      }
+      else
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+  }
+  if (rp->cb != NULL)
+    rp->cb(rp, crfp);
+  return rp;
+}
+
+/**
+ * @brief   Returns a frame fetched from a rule mailbox to the pool.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[in] crfp      pointer to the frame
+ *
+ * @api
+ */
+void canFiltersReleaseFrame(CANFilterSet *fsp, CANRxFrame *crfp) {
+
+  chDbgCheck((fsp != NULL) && (crfp != NULL), "canFiltersReleaseFrame");
+
+  chPoolFree(&fsp->pool, crfp);
+}
+
+/**
+ * @brief   Computes a set of hardware filters covering the rules.
+ * @details The result is a list of at most @p max identifier/mask pairs
+ *          accepting all the frames matched by the rules. When the rules
+ *          do not fit the available hardware filters the pairs are merged
+ *          greedily choosing, each time, the merge adding the lowest
+ *          number of accepted identifiers. The frames accepted by the
+ *          hardware but not matching any rule are then discarded by
+ *          @p canFiltersDispatch().
+ * @note    The result must be translated into the controller specific
+ *          filters format, see the low level driver documentation.
+ *
+ * @param[in] fsp       pointer to the @p CANFilterSet object
+ * @param[out] fmp      pointer to the array of @p CANFilterMask objects
+ * @param[in] max       number of available hardware filters
+ * @return              The number of used filters.
+ *
+ * @api
+ */
+size_t canFiltersCover(CANFilterSet *fsp, CANFilterMask *fmp, size_t max) {
+  size_t i, j, k, count = 0;
+
+  chDbgCheck((fsp != NULL) && (fmp != NULL) && (max > 0), "canFiltersCover");
+
+  for (i = 0; i < fsp->n; i++) {
+    const CANFilterRule *rp = &fsp->rules[i];
+    CANFilterMask f, m;
+    uint32_t cost, best = 0xFFFFFFFFU;
+    size_t bi = 0, bj = 0;
+
+    f.mask = rp->mask & FILTERS_ID_MASK(rp->ide);
+    f.id = rp->id & f.mask;
+    f.ide = rp->ide;
+
+    /* Skipping rules already covered.*/
+    for (j = 0; j < count; j++) {
+      if (filters_covers(&fmp[j], &f))
+        break;
+    }
+    if (j < count)
+      continue;
+
+    /* Removing the filters covered by the new one.*/
+    for (j = 0, k = 0; j < count; j++) {
+      if (!filters_covers(&f, &fmp[j]))
+        fmp[k++] = fmp[j];
+    }
+    count = k;
+    if (count < max) {
+      fmp[count++] = f;
+      continue;
+    }
+
+    /* No free filters, merging the pair with the lowest cost, the new
+       filter is the element at index count.*/
+    for (j = 0; j < count; j++) {
+      for (k = j + 1; k <= count; k++) {
+        const CANFilterMask *bp = k < count ? &fmp[k] : &f;
+        filters_merge(&m, &fmp[j], bp);
+        cost = filters_accepted(&fmp[j]) + filters_accepted(bp);
+        cost = filters_accepted(&m) > cost ? filters_accepted(&m) - cost : 0;
+        if (cost < best) {
+          best = cost;
+          bi = j;
+          bj = k;
+        }
+      }
+    }
+    filters_merge(&m, &fmp[bi], bj < count ? &fmp[bj] : &f);
+    if (bj < count)
+      fmp[bj] = f;
+    fmp[bi] = m;
+
+    /* The merged filter could cover other filters.*/
+    for (j = 0, k = 0; j < count; j++) {
+      if ((j == bi) || !filters_covers(&m, &fmp[j]))
+        fmp[k++] = fmp[j];
+    }
+    count = k;
+  }
+  return count;
+}
+#endif /* CAN_USE_SOFTWARE_FILTERS */
+
 #endif /* HAL_USE_CAN */
 
 /** @} */
@@ -89,6 +89,9 @@ void halInit(void) {
 #if HAL_USE_I2C || defined(__DOXYGEN__)
   i2cInit();
 #endif
+#if HAL_USE_I2S || defined(__DOXYGEN__)
+  i2sInit();
+#endif
 #if HAL_USE_ICU || defined(__DOXYGEN__)
   icuInit();
 #endif
@@ -119,6 +122,9 @@ void halInit(void) {
 #if HAL_USE_SERIAL_USB || defined(__DOXYGEN__)
   sduInit();
 #endif
+#if HAL_USE_SERIAL_UART || defined(__DOXYGEN__)
+  sduartInit();
+#endif
 #if HAL_USE_RTC || defined(__DOXYGEN__)
   rtcInit();
 #endif
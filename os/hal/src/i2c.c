@@ -50,6 +50,22 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Starts the transaction at the head of the queue.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ *
+ * @notapi
+ */
+static void i2c_queue_start(I2CDriver *i2cp) {
+
+  i2cp->errors = I2CD_NO_ERROR;
+  i2cp->state = i2cp->qhead->txbytes > 0 ? I2C_ACTIVE_TX : I2C_ACTIVE_RX;
+  i2c_lld_start_transaction(i2cp, i2cp->qhead);
+}
+#endif /* I2C_USE_QUEUE */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -85,6 +101,13 @@ void i2cObjectInit(I2CDriver *i2cp) {
 #endif /* CH_USE_MUTEXES */
 #endif /* I2C_USE_MUTUAL_EXCLUSION */
 
+#if I2C_USE_QUEUE
+  i2cp->qhead = NULL;
+  i2cp->qtail = NULL;
+  chSemInit(&i2cp->qsem, 0);
+  chEvtInit(&i2cp->queue_event);
+#endif /* I2C_USE_QUEUE */
+
 #if defined(I2C_DRIVER_EXT_INIT_HOOK)
   I2C_DRIVER_EXT_INIT_HOOK(i2cp);
 #endif
@@ -298,6 +321,141 @@ void i2cReleaseBus(I2CDriver *i2cp) {
 }
 #endif /* I2C_USE_MUTUAL_EXCLUSION */
 
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Appends transactions to the queue.
+ * @details The transactions are executed in order and back to back by the
+ *          driver, if the queue was empty the first transaction is
+ *          started immediately. After each transaction its status is
+ *          updated and its callback, if any, is invoked from the ISR
+ *          context. A failed transaction does not stop the queue. When
+ *          the queue becomes empty the waiting threads are awakened and
+ *          the @p queue_event is broadcasted.
+ * @note    The transactions must not be modified while queued, they can
+ *          be submitted again from their own callback.
+ * @note    The blocking transfer APIs must not be used while the queue
+ *          is not empty.
+ * @note    The queue does not implement timeouts, the underlying
+ *          implementation is responsible for terminating the transactions
+ *          on a stuck bus.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] itp       pointer to an array of transactions
+ * @param[in] n         number of transactions in the array
+ *
+ * @iclass
+ */
+void i2cQueueSubmitI(I2CDriver *i2cp, I2CTransaction *itp, size_t n) {
+  bool_t empty;
+  size_t i;
+
+  chDbgCheckClassI();
+  chDbgCheck((i2cp != NULL) && (itp != NULL) && (n > 0), "i2cQueueSubmitI");
+  chDbgAssert((i2cp->state == I2C_READY) || (i2cp->qhead != NULL),
+              "i2cQueueSubmitI(), #1", "not ready");
+
+  for (i = 0; i < n; i++) {
+    chDbgCheck((itp[i].addr != 0) &&
+               ((itp[i].txbytes > 0) || (itp[i].rxbytes > 0)) &&
+               ((itp[i].txbytes == 0) || (itp[i].txbuf != NULL)) &&
+               ((itp[i].rxbytes == 0) || (itp[i].rxbuf != NULL)),
+               "i2cQueueSubmitI");
+    itp[i].next = i + 1 < n ? &itp[i + 1] : NULL;
+    itp[i].status = I2C_TRANSACTION_PENDING;
+    itp[i].errors = I2CD_NO_ERROR;
+  }
+  empty = i2cp->qhead == NULL;
+  if (empty)
+    i2cp->qhead = itp;
+  else
+    i2cp->qtail->next = itp;
+  i2cp->qtail = &itp[n - 1];
+  if (empty)
+    i2c_queue_start(i2cp);
+}
+
+/**
+ * @brief   Appends transactions to the queue.
+ * @details See @p i2cQueueSubmitI().
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] itp       pointer to an array of transactions
+ * @param[in] n         number of transactions in the array
+ *
+ * @api
+ */
+void i2cQueueSubmit(I2CDriver *i2cp, I2CTransaction *itp, size_t n) {
+
+  chSysLock();
+  i2cQueueSubmitI(i2cp, itp, n);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Waits for the transactions queue to become empty.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the queue is empty.
+ * @retval RDY_TIMEOUT  if the queue is still not empty after the
+ *                      specified time.
+ *
+ * @api
+ */
+msg_t i2cQueueWait(I2CDriver *i2cp, systime_t timeout) {
+  msg_t msg = RDY_OK;
+
+  chDbgCheck(i2cp != NULL, "i2cQueueWait");
+
+  chSysLock();
+  if (i2cp->qhead != NULL)
+    msg = chSemWaitTimeoutS(&i2cp->qsem, timeout);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Transaction completion ISR code.
+ * @details This function must be invoked by the low level driver when the
+ *          transaction at the head of the queue is complete, the next
+ *          transaction is started before invoking the completion callback
+ *          in order to keep the bus busy.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] msg       transaction status, @p RDY_OK or @p RDY_RESET, the
+ *                      errors are taken from the driver errors mask
+ *
+ * @notapi
+ */
+void _i2c_queue_complete(I2CDriver *i2cp, msg_t msg) {
+  I2CTransaction *itp;
+
+  chSysLockFromIsr();
+  itp = i2cp->qhead;
+  itp->errors = i2cp->errors;
+  itp->status = msg;
+  i2cp->qhead = itp->next;
+  if (i2cp->qhead != NULL)
+    i2c_queue_start(i2cp);
+  else {
+    i2cp->qtail = NULL;
+    i2cp->state = I2C_READY;
+    while (chSemGetCounterI(&i2cp->qsem) < 0)
+      chSemSignalI(&i2cp->qsem);
+    chEvtBroadcastI(&i2cp->queue_event);
+  }
+  chSysUnlockFromIsr();
+
+  if (itp->callback != NULL)
+    itp->callback(i2cp, itp);
+}
+#endif /* I2C_USE_QUEUE */
+
 #endif /* HAL_USE_I2C */
 
 /** @} */
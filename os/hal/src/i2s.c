@@ -74,6 +74,7 @@ void i2sObjectInit(I2SDriver *i2sp) {
 
   i2sp->state  = I2S_STOP;
   i2sp->config = NULL;
+  _i2s_reset_accounting(i2sp);
 }
 
 /**
@@ -125,7 +126,7 @@ void i2sStop(I2SDriver *i2sp) {
  */
 void i2sStartExchange(I2SDriver *i2sp) {
 
-  chDbgCheck(i2sp != NULL "i2sStartExchange");
+  chDbgCheck(i2sp != NULL, "i2sStartExchange");
 
   chSysLock();
   chDbgAssert(i2sp->state == I2S_READY,
@@ -143,7 +144,7 @@ void i2sStartExchange(I2SDriver *i2sp) {
  */
 void i2sStartExchangeContinuous(I2SDriver *i2sp) {
 
-  chDbgCheck(i2sp != NULL "i2sStartExchangeContinuous");
+  chDbgCheck(i2sp != NULL, "i2sStartExchangeContinuous");
 
   chSysLock();
   chDbgAssert(i2sp->state == I2S_READY,
@@ -174,6 +175,26 @@ void i2sStopExchange(I2SDriver *i2sp) {
   chSysUnlock();
 }
 
+/**
+ * @brief   Releases the last half buffer notified by the callback.
+ * @details In continuous mode the application must release each half
+ *          buffer after having refilled and/or read it, an half buffer
+ *          reused by the hardware before being released is accounted as
+ *          an underrun if transmitting and as an overrun if receiving.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @api
+ */
+void i2sReleaseBuffer(I2SDriver *i2sp) {
+
+  chDbgCheck(i2sp != NULL, "i2sReleaseBuffer");
+
+  chSysLock();
+  i2sReleaseBufferI(i2sp);
+  chSysUnlock();
+}
+
 #endif /* HAL_USE_I2S */
 
 /** @} */
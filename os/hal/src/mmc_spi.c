@@ -36,10 +36,19 @@
 
 #if HAL_USE_MMC_SPI || defined(__DOXYGEN__)
 
+#if MMC_USE_CRC_LIBRARY
+#include "crc.h"
+#endif
+
 /*===========================================================================*/
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+#if MMC_USE_CRC_LIBRARY
+#define crc7(crc, buffer, len)      crc7Update(crc, buffer, len)
+#define crc16(crc, buffer, len)     crc16Update(crc, buffer, len)
+#endif
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -68,6 +77,7 @@ static const struct MMCDriverVMT mmc_vmt = {
   (bool_t (*)(void *, BlockDeviceInfo *))mmcGetInfo
 };
 
+#if !MMC_USE_CRC_LIBRARY || defined(__DOXYGEN__)
 /**
  * @brief   Lookup table for CRC-7 ( based on polynomial x^7 + x^3 + 1).
  */
@@ -96,6 +106,47 @@ static const uint8_t crc7_lookup_table[256] = {
   0x62, 0x6b, 0x70, 0x79
 };
 
+#if MMC_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief   Lookup table for CRC-16 (based on polynomial x^16 + x^12 + x^5 + 1).
+ */
+static const uint16_t crc16_lookup_table[256] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+  0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+  0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+  0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+  0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+  0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+  0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+  0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+  0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+  0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+  0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+  0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+  0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+  0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+  0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+  0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+  0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+  0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+  0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+  0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+  0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+  0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+  0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+  0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+  0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+  0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+  0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+  0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+  0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+  0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+  0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+  0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
+};
+#endif /* MMC_USE_CRC */
+#endif /* !MMC_USE_CRC_LIBRARY */
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
@@ -105,12 +156,8 @@ static bool_t mmc_read(void *instance, uint32_t startblk,
 
   if (mmcStartSequentialRead((MMCDriver *)instance, startblk))
     return CH_FAILED;
-  while (n > 0) {
-    if (mmcSequentialRead((MMCDriver *)instance, buffer))
-      return CH_FAILED;
-    buffer += MMCSD_BLOCK_SIZE;
-    n--;
-  }
+  if (mmcSequentialReadBlocks((MMCDriver *)instance, buffer, n, NULL))
+    return CH_FAILED;
   if (mmcStopSequentialRead((MMCDriver *)instance))
       return CH_FAILED;
   return CH_SUCCESS;
@@ -121,17 +168,14 @@ static bool_t mmc_write(void *instance, uint32_t startblk,
 
   if (mmcStartSequentialWrite((MMCDriver *)instance, startblk))
       return CH_FAILED;
-  while (n > 0) {
-      if (mmcSequentialWrite((MMCDriver *)instance, buffer))
-          return CH_FAILED;
-      buffer += MMCSD_BLOCK_SIZE;
-      n--;
-  }
+  if (mmcSequentialWriteBlocks((MMCDriver *)instance, buffer, n))
+      return CH_FAILED;
   if (mmcStopSequentialWrite((MMCDriver *)instance))
       return CH_FAILED;
   return CH_SUCCESS;
 }
 
+#if !MMC_USE_CRC_LIBRARY || defined(__DOXYGEN__)
 /**
  * @brief Calculate the MMC standard CRC-7 based on a lookup table.
  *
@@ -147,8 +191,44 @@ static uint8_t crc7(uint8_t crc, const uint8_t *buffer, size_t len) {
   return crc;
 }
 
+#if MMC_USE_CRC || defined(__DOXYGEN__)
+/**
+ * @brief Calculate the CRC-16 of a data block based on a lookup table.
+ *
+ * @param[in] crc       start value for CRC
+ * @param[in] buffer    pointer to data buffer
+ * @param[in] len       length of data
+ * @return              Calculated CRC
+ */
+static uint16_t crc16(uint16_t crc, const uint8_t *buffer, size_t len) {
+
+  while (len--)
+    crc = (crc << 8) ^ crc16_lookup_table[(crc >> 8) ^ (*buffer++)];
+  return crc;
+}
+#endif /* MMC_USE_CRC */
+#endif /* !MMC_USE_CRC_LIBRARY */
+
+/**
+ * @brief   Waits for the completion of an operation started asynchronously.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ *
+ * @notapi
+ */
+static void spi_sync(SPIDriver *spip) {
+
+  chSysLock();
+  if (spip->state == SPI_ACTIVE)
+    _spi_wait_s(spip);
+  chSysUnlock();
+}
+
 /**
  * @brief   Waits an idle condition.
+ * @details The bus is polled in bursts of @p MMC_POLL_BURST frames, the
+ *          card keeps the line low while busy so the busy condition is over
+ *          when the last frame of a burst is 0xFF.
  *
  * @param[in] mmcp      pointer to the @p MMCDriver object
  *
@@ -156,17 +236,17 @@ static uint8_t crc7(uint8_t crc, const uint8_t *buffer, size_t len) {
  */
 static void wait(MMCDriver *mmcp) {
   int i;
-  uint8_t buf[4];
+  uint8_t buf[MMC_POLL_BURST];
 
-  for (i = 0; i < 16; i++) {
-    spiReceive(mmcp->config->spip, 1, buf);
-    if (buf[0] == 0xFF)
+  for (i = 0; i < 16; i += MMC_POLL_BURST) {
+    spiReceive(mmcp->config->spip, MMC_POLL_BURST, buf);
+    if (buf[MMC_POLL_BURST - 1] == 0xFF)
       return;
   }
   /* Looks like it is a long wait.*/
   while (TRUE) {
-    spiReceive(mmcp->config->spip, 1, buf);
-    if (buf[0] == 0xFF)
+    spiReceive(mmcp->config->spip, MMC_POLL_BURST, buf);
+    if (buf[MMC_POLL_BURST - 1] == 0xFF)
       break;
 #ifdef MMC_NICE_WAITING
     /* Trying to be nice with the other threads.*/
@@ -201,6 +281,49 @@ static void send_hdr(MMCDriver *mmcp, uint8_t cmd, uint32_t arg) {
   spiSend(mmcp->config->spip, 6, buf);
 }
 
+/**
+ * @brief   Waits for a data start token.
+ * @details The bus is polled in bursts of @p MMC_POLL_BURST frames, the
+ *          data frames received after the token are stored in the buffer.
+ *
+ * @param[in] mmcp      pointer to the @p MMCDriver object
+ * @param[in] pre       frames already received, they are scanned first
+ * @param[in] pren      number of frames in @p pre
+ * @param[out] buffer   pointer to the block buffer
+ * @return              The number of data frames already stored in the
+ *                      buffer.
+ * @retval -1           if the token has not been received or the card
+ *                      returned an error token.
+ *
+ * @notapi
+ */
+static int recv_token(MMCDriver *mmcp, const uint8_t *pre, size_t pren,
+                      uint8_t *buffer) {
+  uint8_t buf[MMC_POLL_BURST];
+  unsigned i = 0;
+
+  while (TRUE) {
+    size_t k;
+
+    for (k = 0; k < pren; k++) {
+      if (pre[k] == 0xFE) {
+        k++;
+        memcpy(buffer, &pre[k], pren - k);
+        return (int)(pren - k);
+      }
+      /* Anything else than idle frames is an error token.*/
+      if (pre[k] != 0xFF)
+        return -1;
+    }
+    if (i >= MMC_WAIT_DATA)
+      return -1;
+    spiReceive(mmcp->config->spip, MMC_POLL_BURST, buf);
+    pre = buf;
+    pren = MMC_POLL_BURST;
+    i += MMC_POLL_BURST;
+  }
+}
+
 /**
  * @brief   Receives a single byte response.
  *
@@ -314,22 +437,28 @@ static bool_t read_CxD(MMCDriver *mmcp, uint8_t cmd, uint32_t cxd[4]) {
     spiReceive(mmcp->config->spip, 1, buf);
     if (buf[0] == 0xFE) {
       uint32_t *wp;
+      uint8_t crc[2];
 
       spiReceive(mmcp->config->spip, 16, buf);
+
+      /* CRC then end of transaction. */
+      spiReceive(mmcp->config->spip, 2, crc);
+      spiUnselect(mmcp->config->spip);
+#if MMC_USE_CRC
+      if (crc16(0, buf, 16) != (((uint16_t)crc[0] << 8) | crc[1]))
+        return CH_FAILED;
+#endif
+
       bp = buf;
       for (wp = &cxd[3]; wp >= cxd; wp--) {
         *wp = ((uint32_t)bp[0] << 24) | ((uint32_t)bp[1] << 16) |
               ((uint32_t)bp[2] << 8)  | (uint32_t)bp[3];
         bp += 4;
       }
-
-      /* CRC ignored then end of transaction. */
-      spiIgnore(mmcp->config->spip, 2);
-      spiUnselect(mmcp->config->spip);
-
       return CH_SUCCESS;
     }
   }
+  spiUnselect(mmcp->config->spip);
   return CH_FAILED;
 }
 
@@ -508,6 +637,12 @@ bool_t mmcConnect(MMCDriver *mmcp) {
   /* Initialization complete, full speed.*/
   spiStart(mmcp->config->spip, mmcp->config->hscfg);
 
+#if MMC_USE_CRC
+  /* Enabling the CRC checks on the card side, cards refusing the command
+     are accepted anyway, the read blocks CRC is verified on this side.*/
+  (void)send_command_R1(mmcp, MMCSD_CMD_CRC_ON_OFF, 1);
+#endif
+
   /* Setting block size.*/
   if (send_command_R1(mmcp, MMCSD_CMD_SET_BLOCKLEN,
                       MMCSD_BLOCK_SIZE) != 0x00)
@@ -620,25 +755,84 @@ bool_t mmcStartSequentialRead(MMCDriver *mmcp, uint32_t startblk) {
  * @api
  */
 bool_t mmcSequentialRead(MMCDriver *mmcp, uint8_t *buffer) {
-  int i;
 
   chDbgCheck((mmcp != NULL) && (buffer != NULL), "mmcSequentialRead");
 
+  return mmcSequentialReadBlocks(mmcp, buffer, 1, NULL);
+}
+
+/**
+ * @brief   Reads blocks within a sequential read operation.
+ * @details The transfer of each block is started asynchronously before
+ *          the previous block is verified and passed to the callback, so
+ *          the SPI transfer overlaps the CRC calculation and the consumer
+ *          processing. The CRC of each block is received together with the
+ *          first frames of the next block.
+ *
+ * @param[in] mmcp      pointer to the @p MMCDriver object
+ * @param[out] buffer   pointer to the read buffer, it must be large enough
+ *                      for @p n blocks
+ * @param[in] n         number of blocks to read
+ * @param[in] cb        callback invoked after each verified block, while
+ *                      the next block is being transferred, can be
+ *                      @p NULL
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the operation failed.
+ *
+ * @api
+ */
+bool_t mmcSequentialReadBlocks(MMCDriver *mmcp, uint8_t *buffer, uint32_t n,
+                               mmcreadcb_t cb) {
+  SPIDriver *spip;
+  uint8_t tail[2 + MMC_POLL_BURST];
+  int cnt;
+
+  chDbgCheck((mmcp != NULL) && (buffer != NULL) && (n > 0),
+             "mmcSequentialReadBlocks");
+
   if (mmcp->state != BLK_READING)
     return CH_FAILED;
 
-  for (i = 0; i < MMC_WAIT_DATA; i++) {
-    spiReceive(mmcp->config->spip, 1, buffer);
-    if (buffer[0] == 0xFE) {
-      spiReceive(mmcp->config->spip, MMCSD_BLOCK_SIZE, buffer);
-      /* CRC ignored. */
-      spiIgnore(mmcp->config->spip, 2);
-      return CH_SUCCESS;
+  spip = mmcp->config->spip;
+  if ((cnt = recv_token(mmcp, NULL, 0, buffer)) < 0)
+    goto failed;
+  spiStartReceive(spip, MMCSD_BLOCK_SIZE - cnt, buffer + cnt);
+  while (TRUE) {
+    size_t tn = n > 1 ? sizeof(tail) : 2;
+
+    /* Waiting for the block data then receiving its CRC, if another block
+       is required the same transfer also polls for the next data token.*/
+    spi_sync(spip);
+    spiReceive(spip, tn, tail);
+    if (--n > 0) {
+      if ((cnt = recv_token(mmcp, tail + 2, tn - 2,
+                            buffer + MMCSD_BLOCK_SIZE)) < 0)
+        goto failed;
+      spiStartReceive(spip, MMCSD_BLOCK_SIZE - cnt,
+                      buffer + MMCSD_BLOCK_SIZE + cnt);
     }
+
+    /* The current block is processed while the next one is transferred.*/
+#if MMC_USE_CRC
+    if (crc16(0, buffer, MMCSD_BLOCK_SIZE) !=
+        (((uint16_t)tail[0] << 8) | tail[1])) {
+      spi_sync(spip);
+      goto failed;
+    }
+#endif
+    if (cb != NULL)
+      cb(mmcp, buffer);
+    if (n == 0)
+      return CH_SUCCESS;
+    buffer += MMCSD_BLOCK_SIZE;
   }
-  /* Timeout.*/
-  spiUnselect(mmcp->config->spip);
-  spiStop(mmcp->config->spip);
+
+  /* Timeout or error.*/
+failed:
+  spiUnselect(spip);
+  spiStop(spip);
   mmcp->state = BLK_READY;
   return CH_FAILED;
 }
@@ -655,8 +849,9 @@ bool_t mmcSequentialRead(MMCDriver *mmcp, uint8_t *buffer) {
  * @api
  */
 bool_t mmcStopSequentialRead(MMCDriver *mmcp) {
+  /* CMD12 with its CRC, it is required if the card checks the CRC.*/
   static const uint8_t stopcmd[] = {0x40 | MMCSD_CMD_STOP_TRANSMISSION,
-                                    0, 0, 0, 0, 1, 0xFF};
+                                    0, 0, 0, 0, 0x61, 0xFF};
 
   chDbgCheck(mmcp != NULL, "mmcStopSequentialRead");
 
@@ -724,26 +919,69 @@ bool_t mmcStartSequentialWrite(MMCDriver *mmcp, uint32_t startblk) {
  * @api
  */
 bool_t mmcSequentialWrite(MMCDriver *mmcp, const uint8_t *buffer) {
-  static const uint8_t start[] = {0xFF, 0xFC};
-  uint8_t b[1];
 
   chDbgCheck((mmcp != NULL) && (buffer != NULL), "mmcSequentialWrite");
 
+  return mmcSequentialWriteBlocks(mmcp, buffer, 1);
+}
+
+/**
+ * @brief   Writes blocks within a sequential write operation.
+ * @details The data of each block is transmitted asynchronously while its
+ *          CRC is calculated, the CRC and the data response are exchanged
+ *          in a single transfer.
+ *
+ * @param[in] mmcp      pointer to the @p MMCDriver object
+ * @param[in] buffer    pointer to the write buffer
+ * @param[in] n         number of blocks to write
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   the operation succeeded.
+ * @retval CH_FAILED    the operation failed.
+ *
+ * @api
+ */
+bool_t mmcSequentialWriteBlocks(MMCDriver *mmcp, const uint8_t *buffer,
+                                uint32_t n) {
+  static const uint8_t start[] = {0xFF, 0xFC};
+  SPIDriver *spip;
+  uint8_t tail[3], resp[3];
+
+  chDbgCheck((mmcp != NULL) && (buffer != NULL) && (n > 0),
+             "mmcSequentialWriteBlocks");
+
   if (mmcp->state != BLK_WRITING)
     return CH_FAILED;
 
-  spiSend(mmcp->config->spip, sizeof(start), start);    /* Data prologue.   */
-  spiSend(mmcp->config->spip, MMCSD_BLOCK_SIZE, buffer);/* Data.            */
-  spiIgnore(mmcp->config->spip, 2);                     /* CRC ignored.     */
-  spiReceive(mmcp->config->spip, 1, b);
-  if ((b[0] & 0x1F) == 0x05) {
+  spip = mmcp->config->spip;
+  while (n > 0) {
+    spiSend(spip, sizeof(start), start);                /* Data prologue.   */
+    spiStartSend(spip, MMCSD_BLOCK_SIZE, buffer);       /* Data.            */
+#if MMC_USE_CRC
+    {
+      uint16_t crc = crc16(0, buffer, MMCSD_BLOCK_SIZE);
+      tail[0] = (uint8_t)(crc >> 8);
+      tail[1] = (uint8_t)crc;
+    }
+#else
+    tail[0] = 0xFF;
+    tail[1] = 0xFF;
+#endif
+    tail[2] = 0xFF;
+    spi_sync(spip);
+    spiExchange(spip, sizeof(tail), tail, resp);        /* CRC, response.   */
+    if ((resp[2] & 0x1F) != 0x05)
+      goto failed;
     wait(mmcp);
-    return CH_SUCCESS;
+    buffer += MMCSD_BLOCK_SIZE;
+    n--;
   }
+  return CH_SUCCESS;
 
   /* Error.*/
-  spiUnselect(mmcp->config->spip);
-  spiStop(mmcp->config->spip);
+failed:
+  spiUnselect(spip);
+  spiStop(spip);
   mmcp->state = BLK_READY;
   return CH_FAILED;
 }
@@ -849,6 +1087,10 @@ bool_t mmcErase(MMCDriver *mmcp, uint32_t startblk, uint32_t endblk) {
   /* Erase operation in progress.*/
   mmcp->state = BLK_WRITING;
 
+  /* (Re)starting the SPI in case it has been reprogrammed externally or
+     stopped by a previous failed operation.*/
+  spiStart(mmcp->config->spip, mmcp->config->hscfg);
+
   /* Handling command differences between HC and normal cards.*/
   if (!mmcp->block_addresses) {
     startblk *= MMCSD_BLOCK_SIZE;
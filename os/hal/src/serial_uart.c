@@ -0,0 +1,388 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    serial_uart.c
+ * @brief   Serial over UART Driver code.
+ *
+ * @addtogroup SERIAL_UART
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_SERIAL_UART || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Returns the @p SerialUARTDriver owning an UART driver.
+ * @note    The UART driver is configured using the @p UARTConfig structure
+ *          embedded in the @p SerialUARTDriver object.
+ */
+#define owner(uartp)                                                        \
+  ((SerialUARTDriver *)((uint8_t *)(uartp)->config -                        \
+                        offsetof(SerialUARTDriver, uartcfg)))
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/*
+ * Interface implementation.
+ */
+
+static size_t write(void *ip, const uint8_t *bp, size_t n) {
+
+  return chOQWriteTimeout(&((SerialUARTDriver *)ip)->oqueue, bp,
+                          n, TIME_INFINITE);
+}
+
+static size_t read(void *ip, uint8_t *bp, size_t n) {
+
+  return chIQReadTimeout(&((SerialUARTDriver *)ip)->iqueue, bp,
+                         n, TIME_INFINITE);
+}
+
+static msg_t put(void *ip, uint8_t b) {
+
+  return chOQPutTimeout(&((SerialUARTDriver *)ip)->oqueue, b, TIME_INFINITE);
+}
+
+static msg_t get(void *ip) {
+
+  return chIQGetTimeout(&((SerialUARTDriver *)ip)->iqueue, TIME_INFINITE);
+}
+
+static msg_t putt(void *ip, uint8_t b, systime_t timeout) {
+
+  return chOQPutTimeout(&((SerialUARTDriver *)ip)->oqueue, b, timeout);
+}
+
+static msg_t gett(void *ip, systime_t timeout) {
+
+  return chIQGetTimeout(&((SerialUARTDriver *)ip)->iqueue, timeout);
+}
+
+static size_t writet(void *ip, const uint8_t *bp, size_t n, systime_t time) {
+
+  return chOQWriteTimeout(&((SerialUARTDriver *)ip)->oqueue, bp, n, time);
+}
+
+static size_t readt(void *ip, uint8_t *bp, size_t n, systime_t time) {
+
+  return chIQReadTimeout(&((SerialUARTDriver *)ip)->iqueue, bp, n, time);
+}
+
+static const struct SerialUARTDriverVMT vmt = {
+  write, read, put, get,
+  putt, gett, writet, readt
+};
+
+/**
+ * @brief   Moves received data into the input queue.
+ * @details The data exceeding the queue free space is discarded and the
+ *          @p SDUART_OVERRUN_ERROR flag is broadcasted.
+ *
+ * @param[in] sdup      pointer to a @p SerialUARTDriver object
+ * @param[in] bp        pointer to the received data
+ * @param[in] n         number of received bytes
+ *
+ * @notapi
+ */
+static void push_data(SerialUARTDriver *sdup, const uint8_t *bp, size_t n) {
+  InputQueue *iqp = &sdup->iqueue;
+
+  if (n == 0)
+    return;
+
+  if (chIQWriteI(iqp, bp, n) < n)
+    chnAddFlagsI(sdup, SDUART_OVERRUN_ERROR);
+  chnAddFlagsI(sdup, CHN_INPUT_AVAILABLE);
+}
+
+/**
+ * @brief   Starts a transmission from the output queue, if possible.
+ * @details The data is transmitted in place, the largest contiguous block
+ *          in the queue buffer is sent in a single UART operation.
+ *
+ * @param[in] sdup      pointer to a @p SerialUARTDriver object
+ *
+ * @notapi
+ */
+static void start_transmit(SerialUARTDriver *sdup) {
+  OutputQueue *oqp = &sdup->oqueue;
+  size_t n;
+
+  if ((sdup->state != SDUART_READY) || (sdup->txn > 0))
+    return;
+
+  if ((n = chOQGetFullI(oqp)) > 0) {
+    if (n > (size_t)(oqp->q_top - oqp->q_rdptr))
+      n = oqp->q_top - oqp->q_rdptr;
+    sdup->txn = n;
+    uartStartSendI(sdup->config->uartp, n, oqp->q_rdptr);
+  }
+}
+
+/**
+ * @brief   Notification of data inserted into the output queue.
+ */
+static void onotify(GenericQueue *qp) {
+
+  start_transmit(chQGetLink(qp));
+}
+
+/**
+ * @brief   Receive idle timer callback.
+ * @details The partially filled receive buffer is moved into the input
+ *          queue and the reception restarted on the same buffer.
+ *
+ * @param[in] p         pointer to a @p SerialUARTDriver object
+ */
+static void rxidle(void *p) {
+  SerialUARTDriver *sdup = p;
+  UARTDriver *uartp = sdup->config->uartp;
+  size_t n;
+
+  chSysLockFromIsr();
+  if (sdup->state == SDUART_READY) {
+    n = SERIAL_UART_RX_CHUNK_SIZE - uartStopReceiveI(uartp);
+    push_data(sdup, sdup->rxbuf[sdup->rxidx], n);
+    uartStartReceiveI(uartp, SERIAL_UART_RX_CHUNK_SIZE,
+                      sdup->rxbuf[sdup->rxidx]);
+    chVTSetI(&sdup->rxvt, sdup->config->idle_time, rxidle, sdup);
+  }
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   End of transmission buffer callback.
+ * @details The transmitted data is released from the output queue and the
+ *          next contiguous block, if any, is transmitted.
+ */
+static void txend1(UARTDriver *uartp) {
+  SerialUARTDriver *sdup = owner(uartp);
+  OutputQueue *oqp = &sdup->oqueue;
+
+  chSysLockFromIsr();
+  if (sdup->state == SDUART_READY) {
+    oqp->q_rdptr += sdup->txn;
+    if (oqp->q_rdptr >= oqp->q_top)
+      oqp->q_rdptr = oqp->q_buffer;
+    chOQReleaseI(oqp, sdup->txn);
+    sdup->txn = 0;
+    if (chOQIsEmptyI(oqp))
+      chnAddFlagsI(sdup, CHN_OUTPUT_EMPTY);
+    start_transmit(sdup);
+  }
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Physical end of transmission callback.
+ */
+static void txend2(UARTDriver *uartp) {
+  SerialUARTDriver *sdup = owner(uartp);
+
+  chSysLockFromIsr();
+  if ((sdup->state == SDUART_READY) && (sdup->txn == 0))
+    chnAddFlagsI(sdup, CHN_TRANSMISSION_END);
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Receive buffer filled callback.
+ * @details The reception continues on the other half of the double buffer
+ *          while the filled one is moved into the input queue.
+ */
+static void rxend(UARTDriver *uartp) {
+  SerialUARTDriver *sdup = owner(uartp);
+  unsigned idx = sdup->rxidx;
+
+  chSysLockFromIsr();
+  if (sdup->state == SDUART_READY) {
+    sdup->rxidx = idx ^ 1;
+    uartStartReceiveI(uartp, SERIAL_UART_RX_CHUNK_SIZE,
+                      sdup->rxbuf[idx ^ 1]);
+    push_data(sdup, sdup->rxbuf[idx], SERIAL_UART_RX_CHUNK_SIZE);
+
+    /* The idle time restarts after each filled buffer.*/
+    if (chVTIsArmedI(&sdup->rxvt))
+      chVTResetI(&sdup->rxvt);
+    chVTSetI(&sdup->rxvt, sdup->config->idle_time, rxidle, sdup);
+  }
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Character received while the receiver is not active.
+ * @details This can happen while the reception is restarted.
+ */
+static void rxchar(UARTDriver *uartp, uint16_t c) {
+  SerialUARTDriver *sdup = owner(uartp);
+  uint8_t b = (uint8_t)c;
+
+  chSysLockFromIsr();
+  if (sdup->state == SDUART_READY)
+    push_data(sdup, &b, 1);
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Receive error callback.
+ * @details The UART error flags are translated into the equivalent channel
+ *          flags.
+ */
+static void rxerr(UARTDriver *uartp, uartflags_t e) {
+  SerialUARTDriver *sdup = owner(uartp);
+
+  chSysLockFromIsr();
+  chnAddFlagsI(sdup, (flagsmask_t)e << 3);
+  chSysUnlockFromIsr();
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Serial over UART Driver initialization.
+ * @note    This function is implicitly invoked by @p halInit(), there is
+ *          no need to explicitly initialize the driver.
+ *
+ * @init
+ */
+void sduartInit(void) {
+}
+
+/**
+ * @brief   Initializes a generic full duplex driver object.
+ *
+ * @param[out] sdup     pointer to a @p SerialUARTDriver structure
+ *
+ * @init
+ */
+void sduartObjectInit(SerialUARTDriver *sdup) {
+
+  sdup->vmt = &vmt;
+  chEvtInit(&sdup->event);
+  sdup->state = SDUART_STOP;
+  chIQInit(&sdup->iqueue, sdup->ib, SERIAL_UART_BUFFERS_SIZE, NULL, sdup);
+  chOQInit(&sdup->oqueue, sdup->ob, SERIAL_UART_BUFFERS_SIZE, onotify, sdup);
+  sdup->rxvt.vt_func = NULL;
+  sdup->config = NULL;
+  sdup->txn = 0;
+}
+
+/**
+ * @brief   Configures and starts the driver.
+ * @details The UART driver is started using a copy of the specified UART
+ *          configuration, the reception starts immediately.
+ *
+ * @param[in] sdup      pointer to a @p SerialUARTDriver object
+ * @param[in] config    the serial over UART driver configuration
+ *
+ * @api
+ */
+void sduartStart(SerialUARTDriver *sdup, const SerialUARTConfig *config) {
+
+  chDbgCheck((sdup != NULL) && (config != NULL) &&
+             (config->uartcfg != NULL) && (config->idle_time > 0),
+             "sduartStart");
+
+  chDbgAssert(sdup->state == SDUART_STOP,
+              "sduartStart(), #1",
+              "invalid state");
+
+  sdup->config = config;
+  sdup->uartcfg = *config->uartcfg;
+  sdup->uartcfg.txend1_cb = txend1;
+  sdup->uartcfg.txend2_cb = txend2;
+  sdup->uartcfg.rxend_cb  = rxend;
+  sdup->uartcfg.rxchar_cb = rxchar;
+  sdup->uartcfg.rxerr_cb  = rxerr;
+  uartStart(config->uartp, &sdup->uartcfg);
+
+  chSysLock();
+  sdup->state = SDUART_READY;
+  sdup->rxidx = 0;
+  sdup->txn = 0;
+  uartStartReceiveI(config->uartp, SERIAL_UART_RX_CHUNK_SIZE, sdup->rxbuf[0]);
+  chVTSetI(&sdup->rxvt, config->idle_time, rxidle, sdup);
+
+  /* Data written before the start is transmitted now.*/
+  start_transmit(sdup);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Stops the driver.
+ * @details Any thread waiting on the driver's queues will be awakened with
+ *          the message @p Q_RESET.
+ *
+ * @param[in] sdup      pointer to a @p SerialUARTDriver object
+ *
+ * @api
+ */
+void sduartStop(SerialUARTDriver *sdup) {
+
+  chDbgCheck(sdup != NULL, "sduartStop");
+
+  chSysLock();
+  chDbgAssert((sdup->state == SDUART_STOP) || (sdup->state == SDUART_READY),
+              "sduartStop(), #1",
+              "invalid state");
+  if (sdup->state == SDUART_STOP) {
+    chSysUnlock();
+    return;
+  }
+  sdup->state = SDUART_STOP;
+  if (chVTIsArmedI(&sdup->rxvt))
+    chVTResetI(&sdup->rxvt);
+  chSysUnlock();
+
+  /* Any ongoing operation is aborted by the UART driver stop.*/
+  uartStop(sdup->config->uartp);
+
+  /* Queues reset in order to signal the driver stop to the application.*/
+  chSysLock();
+  sdup->txn = 0;
+  chnAddFlagsI(sdup, CHN_DISCONNECTED);
+  chIQResetI(&sdup->iqueue);
+  chOQResetI(&sdup->oqueue);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+#endif /* HAL_USE_SERIAL_UART */
+
+/** @} */
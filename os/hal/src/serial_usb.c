@@ -108,11 +108,136 @@ static const struct SerialUSBDriverVMT vmt = {
   putt, gett, writet, readt
 };
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS || defined(__DOXYGEN__)
+/**
+ * @brief   Leaves the critical zone between two copy blocks.
+ * @details Gives the pending interrupts and, from thread context, the
+ *          higher priority threads a chance to run.
+ *
+ * @param[in] fromisr   @p TRUE if invoked from an ISR callback
+ *
+ * @notapi
+ */
+static void copy_yield(bool_t fromisr) {
+
+  if (fromisr) {
+    chSysUnlockFromIsr();
+    chSysLockFromIsr();
+  }
+  else {
+    chSysUnlock();
+    chSysLock();
+  }
+}
+
+/**
+ * @brief   Starts a transmit transfer of the output queue data.
+ * @details Up to @p SERIAL_USB_TRANSFER_SIZE bytes are moved into the
+ *          transmit buffer and sent in a single multi-packet transfer.
+ *          The data is moved in blocks of @p SERIAL_USB_COPY_BLOCK_SIZE
+ *          bytes and the kernel lock is released between the blocks, the
+ *          data written meanwhile is included in the transfer.
+ * @pre     The IN endpoint must be idle.
+ *
+ * @param[in] sdup      pointer to a @p SerialUSBDriver object
+ * @param[in] fromisr   @p TRUE if invoked from an ISR callback
+ * @return              The operation status.
+ * @retval FALSE        transfer started or being prepared.
+ * @retval TRUE         the output queue is empty.
+ *
+ * @iclass
+ */
+static bool_t start_transmit(SerialUSBDriver *sdup, bool_t fromisr) {
+  USBDriver *usbp = sdup->config->usbp;
+  size_t n, k;
+
+  /* Another context is already filling the transmit buffer.*/
+  if (sdup->txbusy)
+    return FALSE;
+
+  sdup->txbusy = TRUE;
+  n = 0;
+  while (TRUE) {
+    k = SERIAL_USB_TRANSFER_SIZE - n;
+    if (k > SERIAL_USB_COPY_BLOCK_SIZE)
+      k = SERIAL_USB_COPY_BLOCK_SIZE;
+    k = chOQReadI(&sdup->oqueue, sdup->txbuf + n, k);
+    n += k;
+    if ((k < SERIAL_USB_COPY_BLOCK_SIZE) || (n >= SERIAL_USB_TRANSFER_SIZE))
+      break;
+    copy_yield(fromisr);
+  }
+  sdup->txbusy = FALSE;
+
+  if (n == 0)
+    return TRUE;
+
+  /* The driver could have been stopped while the lock was released.*/
+  if ((usbGetDriverStateI(usbp) == USB_ACTIVE) &&
+      (sdup->state == SDU_READY)) {
+    usbPrepareTransmit(usbp, sdup->config->bulk_in, sdup->txbuf, n);
+    usbStartTransmitI(usbp, sdup->config->bulk_in);
+  }
+  return FALSE;
+}
+
+/**
+ * @brief   Moves the received data into the input queue.
+ * @details The data that does not fit in the input queue is kept in the
+ *          receive buffer until the application reads from the queue, a
+ *          new receive transfer is started only when the receive buffer
+ *          has been emptied, this is the OUT endpoint flow control.
+ *          The data is moved in blocks of @p SERIAL_USB_COPY_BLOCK_SIZE
+ *          bytes and the kernel lock is released between the blocks.
+ *
+ * @param[in] sdup      pointer to a @p SerialUSBDriver object
+ * @param[in] fromisr   @p TRUE if invoked from an ISR callback
+ *
+ * @iclass
+ */
+static void flush_receive(SerialUSBDriver *sdup, bool_t fromisr) {
+  USBDriver *usbp = sdup->config->usbp;
+  size_t n;
+
+  /* Another context is already moving the received data.*/
+  if (sdup->rxbusy)
+    return;
+
+  sdup->rxbusy = TRUE;
+  while (sdup->rxlen > 0) {
+    n = sdup->rxlen;
+    if (n > SERIAL_USB_COPY_BLOCK_SIZE)
+      n = SERIAL_USB_COPY_BLOCK_SIZE;
+    n = chIQWriteI(&sdup->iqueue, sdup->rxptr, n);
+    if (n == 0)
+      break;
+    sdup->rxptr += n;
+    sdup->rxlen -= n;
+    chnAddFlagsI(sdup, CHN_INPUT_AVAILABLE);
+    if (sdup->rxlen > 0)
+      copy_yield(fromisr);
+  }
+  sdup->rxbusy = FALSE;
+
+  /* The driver could have been stopped while the lock was released.*/
+  if ((sdup->rxlen == 0) &&
+      (usbGetDriverStateI(usbp) == USB_ACTIVE) &&
+      (sdup->state == SDU_READY) &&
+      !usbGetReceiveStatusI(usbp, sdup->config->bulk_out)) {
+    usbPrepareReceive(usbp, sdup->config->bulk_out,
+                      sdup->rxbuf, SERIAL_USB_TRANSFER_SIZE);
+    usbStartReceiveI(usbp, sdup->config->bulk_out);
+  }
+}
+#endif /* SERIAL_USB_USE_LINEAR_TRANSFERS */
+
 /**
  * @brief   Notification of data removed from the input queue.
  */
 static void inotify(GenericQueue *qp) {
+#if !SERIAL_USB_USE_LINEAR_TRANSFERS
   size_t n, maxsize;
+#endif
   SerialUSBDriver *sdup = chQGetLink(qp);
 
   /* If the USB driver is not in the appropriate state then transactions
@@ -121,6 +246,15 @@ static void inotify(GenericQueue *qp) {
       (sdup->state != SDU_READY))
     return;
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  /* The received data waiting in the receive buffer is moved when there
+     is space for a whole copy block, or for all of it, moving the data one
+     byte at time as the application reads it would be too expensive.*/
+  if ((sdup->rxlen > 0) &&
+      ((chIQGetEmptyI(&sdup->iqueue) >= SERIAL_USB_COPY_BLOCK_SIZE) ||
+       (chIQGetEmptyI(&sdup->iqueue) >= sdup->rxlen)))
+    flush_receive(sdup, FALSE);
+#else
   /* If there is in the queue enough space to hold at least one packet and
      a transaction is not yet started then a new transaction is started for
      the available space.*/
@@ -137,13 +271,16 @@ static void inotify(GenericQueue *qp) {
     chSysLock();
     usbStartReceiveI(sdup->config->usbp, sdup->config->bulk_out);
   }
+#endif
 }
 
 /**
  * @brief   Notification of data inserted into the output queue.
  */
 static void onotify(GenericQueue *qp) {
+#if !SERIAL_USB_USE_LINEAR_TRANSFERS
   size_t n;
+#endif
   SerialUSBDriver *sdup = chQGetLink(qp);
 
   /* If the USB driver is not in the appropriate state then transactions
@@ -152,6 +289,13 @@ static void onotify(GenericQueue *qp) {
       (sdup->state != SDU_READY))
     return;
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  /* If there is not an ongoing transaction then a new transaction is
+     started with the data in the output queue, concurrent writers do not
+     start another while the transmit buffer is being filled.*/
+  if (!usbGetTransmitStatusI(sdup->config->usbp, sdup->config->bulk_in))
+    start_transmit(sdup, FALSE);
+#else
   /* If there is not an ongoing transaction and the output queue contains
      data then a new transaction is started.*/
   if (!usbGetTransmitStatusI(sdup->config->usbp, sdup->config->bulk_in) &&
@@ -165,6 +309,7 @@ static void onotify(GenericQueue *qp) {
     chSysLock();
     usbStartTransmitI(sdup->config->usbp, sdup->config->bulk_in);
   }
+#endif
 }
 
 /*===========================================================================*/
@@ -197,6 +342,11 @@ void sduObjectInit(SerialUSBDriver *sdup) {
   sdup->state = SDU_STOP;
   chIQInit(&sdup->iqueue, sdup->ib, SERIAL_USB_BUFFERS_SIZE, inotify, sdup);
   chOQInit(&sdup->oqueue, sdup->ob, SERIAL_USB_BUFFERS_SIZE, onotify, sdup);
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  sdup->rxlen  = 0;
+  sdup->txbusy = FALSE;
+  sdup->rxbusy = FALSE;
+#endif
 }
 
 /**
@@ -273,10 +423,22 @@ void sduConfigureHookI(SerialUSBDriver *sdup) {
   chOQResetI(&sdup->oqueue);
   chnAddFlagsI(sdup, CHN_CONNECTED);
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  chDbgAssert((SERIAL_USB_TRANSFER_SIZE %
+               usbp->epc[sdup->config->bulk_out]->out_maxsize) == 0,
+              "sduConfigureHookI(), #1",
+              "transfer size not a multiple of the packet size");
+
+  /* Starts the first OUT transfer immediately.*/
+  sdup->rxptr = sdup->rxbuf;
+  sdup->rxlen = 0;
+  flush_receive(sdup, TRUE);
+#else
   /* Starts the first OUT transaction immediately.*/
   usbPrepareQueuedReceive(usbp, sdup->config->bulk_out, &sdup->iqueue,
                           usbp->epc[sdup->config->bulk_out]->out_maxsize);
   usbStartReceiveI(usbp, sdup->config->bulk_out);
+#endif
 }
 
 /**
@@ -324,7 +486,9 @@ bool_t sduRequestsHook(USBDriver *usbp) {
  * @param[in] ep        endpoint number
  */
 void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
+#if !SERIAL_USB_USE_LINEAR_TRANSFERS
   size_t n;
+#endif
   SerialUSBDriver *sdup = usbp->in_params[ep - 1];
 
   if (sdup == NULL)
@@ -333,6 +497,18 @@ void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
   chSysLockFromIsr();
   chnAddFlagsI(sdup, CHN_OUTPUT_EMPTY);
 
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  /* The data written in the output queue during the transfer is sent in
+     the next transfer, if there is no data and the last packet had the
+     maximum size then a zero sized packet terminates the transfer.*/
+  if (start_transmit(sdup, TRUE) &&
+      (usbp->epc[ep]->in_state->txsize > 0) &&
+      !(usbp->epc[ep]->in_state->txsize &
+        (usbp->epc[ep]->in_maxsize - 1))) {
+    usbPrepareTransmit(usbp, ep, NULL, 0);
+    usbStartTransmitI(usbp, ep);
+  }
+#else
   if ((n = chOQGetFullI(&sdup->oqueue)) > 0) {
     /* The endpoint cannot be busy, we are in the context of the callback,
        so it is safe to transmit without a check.*/
@@ -357,6 +533,7 @@ void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
     chSysLockFromIsr();
     usbStartTransmitI(usbp, ep);
   }
+#endif
 
   chSysUnlockFromIsr();
 }
@@ -370,13 +547,22 @@ void sduDataTransmitted(USBDriver *usbp, usbep_t ep) {
  * @param[in] ep        endpoint number
  */
 void sduDataReceived(USBDriver *usbp, usbep_t ep) {
+#if !SERIAL_USB_USE_LINEAR_TRANSFERS
   size_t n, maxsize;
+#endif
   SerialUSBDriver *sdup = usbp->out_params[ep - 1];
 
   if (sdup == NULL)
     return;
 
   chSysLockFromIsr();
+#if SERIAL_USB_USE_LINEAR_TRANSFERS
+  /* The transfer ends with a short packet or when the buffer is full, the
+     received data is moved into the input queue.*/
+  sdup->rxptr = sdup->rxbuf;
+  sdup->rxlen = usbGetReceiveTransactionSizeI(usbp, ep);
+  flush_receive(sdup, TRUE);
+#else
   chnAddFlagsI(sdup, CHN_INPUT_AVAILABLE);
 
   /* Writes to the input queue can only happen when there is enough space
@@ -393,6 +579,7 @@ void sduDataReceived(USBDriver *usbp, usbep_t ep) {
     chSysLockFromIsr();
     usbStartReceiveI(usbp, ep);
   }
+#endif
 
   chSysUnlockFromIsr();
 }
@@ -89,6 +89,13 @@
 #define HAL_USE_I2C                 TRUE
 #endif
 
+/**
+ * @brief   Enables the I2S subsystem.
+ */
+#if !defined(HAL_USE_I2S) || defined(__DOXYGEN__)
+#define HAL_USE_I2S                 TRUE
+#endif
+
 /**
  * @brief   Enables the ICU subsystem.
  */
@@ -145,6 +152,13 @@
 #define HAL_USE_SERIAL_USB          TRUE
 #endif
 
+/**
+ * @brief   Enables the SERIAL over UART subsystem.
+ */
+#if !defined(HAL_USE_SERIAL_UART) || defined(__DOXYGEN__)
+#define HAL_USE_SERIAL_UART         TRUE
+#endif
+
 /**
  * @brief   Enables the SPI subsystem.
  */
@@ -204,6 +218,29 @@
 #if !defined(CAN_USE_SLEEP_MODE) || defined(__DOXYGEN__)
 #define CAN_USE_SLEEP_MODE          TRUE
 #endif
+
+/**
+ * @brief   Size of the software receive FIFO in frames.
+ * @note    Zero disables the software receive FIFO.
+ */
+#if !defined(CAN_RX_FIFO_SIZE) || defined(__DOXYGEN__)
+#define CAN_RX_FIFO_SIZE            0
+#endif
+
+/**
+ * @brief   Size of the software transmit queue in frames.
+ * @note    Zero disables the software transmit queue.
+ */
+#if !defined(CAN_TX_QUEUE_SIZE) || defined(__DOXYGEN__)
+#define CAN_TX_QUEUE_SIZE           0
+#endif
+
+/**
+ * @brief   Software acceptance filters APIs inclusion switch.
+ */
+#if !defined(CAN_USE_SOFTWARE_FILTERS) || defined(__DOXYGEN__)
+#define CAN_USE_SOFTWARE_FILTERS    FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -219,6 +256,13 @@
 #if !defined(I2C_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
 #define I2C_USE_MUTUAL_EXCLUSION    TRUE
 #endif
+
+/**
+ * @brief   Enables the transactions queue APIs.
+ */
+#if !defined(I2C_USE_QUEUE) || defined(__DOXYGEN__)
+#define I2C_USE_QUEUE               FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -261,6 +305,27 @@
 #if !defined(MMC_NICE_WAITING) || defined(__DOXYGEN__)
 #define MMC_NICE_WAITING            TRUE
 #endif
+
+/**
+ * @brief   Enables the CRC on the data blocks.
+ */
+#if !defined(MMC_USE_CRC) || defined(__DOXYGEN__)
+#define MMC_USE_CRC                 TRUE
+#endif
+
+/**
+ * @brief   Number of frames received by each polling transfer.
+ */
+#if !defined(MMC_POLL_BURST) || defined(__DOXYGEN__)
+#define MMC_POLL_BURST              8
+#endif
+
+/**
+ * @brief   Uses the CRC library instead of the driver local tables.
+ */
+#if !defined(MMC_USE_CRC_LIBRARY) || defined(__DOXYGEN__)
+#define MMC_USE_CRC_LIBRARY         FALSE
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -345,6 +410,30 @@
 #endif
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name SERIAL_UART driver related setting
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Serial over UART queues size.
+ * @details Configuration parameter, you can change the depth of the queue
+ *          buffers depending on the requirements of your application.
+ */
+#if !defined(SERIAL_UART_BUFFERS_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_UART_BUFFERS_SIZE    256
+#endif
+
+/**
+ * @brief   Size of each half of the receive double buffer.
+ */
+#if !defined(SERIAL_UART_RX_CHUNK_SIZE) || defined(__DOXYGEN__)
+#define SERIAL_UART_RX_CHUNK_SIZE   32
+#endif
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name SPI driver related setting
@@ -189,6 +189,25 @@ msg_t i2c_lld_master_transmit_timeout(I2CDriver *i2cp, i2caddr_t addr,
   return RDY_OK;
 }
 
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+/**
+ * @brief   Starts a queued transaction.
+ * @details The transaction is executed asynchronously, on completion the
+ *          ISR must set the driver errors mask and invoke
+ *          @p _i2c_queue_complete().
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] itp       pointer to the transaction
+ *
+ * @notapi
+ */
+void i2c_lld_start_transaction(I2CDriver *i2cp, const I2CTransaction *itp) {
+
+  (void)i2cp;
+  (void)itp;
+}
+#endif /* I2C_USE_QUEUE */
+
 #endif /* HAL_USE_I2C */
 
 /** @} */
@@ -31,6 +31,12 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   This switch defines whether the driver implementation supports
+ *          the transactions queue.
+ */
+#define I2C_SUPPORTS_QUEUE          TRUE
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -111,6 +117,24 @@ struct I2CDriver {
   Semaphore                 semaphore;
 #endif
 #endif /* I2C_USE_MUTUAL_EXCLUSION */
+#if I2C_USE_QUEUE || defined(__DOXYGEN__)
+  /**
+   * @brief   Transaction being executed, head of the queue.
+   */
+  I2CTransaction            *qhead;
+  /**
+   * @brief   Last queued transaction.
+   */
+  I2CTransaction            *qtail;
+  /**
+   * @brief   Threads waiting for the queue to become empty.
+   */
+  Semaphore                 qsem;
+  /**
+   * @brief   The transactions queue became empty.
+   */
+  EventSource               queue_event;
+#endif /* I2C_USE_QUEUE */
 #if defined(I2C_DRIVER_EXT_FIELDS)
   I2C_DRIVER_EXT_FIELDS
 #endif
@@ -153,6 +177,9 @@ extern "C" {
   msg_t i2c_lld_master_receive_timeout(I2CDriver *i2cp, i2caddr_t addr,
                                        uint8_t *rxbuf, size_t rxbytes,
                                        systime_t timeout);
+#if I2C_USE_QUEUE
+  void i2c_lld_start_transaction(I2CDriver *i2cp, const I2CTransaction *itp);
+#endif
 #ifdef __cplusplus
 }
 #endif
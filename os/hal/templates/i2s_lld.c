@@ -0,0 +1,159 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    templates/i2s_lld.c
+ * @brief   I2S Driver subsystem low level driver source template.
+ *
+ * @addtogroup I2S
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+
+#if HAL_USE_I2S || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   I2S1 driver identifier.
+ */
+#if PLATFORM_I2S_USE_I2S1 || defined(__DOXYGEN__)
+I2SDriver I2SD1;
+#endif
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Low level I2S driver initialization.
+ *
+ * @notapi
+ */
+void i2s_lld_init(void) {
+
+#if PLATFORM_I2S_USE_I2S1
+  i2sObjectInit(&I2SD1);
+#endif
+}
+
+/**
+ * @brief   Configures and activates the I2S peripheral.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start(I2SDriver *i2sp) {
+
+  if (i2sp->state == I2S_STOP) {
+    /* Enables the peripheral.*/
+#if PLATFORM_I2S_USE_I2S1
+    if (&I2SD1 == i2sp) {
+
+    }
+#endif
+  }
+  /* Configures the peripheral.*/
+
+}
+
+/**
+ * @brief   Deactivates the I2S peripheral.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_stop(I2SDriver *i2sp) {
+
+  if (i2sp->state == I2S_READY) {
+    /* Disables the peripheral.*/
+#if PLATFORM_I2S_USE_I2S1
+    if (&I2SD1 == i2sp) {
+
+    }
+#endif
+  }
+}
+
+/**
+ * @brief   Starts a I2S data exchange.
+ * @details The buffers are exchanged once, the implementation must use
+ *          @p _i2s_isr_half_code() after the first half and
+ *          @p _i2s_isr_complete_code() at the end.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start_exchange(I2SDriver *i2sp) {
+
+  (void)i2sp;
+}
+
+/**
+ * @brief   Starts a I2S data exchange in continuous mode.
+ * @details The buffers are exchanged circularly, the implementation must
+ *          use @p _i2s_isr_half_code() and @p _i2s_isr_full_code() after
+ *          each half buffer.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_start_exchange_continuous(I2SDriver *i2sp) {
+
+  (void)i2sp;
+}
+
+/**
+ * @brief   Stops the ongoing data exchange.
+ * @details The ongoing data exchange, if any, is stopped, if the driver
+ *          was not active the function does nothing.
+ *
+ * @param[in] i2sp      pointer to the @p I2SDriver object
+ *
+ * @notapi
+ */
+void i2s_lld_stop_exchange(I2SDriver *i2sp) {
+
+  (void)i2sp;
+}
+
+#endif /* HAL_USE_I2S */
+
+/** @} */
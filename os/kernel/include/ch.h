@@ -107,21 +107,24 @@
 #include "chsys.h"
 #include "chvt.h"
 #include "chschd.h"
+#include "chevents.h"
 #include "chsem.h"
 #include "chbsem.h"
 #include "chmtx.h"
 #include "chcond.h"
-#include "chevents.h"
+#include "chrwlock.h"
 #include "chmsg.h"
 #include "chmboxes.h"
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
+#include "chobjfifos.h"
 #include "chthreads.h"
 #include "chdynamic.h"
 #include "chregistry.h"
 #include "chinline.h"
 #include "chqueues.h"
+#include "chwaitobjs.h"
 #include "chstreams.h"
 #include "chfiles.h"
 #include "chdebug.h"
@@ -72,7 +72,7 @@ typedef void (*evhandler_t)(eventid_t);
  *          source that is part of a bigger structure.
  * @param name the name of the event source variable
  */
-#define _EVENTSOURCE_DATA(name) {(void *)(&name)}
+#define _EVENTSOURCE_DATA(name) {(EventListener *)(&name)}
 
 /**
  * @brief   Static event source initializer.
@@ -59,6 +59,7 @@ extern "C" {
 #endif
   void chMBInit(Mailbox *mbp, msg_t *buf, cnt_t n);
   void chMBReset(Mailbox *mbp);
+  void chMBResetI(Mailbox *mbp);
   msg_t chMBPost(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostS(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostI(Mailbox *mbp, msg_t msg);
@@ -46,6 +46,8 @@ typedef struct Mutex {
 #ifdef __cplusplus
 extern "C" {
 #endif
+  void _mtx_boost(Thread *tp, tprio_t prio);
+  void _mtx_enqueue(Mutex *mp, Thread *tp);
   void chMtxInit(Mutex *mp);
   void chMtxLock(Mutex *mp);
   void chMtxLockS(Mutex *mp);
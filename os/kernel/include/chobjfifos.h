@@ -0,0 +1,126 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chobjfifos.h
+ * @brief   Objects FIFOs macros and structures.
+ *
+ * @addtogroup objects_fifos
+ * @{
+ */
+
+#ifndef _CHOBJFIFOS_H_
+#define _CHOBJFIFOS_H_
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_SEMAPHORES
+#error "CH_USE_OBJFIFOS requires CH_USE_SEMAPHORES"
+#endif
+
+#if !CH_USE_MEMPOOLS
+#error "CH_USE_OBJFIFOS requires CH_USE_MEMPOOLS"
+#endif
+
+/**
+ * @brief   Structure representing an objects FIFO.
+ * @details The FIFO is composed of a pool of free objects and of a
+ *          circular buffer of pointers to the posted objects. The circular
+ *          buffer has a slot for each object so posting never blocks.
+ */
+typedef struct {
+  MemoryPool            of_pool;        /**< @brief Pool of the free
+                                                    objects.                */
+  Semaphore             of_freesem;     /**< @brief Free objects counter
+                                                    @p Semaphore.           */
+  void                  **of_buffer;    /**< @brief Pointer to the posted
+                                                    objects buffer.         */
+  void                  **of_top;       /**< @brief Pointer to the location
+                                                    after the buffer.       */
+  void                  **of_wrptr;     /**< @brief Write pointer.          */
+  void                  **of_rdptr;     /**< @brief Read pointer.           */
+  Semaphore             of_fullsem;     /**< @brief Posted objects counter
+                                                    @p Semaphore.           */
+} ObjectsFifo;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chFifoInit(ObjectsFifo *ofp, size_t objsize, cnt_t objn,
+                  void *objbuf, void **msgbuf);
+  void *chFifoTakeObject(ObjectsFifo *ofp, systime_t time);
+  void *chFifoTakeObjectS(ObjectsFifo *ofp, systime_t time);
+  void *chFifoTakeObjectI(ObjectsFifo *ofp);
+  void chFifoReturnObject(ObjectsFifo *ofp, void *objp);
+  void chFifoReturnObjectI(ObjectsFifo *ofp, void *objp);
+  void chFifoReturnObjects(ObjectsFifo *ofp, void * const *objpp, cnt_t n);
+  void chFifoReturnObjectsI(ObjectsFifo *ofp, void * const *objpp, cnt_t n);
+  void chFifoSendObject(ObjectsFifo *ofp, void *objp);
+  void chFifoSendObjectS(ObjectsFifo *ofp, void *objp);
+  void chFifoSendObjectI(ObjectsFifo *ofp, void *objp);
+  void chFifoSendObjects(ObjectsFifo *ofp, void * const *objpp, cnt_t n);
+  void chFifoSendObjectsI(ObjectsFifo *ofp, void * const *objpp, cnt_t n);
+  msg_t chFifoReceiveObject(ObjectsFifo *ofp, void **objpp, systime_t time);
+  msg_t chFifoReceiveObjectS(ObjectsFifo *ofp, void **objpp, systime_t time);
+  msg_t chFifoReceiveObjectI(ObjectsFifo *ofp, void **objpp);
+  cnt_t chFifoReceiveObjects(ObjectsFifo *ofp, void **objpp, cnt_t n,
+                             systime_t time);
+  cnt_t chFifoReceiveObjectsI(ObjectsFifo *ofp, void **objpp, cnt_t n);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of free objects in an objects FIFO.
+ * @note    The returned value can be less than zero when there are waiting
+ *          threads on the internal semaphore.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @return              The number of free objects.
+ *
+ * @iclass
+ */
+#define chFifoGetFreeCountI(ofp) chSemGetCounterI(&(ofp)->of_freesem)
+
+/**
+ * @brief   Returns the number of objects posted in an objects FIFO.
+ * @note    The returned value can be less than zero when there are waiting
+ *          threads on the internal semaphore.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @return              The number of posted objects.
+ *
+ * @iclass
+ */
+#define chFifoGetUsedCountI(ofp) chSemGetCounterI(&(ofp)->of_fullsem)
+/** @} */
+
+#endif /* CH_USE_OBJFIFOS */
+
+#endif /* _CHOBJFIFOS_H_ */
+
+/** @} */
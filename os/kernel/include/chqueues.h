@@ -69,8 +69,26 @@ struct GenericQueue {
   uint8_t               *q_rdptr;   /**< @brief Read pointer.               */
   qnotify_t             q_notify;   /**< @brief Data notification callback. */
   void                  *q_link;    /**< @brief Application defined field.  */
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+  EventSource           q_event;    /**< @brief Source broadcast when data
+                                                or space becomes available. */
+#endif
 };
 
+/**
+ * @brief   Data part of the queue event source initializer.
+ * @details Expands to nothing when @p CH_USE_WAITOBJECTS is disabled.
+ *
+ * @param[in] name      the name of the queue variable
+ *
+ * @notapi
+ */
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+#define _QUEUE_EVENTSOURCE_DATA(name) , _EVENTSOURCE_DATA(name.q_event)
+#else
+#define _QUEUE_EVENTSOURCE_DATA(name)
+#endif
+
 /**
  * @name    Macro Functions
  * @{
@@ -208,6 +226,7 @@ typedef GenericQueue InputQueue;
   (uint8_t *)(buffer),                                                      \
   (inotify),                                                                \
   (link)                                                                    \
+  _QUEUE_EVENTSOURCE_DATA(name)                                             \
 }
 
 /**
@@ -325,6 +344,7 @@ typedef GenericQueue OutputQueue;
   (uint8_t *)(buffer),                                                      \
   (onotify),                                                                \
   (link)                                                                    \
+  _QUEUE_EVENTSOURCE_DATA(name)                                             \
 }
 
 /**
@@ -348,6 +368,8 @@ extern "C" {
                 void *link);
   void chIQResetI(InputQueue *iqp);
   msg_t chIQPutI(InputQueue *iqp, uint8_t b);
+  void chIQCommitI(InputQueue *iqp, size_t n);
+  size_t chIQWriteI(InputQueue *iqp, const uint8_t *bp, size_t n);
   msg_t chIQGetTimeout(InputQueue *iqp, systime_t time);
   size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
                          size_t n, systime_t time);
@@ -357,6 +379,8 @@ extern "C" {
   void chOQResetI(OutputQueue *oqp);
   msg_t chOQPutTimeout(OutputQueue *oqp, uint8_t b, systime_t time);
   msg_t chOQGetI(OutputQueue *oqp);
+  void chOQReleaseI(OutputQueue *oqp, size_t n);
+  size_t chOQReadI(OutputQueue *oqp, uint8_t *bp, size_t n);
   size_t chOQWriteTimeout(OutputQueue *oqp, const uint8_t *bp,
                           size_t n, systime_t time);
   size_t chOQWriteBatchTimeout(OutputQueue *oqp, const uint8_t *bp,
@@ -0,0 +1,200 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrwlock.h
+ * @brief   Reader-writer locks macros and structures.
+ *
+ * @addtogroup rwlocks
+ * @{
+ */
+
+#ifndef _CHRWLOCK_H_
+#define _CHRWLOCK_H_
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_MUTEXES
+#error "CH_USE_RWLOCKS requires CH_USE_MUTEXES"
+#endif
+
+/*===========================================================================*/
+/**
+ * @name    Reader-writer locks related settings
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of reader-writer locks a thread can hold for reading.
+ * @details Each thread reserves one @p RWReader record for each lock it can
+ *          hold for reading at the same time, nested read locks on the same
+ *          lock share a single record.
+ */
+#ifndef CH_RWLOCK_READ_HOLDS
+#define CH_RWLOCK_READ_HOLDS        2
+#endif
+/** @} */
+
+#if CH_RWLOCK_READ_HOLDS < 1
+#error "CH_RWLOCK_READ_HOLDS must be at least 1"
+#endif
+
+/**
+ * @name    Reader-writer lock policies
+ * @{
+ */
+#define RW_PREFER_READERS   0   /**< @brief Readers enter while the lock is
+                                            held for reading.               */
+#define RW_PREFER_WRITERS   1   /**< @brief Readers wait while writers are
+                                            waiting.                        */
+/** @} */
+
+/**
+ * @brief   Reader record of a thread holding a lock for reading.
+ */
+typedef struct RWReader {
+  struct RWReader       *rr_next;   /**< @brief Next reader record of the
+                                                same lock or @p NULL.       */
+  struct RWLock         *rr_lock;   /**< @brief Lock held for reading or
+                                                @p NULL if free.            */
+  Thread                *rr_thread; /**< @brief Reader @p Thread pointer.   */
+  cnt_t                 rr_cnt;     /**< @brief Nested read locks count.    */
+} RWReader;
+
+/**
+ * @brief   Reader-writer lock structure.
+ */
+typedef struct RWLock {
+  ThreadsQueue          rw_rdqueue; /**< @brief Queue of the readers sleeping
+                                                on this lock.               */
+  ThreadsQueue          rw_wrqueue; /**< @brief Queue of the writers sleeping
+                                                on this lock.               */
+  Thread                *rw_owner;  /**< @brief Writer @p Thread pointer or
+                                                @p NULL.                    */
+  struct RWLock         *rw_next;   /**< @brief Next @p RWLock into a writer
+                                                owner-list or @p NULL.      */
+  RWReader              *rw_readers;/**< @brief List of the reader records
+                                                holding the lock or
+                                                @p NULL.                    */
+  uint8_t               rw_policy;  /**< @brief Lock policy.                */
+} RWLock;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  tprio_t _rw_inherited_prio(Thread *tp, tprio_t prio);
+  void chRWLockInit(RWLock *rwp, uint8_t policy);
+  msg_t chRWLockReadLock(RWLock *rwp);
+  msg_t chRWLockReadLockTimeout(RWLock *rwp, systime_t time);
+  msg_t chRWLockReadLockTimeoutS(RWLock *rwp, systime_t time);
+  void chRWLockReadUnlock(RWLock *rwp);
+  void chRWLockReadUnlockS(RWLock *rwp);
+  void chRWLockWriteLock(RWLock *rwp);
+  msg_t chRWLockWriteLockTimeout(RWLock *rwp, systime_t time);
+  msg_t chRWLockWriteLockTimeoutS(RWLock *rwp, systime_t time);
+  void chRWLockWriteUnlock(RWLock *rwp);
+  void chRWLockWriteUnlockS(RWLock *rwp);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   Data part of a static reader-writer lock initializer.
+ * @details This macro should be used when statically initializing a
+ *          reader-writer lock that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the reader-writer lock variable
+ * @param[in] policy    the lock policy, @p RW_PREFER_READERS or
+ *                      @p RW_PREFER_WRITERS
+ */
+#define _RWLOCK_DATA(name, policy) {                                        \
+  _THREADSQUEUE_DATA(name.rw_rdqueue),                                      \
+  _THREADSQUEUE_DATA(name.rw_wrqueue),                                      \
+  NULL,                                                                     \
+  NULL,                                                                     \
+  NULL,                                                                     \
+  (policy)                                                                  \
+}
+
+/**
+ * @brief   Static reader-writer lock initializer.
+ * @details Statically initialized reader-writer locks require no explicit
+ *          initialization using @p chRWLockInit().
+ *
+ * @param[in] name      the name of the reader-writer lock variable
+ * @param[in] policy    the lock policy, @p RW_PREFER_READERS or
+ *                      @p RW_PREFER_WRITERS
+ */
+#define RWLOCK_DECL(name, policy) RWLock name = _RWLOCK_DATA(name, policy)
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Tries to lock a reader-writer lock for reading.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @return              The operation status.
+ * @retval TRUE         if the lock has been successfully acquired
+ * @retval FALSE        if the lock attempt failed.
+ *
+ * @api
+ */
+#define chRWLockTryReadLock(rwp)                                            \
+  (chRWLockReadLockTimeout(rwp, TIME_IMMEDIATE) == RDY_OK)
+
+/**
+ * @brief   Tries to lock a reader-writer lock for writing.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @return              The operation status.
+ * @retval TRUE         if the lock has been successfully acquired
+ * @retval FALSE        if the lock attempt failed.
+ *
+ * @api
+ */
+#define chRWLockTryWriteLock(rwp)                                           \
+  (chRWLockWriteLockTimeout(rwp, TIME_IMMEDIATE) == RDY_OK)
+
+/**
+ * @brief   Returns @p TRUE if the lock is held for writing.
+ *
+ * @sclass
+ */
+#define chRWLockIsWriteLockedS(rwp) ((rwp)->rw_owner != NULL)
+
+/**
+ * @brief   Returns @p TRUE if the lock is held for reading.
+ *
+ * @sclass
+ */
+#define chRWLockIsReadLockedS(rwp) ((rwp)->rw_readers != NULL)
+/** @} */
+
+#endif /* CH_USE_RWLOCKS */
+
+#endif /* _CHRWLOCK_H_ */
+
+/** @} */
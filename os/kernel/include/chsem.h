@@ -38,6 +38,10 @@ typedef struct Semaphore {
   ThreadsQueue          s_queue;    /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 s_cnt;      /**< @brief The semaphore counter.      */
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+  EventSource           s_event;    /**< @brief Source broadcast when the
+                                                counter becomes positive.   */
+#endif
 } Semaphore;
 
 #ifdef __cplusplus
@@ -69,7 +73,12 @@ extern "C" {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+#define _SEMAPHORE_DATA(name, n)                                            \
+  {_THREADSQUEUE_DATA(name.s_queue), n, _EVENTSOURCE_DATA(name.s_event)}
+#else
 #define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n}
+#endif
 
 /**
  * @brief   Static semaphore initializer.
@@ -51,6 +51,8 @@
 #define THD_STATE_WTMSG         12  /**< @brief Waiting for a message.      */
 #define THD_STATE_WTQUEUE       13  /**< @brief Waiting on an I/O queue.    */
 #define THD_STATE_FINAL         14  /**< @brief Thread terminated.          */
+#define THD_STATE_WTRWLOCK      15  /**< @brief Waiting on a reader-writer
+                                         lock.                              */
 
 /**
  * @brief   Thread states as array of strings.
@@ -60,7 +62,7 @@
 #define THD_STATE_NAMES                                                     \
   "READY", "CURRENT", "SUSPENDED", "WTSEM", "WTMTX", "WTCOND", "SLEEPING",  \
   "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ", "SNDMSG", "WTMSG", "WTQUEUE", \
-  "FINAL"
+  "FINAL", "WTRWLOCK"
 /** @} */
 
 /**
@@ -204,6 +206,35 @@ struct Thread {
    */
   tprio_t               p_realprio;
 #endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  /**
+   * @brief List of the reader-writer locks owned for writing by this thread.
+   * @note  The list is terminated by a @p NULL in this field.
+   */
+  RWLock                *p_rwlist;
+  /**
+   * @brief Reader-writer locks held for reading by this thread.
+   * @note  A record is free when its @p rr_lock field is @p NULL.
+   */
+  RWReader              p_rdholds[CH_RWLOCK_READ_HOLDS];
+#endif
+#if (CH_USE_CONDVARS && CH_USE_MUTEXES) || defined(__DOXYGEN__)
+  /**
+   * @brief Condition variable wait state.
+   */
+  union {
+    /**
+     * @brief Mutex to be reacquired on wakeup.
+     * @note  This field is @p NULL for waits with timeout, those threads
+     *        are not moved on the mutex queue by the signaling thread.
+     */
+    Mutex               *mtxp;
+    /**
+     * @brief Condition variable wakeup message.
+     */
+    msg_t               rdymsg;
+  }                     p_cnd;
+#endif
 #if (CH_USE_DYNAMIC && CH_USE_MEMPOOLS) || defined(__DOXYGEN__)
   /**
    * @brief Memory Pool where the thread workspace is returned.
@@ -0,0 +1,102 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwaitobjs.h
+ * @brief   Multiple objects wait macros and structures.
+ *
+ * @addtogroup wait_objects
+ * @{
+ */
+
+#ifndef _CHWAITOBJS_H_
+#define _CHWAITOBJS_H_
+
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_EVENTS
+#error "CH_USE_WAITOBJECTS requires CH_USE_EVENTS"
+#endif
+
+/**
+ * @name    Wait object types
+ * @{
+ */
+#define WO_EVENTSOURCE      0   /**< @brief Event source broadcast.         */
+#define WO_SEMAPHORE        1   /**< @brief Semaphore counter positive.     */
+#define WO_MAILBOX_FETCH    2   /**< @brief Message available in a mailbox. */
+#define WO_MAILBOX_POST     3   /**< @brief Free slot in a mailbox.         */
+#define WO_INPUTQUEUE       4   /**< @brief Data available in an input
+                                            queue.                          */
+#define WO_OUTPUTQUEUE      5   /**< @brief Space available in an output
+                                            queue.                          */
+#define WO_FIFO_RECEIVE     6   /**< @brief Object posted in an objects
+                                            FIFO.                           */
+#define WO_FIFO_TAKE        7   /**< @brief Free object in an objects FIFO. */
+/** @} */
+
+/**
+ * @brief   Wait object structure.
+ * @details Associates a waitable kernel object with the event listener used
+ *          to get notified of its readiness. An array of wait objects is
+ *          the set a thread blocks on using @p chWOWaitTimeout().
+ */
+typedef struct {
+  uint8_t               wo_type;        /**< @brief Type of the object, one
+                                                    of the @p WO_XXX
+                                                    values.                 */
+  void                  *wo_objp;       /**< @brief Pointer to the waited
+                                                    object.                 */
+  EventListener         wo_el;          /**< @brief Listener registered on
+                                                    the object readiness
+                                                    event source.           */
+} WaitObject;
+
+/**
+ * @brief   Data part of a static wait object initializer.
+ * @details This macro should be used when statically initializing an
+ *          array of wait objects.
+ *
+ * @param[in] type      type of the object, one of the @p WO_XXX values
+ * @param[in] objp      pointer to the waited object
+ */
+#define _WAITOBJECT_DATA(type, objp) {(type), (void *)(objp), {NULL}}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chWOObjectInit(WaitObject *wop, uint8_t type, void *objp);
+  void chWORegister(WaitObject *wop, cnt_t n, eventid_t eid);
+  void chWOUnregister(WaitObject *wop, cnt_t n);
+  bool_t chWOIsReadyI(WaitObject *wop);
+  msg_t chWOWaitTimeout(WaitObject *wop, cnt_t n, systime_t time);
+  msg_t chWOWaitTimeoutS(WaitObject *wop, cnt_t n, systime_t time);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_WAITOBJECTS */
+
+#endif /* _CHWAITOBJS_H_ */
+
+/** @} */
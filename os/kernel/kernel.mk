@@ -11,13 +11,16 @@ KERNSRC = ${CHIBIOS}/os/kernel/src/chsys.c \
           ${CHIBIOS}/os/kernel/src/chsem.c \
           ${CHIBIOS}/os/kernel/src/chmtx.c \
           ${CHIBIOS}/os/kernel/src/chcond.c \
+          ${CHIBIOS}/os/kernel/src/chrwlock.c \
           ${CHIBIOS}/os/kernel/src/chevents.c \
           ${CHIBIOS}/os/kernel/src/chmsg.c \
           ${CHIBIOS}/os/kernel/src/chmboxes.c \
           ${CHIBIOS}/os/kernel/src/chqueues.c \
+          ${CHIBIOS}/os/kernel/src/chwaitobjs.c \
           ${CHIBIOS}/os/kernel/src/chmemcore.c \
           ${CHIBIOS}/os/kernel/src/chheap.c \
-          ${CHIBIOS}/os/kernel/src/chmempools.c
+          ${CHIBIOS}/os/kernel/src/chmempools.c \
+          ${CHIBIOS}/os/kernel/src/chobjfifos.c
 
 # Required include directories
 KERNINC = ${CHIBIOS}/os/kernel/include
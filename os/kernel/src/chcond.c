@@ -32,7 +32,12 @@
  *          <h2>Operation mode</h2>
  *          The condition variable is a synchronization object meant to be
  *          used inside a zone protected by a @p Mutex. Mutexes and CondVars
- *          together can implement a Monitor construct.
+ *          together can implement a Monitor construct.<br>
+ *          Signaled threads are moved directly from the condition variable
+ *          queue to the mutex queue (wait morphing), only the thread that
+ *          actually acquires the mutex is made ready. This avoids the
+ *          useless wakeups and priority inheritance walks of the threads
+ *          that would immediately sleep again on the mutex.
  * @pre     In order to use the condition variable APIs the @p CH_USE_CONDVARS
  *          option must be enabled in @p chconf.h.
  * @{
@@ -42,6 +47,40 @@
 
 #if (CH_USE_CONDVARS && CH_USE_MUTEXES) || defined(__DOXYGEN__)
 
+/**
+ * @brief   Wakes up a thread waiting on a condition variable.
+ * @details The thread is made to acquire the mutex it released when it
+ *          started waiting. If the mutex is owned then the thread is moved
+ *          on the mutex queue and made ready later by the unlock operation.
+ *          Threads waiting with a timeout are just made ready, they acquire
+ *          the mutex by themselves.
+ *
+ * @param[in] tp        pointer to the thread removed from the condition
+ *                      variable queue
+ * @param[in] msg       the wakeup message
+ *
+ * @notapi
+ */
+static void cond_wakeup(Thread *tp, msg_t msg) {
+  Mutex *mp = tp->p_cnd.mtxp;
+
+  if (mp == NULL) {
+    chSchReadyI(tp)->p_u.rdymsg = msg;
+    return;
+  }
+  tp->p_cnd.rdymsg = msg;
+  if (mp->m_owner != NULL) {
+    _mtx_enqueue(mp, tp);
+    tp->p_state = THD_STATE_WTMTX;
+  }
+  else {
+    mp->m_owner = tp;
+    mp->m_next = tp->p_mtxlist;
+    tp->p_mtxlist = mp;
+    chSchReadyI(tp);
+  }
+}
+
 /**
  * @brief   Initializes s @p CondVar structure.
  *
@@ -68,8 +107,10 @@ void chCondSignal(CondVar *cp) {
   chDbgCheck(cp != NULL, "chCondSignal");
 
   chSysLock();
-  if (notempty(&cp->c_queue))
-    chSchWakeupS(fifo_remove(&cp->c_queue), RDY_OK);
+  if (notempty(&cp->c_queue)) {
+    cond_wakeup(fifo_remove(&cp->c_queue), RDY_OK);
+    chSchRescheduleS();
+  }
   chSysUnlock();
 }
 
@@ -90,7 +131,7 @@ void chCondSignalI(CondVar *cp) {
   chDbgCheck(cp != NULL, "chCondSignalI");
 
   if (notempty(&cp->c_queue))
-    chSchReadyI(fifo_remove(&cp->c_queue))->p_u.rdymsg = RDY_OK;
+    cond_wakeup(fifo_remove(&cp->c_queue), RDY_OK);
 }
 
 /**
@@ -124,11 +165,11 @@ void chCondBroadcastI(CondVar *cp) {
   chDbgCheckClassI();
   chDbgCheck(cp != NULL, "chCondBroadcastI");
 
-  /* Empties the condition variable queue and inserts all the Threads into the
-     ready list in FIFO order. The wakeup message is set to @p RDY_RESET in
+  /* Empties the condition variable queue and moves all the Threads on the
+     mutex queue in FIFO order. The wakeup message is set to @p RDY_RESET in
      order to make a chCondBroadcast() detectable from a chCondSignal().*/
   while (cp->c_queue.p_next != (void *)&cp->c_queue)
-    chSchReadyI(fifo_remove(&cp->c_queue))->p_u.rdymsg = RDY_RESET;
+    cond_wakeup(fifo_remove(&cp->c_queue), RDY_RESET);
 }
 
 /**
@@ -177,7 +218,6 @@ msg_t chCondWait(CondVar *cp) {
 msg_t chCondWaitS(CondVar *cp) {
   Thread *ctp = currp;
   Mutex *mp;
-  msg_t msg;
 
   chDbgCheckClassS();
   chDbgCheck(cp != NULL, "chCondWaitS");
@@ -187,11 +227,13 @@ msg_t chCondWaitS(CondVar *cp) {
 
   mp = chMtxUnlockS();
   ctp->p_u.wtobjp = cp;
+  ctp->p_cnd.mtxp = mp;
   prio_insert(ctp, &cp->c_queue);
   chSchGoSleepS(THD_STATE_WTCOND);
-  msg = ctp->p_u.rdymsg;
-  chMtxLockS(mp);
-  return msg;
+  /* The mutex has been assigned to this thread by the signaling thread or
+     by the unlock operation.*/
+  chDbgAssert(ctp->p_mtxlist == mp, "chCondWaitS(), #2", "not owned");
+  return ctp->p_cnd.rdymsg;
 }
 
 #if CH_USE_CONDVARS_TIMEOUT || defined(__DOXYGEN__)
@@ -272,6 +314,7 @@ msg_t chCondWaitTimeoutS(CondVar *cp, systime_t time) {
 
   mp = chMtxUnlockS();
   currp->p_u.wtobjp = cp;
+  currp->p_cnd.mtxp = NULL;
   prio_insert(currp, &cp->c_queue);
   msg = chSchGoSleepTimeoutS(THD_STATE_WTCOND, time);
   if (msg != RDY_TIMEOUT)
@@ -86,11 +86,32 @@ void chMBReset(Mailbox *mbp) {
   chDbgCheck(mbp != NULL, "chMBReset");
 
   chSysLock();
+  chMBResetI(mbp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Resets a Mailbox object.
+ * @details All the waiting threads are resumed with status @p RDY_RESET and
+ *          the queued messages are lost.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ *
+ * @iclass
+ */
+void chMBResetI(Mailbox *mbp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(mbp != NULL, "chMBResetI");
+
   mbp->mb_wrptr = mbp->mb_rdptr = mbp->mb_buffer;
   chSemResetI(&mbp->mb_emptysem, mbp->mb_top - mbp->mb_buffer);
   chSemResetI(&mbp->mb_fullsem, 0);
-  chSchRescheduleS();
-  chSysUnlock();
 }
 
 /**
@@ -69,6 +69,82 @@
 
 #if CH_USE_MUTEXES || defined(__DOXYGEN__)
 
+/**
+ * @brief   Boosts the priority of a thread owning a resource.
+ * @details The priority inheritance protocol explores the thread-mutex
+ *          dependencies boosting the priority of all the affected threads
+ *          to equal the specified priority.
+ *
+ * @param[in] tp        pointer to the thread owning the resource
+ * @param[in] prio      the priority of the thread waiting on the resource
+ *
+ * @notapi
+ */
+void _mtx_boost(Thread *tp, tprio_t prio) {
+
+  /* Does the waiting thread have higher priority than the owning thread? */
+  while (tp->p_prio < prio) {
+    /* Make priority of thread tp match the waiting thread's priority.*/
+    tp->p_prio = prio;
+    /* The following states need priority queues reordering.*/
+    switch (tp->p_state) {
+    case THD_STATE_WTMTX:
+      /* Re-enqueues the mutex owner with its new priority.*/
+      prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
+      tp = ((Mutex *)tp->p_u.wtobjp)->m_owner;
+      continue;
+#if CH_USE_CONDVARS | CH_USE_RWLOCKS |                                      \
+    (CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY) |                     \
+    (CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY)
+#if CH_USE_CONDVARS
+    case THD_STATE_WTCOND:
+#endif
+#if CH_USE_RWLOCKS
+    case THD_STATE_WTRWLOCK:
+#endif
+#if CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY
+    case THD_STATE_WTSEM:
+#endif
+#if CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY
+    case THD_STATE_SNDMSGQ:
+#endif
+      /* Re-enqueues tp with its new priority on the queue.*/
+      prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
+      break;
+#endif
+    case THD_STATE_READY:
+#if CH_DBG_ENABLE_ASSERTS
+      /* Prevents an assertion in chSchReadyI().*/
+      tp->p_state = THD_STATE_CURRENT;
+#endif
+      /* Re-enqueues tp with its new priority on the ready list.*/
+      chSchReadyI(dequeue(tp));
+      break;
+    }
+    break;
+  }
+}
+
+/**
+ * @brief   Inserts a thread in the queue of an owned mutex.
+ * @details The priority of the mutex owner is boosted according to the
+ *          priority inheritance protocol.
+ * @pre     The mutex must be owned by a thread other than @p tp.
+ * @post    The caller is responsible of putting the thread in the
+ *          @p THD_STATE_WTMTX state.
+ *
+ * @param[in] mp        pointer to the @p Mutex structure
+ * @param[in] tp        pointer to the thread to be enqueued
+ *
+ * @notapi
+ */
+void _mtx_enqueue(Mutex *mp, Thread *tp) {
+
+  _mtx_boost(mp->m_owner, tp->p_prio);
+  prio_insert(tp, &mp->m_queue);
+  tp->p_u.wtobjp = mp;
+}
+
 /**
  * @brief   Initializes s @p Mutex structure.
  *
@@ -119,52 +195,8 @@ void chMtxLockS(Mutex *mp) {
 
   /* Is the mutex already locked? */
   if (mp->m_owner != NULL) {
-    /* Priority inheritance protocol; explores the thread-mutex dependencies
-       boosting the priority of all the affected threads to equal the priority
-       of the running thread requesting the mutex.*/
-    Thread *tp = mp->m_owner;
-    /* Does the running thread have higher priority than the mutex
-       owning thread? */
-    while (tp->p_prio < ctp->p_prio) {
-      /* Make priority of thread tp match the running thread's priority.*/
-      tp->p_prio = ctp->p_prio;
-      /* The following states need priority queues reordering.*/
-      switch (tp->p_state) {
-      case THD_STATE_WTMTX:
-        /* Re-enqueues the mutex owner with its new priority.*/
-        prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
-        tp = ((Mutex *)tp->p_u.wtobjp)->m_owner;
-        continue;
-#if CH_USE_CONDVARS |                                                       \
-    (CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY) |                     \
-    (CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY)
-#if CH_USE_CONDVARS
-      case THD_STATE_WTCOND:
-#endif
-#if CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY
-      case THD_STATE_WTSEM:
-#endif
-#if CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY
-      case THD_STATE_SNDMSGQ:
-#endif
-        /* Re-enqueues tp with its new priority on the queue.*/
-        prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
-        break;
-#endif
-      case THD_STATE_READY:
-#if CH_DBG_ENABLE_ASSERTS
-        /* Prevents an assertion in chSchReadyI().*/
-        tp->p_state = THD_STATE_CURRENT;
-#endif
-        /* Re-enqueues tp with its new priority on the ready list.*/
-        chSchReadyI(dequeue(tp));
-        break;
-      }
-      break;
-    }
     /* Sleep on the mutex.*/
-    prio_insert(ctp, &mp->m_queue);
-    ctp->p_u.wtobjp = mp;
+    _mtx_enqueue(mp, ctp);
     chSchGoSleepS(THD_STATE_WTMTX);
     /* It is assumed that the thread performing the unlock operation assigns
        the mutex to this thread.*/
@@ -269,6 +301,9 @@ Mutex *chMtxUnlock(void) {
     /* Recalculates the optimal thread priority by scanning the owned
        mutexes list.*/
     tprio_t newprio = ctp->p_realprio;
+#if CH_USE_RWLOCKS
+    newprio = _rw_inherited_prio(ctp, newprio);
+#endif
     mp = ctp->p_mtxlist;
     while (mp != NULL) {
       /* If the highest priority thread waiting in the mutexes list has a
@@ -330,6 +365,9 @@ Mutex *chMtxUnlockS(void) {
     /* Recalculates the optimal thread priority by scanning the owned
        mutexes list.*/
     tprio_t newprio = ctp->p_realprio;
+#if CH_USE_RWLOCKS
+    newprio = _rw_inherited_prio(ctp, newprio);
+#endif
     mp = ctp->p_mtxlist;
     while (mp != NULL) {
       /* If the highest priority thread waiting in the mutexes list has a
@@ -382,7 +420,11 @@ void chMtxUnlockAll(void) {
       else
         ump->m_owner = NULL;
     } while (ctp->p_mtxlist != NULL);
+#if CH_USE_RWLOCKS
+    ctp->p_prio = _rw_inherited_prio(ctp, ctp->p_realprio);
+#else
     ctp->p_prio = ctp->p_realprio;
+#endif
     chSchRescheduleS();
   }
   chSysUnlock();
@@ -0,0 +1,499 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chobjfifos.c
+ * @brief   Objects FIFOs code.
+ *
+ * @addtogroup objects_fifos
+ * @details Objects FIFOs related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          An objects FIFO is a zero-copy communication mechanism between
+ *          threads and/or interrupt handlers. It combines a pool of fixed
+ *          size objects and a mailbox-like queue of pointers to those
+ *          objects.<br>
+ *          Operations defined for objects FIFOs:
+ *          - <b>Take</b>: A free object is taken from the FIFO pool, the
+ *            invoking thread can wait for an object to become available.
+ *          - <b>Send</b>: A taken object, after being filled, is posted in
+ *            FIFO order. This operation never blocks because the queue has
+ *            a slot for each object.
+ *          - <b>Receive</b>: A posted object is fetched from the queue,
+ *            the invoking thread can wait for an object to be posted.
+ *          - <b>Return</b>: A received object, after being processed, is
+ *            returned to the FIFO pool.
+ *          .
+ *          Send, receive and return operations have batch variants that
+ *          handle several objects within a single critical zone and with a
+ *          single reschedule.
+ * @pre     In order to use the objects FIFOs APIs the @p CH_USE_OBJFIFOS
+ *          option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an @p ObjectsFifo object.
+ * @pre     The objects must be properly aligned to contain a pointer to
+ *          void.
+ *
+ * @param[out] ofp      pointer to the @p ObjectsFifo structure to be
+ *                      initialized
+ * @param[in] objsize   size of the objects, the minimum accepted size is the
+ *                      size of a pointer to void
+ * @param[in] objn      number of objects in the objects buffer
+ * @param[in] objbuf    pointer to the objects buffer, an array of @p objn
+ *                      elements of @p objsize bytes
+ * @param[in] msgbuf    pointer to the pointers buffer, an array of @p objn
+ *                      pointers to void
+ *
+ * @init
+ */
+void chFifoInit(ObjectsFifo *ofp, size_t objsize, cnt_t objn,
+                void *objbuf, void **msgbuf) {
+
+  chDbgCheck((ofp != NULL) && (objn > 0) &&
+             (objbuf != NULL) && (msgbuf != NULL), "chFifoInit");
+
+  chPoolInit(&ofp->of_pool, objsize, NULL);
+  chPoolLoadArray(&ofp->of_pool, objbuf, (size_t)objn);
+  chSemInit(&ofp->of_freesem, objn);
+  ofp->of_buffer = ofp->of_wrptr = ofp->of_rdptr = msgbuf;
+  ofp->of_top = &msgbuf[objn];
+  chSemInit(&ofp->of_fullsem, 0);
+}
+
+/**
+ * @brief   Takes a free object from an objects FIFO.
+ * @details The invoking thread waits until a free object becomes available
+ *          or the specified time runs out.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the free object.
+ * @retval NULL         if the operation has timed out.
+ *
+ * @api
+ */
+void *chFifoTakeObject(ObjectsFifo *ofp, systime_t time) {
+  void *objp;
+
+  chSysLock();
+  objp = chFifoTakeObjectS(ofp, time);
+  chSysUnlock();
+  return objp;
+}
+
+/**
+ * @brief   Takes a free object from an objects FIFO.
+ * @details The invoking thread waits until a free object becomes available
+ *          or the specified time runs out.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the free object.
+ * @retval NULL         if the operation has timed out.
+ *
+ * @sclass
+ */
+void *chFifoTakeObjectS(ObjectsFifo *ofp, systime_t time) {
+
+  chDbgCheckClassS();
+  chDbgCheck(ofp != NULL, "chFifoTakeObjectS");
+
+  if (chSemWaitTimeoutS(&ofp->of_freesem, time) != RDY_OK)
+    return NULL;
+  return chPoolAllocI(&ofp->of_pool);
+}
+
+/**
+ * @brief   Takes a free object from an objects FIFO.
+ * @details This variant is non-blocking, the function returns @p NULL if
+ *          there are no free objects.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @return              The pointer to the free object.
+ * @retval NULL         if there are no free objects.
+ *
+ * @iclass
+ */
+void *chFifoTakeObjectI(ObjectsFifo *ofp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(ofp != NULL, "chFifoTakeObjectI");
+
+  if (chSemGetCounterI(&ofp->of_freesem) <= 0)
+    return NULL;
+  chSemFastWaitI(&ofp->of_freesem);
+  return chPoolAllocI(&ofp->of_pool);
+}
+
+/**
+ * @brief   Returns an object to the objects FIFO pool.
+ * @pre     The object must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objp      pointer to the object to be returned
+ *
+ * @api
+ */
+void chFifoReturnObject(ObjectsFifo *ofp, void *objp) {
+
+  chSysLock();
+  chFifoReturnObjectI(ofp, objp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns an object to the objects FIFO pool.
+ * @pre     The object must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objp      pointer to the object to be returned
+ *
+ * @iclass
+ */
+void chFifoReturnObjectI(ObjectsFifo *ofp, void *objp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objp != NULL), "chFifoReturnObjectI");
+
+  chPoolFreeI(&ofp->of_pool, objp);
+  chSemSignalI(&ofp->of_freesem);
+}
+
+/**
+ * @brief   Returns several objects to the objects FIFO pool.
+ * @pre     The objects must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objpp     pointer to an array of pointers to the objects
+ * @param[in] n         number of objects in the array
+ *
+ * @api
+ */
+void chFifoReturnObjects(ObjectsFifo *ofp, void * const *objpp, cnt_t n) {
+
+  chSysLock();
+  chFifoReturnObjectsI(ofp, objpp, n);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns several objects to the objects FIFO pool.
+ * @pre     The objects must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objpp     pointer to an array of pointers to the objects
+ * @param[in] n         number of objects in the array
+ *
+ * @iclass
+ */
+void chFifoReturnObjectsI(ObjectsFifo *ofp, void * const *objpp, cnt_t n) {
+  cnt_t i;
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objpp != NULL) && (n > 0),
+             "chFifoReturnObjectsI");
+
+  for (i = 0; i < n; i++)
+    chPoolFreeI(&ofp->of_pool, objpp[i]);
+  chSemAddCounterI(&ofp->of_freesem, n);
+}
+
+/**
+ * @brief   Posts an object into an objects FIFO.
+ * @details The object is enqueued in FIFO order, the operation never blocks
+ *          because the queue has a slot for each object.
+ * @pre     The object must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @api
+ */
+void chFifoSendObject(ObjectsFifo *ofp, void *objp) {
+
+  chSysLock();
+  chFifoSendObjectS(ofp, objp);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Posts an object into an objects FIFO.
+ * @details The object is enqueued in FIFO order, the operation never blocks
+ *          because the queue has a slot for each object.
+ * @pre     The object must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @sclass
+ */
+void chFifoSendObjectS(ObjectsFifo *ofp, void *objp) {
+
+  chDbgCheckClassS();
+
+  chFifoSendObjectI(ofp, objp);
+  chSchRescheduleS();
+}
+
+/**
+ * @brief   Posts an object into an objects FIFO.
+ * @details The object is enqueued in FIFO order, the operation never blocks
+ *          because the queue has a slot for each object.
+ * @pre     The object must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objp      pointer to the object to be posted
+ *
+ * @iclass
+ */
+void chFifoSendObjectI(ObjectsFifo *ofp, void *objp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objp != NULL), "chFifoSendObjectI");
+
+  *ofp->of_wrptr++ = objp;
+  if (ofp->of_wrptr >= ofp->of_top)
+    ofp->of_wrptr = ofp->of_buffer;
+  chSemSignalI(&ofp->of_fullsem);
+}
+
+/**
+ * @brief   Posts several objects into an objects FIFO.
+ * @details The objects are enqueued in FIFO order within a single critical
+ *          zone, the waiting receivers are rescheduled only once.
+ * @pre     The objects must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objpp     pointer to an array of pointers to the objects
+ * @param[in] n         number of objects in the array
+ *
+ * @api
+ */
+void chFifoSendObjects(ObjectsFifo *ofp, void * const *objpp, cnt_t n) {
+
+  chSysLock();
+  chFifoSendObjectsI(ofp, objpp, n);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Posts several objects into an objects FIFO.
+ * @details The objects are enqueued in FIFO order.
+ * @pre     The objects must have been taken from the same objects FIFO.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[in] objpp     pointer to an array of pointers to the objects
+ * @param[in] n         number of objects in the array
+ *
+ * @iclass
+ */
+void chFifoSendObjectsI(ObjectsFifo *ofp, void * const *objpp, cnt_t n) {
+  cnt_t i;
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objpp != NULL) && (n > 0),
+             "chFifoSendObjectsI");
+
+  for (i = 0; i < n; i++) {
+    *ofp->of_wrptr++ = objpp[i];
+    if (ofp->of_wrptr >= ofp->of_top)
+      ofp->of_wrptr = ofp->of_buffer;
+  }
+  chSemAddCounterI(&ofp->of_fullsem, n);
+}
+
+/**
+ * @brief   Retrieves an object from an objects FIFO.
+ * @details The invoking thread waits until an object is posted in the FIFO
+ *          or the specified time runs out.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[out] objpp    pointer to a pointer to the received object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t chFifoReceiveObject(ObjectsFifo *ofp, void **objpp, systime_t time) {
+  msg_t rdymsg;
+
+  chSysLock();
+  rdymsg = chFifoReceiveObjectS(ofp, objpp, time);
+  chSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves an object from an objects FIFO.
+ * @details The invoking thread waits until an object is posted in the FIFO
+ *          or the specified time runs out.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[out] objpp    pointer to a pointer to the received object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t chFifoReceiveObjectS(ObjectsFifo *ofp, void **objpp, systime_t time) {
+  msg_t rdymsg;
+
+  chDbgCheckClassS();
+  chDbgCheck((ofp != NULL) && (objpp != NULL), "chFifoReceiveObjectS");
+
+  rdymsg = chSemWaitTimeoutS(&ofp->of_fullsem, time);
+  if (rdymsg == RDY_OK) {
+    *objpp = *ofp->of_rdptr++;
+    if (ofp->of_rdptr >= ofp->of_top)
+      ofp->of_rdptr = ofp->of_buffer;
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves an object from an objects FIFO.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the FIFO is empty.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[out] objpp    pointer to a pointer to the received object
+ * @return              The operation status.
+ * @retval RDY_OK       if an object has been correctly fetched.
+ * @retval RDY_TIMEOUT  if the FIFO is empty.
+ *
+ * @iclass
+ */
+msg_t chFifoReceiveObjectI(ObjectsFifo *ofp, void **objpp) {
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objpp != NULL), "chFifoReceiveObjectI");
+
+  if (chSemGetCounterI(&ofp->of_fullsem) <= 0)
+    return RDY_TIMEOUT;
+  chSemFastWaitI(&ofp->of_fullsem);
+  *objpp = *ofp->of_rdptr++;
+  if (ofp->of_rdptr >= ofp->of_top)
+    ofp->of_rdptr = ofp->of_buffer;
+  return RDY_OK;
+}
+
+/**
+ * @brief   Retrieves several objects from an objects FIFO.
+ * @details The invoking thread waits until at least an object is posted in
+ *          the FIFO or the specified time runs out, then all the available
+ *          objects, up to @p n, are fetched within the same critical zone.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[out] objpp    pointer to an array of pointers receiving the objects
+ * @param[in] n         maximum number of objects to be fetched
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of fetched objects.
+ * @retval 0            if the operation has timed out.
+ *
+ * @api
+ */
+cnt_t chFifoReceiveObjects(ObjectsFifo *ofp, void **objpp, cnt_t n,
+                           systime_t time) {
+  cnt_t k;
+
+  chDbgCheck((ofp != NULL) && (objpp != NULL) && (n > 0),
+             "chFifoReceiveObjects");
+
+  chSysLock();
+  if (chFifoReceiveObjectS(ofp, objpp, time) != RDY_OK) {
+    chSysUnlock();
+    return 0;
+  }
+  k = 1;
+  if (n > 1)
+    k += chFifoReceiveObjectsI(ofp, objpp + 1, n - 1);
+  chSysUnlock();
+  return k;
+}
+
+/**
+ * @brief   Retrieves several objects from an objects FIFO.
+ * @details This variant is non-blocking, all the available objects, up to
+ *          @p n, are fetched.
+ *
+ * @param[in] ofp       pointer to an initialized @p ObjectsFifo object
+ * @param[out] objpp    pointer to an array of pointers receiving the objects
+ * @param[in] n         maximum number of objects to be fetched
+ * @return              The number of fetched objects.
+ * @retval 0            if the FIFO is empty.
+ *
+ * @iclass
+ */
+cnt_t chFifoReceiveObjectsI(ObjectsFifo *ofp, void **objpp, cnt_t n) {
+  cnt_t k;
+
+  chDbgCheckClassI();
+  chDbgCheck((ofp != NULL) && (objpp != NULL) && (n > 0),
+             "chFifoReceiveObjectsI");
+
+  k = chSemGetCounterI(&ofp->of_fullsem);
+  if (k <= 0)
+    return 0;
+  if (k > n)
+    k = n;
+  ofp->of_fullsem.s_cnt -= k;
+  n = k;
+  while (n--) {
+    *objpp++ = *ofp->of_rdptr++;
+    if (ofp->of_rdptr >= ofp->of_top)
+      ofp->of_rdptr = ofp->of_buffer;
+  }
+  return k;
+}
+#endif /* CH_USE_OBJFIFOS */
+
+/** @} */
@@ -41,6 +41,8 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
@@ -94,6 +96,9 @@ void chIQInit(InputQueue *iqp, uint8_t *bp, size_t size, qnotify_t infy,
   iqp->q_top = bp + size;
   iqp->q_notify = infy;
   iqp->q_link = link;
+#if CH_USE_WAITOBJECTS
+  chEvtInit(&iqp->q_event);
+#endif
 }
 
 /**
@@ -144,10 +149,86 @@ msg_t chIQPutI(InputQueue *iqp, uint8_t b) {
 
   if (notempty(&iqp->q_waiting))
     chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+#if CH_USE_WAITOBJECTS
+  /* Readiness is only broadcast on the empty to non-empty transition.*/
+  if (iqp->q_counter == 1)
+    chEvtBroadcastI(&iqp->q_event);
+#endif
 
   return Q_OK;
 }
 
+/**
+ * @brief   Input queue commit.
+ * @details Makes readable @p n bytes already written in the buffer by the
+ *          caller, the write pointer must have been advanced accordingly.
+ *          The threads waiting for data are resumed.
+ * @note    This function is meant for drivers filling the queue buffer
+ *          directly, for example from an hardware FIFO.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] n         number of bytes written in the buffer, it must not
+ *                      exceed the empty space in the queue
+ *
+ * @iclass
+ */
+void chIQCommitI(InputQueue *iqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck(n <= chIQGetEmptyI(iqp), "chIQCommitI");
+
+  if (n == 0)
+    return;
+
+  iqp->q_counter += n;
+  while (notempty(&iqp->q_waiting))
+    chSchReadyI(fifo_remove(&iqp->q_waiting))->p_u.rdymsg = Q_OK;
+#if CH_USE_WAITOBJECTS
+  /* Readiness is only broadcast on the empty to non-empty transition.*/
+  if (iqp->q_counter == n)
+    chEvtBroadcastI(&iqp->q_event);
+#endif
+}
+
+/**
+ * @brief   Input queue bulk write.
+ * @details Copies up to @p n bytes from a buffer into the low end of an
+ *          input queue, the threads waiting for data are resumed.
+ * @note    The copy is performed within the critical zone, the caller
+ *          should bound @p n in order to bound the interrupts latency.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         maximum number of bytes to be written
+ * @return              The number of bytes written, it is lower than
+ *                      @p n if the queue becomes full.
+ *
+ * @iclass
+ */
+size_t chIQWriteI(InputQueue *iqp, const uint8_t *bp, size_t n) {
+  size_t streak;
+
+  chDbgCheckClassI();
+
+  if (n > chIQGetEmptyI(iqp))
+    n = chIQGetEmptyI(iqp);
+  if (n == 0)
+    return 0;
+
+  streak = (size_t)(iqp->q_top - iqp->q_wrptr);
+  if (streak > n)
+    streak = n;
+  memcpy(iqp->q_wrptr, bp, streak);
+  memcpy(iqp->q_buffer, bp + streak, n - streak);
+  if (streak < n)
+    iqp->q_wrptr = iqp->q_buffer + (n - streak);
+  else if ((iqp->q_wrptr += n) >= iqp->q_top)
+    iqp->q_wrptr = iqp->q_buffer;
+
+  chIQCommitI(iqp, n);
+  return n;
+}
+
 /**
  * @brief   Input queue read with timeout.
  * @details This function reads a byte value from an input queue. If the queue
@@ -274,6 +355,9 @@ void chOQInit(OutputQueue *oqp, uint8_t *bp, size_t size, qnotify_t onfy,
   oqp->q_top = bp + size;
   oqp->q_notify = onfy;
   oqp->q_link = link;
+#if CH_USE_WAITOBJECTS
+  chEvtInit(&oqp->q_event);
+#endif
 }
 
 /**
@@ -295,6 +379,9 @@ void chOQResetI(OutputQueue *oqp) {
   oqp->q_counter = chQSizeI(oqp);
   while (notempty(&oqp->q_waiting))
     chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_RESET;
+#if CH_USE_WAITOBJECTS
+  chEvtBroadcastI(&oqp->q_event);
+#endif
 }
 
 /**
@@ -368,10 +455,86 @@ msg_t chOQGetI(OutputQueue *oqp) {
 
   if (notempty(&oqp->q_waiting))
     chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+#if CH_USE_WAITOBJECTS
+  /* Readiness is only broadcast on the full to non-full transition.*/
+  if (oqp->q_counter == 1)
+    chEvtBroadcastI(&oqp->q_event);
+#endif
 
   return b;
 }
 
+/**
+ * @brief   Output queue release.
+ * @details Makes writable @p n bytes already read from the buffer by the
+ *          caller, the read pointer must have been advanced accordingly.
+ *          The threads waiting for space are resumed.
+ * @note    This function is meant for drivers emptying the queue buffer
+ *          directly, for example into an hardware FIFO.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] n         number of bytes read from the buffer, it must not
+ *                      exceed the data in the queue
+ *
+ * @iclass
+ */
+void chOQReleaseI(OutputQueue *oqp, size_t n) {
+
+  chDbgCheckClassI();
+  chDbgCheck(n <= chOQGetFullI(oqp), "chOQReleaseI");
+
+  if (n == 0)
+    return;
+
+  oqp->q_counter += n;
+  while (notempty(&oqp->q_waiting))
+    chSchReadyI(fifo_remove(&oqp->q_waiting))->p_u.rdymsg = Q_OK;
+#if CH_USE_WAITOBJECTS
+  /* Readiness is only broadcast on the full to non-full transition.*/
+  if (oqp->q_counter == n)
+    chEvtBroadcastI(&oqp->q_event);
+#endif
+}
+
+/**
+ * @brief   Output queue bulk read.
+ * @details Copies up to @p n bytes from the low end of an output queue into
+ *          a buffer, the threads waiting for space are resumed.
+ * @note    The copy is performed within the critical zone, the caller
+ *          should bound @p n in order to bound the interrupts latency.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         maximum number of bytes to be read
+ * @return              The number of bytes read, it is lower than @p n if
+ *                      the queue becomes empty.
+ *
+ * @iclass
+ */
+size_t chOQReadI(OutputQueue *oqp, uint8_t *bp, size_t n) {
+  size_t streak;
+
+  chDbgCheckClassI();
+
+  if (n > chOQGetFullI(oqp))
+    n = chOQGetFullI(oqp);
+  if (n == 0)
+    return 0;
+
+  streak = (size_t)(oqp->q_top - oqp->q_rdptr);
+  if (streak > n)
+    streak = n;
+  memcpy(bp, oqp->q_rdptr, streak);
+  memcpy(bp + streak, oqp->q_buffer, n - streak);
+  if (streak < n)
+    oqp->q_rdptr = oqp->q_buffer + (n - streak);
+  else if ((oqp->q_rdptr += n) >= oqp->q_top)
+    oqp->q_rdptr = oqp->q_buffer;
+
+  chOQReleaseI(oqp, n);
+  return n;
+}
+
 
 /**
  * @brief   Output queue write with timeout.
@@ -0,0 +1,557 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chrwlock.c
+ * @brief   Reader-writer locks code.
+ *
+ * @addtogroup rwlocks
+ * @details Reader-writer locks related APIs and services.
+ *
+ *          <h2>Operation mode</h2>
+ *          A reader-writer lock can be held by a single writer or by any
+ *          number of readers at the same time.<br>
+ *          The lock policy decides which threads enter first when the lock
+ *          is contended:
+ *          - <b>RW_PREFER_READERS</b>: readers enter as long as the lock is
+ *            not held for writing, writers can starve.
+ *          - <b>RW_PREFER_WRITERS</b>: readers wait if a writer is waiting,
+ *            the waiting writers enter first when the lock is released.
+ *          .
+ *          Reader-writer locks implement the same priority inheritance
+ *          algorithm of the mutexes, a thread waiting on the lock boosts
+ *          the priority of the writer or of all the readers holding it.
+ *          Priority inheritance propagates through the mutexes owned by
+ *          the boosted threads but not through reader-writer locks the
+ *          boosted threads are waiting on.<br>
+ *          Constraints:
+ *          - A thread can hold up to @p CH_RWLOCK_READ_HOLDS different
+ *            reader-writer locks for reading at time, further read locks
+ *            are rejected with @p RDY_RESET in all builds.
+ *          - Read locks can be nested on the same lock, write locks can
+ *            be nested like mutexes. A thread holding a lock for writing
+ *            cannot lock it again.
+ *          - A thread timing out on a lock does not revert the priority
+ *            boost it gave, the boost lasts until the lock is released.
+ *          .
+ * @pre     In order to use the reader-writer lock APIs the
+ *          @p CH_USE_RWLOCKS option must be enabled in @p chconf.h.
+ * @post    Enabling reader-writer locks requires a pointer and
+ *          @p CH_RWLOCK_READ_HOLDS reader records in the @p Thread
+ *          structure.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Returns the highest priority among the threads waiting on a
+ *          reader-writer lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @return              The highest priority or @p NOPRIO if there are no
+ *                      waiting threads.
+ *
+ * @notapi
+ */
+static tprio_t rw_waiters_prio(RWLock *rwp) {
+  tprio_t prio = NOPRIO;
+
+  if (notempty(&rwp->rw_rdqueue))
+    prio = rwp->rw_rdqueue.p_next->p_prio;
+  if (notempty(&rwp->rw_wrqueue) && (rwp->rw_wrqueue.p_next->p_prio > prio))
+    prio = rwp->rw_wrqueue.p_next->p_prio;
+  return prio;
+}
+
+/**
+ * @brief   Boosts the threads holding a reader-writer lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] prio      the priority of the waiting thread
+ *
+ * @notapi
+ */
+static void rw_boost(RWLock *rwp, tprio_t prio) {
+  RWReader *rp;
+
+  if (rwp->rw_owner != NULL)
+    _mtx_boost(rwp->rw_owner, prio);
+  else {
+    for (rp = rwp->rw_readers; rp != NULL; rp = rp->rr_next)
+      _mtx_boost(rp->rr_thread, prio);
+  }
+}
+
+/**
+ * @brief   Finds the reader record of a thread for a reader-writer lock.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] rwp       pointer to the @p RWLock structure or @p NULL in
+ *                      order to find a free record
+ * @return              The reader record or @p NULL if not found.
+ *
+ * @notapi
+ */
+static RWReader *rw_find_reader(Thread *tp, RWLock *rwp) {
+  RWReader *rp = tp->p_rdholds;
+
+  while (rp < &tp->p_rdholds[CH_RWLOCK_READ_HOLDS]) {
+    if (rp->rr_lock == rwp)
+      return rp;
+    rp++;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Adds a thread to the readers holding a reader-writer lock.
+ * @pre     The thread must have a free reader record.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] tp        pointer to the reader thread
+ *
+ * @notapi
+ */
+static void rw_add_reader(RWLock *rwp, Thread *tp) {
+  RWReader *rp = rw_find_reader(tp, NULL);
+
+  rp->rr_lock = rwp;
+  rp->rr_thread = tp;
+  rp->rr_cnt = 1;
+  rp->rr_next = rwp->rw_readers;
+  rwp->rw_readers = rp;
+}
+
+/**
+ * @brief   Makes a thread the writer holding a reader-writer lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] tp        pointer to the writer thread
+ *
+ * @notapi
+ */
+static void rw_set_owner(RWLock *rwp, Thread *tp) {
+
+  rwp->rw_owner = tp;
+  rwp->rw_next = tp->p_rwlist;
+  tp->p_rwlist = rwp;
+}
+
+/**
+ * @brief   Makes all the waiting readers enter a reader-writer lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @notapi
+ */
+static void rw_wakeup_readers(RWLock *rwp) {
+
+  while (notempty(&rwp->rw_rdqueue)) {
+    Thread *tp = fifo_remove(&rwp->rw_rdqueue);
+    rw_add_reader(rwp, tp);
+    chSchReadyI(tp)->p_u.rdymsg = RDY_OK;
+  }
+}
+
+/**
+ * @brief   Assigns a released reader-writer lock to the waiting threads.
+ * @details The waiting threads enter the lock according to the lock
+ *          policy, the new holders inherit the priority of the threads
+ *          still waiting.
+ * @pre     The lock must not be held.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @notapi
+ */
+static void rw_grant(RWLock *rwp) {
+
+  if (notempty(&rwp->rw_wrqueue) &&
+      ((rwp->rw_policy == RW_PREFER_WRITERS) || isempty(&rwp->rw_rdqueue))) {
+    Thread *tp = fifo_remove(&rwp->rw_wrqueue);
+    rw_set_owner(rwp, tp);
+    chSchReadyI(tp)->p_u.rdymsg = RDY_OK;
+  }
+  else
+    rw_wakeup_readers(rwp);
+  rw_boost(rwp, rw_waiters_prio(rwp));
+}
+
+/**
+ * @brief   Recalculates the priority of a thread releasing a lock.
+ * @details The thread priority is set to the highest priority among its
+ *          base priority and the threads waiting on the owned mutexes and
+ *          reader-writer locks.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+static void rw_restore_prio(Thread *tp) {
+  tprio_t newprio = _rw_inherited_prio(tp, tp->p_realprio);
+  Mutex *mp = tp->p_mtxlist;
+
+  while (mp != NULL) {
+    if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
+      newprio = mp->m_queue.p_next->p_prio;
+    mp = mp->m_next;
+  }
+  tp->p_prio = newprio;
+}
+
+/**
+ * @brief   Returns the priority inherited through reader-writer locks.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] prio      the priority inherited from other sources
+ * @return              The highest priority among @p prio and the threads
+ *                      waiting on the locks held by @p tp.
+ *
+ * @notapi
+ */
+tprio_t _rw_inherited_prio(Thread *tp, tprio_t prio) {
+  RWLock *rwp = tp->p_rwlist;
+  RWReader *rp;
+  tprio_t p;
+
+  while (rwp != NULL) {
+    if ((p = rw_waiters_prio(rwp)) > prio)
+      prio = p;
+    rwp = rwp->rw_next;
+  }
+  for (rp = tp->p_rdholds; rp < &tp->p_rdholds[CH_RWLOCK_READ_HOLDS]; rp++) {
+    if ((rp->rr_lock != NULL) && ((p = rw_waiters_prio(rp->rr_lock)) > prio))
+      prio = p;
+  }
+  return prio;
+}
+
+/**
+ * @brief   Initializes s @p RWLock structure.
+ *
+ * @param[out] rwp      pointer to a @p RWLock structure
+ * @param[in] policy    the lock policy, @p RW_PREFER_READERS or
+ *                      @p RW_PREFER_WRITERS
+ *
+ * @init
+ */
+void chRWLockInit(RWLock *rwp, uint8_t policy) {
+
+  chDbgCheck((rwp != NULL) && (policy <= RW_PREFER_WRITERS), "chRWLockInit");
+
+  queue_init(&rwp->rw_rdqueue);
+  queue_init(&rwp->rw_wrqueue);
+  rwp->rw_owner = NULL;
+  rwp->rw_readers = NULL;
+  rwp->rw_policy = policy;
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for reading.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_RESET    if the thread cannot hold the lock for reading, see
+ *                      @p chRWLockReadLockTimeoutS().
+ *
+ * @api
+ */
+msg_t chRWLockReadLock(RWLock *rwp) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockReadLockTimeoutS(rwp, TIME_INFINITE);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for reading.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ * @retval RDY_RESET    if the thread cannot hold the lock for reading, see
+ *                      @p chRWLockReadLockTimeoutS().
+ *
+ * @api
+ */
+msg_t chRWLockReadLockTimeout(RWLock *rwp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockReadLockTimeoutS(rwp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for reading.
+ * @details A thread already holding the lock for reading enters it again
+ *          regardless of the lock policy, the lock is released after the
+ *          same number of unlocks.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ * @retval RDY_RESET    if the thread already holds the lock for writing or
+ *                      already holds @p CH_RWLOCK_READ_HOLDS other locks
+ *                      for reading.
+ *
+ * @sclass
+ */
+msg_t chRWLockReadLockTimeoutS(RWLock *rwp, systime_t time) {
+  Thread *ctp = currp;
+  RWReader *rp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockReadLockTimeoutS");
+
+  /* Nested read lock.*/
+  if ((rp = rw_find_reader(ctp, rwp)) != NULL) {
+    rp->rr_cnt++;
+    return RDY_OK;
+  }
+
+  /* Read locks that would deadlock or that have no free reader record
+     are rejected.*/
+  if ((rwp->rw_owner == ctp) || (rw_find_reader(ctp, NULL) == NULL))
+    return RDY_RESET;
+
+  if ((rwp->rw_owner == NULL) &&
+      ((rwp->rw_policy == RW_PREFER_READERS) || isempty(&rwp->rw_wrqueue))) {
+    rw_add_reader(rwp, ctp);
+    return RDY_OK;
+  }
+  if (TIME_IMMEDIATE == time)
+    return RDY_TIMEOUT;
+
+  /* Sleep on the lock, when awakened the lock has been already assigned to
+     this thread by the releasing thread.*/
+  rw_boost(rwp, ctp->p_prio);
+  prio_insert(ctp, &rwp->rw_rdqueue);
+  ctp->p_u.wtobjp = &rwp->rw_rdqueue;
+  return chSchGoSleepTimeoutS(THD_STATE_WTRWLOCK, time);
+}
+
+/**
+ * @brief   Unlocks a reader-writer lock held for reading.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+void chRWLockReadUnlock(RWLock *rwp) {
+
+  chSysLock();
+  chRWLockReadUnlockS(rwp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Unlocks a reader-writer lock held for reading.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @sclass
+ */
+void chRWLockReadUnlockS(RWLock *rwp) {
+  Thread *ctp = currp;
+  RWReader *rp, **rpp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockReadUnlockS");
+  rp = rw_find_reader(ctp, rwp);
+  chDbgAssert(rp != NULL,
+              "chRWLockReadUnlockS(), #1",
+              "not holding the lock for reading");
+
+  if (--rp->rr_cnt > 0)
+    return;
+
+  /* Removes the reader record from the readers list.*/
+  rpp = &rwp->rw_readers;
+  while (*rpp != rp)
+    rpp = &(*rpp)->rr_next;
+  *rpp = rp->rr_next;
+  rp->rr_lock = NULL;
+
+  /* The last reader assigns the lock to the waiting writer, if any.*/
+  if (rwp->rw_readers == NULL)
+    rw_grant(rwp);
+  rw_restore_prio(ctp);
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for writing.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+void chRWLockWriteLock(RWLock *rwp) {
+
+  chSysLock();
+  chRWLockWriteLockTimeoutS(rwp, TIME_INFINITE);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for writing.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t chRWLockWriteLockTimeout(RWLock *rwp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockWriteLockTimeoutS(rwp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Locks the specified reader-writer lock for writing.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @sclass
+ */
+msg_t chRWLockWriteLockTimeoutS(RWLock *rwp, systime_t time) {
+  Thread *ctp = currp;
+  msg_t msg;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockWriteLockTimeoutS");
+  chDbgAssert((rwp->rw_owner != ctp) && (rw_find_reader(ctp, rwp) == NULL),
+              "chRWLockWriteLockTimeoutS(), #1",
+              "already holding the lock");
+
+  if ((rwp->rw_owner == NULL) && (rwp->rw_readers == NULL)) {
+    rw_set_owner(rwp, ctp);
+    return RDY_OK;
+  }
+  if (TIME_IMMEDIATE == time)
+    return RDY_TIMEOUT;
+
+  /* Sleep on the lock, when awakened the lock has been already assigned to
+     this thread by the releasing thread.*/
+  rw_boost(rwp, ctp->p_prio);
+  prio_insert(ctp, &rwp->rw_wrqueue);
+  ctp->p_u.wtobjp = &rwp->rw_wrqueue;
+  msg = chSchGoSleepTimeoutS(THD_STATE_WTRWLOCK, time);
+  if ((msg == RDY_TIMEOUT) && (rwp->rw_owner == NULL) &&
+      isempty(&rwp->rw_wrqueue) && notempty(&rwp->rw_rdqueue)) {
+    /* The waiting readers were only blocked by this writer.*/
+    rw_wakeup_readers(rwp);
+    chSchRescheduleS();
+  }
+  return msg;
+}
+
+/**
+ * @brief   Unlocks a reader-writer lock held for writing.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+void chRWLockWriteUnlock(RWLock *rwp) {
+
+  chSysLock();
+  chRWLockWriteUnlockS(rwp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Unlocks a reader-writer lock held for writing.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @sclass
+ */
+void chRWLockWriteUnlockS(RWLock *rwp) {
+  Thread *ctp = currp;
+  RWLock **rwpp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockWriteUnlockS");
+  chDbgAssert(rwp->rw_owner == ctp,
+              "chRWLockWriteUnlockS(), #1",
+              "not holding the lock for writing");
+
+  /* Removes the lock from the thread's owned locks list.*/
+  rwpp = &ctp->p_rwlist;
+  while (*rwpp != rwp)
+    rwpp = &(*rwpp)->rw_next;
+  *rwpp = rwp->rw_next;
+  rwp->rw_owner = NULL;
+
+  rw_grant(rwp);
+  rw_restore_prio(ctp);
+}
+
+#endif /* CH_USE_RWLOCKS */
+
+/** @} */
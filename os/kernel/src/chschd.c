@@ -136,7 +136,7 @@ static void wakeup(void *p) {
        another thread with higher priority.*/
     chSysUnlockFromIsr();
     return;
-#if CH_USE_SEMAPHORES || CH_USE_QUEUES ||                                   \
+#if CH_USE_SEMAPHORES || CH_USE_QUEUES || CH_USE_RWLOCKS ||                \
     (CH_USE_CONDVARS && CH_USE_CONDVARS_TIMEOUT)
 #if CH_USE_SEMAPHORES
   case THD_STATE_WTSEM:
@@ -148,6 +148,9 @@ static void wakeup(void *p) {
 #endif
 #if CH_USE_CONDVARS && CH_USE_CONDVARS_TIMEOUT
   case THD_STATE_WTCOND:
+#endif
+#if CH_USE_RWLOCKS
+  case THD_STATE_WTRWLOCK:
 #endif
     /* States requiring dequeuing.*/
     dequeue(tp);
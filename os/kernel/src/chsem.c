@@ -82,6 +82,9 @@ void chSemInit(Semaphore *sp, cnt_t n) {
 
   queue_init(&sp->s_queue);
   sp->s_cnt = n;
+#if CH_USE_WAITOBJECTS
+  chEvtInit(&sp->s_event);
+#endif
 }
 
 /**
@@ -140,6 +143,10 @@ void chSemResetI(Semaphore *sp, cnt_t n) {
   sp->s_cnt = n;
   while (++cnt <= 0)
     chSchReadyI(lifo_remove(&sp->s_queue))->p_u.rdymsg = RDY_RESET;
+#if CH_USE_WAITOBJECTS
+  if ((n > 0) && chEvtIsListeningI(&sp->s_event))
+    chEvtBroadcastI(&sp->s_event);
+#endif
 }
 
 /**
@@ -279,6 +286,12 @@ void chSemSignal(Semaphore *sp) {
   chSysLock();
   if (++sp->s_cnt <= 0)
     chSchWakeupS(fifo_remove(&sp->s_queue), RDY_OK);
+#if CH_USE_WAITOBJECTS
+  else if (chEvtIsListeningI(&sp->s_event)) {
+    chEvtBroadcastI(&sp->s_event);
+    chSchRescheduleS();
+  }
+#endif
   chSysUnlock();
 }
 
@@ -309,6 +322,10 @@ void chSemSignalI(Semaphore *sp) {
     tp->p_u.rdymsg = RDY_OK;
     chSchReadyI(tp);
   }
+#if CH_USE_WAITOBJECTS
+  else if (chEvtIsListeningI(&sp->s_event))
+    chEvtBroadcastI(&sp->s_event);
+#endif
 }
 
 /**
@@ -338,6 +355,10 @@ void chSemAddCounterI(Semaphore *sp, cnt_t n) {
       chSchReadyI(fifo_remove(&sp->s_queue))->p_u.rdymsg = RDY_OK;
     n--;
   }
+#if CH_USE_WAITOBJECTS
+  if ((sp->s_cnt > 0) && chEvtIsListeningI(&sp->s_event))
+    chEvtBroadcastI(&sp->s_event);
+#endif
 }
 
 #if CH_USE_SEMSW || defined(__DOXYGEN__)
@@ -372,6 +393,10 @@ msg_t chSemSignalWait(Semaphore *sps, Semaphore *spw) {
   chSysLock();
   if (++sps->s_cnt <= 0)
     chSchReadyI(fifo_remove(&sps->s_queue))->p_u.rdymsg = RDY_OK;
+#if CH_USE_WAITOBJECTS
+  else if (chEvtIsListeningI(&sps->s_event))
+    chEvtBroadcastI(&sps->s_event);
+#endif
   if (--spw->s_cnt < 0) {
     Thread *ctp = currp;
     sem_insert(ctp, &spw->s_queue);
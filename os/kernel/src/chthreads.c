@@ -67,6 +67,9 @@
  * @notapi
  */
 Thread *_thread_init(Thread *tp, tprio_t prio) {
+#if CH_USE_RWLOCKS
+  unsigned i;
+#endif
 
   tp->p_prio = prio;
   tp->p_state = THD_STATE_SUSPENDED;
@@ -78,6 +81,11 @@ Thread *_thread_init(Thread *tp, tprio_t prio) {
   tp->p_realprio = prio;
   tp->p_mtxlist = NULL;
 #endif
+#if CH_USE_RWLOCKS
+  tp->p_rwlist = NULL;
+  for (i = 0; i < CH_RWLOCK_READ_HOLDS; i++)
+    tp->p_rdholds[i].rr_lock = NULL;
+#endif
 #if CH_USE_EVENTS
   tp->p_epending = 0;
 #endif
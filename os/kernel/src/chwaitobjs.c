@@ -0,0 +1,315 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    chwaitobjs.c
+ * @brief   Multiple objects wait code.
+ *
+ * @addtogroup wait_objects
+ * @details Multiple objects wait related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          This module allows a single thread to block on a set of
+ *          heterogeneous kernel objects and to learn which one became
+ *          ready first, replacing the one thread per object scheme.<br>
+ *          Semaphores and I/O queues embed an @p EventSource that is
+ *          broadcast when they become ready, mailboxes and objects FIFOs
+ *          inherit this from their internal semaphores. A wait object
+ *          associates a waitable object with an @p EventListener, the
+ *          waiting is then performed using the normal events machinery
+ *          while the objects state is polled under the kernel lock so
+ *          no notification can be lost.<br>
+ *          Operations defined for wait objects:
+ *          - <b>Register</b>: The listeners of a set of wait objects are
+ *            registered for the invoking thread, each object is assigned
+ *            a distinct event flag.
+ *          - <b>Wait</b>: The invoking thread blocks until at least one
+ *            object of the set is ready, the index of the ready object is
+ *            returned.
+ *          - <b>Unregister</b>: The listeners are removed from the
+ *            objects.
+ *          .
+ *          Readiness is only an indication, the actual operation on the
+ *          returned object should be performed using a non-blocking or
+ *          @p TIME_IMMEDIATE API because other threads could consume the
+ *          resource in the meantime.
+ * @note    Drivers that manipulate the queue counters directly instead of
+ *          using the I-class queue APIs do not broadcast the readiness
+ *          event.
+ * @pre     In order to use the multiple objects wait APIs the
+ *          @p CH_USE_WAITOBJECTS option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Returns the event source associated to a wait object.
+ *
+ * @param[in] wop       pointer to the @p WaitObject structure
+ * @return              The readiness event source of the object.
+ *
+ * @notapi
+ */
+static EventSource *wo_source(WaitObject *wop) {
+
+  switch (wop->wo_type) {
+  case WO_EVENTSOURCE:
+    return (EventSource *)wop->wo_objp;
+#if CH_USE_SEMAPHORES
+  case WO_SEMAPHORE:
+    return &((Semaphore *)wop->wo_objp)->s_event;
+#endif
+#if CH_USE_MAILBOXES
+  case WO_MAILBOX_FETCH:
+    return &((Mailbox *)wop->wo_objp)->mb_fullsem.s_event;
+  case WO_MAILBOX_POST:
+    return &((Mailbox *)wop->wo_objp)->mb_emptysem.s_event;
+#endif
+#if CH_USE_QUEUES
+  case WO_INPUTQUEUE:
+  case WO_OUTPUTQUEUE:
+    return &((GenericQueue *)wop->wo_objp)->q_event;
+#endif
+#if CH_USE_OBJFIFOS
+  case WO_FIFO_RECEIVE:
+    return &((ObjectsFifo *)wop->wo_objp)->of_fullsem.s_event;
+  case WO_FIFO_TAKE:
+    return &((ObjectsFifo *)wop->wo_objp)->of_freesem.s_event;
+#endif
+  default:
+    chDbgAssert(FALSE, "wo_source(), #1", "invalid object type");
+    return NULL;
+  }
+}
+
+/**
+ * @brief   Initializes a @p WaitObject object.
+ *
+ * @param[out] wop      pointer to the @p WaitObject structure to be
+ *                      initialized
+ * @param[in] type      type of the object, one of the @p WO_XXX values
+ * @param[in] objp      pointer to the waited object
+ *
+ * @init
+ */
+void chWOObjectInit(WaitObject *wop, uint8_t type, void *objp) {
+
+  chDbgCheck((wop != NULL) && (type <= WO_FIFO_TAKE) && (objp != NULL),
+             "chWOObjectInit");
+
+  wop->wo_type = type;
+  wop->wo_objp = objp;
+  wop->wo_el.el_next = NULL;
+}
+
+/**
+ * @brief   Registers a set of wait objects for the current thread.
+ * @details Each object is assigned the event flag @p eid plus its index
+ *          in the array.
+ * @note    The event flags used by the set must not be used by other
+ *          event listeners of the same thread.
+ *
+ * @param[in] wop       pointer to an array of @p WaitObject structures
+ * @param[in] n         number of elements in the array
+ * @param[in] eid       event identifier assigned to the first object
+ *
+ * @api
+ */
+void chWORegister(WaitObject *wop, cnt_t n, eventid_t eid) {
+
+  chDbgCheck((wop != NULL) && (n > 0) &&
+             (eid + n <= (cnt_t)(sizeof(eventmask_t) * 8)), "chWORegister");
+
+  while (n > 0) {
+    chEvtRegister(wo_source(wop), &wop->wo_el, eid);
+    wop++;
+    eid++;
+    n--;
+  }
+}
+
+/**
+ * @brief   Unregisters a set of wait objects.
+ * @note    Any pending event flag of the set is cleared.
+ *
+ * @param[in] wop       pointer to an array of @p WaitObject structures
+ * @param[in] n         number of elements in the array
+ *
+ * @api
+ */
+void chWOUnregister(WaitObject *wop, cnt_t n) {
+  eventmask_t mask = 0;
+
+  chDbgCheck((wop != NULL) && (n > 0), "chWOUnregister");
+
+  /* Unregistering in reverse order because listeners are found on top of
+     the sources lists.*/
+  wop += n;
+  while (n > 0) {
+    wop--;
+    mask |= wop->wo_el.el_mask;
+    chEvtUnregister(wo_source(wop), &wop->wo_el);
+    n--;
+  }
+  chEvtGetAndClearEvents(mask);
+}
+
+/**
+ * @brief   Checks if a wait object is ready.
+ * @note    Event source objects are ready when their event flag is pending
+ *          for the registered thread.
+ *
+ * @param[in] wop       pointer to a registered @p WaitObject structure
+ * @return              The object state.
+ * @retval FALSE        if the object is not ready.
+ * @retval TRUE         if the object is ready.
+ *
+ * @iclass
+ */
+bool_t chWOIsReadyI(WaitObject *wop) {
+
+  chDbgCheckClassI();
+  chDbgCheck(wop != NULL, "chWOIsReadyI");
+
+  switch (wop->wo_type) {
+  case WO_EVENTSOURCE:
+    return (wop->wo_el.el_listener->p_epending & wop->wo_el.el_mask) != 0;
+#if CH_USE_SEMAPHORES
+  case WO_SEMAPHORE:
+    return chSemGetCounterI((Semaphore *)wop->wo_objp) > 0;
+#endif
+#if CH_USE_MAILBOXES
+  case WO_MAILBOX_FETCH:
+    return chMBGetUsedCountI((Mailbox *)wop->wo_objp) > 0;
+  case WO_MAILBOX_POST:
+    return chMBGetFreeCountI((Mailbox *)wop->wo_objp) > 0;
+#endif
+#if CH_USE_QUEUES
+  case WO_INPUTQUEUE:
+    return !chIQIsEmptyI((InputQueue *)wop->wo_objp);
+  case WO_OUTPUTQUEUE:
+    return !chOQIsFullI((OutputQueue *)wop->wo_objp);
+#endif
+#if CH_USE_OBJFIFOS
+  case WO_FIFO_RECEIVE:
+    return chFifoGetUsedCountI((ObjectsFifo *)wop->wo_objp) > 0;
+  case WO_FIFO_TAKE:
+    return chFifoGetFreeCountI((ObjectsFifo *)wop->wo_objp) > 0;
+#endif
+  default:
+    chDbgAssert(FALSE, "chWOIsReadyI(), #1", "invalid object type");
+    return FALSE;
+  }
+}
+
+/**
+ * @brief   Waits for one of a set of wait objects to become ready.
+ * @details The objects are checked in array order so lower indexes have
+ *          precedence when several objects are ready at the same time.
+ * @pre     The wait objects must have been registered by the invoking
+ *          thread using @p chWORegister().
+ *
+ * @param[in] wop       pointer to an array of @p WaitObject structures
+ * @param[in] n         number of elements in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The index of the ready object.
+ * @retval RDY_TIMEOUT  if no object became ready within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+msg_t chWOWaitTimeout(WaitObject *wop, cnt_t n, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chWOWaitTimeoutS(wop, n, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Waits for one of a set of wait objects to become ready.
+ * @details The objects are checked in array order so lower indexes have
+ *          precedence when several objects are ready at the same time.
+ * @pre     The wait objects must have been registered by the invoking
+ *          thread using @p chWORegister().
+ *
+ * @param[in] wop       pointer to an array of @p WaitObject structures
+ * @param[in] n         number of elements in the array
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The index of the ready object.
+ * @retval RDY_TIMEOUT  if no object became ready within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+msg_t chWOWaitTimeoutS(WaitObject *wop, cnt_t n, systime_t time) {
+  Thread *ctp = currp;
+  systime_t start = chTimeNow();
+  eventmask_t mask = 0;
+  cnt_t i;
+
+  chDbgCheckClassS();
+  chDbgCheck((wop != NULL) && (n > 0), "chWOWaitTimeoutS");
+
+  for (i = 0; i < n; i++)
+    mask |= wop[i].wo_el.el_mask;
+
+  while (TRUE) {
+    systime_t elapsed;
+
+    for (i = 0; i < n; i++) {
+      if (chWOIsReadyI(&wop[i])) {
+        /* Consuming the flag, it is only meaningful for event sources.*/
+        ctp->p_epending &= ~wop[i].wo_el.el_mask;
+        return (msg_t)i;
+      }
+    }
+
+    /* No object is ready, the pending flags are stale and are cleared, any
+       readiness change after this point sets them again and wakes up the
+       thread.*/
+    ctp->p_epending &= ~mask;
+    if (TIME_INFINITE == time)
+      elapsed = 0;
+    else {
+      elapsed = chTimeNow() - start;
+      if (elapsed >= time)
+        return RDY_TIMEOUT;
+    }
+    ctp->p_u.ewmask = mask;
+    if (chSchGoSleepTimeoutS(THD_STATE_WTOREVT, time - elapsed) < RDY_OK)
+      return RDY_TIMEOUT;
+  }
+}
+
+#endif /* CH_USE_WAITOBJECTS */
+
+/** @} */
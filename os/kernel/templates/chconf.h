@@ -214,6 +214,18 @@
 #define CH_USE_CONDVARS_TIMEOUT         TRUE
 #endif
 
+/**
+ * @brief   Reader-writer locks APIs.
+ * @details If enabled then the reader-writer locks APIs are included in
+ *          the kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_RWLOCKS) || defined(__DOXYGEN__)
+#define CH_USE_RWLOCKS                  TRUE
+#endif
+
 /**
  * @brief   Events Flags APIs.
  * @details If enabled then the event flags APIs are included in the kernel.
@@ -236,6 +248,20 @@
 #define CH_USE_EVENTS_TIMEOUT           TRUE
 #endif
 
+/**
+ * @brief   Multiple objects wait APIs.
+ * @details If enabled then semaphores, mailboxes and I/O queues embed an
+ *          event source broadcasting their readiness and the
+ *          @p chWOWaitTimeout() API is included in the kernel.
+ *
+ * @note    The default is @p FALSE, each semaphore and queue embeds an
+ *          event source and their signal operations broadcast it.
+ * @note    Requires @p CH_USE_EVENTS.
+ */
+#if !defined(CH_USE_WAITOBJECTS) || defined(__DOXYGEN__)
+#define CH_USE_WAITOBJECTS              FALSE
+#endif
+
 /**
  * @brief   Synchronous Messages APIs.
  * @details If enabled then the synchronous messages APIs are included
@@ -331,6 +357,18 @@
 #define CH_USE_MEMPOOLS                 TRUE
 #endif
 
+/**
+ * @brief   Objects FIFOs APIs.
+ * @details If enabled then the objects FIFOs APIs are included in the
+ *          kernel.
+ *
+ * @note    The default is @p TRUE.
+ * @note    Requires @p CH_USE_SEMAPHORES and @p CH_USE_MEMPOOLS.
+ */
+#if !defined(CH_USE_OBJFIFOS) || defined(__DOXYGEN__)
+#define CH_USE_OBJFIFOS                 TRUE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -0,0 +1,110 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @addtogroup SIMX64_CORE
+ * @{
+ */
+
+#include <stdlib.h>
+
+#include "ch.h"
+#include "hal.h"
+
+/**
+ * Performs a context switch between two threads.
+ * @param otp the thread to be switched out
+ * @param ntp the thread to be switched in
+ */
+__attribute__((used))
+static void __dummy(Thread *ntp, Thread *otp) {
+  (void)ntp; (void)otp;
+
+  asm volatile (
+#if defined(__APPLE__)
+                ".globl _port_switch                            \n\t"
+                "_port_switch:                                  \n\t"
+#else
+                ".globl port_switch                             \n\t"
+                "port_switch:                                   \n\t"
+#endif
+                "push    %%rbp                                  \n\t"
+                "push    %%rbx                                  \n\t"
+                "push    %%r12                                  \n\t"
+                "push    %%r13                                  \n\t"
+                "push    %%r14                                  \n\t"
+                "push    %%r15                                  \n\t"
+                "movq    %%rsp, %c0(%%rsi)                      \n\t"
+                "movq    %c0(%%rdi), %%rsp                      \n\t"
+                "pop     %%r15                                  \n\t"
+                "pop     %%r14                                  \n\t"
+                "pop     %%r13                                  \n\t"
+                "pop     %%r12                                  \n\t"
+                "pop     %%rbx                                  \n\t"
+                "pop     %%rbp                                  \n\t"
+                "ret" : : "i" (offsetof(Thread, p_ctx)));
+}
+
+/**
+ * First code executed by a new thread, the work function and its argument
+ * are moved from the callee-saved registers initialized in
+ * @p SETUP_CONTEXT() into the argument registers.
+ */
+__attribute__((used))
+static void __dummy2(void) {
+
+  asm volatile (
+#if defined(__APPLE__)
+                ".globl __port_thread_trampoline                \n\t"
+                "__port_thread_trampoline:                      \n\t"
+                "movq    %r12, %rdi                             \n\t"
+                "movq    %r13, %rsi                             \n\t"
+                "call    __port_thread_start");
+#else
+                ".globl _port_thread_trampoline                 \n\t"
+                "_port_thread_trampoline:                       \n\t"
+                "movq    %r12, %rdi                             \n\t"
+                "movq    %r13, %rsi                             \n\t"
+                "call    _port_thread_start");
+#endif
+}
+
+/**
+ * Halts the system. In this implementation it just exits the simulation.
+ */
+void port_halt(void) {
+
+  exit(2);
+}
+
+/**
+ * @brief   Start a thread by invoking its work function.
+ * @details If the work function returns @p chThdExit() is automatically
+ *          invoked.
+ */
+__attribute__((noreturn))
+void _port_thread_start(msg_t (*pf)(void *), void *p) {
+
+  chSysUnlock();
+  chThdExit(pf(p));
+  while(1);
+}
+
+/** @} */
@@ -0,0 +1,236 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    adc_stream.c
+ * @brief   ADC streaming layer code.
+ * @details The converter runs in circular mode, each half buffer event
+ *          copies the completed half into a free block taken from a memory
+ *          pool and posts the block in a mailbox. The consumer threads
+ *          fetch the blocks from the mailbox and work on them in place,
+ *          the blocks are returned to the pool when released.
+ *
+ * @addtogroup adc_stream
+ * @{
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "adc_stream.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Stream owning a driver.
+ * @details The driver is operating on the conversion group embedded in
+ *          the stream object.
+ */
+#define owner(adcp)                                                         \
+  ((ADCStream *)((uint8_t *)(adcp)->grpp - offsetof(ADCStream, grp)))
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Half buffer callback.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] buffer    pointer to the completed half buffer
+ * @param[in] n         number of rows in the half buffer
+ */
+static void end_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+  ADCStream *asp = owner(adcp);
+  ADCStreamBlock *bp;
+
+  chSysLockFromIsr();
+  bp = chPoolAllocI(&asp->pool);
+  if (bp == NULL) {
+    /* No free blocks, the consumers are not keeping up.*/
+    asp->overruns++;
+    asp->seq++;
+    chSysUnlockFromIsr();
+    return;
+  }
+  bp->seq = asp->seq++;
+  chSysUnlockFromIsr();
+
+  /* The half buffer is copied outside the critical zone.*/
+  bp->time = chTimeNow();
+  bp->n = n;
+  memcpy(adcsBlockSamples(bp), buffer,
+         n * asp->grp.num_channels * sizeof(adcsample_t));
+
+  /* The mailbox has a slot for each block, it cannot be full.*/
+  chSysLockFromIsr();
+  (void)chMBPostI(&asp->mbox, (msg_t)bp);
+  chSysUnlockFromIsr();
+}
+
+/**
+ * @brief   Converter error callback.
+ * @details The ready blocks are discarded and the threads waiting for a
+ *          block are released with a @p NULL block.
+ * @note    The driver has already stopped the conversion.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ * @param[in] err       ADC error code
+ */
+static void error_cb(ADCDriver *adcp, adcerror_t err) {
+  ADCStream *asp = owner(adcp);
+
+  (void)err;
+  chSysLockFromIsr();
+  asp->errors++;
+  asp->state = ADCS_ERROR;
+  chMBResetI(&asp->mbox);
+  chSysUnlockFromIsr();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a generic ADC stream object.
+ *
+ * @param[out] asp      pointer to the @p ADCStream object
+ *
+ * @init
+ */
+void adcsObjectInit(ADCStream *asp) {
+
+  asp->state = ADCS_STOP;
+  asp->config = NULL;
+}
+
+/**
+ * @brief   Starts the acquisition.
+ * @details The blocks pool and the ready queue are initialized and the
+ *          circular conversion is started.
+ * @note    All the blocks fetched from a previous run must have been
+ *          released before restarting the stream.
+ *
+ * @param[in] asp       pointer to the @p ADCStream object
+ * @param[in] config    the stream configuration
+ *
+ * @api
+ */
+void adcsStart(ADCStream *asp, const ADCStreamConfig *config) {
+  size_t size;
+
+  chDbgCheck((asp != NULL) && (config != NULL) &&
+             (config->adcp != NULL) && (config->grpp != NULL) &&
+             (config->buffer != NULL) && (config->depth >= 2) &&
+             ((config->depth & 1) == 0) && (config->blocks != NULL) &&
+             (config->queue != NULL) && (config->nblocks > 0),
+             "adcsStart");
+  chDbgAssert(config->grpp->circular,
+              "adcsStart(), #1", "not circular");
+  chDbgAssert((asp->state == ADCS_STOP) || (asp->state == ADCS_ERROR),
+              "adcsStart(), #2", "invalid state");
+
+  asp->config   = config;
+  asp->grp      = *config->grpp;
+  asp->grp.end_cb   = end_cb;
+  asp->grp.error_cb = error_cb;
+  asp->seq      = 0;
+  asp->overruns = 0;
+  asp->errors   = 0;
+
+  size = ADC_STREAM_BLOCK_SIZE(asp->grp.num_channels, config->depth / 2);
+  chPoolInit(&asp->pool, size, NULL);
+  chPoolLoadArray(&asp->pool, config->blocks, config->nblocks);
+  chMBInit(&asp->mbox, config->queue, (cnt_t)config->nblocks);
+
+  asp->state = ADCS_ACTIVE;
+  adcStartConversion(config->adcp, &asp->grp, config->buffer, config->depth);
+}
+
+/**
+ * @brief   Stops the acquisition.
+ * @details The ready blocks are discarded and the threads waiting for a
+ *          block are released with a @p NULL block.
+ *
+ * @param[in] asp       pointer to the @p ADCStream object
+ *
+ * @api
+ */
+void adcsStop(ADCStream *asp) {
+
+  chDbgCheck(asp != NULL, "adcsStop");
+  chDbgAssert((asp->state == ADCS_ACTIVE) || (asp->state == ADCS_ERROR),
+              "adcsStop(), #1", "invalid state");
+
+  adcStopConversion(asp->config->adcp);
+  asp->state = ADCS_STOP;
+  chMBReset(&asp->mbox);
+}
+
+/**
+ * @brief   Waits for the next block of samples.
+ * @details The block is not copied, the caller works on the samples in
+ *          place and must release the block using @p adcsReleaseBlock().
+ *          Multiple threads can consume the blocks of the same stream.
+ *
+ * @param[in] asp       pointer to the @p ADCStream object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The block pointer.
+ * @retval NULL         if the operation timed out or the stream has been
+ *                      stopped, also by a converter error.
+ *
+ * @api
+ */
+ADCStreamBlock *adcsGetBlock(ADCStream *asp, systime_t time) {
+  msg_t msg;
+
+  chDbgCheck(asp != NULL, "adcsGetBlock");
+  chDbgAssert(asp->config != NULL, "adcsGetBlock(), #1", "never started");
+
+  chSysLock();
+  /* A stopped stream has no more blocks, the caller must not wait.*/
+  if ((asp->state != ADCS_ACTIVE) ||
+      (chMBFetchS(&asp->mbox, &msg, time) != RDY_OK))
+    msg = (msg_t)NULL;
+  chSysUnlock();
+  return (ADCStreamBlock *)msg;
+}
+
+/**
+ * @brief   Returns a block to the stream.
+ *
+ * @param[in] asp       pointer to the @p ADCStream object
+ * @param[in] bp        pointer to the @p ADCStreamBlock object
+ *
+ * @api
+ */
+void adcsReleaseBlock(ADCStream *asp, ADCStreamBlock *bp) {
+
+  chDbgCheck((asp != NULL) && (bp != NULL), "adcsReleaseBlock");
+
+  chPoolFree(&asp->pool, bp);
+}
+
+/** @} */
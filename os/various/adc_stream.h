@@ -0,0 +1,198 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    adc_stream.h
+ * @brief   ADC streaming layer header.
+ *
+ * @addtogroup adc_stream
+ * @{
+ */
+
+#ifndef _ADC_STREAM_H_
+#define _ADC_STREAM_H_
+
+/*
+ * Module dependencies check.
+ */
+#if !HAL_USE_ADC
+#error "ADC streams require HAL_USE_ADC"
+#endif
+
+#if !CH_USE_MAILBOXES || !CH_USE_MEMPOOLS
+#error "ADC streams require CH_USE_MAILBOXES and CH_USE_MEMPOOLS"
+#endif
+
+/**
+ * @brief   ADC stream state machine possible states.
+ */
+typedef enum {
+  ADCS_UNINIT = 0,                  /**< Not initialized.                   */
+  ADCS_STOP = 1,                    /**< Stopped.                           */
+  ADCS_ACTIVE = 2,                  /**< Acquiring.                         */
+  ADCS_ERROR = 3                    /**< Stopped by a converter error.      */
+} adcsstate_t;
+
+/**
+ * @brief   Block of samples.
+ * @details The header is followed by the samples of @p n rows, organized
+ *          as in the conversion buffer.
+ */
+typedef struct {
+  /**
+   * @brief Sequence number, a gap means that blocks have been lost.
+   */
+  uint32_t                  seq;
+  /**
+   * @brief System time of the block completion.
+   */
+  systime_t                 time;
+  /**
+   * @brief Number of rows in the block.
+   */
+  size_t                    n;
+} ADCStreamBlock;
+
+/**
+ * @brief   ADC stream configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief ADC driver, it must be already started.
+   */
+  ADCDriver                 *adcp;
+  /**
+   * @brief Conversion group, it must be circular.
+   * @note  The callbacks in the group are ignored, the stream uses its own.
+   */
+  const ADCConversionGroup  *grpp;
+  /**
+   * @brief Conversion buffer.
+   */
+  adcsample_t               *buffer;
+  /**
+   * @brief Conversion buffer depth in rows, it must be even.
+   * @note  Each half buffer becomes a block of <tt>depth / 2</tt> rows.
+   */
+  size_t                    depth;
+  /**
+   * @brief Blocks storage, see @p ADC_STREAM_BLOCKS_DECL().
+   */
+  void                      *blocks;
+  /**
+   * @brief Ready blocks queue storage, an array of @p nblocks messages.
+   */
+  msg_t                     *queue;
+  /**
+   * @brief Number of blocks.
+   */
+  size_t                    nblocks;
+} ADCStreamConfig;
+
+/**
+ * @brief   Structure representing an ADC stream.
+ */
+typedef struct {
+  /**
+   * @brief Stream state.
+   */
+  adcsstate_t               state;
+  /**
+   * @brief Current configuration data.
+   */
+  const ADCStreamConfig     *config;
+  /**
+   * @brief Conversion group used on the driver, copy of the configured
+   *        one with the stream callbacks.
+   */
+  ADCConversionGroup        grp;
+  /**
+   * @brief Free blocks.
+   */
+  MemoryPool                pool;
+  /**
+   * @brief Ready blocks.
+   */
+  Mailbox                   mbox;
+  /**
+   * @brief Sequence number of the next block.
+   */
+  uint32_t                  seq;
+  /**
+   * @brief Blocks lost because no free block was available.
+   */
+  uint32_t                  overruns;
+  /**
+   * @brief Converter errors.
+   */
+  uint32_t                  errors;
+} ADCStream;
+
+/**
+ * @brief   Size of a block of samples.
+ * @details The size is rounded to a multiple of the @p stkalign_t type.
+ *
+ * @param[in] channels  number of channels in the conversion group
+ * @param[in] rows      number of rows in the block
+ */
+#define ADC_STREAM_BLOCK_SIZE(channels, rows)                               \
+  ((((sizeof(ADCStreamBlock) +                                              \
+      (channels) * (rows) * sizeof(adcsample_t)) - 1) |                     \
+    (sizeof(stkalign_t) - 1)) + 1)
+
+/**
+ * @brief   Declares the storage of an ADC stream blocks.
+ *
+ * @param[in] name      name of the array
+ * @param[in] nblocks   number of blocks
+ * @param[in] channels  number of channels in the conversion group
+ * @param[in] depth     conversion buffer depth
+ */
+#define ADC_STREAM_BLOCKS_DECL(name, nblocks, channels, depth)              \
+  stkalign_t name[(nblocks) *                                               \
+                  ADC_STREAM_BLOCK_SIZE(channels, (depth) / 2) /            \
+                  sizeof(stkalign_t)]
+
+/**
+ * @brief   Samples of a block.
+ *
+ * @param[in] bp        pointer to the @p ADCStreamBlock object
+ * @return              Pointer to the first sample.
+ */
+#define adcsBlockSamples(bp) ((adcsample_t *)((ADCStreamBlock *)(bp) + 1))
+
+/**
+ * @brief   Blocks lost since the stream start.
+ *
+ * @param[in] asp       pointer to the @p ADCStream object
+ */
+#define adcsGetOverruns(asp) ((asp)->overruns)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void adcsObjectInit(ADCStream *asp);
+  void adcsStart(ADCStream *asp, const ADCStreamConfig *config);
+  void adcsStop(ADCStream *asp);
+  ADCStreamBlock *adcsGetBlock(ADCStream *asp, systime_t time);
+  void adcsReleaseBlock(ADCStream *asp, ADCStreamBlock *bp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ADC_STREAM_H_ */
+
+/** @} */
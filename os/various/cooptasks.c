@@ -0,0 +1,322 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    cooptasks.c
+ * @brief   Cooperative tasks code.
+ * @details The scheduler runs in the host thread and walks the list of the
+ *          started tasks, a task is resumed if it is ready or if its wait
+ *          condition is satisfied. When no task could be resumed in a pass
+ *          the host thread sleeps on its events with the nearest tasks
+ *          timeout, the awaited semaphores and queues signal the host
+ *          thread through their readiness event sources so no wakeup can
+ *          be lost between the pass and the sleep.
+ *
+ * @addtogroup coop_tasks
+ * @{
+ */
+
+#include "ch.h"
+#include "cooptasks.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Mask of the host thread wakeup event.
+ */
+#define COOP_WAKEUP_MASK    ((eventmask_t)1 << COOP_WAKEUP_EVENT)
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+/**
+ * @brief   Checks a wait object and consumes it if it is a semaphore.
+ *
+ * @param[in] wop       pointer to the @p WaitObject structure
+ * @return              The object state.
+ * @retval FALSE        if the object is not ready.
+ * @retval TRUE         if the object is ready.
+ *
+ * @iclass
+ */
+static bool_t coop_object_ready(WaitObject *wop) {
+
+  if (!chWOIsReadyI(wop))
+    return FALSE;
+  if (wop->wo_type == WO_SEMAPHORE)
+    chSemFastWaitI((Semaphore *)wop->wo_objp);
+  return TRUE;
+}
+#endif
+
+/**
+ * @brief   Checks the wait condition of a task.
+ * @details If the condition is satisfied or the wait timed out then the
+ *          wait result is stored in the task, else the time remaining
+ *          before the task timeout is stored in @p nextp if shorter than
+ *          its current value.
+ *
+ * @param[in] csp       pointer to the @p CoopScheduler structure
+ * @param[in] ctp       pointer to a waiting @p CoopTask structure
+ * @param[in,out] nextp pointer to the nearest timeout
+ * @return              The wait state.
+ * @retval FALSE        if the task is still waiting.
+ * @retval TRUE         if the task can be resumed.
+ */
+static bool_t coop_check(CoopScheduler *csp, CoopTask *ctp,
+                         systime_t *nextp) {
+  systime_t elapsed;
+
+  switch (ctp->ct_state) {
+  case COOP_STATE_WTEVENTS:
+    if ((csp->cs_events & ctp->ct_u.ewmask) != 0) {
+      ctp->ct_u.ewmask &= csp->cs_events;
+      csp->cs_events &= ~ctp->ct_u.ewmask;
+      return TRUE;
+    }
+    break;
+#if CH_USE_WAITOBJECTS
+  case COOP_STATE_WTOBJECT:
+    {
+      bool_t ready;
+
+      chSysLock();
+      ready = coop_object_ready(&ctp->ct_wo);
+      chSysUnlock();
+      if (ready) {
+        chWOUnregister(&ctp->ct_wo, 1);
+        ctp->ct_u.rdymsg = RDY_OK;
+        return TRUE;
+      }
+    }
+    break;
+#endif
+  default:
+    break;
+  }
+
+  if (ctp->ct_wtime == TIME_INFINITE)
+    return FALSE;
+  elapsed = chTimeNow() - ctp->ct_wstart;
+  if (elapsed < ctp->ct_wtime) {
+    if (ctp->ct_wtime - elapsed < *nextp)
+      *nextp = ctp->ct_wtime - elapsed;
+    return FALSE;
+  }
+
+  /* Timeout.*/
+  if (ctp->ct_state == COOP_STATE_WTEVENTS)
+    ctp->ct_u.ewmask = 0;
+  else {
+#if CH_USE_WAITOBJECTS
+    if (ctp->ct_state == COOP_STATE_WTOBJECT)
+      chWOUnregister(&ctp->ct_wo, 1);
+#endif
+    ctp->ct_u.rdymsg = RDY_TIMEOUT;
+  }
+  return TRUE;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a @p CoopScheduler structure.
+ *
+ * @param[out] csp      pointer to the @p CoopScheduler structure
+ *
+ * @init
+ */
+void coopSchedulerInit(CoopScheduler *csp) {
+
+  chDbgCheck(csp != NULL, "coopSchedulerInit");
+
+  csp->cs_tasks = NULL;
+  csp->cs_new = NULL;
+  csp->cs_events = 0;
+}
+
+/**
+ * @brief   Starts a cooperative task.
+ * @details The task is resumed for the first time in the next pass of the
+ *          scheduler.
+ * @note    This function must be invoked from the host thread, for
+ *          example from another task, or before the host thread is
+ *          started.
+ *
+ * @param[in] csp       pointer to the @p CoopScheduler structure
+ * @param[out] ctp      pointer to the @p CoopTask structure, the task must
+ *                      not be already running
+ * @param[in] func      the task function
+ * @param[in] arg       an argument passed to the task function, it can be
+ *                      retrieved using @p coopGetArg()
+ *
+ * @api
+ */
+void coopTaskStart(CoopScheduler *csp, CoopTask *ctp,
+                   cooptfunc_t func, void *arg) {
+
+  chDbgCheck((csp != NULL) && (ctp != NULL) && (func != NULL),
+             "coopTaskStart");
+
+  ctp->ct_func = func;
+  ctp->ct_arg = arg;
+  ctp->ct_lc = 0;
+  ctp->ct_state = COOP_STATE_READY;
+  ctp->ct_next = csp->cs_new;
+  csp->cs_new = ctp;
+}
+
+/**
+ * @brief   Runs the cooperative tasks.
+ * @details The function must be invoked by the host thread, the events of
+ *          the host thread are delivered to the tasks.
+ *
+ * @param[in] csp       pointer to the @p CoopScheduler structure
+ * @return              The function returns @p RDY_OK when all the tasks
+ *                      have terminated.
+ *
+ * @api
+ */
+msg_t coopSchedulerRun(CoopScheduler *csp) {
+
+  chDbgCheck(csp != NULL, "coopSchedulerRun");
+
+  while (TRUE) {
+    CoopTask **ctpp, *ctp;
+    systime_t next = TIME_INFINITE;
+    bool_t resumed = FALSE;
+
+    /* The tasks started since the previous pass are moved in the list.*/
+    while ((ctp = csp->cs_new) != NULL) {
+      csp->cs_new = ctp->ct_next;
+      ctp->ct_next = csp->cs_tasks;
+      csp->cs_tasks = ctp;
+    }
+    if (csp->cs_tasks == NULL)
+      return RDY_OK;
+
+    csp->cs_events |= chEvtGetAndClearEvents(ALL_EVENTS) & ~COOP_WAKEUP_MASK;
+
+    ctpp = &csp->cs_tasks;
+    while ((ctp = *ctpp) != NULL) {
+      if ((ctp->ct_state != COOP_STATE_READY) &&
+          !coop_check(csp, ctp, &next)) {
+        ctpp = &ctp->ct_next;
+        continue;
+      }
+      resumed = TRUE;
+      ctp->ct_state = COOP_STATE_READY;
+      if (ctp->ct_func(ctp) == COOP_EXITED) {
+        ctp->ct_state = COOP_STATE_FINAL;
+        *ctpp = ctp->ct_next;
+      }
+      else
+        ctpp = &ctp->ct_next;
+    }
+
+    /* Nothing to do, the host thread sleeps until an event, an awaited
+       object or the nearest timeout wakes it up.*/
+    if (!resumed)
+      csp->cs_events |= chEvtWaitAnyTimeout(ALL_EVENTS, next) &
+                        ~COOP_WAKEUP_MASK;
+  }
+}
+
+/**
+ * @brief   Host thread function.
+ * @details This function can be used as the function of a thread hosting
+ *          the cooperative tasks.
+ *
+ * @param[in] arg       pointer to the @p CoopScheduler structure
+ * @return              The function returns @p RDY_OK when all the tasks
+ *                      have terminated.
+ */
+msg_t coopThread(void *arg) {
+
+#if CH_USE_REGISTRY
+  chRegSetThreadName("coop");
+#endif
+  return coopSchedulerRun((CoopScheduler *)arg);
+}
+
+/**
+ * @brief   Prepares a timed wait.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] state     the waiting state
+ * @param[in] time      the number of ticks before the wait timeouts
+ *
+ * @notapi
+ */
+void _coop_wait_time(CoopTask *ctp, uint8_t state, systime_t time) {
+
+  ctp->ct_state = state;
+  ctp->ct_wstart = chTimeNow();
+  ctp->ct_wtime = time;
+}
+
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+/**
+ * @brief   Prepares an object wait.
+ * @details If the object is ready or the timeout is @p TIME_IMMEDIATE the
+ *          wait is completed immediately, else the object listener is
+ *          registered on the host thread.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] type      type of the object, one of the @p WO_XXX values
+ *                      except @p WO_EVENTSOURCE
+ * @param[in] objp      pointer to the awaited object
+ * @param[in] time      the number of ticks before the wait timeouts
+ * @return              The wait state.
+ * @retval FALSE        if the task must be suspended.
+ * @retval TRUE         if the wait has been completed.
+ *
+ * @notapi
+ */
+bool_t _coop_wait_object(CoopTask *ctp, uint8_t type, void *objp,
+                         systime_t time) {
+  bool_t ready;
+
+  chDbgCheck((ctp != NULL) && (type != WO_EVENTSOURCE), "_coop_wait_object");
+
+  chWOObjectInit(&ctp->ct_wo, type, objp);
+  chSysLock();
+  ready = coop_object_ready(&ctp->ct_wo);
+  chSysUnlock();
+  if (ready) {
+    ctp->ct_u.rdymsg = RDY_OK;
+    return TRUE;
+  }
+  if (time == TIME_IMMEDIATE) {
+    ctp->ct_u.rdymsg = RDY_TIMEOUT;
+    return TRUE;
+  }
+
+  /* The listener is registered before the next check of the scheduler so
+     a readiness change after that check wakes up the host thread.*/
+  chWORegister(&ctp->ct_wo, 1, COOP_WAKEUP_EVENT);
+  _coop_wait_time(ctp, COOP_STATE_WTOBJECT, time);
+  return FALSE;
+}
+#endif /* CH_USE_WAITOBJECTS */
+
+/** @} */
@@ -0,0 +1,358 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    cooptasks.h
+ * @brief   Cooperative tasks macros and structures.
+ *
+ * @addtogroup coop_tasks
+ * @{
+ */
+
+#ifndef _COOPTASKS_H_
+#define _COOPTASKS_H_
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_EVENTS || !CH_USE_EVENTS_TIMEOUT
+#error "Cooperative tasks require CH_USE_EVENTS and CH_USE_EVENTS_TIMEOUT"
+#endif
+
+/**
+ * @brief   Event flag used to wake up the host thread.
+ * @details The semaphores and queues awaited by the tasks signal this flag
+ *          to the host thread, it must not be used by other event
+ *          listeners of the host thread.
+ */
+#if !defined(COOP_WAKEUP_EVENT) || defined(__DOXYGEN__)
+#define COOP_WAKEUP_EVENT               31
+#endif
+
+#if (COOP_WAKEUP_EVENT < 0) || (COOP_WAKEUP_EVENT > 31)
+#error "invalid COOP_WAKEUP_EVENT value"
+#endif
+
+/**
+ * @name    Task function return codes
+ * @{
+ */
+#define COOP_WAITING        0   /**< @brief Task suspended, it will be
+                                            resumed.                        */
+#define COOP_EXITED         1   /**< @brief Task terminated.                */
+/** @} */
+
+/**
+ * @name    Task states
+ * @{
+ */
+#define COOP_STATE_FINAL    0   /**< @brief Not started or terminated.      */
+#define COOP_STATE_READY    1   /**< @brief Ready to be resumed.            */
+#define COOP_STATE_SLEEPING 2   /**< @brief Waiting for a timeout.          */
+#define COOP_STATE_WTEVENTS 3   /**< @brief Waiting for events.             */
+#define COOP_STATE_WTOBJECT 4   /**< @brief Waiting for a wait object.      */
+/** @} */
+
+/**
+ * @brief   Type of a cooperative task structure.
+ */
+typedef struct CoopTask CoopTask;
+
+/**
+ * @brief   Cooperative task function.
+ * @details The function is invoked each time the task is resumed, it must
+ *          be written between @p coopBegin() and @p coopEnd() and returns
+ *          @p COOP_WAITING or @p COOP_EXITED.
+ */
+typedef msg_t (*cooptfunc_t)(CoopTask *ctp);
+
+/**
+ * @brief   Cooperative task structure.
+ * @details A task has no stack, its state across suspension points is the
+ *          resume point and the data stored in the structure or in an
+ *          enclosing one. Local variables of the task function are lost
+ *          when the task is suspended.
+ */
+struct CoopTask {
+  CoopTask              *ct_next;       /**< @brief Next task in the
+                                                    scheduler list.         */
+  cooptfunc_t           ct_func;        /**< @brief Task function.          */
+  void                  *ct_arg;        /**< @brief Task argument.          */
+  systime_t             ct_wstart;      /**< @brief Start time of the
+                                                    current wait.           */
+  systime_t             ct_wtime;       /**< @brief Timeout of the current
+                                                    wait.                   */
+  /**
+   * @brief   Wait data and result.
+   */
+  union {
+    msg_t               rdymsg;         /**< @brief Wait result.            */
+    eventmask_t         ewmask;         /**< @brief Awaited events, the
+                                                    received events after
+                                                    the wait.               */
+  } ct_u;
+  uint16_t              ct_lc;          /**< @brief Resume point.           */
+  uint8_t               ct_state;       /**< @brief Current task state.     */
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+  WaitObject            ct_wo;          /**< @brief Awaited object.         */
+#endif
+};
+
+/**
+ * @brief   Cooperative tasks scheduler structure.
+ */
+typedef struct {
+  CoopTask              *cs_tasks;      /**< @brief Started tasks list.     */
+  CoopTask              *cs_new;        /**< @brief Tasks started and not
+                                                    yet in the list.        */
+  eventmask_t           cs_events;      /**< @brief Events of the host
+                                                    thread not yet consumed
+                                                    by the tasks.           */
+} CoopScheduler;
+
+/**
+ * @brief   Data part of a static scheduler initializer.
+ * @details This macro should be used when statically initializing a
+ *          scheduler that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the scheduler variable
+ */
+#define _COOPSCHEDULER_DATA(name) {NULL, NULL, 0}
+
+/**
+ * @brief   Static scheduler initializer.
+ * @details Statically initialized schedulers require no explicit
+ *          initialization using @p coopSchedulerInit().
+ *
+ * @param[in] name      the name of the scheduler variable
+ */
+#define COOPSCHEDULER_DECL(name) CoopScheduler name = _COOPSCHEDULER_DATA(name)
+
+/**
+ * @name    Task body macros
+ * @note    The resume points are identified by the source line, two
+ *          suspension points cannot be on the same line and the task
+ *          function must be in a source file shorter than 65536 lines.
+ * @note    The task body is a @p switch statement, the task function
+ *          cannot use @p switch statements containing suspension points.
+ * @{
+ */
+/**
+ * @brief   Suspends the task, the task is resumed at the same point.
+ *
+ * @notapi
+ */
+#define _coop_suspend(ctp)                                                  \
+  (ctp)->ct_lc = (uint16_t)__LINE__;                                        \
+  return COOP_WAITING;                                                      \
+  case __LINE__:
+
+/**
+ * @brief   Beginning of the task body.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopBegin(ctp) switch ((ctp)->ct_lc) { case 0:
+
+/**
+ * @brief   End of the task body, the task is terminated.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopEnd(ctp) } (ctp)->ct_lc = 0; return COOP_EXITED
+
+/**
+ * @brief   Terminates the task.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopExit(ctp) do {                                                  \
+  (ctp)->ct_lc = 0;                                                         \
+  return COOP_EXITED;                                                       \
+} while (0)
+
+/**
+ * @brief   Lets the other ready tasks run.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopYield(ctp) do {                                                 \
+  _coop_suspend(ctp);                                                       \
+} while (0)
+
+/**
+ * @brief   Suspends the task for the specified time.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] time      the number of ticks before the task is resumed,
+ *                      the special value @a TIME_INFINITE is allowed but
+ *                      it is meaningful only in a loop of waits
+ */
+#define coopSleep(ctp, time) do {                                           \
+  _coop_wait_time(ctp, COOP_STATE_SLEEPING, time);                          \
+  _coop_suspend(ctp);                                                       \
+} while (0)
+
+/**
+ * @brief   Waits for any of the specified events of the host thread.
+ * @details The received events are cleared and returned by
+ *          @p coopGetEvents(), zero is returned on timeout.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] mask      mask of the events that the task is interested in
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ */
+#define coopWaitEventsTimeout(ctp, mask, time) do {                         \
+  (ctp)->ct_u.ewmask = (mask);                                              \
+  _coop_wait_time(ctp, COOP_STATE_WTEVENTS, time);                          \
+  _coop_suspend(ctp);                                                       \
+} while (0)
+
+#if CH_USE_WAITOBJECTS || defined(__DOXYGEN__)
+/**
+ * @brief   Waits for a kernel object to become ready.
+ * @details The result returned by @p coopGetMsg() is @p RDY_OK or
+ *          @p RDY_TIMEOUT. The task is not suspended if the object is
+ *          already ready.
+ * @note    A semaphore is taken when ready, the other objects readiness
+ *          is only an indication and the operation on the object should
+ *          be performed using a non-blocking or @p TIME_IMMEDIATE API.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] type      type of the object, one of the @p WO_XXX values
+ *                      except @p WO_EVENTSOURCE, event sources are awaited
+ *                      by registering them on the host thread and using
+ *                      @p coopWaitEventsTimeout()
+ * @param[in] objp      pointer to the awaited object
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ */
+#define coopWaitObjectTimeout(ctp, type, objp, time) do {                   \
+  if (!_coop_wait_object(ctp, type, objp, time)) {                          \
+    _coop_suspend(ctp);                                                     \
+  }                                                                         \
+} while (0)
+
+/**
+ * @brief   Waits on a semaphore.
+ * @details The result returned by @p coopGetMsg() is @p RDY_OK if the
+ *          semaphore has been taken or @p RDY_TIMEOUT.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] sp        pointer to a @p Semaphore structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ */
+#define coopWaitSemaphoreTimeout(ctp, sp, time)                             \
+  coopWaitObjectTimeout(ctp, WO_SEMAPHORE, sp, time)
+
+/**
+ * @brief   Waits for data in an input queue.
+ * @details The result returned by @p coopGetMsg() is @p RDY_OK if data is
+ *          available or @p RDY_TIMEOUT.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ */
+#define coopWaitInputQueueTimeout(ctp, iqp, time)                           \
+  coopWaitObjectTimeout(ctp, WO_INPUTQUEUE, iqp, time)
+
+/**
+ * @brief   Waits for space in an output queue.
+ * @details The result returned by @p coopGetMsg() is @p RDY_OK if space is
+ *          available or @p RDY_TIMEOUT.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ */
+#define coopWaitOutputQueueTimeout(ctp, oqp, time)                          \
+  coopWaitObjectTimeout(ctp, WO_OUTPUTQUEUE, oqp, time)
+#endif /* CH_USE_WAITOBJECTS */
+/** @} */
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the task argument.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopGetArg(ctp) ((ctp)->ct_arg)
+
+/**
+ * @brief   Returns the result of the last object wait.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopGetMsg(ctp) ((ctp)->ct_u.rdymsg)
+
+/**
+ * @brief   Returns the events received by the last events wait.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopGetEvents(ctp) ((ctp)->ct_u.ewmask)
+
+/**
+ * @brief   Verifies if the task is terminated or not started.
+ *
+ * @param[in] ctp       pointer to the @p CoopTask structure
+ */
+#define coopIsTerminated(ctp) ((ctp)->ct_state == COOP_STATE_FINAL)
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void coopSchedulerInit(CoopScheduler *csp);
+  void coopTaskStart(CoopScheduler *csp, CoopTask *ctp,
+                     cooptfunc_t func, void *arg);
+  msg_t coopSchedulerRun(CoopScheduler *csp);
+  msg_t coopThread(void *arg);
+  void _coop_wait_time(CoopTask *ctp, uint8_t state, systime_t time);
+#if CH_USE_WAITOBJECTS
+  bool_t _coop_wait_object(CoopTask *ctp, uint8_t type, void *objp,
+                           systime_t time);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _COOPTASKS_H_ */
+
+/** @} */
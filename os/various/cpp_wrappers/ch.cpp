@@ -589,6 +589,56 @@ namespace chibios_rt {
   }
 #endif /* CH_USE_CONDVARS_TIMEOUT */
 #endif /* CH_USE_CONDVARS */
+
+#if CH_USE_RWLOCKS
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  RWLock::RWLock(uint8_t policy) {
+
+    chRWLockInit(&rwlock, policy);
+  }
+
+  msg_t RWLock::readLock(void) {
+
+    return chRWLockReadLock(&rwlock);
+  }
+
+  msg_t RWLock::readLockTimeout(systime_t time) {
+
+    return chRWLockReadLockTimeout(&rwlock, time);
+  }
+
+  bool RWLock::tryReadLock(void) {
+
+    return chRWLockTryReadLock(&rwlock);
+  }
+
+  void RWLock::readUnlock(void) {
+
+    chRWLockReadUnlock(&rwlock);
+  }
+
+  void RWLock::writeLock(void) {
+
+    chRWLockWriteLock(&rwlock);
+  }
+
+  msg_t RWLock::writeLockTimeout(systime_t time) {
+
+    return chRWLockWriteLockTimeout(&rwlock, time);
+  }
+
+  bool RWLock::tryWriteLock(void) {
+
+    return chRWLockTryWriteLock(&rwlock);
+  }
+
+  void RWLock::writeUnlock(void) {
+
+    chRWLockWriteUnlock(&rwlock);
+  }
+#endif /* CH_USE_RWLOCKS */
 #endif /* CH_USE_MUTEXES */
 
 #if CH_USE_EVENTS
@@ -861,6 +911,112 @@ namespace chibios_rt {
     chPoolFreeI(&pool, objp);
   }
 #endif /* CH_USE_MEMPOOLS */
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::ObjectsFifo                                                *
+   *------------------------------------------------------------------------*/
+  ObjectsFifo::ObjectsFifo(size_t objsize, cnt_t objn,
+                           void *objbuf, void **msgbuf) {
+
+    chFifoInit(&fifo, objsize, objn, objbuf, msgbuf);
+  }
+
+  void *ObjectsFifo::takeObject(systime_t time) {
+
+    return chFifoTakeObject(&fifo, time);
+  }
+
+  void *ObjectsFifo::takeObjectS(systime_t time) {
+
+    return chFifoTakeObjectS(&fifo, time);
+  }
+
+  void *ObjectsFifo::takeObjectI(void) {
+
+    return chFifoTakeObjectI(&fifo);
+  }
+
+  void ObjectsFifo::returnObject(void *objp) {
+
+    chFifoReturnObject(&fifo, objp);
+  }
+
+  void ObjectsFifo::returnObjectI(void *objp) {
+
+    chFifoReturnObjectI(&fifo, objp);
+  }
+
+  void ObjectsFifo::returnObjects(void * const *objpp, cnt_t n) {
+
+    chFifoReturnObjects(&fifo, objpp, n);
+  }
+
+  void ObjectsFifo::returnObjectsI(void * const *objpp, cnt_t n) {
+
+    chFifoReturnObjectsI(&fifo, objpp, n);
+  }
+
+  void ObjectsFifo::sendObject(void *objp) {
+
+    chFifoSendObject(&fifo, objp);
+  }
+
+  void ObjectsFifo::sendObjectS(void *objp) {
+
+    chFifoSendObjectS(&fifo, objp);
+  }
+
+  void ObjectsFifo::sendObjectI(void *objp) {
+
+    chFifoSendObjectI(&fifo, objp);
+  }
+
+  void ObjectsFifo::sendObjects(void * const *objpp, cnt_t n) {
+
+    chFifoSendObjects(&fifo, objpp, n);
+  }
+
+  void ObjectsFifo::sendObjectsI(void * const *objpp, cnt_t n) {
+
+    chFifoSendObjectsI(&fifo, objpp, n);
+  }
+
+  msg_t ObjectsFifo::receiveObject(void **objpp, systime_t time) {
+
+    return chFifoReceiveObject(&fifo, objpp, time);
+  }
+
+  msg_t ObjectsFifo::receiveObjectS(void **objpp, systime_t time) {
+
+    return chFifoReceiveObjectS(&fifo, objpp, time);
+  }
+
+  msg_t ObjectsFifo::receiveObjectI(void **objpp) {
+
+    return chFifoReceiveObjectI(&fifo, objpp);
+  }
+
+  cnt_t ObjectsFifo::receiveObjects(void **objpp, cnt_t n, systime_t time) {
+
+    return chFifoReceiveObjects(&fifo, objpp, n, time);
+  }
+
+  cnt_t ObjectsFifo::receiveObjectsI(void **objpp, cnt_t n) {
+
+    return chFifoReceiveObjectsI(&fifo, objpp, n);
+  }
+
+  cnt_t ObjectsFifo::getFreeCountI(void) {
+
+    return chFifoGetFreeCountI(&fifo);
+  }
+
+  cnt_t ObjectsFifo::getUsedCountI(void) {
+
+    return chFifoGetUsedCountI(&fifo);
+  }
+#endif /* CH_USE_OBJFIFOS */
 }
 
 /** @} */
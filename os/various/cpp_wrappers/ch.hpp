@@ -1329,6 +1329,122 @@ namespace chibios_rt {
 #endif /* CH_USE_CONDVARS_TIMEOUT */
   };
 #endif /* CH_USE_CONDVARS */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a reader-writer lock.
+   */
+  class RWLock {
+  public:
+    /**
+     * @brief   Embedded @p ::RWLock structure.
+     */
+    ::RWLock rwlock;
+
+    /**
+     * @brief   RWLock object constructor.
+     * @details The embedded @p ::RWLock structure is initialized.
+     *
+     * @param[in] policy    the arbitration policy, @p RW_PREFER_READERS or
+     *                      @p RW_PREFER_WRITERS
+     *
+     * @init
+     */
+    RWLock(uint8_t policy);
+
+    /**
+     * @brief   Acquires the lock for reading.
+     *
+     * @return              The operation result.
+     * @retval RDY_OK       if the lock has been acquired.
+     * @retval RDY_RESET    if the thread cannot hold the lock for reading.
+     *
+     * @api
+     */
+    msg_t readLock(void);
+
+    /**
+     * @brief   Acquires the lock for reading with timeout.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the special values are handled as follow:
+     *                      - @a TIME_INFINITE no timeout.
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      .
+     * @return              The operation result.
+     * @retval RDY_OK       if the lock has been acquired.
+     * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+     *                      specified timeout.
+     * @retval RDY_RESET    if the thread cannot hold the lock for reading.
+     *
+     * @api
+     */
+    msg_t readLockTimeout(systime_t time);
+
+    /**
+     * @brief   Tries to acquire the lock for reading without waiting.
+     *
+     * @return              The operation status.
+     * @retval true         if the lock has been acquired.
+     * @retval false        if the lock was not available.
+     *
+     * @api
+     */
+    bool tryReadLock(void);
+
+    /**
+     * @brief   Releases a read lock.
+     *
+     * @api
+     */
+    void readUnlock(void);
+
+    /**
+     * @brief   Acquires the lock for writing.
+     *
+     * @api
+     */
+    void writeLock(void);
+
+    /**
+     * @brief   Acquires the lock for writing with timeout.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the special values are handled as follow:
+     *                      - @a TIME_INFINITE no timeout.
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      .
+     * @return              The operation result.
+     * @retval RDY_OK       if the lock has been acquired.
+     * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    msg_t writeLockTimeout(systime_t time);
+
+    /**
+     * @brief   Tries to acquire the lock for writing without waiting.
+     *
+     * @return              The operation status.
+     * @retval true         if the lock has been acquired.
+     * @retval false        if the lock was not available.
+     *
+     * @api
+     */
+    bool tryWriteLock(void);
+
+    /**
+     * @brief   Releases a write lock.
+     *
+     * @api
+     */
+    void writeUnlock(void);
+  };
+#endif /* CH_USE_RWLOCKS */
 #endif /* CH_USE_MUTEXES */
 
 #if CH_USE_EVENTS || defined(__DOXYGEN__)
@@ -2209,6 +2325,351 @@ namespace chibios_rt {
   };
 #endif /* CH_USE_MEMPOOLS */
 
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::ObjectsFifo                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating an objects FIFO.
+   */
+  class ObjectsFifo {
+  public:
+    /**
+     * @brief   Embedded @p ::ObjectsFifo structure.
+     */
+    ::ObjectsFifo fifo;
+
+    /**
+     * @brief   ObjectsFifo constructor.
+     * @details The embedded @p ::ObjectsFifo structure is initialized.
+     *
+     * @param[in] objsize   size of the objects, the minimum accepted size is
+     *                      the size of a pointer to void
+     * @param[in] objn      number of objects in the objects buffer
+     * @param[in] objbuf    pointer to the objects buffer
+     * @param[in] msgbuf    pointer to the pointers buffer, an array of
+     *                      @p objn pointers to void
+     *
+     * @init
+     */
+    ObjectsFifo(size_t objsize, cnt_t objn, void *objbuf, void **msgbuf);
+
+    /**
+     * @brief   Takes a free object from the objects FIFO.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the free object.
+     * @retval NULL         if the operation has timed out.
+     *
+     * @api
+     */
+    void *takeObject(systime_t time);
+
+    /**
+     * @brief   Takes a free object from the objects FIFO.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the free object.
+     * @retval NULL         if the operation has timed out.
+     *
+     * @sclass
+     */
+    void *takeObjectS(systime_t time);
+
+    /**
+     * @brief   Takes a free object from the objects FIFO.
+     *
+     * @return              The pointer to the free object.
+     * @retval NULL         if there are no free objects.
+     *
+     * @iclass
+     */
+    void *takeObjectI(void);
+
+    /**
+     * @brief   Returns an object to the objects FIFO pool.
+     *
+     * @param[in] objp      pointer to the object to be returned
+     *
+     * @api
+     */
+    void returnObject(void *objp);
+
+    /**
+     * @brief   Returns an object to the objects FIFO pool.
+     *
+     * @param[in] objp      pointer to the object to be returned
+     *
+     * @iclass
+     */
+    void returnObjectI(void *objp);
+
+    /**
+     * @brief   Returns several objects to the objects FIFO pool.
+     *
+     * @param[in] objpp     pointer to an array of pointers to the objects
+     * @param[in] n         number of objects in the array
+     *
+     * @api
+     */
+    void returnObjects(void * const *objpp, cnt_t n);
+
+    /**
+     * @brief   Returns several objects to the objects FIFO pool.
+     *
+     * @param[in] objpp     pointer to an array of pointers to the objects
+     * @param[in] n         number of objects in the array
+     *
+     * @iclass
+     */
+    void returnObjectsI(void * const *objpp, cnt_t n);
+
+    /**
+     * @brief   Posts an object into the objects FIFO.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @api
+     */
+    void sendObject(void *objp);
+
+    /**
+     * @brief   Posts an object into the objects FIFO.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @sclass
+     */
+    void sendObjectS(void *objp);
+
+    /**
+     * @brief   Posts an object into the objects FIFO.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @iclass
+     */
+    void sendObjectI(void *objp);
+
+    /**
+     * @brief   Posts several objects into the objects FIFO.
+     *
+     * @param[in] objpp     pointer to an array of pointers to the objects
+     * @param[in] n         number of objects in the array
+     *
+     * @api
+     */
+    void sendObjects(void * const *objpp, cnt_t n);
+
+    /**
+     * @brief   Posts several objects into the objects FIFO.
+     *
+     * @param[in] objpp     pointer to an array of pointers to the objects
+     * @param[in] n         number of objects in the array
+     *
+     * @iclass
+     */
+    void sendObjectsI(void * const *objpp, cnt_t n);
+
+    /**
+     * @brief   Retrieves an object from the objects FIFO.
+     *
+     * @param[out] objpp    pointer to a pointer to the received object
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if an object has been correctly fetched.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @api
+     */
+    msg_t receiveObject(void **objpp, systime_t time);
+
+    /**
+     * @brief   Retrieves an object from the objects FIFO.
+     *
+     * @param[out] objpp    pointer to a pointer to the received object
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if an object has been correctly fetched.
+     * @retval RDY_TIMEOUT  if the operation has timed out.
+     *
+     * @sclass
+     */
+    msg_t receiveObjectS(void **objpp, systime_t time);
+
+    /**
+     * @brief   Retrieves an object from the objects FIFO.
+     *
+     * @param[out] objpp    pointer to a pointer to the received object
+     * @return              The operation status.
+     * @retval RDY_OK       if an object has been correctly fetched.
+     * @retval RDY_TIMEOUT  if the FIFO is empty.
+     *
+     * @iclass
+     */
+    msg_t receiveObjectI(void **objpp);
+
+    /**
+     * @brief   Retrieves several objects from the objects FIFO.
+     *
+     * @param[out] objpp    pointer to an array of pointers receiving the
+     *                      objects
+     * @param[in] n         maximum number of objects to be fetched
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The number of fetched objects.
+     * @retval 0            if the operation has timed out.
+     *
+     * @api
+     */
+    cnt_t receiveObjects(void **objpp, cnt_t n, systime_t time);
+
+    /**
+     * @brief   Retrieves several objects from the objects FIFO.
+     *
+     * @param[out] objpp    pointer to an array of pointers receiving the
+     *                      objects
+     * @param[in] n         maximum number of objects to be fetched
+     * @return              The number of fetched objects.
+     * @retval 0            if the FIFO is empty.
+     *
+     * @iclass
+     */
+    cnt_t receiveObjectsI(void **objpp, cnt_t n);
+
+    /**
+     * @brief   Returns the number of free objects.
+     *
+     * @return              The number of free objects.
+     *
+     * @iclass
+     */
+    cnt_t getFreeCountI(void);
+
+    /**
+     * @brief   Returns the number of posted objects.
+     *
+     * @return              The number of posted objects.
+     *
+     * @iclass
+     */
+    cnt_t getUsedCountI(void);
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::ObjectsFifoBuffer                                          *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating an objects FIFO and its buffers.
+   * @note    The objects are aligned to the size of a pointer to void.
+   *
+   * @param T                   type of the objects
+   * @param N                   number of objects
+   */
+  template<class T, cnt_t N>
+  class ObjectsFifoBuffer : public ObjectsFifo {
+  private:
+    /* Objects size rounded up to a multiple of a pointer size.*/
+    static const size_t OBJSIZE = ((sizeof (T) + sizeof (void *) - 1) /
+                                   sizeof (void *)) * sizeof (void *);
+    /* The buffer is declared as an array of pointers to void for the same
+       reasons explained in ObjectsPool.*/
+    void *of_objbuf[(N * OBJSIZE) / sizeof (void *)];
+    void *of_msgbuf[N];
+
+  public:
+    /**
+     * @brief   ObjectsFifoBuffer constructor.
+     *
+     * @init
+     */
+    ObjectsFifoBuffer(void) : ObjectsFifo(OBJSIZE, N, of_objbuf, of_msgbuf) {
+    }
+
+    /**
+     * @brief   Takes a free object from the objects FIFO.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the free object.
+     * @retval NULL         if the operation has timed out.
+     *
+     * @api
+     */
+    T *take(systime_t time) {
+
+      return (T *)takeObject(time);
+    }
+
+    /**
+     * @brief   Posts an object into the objects FIFO.
+     *
+     * @param[in] objp      pointer to the object to be posted
+     *
+     * @api
+     */
+    void send(T *objp) {
+
+      sendObject(objp);
+    }
+
+    /**
+     * @brief   Retrieves an object from the objects FIFO.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The pointer to the received object.
+     * @retval NULL         if the operation has timed out.
+     *
+     * @api
+     */
+    T *receive(systime_t time) {
+      void *objp;
+
+      if (receiveObject(&objp, time) != RDY_OK)
+        return NULL;
+      return (T *)objp;
+    }
+
+    /**
+     * @brief   Returns an object to the objects FIFO pool.
+     *
+     * @param[in] objp      pointer to the object to be returned
+     *
+     * @api
+     */
+    void release(T *objp) {
+
+      returnObject(objp);
+    }
+  };
+#endif /* CH_USE_OBJFIFOS */
+
   /*------------------------------------------------------------------------*
    * chibios_rt::BaseSequentialStreamInterface                              *
    *------------------------------------------------------------------------*/
@@ -0,0 +1,200 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    chcoop.hpp
+ * @brief   C++ wrapper of the cooperative tasks.
+ * @details The task classes are bound to their body at compile time, the
+ *          task object only adds the @p CoopTask structure to the derived
+ *          class data. The @p cooptasks.c file must be added to the build.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include "ch.hpp"
+#include "cooptasks.h"
+
+#ifndef _CHCOOP_HPP_
+#define _CHCOOP_HPP_
+
+namespace chibios_rt {
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::CoopScheduler                                              *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a cooperative tasks scheduler.
+   */
+  class CoopScheduler {
+  public:
+    /**
+     * @brief   Embedded @p ::CoopScheduler structure.
+     */
+    ::CoopScheduler sched;
+
+    /**
+     * @brief   CoopScheduler constructor.
+     *
+     * @init
+     */
+    CoopScheduler(void) {
+
+      coopSchedulerInit(&sched);
+    }
+
+    /**
+     * @brief   Runs the cooperative tasks.
+     * @details The function must be invoked by the host thread.
+     *
+     * @return              The function returns @p RDY_OK when all the
+     *                      tasks have terminated.
+     *
+     * @api
+     */
+    msg_t run(void) {
+
+      return coopSchedulerRun(&sched);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::CoopTask                                                   *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class of a cooperative task.
+   * @details The derived class @p T implements the task body in a public
+   *          <tt>msg_t main(void)</tt> function written between
+   *          <tt>coopBegin(&task)</tt> and <tt>coopEnd(&task)</tt>, the
+   *          task state is kept in the class members.
+   *
+   * @param T                   the derived class
+   */
+  template <class T>
+  class CoopTask {
+  private:
+    /**
+     * @brief   Task function, it resumes the task body.
+     */
+    static msg_t entry(::CoopTask *ctp) {
+
+      return static_cast<T *>((CoopTask<T> *)coopGetArg(ctp))->main();
+    }
+
+  public:
+    /**
+     * @brief   Embedded @p ::CoopTask structure.
+     */
+    ::CoopTask task;
+
+    /**
+     * @brief   CoopTask constructor.
+     * @details The task is not started here.
+     *
+     * @init
+     */
+    CoopTask(void) {
+
+      task.ct_state = COOP_STATE_FINAL;
+    }
+
+    /**
+     * @brief   Starts the task.
+     * @note    This function must be invoked from the host thread or
+     *          before the host thread is started.
+     *
+     * @param[in] scheduler     the scheduler hosting the task
+     *
+     * @api
+     */
+    void start(CoopScheduler &scheduler) {
+
+      coopTaskStart(&scheduler.sched, &task, entry, this);
+    }
+
+    /**
+     * @brief   Verifies if the task is terminated or not started.
+     *
+     * @return                  The task state.
+     *
+     * @api
+     */
+    bool isTerminated(void) {
+
+      return coopIsTerminated(&task);
+    }
+
+    /**
+     * @brief   Returns the result of the last object wait.
+     *
+     * @return                  The wait result.
+     *
+     * @api
+     */
+    msg_t getMsg(void) {
+
+      return coopGetMsg(&task);
+    }
+
+    /**
+     * @brief   Returns the events received by the last events wait.
+     *
+     * @return                  The received events.
+     *
+     * @api
+     */
+    eventmask_t getEvents(void) {
+
+      return coopGetEvents(&task);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::CoopThread                                                 *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Static thread hosting a cooperative tasks scheduler.
+   * @details The thread returns when all its tasks have terminated.
+   *
+   * @param N                   the stack size of the host thread, it must
+   *                            cover the deepest task body
+   */
+  template <int N>
+  class CoopThread : public BaseStaticThread<N> {
+  public:
+    /**
+     * @brief   Scheduler of the hosted tasks.
+     */
+    CoopScheduler scheduler;
+
+  protected:
+    /**
+     * @brief   Host thread body.
+     *
+     * @return                  @p RDY_OK when all the tasks have
+     *                          terminated.
+     */
+    virtual msg_t main(void) {
+
+      BaseThread::setName("coop");
+      return scheduler.run();
+    }
+  };
+}
+
+#endif /* _CHCOOP_HPP_ */
+
+/** @} */
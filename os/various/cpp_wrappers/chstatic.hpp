@@ -0,0 +1,895 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    chstatic.hpp
+ * @brief   C++ statically initialized kernel objects.
+ * @details The classes in this file are aggregates, they have no
+ *          constructors and are initialized using the @p STATIC_xxx_DECL()
+ *          macros, which expand to the kernel static initializers. The
+ *          objects are emitted by the compiler as initialized data, nothing
+ *          is executed at startup. The threads are described by a constant
+ *          table, placed in flash, and started in a single critical zone by
+ *          @p chibios_static::System::start(). Stack sizes and priorities
+ *          are checked at compile time.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include "ch.hpp"
+
+#ifndef _CHSTATIC_HPP_
+#define _CHSTATIC_HPP_
+
+/**
+ * @brief   Minimum stack size accepted for the static threads.
+ * @details The size is the one passed to @p THD_WA_SIZE(), the port
+ *          overhead is added on top of it.
+ */
+#if !defined(STATIC_THREAD_MIN_STACK) || defined(__DOXYGEN__)
+#define STATIC_THREAD_MIN_STACK         64
+#endif
+
+/**
+ * @name    Static initializers
+ * @{
+ */
+/**
+ * @brief   Static counter semaphore declaration.
+ *
+ * @param[in] name      the name of the semaphore variable
+ * @param[in] n         the counter initial value, this value must be
+ *                      non-negative
+ */
+#define STATIC_SEMAPHORE_DECL(name, n)                                      \
+  chibios_static::CounterSemaphore name = {_SEMAPHORE_DATA(name.sem, n)}
+
+/**
+ * @brief   Static binary semaphore declaration.
+ *
+ * @param[in] name      the name of the semaphore variable
+ * @param[in] taken     the semaphore initial state
+ */
+#define STATIC_BSEMAPHORE_DECL(name, taken)                                 \
+  chibios_static::BinarySemaphore name = {_BSEMAPHORE_DATA(name.bsem, taken)}
+
+/**
+ * @brief   Static mutex declaration.
+ *
+ * @param[in] name      the name of the mutex variable
+ */
+#define STATIC_MUTEX_DECL(name)                                             \
+  chibios_static::Mutex name = {_MUTEX_DATA(name.mutex)}
+
+/**
+ * @brief   Static condition variable declaration.
+ *
+ * @param[in] name      the name of the condition variable
+ */
+#define STATIC_CONDVAR_DECL(name)                                           \
+  chibios_static::CondVar name = {_CONDVAR_DATA(name.condvar)}
+
+/**
+ * @brief   Static event source declaration.
+ *
+ * @param[in] name      the name of the event source variable
+ */
+#define STATIC_EVTSOURCE_DECL(name)                                         \
+  chibios_static::EvtSource name = {_EVENTSOURCE_DATA(name.ev_source)}
+
+/**
+ * @brief   Static mailbox declaration.
+ *
+ * @param[in] name      the name of the mailbox variable
+ * @param[in] n         number of messages in the buffer
+ */
+#define STATIC_MAILBOX_DECL(name, n)                                        \
+  chibios_static::Mailbox<n> name = {_MAILBOX_DATA(name.mb, name.mb_buf, n), \
+                                     {0}}
+
+/**
+ * @brief   Static objects pool declaration.
+ *
+ * @param[in] name      the name of the pool variable
+ * @param[in] type      type of the pool objects
+ * @param[in] n         number of objects in the pool
+ */
+#define STATIC_OBJECTSPOOL_DECL(name, type, n)                              \
+  chibios_static::ObjectsPool<type, n> name = {                             \
+    _MEMORYPOOL_DATA(name.pool,                                             \
+                     (chibios_static::ObjectsPool<type, n>::OBJSIZE),       \
+                     NULL),                                                 \
+    0, {NULL}                                                               \
+  }
+
+/**
+ * @brief   Static input queue declaration.
+ *
+ * @param[in] name      the name of the queue variable
+ * @param[in] n         size of the queue buffer
+ * @param[in] inotify   input notification callback pointer
+ * @param[in] link      application defined pointer
+ */
+#define STATIC_INQUEUE_DECL(name, n, inotify, link)                         \
+  chibios_static::InQueue<n> name = {                                       \
+    _INPUTQUEUE_DATA(name.iq, name.iq_buf, n, inotify, link), {0}           \
+  }
+
+/**
+ * @brief   Static output queue declaration.
+ *
+ * @param[in] name      the name of the queue variable
+ * @param[in] n         size of the queue buffer
+ * @param[in] onotify   output notification callback pointer
+ * @param[in] link      application defined pointer
+ */
+#define STATIC_OUTQUEUE_DECL(name, n, onotify, link)                        \
+  chibios_static::OutQueue<n> name = {                                      \
+    _OUTPUTQUEUE_DATA(name.oq, name.oq_buf, n, onotify, link), {0}          \
+  }
+
+/**
+ * @brief   Static thread descriptor initializer.
+ * @details The priority is taken from the working area type.
+ *
+ * @param[in] area      a @p chibios_static::ThreadArea variable
+ * @param[in] func      the thread function
+ * @param[in] arg       an argument passed to the thread function
+ * @param[in] name      the thread name, used when the registry is enabled
+ */
+#define STATIC_THREAD(area, func, arg, name)                                \
+  {(void *)(area).wa, sizeof (area).wa, (area).PRIO, (func), (arg), (name)}
+/** @} */
+
+/**
+ * @brief   ChibiOS statically initialized kernel objects.
+ */
+namespace chibios_static {
+
+  /*------------------------------------------------------------------------*
+   * chibios_static::ThreadArea                                             *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Working area of a static thread.
+   * @details The stack size and the priority are template parameters so
+   *          that they are verified at compile time.
+   *
+   * @param N                   stack size, as passed to @p THD_WA_SIZE()
+   * @param P                   thread priority
+   */
+  template <size_t N, tprio_t P>
+  struct ThreadArea {
+    /* Compile-time checks.*/
+    typedef char stack_size_below_STATIC_THREAD_MIN_STACK[
+                                  N >= STATIC_THREAD_MIN_STACK ? 1 : -1];
+    typedef char priority_out_of_range[(P > IDLEPRIO) && (P <= HIGHPRIO) ?
+                                       1 : -1];
+
+    /**
+     * @brief   Thread priority.
+     */
+    static const tprio_t PRIO = P;
+
+    /**
+     * @brief   Working area.
+     */
+    WORKING_AREA(wa, N);
+  };
+
+  /**
+   * @brief   Static thread descriptor.
+   * @details Use @p STATIC_THREAD() in order to initialize the descriptors,
+   *          a constant table of descriptors is placed in flash.
+   */
+  struct ThreadDescriptor {
+    void                *wa;        /**< @brief Working area.               */
+    size_t              size;       /**< @brief Working area size.          */
+    tprio_t             prio;       /**< @brief Thread priority.            */
+    tfunc_t             func;       /**< @brief Thread function.            */
+    void                *arg;       /**< @brief Thread function argument.   */
+    const char          *name;      /**< @brief Thread name.                */
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_static::System                                                 *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Static system description services.
+   */
+  class System {
+  public:
+    /**
+     * @brief   Starts all the threads in a descriptors table.
+     * @details The threads are created and made ready within a single
+     *          critical zone then a single reschedule is performed, the
+     *          threads with priority higher than the caller start
+     *          executing when the function returns.
+     * @note    The creation of each thread dominates, starting from a
+     *          table costs about the same as starting the threads one by
+     *          one. The table provides the compile-time checks and keeps
+     *          the threads description in flash.
+     * @note    The working areas of threads that terminated can be reused
+     *          by calling this function again.
+     *
+     * @param[in] threads   pointer to the descriptors table
+     * @param[in] n         number of descriptors in the table
+     *
+     * @api
+     */
+    static void start(const ThreadDescriptor *threads, size_t n) {
+      size_t i;
+
+      chSysLock();
+      for (i = 0; i < n; i++) {
+        Thread *tp = chThdCreateI(threads[i].wa, threads[i].size,
+                                  threads[i].prio, threads[i].func,
+                                  threads[i].arg);
+#if CH_USE_REGISTRY
+        tp->p_name = threads[i].name;
+#endif
+        chSchReadyI(tp);
+      }
+      chSchRescheduleS();
+      chSysUnlock();
+    }
+
+    /**
+     * @brief   Starts all the threads in a descriptors array.
+     *
+     * @param[in] threads   the descriptors array
+     *
+     * @api
+     */
+    template <size_t N>
+    static void start(const ThreadDescriptor (&threads)[N]) {
+
+      start(threads, N);
+    }
+  };
+
+#if CH_USE_SEMAPHORES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::CounterSemaphore                                       *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized counter semaphore.
+   */
+  struct CounterSemaphore {
+    /**
+     * @brief   Embedded @p ::Semaphore structure.
+     */
+    ::Semaphore sem;
+
+    /**
+     * @brief   Performs a wait operation on the semaphore.
+     *
+     * @api
+     */
+    msg_t wait(void) {
+
+      return chSemWait(&sem);
+    }
+
+    /**
+     * @brief   Performs a wait operation on the semaphore with timeout.
+     *
+     * @api
+     */
+    msg_t waitTimeout(systime_t time) {
+
+      return chSemWaitTimeout(&sem, time);
+    }
+
+    /**
+     * @brief   Performs a signal operation on the semaphore.
+     *
+     * @api
+     */
+    void signal(void) {
+
+      chSemSignal(&sem);
+    }
+
+    /**
+     * @brief   Performs a signal operation on the semaphore.
+     *
+     * @iclass
+     */
+    void signalI(void) {
+
+      chSemSignalI(&sem);
+    }
+
+    /**
+     * @brief   Performs a reset operation on the semaphore.
+     *
+     * @api
+     */
+    void reset(cnt_t n) {
+
+      chSemReset(&sem, n);
+    }
+
+    /**
+     * @brief   Returns the semaphore counter current value.
+     *
+     * @iclass
+     */
+    cnt_t getCounterI(void) {
+
+      return chSemGetCounterI(&sem);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_static::BinarySemaphore                                        *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized binary semaphore.
+   */
+  struct BinarySemaphore {
+    /**
+     * @brief   Embedded @p ::BinarySemaphore structure.
+     */
+    ::BinarySemaphore bsem;
+
+    /**
+     * @brief   Wait operation on the binary semaphore.
+     *
+     * @api
+     */
+    msg_t wait(void) {
+
+      return chBSemWait(&bsem);
+    }
+
+    /**
+     * @brief   Wait operation on the binary semaphore with timeout.
+     *
+     * @api
+     */
+    msg_t waitTimeout(systime_t time) {
+
+      return chBSemWaitTimeout(&bsem, time);
+    }
+
+    /**
+     * @brief   Performs a signal operation on the binary semaphore.
+     *
+     * @api
+     */
+    void signal(void) {
+
+      chBSemSignal(&bsem);
+    }
+
+    /**
+     * @brief   Performs a signal operation on the binary semaphore.
+     *
+     * @iclass
+     */
+    void signalI(void) {
+
+      chBSemSignalI(&bsem);
+    }
+
+    /**
+     * @brief   Returns the binary semaphore current state.
+     *
+     * @retval false        if the binary semaphore is not taken.
+     * @retval true         if the binary semaphore is taken.
+     *
+     * @iclass
+     */
+    bool getStateI(void) {
+
+      return (bool)chBSemGetStateI(&bsem);
+    }
+  };
+#endif /* CH_USE_SEMAPHORES */
+
+#if CH_USE_MUTEXES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::Mutex                                                  *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized mutex.
+   */
+  struct Mutex {
+    /**
+     * @brief   Embedded @p ::Mutex structure.
+     */
+    ::Mutex mutex;
+
+    /**
+     * @brief   Locks the mutex.
+     *
+     * @api
+     */
+    void lock(void) {
+
+      chMtxLock(&mutex);
+    }
+
+    /**
+     * @brief   Tries to lock the mutex.
+     *
+     * @retval false        if the mutex is already locked.
+     * @retval true         if the mutex has been locked.
+     *
+     * @api
+     */
+    bool tryLock(void) {
+
+      return (bool)chMtxTryLock(&mutex);
+    }
+
+    /**
+     * @brief   Unlocks the next owned mutex in reverse lock order.
+     *
+     * @api
+     */
+    static void unlock(void) {
+
+      chMtxUnlock();
+    }
+  };
+
+#if CH_USE_CONDVARS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::CondVar                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized condition variable.
+   */
+  struct CondVar {
+    /**
+     * @brief   Embedded @p ::CondVar structure.
+     */
+    ::CondVar condvar;
+
+    /**
+     * @brief   Signals one thread that is waiting on the condition variable.
+     *
+     * @api
+     */
+    void signal(void) {
+
+      chCondSignal(&condvar);
+    }
+
+    /**
+     * @brief   Signals all threads that are waiting on the condition
+     *          variable.
+     *
+     * @api
+     */
+    void broadcast(void) {
+
+      chCondBroadcast(&condvar);
+    }
+
+    /**
+     * @brief   Waits on the condition variable releasing the mutex lock.
+     *
+     * @api
+     */
+    msg_t wait(void) {
+
+      return chCondWait(&condvar);
+    }
+
+#if CH_USE_CONDVARS_TIMEOUT || defined(__DOXYGEN__)
+    /**
+     * @brief   Waits on the condition variable releasing the mutex lock,
+     *          with timeout.
+     *
+     * @api
+     */
+    msg_t waitTimeout(systime_t time) {
+
+      return chCondWaitTimeout(&condvar, time);
+    }
+#endif /* CH_USE_CONDVARS_TIMEOUT */
+  };
+#endif /* CH_USE_CONDVARS */
+#endif /* CH_USE_MUTEXES */
+
+#if CH_USE_EVENTS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::EvtSource                                              *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized event source.
+   */
+  struct EvtSource {
+    /**
+     * @brief   Embedded @p ::EventSource structure.
+     */
+    struct ::EventSource ev_source;
+
+    /**
+     * @brief   Registers a listener on the event source.
+     *
+     * @api
+     */
+    void registerOne(chibios_rt::EvtListener *elp, eventid_t eid) {
+
+      chEvtRegister(&ev_source, &elp->ev_listener, eid);
+    }
+
+    /**
+     * @brief   Registers a listener on the event source with an events
+     *          mask.
+     *
+     * @api
+     */
+    void registerMask(chibios_rt::EvtListener *elp, eventmask_t emask) {
+
+      chEvtRegisterMask(&ev_source, &elp->ev_listener, emask);
+    }
+
+    /**
+     * @brief   Unregisters a listener.
+     *
+     * @api
+     */
+    void unregister(chibios_rt::EvtListener *elp) {
+
+      chEvtUnregister(&ev_source, &elp->ev_listener);
+    }
+
+    /**
+     * @brief   Broadcasts on the event source.
+     *
+     * @api
+     */
+    void broadcastFlags(flagsmask_t flags) {
+
+      chEvtBroadcastFlags(&ev_source, flags);
+    }
+
+    /**
+     * @brief   Broadcasts on the event source.
+     *
+     * @iclass
+     */
+    void broadcastFlagsI(flagsmask_t flags) {
+
+      chEvtBroadcastFlagsI(&ev_source, flags);
+    }
+  };
+#endif /* CH_USE_EVENTS */
+
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::Mailbox                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized mailbox and its messages buffer.
+   *
+   * @param N                   number of messages in the buffer
+   */
+  template <cnt_t N>
+  struct Mailbox {
+    typedef char mailbox_size_must_be_positive[N > 0 ? 1 : -1];
+
+    /**
+     * @brief   Embedded @p ::Mailbox structure.
+     */
+    ::Mailbox mb;
+
+    /**
+     * @brief   Messages buffer.
+     */
+    msg_t mb_buf[N];
+
+    /**
+     * @brief   Posts a message into the mailbox.
+     *
+     * @api
+     */
+    msg_t post(msg_t msg, systime_t time) {
+
+      return chMBPost(&mb, msg, time);
+    }
+
+    /**
+     * @brief   Posts a message into the mailbox.
+     *
+     * @iclass
+     */
+    msg_t postI(msg_t msg) {
+
+      return chMBPostI(&mb, msg);
+    }
+
+    /**
+     * @brief   Posts an high priority message into the mailbox.
+     *
+     * @api
+     */
+    msg_t postAhead(msg_t msg, systime_t time) {
+
+      return chMBPostAhead(&mb, msg, time);
+    }
+
+    /**
+     * @brief   Retrieves a message from the mailbox.
+     *
+     * @api
+     */
+    msg_t fetch(msg_t *msgp, systime_t time) {
+
+      return chMBFetch(&mb, msgp, time);
+    }
+
+    /**
+     * @brief   Retrieves a message from the mailbox.
+     *
+     * @iclass
+     */
+    msg_t fetchI(msg_t *msgp) {
+
+      return chMBFetchI(&mb, msgp);
+    }
+
+    /**
+     * @brief   Resets the mailbox.
+     *
+     * @api
+     */
+    void reset(void) {
+
+      chMBReset(&mb);
+    }
+
+    /**
+     * @brief   Returns the number of free message slots.
+     *
+     * @iclass
+     */
+    cnt_t getFreeCountI(void) {
+
+      return chMBGetFreeCountI(&mb);
+    }
+
+    /**
+     * @brief   Returns the number of used message slots.
+     *
+     * @iclass
+     */
+    cnt_t getUsedCountI(void) {
+
+      return chMBGetUsedCountI(&mb);
+    }
+  };
+#endif /* CH_USE_MAILBOXES */
+
+#if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::ObjectsPool                                            *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized objects pool.
+   * @details The pool free list starts empty and the objects buffer is
+   *          handed out sequentially on allocation, the objects that are
+   *          freed enter the free list. This replaces the startup
+   *          @p chPoolLoadArray() with no additional cost on allocation.
+   * @note    The pool uses more RAM than @p chibios_rt::ObjectsPool: the
+   *          count of objects handed out is an additional field and the
+   *          objects size is rounded up to a multiple of a pointer size so
+   *          that the free list links are always aligned.
+   * @note    The objects not yet handed out are not visible to the C API,
+   *          objects must be allocated through this class.
+   *
+   * @param T                   type of the objects
+   * @param N                   number of objects
+   */
+  template <class T, size_t N>
+  struct ObjectsPool {
+    typedef char pool_size_must_be_positive[N > 0 ? 1 : -1];
+
+    /**
+     * @brief   Objects size rounded up to a multiple of a pointer size.
+     */
+    static const size_t OBJSIZE = ((sizeof (T) + sizeof (void *) - 1) /
+                                   sizeof (void *)) * sizeof (void *);
+
+    /**
+     * @brief   Embedded @p ::MemoryPool structure.
+     */
+    ::MemoryPool pool;
+
+    /**
+     * @brief   Number of objects already handed out from the buffer.
+     */
+    size_t next;
+
+    /**
+     * @brief   Objects buffer, declared as pointers for alignment.
+     */
+    void *pool_buf[(N * OBJSIZE) / sizeof (void *)];
+
+    /**
+     * @brief   Allocates an object from the pool.
+     *
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if the pool is empty.
+     *
+     * @iclass
+     */
+    T *allocI(void) {
+      void *objp = chPoolAllocI(&pool);
+
+      if ((objp == NULL) && (next < N))
+        objp = &pool_buf[next++ * (OBJSIZE / sizeof (void *))];
+      return (T *)objp;
+    }
+
+    /**
+     * @brief   Allocates an object from the pool.
+     *
+     * @return              The pointer to the allocated object.
+     * @retval NULL         if the pool is empty.
+     *
+     * @api
+     */
+    T *alloc(void) {
+      T *objp;
+
+      chSysLock();
+      objp = allocI();
+      chSysUnlock();
+      return objp;
+    }
+
+    /**
+     * @brief   Releases an object into the pool.
+     *
+     * @iclass
+     */
+    void freeI(T *objp) {
+
+      chPoolFreeI(&pool, objp);
+    }
+
+    /**
+     * @brief   Releases an object into the pool.
+     *
+     * @api
+     */
+    void free(T *objp) {
+
+      chPoolFree(&pool, objp);
+    }
+  };
+#endif /* CH_USE_MEMPOOLS */
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_static::InQueue                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized input queue and its buffer.
+   *
+   * @param N                   size of the input queue
+   */
+  template <size_t N>
+  struct InQueue {
+    typedef char queue_size_must_be_positive[N > 0 ? 1 : -1];
+
+    /**
+     * @brief   Embedded @p ::InputQueue structure.
+     */
+    ::InputQueue iq;
+
+    /**
+     * @brief   Queue buffer.
+     */
+    uint8_t iq_buf[N];
+
+    /**
+     * @brief   Input queue write.
+     *
+     * @iclass
+     */
+    msg_t putI(uint8_t b) {
+
+      return chIQPutI(&iq, b);
+    }
+
+    /**
+     * @brief   Input queue read with timeout.
+     *
+     * @api
+     */
+    msg_t getTimeout(systime_t time) {
+
+      return chIQGetTimeout(&iq, time);
+    }
+
+    /**
+     * @brief   Input queue bulk read with timeout.
+     *
+     * @api
+     */
+    size_t readTimeout(uint8_t *bp, size_t n, systime_t time) {
+
+      return chIQReadTimeout(&iq, bp, n, time);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_static::OutQueue                                               *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically initialized output queue and its buffer.
+   *
+   * @param N                   size of the output queue
+   */
+  template <size_t N>
+  struct OutQueue {
+    typedef char queue_size_must_be_positive[N > 0 ? 1 : -1];
+
+    /**
+     * @brief   Embedded @p ::OutputQueue structure.
+     */
+    ::OutputQueue oq;
+
+    /**
+     * @brief   Queue buffer.
+     */
+    uint8_t oq_buf[N];
+
+    /**
+     * @brief   Output queue read.
+     *
+     * @iclass
+     */
+    msg_t getI(void) {
+
+      return chOQGetI(&oq);
+    }
+
+    /**
+     * @brief   Output queue write with timeout.
+     *
+     * @api
+     */
+    msg_t putTimeout(uint8_t b, systime_t time) {
+
+      return chOQPutTimeout(&oq, b, time);
+    }
+
+    /**
+     * @brief   Output queue bulk write with timeout.
+     *
+     * @api
+     */
+    size_t writeTimeout(const uint8_t *bp, size_t n, systime_t time) {
+
+      return chOQWriteTimeout(&oq, bp, n, time);
+    }
+  };
+#endif /* CH_USE_QUEUES */
+}
+
+#endif /* _CHSTATIC_HPP_ */
+
+/** @} */
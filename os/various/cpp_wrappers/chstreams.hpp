@@ -0,0 +1,933 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    chstreams.hpp
+ * @brief   C++ statically dispatched streams and queues.
+ * @details This header is a template-only layer, nothing has to be added to
+ *          the build. Unlike the @p InQueue, @p OutQueue and
+ *          @p BaseSequentialStreamInterface wrappers the classes in this
+ *          file are bound at compile time: the per-byte fast paths are
+ *          expanded inline and the bulk operations copy whole contiguous
+ *          segments of the buffers while holding the kernel lock.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.hpp"
+
+#ifndef _CHSTREAMS_HPP_
+#define _CHSTREAMS_HPP_
+
+/**
+ * @brief   Maximum number of bytes copied within a single critical zone.
+ * @details Bulk queue transfers are split in chunks not larger than this
+ *          value, the kernel lock is released between chunks in order to
+ *          bound the interrupts latency.
+ */
+#if !defined(CHSTREAMS_MAX_CHUNK) || defined(__DOXYGEN__)
+#define CHSTREAMS_MAX_CHUNK             64
+#endif
+
+#if CHSTREAMS_MAX_CHUNK < 1
+#error "invalid CHSTREAMS_MAX_CHUNK value"
+#endif
+
+namespace chibios_rt {
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::Fifo                                                       *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class of a typed ring buffer.
+   * @details The buffer does not involve the kernel at all, there is no
+   *          locking and no waiting, the caller is responsible for the
+   *          serialization of the accesses, for example by using the buffer
+   *          only from within a critical zone or from a single thread.
+   * @note    The bulk operations copy the objects using @p memcpy(), @p T
+   *          must be a POD type.
+   *
+   * @param T                   type of the buffered objects
+   * @param N                   number of objects, it must be a power of two
+   */
+  template <class T, size_t N>
+  class Fifo {
+  private:
+    /* Compile-time check on the buffer size.*/
+    typedef char fifo_size_must_be_a_power_of_two[(N > 0) &&
+                                                  ((N & (N - 1)) == 0) ?
+                                                  1 : -1];
+
+    /* Free running indexes, the counters are masked on access and their
+       difference is the number of buffered objects.*/
+    size_t wr;
+    size_t rd;
+    T buffer[N];
+
+  public:
+    /**
+     * @brief   Fifo constructor.
+     *
+     * @init
+     */
+    Fifo(void) : wr(0), rd(0) {
+    }
+
+    /**
+     * @brief   Returns the buffer size.
+     *
+     * @return              The number of objects the buffer can hold.
+     */
+    size_t getSize(void) const {
+
+      return N;
+    }
+
+    /**
+     * @brief   Returns the number of buffered objects.
+     *
+     * @return              The number of buffered objects.
+     */
+    size_t getFull(void) const {
+
+      return wr - rd;
+    }
+
+    /**
+     * @brief   Returns the number of empty slots.
+     *
+     * @return              The number of empty slots.
+     */
+    size_t getEmpty(void) const {
+
+      return N - (wr - rd);
+    }
+
+    /**
+     * @brief   Evaluates to @p true if the buffer is empty.
+     *
+     * @return              The buffer status.
+     */
+    bool isEmpty(void) const {
+
+      return wr == rd;
+    }
+
+    /**
+     * @brief   Evaluates to @p true if the buffer is full.
+     *
+     * @return              The buffer status.
+     */
+    bool isFull(void) const {
+
+      return wr - rd == N;
+    }
+
+    /**
+     * @brief   Discards all the buffered objects.
+     */
+    void reset(void) {
+
+      wr = rd = 0;
+    }
+
+    /**
+     * @brief   Appends an object to the buffer.
+     *
+     * @param[in] obj       the object to be appended
+     * @return              The operation status.
+     * @retval false        if the buffer is full.
+     * @retval true         if the object has been appended.
+     */
+    bool put(const T &obj) {
+
+      if (isFull())
+        return false;
+      buffer[wr & (N - 1)] = obj;
+      wr++;
+      return true;
+    }
+
+    /**
+     * @brief   Removes the oldest object from the buffer.
+     *
+     * @param[out] obj      the removed object
+     * @return              The operation status.
+     * @retval false        if the buffer is empty.
+     * @retval true         if an object has been removed.
+     */
+    bool get(T &obj) {
+
+      if (isEmpty())
+        return false;
+      obj = buffer[rd & (N - 1)];
+      rd++;
+      return true;
+    }
+
+    /**
+     * @brief   Returns a pointer to the oldest object without removing it.
+     *
+     * @return              Pointer to the oldest object.
+     * @retval NULL         if the buffer is empty.
+     */
+    T *peek(void) {
+
+      if (isEmpty())
+        return NULL;
+      return &buffer[rd & (N - 1)];
+    }
+
+    /**
+     * @brief   Appends an array of objects to the buffer.
+     * @details The objects that do not fit in the buffer are not copied, the
+     *          copy is performed in at most two segments.
+     *
+     * @param[in] op        pointer to the objects to be appended
+     * @param[in] n         number of objects to be appended
+     * @return              The number of objects effectively appended.
+     */
+    size_t write(const T *op, size_t n) {
+      size_t i, seg;
+
+      if (n > getEmpty())
+        n = getEmpty();
+      i = wr & (N - 1);
+      seg = N - i < n ? N - i : n;
+      memcpy(&buffer[i], op, seg * sizeof (T));
+      memcpy(&buffer[0], op + seg, (n - seg) * sizeof (T));
+      wr += n;
+      return n;
+    }
+
+    /**
+     * @brief   Removes an array of objects from the buffer.
+     * @details The copy is performed in at most two segments.
+     *
+     * @param[out] op       pointer to the destination array
+     * @param[in] n         maximum number of objects to be removed
+     * @return              The number of objects effectively removed.
+     */
+    size_t read(T *op, size_t n) {
+      size_t i, seg;
+
+      if (n > getFull())
+        n = getFull();
+      i = rd & (N - 1);
+      seg = N - i < n ? N - i : n;
+      memcpy(op, &buffer[i], seg * sizeof (T));
+      memcpy(op + seg, &buffer[0], (n - seg) * sizeof (T));
+      rd += n;
+      return n;
+    }
+  };
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+  /**
+   * @brief   Suspends the current thread on a queue.
+   * @details Inline equivalent of the waiting logic of the kernel queues,
+   *          the woken thread receives the message posted by the I-class
+   *          queue functions.
+   *
+   * @param[in] qp        pointer to the @p GenericQueue structure
+   * @param[in] time      the number of ticks before the operation timeouts
+   * @return              The wakeup message.
+   *
+   * @notapi
+   */
+  static inline msg_t queueWaitS(GenericQueue *qp, systime_t time) {
+
+    if (TIME_IMMEDIATE == time)
+      return Q_TIMEOUT;
+    currp->p_u.wtobjp = qp;
+    queue_insert(currp, &qp->q_waiting);
+    return chSchGoSleepTimeoutS(THD_STATE_WTQUEUE, time);
+  }
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::StaticInQueue                                              *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating an input queue and its buffer.
+   * @details The embedded @p ::InputQueue is fully compatible with the C
+   *          API, the low level drivers keep feeding it using
+   *          @p chIQPutI() through @p getQueue(). The thread-side
+   *          operations are expanded inline.
+   * @note    The bulk read invokes the notification callback once for each
+   *          copied chunk instead of once for each byte.
+   *
+   * @param N                   size of the input queue
+   */
+  template <size_t N>
+  class StaticInQueue {
+  private:
+    ::InputQueue iq;
+    uint8_t iq_buf[N];
+
+  public:
+    /**
+     * @brief   StaticInQueue constructor.
+     *
+     * @param[in] infy      input notify callback function, can be @p NULL
+     * @param[in] link      parameter to be passed to the callback
+     *
+     * @init
+     */
+    StaticInQueue(qnotify_t infy, void *link) {
+
+      chIQInit(&iq, iq_buf, N, infy, link);
+    }
+
+    /**
+     * @brief   Returns a pointer to the embedded @p ::InputQueue.
+     *
+     * @return              Pointer to the C queue structure.
+     */
+    ::InputQueue *getQueue(void) {
+
+      return &iq;
+    }
+
+    /**
+     * @brief   Returns the filled space into the queue.
+     *
+     * @return              The number of full bytes in the queue.
+     *
+     * @iclass
+     */
+    size_t getFullI(void) {
+
+      return chIQGetFullI(&iq);
+    }
+
+    /**
+     * @brief   Returns the empty space into the queue.
+     *
+     * @return              The number of empty bytes in the queue.
+     *
+     * @iclass
+     */
+    size_t getEmptyI(void) {
+
+      return chIQGetEmptyI(&iq);
+    }
+
+    /**
+     * @brief   Evaluates to @p true if the queue is empty.
+     *
+     * @return              The queue status.
+     *
+     * @iclass
+     */
+    bool isEmptyI(void) {
+
+      return (bool)chIQIsEmptyI(&iq);
+    }
+
+    /**
+     * @brief   Resets the queue.
+     * @details All the data in the queue is erased and lost, any waiting
+     *          thread is resumed with status @p Q_RESET.
+     *
+     * @iclass
+     */
+    void resetI(void) {
+
+      chIQResetI(&iq);
+    }
+
+    /**
+     * @brief   Input queue write.
+     *
+     * @param[in] b         the byte value to be written in the queue
+     * @return              The operation status.
+     * @retval Q_OK         if the operation has been completed with success.
+     * @retval Q_FULL       if the queue is full.
+     *
+     * @iclass
+     */
+    msg_t putI(uint8_t b) {
+
+      return chIQPutI(&iq, b);
+    }
+
+    /**
+     * @brief   Input queue read with timeout.
+     * @details Same semantic of @p chIQGetTimeout().
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              A byte value from the queue.
+     * @retval Q_TIMEOUT    if the specified time expired.
+     * @retval Q_RESET      if the queue has been reset.
+     *
+     * @api
+     */
+    msg_t getTimeout(systime_t time) {
+      uint8_t b;
+
+      chSysLock();
+      if (iq.q_notify)
+        iq.q_notify(&iq);
+
+      while (chIQIsEmptyI(&iq)) {
+        msg_t msg = queueWaitS((GenericQueue *)&iq, time);
+        if (msg < Q_OK) {
+          chSysUnlock();
+          return msg;
+        }
+      }
+
+      iq.q_counter--;
+      b = *iq.q_rdptr++;
+      if (iq.q_rdptr >= iq.q_top)
+        iq.q_rdptr = iq.q_buffer;
+
+      chSysUnlock();
+      return b;
+    }
+
+    /**
+     * @brief   Input queue read.
+     *
+     * @return              A byte value from the queue.
+     * @retval Q_RESET      if the queue has been reset.
+     *
+     * @api
+     */
+    msg_t get(void) {
+
+      return getTimeout(TIME_INFINITE);
+    }
+
+    /**
+     * @brief   Input queue bulk read with timeout.
+     * @details Same semantic of @p chIQReadTimeout() except that the data
+     *          is moved in contiguous chunks of up to
+     *          @p CHSTREAMS_MAX_CHUNK bytes for each critical zone.
+     *
+     * @param[out] bp       pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be transferred, the
+     *                      value 0 is reserved
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The number of bytes effectively transferred.
+     *
+     * @api
+     */
+    size_t readTimeout(uint8_t *bp, size_t n, systime_t time) {
+      size_t r = 0;
+
+      chDbgCheck(n > 0, "StaticInQueue::readTimeout");
+
+      chSysLock();
+      while (true) {
+        size_t chunk;
+
+        if (iq.q_notify)
+          iq.q_notify(&iq);
+
+        while (chIQIsEmptyI(&iq)) {
+          if (queueWaitS((GenericQueue *)&iq, time) != Q_OK) {
+            chSysUnlock();
+            return r;
+          }
+        }
+
+        /* Largest contiguous segment not exceeding the chunk size.*/
+        chunk = (size_t)(iq.q_top - iq.q_rdptr);
+        if (chunk > chQSpaceI(&iq))
+          chunk = chQSpaceI(&iq);
+        if (chunk > n)
+          chunk = n;
+        if (chunk > CHSTREAMS_MAX_CHUNK)
+          chunk = CHSTREAMS_MAX_CHUNK;
+
+        memcpy(bp, iq.q_rdptr, chunk);
+        iq.q_counter -= chunk;
+        iq.q_rdptr += chunk;
+        if (iq.q_rdptr >= iq.q_top)
+          iq.q_rdptr = iq.q_buffer;
+
+        chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
+        bp += chunk;
+        r += chunk;
+        n -= chunk;
+        if (n == 0)
+          return r;
+
+        chSysLock();
+      }
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::StaticOutQueue                                             *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Template class encapsulating an output queue and its buffer.
+   * @details The embedded @p ::OutputQueue is fully compatible with the C
+   *          API, the low level drivers keep draining it using
+   *          @p chOQGetI() through @p getQueue(). The thread-side
+   *          operations are expanded inline.
+   * @note    The bulk write invokes the notification callback once for each
+   *          copied chunk instead of once for each byte.
+   *
+   * @param N                   size of the output queue
+   */
+  template <size_t N>
+  class StaticOutQueue {
+  private:
+    ::OutputQueue oq;
+    uint8_t oq_buf[N];
+
+  public:
+    /**
+     * @brief   StaticOutQueue constructor.
+     *
+     * @param[in] onfy      output notify callback function, can be @p NULL
+     * @param[in] link      parameter to be passed to the callback
+     *
+     * @init
+     */
+    StaticOutQueue(qnotify_t onfy, void *link) {
+
+      chOQInit(&oq, oq_buf, N, onfy, link);
+    }
+
+    /**
+     * @brief   Returns a pointer to the embedded @p ::OutputQueue.
+     *
+     * @return              Pointer to the C queue structure.
+     */
+    ::OutputQueue *getQueue(void) {
+
+      return &oq;
+    }
+
+    /**
+     * @brief   Returns the filled space into the queue.
+     *
+     * @return              The number of full bytes in the queue.
+     *
+     * @iclass
+     */
+    size_t getFullI(void) {
+
+      return chOQGetFullI(&oq);
+    }
+
+    /**
+     * @brief   Returns the empty space into the queue.
+     *
+     * @return              The number of empty bytes in the queue.
+     *
+     * @iclass
+     */
+    size_t getEmptyI(void) {
+
+      return chOQGetEmptyI(&oq);
+    }
+
+    /**
+     * @brief   Evaluates to @p true if the queue is full.
+     *
+     * @return              The queue status.
+     *
+     * @iclass
+     */
+    bool isFullI(void) {
+
+      return (bool)chOQIsFullI(&oq);
+    }
+
+    /**
+     * @brief   Resets the queue.
+     * @details All the data in the queue is erased and lost, any waiting
+     *          thread is resumed with status @p Q_RESET.
+     *
+     * @iclass
+     */
+    void resetI(void) {
+
+      chOQResetI(&oq);
+    }
+
+    /**
+     * @brief   Output queue read.
+     *
+     * @return              The byte value from the queue.
+     * @retval Q_EMPTY      if the queue is empty.
+     *
+     * @iclass
+     */
+    msg_t getI(void) {
+
+      return chOQGetI(&oq);
+    }
+
+    /**
+     * @brief   Output queue write with timeout.
+     * @details Same semantic of @p chOQPutTimeout().
+     *
+     * @param[in] b         the byte value to be written in the queue
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval Q_OK         if the operation succeeded.
+     * @retval Q_TIMEOUT    if the specified time expired.
+     * @retval Q_RESET      if the queue has been reset.
+     *
+     * @api
+     */
+    msg_t putTimeout(uint8_t b, systime_t time) {
+
+      chSysLock();
+      while (chOQIsFullI(&oq)) {
+        msg_t msg = queueWaitS((GenericQueue *)&oq, time);
+        if (msg < Q_OK) {
+          chSysUnlock();
+          return msg;
+        }
+      }
+
+      oq.q_counter--;
+      *oq.q_wrptr++ = b;
+      if (oq.q_wrptr >= oq.q_top)
+        oq.q_wrptr = oq.q_buffer;
+
+      if (oq.q_notify)
+        oq.q_notify(&oq);
+
+      chSysUnlock();
+      return Q_OK;
+    }
+
+    /**
+     * @brief   Output queue write.
+     *
+     * @param[in] b         the byte value to be written in the queue
+     * @return              The operation status.
+     * @retval Q_OK         if the operation succeeded.
+     * @retval Q_RESET      if the queue has been reset.
+     *
+     * @api
+     */
+    msg_t put(uint8_t b) {
+
+      return putTimeout(b, TIME_INFINITE);
+    }
+
+    /**
+     * @brief   Output queue bulk write with timeout.
+     * @details Same semantic of @p chOQWriteTimeout() except that the data
+     *          is moved in contiguous chunks of up to
+     *          @p CHSTREAMS_MAX_CHUNK bytes for each critical zone.
+     *
+     * @param[in] bp        pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be transferred, the
+     *                      value 0 is reserved
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The number of bytes effectively transferred.
+     *
+     * @api
+     */
+    size_t writeTimeout(const uint8_t *bp, size_t n, systime_t time) {
+      size_t w = 0;
+
+      chDbgCheck(n > 0, "StaticOutQueue::writeTimeout");
+
+      chSysLock();
+      while (true) {
+        size_t chunk;
+
+        while (chOQIsFullI(&oq)) {
+          if (queueWaitS((GenericQueue *)&oq, time) != Q_OK) {
+            chSysUnlock();
+            return w;
+          }
+        }
+
+        /* Largest contiguous segment not exceeding the chunk size.*/
+        chunk = (size_t)(oq.q_top - oq.q_wrptr);
+        if (chunk > chQSpaceI(&oq))
+          chunk = chQSpaceI(&oq);
+        if (chunk > n)
+          chunk = n;
+        if (chunk > CHSTREAMS_MAX_CHUNK)
+          chunk = CHSTREAMS_MAX_CHUNK;
+
+        memcpy(oq.q_wrptr, bp, chunk);
+        oq.q_counter -= chunk;
+        oq.q_wrptr += chunk;
+        if (oq.q_wrptr >= oq.q_top)
+          oq.q_wrptr = oq.q_buffer;
+
+        if (oq.q_notify)
+          oq.q_notify(&oq);
+
+        chSysUnlock(); /* Gives a preemption chance in a controlled point.*/
+        bp += chunk;
+        w += chunk;
+        n -= chunk;
+        if (n == 0)
+          return w;
+
+        chSysLock();
+      }
+    }
+  };
+#endif /* CH_USE_QUEUES */
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::SequentialStream                                           *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically dispatched sequential stream.
+   * @details Base class of the streams bound at compile time, the derived
+   *          class @p S passes itself as template parameter and implements
+   *          @p writeTimeout(), @p readTimeout(), @p putTimeout() and
+   *          @p getTimeout(). Code written against
+   *          <tt>SequentialStream<S> &</tt> is resolved and inlined at
+   *          compile time, there is no virtual table involved.
+   *
+   * @param S                   the derived stream class
+   */
+  template <class S>
+  class SequentialStream {
+  protected:
+    /**
+     * @brief   Returns the derived stream.
+     */
+    S &self(void) {
+
+      return *static_cast<S *>(this);
+    }
+
+  public:
+    /**
+     * @brief   Sequential Stream write.
+     *
+     * @param[in] bp        pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be transferred
+     * @return              The number of bytes transferred.
+     *
+     * @api
+     */
+    size_t write(const uint8_t *bp, size_t n) {
+
+      if (n == 0)
+        return 0;
+      return self().writeTimeout(bp, n, TIME_INFINITE);
+    }
+
+    /**
+     * @brief   Sequential Stream read.
+     *
+     * @param[out] bp       pointer to the data buffer
+     * @param[in] n         the maximum amount of data to be transferred
+     * @return              The number of bytes transferred.
+     *
+     * @api
+     */
+    size_t read(uint8_t *bp, size_t n) {
+
+      if (n == 0)
+        return 0;
+      return self().readTimeout(bp, n, TIME_INFINITE);
+    }
+
+    /**
+     * @brief   Sequential Stream blocking byte write.
+     *
+     * @param[in] b         the byte value to be written to the channel
+     * @return              The operation status.
+     * @retval Q_OK         if the operation succeeded.
+     * @retval Q_RESET      if an end-of-file condition has been met.
+     *
+     * @api
+     */
+    msg_t put(uint8_t b) {
+
+      return self().putTimeout(b, TIME_INFINITE);
+    }
+
+    /**
+     * @brief   Sequential Stream blocking byte read.
+     *
+     * @return              A byte value from the channel.
+     * @retval Q_RESET      if an end-of-file condition has been met.
+     *
+     * @api
+     */
+    msg_t get(void) {
+
+      return self().getTimeout(TIME_INFINITE);
+    }
+  };
+
+#if CH_USE_QUEUES || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::QueueStream                                                *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Statically dispatched stream over a pair of queues.
+   * @details The stream reads from an input queue and writes to an output
+   *          queue, this is the structure of the buffered drivers, the low
+   *          level side accesses the queues using the C I-class API.
+   *
+   * @param NI                  size of the input queue
+   * @param NO                  size of the output queue
+   */
+  template <size_t NI, size_t NO>
+  class QueueStream : public SequentialStream<QueueStream<NI, NO> > {
+  public:
+    /**
+     * @brief   Input queue.
+     */
+    StaticInQueue<NI> iqueue;
+
+    /**
+     * @brief   Output queue.
+     */
+    StaticOutQueue<NO> oqueue;
+
+    /**
+     * @brief   QueueStream constructor.
+     *
+     * @param[in] infy      input notify callback function, can be @p NULL
+     * @param[in] onfy      output notify callback function, can be @p NULL
+     * @param[in] link      parameter to be passed to the callbacks
+     *
+     * @init
+     */
+    QueueStream(qnotify_t infy, qnotify_t onfy, void *link) :
+      iqueue(infy, link), oqueue(onfy, link) {
+    }
+
+    /**
+     * @brief   Stream write with timeout.
+     *
+     * @api
+     */
+    size_t writeTimeout(const uint8_t *bp, size_t n, systime_t time) {
+
+      return oqueue.writeTimeout(bp, n, time);
+    }
+
+    /**
+     * @brief   Stream read with timeout.
+     *
+     * @api
+     */
+    size_t readTimeout(uint8_t *bp, size_t n, systime_t time) {
+
+      return iqueue.readTimeout(bp, n, time);
+    }
+
+    /**
+     * @brief   Stream byte write with timeout.
+     *
+     * @api
+     */
+    msg_t putTimeout(uint8_t b, systime_t time) {
+
+      return oqueue.putTimeout(b, time);
+    }
+
+    /**
+     * @brief   Stream byte read with timeout.
+     *
+     * @api
+     */
+    msg_t getTimeout(systime_t time) {
+
+      return iqueue.getTimeout(time);
+    }
+  };
+#endif /* CH_USE_QUEUES */
+
+  /*------------------------------------------------------------------------*
+   * chibios_rt::StreamAdapter                                              *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Exposes a statically dispatched stream as a
+   *          @p BaseSequentialStreamInterface.
+   * @details Allows to pass a stream to code that uses the virtual
+   *          interface, for example @p chprintf() after a cast to
+   *          @p ::BaseSequentialStream. Only the calls made through the
+   *          adapter pay for the virtual dispatch.
+   *
+   * @param S                   the adapted stream class
+   */
+  template <class S>
+  class StreamAdapter : public BaseSequentialStreamInterface {
+  private:
+    S &stream;
+
+  public:
+    /**
+     * @brief   StreamAdapter constructor.
+     *
+     * @param[in] s         the stream to be adapted
+     *
+     * @init
+     */
+    StreamAdapter(S &s) : stream(s) {
+    }
+
+    virtual size_t write(const uint8_t *bp, size_t n) {
+
+      return stream.write(bp, n);
+    }
+
+    virtual size_t read(uint8_t *bp, size_t n) {
+
+      return stream.read(bp, n);
+    }
+
+    virtual msg_t put(uint8_t b) {
+
+      return stream.put(b);
+    }
+
+    virtual msg_t get(void) {
+
+      return stream.get();
+    }
+  };
+}
+
+#endif /* _CHSTREAMS_HPP_ */
+
+/** @} */
@@ -0,0 +1,128 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    crc.h
+ * @brief   CRC library header.
+ *
+ * @addtogroup crc
+ * @{
+ */
+
+#ifndef _CRC_H_
+#define _CRC_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Well known initial values
+ * @{
+ */
+/**
+ * @brief   Initial value for the MMC/SD commands CRC7.
+ */
+#define CRC7_INIT_MMC               0x00
+/**
+ * @brief   Initial value for the MMC/SD data blocks CRC16 (XMODEM).
+ */
+#define CRC16_INIT_MMC              0x0000
+/**
+ * @brief   Initial value for the CRC16-CCITT (CCITT-FALSE).
+ */
+#define CRC16_INIT_CCITT            0xFFFF
+/**
+ * @brief   Initial value for the CRC32 (IEEE 802.3).
+ */
+#define CRC32_INIT                  0x00000000
+/** @} */
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of bytes processed by each step of the software kernels.
+ * @details Valid values are 1, 4 and 8. Each step uses a 256 entries lookup
+ *          table, the CRC16 and CRC32 tables occupy respectively 512 and
+ *          1024 bytes each.
+ */
+#if !defined(CRC_SLICING) || defined(__DOXYGEN__)
+#define CRC_SLICING                 4
+#endif
+
+/**
+ * @brief   CRC16 hardware backend hook.
+ * @details If defined this macro replaces the software kernel in
+ *          @p crc16Update(), it is invoked as
+ *          <tt>CRC16_HW_UPDATE(crc, buffer, n)</tt> and must evaluate to the
+ *          updated CRC. The backend can fall back to @p crc16SwUpdate() for
+ *          the parts it cannot handle, unaligned heads or tails as example.
+ */
+#if defined(__DOXYGEN__)
+#define CRC16_HW_UPDATE(crc, buffer, n)
+#endif
+
+/**
+ * @brief   CRC32 hardware backend hook.
+ * @details If defined this macro replaces the software kernel in
+ *          @p crc32Update(), it is invoked as
+ *          <tt>CRC32_HW_UPDATE(crc, buffer, n)</tt> and must evaluate to the
+ *          updated CRC using the same conventions of @p crc32SwUpdate().
+ * @note    Units like the STM32 CRC peripheral compute the non reflected
+ *          variant of the polynomial on 32 bits words, the backend must
+ *          take care of the bit and byte ordering.
+ */
+#if defined(__DOXYGEN__)
+#define CRC32_HW_UPDATE(crc, buffer, n)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (CRC_SLICING != 1) && (CRC_SLICING != 4) && (CRC_SLICING != 8)
+#error "invalid CRC_SLICING value"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  uint8_t crc7Update(uint8_t crc, const void *buffer, size_t n);
+  uint16_t crc16SwUpdate(uint16_t crc, const void *buffer, size_t n);
+  uint16_t crc16Update(uint16_t crc, const void *buffer, size_t n);
+  uint32_t crc32SwUpdate(uint32_t crc, const void *buffer, size_t n);
+  uint32_t crc32Update(uint32_t crc, const void *buffer, size_t n);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CRC_H_ */
+
+/** @} */
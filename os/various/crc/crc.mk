@@ -0,0 +1,4 @@
+# CRC library files.
+CRCSRC = ${CHIBIOS}/os/various/crc/crc.c
+
+CRCINC = ${CHIBIOS}/os/various/crc
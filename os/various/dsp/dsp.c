@@ -0,0 +1,583 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    dsp.c
+ * @brief   DSP blocks library code.
+ * @details The filtering, scaling and measurement stages use the CMSIS DSP
+ *          kernels when @p DSP_USE_CMSIS is enabled, the portable kernels
+ *          replicate the CMSIS arithmetic: 64 bits accumulators, truncation
+ *          of the discarded bits and saturation of the results.
+ *
+ * @addtogroup dsp
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "dsp.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Quarter period of a sine wave, Q15 format.
+ * @details The table has <tt>DSP_FFT_MAX_SIZE / 4 + 1</tt> entries.
+ */
+static const q15_t quarter_sine[DSP_FFT_MAX_SIZE / 4 + 1] = {
+      0,   201,   402,   603,   804,  1005,  1206,  1407,
+   1608,  1809,  2009,  2210,  2410,  2611,  2811,  3012,
+   3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+   4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+   6393,  6590,  6786,  6983,  7179,  7375,  7571,  7767,
+   7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+   9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849,
+  11039, 11228, 11417, 11605, 11793, 11980, 12167, 12353,
+  12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+  14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269,
+  15446, 15623, 15800, 15976, 16151, 16325, 16499, 16673,
+  16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+  18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357,
+  19519, 19680, 19841, 20000, 20159, 20317, 20475, 20631,
+  20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+  22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027,
+  23170, 23311, 23452, 23592, 23731, 23870, 24007, 24143,
+  24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+  25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198,
+  26319, 26438, 26556, 26674, 26790, 26905, 27019, 27133,
+  27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+  28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803,
+  28898, 28992, 29085, 29177, 29268, 29358, 29447, 29534,
+  29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+  30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783,
+  30852, 30919, 30985, 31050, 31113, 31176, 31237, 31297,
+  31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+  31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098,
+  32137, 32176, 32213, 32250, 32285, 32318, 32351, 32382,
+  32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+  32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717,
+  32728, 32737, 32745, 32752, 32757, 32761, 32765, 32766,
+  32767
+};
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Saturates a value to the Q15 range.
+ *
+ * @param[in] v         the value
+ * @return              The saturated value.
+ */
+static inline q15_t sat16(q63_t v) {
+
+  if (v > 32767)
+    return 32767;
+  if (v < -32768)
+    return -32768;
+  return (q15_t)v;
+}
+
+/**
+ * @brief   Integer square root.
+ *
+ * @param[in] v         the value
+ * @return              The square root rounded down.
+ */
+static uint32_t isqrt(uint32_t v) {
+  uint32_t r = 0, bit = 1UL << 30;
+
+  while (bit > v)
+    bit >>= 2;
+  while (bit != 0) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    }
+    else
+      r >>= 1;
+    bit >>= 2;
+  }
+  return r;
+}
+
+static const q15_t *fir_process(void *ip, const q15_t *in, q15_t *out,
+                                size_t *np) {
+  DSPFir *fp = ip;
+  size_t n = *np;
+
+  chDbgCheck(n <= fp->maxn, "fir_process");
+
+#if DSP_USE_CMSIS
+  arm_fir_q15(&fp->fir, (q15_t *)in, out, n);
+#else
+  {
+    q15_t *xp;
+    q63_t acc;
+    size_t i;
+    uint16_t k;
+
+    memcpy(fp->state + fp->ntaps - 1, in, n * sizeof(q15_t));
+    for (i = 0; i < n; i++) {
+      xp = fp->state + i;
+      acc = 0;
+      for (k = 0; k < fp->ntaps; k++)
+        acc += (q31_t)fp->coeffs[k] * xp[k];
+      out[i] = sat16(acc >> 15);
+    }
+    memmove(fp->state, fp->state + n, (fp->ntaps - 1) * sizeof(q15_t));
+  }
+#endif
+  return out;
+}
+
+static const struct DSPStageVMT fir_vmt = {fir_process};
+
+static const q15_t *biquad_process(void *ip, const q15_t *in, q15_t *out,
+                                   size_t *np) {
+  DSPBiquad *bp = ip;
+
+#if DSP_USE_CMSIS
+  arm_biquad_cascade_df1_q15(&bp->iir, (q15_t *)in, out, *np);
+#else
+  {
+    const q15_t *cp = bp->coeffs;
+    q15_t *sp = bp->state;
+    q15_t x1, x2, y1, y2, x;
+    q63_t acc;
+    size_t i;
+    uint8_t s;
+
+    for (s = 0; s < bp->nsections; s++) {
+      x1 = sp[0];
+      x2 = sp[1];
+      y1 = sp[2];
+      y2 = sp[3];
+      for (i = 0; i < *np; i++) {
+        x = in[i];
+        acc = (q31_t)cp[0] * x + (q31_t)cp[2] * x1 + (q31_t)cp[3] * x2;
+        acc += (q31_t)cp[4] * y1 + (q31_t)cp[5] * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = sat16(acc >> (15 - bp->shift));
+        out[i] = y1;
+      }
+      sp[0] = x1;
+      sp[1] = x2;
+      sp[2] = y1;
+      sp[3] = y2;
+      sp += 4;
+      cp += 6;
+      /* The next sections work on the output buffer.*/
+      in = out;
+    }
+  }
+#endif
+  return out;
+}
+
+static const struct DSPStageVMT biquad_vmt = {biquad_process};
+
+static const q15_t *decimator_process(void *ip, const q15_t *in, q15_t *out,
+                                      size_t *np) {
+  DSPDecimator *dp = ip;
+  size_t n = *np;
+
+  chDbgCheck((n <= dp->maxn) && ((n % dp->m) == 0), "decimator_process");
+
+#if DSP_USE_CMSIS
+  arm_fir_decimate_q15(&dp->dec, (q15_t *)in, out, n);
+#else
+  {
+    q15_t *xp;
+    q63_t acc;
+    size_t i;
+    uint16_t k;
+
+    memcpy(dp->state + dp->ntaps - 1, in, n * sizeof(q15_t));
+    for (i = 0; i < n / dp->m; i++) {
+      xp = dp->state + i * dp->m;
+      acc = 0;
+      for (k = 0; k < dp->ntaps; k++)
+        acc += (q31_t)dp->coeffs[k] * xp[k];
+      out[i] = sat16(acc >> 15);
+    }
+    memmove(dp->state, dp->state + n, (dp->ntaps - 1) * sizeof(q15_t));
+  }
+#endif
+  *np = n / dp->m;
+  return out;
+}
+
+static const struct DSPStageVMT decimator_vmt = {decimator_process};
+
+static const q15_t *scaler_process(void *ip, const q15_t *in, q15_t *out,
+                                   size_t *np) {
+  DSPScaler *sp = ip;
+
+#if DSP_USE_CMSIS
+  arm_scale_q15((q15_t *)in, sp->fract, sp->shift, out, *np);
+#else
+  {
+    int kshift = 15 - sp->shift;
+    size_t i;
+
+    for (i = 0; i < *np; i++)
+      out[i] = sat16(((q31_t)in[i] * sp->fract) >> kshift);
+  }
+#endif
+  return out;
+}
+
+static const struct DSPStageVMT scaler_vmt = {scaler_process};
+
+static const q15_t *level_process(void *ip, const q15_t *in, q15_t *out,
+                                  size_t *np) {
+  DSPLevel *lp = ip;
+  q63_t power;
+  q15_t max, min;
+  uint32_t ms;
+
+  (void)out;
+
+  if (*np == 0)
+    return in;
+
+#if DSP_USE_CMSIS
+  {
+    uint32_t index;
+
+    arm_power_q15((q15_t *)in, *np, &power);
+    arm_max_q15((q15_t *)in, *np, &max, &index);
+    arm_min_q15((q15_t *)in, *np, &min, &index);
+  }
+#else
+  {
+    size_t i;
+
+    power = 0;
+    max = min = in[0];
+    for (i = 0; i < *np; i++) {
+      power += (q31_t)in[i] * in[i];
+      if (in[i] > max)
+        max = in[i];
+      if (in[i] < min)
+        min = in[i];
+    }
+  }
+#endif
+
+  /* The power is in Q30 format, the square root of the mean is in Q15.*/
+  ms = (uint32_t)(power / (q63_t)*np);
+  lp->rms = (q15_t)(ms >= (1UL << 30) ? 32767 : isqrt(ms));
+  lp->peak = sat16(-(q31_t)min > max ? -(q31_t)min : max);
+  return in;
+}
+
+static const struct DSPStageVMT level_vmt = {level_process};
+
+/**
+ * @brief   Twiddle factor.
+ *
+ * @param[in] i         angle in units of <tt>2 * pi / DSP_FFT_MAX_SIZE</tt>,
+ *                      from zero to <tt>DSP_FFT_MAX_SIZE / 2 - 1</tt>
+ * @param[out] cp       cosine of the angle
+ * @param[out] sp       sine of the angle
+ */
+static void twiddle(size_t i, q31_t *cp, q31_t *sp) {
+
+  if (i <= DSP_FFT_MAX_SIZE / 4) {
+    *sp = quarter_sine[i];
+    *cp = quarter_sine[DSP_FFT_MAX_SIZE / 4 - i];
+  }
+  else {
+    *sp = quarter_sine[DSP_FFT_MAX_SIZE / 2 - i];
+    *cp = -quarter_sine[i - DSP_FFT_MAX_SIZE / 4];
+  }
+}
+
+static const q15_t *spectrum_process(void *ip, const q15_t *in, q15_t *out,
+                                     size_t *np) {
+  DSPSpectrum *sp = ip;
+  q15_t *w = sp->work;
+  size_t size = sp->size, i, j, k, len, half, step;
+  q31_t c, s, tr, ti, ar, ai;
+  uint32_t bits;
+
+  chDbgCheck(*np == size, "spectrum_process");
+
+  /* Bit reversed load, the imaginary parts are zero.*/
+  for (bits = 0; (1UL << bits) < size; bits++)
+    ;
+  for (i = 0; i < size; i++) {
+    for (j = 0, k = i, len = 0; len < bits; len++, k >>= 1)
+      j = (j << 1) | (k & 1);
+    w[j * 2] = in[i];
+    w[j * 2 + 1] = 0;
+  }
+
+  /* Radix-2 butterflies, each stage is scaled by one half.*/
+  for (len = 2; len <= size; len <<= 1) {
+    half = len / 2;
+    step = DSP_FFT_MAX_SIZE / len;
+    for (i = 0; i < size; i += len) {
+      for (j = 0; j < half; j++) {
+        q15_t *a = &w[(i + j) * 2];
+        q15_t *b = &w[(i + j + half) * 2];
+
+        twiddle(j * step, &c, &s);
+        tr = ((q31_t)b[0] * c + (q31_t)b[1] * s + 0x4000) >> 15;
+        ti = ((q31_t)b[1] * c - (q31_t)b[0] * s + 0x4000) >> 15;
+        ar = a[0];
+        ai = a[1];
+        a[0] = sat16((ar + tr) >> 1);
+        a[1] = sat16((ai + ti) >> 1);
+        b[0] = sat16((ar - tr) >> 1);
+        b[1] = sat16((ai - ti) >> 1);
+      }
+    }
+  }
+
+  /* Magnitudes of the bins up to the Nyquist frequency.*/
+  for (i = 0; i < size / 2; i++) {
+    uint32_t m = (uint32_t)((q31_t)w[i * 2] * w[i * 2]) +
+                 (uint32_t)((q31_t)w[i * 2 + 1] * w[i * 2 + 1]);
+    out[i] = sat16(isqrt(m));
+  }
+  *np = size / 2;
+  return out;
+}
+
+static const struct DSPStageVMT spectrum_vmt = {spectrum_process};
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a pipeline.
+ *
+ * @param[out] pp       pointer to the @p DSPPipeline object
+ * @param[in] stages    array of stages in processing order
+ * @param[in] n         number of stages
+ * @param[in] buf1      first intermediate buffer
+ * @param[in] buf2      second intermediate buffer
+ *
+ * @init
+ */
+void dspPipelineObjectInit(DSPPipeline *pp, DSPStage * const *stages,
+                           size_t n, q15_t *buf1, q15_t *buf2) {
+
+  chDbgCheck((pp != NULL) && (stages != NULL) &&
+             (buf1 != NULL) && (buf2 != NULL) && (buf1 != buf2),
+             "dspPipelineObjectInit");
+
+  pp->stages = stages;
+  pp->n = n;
+  pp->buffers[0] = buf1;
+  pp->buffers[1] = buf2;
+}
+
+/**
+ * @brief   Processes a block through all the stages of a pipeline.
+ * @details The stages alternate on the two intermediate buffers, the input
+ *          block is not modified.
+ *
+ * @param[in] pp        pointer to the @p DSPPipeline object
+ * @param[in] in        input block
+ * @param[in,out] np    the input block size, updated with the output block
+ *                      size
+ * @return              The output block, it is valid until the next
+ *                      invocation.
+ *
+ * @api
+ */
+const q15_t *dspPipelineProcess(DSPPipeline *pp, const q15_t *in,
+                                size_t *np) {
+  size_t i;
+
+  chDbgCheck((pp != NULL) && (in != NULL) && (np != NULL),
+             "dspPipelineProcess");
+
+  for (i = 0; i < pp->n; i++) {
+    q15_t *out = in == pp->buffers[0] ? pp->buffers[1] : pp->buffers[0];
+
+    in = dspStageProcess(pp->stages[i], in, out, np);
+  }
+  return in;
+}
+
+/**
+ * @brief   Initializes a FIR filter stage.
+ *
+ * @param[out] fp       pointer to the @p DSPFir object
+ * @param[in] ntaps     number of taps, even and not less than four
+ * @param[in] coeffs    coefficients in time reversed order
+ * @param[in] state     state buffer, see @p DSP_FIR_STATE_SIZE()
+ * @param[in] maxn      maximum block size
+ *
+ * @init
+ */
+void dspFirObjectInit(DSPFir *fp, uint16_t ntaps, const q15_t *coeffs,
+                      q15_t *state, size_t maxn) {
+
+  chDbgCheck((fp != NULL) && (ntaps >= 4) && ((ntaps & 1) == 0) &&
+             (coeffs != NULL) && (state != NULL), "dspFirObjectInit");
+
+  fp->vmt = &fir_vmt;
+  fp->ntaps = ntaps;
+  fp->coeffs = coeffs;
+  fp->state = state;
+  fp->maxn = maxn;
+#if DSP_USE_CMSIS
+  (void)arm_fir_init_q15(&fp->fir, ntaps, (q15_t *)coeffs, state, maxn);
+#else
+  memset(state, 0, DSP_FIR_STATE_SIZE(ntaps, maxn) * sizeof(q15_t));
+#endif
+}
+
+/**
+ * @brief   Initializes a biquad cascade stage.
+ *
+ * @param[out] bp       pointer to the @p DSPBiquad object
+ * @param[in] nsections number of sections
+ * @param[in] coeffs    six coefficients for each section
+ * @param[in] state     state buffer, see @p DSP_BIQUAD_STATE_SIZE()
+ * @param[in] shift     output shift, from zero to 15
+ *
+ * @init
+ */
+void dspBiquadObjectInit(DSPBiquad *bp, uint8_t nsections,
+                         const q15_t *coeffs, q15_t *state, int8_t shift) {
+
+  chDbgCheck((bp != NULL) && (nsections > 0) && (coeffs != NULL) &&
+             (state != NULL) && (shift >= 0) && (shift <= 15),
+             "dspBiquadObjectInit");
+
+  bp->vmt = &biquad_vmt;
+  bp->nsections = nsections;
+  bp->shift = shift;
+  bp->coeffs = coeffs;
+  bp->state = state;
+#if DSP_USE_CMSIS
+  arm_biquad_cascade_df1_init_q15(&bp->iir, nsections, (q15_t *)coeffs,
+                                  state, shift);
+#else
+  memset(state, 0, DSP_BIQUAD_STATE_SIZE(nsections) * sizeof(q15_t));
+#endif
+}
+
+/**
+ * @brief   Initializes a FIR decimator stage.
+ *
+ * @param[out] dp       pointer to the @p DSPDecimator object
+ * @param[in] ntaps     number of taps
+ * @param[in] m         decimation factor
+ * @param[in] coeffs    coefficients in time reversed order
+ * @param[in] state     state buffer, see @p DSP_DECIMATOR_STATE_SIZE()
+ * @param[in] maxn      maximum input block size, multiple of @p m
+ *
+ * @init
+ */
+void dspDecimatorObjectInit(DSPDecimator *dp, uint16_t ntaps, uint8_t m,
+                            const q15_t *coeffs, q15_t *state, size_t maxn) {
+
+  chDbgCheck((dp != NULL) && (ntaps > 0) && (m > 0) && (coeffs != NULL) &&
+             (state != NULL) && ((maxn % m) == 0), "dspDecimatorObjectInit");
+
+  dp->vmt = &decimator_vmt;
+  dp->ntaps = ntaps;
+  dp->m = m;
+  dp->coeffs = coeffs;
+  dp->state = state;
+  dp->maxn = maxn;
+#if DSP_USE_CMSIS
+  (void)arm_fir_decimate_init_q15(&dp->dec, ntaps, m, (q15_t *)coeffs,
+                                  state, maxn);
+#else
+  memset(state, 0, DSP_DECIMATOR_STATE_SIZE(ntaps, maxn) * sizeof(q15_t));
+#endif
+}
+
+/**
+ * @brief   Initializes a scaling stage.
+ *
+ * @param[out] sp       pointer to the @p DSPScaler object
+ * @param[in] fract     fractional multiplier
+ * @param[in] shift     shift, from -16 to 15
+ *
+ * @init
+ */
+void dspScalerObjectInit(DSPScaler *sp, q15_t fract, int8_t shift) {
+
+  chDbgCheck((sp != NULL) && (shift >= -16) && (shift <= 15),
+             "dspScalerObjectInit");
+
+  sp->vmt = &scaler_vmt;
+  sp->fract = fract;
+  sp->shift = shift;
+}
+
+/**
+ * @brief   Initializes a level measurement stage.
+ *
+ * @param[out] lp       pointer to the @p DSPLevel object
+ *
+ * @init
+ */
+void dspLevelObjectInit(DSPLevel *lp) {
+
+  chDbgCheck(lp != NULL, "dspLevelObjectInit");
+
+  lp->vmt = &level_vmt;
+  lp->rms = 0;
+  lp->peak = 0;
+}
+
+/**
+ * @brief   Initializes a spectrum stage.
+ *
+ * @param[out] sp       pointer to the @p DSPSpectrum object
+ * @param[in] size      transform size, a power of two from 4 to
+ *                      @p DSP_FFT_MAX_SIZE
+ * @param[in] work      work area, see @p DSP_SPECTRUM_WORK_SIZE()
+ *
+ * @init
+ */
+void dspSpectrumObjectInit(DSPSpectrum *sp, size_t size, q15_t *work) {
+
+  chDbgCheck((sp != NULL) && (size >= 4) && (size <= DSP_FFT_MAX_SIZE) &&
+             ((size & (size - 1)) == 0) && (work != NULL),
+             "dspSpectrumObjectInit");
+
+  sp->vmt = &spectrum_vmt;
+  sp->size = size;
+  sp->work = work;
+}
+
+/** @} */
@@ -0,0 +1,343 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    dsp.h
+ * @brief   DSP blocks library header.
+ *
+ * @addtogroup dsp
+ * @{
+ */
+
+#ifndef _DSP_H_
+#define _DSP_H_
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum size of the spectrum stage transform.
+ */
+#define DSP_FFT_MAX_SIZE            1024
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Uses the CMSIS DSP library kernels.
+ * @details If set to @p TRUE the filtering, scaling and measurement stages
+ *          use the CMSIS DSP library functions, the application must
+ *          define the CMSIS core macro (@p ARM_MATH_CM4 as example) and
+ *          link the matching CMSIS DSP library. The portable kernels
+ *          produce the same results bit by bit.
+ */
+#if !defined(DSP_USE_CMSIS) || defined(__DOXYGEN__)
+#define DSP_USE_CMSIS               FALSE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if DSP_USE_CMSIS
+#include "arm_math.h"
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+#if !DSP_USE_CMSIS || defined(__DOXYGEN__)
+/**
+ * @brief   Q1.15 fixed point type.
+ */
+typedef int16_t q15_t;
+
+/**
+ * @brief   Q1.31 fixed point type.
+ */
+typedef int32_t q31_t;
+
+/**
+ * @brief   Q63 fixed point type.
+ */
+typedef int64_t q63_t;
+#endif
+
+/**
+ * @brief   @p DSPStage specific methods.
+ */
+#define _dsp_stage_methods                                                  \
+  /* Processes a block, returns the output and updates the block size.*/    \
+  const q15_t *(*process)(void *instance, const q15_t *in, q15_t *out,      \
+                          size_t *np);
+
+/**
+ * @brief   @p DSPStage specific data.
+ * @note    It is empty because @p DSPStage is only an interface without
+ *          implementation.
+ */
+#define _dsp_stage_data
+
+/**
+ * @brief   @p DSPStage virtual methods table.
+ */
+struct DSPStageVMT {
+  _dsp_stage_methods
+};
+
+/**
+ * @brief   Processing stage.
+ * @details A stage reads a block of samples and produces a block of
+ *          samples, the output block can be smaller than the input one.
+ *          A stage that does not modify the samples returns its input
+ *          without copying it.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+} DSPStage;
+
+/**
+ * @brief   Stages pipeline.
+ */
+typedef struct {
+  /**
+   * @brief Stages in processing order.
+   */
+  DSPStage * const          *stages;
+  /**
+   * @brief Number of stages.
+   */
+  size_t                    n;
+  /**
+   * @brief Intermediate buffers, each one large enough for the largest
+   *        block in the pipeline.
+   */
+  q15_t                     *buffers[2];
+} DSPPipeline;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   FIR filter stage.
+ * @details The coefficients are stored in time reversed order, the number
+ *          of taps must be even and at least four.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+#if DSP_USE_CMSIS || defined(__DOXYGEN__)
+  /** @brief CMSIS filter instance.*/
+  arm_fir_instance_q15      fir;
+#endif
+  /** @brief Number of taps.*/
+  uint16_t                  ntaps;
+  /** @brief Coefficients.*/
+  const q15_t               *coeffs;
+  /** @brief State, see @p DSP_FIR_STATE_SIZE().*/
+  q15_t                     *state;
+  /** @brief Maximum block size.*/
+  size_t                    maxn;
+} DSPFir;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   Biquad cascade stage, direct form I.
+ * @details Each section has six coefficients <tt>{b0, 0, b1, b2, a1, a2}</tt>
+ *          with the feedback coefficients negated, the results are shifted
+ *          left by @p shift bits allowing coefficients larger than one.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+#if DSP_USE_CMSIS || defined(__DOXYGEN__)
+  /** @brief CMSIS filter instance.*/
+  arm_biquad_casd_df1_inst_q15 iir;
+#endif
+  /** @brief Number of sections.*/
+  uint8_t                   nsections;
+  /** @brief Output shift.*/
+  int8_t                    shift;
+  /** @brief Coefficients.*/
+  const q15_t               *coeffs;
+  /** @brief State, four samples for each section.*/
+  q15_t                     *state;
+} DSPBiquad;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   FIR decimator stage.
+ * @details One output sample is produced each @p m input samples, the
+ *          blocks size must be a multiple of @p m.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+#if DSP_USE_CMSIS || defined(__DOXYGEN__)
+  /** @brief CMSIS decimator instance.*/
+  arm_fir_decimate_instance_q15 dec;
+#endif
+  /** @brief Number of taps.*/
+  uint16_t                  ntaps;
+  /** @brief Decimation factor.*/
+  uint8_t                   m;
+  /** @brief Coefficients.*/
+  const q15_t               *coeffs;
+  /** @brief State, see @p DSP_DECIMATOR_STATE_SIZE().*/
+  q15_t                     *state;
+  /** @brief Maximum block size.*/
+  size_t                    maxn;
+} DSPDecimator;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   Fixed point scaling stage.
+ * @details The samples are multiplied by <tt>fract * 2^shift</tt> with
+ *          saturation.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+  /** @brief Fractional multiplier.*/
+  q15_t                     fract;
+  /** @brief Shift, from -16 to 15.*/
+  int8_t                    shift;
+} DSPScaler;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   Level measurement stage.
+ * @details The RMS and peak values of each block are measured, the samples
+ *          are passed through unchanged.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+  /** @brief RMS value of the last block.*/
+  q15_t                     rms;
+  /** @brief Peak absolute value of the last block.*/
+  q15_t                     peak;
+} DSPLevel;
+
+/**
+ * @extends DSPStage
+ *
+ * @brief   Spectrum stage.
+ * @details Blocks of @p size samples are transformed in @p size / 2
+ *          magnitudes, from the DC bin up to the bin before the Nyquist
+ *          frequency. The transform is scaled by <tt>1 / size</tt>, a full
+ *          scale sine has magnitude 0.5.
+ */
+typedef struct {
+  /** @brief Virtual Methods Table.*/
+  const struct DSPStageVMT *vmt;
+  _dsp_stage_data
+  /** @brief Transform size.*/
+  size_t                    size;
+  /** @brief Work area, @p size complex samples.*/
+  q15_t                     *work;
+} DSPSpectrum;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Size of a FIR filter state.
+ *
+ * @param[in] ntaps     number of taps
+ * @param[in] maxn      maximum block size
+ */
+#define DSP_FIR_STATE_SIZE(ntaps, maxn) ((ntaps) + (maxn))
+
+/**
+ * @brief   Size of a FIR decimator state.
+ *
+ * @param[in] ntaps     number of taps
+ * @param[in] maxn      maximum input block size
+ */
+#define DSP_DECIMATOR_STATE_SIZE(ntaps, maxn) ((ntaps) + (maxn) - 1)
+
+/**
+ * @brief   Size of a biquad cascade state.
+ *
+ * @param[in] nsections number of sections
+ */
+#define DSP_BIQUAD_STATE_SIZE(nsections) ((nsections) * 4)
+
+/**
+ * @brief   Size of a spectrum stage work area.
+ *
+ * @param[in] size      transform size
+ */
+#define DSP_SPECTRUM_WORK_SIZE(size) ((size) * 2)
+
+/**
+ * @brief   Processes a block through a stage.
+ *
+ * @param[in] ip        pointer to a @p DSPStage or derived class
+ * @param[in] in        input block
+ * @param[out] out      output buffer, it can be left unused
+ * @param[in,out] np    the input block size, updated with the output block
+ *                      size
+ * @return              The output block, @p out or @p in.
+ *
+ * @api
+ */
+#define dspStageProcess(ip, in, out, np)                                    \
+  ((ip)->vmt->process(ip, in, out, np))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void dspPipelineObjectInit(DSPPipeline *pp, DSPStage * const *stages,
+                             size_t n, q15_t *buf1, q15_t *buf2);
+  const q15_t *dspPipelineProcess(DSPPipeline *pp, const q15_t *in,
+                                  size_t *np);
+  void dspFirObjectInit(DSPFir *fp, uint16_t ntaps, const q15_t *coeffs,
+                        q15_t *state, size_t maxn);
+  void dspBiquadObjectInit(DSPBiquad *bp, uint8_t nsections,
+                           const q15_t *coeffs, q15_t *state, int8_t shift);
+  void dspDecimatorObjectInit(DSPDecimator *dp, uint16_t ntaps, uint8_t m,
+                              const q15_t *coeffs, q15_t *state,
+                              size_t maxn);
+  void dspScalerObjectInit(DSPScaler *sp, q15_t fract, int8_t shift);
+  void dspLevelObjectInit(DSPLevel *lp);
+  void dspSpectrumObjectInit(DSPSpectrum *sp, size_t size, q15_t *work);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DSP_H_ */
+
+/** @} */
@@ -0,0 +1,4 @@
+# DSP library files.
+DSPSRC = ${CHIBIOS}/os/various/dsp/dsp.c
+
+DSPINC = ${CHIBIOS}/os/various/dsp
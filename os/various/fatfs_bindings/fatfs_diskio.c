@@ -317,6 +317,9 @@ DRESULT disk_ioctl (
     switch (ctrl) {
     case CTRL_SYNC:
         return RES_OK;
+    case GET_SECTOR_COUNT:
+        *((DWORD *)buff) = mmcsdGetCardCapacity(&MMCD1);
+        return RES_OK;
     case GET_SECTOR_SIZE:
         *((WORD *)buff) = MMCSD_BLOCK_SIZE;
         return RES_OK;
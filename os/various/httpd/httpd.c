@@ -0,0 +1,964 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    httpd.c
+ * @brief   HTTP static files server code.
+ * @details The files are read by FatFs directly into the transmit buffers
+ *          of the worker, whole sectors are transferred from the disk
+ *          without passing through the FatFs buffers, then the buffers
+ *          are passed by reference to the TCP stack without copying the
+ *          data into pbufs. A buffer is reused only after all its data has
+ *          been acknowledged by the peer.
+ *
+ * @addtogroup httpd
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "httpd.h"
+
+#include "lwip/opt.h"
+#include "lwip/api.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+
+#if LWIP_NETCONN || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define INDEX_MASK                  (HTTPD_INDEX_SIZE - 1)
+#define INDEX_DEPTH                 4
+#define HEADER_SIZE                 320
+
+#define STAT_INC(field, n) {                                                \
+  chSysLock();                                                              \
+  stats.field += (n);                                                       \
+  chSysUnlock();                                                            \
+}
+
+/**
+ * @brief   Worker thread structure.
+ */
+typedef struct {
+  /** @brief Transmit buffers, first for alignment.*/
+  uint8_t                   buffers[HTTPD_BUFFERS][HTTPD_BUFFER_SIZE];
+  /** @brief Bytes written on the current connection after the data of
+      each buffer, used for tracking the acknowledged buffers.*/
+  uint32_t                  ends[HTTPD_BUFFERS];
+  /** @brief Bytes written on the current connection.*/
+  uint32_t                  written;
+  /** @brief Bytes acknowledged by the peer on the current connection,
+      updated by the tcpip thread.*/
+  uint32_t                  acked;
+  /** @brief Semaphore signaled on acknowledgments and connection errors.*/
+  BinarySemaphore           acksem;
+  /** @brief Connection tracked by the tcpip thread or @p NULL, only
+      accessed by the tcpip thread.*/
+  struct netconn            *tracked;
+  /** @brief Send sequence number of the first byte written on the tracked
+      connection, only accessed by the tcpip thread.*/
+  u32_t                     base;
+  /** @brief Next buffer to be used.*/
+  unsigned                  next;
+  /** @brief Current connection.*/
+  struct netconn            *conn;
+  /** @brief Partially consumed received netbuf or @p NULL.*/
+  struct netbuf             *nb;
+  /** @brief Offset of the data not yet consumed in @p nb.*/
+  u16_t                     nboff;
+  /** @brief Received request data.*/
+  char                      request[HTTPD_REQUEST_SIZE + 1];
+  /** @brief Number of bytes in @p request.*/
+  size_t                    reqlen;
+  /** @brief Path of the requested file.*/
+  char                      path[HTTPD_PATH_SIZE];
+  /** @brief Response header.*/
+  char                      header[HEADER_SIZE];
+  /** @brief Open file.*/
+  FIL                       fil;
+} worker_t;
+
+/**
+ * @brief   Parsed request.
+ */
+typedef struct {
+  bool_t                    head;
+  bool_t                    keepalive;
+  bool_t                    gzip;
+  bool_t                    range;
+  DWORD                     first;
+  DWORD                     last;
+  bool_t                    suffix;
+  uint32_t                  etag;
+  bool_t                    hasetag;
+  char                      *path;
+} request_t;
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Stack area for the listener thread.
+ */
+WORKING_AREA(wa_httpd_server, HTTPD_THREAD_STACK_SIZE);
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static HTTPDEntry entries[HTTPD_INDEX_SIZE];
+static char root[HTTPD_PATH_SIZE];
+static MUTEX_DECL(index_mtx);
+
+static HTTPDStats stats;
+
+static worker_t workers[HTTPD_THREADS];
+static WORKING_AREA(wa_workers[HTTPD_THREADS], HTTPD_THREAD_STACK_SIZE);
+static msg_t connections_buffer[HTTPD_THREADS * 2];
+static MAILBOX_DECL(connections, connections_buffer, HTTPD_THREADS * 2);
+
+static const struct {
+  const char                *ext;
+  const char                *type;
+} types[] = {
+  {"html", "text/html"},
+  {"htm",  "text/html"},
+  {"css",  "text/css"},
+  {"js",   "application/javascript"},
+  {"json", "application/json"},
+  {"txt",  "text/plain"},
+  {"xml",  "text/xml"},
+  {"svg",  "image/svg+xml"},
+  {"png",  "image/png"},
+  {"jpg",  "image/jpeg"},
+  {"jpeg", "image/jpeg"},
+  {"gif",  "image/gif"},
+  {"ico",  "image/x-icon"},
+  {NULL,   "application/octet-stream"}
+};
+
+static const char status_200[] = "200 OK";
+static const char status_206[] = "206 Partial Content";
+static const char status_304[] = "304 Not Modified";
+static const char status_400[] = "400 Bad Request";
+static const char status_404[] = "404 Not Found";
+static const char status_405[] = "405 Method Not Allowed";
+static const char status_416[] = "416 Requested Range Not Satisfiable";
+static const char status_500[] = "500 Internal Server Error";
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/*
+ * FNV-1a hash of a string.
+ */
+static uint32_t hash(const char *s) {
+  uint32_t h = 2166136261U;
+
+  while (*s)
+    h = (h ^ (uint8_t)*s++) * 16777619U;
+  return h;
+}
+
+/*
+ * MIME type from the file extension, the extension is case insensitive.
+ */
+static const char *mime_type(const char *path) {
+  const char *ext = strrchr(path, '.');
+  char buf[8];
+  unsigned i;
+
+  if ((ext == NULL) || (strlen(ext + 1) >= sizeof buf))
+    ext = "";
+  else
+    ext++;
+  for (i = 0; ext[i] != '\0'; i++)
+    buf[i] = (ext[i] >= 'A') && (ext[i] <= 'Z') ? ext[i] + 'a' - 'A' : ext[i];
+  buf[i] = '\0';
+  for (i = 0; types[i].ext != NULL; i++) {
+    if (strcmp(buf, types[i].ext) == 0)
+      break;
+  }
+  return types[i].type;
+}
+
+/*
+ * Returns the index entry of a path or a free entry for it, NULL if the
+ * path is not present and the index is full.
+ */
+static HTTPDEntry *index_find(const char *path, uint32_t h) {
+  unsigned i, n;
+
+  for (i = h & INDEX_MASK, n = 0; n < HTTPD_INDEX_SIZE;
+       i = (i + 1) & INDEX_MASK, n++) {
+    if (entries[i].path[0] == '\0')
+      return &entries[i];
+    if ((entries[i].hash == h) && (strcmp(entries[i].path, path) == 0))
+      return &entries[i];
+  }
+  return NULL;
+}
+
+/*
+ * Adds a file to the index, the path is relative to the document root.
+ */
+static bool_t index_add(char *path, FILINFO *fip) {
+  size_t n = strlen(path);
+  bool_t gz = (n > 3) && (strcmp(path + n - 3, ".gz") == 0);
+  HTTPDEntry *ep;
+  uint32_t h;
+
+  if (gz)
+    path[n - 3] = '\0';
+  h = hash(path);
+  ep = index_find(path, h);
+  if (ep != NULL) {
+    if (ep->path[0] == '\0') {
+      strcpy(ep->path, path);
+      ep->hash = h;
+      ep->type = mime_type(path);
+    }
+    if (gz)
+      ep->gzsize = fip->fsize;
+    else {
+      ep->size = fip->fsize;
+      ep->plain = TRUE;
+    }
+    ep->etag = ep->etag * 31 + ((uint32_t)fip->fdate << 16) + fip->ftime +
+               fip->fsize;
+  }
+  if (gz)
+    path[n - 3] = '.';
+  return ep == NULL ? CH_FAILED : CH_SUCCESS;
+}
+
+/*
+ * Scans a directory, the path buffer is HTTPD_PATH_SIZE bytes large.
+ */
+static bool_t index_scan(char *path, unsigned depth) {
+#if _USE_LFN
+  static char lfn[_MAX_LFN + 1];
+#endif
+  size_t n = strlen(path);
+  bool_t err = CH_SUCCESS;
+  FILINFO fi;
+  DIR dir;
+
+  if (f_opendir(&dir, path) != FR_OK)
+    return CH_FAILED;
+  while (TRUE) {
+    char *fn;
+
+#if _USE_LFN
+    fi.lfname = lfn;
+    fi.lfsize = sizeof lfn;
+#endif
+    if ((f_readdir(&dir, &fi) != FR_OK) || (fi.fname[0] == '\0'))
+      break;
+    if (fi.fname[0] == '.')
+      continue;
+#if _USE_LFN
+    fn = *fi.lfname ? fi.lfname : fi.fname;
+#else
+    fn = fi.fname;
+#endif
+    if (n + 1 + strlen(fn) >= HTTPD_PATH_SIZE) {
+      err = CH_FAILED;
+      continue;
+    }
+    path[n] = '/';
+    strcpy(path + n + 1, fn);
+    if (fi.fattrib & AM_DIR) {
+      if (depth < INDEX_DEPTH)
+        err |= index_scan(path, depth + 1);
+    }
+    else
+      err |= index_add(path + strlen(root), &fi);
+    path[n] = '\0';
+  }
+  return err;
+}
+
+/*
+ * Case insensitive header name match, returns a pointer to the value.
+ */
+static char *header_value(char *line, const char *name) {
+
+  while (*name) {
+    char c = *line++;
+    if ((c >= 'A') && (c <= 'Z'))
+      c += 'a' - 'A';
+    if (c != *name++)
+      return NULL;
+  }
+  if (*line++ != ':')
+    return NULL;
+  while (*line == ' ')
+    line++;
+  return line;
+}
+
+static char *parse_number(char *p, DWORD *np) {
+  DWORD n = 0;
+
+  if ((*p < '0') || (*p > '9'))
+    return NULL;
+  while ((*p >= '0') && (*p <= '9'))
+    n = n * 10 + (*p++ - '0');
+  *np = n;
+  return p;
+}
+
+static char *append(char *p, const char *s) {
+
+  while (*s)
+    *p++ = *s++;
+  return p;
+}
+
+static char *append_number(char *p, uint32_t n, unsigned radix) {
+  char buf[12], *q = &buf[sizeof buf];
+
+  do {
+    unsigned d = n % radix;
+    *--q = d < 10 ? '0' + d : 'a' + d - 10;
+    n /= radix;
+  } while (n != 0);
+  while (q < &buf[sizeof buf])
+    *p++ = *q++;
+  return p;
+}
+
+/*
+ * Parses the request header, the header is zero terminated and the lines
+ * terminators are replaced by zeros.
+ */
+static const char *parse_request(char *p, request_t *rp) {
+  char *line, *version;
+
+  memset(rp, 0, sizeof *rp);
+
+  /* Request line.*/
+  line = p;
+  p = strstr(p, "\r\n");
+  *p = '\0';
+  p += 2;
+  if (strncmp(line, "GET ", 4) == 0)
+    rp->path = line + 4;
+  else if (strncmp(line, "HEAD ", 5) == 0) {
+    rp->path = line + 5;
+    rp->head = TRUE;
+  }
+  else
+    return status_405;
+  version = strchr(rp->path, ' ');
+  if ((version == NULL) || (rp->path[0] != '/') ||
+      (strncmp(version + 1, "HTTP/1.", 7) != 0))
+    return status_400;
+  *version = '\0';
+  rp->keepalive = version[8] >= '1';
+  line = strchr(rp->path, '?');
+  if (line != NULL)
+    *line = '\0';
+  if (strstr(rp->path, "..") != NULL)
+    return status_400;
+
+  /* Header fields.*/
+  while (*p != '\0') {
+    char *v;
+
+    line = p;
+    p = strstr(p, "\r\n");
+    *p = '\0';
+    p += 2;
+    if ((v = header_value(line, "connection")) != NULL) {
+      if (strstr(v, "close") != NULL)
+        rp->keepalive = FALSE;
+      else if ((strstr(v, "keep-alive") != NULL) ||
+               (strstr(v, "Keep-Alive") != NULL))
+        rp->keepalive = TRUE;
+    }
+    else if ((v = header_value(line, "accept-encoding")) != NULL)
+      rp->gzip = strstr(v, "gzip") != NULL;
+    else if ((v = header_value(line, "if-none-match")) != NULL) {
+      uint32_t etag = 0;
+
+      if (*v++ == '"') {
+        while (((*v >= '0') && (*v <= '9')) || ((*v >= 'a') && (*v <= 'f')))
+          etag = (etag << 4) + (*v <= '9' ? *v++ - '0' : *v++ - 'a' + 10);
+        rp->etag = etag;
+        rp->hasetag = *v == '"';
+      }
+    }
+    else if ((v = header_value(line, "range")) != NULL) {
+      /* Single ranges only, multiple ranges are ignored and the whole
+         content is sent.*/
+      if ((strncmp(v, "bytes=", 6) == 0) && (strchr(v, ',') == NULL)) {
+        v += 6;
+        if (*v == '-') {
+          rp->suffix = TRUE;
+          rp->range = parse_number(v + 1, &rp->last) != NULL;
+        }
+        else if (((v = parse_number(v, &rp->first)) != NULL) && (*v == '-')) {
+          rp->range = TRUE;
+          if (parse_number(v + 1, &rp->last) == NULL)
+            rp->last = (DWORD)-1;
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Netconn events callback. The send and error events are raised by the
+ * tcpip thread, the acknowledged bytes of the worker serving the
+ * connection are updated from the pcb and the worker is woken. The stack
+ * raises the send events only above the send buffer low water mark, the
+ * last acknowledgment of the written data always raises one.
+ */
+static void httpd_event(struct netconn *conn, enum netconn_evt evt,
+                        u16_t len) {
+  unsigned i;
+
+  (void)len;
+  if ((evt != NETCONN_EVT_SENDPLUS) && (evt != NETCONN_EVT_ERROR))
+    return;
+  for (i = 0; i < HTTPD_THREADS; i++) {
+    worker_t *wp = &workers[i];
+
+    if (wp->tracked == conn) {
+      chSysLock();
+      if (conn->pcb.tcp != NULL)
+        wp->acked = conn->pcb.tcp->lastack - wp->base;
+      chBSemSignalI(&wp->acksem);
+      chSchRescheduleS();
+      chSysUnlock();
+      return;
+    }
+  }
+}
+
+/*
+ * Starts tracking an accepted connection, runs in the tcpip thread. The
+ * Nagle algorithm is disabled so that the responses tail segments are
+ * sent without waiting for the previous segments acknowledgment.
+ */
+static void track_tcp(void *p) {
+  worker_t *wp = p;
+  struct tcp_pcb *pcb = wp->conn->pcb.tcp;
+
+  if (pcb != NULL) {
+    tcp_nagle_disable(pcb);
+    wp->base = pcb->snd_lbb;
+  }
+  wp->tracked = wp->conn;
+}
+
+static void untrack_tcp(void *p) {
+  worker_t *wp = p;
+
+  wp->tracked = NULL;
+}
+
+/*
+ * Sent callback of a connection shut down for transmission, the netconn
+ * layer no longer raises send events after the shutdown.
+ */
+static err_t linger_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+
+  (void)pcb;
+  httpd_event(arg, NETCONN_EVT_SENDPLUS, len);
+  return ERR_OK;
+}
+
+/*
+ * Keeps tracking the acknowledgments after the shutdown, runs in the
+ * tcpip thread. The acknowledgments received before this point are
+ * accounted immediately.
+ */
+static void linger_tcp(void *p) {
+  worker_t *wp = p;
+
+  if (wp->conn->pcb.tcp != NULL)
+    tcp_sent(wp->conn->pcb.tcp, linger_sent);
+  httpd_event(wp->conn, NETCONN_EVT_SENDPLUS, 0);
+}
+
+static void abort_tcp(void *p) {
+  worker_t *wp = p;
+
+  wp->tracked = NULL;
+  if (wp->conn->pcb.tcp != NULL)
+    tcp_abort(wp->conn->pcb.tcp);
+}
+
+/*
+ * Waits for the bytes written up to the specified position to be
+ * acknowledged, returns CH_FAILED on connection errors or timeout.
+ */
+static bool_t wait_acked(worker_t *wp, uint32_t n, systime_t time) {
+  systime_t start = chTimeNow();
+  bool_t err = CH_SUCCESS;
+
+  chSysLock();
+  while (wp->acked < n) {
+    systime_t left = time;
+
+    if (time != TIME_INFINITE) {
+      systime_t elapsed = chTimeNow() - start;
+
+      if (elapsed >= time) {
+        err = CH_FAILED;
+        break;
+      }
+      left = time - elapsed;
+    }
+    if (ERR_IS_FATAL(wp->conn->last_err) ||
+        (chBSemWaitTimeoutS(&wp->acksem, left) == RDY_TIMEOUT)) {
+      err = CH_FAILED;
+      break;
+    }
+  }
+  chSysUnlock();
+  return err;
+}
+
+/*
+ * Waits for a buffer to be released by the TCP stack, a buffer is free
+ * once the bytes written up to the end of its data are acknowledged.
+ */
+static uint8_t *get_buffer(worker_t *wp) {
+  unsigned i = wp->next;
+  uint32_t acked;
+
+  chSysLock();
+  acked = wp->acked;
+  chSysUnlock();
+  if (acked < wp->ends[i]) {
+    STAT_INC(bufwaits, 1);
+    if (wait_acked(wp, wp->ends[i], TIME_INFINITE))
+      return NULL;
+  }
+  wp->next = (i + 1) % HTTPD_BUFFERS;
+  return wp->buffers[i];
+}
+
+static bool_t write_data(worker_t *wp, const void *p, size_t n, u8_t flags) {
+
+  if (netconn_write(wp->conn, p, n, flags) != ERR_OK)
+    return CH_FAILED;
+  wp->written += n;
+  return CH_SUCCESS;
+}
+
+/*
+ * Streams a part of the open file.
+ */
+static bool_t send_file(worker_t *wp, DWORD offset, DWORD n) {
+
+  if (f_lseek(&wp->fil, offset) != FR_OK)
+    return CH_FAILED;
+  while (n > 0) {
+    unsigned i = wp->next;
+    uint8_t *bp = get_buffer(wp);
+    UINT size, br;
+
+    if (bp == NULL)
+      return CH_FAILED;
+
+    /* The first read of an unaligned range ends on a sector boundary so
+       that the following reads are aligned.*/
+    size = n < HTTPD_BUFFER_SIZE ? (UINT)n : HTTPD_BUFFER_SIZE;
+    if ((offset % 512) != 0 && (size > 512 - offset % 512))
+      size = 512 - offset % 512;
+    if ((f_read(&wp->fil, bp, size, &br) != FR_OK) || (br != size))
+      return CH_FAILED;
+    if (write_data(wp, bp, size, NETCONN_NOCOPY))
+      return CH_FAILED;
+    wp->ends[i] = wp->written;
+    STAT_INC(bytes, size);
+    offset += size;
+    n -= size;
+  }
+  return CH_SUCCESS;
+}
+
+/*
+ * Sends a response without content.
+ */
+static bool_t send_status(worker_t *wp, const char *status, bool_t keepalive) {
+  char *p = wp->header;
+
+  STAT_INC(errors, 1);
+  p = append(p, "HTTP/1.1 ");
+  p = append(p, status);
+  p = append(p, "\r\nContent-Length: 0\r\nConnection: ");
+  p = append(p, keepalive ? "keep-alive\r\n\r\n" : "close\r\n\r\n");
+  return write_data(wp, wp->header, p - wp->header, NETCONN_COPY);
+}
+
+/*
+ * Serves a request, returns CH_FAILED if the connection must be closed.
+ * The last request allowed on a connection is answered with a
+ * "Connection: close" header.
+ */
+static bool_t serve_request(worker_t *wp, char *req, bool_t final) {
+  const char *status;
+  request_t r;
+  HTTPDEntry e;
+  DWORD size, first, last;
+  bool_t gzip;
+  char *p;
+
+  status = parse_request(req, &r);
+  if (status != NULL) {
+    send_status(wp, status, FALSE);
+    return CH_FAILED;
+  }
+  if (final)
+    r.keepalive = FALSE;
+
+  /* Lookup in the content index.*/
+  if (strlen(r.path) + strlen(root) + sizeof "index.html.gz" > HTTPD_PATH_SIZE)
+    return send_status(wp, status_404, r.keepalive) || !r.keepalive;
+  p = append(wp->path, root);
+  p = append(p, r.path);
+  if (p[-1] == '/')
+    p = append(p, "index.html");
+  *p = '\0';
+  if (httpdIndexLookup(wp->path + strlen(root), &e) ||
+      (!e.plain && !r.gzip))
+    return send_status(wp, status_404, r.keepalive) || !r.keepalive;
+  gzip = r.gzip && (e.gzsize > 0);
+  size = gzip ? e.gzsize : e.size;
+  if (r.hasetag && (r.etag == e.etag)) {
+    STAT_INC(notmodified, 1);
+    status = status_304;
+    r.head = TRUE;
+  }
+
+  /* Range selection.*/
+  first = 0;
+  last = size - 1;
+  if (r.range && (status == NULL)) {
+    if (r.suffix) {
+      if (r.last > size)
+        r.last = size;
+      r.first = size - r.last;
+      r.last = size - 1;
+    }
+    if (r.last >= size)
+      r.last = size - 1;
+    if ((r.first > r.last) || (r.first >= size)) {
+      p = wp->header;
+      p = append(p, "HTTP/1.1 ");
+      p = append(p, status_416);
+      p = append(p, "\r\nContent-Range: bytes */");
+      p = append_number(p, size, 10);
+      p = append(p, "\r\nContent-Length: 0\r\n\r\n");
+      STAT_INC(errors, 1);
+      return write_data(wp, wp->header, p - wp->header, NETCONN_COPY) ||
+             !r.keepalive;
+    }
+    first = r.first;
+    last = r.last;
+    status = status_206;
+    STAT_INC(ranges, 1);
+  }
+  if (status == NULL)
+    status = status_200;
+
+  /* The file is opened before sending the header so that a failure can
+     still be reported.*/
+  if (!r.head) {
+    if (gzip)
+      strcat(wp->path, ".gz");
+    if (f_open(&wp->fil, wp->path, FA_READ) != FR_OK) {
+      send_status(wp, status_500, FALSE);
+      return CH_FAILED;
+    }
+  }
+  if (gzip)
+    STAT_INC(compressed, 1);
+
+  /* Response header.*/
+  p = wp->header;
+  p = append(p, "HTTP/1.1 ");
+  p = append(p, status);
+  p = append(p, "\r\nServer: ChibiOS/RT\r\nContent-Type: ");
+  p = append(p, e.type);
+  p = append(p, "\r\nAccept-Ranges: bytes\r\nETag: \"");
+  p = append_number(p, e.etag, 16);
+  p = append(p, "\"\r\n");
+  if (e.gzsize > 0)
+    p = append(p, "Vary: Accept-Encoding\r\n");
+  if (gzip)
+    p = append(p, "Content-Encoding: gzip\r\n");
+  if (status == status_206) {
+    p = append(p, "Content-Range: bytes ");
+    p = append_number(p, first, 10);
+    p = append(p, "-");
+    p = append_number(p, last, 10);
+    p = append(p, "/");
+    p = append_number(p, size, 10);
+    p = append(p, "\r\n");
+  }
+  p = append(p, "Content-Length: ");
+  p = append_number(p, status == status_304 ? 0 : last - first + 1, 10);
+  p = append(p, r.keepalive ? "\r\nConnection: keep-alive\r\n\r\n" :
+                              "\r\nConnection: close\r\n\r\n");
+  if (write_data(wp, wp->header, p - wp->header, NETCONN_COPY) ||
+      (!r.head && (size > 0) && send_file(wp, first, last - first + 1))) {
+    if (!r.head)
+      f_close(&wp->fil);
+    return CH_FAILED;
+  }
+  if (!r.head)
+    f_close(&wp->fil);
+  return !r.keepalive;
+}
+
+/*
+ * Receives a complete request header, returns its size including the
+ * terminating empty line or zero on failure.
+ */
+static size_t receive_request(worker_t *wp) {
+  size_t scan = 0;
+
+  while (TRUE) {
+    u16_t n;
+    char *p;
+
+    wp->request[wp->reqlen] = '\0';
+    p = strstr(wp->request + scan, "\r\n\r\n");
+    if (p != NULL) {
+      p[2] = '\0';
+      return p - wp->request + 4;
+    }
+    if (wp->reqlen >= HTTPD_REQUEST_SIZE)
+      return 0;
+    scan = wp->reqlen > 3 ? wp->reqlen - 3 : 0;
+    if (wp->nb == NULL) {
+      if (netconn_recv(wp->conn, &wp->nb) != ERR_OK) {
+        wp->nb = NULL;
+        return 0;
+      }
+      wp->nboff = 0;
+    }
+    n = netbuf_copy_partial(wp->nb, wp->request + wp->reqlen,
+                            HTTPD_REQUEST_SIZE - wp->reqlen, wp->nboff);
+    wp->nboff += n;
+    wp->reqlen += n;
+    if (wp->nboff >= netbuf_len(wp->nb)) {
+      netbuf_delete(wp->nb);
+      wp->nb = NULL;
+    }
+  }
+}
+
+/*
+ * Closes the connection after the transmitted data has been acknowledged,
+ * the connection is aborted if the data is not acknowledged in time. The
+ * tracking ends before the connection is deleted, the tcpip thread
+ * processes the requests in order.
+ */
+static void close_connection(worker_t *wp) {
+
+  if (wp->nb != NULL) {
+    netbuf_delete(wp->nb);
+    wp->nb = NULL;
+  }
+  netconn_shutdown(wp->conn, 0, 1);
+  tcpip_callback(linger_tcp, wp);
+  if (wait_acked(wp, wp->written, MS2ST(HTTPD_LINGER_TIMEOUT)))
+    tcpip_callback(abort_tcp, wp);
+  else {
+    tcpip_callback(untrack_tcp, wp);
+    netconn_close(wp->conn);
+  }
+  netconn_delete(wp->conn);
+}
+
+static msg_t httpd_worker(void *p) {
+  worker_t *wp = p;
+
+  chRegSetThreadName("httpd_worker");
+  while (TRUE) {
+    unsigned n;
+    msg_t msg;
+
+    chMBFetch(&connections, &msg, TIME_INFINITE);
+    wp->conn = (struct netconn *)msg;
+    wp->written = 0;
+    chSysLock();
+    wp->acked = 0;
+    chSysUnlock();
+    memset(wp->ends, 0, sizeof wp->ends);
+    wp->nb = NULL;
+    wp->reqlen = 0;
+#if LWIP_SO_RCVTIMEO
+    netconn_set_recvtimeout(wp->conn, HTTPD_KEEPALIVE_TIMEOUT);
+#endif
+    tcpip_callback(track_tcp, wp);
+    STAT_INC(connections, 1);
+    for (n = 0; n < HTTPD_MAX_REQUESTS; n++) {
+      size_t len = receive_request(wp);
+
+      if (len == 0) {
+        if (wp->reqlen > 0)
+          send_status(wp, status_400, FALSE);
+        break;
+      }
+      STAT_INC(requests, 1);
+      if (n > 0)
+        STAT_INC(reused, 1);
+      if (serve_request(wp, wp->request, n == HTTPD_MAX_REQUESTS - 1))
+        break;
+
+      /* Pipelined requests data.*/
+      wp->reqlen -= len;
+      memmove(wp->request, wp->request + len, wp->reqlen);
+    }
+    close_connection(wp);
+  }
+  return 0;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds the content index.
+ * @details The document root and its subdirectories are scanned, each file
+ *          is added to the index together with its precompressed variant.
+ *          The requests for files not present in the index are answered
+ *          without accessing the file system, the index must be rebuilt
+ *          after changing the content.
+ *
+ * @param[in] path      document root path, an empty string is the root
+ *                      of the default volume
+ * @return              The operation status.
+ * @retval CH_SUCCESS   if the operation succeeded.
+ * @retval CH_FAILED    if the directories could not be read or the index
+ *                      is too small, the files that fit are still indexed.
+ *
+ * @api
+ */
+bool_t httpdIndexBuild(const char *path) {
+  char buf[HTTPD_PATH_SIZE];
+  bool_t err;
+
+  chDbgCheck(path != NULL, "httpdIndexBuild");
+
+  if (strlen(path) >= HTTPD_PATH_SIZE)
+    return CH_FAILED;
+  chMtxLock(&index_mtx);
+  memset(entries, 0, sizeof entries);
+  strcpy(root, path);
+  strcpy(buf, path);
+  err = index_scan(buf, 0);
+  chMtxUnlock();
+  return err;
+}
+
+/**
+ * @brief   Returns a copy of an index entry.
+ *
+ * @param[in] path      path relative to the document root
+ * @param[out] ep       pointer to the entry to be filled
+ * @return              The operation status.
+ * @retval CH_SUCCESS   if the path has been found.
+ * @retval CH_FAILED    if the path is not in the index.
+ *
+ * @api
+ */
+bool_t httpdIndexLookup(const char *path, HTTPDEntry *ep) {
+  HTTPDEntry *p;
+
+  chDbgCheck((path != NULL) && (ep != NULL), "httpdIndexLookup");
+
+  chMtxLock(&index_mtx);
+  p = index_find(path, hash(path));
+  if ((p != NULL) && (p->path[0] != '\0'))
+    *ep = *p;
+  chMtxUnlock();
+  return (p == NULL) || (p->path[0] == '\0') ? CH_FAILED : CH_SUCCESS;
+}
+
+/**
+ * @brief   Returns a snapshot of the server statistics.
+ *
+ * @param[out] sp       pointer to the statistics structure to be filled
+ *
+ * @api
+ */
+void httpdGetStats(HTTPDStats *sp) {
+
+  chSysLock();
+  *sp = stats;
+  chSysUnlock();
+}
+
+/**
+ * @brief   HTTP server thread.
+ * @details The thread accepts the connections and queues them to the
+ *          worker threads.
+ *
+ * @param[in] p         not used
+ * @return              The function does not return.
+ */
+msg_t httpd_server(void *p) {
+  struct netconn *conn, *newconn;
+  unsigned i;
+
+  (void)p;
+  chRegSetThreadName("httpd");
+
+  for (i = 0; i < HTTPD_THREADS; i++) {
+    chBSemInit(&workers[i].acksem, TRUE);
+    chThdCreateStatic(wa_workers[i], sizeof wa_workers[i],
+                      HTTPD_THREAD_PRIORITY, httpd_worker, &workers[i]);
+  }
+
+  /* The accepted connections inherit the events callback.*/
+  conn = netconn_new_with_callback(NETCONN_TCP, httpd_event);
+  LWIP_ERROR("httpd_server: invalid conn", (conn != NULL), return RDY_RESET;);
+  netconn_bind(conn, NULL, HTTPD_PORT);
+  netconn_listen(conn);
+
+  /* Goes to the final priority after initialization.*/
+  chThdSetPriority(HTTPD_THREAD_PRIORITY);
+
+  while (TRUE) {
+    if (netconn_accept(conn, &newconn) != ERR_OK)
+      continue;
+    chMBPost(&connections, (msg_t)newconn, TIME_INFINITE);
+  }
+  return RDY_OK;
+}
+
+#endif /* LWIP_NETCONN */
+
+/** @} */
@@ -0,0 +1,226 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    httpd.h
+ * @brief   HTTP static files server header.
+ *
+ * @addtogroup httpd
+ * @{
+ */
+
+#ifndef _HTTPD_H_
+#define _HTTPD_H_
+
+#include "ff.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Server TCP port.
+ */
+#if !defined(HTTPD_PORT) || defined(__DOXYGEN__)
+#define HTTPD_PORT                  80
+#endif
+
+/**
+ * @brief   Number of worker threads.
+ * @details Each worker thread serves one connection at time, the accepted
+ *          connections exceeding the number of workers are queued.
+ */
+#if !defined(HTTPD_THREADS) || defined(__DOXYGEN__)
+#define HTTPD_THREADS               2
+#endif
+
+/**
+ * @brief   Listener and worker threads stack size.
+ */
+#if !defined(HTTPD_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
+#define HTTPD_THREAD_STACK_SIZE     1024
+#endif
+
+/**
+ * @brief   Listener and worker threads priority.
+ */
+#if !defined(HTTPD_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define HTTPD_THREAD_PRIORITY       (LOWPRIO + 2)
+#endif
+
+/**
+ * @brief   Size of each transmit buffer of a worker.
+ * @note    Must be a multiple of the sector size, whole sectors are
+ *          transferred by FatFs directly from the disk into the buffer.
+ */
+#if !defined(HTTPD_BUFFER_SIZE) || defined(__DOXYGEN__)
+#define HTTPD_BUFFER_SIZE           2048
+#endif
+
+/**
+ * @brief   Number of transmit buffers of a worker.
+ * @details The buffers are passed to the TCP stack by reference and
+ *          reused after the data has been acknowledged, the buffers
+ *          following the oldest one must be able to cover the TCP send
+ *          buffer in order to never wait for acknowledges while streaming.
+ */
+#if !defined(HTTPD_BUFFERS) || defined(__DOXYGEN__)
+#define HTTPD_BUFFERS               4
+#endif
+
+/**
+ * @brief   Maximum size of a request header.
+ */
+#if !defined(HTTPD_REQUEST_SIZE) || defined(__DOXYGEN__)
+#define HTTPD_REQUEST_SIZE          512
+#endif
+
+/**
+ * @brief   Number of entries of the content index.
+ */
+#if !defined(HTTPD_INDEX_SIZE) || defined(__DOXYGEN__)
+#define HTTPD_INDEX_SIZE            32
+#endif
+
+/**
+ * @brief   Maximum length of a path, including the document root.
+ */
+#if !defined(HTTPD_PATH_SIZE) || defined(__DOXYGEN__)
+#define HTTPD_PATH_SIZE             64
+#endif
+
+/**
+ * @brief   Maximum number of requests served on a persistent connection.
+ */
+#if !defined(HTTPD_MAX_REQUESTS) || defined(__DOXYGEN__)
+#define HTTPD_MAX_REQUESTS          100
+#endif
+
+/**
+ * @brief   Idle time, in milliseconds, before closing a persistent
+ *          connection.
+ * @note    Requires @p LWIP_SO_RCVTIMEO, persistent connections are never
+ *          closed by the server if the option is disabled.
+ */
+#if !defined(HTTPD_KEEPALIVE_TIMEOUT) || defined(__DOXYGEN__)
+#define HTTPD_KEEPALIVE_TIMEOUT     5000
+#endif
+
+/**
+ * @brief   Maximum time, in milliseconds, waiting for the transmitted data
+ *          to be acknowledged before closing a connection.
+ * @details The connection is aborted if the data is not acknowledged in
+ *          time, the transmit buffers are not released to the next
+ *          connection while still referenced by the TCP stack.
+ */
+#if !defined(HTTPD_LINGER_TIMEOUT) || defined(__DOXYGEN__)
+#define HTTPD_LINGER_TIMEOUT        2000
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (HTTPD_BUFFER_SIZE % 512) != 0
+#error "HTTPD_BUFFER_SIZE must be a multiple of 512"
+#endif
+
+#if HTTPD_BUFFERS < 2
+#error "HTTPD_BUFFERS must be at least 2"
+#endif
+
+#if (HTTPD_INDEX_SIZE & (HTTPD_INDEX_SIZE - 1)) != 0
+#error "HTTPD_INDEX_SIZE must be a power of two"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Content index entry.
+ * @details Each entry describes a file and its optional precompressed
+ *          variant, a file named as the original with a ".gz" suffix.
+ */
+typedef struct {
+  /** @brief Path relative to the document root, empty if free.*/
+  char                      path[HTTPD_PATH_SIZE];
+  /** @brief Path hash.*/
+  uint32_t                  hash;
+  /** @brief MIME type.*/
+  const char                *type;
+  /** @brief File size or zero if only the compressed file exists.*/
+  DWORD                     size;
+  /** @brief Compressed file size or zero if not present.*/
+  DWORD                     gzsize;
+  /** @brief Entity tag derived from size and modification time.*/
+  uint32_t                  etag;
+  /** @brief The plain file exists.*/
+  bool_t                    plain;
+} HTTPDEntry;
+
+/**
+ * @brief   Server statistics.
+ */
+typedef struct {
+  /** @brief Accepted connections.*/
+  uint32_t                  connections;
+  /** @brief Requests received.*/
+  uint32_t                  requests;
+  /** @brief Requests served on an already used connection.*/
+  uint32_t                  reused;
+  /** @brief Partial content responses.*/
+  uint32_t                  ranges;
+  /** @brief Responses using the precompressed variant.*/
+  uint32_t                  compressed;
+  /** @brief Not modified responses.*/
+  uint32_t                  notmodified;
+  /** @brief Error responses.*/
+  uint32_t                  errors;
+  /** @brief Content bytes passed by reference to the TCP stack.*/
+  uint32_t                  bytes;
+  /** @brief Waits for a transmit buffer to be acknowledged.*/
+  uint32_t                  bufwaits;
+} HTTPDStats;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+extern WORKING_AREA(wa_httpd_server, HTTPD_THREAD_STACK_SIZE);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  bool_t httpdIndexBuild(const char *root);
+  bool_t httpdIndexLookup(const char *path, HTTPDEntry *ep);
+  void httpdGetStats(HTTPDStats *sp);
+  msg_t httpd_server(void *p);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HTTPD_H_ */
+
+/** @} */
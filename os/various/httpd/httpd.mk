@@ -0,0 +1,4 @@
+# HTTP server files.
+HTTPDSRC = ${CHIBIOS}/os/various/httpd/httpd.c
+
+HTTPDINC = ${CHIBIOS}/os/various/httpd
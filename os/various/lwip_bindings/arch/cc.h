@@ -59,14 +59,16 @@ typedef uint16_t        u16_t;
 typedef int16_t         s16_t;
 typedef uint32_t        u32_t;
 typedef int32_t         s32_t;
-typedef uint32_t        mem_ptr_t;
+typedef uintptr_t       mem_ptr_t;
 
 #define LWIP_PLATFORM_DIAG(x)
 #define LWIP_PLATFORM_ASSERT(x) {                                       \
   chSysHalt();                                                          \
 }
 
+#ifndef BYTE_ORDER
 #define BYTE_ORDER LITTLE_ENDIAN
+#endif
 #define LWIP_PROVIDE_ERRNO
 
 #endif /* __CC_H__ */
@@ -60,13 +60,38 @@
 #include "arch/cc.h"
 #include "arch/sys_arch.h"
 
+#if !CH_USE_MEMCORE || !CH_USE_MEMPOOLS || !CH_USE_DYNAMIC
+#error "sys_arch requires CH_USE_MEMCORE, CH_USE_MEMPOOLS and CH_USE_DYNAMIC"
+#endif
+
+/*
+ * Semaphores, mailboxes and threads working areas are allocated from memory
+ * pools, the pools are filled from the core allocator on demand and the
+ * objects are recycled, the memory used is bounded by the peak usage.
+ */
+#define MBOX_OBJECT_SIZE(n)                                                 \
+  MEM_ALIGN_NEXT(sizeof(Mailbox) + sizeof(msg_t) * (n))
+
+#define MBOX_CLASS_SIZE(i)  (SYS_ARCH_MBOX_MIN_SIZE << (i))
+
+static MemoryPool sem_pool;
+static MemoryPool mbox_pools[SYS_ARCH_MBOX_CLASSES];
+static MemoryPool thread_pools[SYS_ARCH_THREAD_CLASSES];
+static Thread *threads[SYS_ARCH_THREADS];
+static SEMAPHORE_DECL(threads_sem, 1);
+
 void sys_init(void) {
+  unsigned i;
 
+  chPoolInit(&sem_pool, MEM_ALIGN_NEXT(sizeof(Semaphore)), chCoreAllocI);
+  for (i = 0; i < SYS_ARCH_MBOX_CLASSES; i++)
+    chPoolInit(&mbox_pools[i], MBOX_OBJECT_SIZE(MBOX_CLASS_SIZE(i)),
+               chCoreAllocI);
 }
 
 err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
 
-  *sem = chHeapAlloc(NULL, sizeof(Semaphore));
+  *sem = chPoolAlloc(&sem_pool);
   if (*sem == 0) {
     SYS_STATS_INC(sem.err);
     return ERR_MEM;
@@ -80,7 +105,7 @@ err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
 
 void sys_sem_free(sys_sem_t *sem) {
 
-  chHeapFree(*sem);
+  chPoolFree(&sem_pool, *sem);
   *sem = SYS_SEM_NULL;
   SYS_STATS_DEC(sem.used);
 }
@@ -122,16 +147,33 @@ void sys_sem_set_invalid(sys_sem_t *sem) {
   *sem = SYS_SEM_NULL;
 }
 
+/*
+ * Returns the index of the smallest mailboxes class able to contain the
+ * specified number of messages or SYS_ARCH_MBOX_CLASSES if too large.
+ */
+static unsigned mbox_class(cnt_t n) {
+  unsigned i;
+
+  for (i = 0; i < SYS_ARCH_MBOX_CLASSES; i++)
+    if (n <= MBOX_CLASS_SIZE(i))
+      break;
+  return i;
+}
+
 err_t sys_mbox_new(sys_mbox_t *mbox, int size) {
-  
-  *mbox = chHeapAlloc(NULL, sizeof(Mailbox) + sizeof(msg_t) * size);
+  unsigned i;
+
+  if (size <= 0)
+    size = SYS_ARCH_MBOX_MIN_SIZE;
+  i = mbox_class((cnt_t)size);
+  *mbox = i < SYS_ARCH_MBOX_CLASSES ? chPoolAlloc(&mbox_pools[i]) : NULL;
   if (*mbox == 0) {
     SYS_STATS_INC(mbox.err);
     return ERR_MEM;
   }
   else {
     chMBInit(*mbox, (void *)(((uint8_t *)*mbox) + sizeof(Mailbox)), size);
-    SYS_STATS_INC(mbox.used);
+    SYS_STATS_INC_USED(mbox);
     return ERR_OK;
   }
 }
@@ -145,7 +187,8 @@ void sys_mbox_free(sys_mbox_t *mbox) {
     SYS_STATS_INC(mbox.err);
     chMBReset(*mbox);
   }
-  chHeapFree(*mbox);
+  chPoolFree(&mbox_pools[mbox_class((cnt_t)((*mbox)->mb_top -
+                                            (*mbox)->mb_buffer))], *mbox);
   *mbox = SYS_MBOX_NULL;
   SYS_STATS_DEC(mbox.used);
 }
@@ -195,18 +238,60 @@ void sys_mbox_set_invalid(sys_mbox_t *mbox) {
   *mbox = SYS_MBOX_NULL;
 }
 
+/*
+ * The working areas of the terminated threads are returned to their pools,
+ * the creation reference is released here because lwIP never waits for
+ * its threads.
+ */
+static void thread_reclaim(void) {
+  unsigned i;
+
+  for (i = 0; i < SYS_ARCH_THREADS; i++) {
+    Thread *tp = NULL;
+
+    chSysLock();
+    if ((threads[i] != NULL) && (threads[i]->p_state == THD_STATE_FINAL)) {
+      tp = threads[i];
+      threads[i] = NULL;
+    }
+    chSysUnlock();
+    if (tp != NULL)
+      chThdRelease(tp);
+  }
+}
+
 sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread,
                             void *arg, int stacksize, int prio) {
-
+  MemoryPool *mp = NULL;
+  Thread *tp = NULL;
   size_t wsz;
-  void *wsp;
+  unsigned i, slot;
 
   (void)name;
   wsz = THD_WA_SIZE(stacksize);
-  wsp = chCoreAlloc(wsz);
-  if (wsp == NULL)
-    return NULL;
-  return (sys_thread_t)chThdCreateStatic(wsp, wsz, prio, (tfunc_t)thread, arg);
+
+  chSemWait(&threads_sem);
+  thread_reclaim();
+  for (slot = 0; slot < SYS_ARCH_THREADS; slot++)
+    if (threads[slot] == NULL)
+      break;
+
+  /* Pool of the working areas of this size, a free pool is taken for the
+     first thread of a new size.*/
+  for (i = 0; i < SYS_ARCH_THREAD_CLASSES; i++) {
+    if (thread_pools[i].mp_object_size == 0)
+      chPoolInit(&thread_pools[i], wsz, chCoreAllocI);
+    if (thread_pools[i].mp_object_size == wsz) {
+      mp = &thread_pools[i];
+      break;
+    }
+  }
+  if ((slot < SYS_ARCH_THREADS) && (mp != NULL)) {
+    tp = chThdCreateFromMemoryPool(mp, prio, (tfunc_t)thread, arg);
+    threads[slot] = tp;
+  }
+  chSemSignal(&threads_sem);
+  return (sys_thread_t)tp;
 }
 
 sys_prot_t sys_arch_protect(void) {
@@ -65,4 +65,27 @@ typedef int             sys_prot_t;
 /* let sys.h use binary semaphores for mutexes */
 #define LWIP_COMPAT_MUTEX 1
 
+/* smallest mailbox size, the mailboxes buffers are allocated in classes
+   of SYS_ARCH_MBOX_MIN_SIZE * 2^n messages */
+#ifndef SYS_ARCH_MBOX_MIN_SIZE
+#define SYS_ARCH_MBOX_MIN_SIZE 4
+#endif
+
+/* number of mailboxes size classes */
+#ifndef SYS_ARCH_MBOX_CLASSES
+#define SYS_ARCH_MBOX_CLASSES 6
+#endif
+
+/* number of different stack sizes for threads created by sys_thread_new() */
+#ifndef SYS_ARCH_THREAD_CLASSES
+#define SYS_ARCH_THREAD_CLASSES 4
+#endif
+
+/* maximum number of threads created by sys_thread_new() and not yet
+   reclaimed, the working area of a terminated thread is reclaimed by the
+   next sys_thread_new() call */
+#ifndef SYS_ARCH_THREADS
+#define SYS_ARCH_THREADS 8
+#endif
+
 #endif /* __SYS_ARCH_H__ */
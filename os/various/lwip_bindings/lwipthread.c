@@ -55,6 +55,8 @@
  * @{
  */
 
+#include <string.h>
+
 #include "ch.h"
 #include "hal.h"
 #include "evtimer.h"
@@ -74,7 +76,8 @@
 #include "netif/ppp_oe.h"
 
 #define PERIODIC_TIMER_ID       1
-#define FRAME_RECEIVED_ID       2
+#define FRAME_RECEIVED_ID(n)    ((eventmask_t)2 << (n))
+#define INPUT_FRAME_ID          1
 
 /**
  * Stack area for the LWIP-MAC thread.
@@ -102,12 +105,15 @@ static void low_level_init(struct netif *netif) {
  * Transmits a frame.
  */
 static err_t low_level_output(struct netif *netif, struct pbuf *p) {
+  LWIPInterface *ifp = netif->state;
   struct pbuf *q;
   MACTransmitDescriptor td;
 
-  (void)netif;
-  if (macWaitTransmitDescriptor(&ETHD1, &td, MS2ST(LWIP_SEND_TIMEOUT)) != RDY_OK)
+  if (macWaitTransmitDescriptor(ifp->config->macp, &td,
+                                MS2ST(LWIP_SEND_TIMEOUT)) != RDY_OK) {
+    ifp->stats.txtimeouts++;
     return ERR_TIMEOUT;
+  }
 
 #if ETH_PAD_SIZE
   pbuf_header(p, -ETH_PAD_SIZE);        /* drop the padding word */
@@ -123,6 +129,7 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p) {
 #endif
 
   LINK_STATS_INC(link.xmit);
+  ifp->stats.txframes++;
 
   return ERR_OK;
 }
@@ -130,13 +137,13 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p) {
 /*
  * Receives a frame.
  */
-static struct pbuf *low_level_input(struct netif *netif) {
+static struct pbuf *low_level_input(LWIPInterface *ifp) {
   MACReceiveDescriptor rd;
   struct pbuf *p, *q;
   u16_t len;
 
-  (void)netif;
-  if (macWaitReceiveDescriptor(&ETHD1, &rd, TIME_IMMEDIATE) == RDY_OK) {
+  if (macWaitReceiveDescriptor(ifp->config->macp, &rd,
+                               TIME_IMMEDIATE) == RDY_OK) {
     len = (u16_t)rd.size;
 
 #if ETH_PAD_SIZE
@@ -167,6 +174,7 @@ static struct pbuf *low_level_input(struct netif *netif) {
       macReleaseReceiveDescriptor(&rd);
       LINK_STATS_INC(link.memerr);
       LINK_STATS_INC(link.drop);
+      ifp->stats.rxnomem++;
     }
     return p;
   }
@@ -189,7 +197,6 @@ static err_t ethernetif_init(struct netif *netif) {
    */
   NETIF_INIT_SNMP(netif, snmp_ifType_ethernet_csmacd, LWIP_LINK_SPEED);
 
-  netif->state = NULL;
   netif->name[0] = LWIP_IFNAME0;
   netif->name[1] = LWIP_IFNAME1;
   /* We directly use etharp_output() here to save a function call.
@@ -205,6 +212,89 @@ static err_t ethernetif_init(struct netif *netif) {
   return ERR_OK;
 }
 
+/*
+ * Receives up to LWIP_RX_BATCH_SIZE frames from an interface and passes
+ * them to the stack, returns the number of frames received.
+ */
+static unsigned ethernetif_input(LWIPInterface *ifp) {
+  struct netif *netif = &ifp->netif;
+  struct pbuf *p;
+  unsigned n = 0;
+
+  while ((n < LWIP_RX_BATCH_SIZE) && ((p = low_level_input(ifp)) != NULL)) {
+    struct eth_hdr *ethhdr = p->payload;
+
+    n++;
+    switch (htons(ethhdr->type)) {
+    /* IP or ARP packet? */
+    case ETHTYPE_IP:
+    case ETHTYPE_ARP:
+#if PPPOE_SUPPORT
+    /* PPPoE packet? */
+    case ETHTYPE_PPPOEDISC:
+    case ETHTYPE_PPPOE:
+#endif /* PPPOE_SUPPORT */
+      /* full packet send to tcpip_thread to process */
+      if (netif->input(p, netif) == ERR_OK) {
+        ifp->stats.rxframes++;
+        break;
+      }
+      LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+      ifp->stats.rxqueuefull++;
+      pbuf_free(p);
+      break;
+    default:
+      pbuf_free(p);
+    }
+  }
+  return n;
+}
+
+/*
+ * Updates the batches statistics of an interface.
+ */
+static void ethernetif_batch(LWIPInterface *ifp, unsigned n) {
+
+  if (n > 0) {
+    ifp->stats.rxbatches++;
+    if (n > ifp->stats.rxbatchmax)
+      ifp->stats.rxbatchmax = n;
+  }
+}
+
+/*
+ * Input thread of an interface, the frames are received in batches, a
+ * full batch is followed by a yield in order to let the input threads
+ * of the other interfaces at the same priority run.
+ */
+static msg_t ethernetif_thread(void *p) {
+  LWIPInterface *ifp = p;
+  EventListener el;
+
+  chRegSetThreadName("lwipinput");
+
+  chEvtRegisterMask(macGetReceiveEventSource(ifp->config->macp), &el,
+                    INPUT_FRAME_ID);
+  chEvtAddEvents(INPUT_FRAME_ID);
+
+  while (TRUE) {
+    unsigned n, total = 0;
+
+    chEvtWaitAny(INPUT_FRAME_ID);
+#if LWIP_RX_MODERATION > 0
+    chThdSleep(LWIP_RX_MODERATION);
+#endif
+    while ((n = ethernetif_input(ifp)) > 0) {
+      total += n;
+      if (n < LWIP_RX_BATCH_SIZE)
+        break;
+      chThdYield();
+    }
+    ethernetif_batch(ifp, total);
+  }
+  return 0;
+}
+
 /**
  * @brief LWIP handling thread.
  *
@@ -212,51 +302,95 @@ static err_t ethernetif_init(struct netif *netif) {
  * @return The function does not return.
  */
 msg_t lwip_thread(void *p) {
+  static LWIPInterfaceConfig ifcfg = {&ETHD1, NULL, NULL, 0, 0};
+  static LWIPInterface thisif;
+  static const LWIPThreadConfig config = {&thisif, 1};
+
+  ifcfg.opts = p;
+  thisif.config = &ifcfg;
+  return lwip_multi_thread((void *)&config);
+}
+
+/**
+ * @brief LWIP handling thread for multiple interfaces.
+ * @details The links status of all the interfaces is polled by this
+ *          thread. The frames are received by the input thread of the
+ *          interface, if configured, or by this thread serving the
+ *          interfaces in turn, up to @p LWIP_RX_BATCH_SIZE frames each,
+ *          so that a burst on an interface does not starve the others.
+ *
+ * @param[in] p pointer to a @p LWIPThreadConfig structure
+ * @return The function does not return.
+ */
+msg_t lwip_multi_thread(void *p) {
+  const LWIPThreadConfig *cfg = p;
   EvTimer evt;
-  EventListener el0, el1;
-  struct ip_addr ip, gateway, netmask;
-  static struct netif thisif;
-  static const MACConfig mac_config = {thisif.hwaddr};
+  EventListener el0;
+  eventmask_t rxmask = 0;
+  unsigned i;
+
+  chDbgCheck((cfg != NULL) && (cfg->n > 0) && (cfg->n <= 31),
+             "lwip_multi_thread");
 
   chRegSetThreadName("lwipthread");
 
   /* Initializes the thing.*/
   tcpip_init(NULL, NULL);
 
-  /* TCP/IP parameters, runtime or compile time.*/
-  if (p) {
-    struct lwipthread_opts *opts = p;
-    unsigned i;
+  for (i = 0; i < cfg->n; i++) {
+    LWIPInterface *ifp = &cfg->interfaces[i];
+    const struct lwipthread_opts *opts = ifp->config->opts;
+    struct ip_addr ip, gateway, netmask;
 
-    for (i = 0; i < 6; i++)
-      thisif.hwaddr[i] = opts->macaddress[i];
-    ip.addr = opts->address;
-    gateway.addr = opts->gateway;
-    netmask.addr = opts->netmask;
-  }
-  else {
-    thisif.hwaddr[0] = LWIP_ETHADDR_0;
-    thisif.hwaddr[1] = LWIP_ETHADDR_1;
-    thisif.hwaddr[2] = LWIP_ETHADDR_2;
-    thisif.hwaddr[3] = LWIP_ETHADDR_3;
-    thisif.hwaddr[4] = LWIP_ETHADDR_4;
-    thisif.hwaddr[5] = LWIP_ETHADDR_5;
-    LWIP_IPADDR(&ip);
-    LWIP_GATEWAY(&gateway);
-    LWIP_NETMASK(&netmask);
-  }
-  macStart(&ETHD1, &mac_config);
-  netif_add(&thisif, &ip, &netmask, &gateway, NULL, ethernetif_init, tcpip_input);
+    /* TCP/IP parameters, runtime or compile time.*/
+    if (opts) {
+      unsigned j;
 
-  netif_set_default(&thisif);
-  netif_set_up(&thisif);
+      for (j = 0; j < 6; j++)
+        ifp->netif.hwaddr[j] = opts->macaddress[j];
+      ip.addr = opts->address;
+      gateway.addr = opts->gateway;
+      netmask.addr = opts->netmask;
+    }
+    else {
+      ifp->netif.hwaddr[0] = LWIP_ETHADDR_0;
+      ifp->netif.hwaddr[1] = LWIP_ETHADDR_1;
+      ifp->netif.hwaddr[2] = LWIP_ETHADDR_2;
+      ifp->netif.hwaddr[3] = LWIP_ETHADDR_3;
+      ifp->netif.hwaddr[4] = LWIP_ETHADDR_4;
+      ifp->netif.hwaddr[5] = LWIP_ETHADDR_5;
+      LWIP_IPADDR(&ip);
+      LWIP_GATEWAY(&gateway);
+      LWIP_NETMASK(&netmask);
+    }
+    memset(&ifp->stats, 0, sizeof (ifp->stats));
+    memset(&ifp->maccfg, 0, sizeof (ifp->maccfg));
+    ifp->maccfg.mac_address = ifp->netif.hwaddr;
+    macStart(ifp->config->macp, &ifp->maccfg);
+    netif_add(&ifp->netif, &ip, &netmask, &gateway, ifp, ethernetif_init,
+              tcpip_input);
+    netif_set_up(&ifp->netif);
+
+    /* Frames reception by a dedicated thread or by this thread.*/
+    if (ifp->config->wa != NULL) {
+      ifp->thread = chThdCreateStatic(ifp->config->wa, ifp->config->wasize,
+                                      ifp->config->prio, ethernetif_thread,
+                                      ifp);
+    }
+    else {
+      ifp->thread = NULL;
+      chEvtRegisterMask(macGetReceiveEventSource(ifp->config->macp), &ifp->el,
+                        FRAME_RECEIVED_ID(i));
+      rxmask |= FRAME_RECEIVED_ID(i);
+    }
+  }
+  netif_set_default(&cfg->interfaces[0].netif);
 
   /* Setup event sources.*/
   evtInit(&evt, LWIP_LINK_POLL_INTERVAL);
   evtStart(&evt);
   chEvtRegisterMask(&evt.et_es, &el0, PERIODIC_TIMER_ID);
-  chEvtRegisterMask(macGetReceiveEventSource(&ETHD1), &el1, FRAME_RECEIVED_ID);
-  chEvtAddEvents(PERIODIC_TIMER_ID | FRAME_RECEIVED_ID);
+  chEvtAddEvents(PERIODIC_TIMER_ID | rxmask);
 
   /* Goes to the final priority after initialization.*/
   chThdSetPriority(LWIP_THREAD_PRIORITY);
@@ -264,40 +398,59 @@ msg_t lwip_thread(void *p) {
   while (TRUE) {
     eventmask_t mask = chEvtWaitAny(ALL_EVENTS);
     if (mask & PERIODIC_TIMER_ID) {
-      bool_t current_link_status = macPollLinkStatus(&ETHD1);
-      if (current_link_status != netif_is_link_up(&thisif)) {
-        if (current_link_status)
-          tcpip_callback_with_block((tcpip_callback_fn) netif_set_link_up,
-                                     &thisif, 0);
-        else
-          tcpip_callback_with_block((tcpip_callback_fn) netif_set_link_down,
-                                     &thisif, 0);
+      for (i = 0; i < cfg->n; i++) {
+        struct netif *netif = &cfg->interfaces[i].netif;
+        bool_t current_link_status =
+            macPollLinkStatus(cfg->interfaces[i].config->macp);
+        if (current_link_status != netif_is_link_up(netif)) {
+          if (current_link_status)
+            tcpip_callback_with_block((tcpip_callback_fn) netif_set_link_up,
+                                       netif, 0);
+          else
+            tcpip_callback_with_block((tcpip_callback_fn) netif_set_link_down,
+                                       netif, 0);
+        }
       }
     }
-    if (mask & FRAME_RECEIVED_ID) {
-      struct pbuf *p;
-      while ((p = low_level_input(&thisif)) != NULL) {
-        struct eth_hdr *ethhdr = p->payload;
-        switch (htons(ethhdr->type)) {
-        /* IP or ARP packet? */
-        case ETHTYPE_IP:
-        case ETHTYPE_ARP:
-#if PPPOE_SUPPORT
-        /* PPPoE packet? */
-        case ETHTYPE_PPPOEDISC:
-        case ETHTYPE_PPPOE:
-#endif /* PPPOE_SUPPORT */
-          /* full packet send to tcpip_thread to process */
-          if (thisif.input(p, &thisif) == ERR_OK)
-            break;
-          LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-        default:
-          pbuf_free(p);
+    mask &= rxmask;
+    if (mask) {
+      for (i = 0; i < cfg->n; i++)
+        cfg->interfaces[i].rxcount = 0;
+
+#if LWIP_RX_MODERATION > 0
+      chThdSleep(LWIP_RX_MODERATION);
+#endif
+      /* Round robin among the interfaces with pending frames, an interface
+         is no more served when it returns less than a full batch.*/
+      while (mask) {
+        for (i = 0; i < cfg->n; i++) {
+          if (mask & FRAME_RECEIVED_ID(i)) {
+            unsigned n = ethernetif_input(&cfg->interfaces[i]);
+            cfg->interfaces[i].rxcount += n;
+            if (n < LWIP_RX_BATCH_SIZE)
+              mask &= ~FRAME_RECEIVED_ID(i);
+          }
         }
       }
+      for (i = 0; i < cfg->n; i++)
+        ethernetif_batch(&cfg->interfaces[i], cfg->interfaces[i].rxcount);
     }
   }
   return 0;
 }
 
+/**
+ * @brief Returns a snapshot of the statistics of an interface.
+ *
+ * @param[in] ifp pointer to the @p LWIPInterface structure
+ * @param[out] sp pointer to the @p LWIPInterfaceStats structure to be
+ *                filled
+ */
+void lwipGetInterfaceStats(LWIPInterface *ifp, LWIPInterfaceStats *sp) {
+
+  chSysLock();
+  *sp = ifp->stats;
+  chSysUnlock();
+}
+
 /** @} */
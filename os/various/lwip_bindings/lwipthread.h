@@ -25,6 +25,7 @@
 #define _LWIPTHREAD_H_
 
 #include <lwip/opt.h>
+#include <lwip/netif.h>
 
 /** @brief MAC thread priority.*/
 #ifndef LWIP_THREAD_PRIORITY
@@ -33,7 +34,7 @@
 
 /** @brief MAC thread stack size. */
 #if !defined(LWIP_THREAD_STACK_SIZE) || defined(__DOXYGEN__)
-#define LWIP_THREAD_STACK_SIZE              512
+#define LWIP_THREAD_STACK_SIZE              1024
 #endif
 
 /** @brief Link poll interval. */
@@ -106,6 +107,18 @@
 #define LWIP_IFNAME1                        's'
 #endif
 
+/** @brief Maximum frames received from an interface before serving the
+    other interfaces. */
+#if !defined(LWIP_RX_BATCH_SIZE) || defined(__DOXYGEN__)
+#define LWIP_RX_BATCH_SIZE                  8
+#endif
+
+/** @brief Delay between a receive event and the frames reception, more
+    frames are collected for each wakeup, zero disables the delay. */
+#if !defined(LWIP_RX_MODERATION) || defined(__DOXYGEN__)
+#define LWIP_RX_MODERATION                  0
+#endif
+
 /**
  * @brief Runtime TCP/IP settings.
  */
@@ -116,12 +129,84 @@ struct lwipthread_opts {
   uint32_t      gateway;
 };
 
+/**
+ * @brief Network interface configuration.
+ */
+typedef struct {
+  /** @brief MAC driver of the interface.*/
+  MACDriver                     *macp;
+  /** @brief Addresses or @p NULL for the compile time settings.*/
+  const struct lwipthread_opts  *opts;
+  /** @brief Input thread working area or @p NULL if the frames are
+      received by the LWIP thread.*/
+  void                          *wa;
+  /** @brief Input thread working area size.*/
+  size_t                        wasize;
+  /** @brief Input thread priority.*/
+  tprio_t                       prio;
+} LWIPInterfaceConfig;
+
+/**
+ * @brief Network interface statistics.
+ */
+typedef struct {
+  /** @brief Frames passed to the stack.*/
+  uint32_t                      rxframes;
+  /** @brief Wakeups that received one or more frames.*/
+  uint32_t                      rxbatches;
+  /** @brief Largest number of frames received for a single wakeup, it is
+      an estimate of the receive queue depth.*/
+  uint32_t                      rxbatchmax;
+  /** @brief Frames dropped because pbufs were not available.*/
+  uint32_t                      rxnomem;
+  /** @brief Frames dropped because the stack input queue was full.*/
+  uint32_t                      rxqueuefull;
+  /** @brief Frames transmitted.*/
+  uint32_t                      txframes;
+  /** @brief Frames dropped because a transmit descriptor was not
+      available within @p LWIP_SEND_TIMEOUT.*/
+  uint32_t                      txtimeouts;
+} LWIPInterfaceStats;
+
+/**
+ * @brief Network interface.
+ */
+typedef struct {
+  /** @brief Interface configuration.*/
+  const LWIPInterfaceConfig     *config;
+  /** @brief lwIP interface.*/
+  struct netif                  netif;
+  /** @brief MAC driver configuration.*/
+  MACConfig                     maccfg;
+  /** @brief Input thread or @p NULL.*/
+  Thread                        *thread;
+  /** @brief Receive event listener of the LWIP thread, used when there
+      is no input thread.*/
+  EventListener                 el;
+  /** @brief Frames received by the LWIP thread in the current wakeup.*/
+  unsigned                      rxcount;
+  /** @brief Interface statistics.*/
+  LWIPInterfaceStats            stats;
+} LWIPInterface;
+
+/**
+ * @brief Multiple interfaces LWIP thread configuration.
+ */
+typedef struct {
+  /** @brief Network interfaces, the first one is the default interface.*/
+  LWIPInterface                 *interfaces;
+  /** @brief Number of network interfaces.*/
+  unsigned                      n;
+} LWIPThreadConfig;
+
 extern WORKING_AREA(wa_lwip_thread, LWIP_THREAD_STACK_SIZE);
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   msg_t lwip_thread(void *p);
+  msg_t lwip_multi_thread(void *p);
+  void lwipGetInterfaceStats(LWIPInterface *ifp, LWIPInterfaceStats *sp);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,360 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    usb_composite.c
+ * @brief   USB composite device layer code.
+ * @details The layer owns the @p USBConfig of the USB driver. Descriptor
+ *          requests are served from the configuration tables, the class
+ *          and vendor requests are routed to the function owning the
+ *          addressed interface or endpoint through lookup tables built on
+ *          start and the function endpoints are enabled on
+ *          SET_CONFIGURATION.
+ *
+ * @addtogroup usb_composite
+ * @{
+ */
+
+#include <stddef.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "usb_composite.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Composite driver owning an USB driver.
+ * @details The USB driver is operating on the configuration embedded in
+ *          the composite driver object.
+ */
+#define owner(usbp)                                                         \
+  ((USBCompositeDriver *)((uint8_t *)(usbp)->config -                       \
+                          offsetof(USBCompositeDriver, usbconfig)))
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Alternate setting, only the setting zero is supported by
+ *          default.
+ */
+static const uint8_t zero_alternate = 0;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+#if CH_DBG_ENABLE_ASSERTS || defined(__DOXYGEN__)
+/**
+ * @brief   Verifies the configuration descriptor against the functions.
+ * @details Each interface and endpoint descriptor must belong to the
+ *          function owning the interface or endpoint number.
+ *
+ * @param[in] ucdp      pointer to the @p USBCompositeDriver object
+ * @return              The verification result.
+ * @retval TRUE         The descriptor matches the functions.
+ * @retval FALSE        The descriptor does not match the functions.
+ */
+static bool_t check_descriptor(USBCompositeDriver *ucdp) {
+  const USBDescriptor *dp = ucdp->config->configuration_descriptor;
+  const USBCompositeFunction *fp = NULL;
+  const uint8_t *p = dp->ud_string;
+  unsigned i, ninterfaces = 0;
+  usbep_t ep;
+
+  for (i = 0; i < ucdp->config->num_functions; i++)
+    ninterfaces += ucdp->config->functions[i].num_interfaces;
+  if ((dp->ud_size < USB_COMPOSITE_CONFIGURATION_DESC_SIZE) ||
+      (p[1] != USB_DESCRIPTOR_CONFIGURATION) ||
+      ((size_t)usbFetchWord(&p[2]) != dp->ud_size) ||
+      (p[4] != ninterfaces))
+    return FALSE;
+
+  for (i = p[0]; i < dp->ud_size; i += p[i]) {
+    if ((p[i] < 2) || (i + p[i] > dp->ud_size))
+      return FALSE;
+    switch (p[i + 1]) {
+    case USB_DESCRIPTOR_INTERFACE:
+      if (p[i + 2] >= USB_COMPOSITE_MAX_INTERFACES)
+        return FALSE;
+      fp = ucdp->interfaces[p[i + 2]];
+      if (fp == NULL)
+        return FALSE;
+      break;
+    case USB_DESCRIPTOR_ENDPOINT:
+      ep = p[i + 2] & 0x0F;
+      if ((fp == NULL) || (ep == 0) || (ep > USB_MAX_ENDPOINTS) ||
+          (ucdp->endpoints[ep - 1] != fp))
+        return FALSE;
+      break;
+    default:
+      break;
+    }
+  }
+  return TRUE;
+}
+#endif /* CH_DBG_ENABLE_ASSERTS */
+
+/**
+ * @brief   Handles the GET_DESCRIPTOR callback.
+ */
+static const USBDescriptor *get_descriptor(USBDriver *usbp, uint8_t dtype,
+                                           uint8_t dindex, uint16_t lang) {
+  const USBCompositeConfig *config = owner(usbp)->config;
+
+  (void)lang;
+  switch (dtype) {
+  case USB_DESCRIPTOR_DEVICE:
+    return config->device_descriptor;
+  case USB_DESCRIPTOR_CONFIGURATION:
+    if (dindex == 0)
+      return config->configuration_descriptor;
+    break;
+  case USB_DESCRIPTOR_STRING:
+    if (dindex < config->num_strings)
+      return &config->strings[dindex];
+    break;
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Standard interface requests of functions without alternate
+ *          settings.
+ */
+static bool_t interface_handler(USBDriver *usbp) {
+
+  if ((usbp->setup[0] & USB_RTYPE_TYPE_MASK) != USB_RTYPE_TYPE_STD)
+    return FALSE;
+  switch (usbp->setup[1]) {
+  case USB_REQ_GET_INTERFACE:
+    usbSetupTransfer(usbp, (uint8_t *)&zero_alternate, 1, NULL);
+    return TRUE;
+  case USB_REQ_SET_INTERFACE:
+    if (usbFetchWord(&usbp->setup[2]) != 0)
+      return FALSE;
+    usbSetupTransfer(usbp, NULL, 0, NULL);
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/**
+ * @brief   Dispatches the setup requests to the functions.
+ */
+static bool_t requests_hook(USBDriver *usbp) {
+  USBCompositeDriver *ucdp = owner(usbp);
+  const USBCompositeFunction *fp = NULL;
+  uint8_t index = usbp->setup[4];
+
+  switch (usbp->setup[0] & USB_RTYPE_RECIPIENT_MASK) {
+  case USB_RTYPE_RECIPIENT_INTERFACE:
+    if (index < USB_COMPOSITE_MAX_INTERFACES)
+      fp = ucdp->interfaces[index];
+    if (fp != NULL) {
+      if ((fp->requests_hook_cb != NULL) && fp->requests_hook_cb(usbp))
+        return TRUE;
+      return interface_handler(usbp);
+    }
+    break;
+  case USB_RTYPE_RECIPIENT_ENDPOINT:
+    /* Standard endpoint requests are left to the default handler.*/
+    index &= 0x0F;
+    if (((usbp->setup[0] & USB_RTYPE_TYPE_MASK) != USB_RTYPE_TYPE_STD) &&
+        (index > 0) && (index <= USB_MAX_ENDPOINTS))
+      fp = ucdp->endpoints[index - 1];
+    if (fp != NULL)
+      return (fp->requests_hook_cb != NULL) && fp->requests_hook_cb(usbp);
+    break;
+  default:
+    break;
+  }
+
+  if (ucdp->config->requests_hook_cb != NULL)
+    return ucdp->config->requests_hook_cb(usbp);
+  return FALSE;
+}
+
+/**
+ * @brief   Handles the USB driver global events.
+ */
+static void usb_event(USBDriver *usbp, usbevent_t event) {
+  const USBCompositeConfig *config = owner(usbp)->config;
+  const USBCompositeFunction *fp;
+  unsigned i, j;
+
+  chSysLockFromIsr();
+  if (event == USB_EVENT_CONFIGURED) {
+    if (usbp->state == USB_ACTIVE) {
+      /* Endpoints already enabled by a previous SET_CONFIGURATION are
+         left in their current state.*/
+      for (i = 0; i < config->num_functions; i++) {
+        fp = &config->functions[i];
+        for (j = 0; j < fp->num_endpoints; j++)
+          if (usbp->epc[fp->endpoints[j].ep] == NULL)
+            usbInitEndpointI(usbp, fp->endpoints[j].ep,
+                             fp->endpoints[j].epcp);
+      }
+    }
+    else
+      usbDisableEndpointsI(usbp);
+  }
+  for (i = 0; i < config->num_functions; i++) {
+    fp = &config->functions[i];
+    if (fp->event_cb != NULL)
+      fp->event_cb(usbp, event, fp->arg);
+  }
+  chSysUnlockFromIsr();
+
+  if (config->event_cb != NULL)
+    config->event_cb(usbp, event);
+}
+
+/**
+ * @brief   Start Of Frame callback.
+ */
+static void sof_handler(USBDriver *usbp) {
+
+  owner(usbp)->config->sof_cb(usbp);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a generic composite driver object.
+ *
+ * @param[out] ucdp     pointer to the @p USBCompositeDriver object
+ *
+ * @init
+ */
+void ucdObjectInit(USBCompositeDriver *ucdp) {
+
+  ucdp->state  = UCD_STOP;
+  ucdp->config = NULL;
+  ucdp->usbconfig.event_cb          = usb_event;
+  ucdp->usbconfig.get_descriptor_cb = get_descriptor;
+  ucdp->usbconfig.requests_hook_cb  = requests_hook;
+  ucdp->usbconfig.sof_cb            = NULL;
+}
+
+/**
+ * @brief   Configures and starts the composite device.
+ * @details The interfaces and endpoints lookup tables are built from the
+ *          functions and the USB driver is started, the application then
+ *          connects the device to the bus.
+ * @note    Each interface and endpoint must belong to a single function.
+ *
+ * @param[in] ucdp      pointer to the @p USBCompositeDriver object
+ * @param[in] config    the composite device configuration
+ *
+ * @api
+ */
+void ucdStart(USBCompositeDriver *ucdp, const USBCompositeConfig *config) {
+  const USBCompositeFunction *fp;
+  unsigned i, j;
+
+  chDbgCheck((ucdp != NULL) && (config != NULL) && (config->usbp != NULL) &&
+             (config->device_descriptor != NULL) &&
+             (config->configuration_descriptor != NULL) &&
+             ((config->functions != NULL) || (config->num_functions == 0)),
+             "ucdStart");
+  chDbgAssert(ucdp->state == UCD_STOP, "ucdStart(), #1", "invalid state");
+
+  ucdp->config = config;
+  ucdp->usbconfig.sof_cb = config->sof_cb != NULL ? sof_handler : NULL;
+  for (i = 0; i < USB_COMPOSITE_MAX_INTERFACES; i++)
+    ucdp->interfaces[i] = NULL;
+  for (i = 0; i < USB_MAX_ENDPOINTS; i++)
+    ucdp->endpoints[i] = NULL;
+
+  for (i = 0; i < config->num_functions; i++) {
+    fp = &config->functions[i];
+    chDbgAssert(fp->first_interface + fp->num_interfaces <=
+                USB_COMPOSITE_MAX_INTERFACES,
+                "ucdStart(), #2", "interface out of range");
+    for (j = fp->first_interface;
+         j < (unsigned)(fp->first_interface + fp->num_interfaces); j++) {
+      chDbgAssert(ucdp->interfaces[j] == NULL,
+                  "ucdStart(), #3", "interface already owned");
+      ucdp->interfaces[j] = fp;
+    }
+    for (j = 0; j < fp->num_endpoints; j++) {
+      usbep_t ep = fp->endpoints[j].ep;
+
+      chDbgAssert((ep > 0) && (ep <= USB_MAX_ENDPOINTS) &&
+                  (fp->endpoints[j].epcp != NULL),
+                  "ucdStart(), #4", "invalid endpoint");
+      chDbgAssert(ucdp->endpoints[ep - 1] == NULL,
+                  "ucdStart(), #5", "endpoint already owned");
+      ucdp->endpoints[ep - 1] = fp;
+    }
+  }
+#if CH_DBG_ENABLE_ASSERTS
+  chDbgAssert(check_descriptor(ucdp),
+              "ucdStart(), #6", "descriptor not matching the functions");
+#endif
+
+  ucdp->state = UCD_READY;
+  usbStart(config->usbp, &ucdp->usbconfig);
+}
+
+/**
+ * @brief   Stops the composite device.
+ * @details The USB driver is stopped.
+ *
+ * @param[in] ucdp      pointer to the @p USBCompositeDriver object
+ *
+ * @api
+ */
+void ucdStop(USBCompositeDriver *ucdp) {
+
+  chDbgCheck(ucdp != NULL, "ucdStop");
+  chDbgAssert((ucdp->state == UCD_STOP) || (ucdp->state == UCD_READY),
+              "ucdStop(), #1", "invalid state");
+
+  if (ucdp->state == UCD_READY)
+    usbStop(ucdp->config->usbp);
+  ucdp->state = UCD_STOP;
+}
+
+#if HAL_USE_SERIAL_USB || defined(__DOXYGEN__)
+/**
+ * @brief   Events callback of a Serial over USB function.
+ * @details The Serial over USB driver is reset when the device is
+ *          configured, the function argument is the @p SerialUSBDriver
+ *          object and the requests hook is @p sduRequestsHook().
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] event     event type
+ * @param[in] arg       pointer to the @p SerialUSBDriver object
+ *
+ * @iclass
+ */
+void ucdSerialUSBEventHookI(USBDriver *usbp, usbevent_t event, void *arg) {
+
+  if ((event == USB_EVENT_CONFIGURED) && (usbp->state == USB_ACTIVE))
+    sduConfigureHookI((SerialUSBDriver *)arg);
+}
+#endif /* HAL_USE_SERIAL_USB */
+
+/** @} */
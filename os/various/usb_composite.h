@@ -0,0 +1,303 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    usb_composite.h
+ * @brief   USB composite device layer header.
+ *
+ * @addtogroup usb_composite
+ * @{
+ */
+
+#ifndef _USB_COMPOSITE_H_
+#define _USB_COMPOSITE_H_
+
+/*
+ * Module dependencies check.
+ */
+#if !HAL_USE_USB
+#error "USB composite devices require HAL_USE_USB"
+#endif
+
+/**
+ * @brief   Maximum number of interfaces in the configuration.
+ */
+#if !defined(USB_COMPOSITE_MAX_INTERFACES) || defined(__DOXYGEN__)
+#define USB_COMPOSITE_MAX_INTERFACES        8
+#endif
+
+/**
+ * @name    Descriptors sizes
+ * @{
+ */
+#define USB_COMPOSITE_CONFIGURATION_DESC_SIZE   9
+#define USB_COMPOSITE_CDC_ACM_DESC_SIZE         66
+#define USB_COMPOSITE_BULK_DESC_SIZE            23
+/** @} */
+
+/**
+ * @brief   Device Descriptor of a composite device.
+ * @details The device class is the Interface Association Descriptor one,
+ *          each function is described by its own interfaces.
+ */
+#define USB_COMPOSITE_DEVICE_DESC(bcdUSB, bMaxPacketSize, idVendor,         \
+                                  idProduct, bcdDevice, iManufacturer,      \
+                                  iProduct, iSerialNumber)                  \
+  USB_DESC_DEVICE(bcdUSB, 0xEF, 0x02, 0x01, bMaxPacketSize, idVendor,       \
+                  idProduct, bcdDevice, iManufacturer, iProduct,            \
+                  iSerialNumber, 1)
+
+/**
+ * @brief   Configuration Descriptor header of a composite device.
+ * @note    The @p wTotalLength field must be the header size plus the
+ *          size of all the function descriptors following it.
+ */
+#define USB_COMPOSITE_CONFIGURATION_DESC(wTotalLength, bNumInterfaces,      \
+                                         bmAttributes, bMaxPower)           \
+  USB_DESC_CONFIGURATION(wTotalLength, bNumInterfaces, 1, 0,                \
+                         bmAttributes, bMaxPower)
+
+/**
+ * @brief   Descriptors of a CDC ACM function.
+ * @details An Interface Association Descriptor groups the communication
+ *          interface @p first and the data interface <tt>first + 1</tt>.
+ *          The size is @p USB_COMPOSITE_CDC_ACM_DESC_SIZE.
+ *
+ * @param[in] first     number of the communication interface
+ * @param[in] int_ep    interrupt IN endpoint number
+ * @param[in] int_size  interrupt endpoint maximum packet size
+ * @param[in] interval  interrupt endpoint polling interval
+ * @param[in] in_ep     bulk IN endpoint number
+ * @param[in] out_ep    bulk OUT endpoint number
+ * @param[in] size      bulk endpoints maximum packet size
+ * @param[in] iFunction index of the function string descriptor
+ */
+#define USB_COMPOSITE_CDC_ACM_DESC(first, int_ep, int_size, interval,       \
+                                   in_ep, out_ep, size, iFunction)          \
+  USB_DESC_INTERFACE_ASSOCIATION((first), 2, 0x02, 0x02, 0x01, iFunction), \
+  USB_DESC_INTERFACE((first), 0, 1, 0x02, 0x02, 0x01, 0),                   \
+  /* Header Functional Descriptor (CDC section 5.2.3).*/                    \
+  USB_DESC_BYTE(5), USB_DESC_BYTE(0x24), USB_DESC_BYTE(0x00),               \
+  USB_DESC_BCD(0x0110),                                                     \
+  /* Call Management Functional Descriptor.*/                               \
+  USB_DESC_BYTE(5), USB_DESC_BYTE(0x24), USB_DESC_BYTE(0x01),               \
+  USB_DESC_BYTE(0x00), USB_DESC_BYTE((first) + 1),                          \
+  /* ACM Functional Descriptor.*/                                           \
+  USB_DESC_BYTE(4), USB_DESC_BYTE(0x24), USB_DESC_BYTE(0x02),               \
+  USB_DESC_BYTE(0x02),                                                      \
+  /* Union Functional Descriptor.*/                                         \
+  USB_DESC_BYTE(5), USB_DESC_BYTE(0x24), USB_DESC_BYTE(0x06),               \
+  USB_DESC_BYTE(first), USB_DESC_BYTE((first) + 1),                         \
+  USB_DESC_ENDPOINT((int_ep) | 0x80, 0x03, int_size, interval),             \
+  USB_DESC_INTERFACE((first) + 1, 0, 2, 0x0A, 0x00, 0x00, 0),               \
+  USB_DESC_ENDPOINT(out_ep, 0x02, size, 0),                                 \
+  USB_DESC_ENDPOINT((in_ep) | 0x80, 0x02, size, 0)
+
+/**
+ * @brief   Descriptors of an interface with a bulk endpoints pair.
+ * @details The size is @p USB_COMPOSITE_BULK_DESC_SIZE.
+ *
+ * @param[in] bInterfaceNumber      number of the interface
+ * @param[in] bInterfaceClass       interface class
+ * @param[in] bInterfaceSubClass    interface subclass
+ * @param[in] bInterfaceProtocol    interface protocol
+ * @param[in] in_ep     bulk IN endpoint number
+ * @param[in] out_ep    bulk OUT endpoint number
+ * @param[in] size      bulk endpoints maximum packet size
+ * @param[in] iInterface            index of the interface string descriptor
+ */
+#define USB_COMPOSITE_BULK_DESC(bInterfaceNumber, bInterfaceClass,          \
+                                bInterfaceSubClass, bInterfaceProtocol,     \
+                                in_ep, out_ep, size, iInterface)            \
+  USB_DESC_INTERFACE(bInterfaceNumber, 0, 2, bInterfaceClass,               \
+                     bInterfaceSubClass, bInterfaceProtocol, iInterface),   \
+  USB_DESC_ENDPOINT((in_ep) | 0x80, 0x02, size, 0),                         \
+  USB_DESC_ENDPOINT(out_ep, 0x02, size, 0)
+
+/**
+ * @brief   Descriptors of a Mass Storage Bulk-Only function.
+ * @details The size is @p USB_COMPOSITE_BULK_DESC_SIZE.
+ */
+#define USB_COMPOSITE_MSC_DESC(bInterfaceNumber, in_ep, out_ep, size,       \
+                               iInterface)                                  \
+  USB_COMPOSITE_BULK_DESC(bInterfaceNumber, 0x08, 0x06, 0x50,               \
+                          in_ep, out_ep, size, iInterface)
+
+/**
+ * @brief   Composite driver state machine possible states.
+ */
+typedef enum {
+  UCD_UNINIT = 0,                   /**< Not initialized.                   */
+  UCD_STOP = 1,                     /**< Stopped.                           */
+  UCD_READY = 2                     /**< Ready.                             */
+} ucdstate_t;
+
+/**
+ * @brief   Type of a function event callback.
+ * @details The callback is invoked from the USB interrupt handler with the
+ *          kernel locked, only I-class functions can be used. The
+ *          endpoints of the function are already enabled when the
+ *          @p USB_EVENT_CONFIGURED event is notified.
+ *
+ * @param[in] usbp      pointer to the @p USBDriver object
+ * @param[in] event     event type
+ * @param[in] arg       function argument
+ */
+typedef void (*ucdeventcb_t)(USBDriver *usbp, usbevent_t event, void *arg);
+
+/**
+ * @brief   Endpoint of a function.
+ */
+typedef struct {
+  /**
+   * @brief Endpoint number.
+   */
+  usbep_t                   ep;
+  /**
+   * @brief Endpoint configuration, enabled on SET_CONFIGURATION.
+   */
+  const USBEndpointConfig   *epcp;
+} USBCompositeEndpoint;
+
+/**
+ * @brief   Function of a composite device.
+ * @details A function owns a range of interfaces and a set of endpoints,
+ *          the class and vendor requests addressed to them are dispatched
+ *          to the function requests hook.
+ */
+typedef struct {
+  /**
+   * @brief First interface of the function.
+   */
+  uint8_t                   first_interface;
+  /**
+   * @brief Number of interfaces of the function.
+   */
+  uint8_t                   num_interfaces;
+  /**
+   * @brief Number of endpoints of the function.
+   */
+  uint8_t                   num_endpoints;
+  /**
+   * @brief Endpoints of the function.
+   */
+  const USBCompositeEndpoint *endpoints;
+  /**
+   * @brief Requests hook, can be @p NULL.
+   * @details Standard requests addressed to the function interfaces are
+   *          also passed to the hook before the default handling.
+   */
+  usbreqhandler_t           requests_hook_cb;
+  /**
+   * @brief Events callback, can be @p NULL.
+   */
+  ucdeventcb_t              event_cb;
+  /**
+   * @brief Argument of the events callback.
+   */
+  void                      *arg;
+} USBCompositeFunction;
+
+/**
+ * @brief   Composite driver configuration structure.
+ */
+typedef struct {
+  /**
+   * @brief USB driver to use.
+   */
+  USBDriver                 *usbp;
+  /**
+   * @brief Device descriptor.
+   */
+  const USBDescriptor       *device_descriptor;
+  /**
+   * @brief Configuration descriptor.
+   */
+  const USBDescriptor       *configuration_descriptor;
+  /**
+   * @brief String descriptors.
+   */
+  const USBDescriptor       *strings;
+  /**
+   * @brief Number of string descriptors.
+   */
+  uint8_t                   num_strings;
+  /**
+   * @brief Number of functions.
+   */
+  uint8_t                   num_functions;
+  /**
+   * @brief Functions of the device.
+   */
+  const USBCompositeFunction *functions;
+  /**
+   * @brief Requests hook for requests not addressed to a function, can
+   *        be @p NULL.
+   */
+  usbreqhandler_t           requests_hook_cb;
+  /**
+   * @brief Application events callback, invoked after the functions ones,
+   *        can be @p NULL.
+   */
+  usbeventcb_t              event_cb;
+  /**
+   * @brief Start Of Frame callback, can be @p NULL.
+   */
+  usbcallback_t             sof_cb;
+} USBCompositeConfig;
+
+/**
+ * @brief   Structure representing a composite device driver.
+ */
+typedef struct {
+  /**
+   * @brief Driver state.
+   */
+  ucdstate_t                state;
+  /**
+   * @brief Current configuration data.
+   */
+  const USBCompositeConfig  *config;
+  /**
+   * @brief Configuration passed to the USB driver.
+   */
+  USBConfig                 usbconfig;
+  /**
+   * @brief Owner function of each interface.
+   */
+  const USBCompositeFunction *interfaces[USB_COMPOSITE_MAX_INTERFACES];
+  /**
+   * @brief Owner function of each endpoint, the base index is one.
+   */
+  const USBCompositeFunction *endpoints[USB_MAX_ENDPOINTS];
+} USBCompositeDriver;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void ucdObjectInit(USBCompositeDriver *ucdp);
+  void ucdStart(USBCompositeDriver *ucdp, const USBCompositeConfig *config);
+  void ucdStop(USBCompositeDriver *ucdp);
+#if HAL_USE_SERIAL_USB
+  void ucdSerialUSBEventHookI(USBDriver *usbp, usbevent_t event, void *arg);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _USB_COMPOSITE_H_ */
+
+/** @} */
@@ -0,0 +1,357 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    bmkcoop.cpp
+ * @brief   Cooperative tasks benchmark.
+ * @details Compares stackless cooperative tasks hosted in a single thread
+ *          against real threads. The RAM needed by an activity is
+ *          reported for both, the switch cost is measured with two
+ *          activities yielding to each other and the wakeup cost with two
+ *          activities exchanging semaphore signals. Each measurement is
+ *          executed @p BMK_COOP_ROUNDS times, the best round is reported.
+ *          The tasks waits on timeouts, events, queues and semaphores are
+ *          verified while another task keeps running in the same host
+ *          thread.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include "ch.hpp"
+#include "hal.h"
+#include "chprintf.h"
+#include "chcoop.hpp"
+#include "bmkcoop.hpp"
+
+#if !HAL_IMPLEMENTS_COUNTERS
+#error "the cooperative tasks benchmark requires the HAL realtime counters"
+#endif
+
+#if !CH_USE_WAITOBJECTS
+#error "the cooperative tasks benchmark requires CH_USE_WAITOBJECTS"
+#endif
+
+#define BMK_PRIO            (NORMALPRIO + 1)
+
+static WORKING_AREA(wa1, BMK_COOP_STACK);
+static WORKING_AREA(wa2, BMK_COOP_STACK);
+
+static chibios_rt::CoopThread<BMK_COOP_STACK> host;
+
+static Semaphore sem1, sem2;
+
+/*===========================================================================*/
+/* Threads.                                                                  */
+/*===========================================================================*/
+
+static msg_t yield_thread(void *arg) {
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < BMK_COOP_SWITCHES / 2; i++)
+    chThdYield();
+  return 0;
+}
+
+static msg_t ping_thread(void *arg) {
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < BMK_COOP_SWITCHES / 2; i++) {
+    chSemSignal(&sem1);
+    chSemWait(&sem2);
+  }
+  return 0;
+}
+
+static msg_t pong_thread(void *arg) {
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < BMK_COOP_SWITCHES / 2; i++) {
+    chSemWait(&sem1);
+    chSemSignal(&sem2);
+  }
+  return 0;
+}
+
+/*===========================================================================*/
+/* Cooperative tasks.                                                        */
+/*===========================================================================*/
+
+class YieldTask : public chibios_rt::CoopTask<YieldTask> {
+private:
+  unsigned n;
+
+public:
+  msg_t main(void) {
+
+    coopBegin(&task);
+    for (n = 0; n < BMK_COOP_SWITCHES / 2; n++)
+      coopYield(&task);
+    coopEnd(&task);
+  }
+};
+
+class PingTask : public chibios_rt::CoopTask<PingTask> {
+private:
+  unsigned n;
+
+public:
+  msg_t main(void) {
+
+    coopBegin(&task);
+    for (n = 0; n < BMK_COOP_SWITCHES / 2; n++) {
+      chSemSignal(&sem1);
+      coopWaitSemaphoreTimeout(&task, &sem2, TIME_INFINITE);
+    }
+    coopEnd(&task);
+  }
+};
+
+class PongTask : public chibios_rt::CoopTask<PongTask> {
+private:
+  unsigned n;
+
+public:
+  msg_t main(void) {
+
+    coopBegin(&task);
+    for (n = 0; n < BMK_COOP_SWITCHES / 2; n++) {
+      coopWaitSemaphoreTimeout(&task, &sem1, TIME_INFINITE);
+      chSemSignal(&sem2);
+    }
+    coopEnd(&task);
+  }
+};
+
+static YieldTask yield1, yield2;
+static PingTask ping;
+static PongTask pong;
+
+/*===========================================================================*/
+/* Verification.                                                             */
+/*===========================================================================*/
+
+static uint8_t vq_buffer[4];
+static INPUTQUEUE_DECL(vq, vq_buffer, sizeof vq_buffer, NULL, NULL);
+static SEMAPHORE_DECL(vsem, 0);
+
+class VerifyTask : public chibios_rt::CoopTask<VerifyTask> {
+private:
+  systime_t time;
+
+public:
+  bool ok;
+  bool done;
+
+  msg_t main(void) {
+
+    coopBegin(&task);
+    ok = true;
+    done = false;
+
+    /* Sleep.*/
+    time = chTimeNow();
+    coopSleep(&task, MS2ST(10));
+    ok = ok && (chTimeNow() - time >= MS2ST(10));
+
+    /* Event signaled by the helper thread, then an events timeout.*/
+    coopWaitEventsTimeout(&task, EVENT_MASK(0), MS2ST(500));
+    ok = ok && (getEvents() == EVENT_MASK(0));
+    coopWaitEventsTimeout(&task, EVENT_MASK(1), MS2ST(5));
+    ok = ok && (getEvents() == 0);
+
+    /* Data put in the queue by the helper thread.*/
+    coopWaitInputQueueTimeout(&task, &vq, MS2ST(500));
+    ok = ok && (getMsg() == RDY_OK) &&
+         (chIQGetTimeout(&vq, TIME_IMMEDIATE) == 0x55);
+
+    /* Semaphore signaled by the helper thread, then a semaphore timeout.*/
+    coopWaitSemaphoreTimeout(&task, &vsem, MS2ST(500));
+    ok = ok && (getMsg() == RDY_OK) && (chSemGetCounterI(&vsem) == 0);
+    coopWaitSemaphoreTimeout(&task, &vsem, MS2ST(5));
+    ok = ok && (getMsg() == RDY_TIMEOUT);
+
+    done = true;
+    coopEnd(&task);
+  }
+};
+
+static VerifyTask verify;
+
+/*
+ * Runs while the verification task waits, it proves that the waits do not
+ * block the host thread.
+ */
+class TickTask : public chibios_rt::CoopTask<TickTask> {
+public:
+  unsigned ticks;
+
+  msg_t main(void) {
+
+    coopBegin(&task);
+    ticks = 0;
+    while (!verify.done) {
+      ticks++;
+      coopSleep(&task, MS2ST(1));
+    }
+    coopEnd(&task);
+  }
+};
+
+static TickTask tick;
+
+static msg_t helper_thread(void *arg) {
+
+  chThdSleepMilliseconds(20);
+  chEvtSignal((Thread *)arg, EVENT_MASK(0));
+  chThdSleepMilliseconds(20);
+  chSysLock();
+  chIQPutI(&vq, 0x55);
+  chSchRescheduleS();
+  chSysUnlock();
+  chThdSleepMilliseconds(20);
+  chSemSignal(&vsem);
+  return 0;
+}
+
+static bool verify_tasks(void) {
+  Thread *tp;
+
+  verify.start(host.scheduler);
+  tick.start(host.scheduler);
+  host.start(BMK_PRIO);
+  tp = chThdCreateStatic(wa1, sizeof wa1, BMK_PRIO + 1, helper_thread,
+                         host.thread_ref);
+  chThdWait(tp);
+  host.wait();
+
+  return verify.isTerminated() && tick.isTerminated() &&
+         verify.ok && (tick.ticks >= 20);
+}
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+static halrtcnt_t run_threads(tfunc_t f1, tfunc_t f2) {
+  Thread *tp1, *tp2;
+  halrtcnt_t start;
+
+  start = halGetCounterValue();
+  chSysLock();
+  tp1 = chThdCreateI(wa1, sizeof wa1, BMK_PRIO, f1, NULL);
+  tp2 = chThdCreateI(wa2, sizeof wa2, BMK_PRIO, f2, NULL);
+  chSchReadyI(tp1);
+  chSchReadyI(tp2);
+  chSchRescheduleS();
+  chSysUnlock();
+  chThdWait(tp1);
+  chThdWait(tp2);
+  return halGetCounterValue() - start;
+}
+
+static halrtcnt_t run_host(void) {
+  halrtcnt_t start;
+
+  start = halGetCounterValue();
+  host.start(BMK_PRIO);
+  host.wait();
+  return halGetCounterValue() - start;
+}
+
+static void print_centi(BaseSequentialStream *chp, const char *name,
+                        halrtcnt_t best) {
+  unsigned long centi = (unsigned long)best * 100UL / BMK_COOP_SWITCHES;
+
+  chprintf(chp, "%-40s: %lu.%02lu ticks/switch\r\n", name,
+           centi / 100UL, centi % 100UL);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Executes the cooperative tasks benchmark.
+ *
+ * @param[in] chp       stream where the report is printed
+ * @return              The verification result.
+ * @retval false        if the tasks misbehaved.
+ * @retval true         if all the verifications passed.
+ */
+bool bmkCoopExecute(BaseSequentialStream *chp) {
+  halrtcnt_t elapsed, best_tyield, best_cyield, best_tsem, best_csem;
+  unsigned round;
+  bool result;
+
+  chprintf(chp, "*** Cooperative tasks benchmark, %u switches, "
+                "best of %u rounds\r\n",
+           (unsigned)BMK_COOP_SWITCHES, (unsigned)BMK_COOP_ROUNDS);
+
+  best_tyield = best_cyield = best_tsem = best_csem = (halrtcnt_t)-1;
+  for (round = 0; round <= BMK_COOP_ROUNDS; round++) {
+    elapsed = run_threads(yield_thread, yield_thread);
+    if ((round > 0) && (elapsed < best_tyield))
+      best_tyield = elapsed;
+
+    yield1.start(host.scheduler);
+    yield2.start(host.scheduler);
+    elapsed = run_host();
+    if ((round > 0) && (elapsed < best_cyield))
+      best_cyield = elapsed;
+
+    chSemInit(&sem1, 0);
+    chSemInit(&sem2, 0);
+    elapsed = run_threads(ping_thread, pong_thread);
+    if ((round > 0) && (elapsed < best_tsem))
+      best_tsem = elapsed;
+
+    chSemInit(&sem1, 0);
+    chSemInit(&sem2, 0);
+    ping.start(host.scheduler);
+    pong.start(host.scheduler);
+    elapsed = run_host();
+    if ((round > 0) && (elapsed < best_csem))
+      best_csem = elapsed;
+  }
+
+  result = yield1.isTerminated() && yield2.isTerminated() &&
+           ping.isTerminated() && pong.isTerminated();
+  result = verify_tasks() && result;
+
+  chprintf(chp, "%-40s: %u bytes\r\n", "RAM per task, CoopTask structure",
+           (unsigned)sizeof (::CoopTask));
+  chprintf(chp, "%-40s: %u bytes\r\n", "RAM per thread, working area",
+           (unsigned)sizeof wa1);
+  chprintf(chp, "%-40s: %u\r\n", "Activities",
+           (unsigned)BMK_COOP_ACTIVITIES);
+  chprintf(chp, "%-40s: %u bytes\r\n", "RAM for all activities, tasks + host",
+           (unsigned)(BMK_COOP_ACTIVITIES * sizeof (::CoopTask) +
+                      sizeof host));
+  chprintf(chp, "%-40s: %u bytes\r\n", "RAM for all activities, threads",
+           (unsigned)(BMK_COOP_ACTIVITIES * sizeof wa1));
+  print_centi(chp, "Yield, threads", best_tyield);
+  print_centi(chp, "Yield, tasks", best_cyield);
+  print_centi(chp, "Semaphore ping-pong, threads", best_tsem);
+  print_centi(chp, "Semaphore ping-pong, tasks", best_csem);
+  chprintf(chp, "%-40s: %s\r\n", "Verification", result ? "OK" : "FAILED");
+  return result;
+}
+
+/** @} */
@@ -0,0 +1,62 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    bmkcoop.hpp
+ * @brief   Cooperative tasks benchmark header.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#ifndef _BMKCOOP_HPP_
+#define _BMKCOOP_HPP_
+
+#include "ch.hpp"
+
+/**
+ * @brief   Stack size of the benchmark threads and of the host thread.
+ */
+#if !defined(BMK_COOP_STACK) || defined(__DOXYGEN__)
+#define BMK_COOP_STACK                  256
+#endif
+
+/**
+ * @brief   Number of activities in the RAM comparison.
+ */
+#if !defined(BMK_COOP_ACTIVITIES) || defined(__DOXYGEN__)
+#define BMK_COOP_ACTIVITIES             64
+#endif
+
+/**
+ * @brief   Number of switches in each benchmark round.
+ */
+#if !defined(BMK_COOP_SWITCHES) || defined(__DOXYGEN__)
+#define BMK_COOP_SWITCHES               256
+#endif
+
+/**
+ * @brief   Number of rounds for each measurement.
+ */
+#if !defined(BMK_COOP_ROUNDS) || defined(__DOXYGEN__)
+#define BMK_COOP_ROUNDS                 16
+#endif
+
+bool bmkCoopExecute(BaseSequentialStream *chp);
+
+#endif /* _BMKCOOP_HPP_ */
+
+/** @} */
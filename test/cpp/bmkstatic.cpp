@@ -0,0 +1,291 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    bmkstatic.cpp
+ * @brief   C++ static system description benchmark.
+ * @details Compares a set of kernel objects and threads built with the
+ *          @p ch.hpp constructors against the same set described by
+ *          @p chstatic.hpp. The constructors are executed again through
+ *          placement new in order to measure the startup time they cost,
+ *          the statically described objects have no startup cost. The RAM
+ *          used by both sets and the flash used by the threads table are
+ *          reported, the behavior of the static objects is verified.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include <new>
+
+#include "ch.hpp"
+#include "hal.h"
+#include "chprintf.h"
+#include "chstatic.hpp"
+#include "bmkstatic.hpp"
+
+#if !HAL_IMPLEMENTS_COUNTERS
+#error "the static description benchmark requires the HAL realtime counters"
+#endif
+
+#define WORKERS_PRIO        (LOWPRIO + 1)
+
+typedef struct {
+  uint32_t          a;
+  uint32_t          b;
+  uint8_t           c;
+} object_t;
+
+/*===========================================================================*/
+/* Objects constructed at runtime.                                           */
+/*===========================================================================*/
+
+static volatile unsigned runtime_runs;
+
+class Worker : public chibios_rt::BaseStaticThread<BMK_STATIC_STACK> {
+protected:
+  virtual msg_t main(void) {
+
+    runtime_runs++;
+    return 0;
+  }
+};
+
+class RuntimeObjects {
+public:
+  chibios_rt::CounterSemaphore sem1, sem2, sem3, sem4;
+  chibios_rt::BinarySemaphore bsem;
+  chibios_rt::Mutex mtx1, mtx2;
+  chibios_rt::CondVar cond;
+  chibios_rt::EvtSource evt;
+  chibios_rt::MailboxBuffer<16> mb1, mb2;
+  chibios_rt::ObjectsPool<object_t, 16> pool;
+  chibios_rt::InQueueBuffer<64> iq;
+  chibios_rt::OutQueueBuffer<64> oq;
+
+  RuntimeObjects(void) : sem1(0), sem2(0), sem3(0), sem4(0), bsem(false),
+                         iq(NULL, NULL), oq(NULL, NULL) {
+  }
+};
+
+static stkalign_t runtime_storage[(sizeof (RuntimeObjects) +
+                                   sizeof (stkalign_t) - 1) /
+                                  sizeof (stkalign_t)];
+
+static Worker workers[4];
+
+/*===========================================================================*/
+/* Static system description.                                                */
+/*===========================================================================*/
+
+static STATIC_SEMAPHORE_DECL(sem1, 0);
+static STATIC_SEMAPHORE_DECL(sem2, 0);
+static STATIC_SEMAPHORE_DECL(sem3, 0);
+static STATIC_SEMAPHORE_DECL(sem4, 1);
+static STATIC_BSEMAPHORE_DECL(bsem, false);
+static STATIC_MUTEX_DECL(mtx1);
+static STATIC_MUTEX_DECL(mtx2);
+static STATIC_CONDVAR_DECL(cond);
+static STATIC_EVTSOURCE_DECL(evt);
+static STATIC_MAILBOX_DECL(mb1, 16);
+static STATIC_MAILBOX_DECL(mb2, 16);
+static STATIC_OBJECTSPOOL_DECL(pool, object_t, 16);
+static STATIC_INQUEUE_DECL(iq, 64, NULL, NULL);
+static STATIC_OUTQUEUE_DECL(oq, 64, NULL, NULL);
+
+static const size_t static_objects_size = sizeof sem1 + sizeof sem2 +
+                                          sizeof sem3 + sizeof sem4 +
+                                          sizeof bsem + sizeof mtx1 +
+                                          sizeof mtx2 + sizeof cond +
+                                          sizeof evt + sizeof mb1 +
+                                          sizeof mb2 + sizeof pool +
+                                          sizeof iq + sizeof oq;
+
+static volatile unsigned static_runs;
+static tprio_t static_prios[4];
+
+static msg_t static_worker(void *arg) {
+
+  static_prios[(size_t)arg] = chThdGetPriority();
+  static_runs++;
+  return 0;
+}
+
+static chibios_static::ThreadArea<BMK_STATIC_STACK, WORKERS_PRIO> wa1, wa2,
+                                                                  wa3, wa4;
+
+static const chibios_static::ThreadDescriptor threads[] = {
+  STATIC_THREAD(wa1, static_worker, (void *)0, "worker1"),
+  STATIC_THREAD(wa2, static_worker, (void *)1, "worker2"),
+  STATIC_THREAD(wa3, static_worker, (void *)2, "worker3"),
+  STATIC_THREAD(wa4, static_worker, (void *)3, "worker4")
+};
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+/*
+ * Lets the workers run to completion by temporarily lowering the priority
+ * of the benchmark thread below them.
+ */
+static void run_workers(void) {
+  tprio_t prio = chThdSetPriority(LOWPRIO);
+
+  chThdSetPriority(prio);
+}
+
+static bool verify_objects(void) {
+  bool ok = true;
+  msg_t msg;
+  object_t *objs[17];
+  unsigned i;
+
+  /* Semaphores.*/
+  ok = ok && (sem1.waitTimeout(TIME_IMMEDIATE) == RDY_TIMEOUT);
+  ok = ok && (sem4.waitTimeout(TIME_IMMEDIATE) == RDY_OK);
+  sem4.signal();
+  ok = ok && (bsem.wait() == RDY_OK) && bsem.getStateI();
+  bsem.signal();
+  ok = ok && !bsem.getStateI();
+
+  /* Mutexes.*/
+  ok = ok && mtx1.tryLock();
+  ok = ok && mtx2.tryLock();
+  chibios_static::Mutex::unlock();
+  chibios_static::Mutex::unlock();
+  ok = ok && (mtx1.mutex.m_owner == NULL) && (mtx2.mutex.m_owner == NULL);
+
+  /* Condition variable and event source, nothing waiting.*/
+  cond.broadcast();
+  evt.broadcastFlags(1);
+
+  /* Mailboxes.*/
+  for (i = 0; i < 16; i++)
+    ok = ok && (mb1.post((msg_t)i, TIME_IMMEDIATE) == RDY_OK);
+  ok = ok && (mb1.post(16, TIME_IMMEDIATE) == RDY_TIMEOUT);
+  for (i = 0; i < 16; i++)
+    ok = ok && (mb1.fetch(&msg, TIME_IMMEDIATE) == RDY_OK) &&
+         (msg == (msg_t)i);
+  ok = ok && (mb2.fetch(&msg, TIME_IMMEDIATE) == RDY_TIMEOUT);
+
+  /* Pool, the buffer is handed out once then the free list is used.*/
+  objs[0] = pool.alloc();
+  objs[1] = pool.alloc();
+  pool.free(objs[0]);
+  ok = ok && (pool.alloc() == objs[0]);
+  for (i = 2; i < 17; i++)
+    objs[i] = pool.alloc();
+  ok = ok && (objs[16] == NULL);
+  for (i = 1; i < 16; i++)
+    ok = ok && ((uint8_t *)objs[i] - (uint8_t *)objs[i - 1] ==
+                (ptrdiff_t)pool.OBJSIZE);
+  for (i = 0; i < 16; i++)
+    pool.free(objs[i]);
+  ok = ok && (pool.alloc() == objs[15]);
+  pool.free(objs[15]);
+
+  /* Queues.*/
+  chSysLock();
+  ok = ok && (iq.putI(0x55) == Q_OK);
+  chSysUnlock();
+  ok = ok && (iq.getTimeout(TIME_IMMEDIATE) == 0x55);
+  ok = ok && (oq.putTimeout(0xAA, TIME_IMMEDIATE) == Q_OK);
+  chSysLock();
+  ok = ok && (oq.getI() == 0xAA) && (oq.getI() == Q_EMPTY);
+  chSysUnlock();
+
+  return ok;
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Executes the static system description benchmark.
+ *
+ * @param[in] chp       stream where the report is printed
+ * @return              The verification result.
+ * @retval false        if the static objects or threads misbehaved.
+ * @retval true         if all the verifications passed.
+ */
+bool bmkStaticExecute(BaseSequentialStream *chp) {
+  halrtcnt_t start, elapsed, best_ctor, best_start, best_table;
+  unsigned round, i;
+  bool result;
+
+  chprintf(chp, "*** C++ static description benchmark, best of %u rounds\r\n",
+           (unsigned)BMK_STATIC_ROUNDS);
+
+  /* The static objects are verified before anything else touches them.*/
+  result = verify_objects();
+
+  best_ctor = best_start = best_table = (halrtcnt_t)-1;
+  for (round = 0; round <= BMK_STATIC_ROUNDS; round++) {
+    /* Startup work of the constructors.*/
+    start = halGetCounterValue();
+    new (runtime_storage) RuntimeObjects();
+    elapsed = halGetCounterValue() - start;
+    if ((round > 0) && (elapsed < best_ctor))
+      best_ctor = elapsed;
+
+    /* Threads started one by one.*/
+    start = halGetCounterValue();
+    for (i = 0; i < 4; i++)
+      workers[i].start(WORKERS_PRIO);
+    elapsed = halGetCounterValue() - start;
+    if ((round > 0) && (elapsed < best_start))
+      best_start = elapsed;
+    run_workers();
+
+    /* Threads started from the descriptors table.*/
+    start = halGetCounterValue();
+    chibios_static::System::start(threads);
+    elapsed = halGetCounterValue() - start;
+    if ((round > 0) && (elapsed < best_table))
+      best_table = elapsed;
+    run_workers();
+  }
+
+  result = result && (runtime_runs == 4 * (BMK_STATIC_ROUNDS + 1)) &&
+                     (static_runs == 4 * (BMK_STATIC_ROUNDS + 1));
+  for (i = 0; i < 4; i++)
+    result = result && (static_prios[i] == WORKERS_PRIO);
+
+  chprintf(chp, "%-40s: %lu ticks\r\n", "Objects init, ch.hpp constructors",
+           (unsigned long)best_ctor);
+  chprintf(chp, "%-40s: 0 ticks\r\n", "Objects init, static description");
+  chprintf(chp, "%-40s: %lu ticks\r\n", "4 threads, BaseStaticThread::start()",
+           (unsigned long)best_start);
+  chprintf(chp, "%-40s: %lu ticks\r\n", "4 threads, System::start()",
+           (unsigned long)best_table);
+  chprintf(chp, "%-40s: %u bytes\r\n", "Objects RAM, ch.hpp classes",
+           (unsigned)sizeof (RuntimeObjects));
+  chprintf(chp, "%-40s: %u bytes\r\n", "Objects RAM, static description",
+           (unsigned)static_objects_size);
+  chprintf(chp, "%-40s: %u bytes\r\n", "Threads RAM, BaseStaticThread",
+           (unsigned)sizeof workers);
+  chprintf(chp, "%-40s: %u bytes\r\n", "Threads RAM, ThreadArea",
+           (unsigned)(sizeof wa1 + sizeof wa2 + sizeof wa3 + sizeof wa4));
+  chprintf(chp, "%-40s: %u bytes\r\n", "Threads table, flash",
+           (unsigned)sizeof threads);
+  chprintf(chp, "%-40s: %s\r\n", "Verification", result ? "OK" : "FAILED");
+  return result;
+}
+
+/** @} */
@@ -0,0 +1,49 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    bmkstatic.hpp
+ * @brief   C++ static system description benchmark header.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#ifndef _BMKSTATIC_HPP_
+#define _BMKSTATIC_HPP_
+
+#include "ch.hpp"
+
+/**
+ * @brief   Stack size of the benchmark worker threads.
+ */
+#if !defined(BMK_STATIC_STACK) || defined(__DOXYGEN__)
+#define BMK_STATIC_STACK                512
+#endif
+
+/**
+ * @brief   Number of rounds for each measurement.
+ */
+#if !defined(BMK_STATIC_ROUNDS) || defined(__DOXYGEN__)
+#define BMK_STATIC_ROUNDS               64
+#endif
+
+bool bmkStaticExecute(BaseSequentialStream *chp);
+
+#endif /* _BMKSTATIC_HPP_ */
+
+/** @} */
@@ -0,0 +1,356 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    bmkstreams.cpp
+ * @brief   C++ streams and queues benchmark.
+ * @details Compares the per-byte and bulk transfer costs of the out of line
+ *          queue wrappers and of the virtual stream interface against the
+ *          statically dispatched classes in @p chstreams.hpp. Each case is
+ *          executed @p BMK_STREAMS_ROUNDS times, the best round is reported
+ *          in realtime counter ticks per byte. The transferred data is
+ *          verified after each round.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.hpp"
+#include "hal.h"
+#include "chprintf.h"
+#include "chstreams.hpp"
+#include "bmkstreams.hpp"
+
+#if !HAL_IMPLEMENTS_COUNTERS
+#error "the streams benchmark requires the HAL realtime counters"
+#endif
+
+using namespace chibios_rt;
+
+#define SIZE                BMK_STREAMS_SIZE
+
+/*
+ * Virtual stream over the queue wrappers, the shape of the classes
+ * currently implementing BaseSequentialStreamInterface.
+ */
+class VirtualQueueStream : public BaseSequentialStreamInterface {
+public:
+  InQueueBuffer<SIZE> iqueue;
+  OutQueueBuffer<SIZE> oqueue;
+
+  VirtualQueueStream(void) : iqueue(NULL, NULL), oqueue(NULL, NULL) {
+  }
+
+  virtual size_t write(const uint8_t *bp, size_t n) {
+
+    return oqueue.writeTimeout(bp, n, TIME_INFINITE);
+  }
+
+  virtual size_t read(uint8_t *bp, size_t n) {
+
+    return iqueue.readTimeout(bp, n, TIME_INFINITE);
+  }
+
+  virtual msg_t put(uint8_t b) {
+
+    return oqueue.put(b);
+  }
+
+  virtual msg_t get(void) {
+
+    return iqueue.get();
+  }
+};
+
+typedef struct {
+  const char        *name;
+  void              (*prepare)(void);
+  void              (*execute)(void);
+  bool              (*verify)(void);
+} bmkcase_t;
+
+static uint8_t pattern[SIZE];
+static uint8_t sink[SIZE];
+
+static InQueueBuffer<SIZE> iqb(NULL, NULL);
+static OutQueueBuffer<SIZE> oqb(NULL, NULL);
+static VirtualQueueStream vqs;
+
+static StaticInQueue<SIZE> siq(NULL, NULL);
+static StaticOutQueue<SIZE> soq(NULL, NULL);
+static QueueStream<SIZE, SIZE> qs(NULL, NULL, NULL);
+static Fifo<uint8_t, SIZE> fifo;
+
+/* Accessed through a volatile pointer so that the compiler cannot resolve
+   the virtual calls statically.*/
+static BaseSequentialStreamInterface * volatile vstream = &vqs;
+
+/*===========================================================================*/
+/* Helpers.                                                                  */
+/*===========================================================================*/
+
+static void nothing(void) {
+}
+
+static void clear(void) {
+
+  memset(sink, 0, SIZE);
+}
+
+static bool compare(void) {
+
+  return memcmp(sink, pattern, SIZE) == 0;
+}
+
+template <class Q>
+static void fill(Q &q) {
+  unsigned i;
+
+  clear();
+  chSysLock();
+  for (i = 0; i < SIZE; i++)
+    (void)q.putI(pattern[i]);
+  chSysUnlock();
+}
+
+template <class Q>
+static bool drain(Q &q) {
+  unsigned i;
+  bool empty;
+
+  chSysLock();
+  for (i = 0; i < SIZE; i++) {
+    msg_t msg = q.getI();
+    if (msg < Q_OK)
+      break;
+    sink[i] = (uint8_t)msg;
+  }
+  empty = q.getI() == Q_EMPTY;
+  chSysUnlock();
+  return (i == SIZE) && empty && compare();
+}
+
+template <class S>
+static void put_bytes(SequentialStream<S> &s) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    s.put(pattern[i]);
+}
+
+/*===========================================================================*/
+/* Benchmark cases.                                                          */
+/*===========================================================================*/
+
+static void oqb_put(void) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    oqb.put(pattern[i]);
+}
+
+static void soq_put(void) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    soq.put(pattern[i]);
+}
+
+static void iqb_prepare(void) {
+
+  fill(iqb);
+}
+
+static void iqb_get(void) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    sink[i] = (uint8_t)iqb.get();
+}
+
+static void siq_prepare(void) {
+
+  fill(siq);
+}
+
+static void siq_get(void) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    sink[i] = (uint8_t)siq.get();
+}
+
+static void oqb_write(void) {
+
+  (void)oqb.writeTimeout(pattern, SIZE, TIME_INFINITE);
+}
+
+static void soq_write(void) {
+
+  (void)soq.writeTimeout(pattern, SIZE, TIME_INFINITE);
+}
+
+static void iqb_read(void) {
+
+  (void)iqb.readTimeout(sink, SIZE, TIME_INFINITE);
+}
+
+static void siq_read(void) {
+
+  (void)siq.readTimeout(sink, SIZE, TIME_INFINITE);
+}
+
+static bool oqb_check(void) {
+
+  return drain(oqb);
+}
+
+static bool soq_check(void) {
+
+  return drain(soq);
+}
+
+static void vqs_put(void) {
+  BaseSequentialStreamInterface *s = vstream;
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    s->put(pattern[i]);
+}
+
+static void qs_put(void) {
+
+  put_bytes(qs);
+}
+
+static void vqs_write(void) {
+
+  (void)vstream->write(pattern, SIZE);
+}
+
+static void qs_write(void) {
+
+  (void)qs.write(pattern, SIZE);
+}
+
+static bool vqs_check(void) {
+
+  return drain(vqs.oqueue);
+}
+
+static bool qs_check(void) {
+
+  return drain(qs.oqueue);
+}
+
+static void fifo_prepare(void) {
+
+  fifo.reset();
+  clear();
+}
+
+static void fifo_put(void) {
+  unsigned i;
+
+  for (i = 0; i < SIZE; i++)
+    (void)fifo.put(pattern[i]);
+}
+
+static void fifo_write(void) {
+
+  (void)fifo.write(pattern, SIZE);
+}
+
+static bool fifo_check(void) {
+
+  return fifo.isFull() && (fifo.read(sink, SIZE) == SIZE) &&
+         fifo.isEmpty() && compare();
+}
+
+static const bmkcase_t cases[] = {
+  {"OutQueueBuffer::put()", nothing, oqb_put, oqb_check},
+  {"StaticOutQueue::put()", nothing, soq_put, soq_check},
+  {"InQueueBuffer::get()", iqb_prepare, iqb_get, compare},
+  {"StaticInQueue::get()", siq_prepare, siq_get, compare},
+  {"OutQueueBuffer::writeTimeout()", nothing, oqb_write, oqb_check},
+  {"StaticOutQueue::writeTimeout()", nothing, soq_write, soq_check},
+  {"InQueueBuffer::readTimeout()", iqb_prepare, iqb_read, compare},
+  {"StaticInQueue::readTimeout()", siq_prepare, siq_read, compare},
+  {"BaseSequentialStreamInterface::put()", nothing, vqs_put, vqs_check},
+  {"SequentialStream<S>::put()", nothing, qs_put, qs_check},
+  {"BaseSequentialStreamInterface::write()", nothing, vqs_write, vqs_check},
+  {"SequentialStream<S>::write()", nothing, qs_write, qs_check},
+  {"Fifo<uint8_t, N>::put()", fifo_prepare, fifo_put, fifo_check},
+  {"Fifo<uint8_t, N>::write()", fifo_prepare, fifo_write, fifo_check}
+};
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Executes the streams benchmark.
+ * @note    The benchmark does not yield, it should be invoked from a
+ *          thread with a priority not lower than the other activities in
+ *          order to obtain stable figures.
+ *
+ * @param[in] chp       stream where the report is printed
+ * @return              The verification result.
+ * @retval false        if the transferred data was corrupted.
+ * @retval true         if all the cases passed the verification.
+ */
+bool bmkStreamsExecute(BaseSequentialStream *chp) {
+  unsigned i, round;
+  bool result = true;
+
+  for (i = 0; i < SIZE; i++)
+    pattern[i] = (uint8_t)(i * 7 + 1);
+
+  chprintf(chp, "*** C++ streams benchmark, %u bytes, best of %u rounds\r\n",
+           (unsigned)SIZE, (unsigned)BMK_STREAMS_ROUNDS);
+  chprintf(chp, "*** Counter frequency: %lu Hz\r\n",
+           (unsigned long)halGetCounterFrequency());
+  for (i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+    halrtcnt_t best = (halrtcnt_t)-1;
+    bool ok = true;
+    unsigned long centi;
+
+    /* The first round warms up the caches and is not measured.*/
+    for (round = 0; round <= BMK_STREAMS_ROUNDS; round++) {
+      halrtcnt_t start, elapsed;
+
+      cases[i].prepare();
+      start = halGetCounterValue();
+      cases[i].execute();
+      elapsed = halGetCounterValue() - start;
+      if ((round > 0) && (elapsed < best))
+        best = elapsed;
+      if (!cases[i].verify())
+        ok = false;
+    }
+
+    centi = (unsigned long)best * 100UL / SIZE;
+    chprintf(chp, "%-40s: %lu.%02lu ticks/byte%s\r\n", cases[i].name,
+             centi / 100UL, centi % 100UL, ok ? "" : " (FAILED)");
+    result = result && ok;
+  }
+  return result;
+}
+
+/** @} */
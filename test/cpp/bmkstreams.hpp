@@ -0,0 +1,50 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+/**
+ * @file    bmkstreams.hpp
+ * @brief   C++ streams and queues benchmark header.
+ *
+ * @addtogroup cpp_library
+ * @{
+ */
+
+#ifndef _BMKSTREAMS_HPP_
+#define _BMKSTREAMS_HPP_
+
+#include "ch.hpp"
+
+/**
+ * @brief   Number of bytes moved in each benchmark round.
+ * @note    It is also the size of the benchmarked queues.
+ */
+#if !defined(BMK_STREAMS_SIZE) || defined(__DOXYGEN__)
+#define BMK_STREAMS_SIZE                256
+#endif
+
+/**
+ * @brief   Number of rounds for each measurement.
+ */
+#if !defined(BMK_STREAMS_ROUNDS) || defined(__DOXYGEN__)
+#define BMK_STREAMS_ROUNDS              64
+#endif
+
+bool bmkStreamsExecute(BaseSequentialStream *chp);
+
+#endif /* _BMKSTREAMS_HPP_ */
+
+/** @} */
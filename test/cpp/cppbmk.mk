@@ -0,0 +1,7 @@
+# List of the C++ wrappers benchmark files.
+CPPBMKSRC = ${CHIBIOS}/test/cpp/bmkstreams.cpp \
+            ${CHIBIOS}/test/cpp/bmkstatic.cpp \
+            ${CHIBIOS}/test/cpp/bmkcoop.cpp
+
+# Required include directories
+CPPBMKINC = ${CHIBIOS}/test/cpp
@@ -29,13 +29,16 @@
 #include "testthd.h"
 #include "testsem.h"
 #include "testmtx.h"
+#include "testrwlock.h"
 #include "testmsg.h"
 #include "testmbox.h"
+#include "testfifo.h"
 #include "testevt.h"
 #include "testheap.h"
 #include "testpools.h"
 #include "testdyn.h"
 #include "testqueues.h"
+#include "testwo.h"
 #include "testbmk.h"
 
 /*
@@ -45,13 +48,16 @@ static ROMCONST struct testcase * ROMCONST *patterns[] = {
   patternthd,
   patternsem,
   patternmtx,
+  patternrwlock,
   patternmsg,
   patternmbox,
+  patternfifo,
   patternevt,
   patternheap,
   patternpools,
   patterndyn,
   patternqueues,
+  patternwo,
   patternbmk,
   NULL
 };
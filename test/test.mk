@@ -3,13 +3,16 @@ TESTSRC = ${CHIBIOS}/test/test.c \
           ${CHIBIOS}/test/testthd.c \
           ${CHIBIOS}/test/testsem.c \
           ${CHIBIOS}/test/testmtx.c \
+          ${CHIBIOS}/test/testrwlock.c \
           ${CHIBIOS}/test/testmsg.c \
           ${CHIBIOS}/test/testmbox.c \
+          ${CHIBIOS}/test/testfifo.c \
           ${CHIBIOS}/test/testevt.c \
           ${CHIBIOS}/test/testheap.c \
           ${CHIBIOS}/test/testpools.c \
           ${CHIBIOS}/test/testdyn.c \
           ${CHIBIOS}/test/testqueues.c \
+          ${CHIBIOS}/test/testwo.c \
           ${CHIBIOS}/test/testbmk.c
 
 # Required include directories
@@ -49,6 +49,12 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
+ * - @subpage test_benchmarks_017
+ * - @subpage test_benchmarks_018
+ * - @subpage test_benchmarks_019
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -682,6 +688,16 @@ static void bmk13_execute(void) {
   test_printn(sizeof(Mailbox));
   test_println(" bytes");
 #endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  test_print("--- RWLock: ");
+  test_printn(sizeof(RWLock));
+  test_println(" bytes");
+#endif
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  test_print("--- ObjFF.: ");
+  test_printn(sizeof(ObjectsFifo));
+  test_println(" bytes");
+#endif
 }
 
 ROMCONST struct testcase testbmk13 = {
@@ -691,6 +707,401 @@ ROMCONST struct testcase testbmk13 = {
   bmk13_execute
 };
 
+#if (CH_USE_MEMPOOLS && CH_USE_MAILBOXES) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_014 Memory Pool and Mailbox objects throughput
+ *
+ * <h2>Description</h2>
+ * An object is allocated from a memory pool, posted in a mailbox, fetched
+ * by an higher priority thread and freed back into the pool into a
+ * continuous loop. This is the reference for the objects FIFO
+ * benchmarks.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static MemoryPool mp1;
+static Mailbox mb1;
+
+static msg_t thread14(void *p) {
+  msg_t msg;
+
+  (void)p;
+  while (chMBFetch(&mb1, &msg, TIME_INFINITE) == RDY_OK) {
+    chPoolFree(&mp1, (void *)msg);
+    if (chThdShouldTerminate())
+      break;
+  }
+  return 0;
+}
+
+static void bmk14_setup(void) {
+
+  chPoolInit(&mp1, sizeof (msg_t) * 4, NULL);
+  chPoolLoadArray(&mp1, wa[1], 4);
+  chMBInit(&mb1, (msg_t *)wa[2], 4);
+}
+
+static void bmk14_execute(void) {
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread14, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    (void)chMBPost(&mb1, (msg_t)chPoolAlloc(&mp1), TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_terminate_threads();
+  (void)chMBPost(&mb1, (msg_t)chPoolAlloc(&mp1), TIME_INFINITE);
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" objects/S");
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, memory pool and mailbox",
+  bmk14_setup,
+  NULL,
+  bmk14_execute
+};
+#endif /* CH_USE_MEMPOOLS && CH_USE_MAILBOXES */
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_015 Objects FIFO throughput
+ *
+ * <h2>Description</h2>
+ * An object is taken from an objects FIFO and sent, an higher priority
+ * thread receives the object and returns it to the FIFO. The operation is
+ * performed into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK_FIFO_SIZE 4
+
+static ObjectsFifo of1;
+
+static msg_t thread15(void *p) {
+  void *objs[BMK_FIFO_SIZE];
+  cnt_t n;
+
+  (void)p;
+  while ((n = chFifoReceiveObjects(&of1, objs, BMK_FIFO_SIZE,
+                                   TIME_INFINITE)) > 0) {
+    chFifoReturnObjects(&of1, objs, n);
+    if (chThdShouldTerminate())
+      break;
+  }
+  return 0;
+}
+
+static void bmk15_setup(void) {
+
+  chFifoInit(&of1, sizeof (msg_t) * 4, BMK_FIFO_SIZE, wa[1], (void **)wa[2]);
+}
+
+static void bmk15_execute(void) {
+  uint32_t n = 0;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread15, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chFifoSendObject(&of1, chFifoTakeObject(&of1, TIME_INFINITE));
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_terminate_threads();
+  chFifoSendObject(&of1, chFifoTakeObject(&of1, TIME_INFINITE));
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" objects/S");
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, objects FIFO",
+  bmk15_setup,
+  NULL,
+  bmk15_execute
+};
+
+/**
+ * @page test_benchmarks_016 Objects FIFO batch throughput
+ *
+ * <h2>Description</h2>
+ * Four objects are taken from an objects FIFO and sent as a single batch,
+ * an higher priority thread receives the whole batch and returns it to the
+ * FIFO. The operation is performed into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk16_execute(void) {
+  void *objs[BMK_FIFO_SIZE];
+  uint32_t n = 0;
+  unsigned i;
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread15, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    for (i = 0; i < BMK_FIFO_SIZE; i++)
+      objs[i] = chFifoTakeObjectS(&of1, TIME_INFINITE);
+    chFifoSendObjectsI(&of1, objs, BMK_FIFO_SIZE);
+    chSchRescheduleS();
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_terminate_threads();
+  chFifoSendObject(&of1, chFifoTakeObject(&of1, TIME_INFINITE));
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(n * BMK_FIFO_SIZE);
+  test_println(" objects/S");
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, objects FIFO, batches",
+  bmk15_setup,
+  NULL,
+  bmk16_execute
+};
+#endif /* CH_USE_OBJFIFOS */
+
+#if CH_USE_CONDVARS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_017 Condition variable broadcast performance
+ *
+ * <h2>Description</h2>
+ * A number of higher priority threads wait on a condition variable, the
+ * benchmark thread locks the mutex, broadcasts the condition variable and
+ * unlocks the mutex into a continuous loop. Each awakened thread acquires
+ * the mutex in turn and goes back waiting.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+/**
+ * @brief   Number of threads waiting on the condition variable, values
+ *          in the 8-32 range are meaningful.
+ */
+#if !defined(BMK_CONDVAR_WAITERS) || defined(__DOXYGEN__)
+#define BMK_CONDVAR_WAITERS     8
+#endif
+
+static CondVar cnd1;
+static bool_t bmk17_stop;
+static Thread *bmk17_threads[BMK_CONDVAR_WAITERS];
+static stkalign_t bmk17_wa[BMK_CONDVAR_WAITERS]
+                          [THD_WA_SIZE(THREADS_STACK_SIZE) /
+                           sizeof(stkalign_t)];
+
+static msg_t thread17(void *p) {
+
+  (void)p;
+  chMtxLock(&mtx1);
+  while (!bmk17_stop)
+    chCondWait(&cnd1);
+  chMtxUnlock();
+  return 0;
+}
+
+static void bmk17_setup(void) {
+
+  chMtxInit(&mtx1);
+  chCondInit(&cnd1);
+  bmk17_stop = FALSE;
+}
+
+static void bmk17_execute(void) {
+  uint32_t n = 0;
+  unsigned i;
+
+  for (i = 0; i < BMK_CONDVAR_WAITERS; i++)
+    bmk17_threads[i] = chThdCreateStatic(bmk17_wa[i], sizeof bmk17_wa[i],
+                                         chThdGetPriority() + 1,
+                                         thread17, NULL);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chMtxLock(&mtx1);
+    chCondBroadcast(&cnd1);
+    chMtxUnlock();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chMtxLock(&mtx1);
+  bmk17_stop = TRUE;
+  chCondBroadcast(&cnd1);
+  chMtxUnlock();
+  for (i = 0; i < BMK_CONDVAR_WAITERS; i++)
+    chThdWait(bmk17_threads[i]);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" broadcasts/S, ");
+  test_printn(n * BMK_CONDVAR_WAITERS);
+  test_println(" wakeups/S");
+}
+
+ROMCONST struct testcase testbmk17 = {
+  "Benchmark, condition variable broadcast",
+  bmk17_setup,
+  NULL,
+  bmk17_execute
+};
+#endif /* CH_USE_CONDVARS */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_018 Reader-writer lock, concurrent readers
+ *
+ * <h2>Description</h2>
+ * Four threads at the same priority level lock a reader-writer lock for
+ * reading, yield while holding the lock and then unlock it into a
+ * continuous loop. All the threads can hold the lock at the same time.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK_RW_THREADS          4
+
+static RWLock rw1;
+static uint32_t bmk18_counts[BMK_RW_THREADS];
+
+static msg_t thread18(void *p) {
+  uint32_t *np = (uint32_t *)p;
+
+  while (!test_timer_done) {
+    chRWLockReadLock(&rw1);
+    chThdYield();
+    chRWLockReadUnlock(&rw1);
+    (*np)++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  }
+  return 0;
+}
+
+static void bmk18_setup(void) {
+
+  chRWLockInit(&rw1, RW_PREFER_WRITERS);
+}
+
+static uint32_t bmk18_run(tfunc_t tf, unsigned nthreads) {
+  uint32_t n = 0;
+  unsigned i;
+
+  for (i = 0; i < nthreads; i++)
+    bmk18_counts[i] = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  for (i = 0; i < nthreads; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriority() + 1,
+                                   tf, &bmk18_counts[i]);
+  test_wait_threads();
+  for (i = 0; i < nthreads; i++)
+    n += bmk18_counts[i];
+  return n;
+}
+
+static void bmk18_execute(void) {
+
+  test_print("--- Score : ");
+  test_printn(bmk18_run(thread18, BMK_RW_THREADS));
+  test_println(" lock+unlock/S");
+}
+
+ROMCONST struct testcase testbmk18 = {
+  "Benchmark, reader-writer lock, readers",
+  bmk18_setup,
+  NULL,
+  bmk18_execute
+};
+
+/**
+ * @page test_benchmarks_019 Reader-writer lock, readers scaling
+ *
+ * <h2>Description</h2>
+ * One, two and four threads lock a reader-writer lock for reading and sleep
+ * for one tick while holding it, the same workload is then repeated using
+ * a mutex instead of the reader-writer lock.<br>
+ * The readers sleep at the same time and the score scales with the number
+ * of threads while the mutex serializes them. The performance is
+ * calculated by measuring the number of completed reads after a second of
+ * continuous operations.
+ */
+
+static msg_t thread19(void *p) {
+  uint32_t *np = (uint32_t *)p;
+
+  while (!test_timer_done) {
+    chRWLockReadLock(&rw1);
+    chThdSleep(1);
+    chRWLockReadUnlock(&rw1);
+    (*np)++;
+  }
+  return 0;
+}
+
+static msg_t thread19_mtx(void *p) {
+  uint32_t *np = (uint32_t *)p;
+
+  while (!test_timer_done) {
+    chMtxLock(&mtx1);
+    chThdSleep(1);
+    chMtxUnlock();
+    (*np)++;
+  }
+  return 0;
+}
+
+static void bmk19_setup(void) {
+
+  chMtxInit(&mtx1);
+  bmk18_setup();
+}
+
+static void bmk19_execute(void) {
+  unsigned n;
+
+  for (n = 1; n <= BMK_RW_THREADS; n *= 2) {
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" readers, ");
+    test_printn(bmk18_run(thread19, n));
+    test_print(" reads/S, mutex ");
+    test_printn(bmk18_run(thread19_mtx, n));
+    test_println(" reads/S");
+  }
+}
+
+ROMCONST struct testcase testbmk19 = {
+  "Benchmark, reader-writer lock, readers scaling",
+  bmk19_setup,
+  NULL,
+  bmk19_execute
+};
+#endif /* CH_USE_RWLOCKS */
+
 /**
  * @brief   Test sequence for benchmarks.
  */
@@ -715,6 +1126,20 @@ ROMCONST struct testcase * ROMCONST patternbmk[] = {
   &testbmk12,
 #endif
   &testbmk13,
+#if (CH_USE_MEMPOOLS && CH_USE_MAILBOXES) || defined(__DOXYGEN__)
+  &testbmk14,
+#endif
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  &testbmk15,
+  &testbmk16,
+#endif
+#if CH_USE_CONDVARS || defined(__DOXYGEN__)
+  &testbmk17,
+#endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  &testbmk18,
+  &testbmk19,
+#endif
 #endif
   NULL
 };
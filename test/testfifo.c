@@ -0,0 +1,259 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_fifo Objects FIFOs test
+ *
+ * File: @ref testfifo.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref objects_fifos
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref objects_fifos
+ * subsystem code.<br>
+ * Note that the @ref objects_fifos subsystem depends on the @ref semaphores
+ * and @ref pools subsystems that have to met their testing objectives as
+ * well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_OBJFIFOS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_fifo_001
+ * - @subpage test_fifo_002
+ * .
+ * @file testfifo.c
+ * @brief Objects FIFOs test source file
+ * @file testfifo.h
+ * @brief Objects FIFOs header file
+ */
+
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+
+#define ALLOWED_DELAY MS2ST(5)
+#define FIFO_SIZE 5
+
+/*
+ * Test object, the first field is overwritten while the object is in
+ * the FIFO pool.
+ */
+typedef struct {
+  void      *link;
+  char      token;
+} fifoobj_t;
+
+static ObjectsFifo of1;
+
+/**
+ * @page test_fifo_001 Queuing and timeouts
+ *
+ * <h2>Description</h2>
+ * Objects are taken, sent, received and returned in carefully designed
+ * sequences in order to stimulate all the possible code paths inside the
+ * objects FIFO, both with the single object and the batch APIs.<br>
+ * The test expects to find a consistent FIFO status after each operation.
+ */
+
+static void fifo1_setup(void) {
+
+  chFifoInit(&of1, sizeof (fifoobj_t), FIFO_SIZE,
+             test.wa.T0, (void **)test.wa.T1);
+}
+
+static void fifo1_execute(void) {
+  fifoobj_t *objs[FIFO_SIZE], *objp;
+  msg_t msg;
+  cnt_t n;
+  unsigned i;
+
+  /*
+   * Testing initial space.
+   */
+  test_assert_lock(1, chFifoGetFreeCountI(&of1) == FIFO_SIZE, "wrong size");
+  test_assert_lock(2, chFifoGetUsedCountI(&of1) == 0, "not empty");
+
+  /*
+   * Taking all the objects and sending them.
+   */
+  for (i = 0; i < FIFO_SIZE; i++) {
+    objp = chFifoTakeObject(&of1, TIME_INFINITE);
+    test_assert(3, objp != NULL, "no free object");
+    objp->token = 'A' + i;
+    chFifoSendObject(&of1, objp);
+  }
+
+  /*
+   * Testing take timeout.
+   */
+  test_assert(4, chFifoTakeObject(&of1, 1) == NULL, "object taken");
+  chSysLock();
+  objp = chFifoTakeObjectI(&of1);
+  chSysUnlock();
+  test_assert(5, objp == NULL, "object taken");
+  test_assert_lock(6, chFifoGetUsedCountI(&of1) == FIFO_SIZE, "not full");
+  test_assert_lock(7, of1.of_rdptr == of1.of_wrptr, "pointers not aligned");
+
+  /*
+   * Testing dequeuing and returning.
+   */
+  for (i = 0; i < FIFO_SIZE; i++) {
+    msg = chFifoReceiveObject(&of1, (void **)&objp, TIME_INFINITE);
+    test_assert(8, msg == RDY_OK, "wrong wake-up message");
+    test_emit_token(objp->token);
+    chFifoReturnObject(&of1, objp);
+  }
+  test_assert_sequence(9, "ABCDE");
+
+  /*
+   * Testing receive timeout.
+   */
+  msg = chFifoReceiveObject(&of1, (void **)&objp, 1);
+  test_assert(10, msg == RDY_TIMEOUT, "wrong wake-up message");
+  chSysLock();
+  msg = chFifoReceiveObjectI(&of1, (void **)&objp);
+  chSysUnlock();
+  test_assert(11, msg == RDY_TIMEOUT, "wrong wake-up message");
+  n = chFifoReceiveObjects(&of1, (void **)objs, FIFO_SIZE, 1);
+  test_assert(12, n == 0, "objects received");
+
+  /*
+   * Testing I-Class.
+   */
+  chSysLock();
+  for (i = 0; i < FIFO_SIZE; i++) {
+    objp = chFifoTakeObjectI(&of1);
+    objp->token = 'A' + i;
+    chFifoSendObjectI(&of1, objp);
+  }
+  chSysUnlock();
+  for (i = 0; i < FIFO_SIZE; i++) {
+    chSysLock();
+    msg = chFifoReceiveObjectI(&of1, (void **)&objp);
+    chFifoReturnObjectI(&of1, objp);
+    chSysUnlock();
+    test_assert(13, msg == RDY_OK, "wrong wake-up message");
+    test_emit_token(objp->token);
+  }
+  test_assert_sequence(14, "ABCDE");
+
+  /*
+   * Testing batch operations and buffer circularity.
+   */
+  for (i = 0; i < FIFO_SIZE; i++) {
+    objs[i] = chFifoTakeObject(&of1, TIME_IMMEDIATE);
+    objs[i]->token = 'A' + i;
+  }
+  chFifoSendObjects(&of1, (void * const *)objs, 3);
+  chFifoSendObjects(&of1, (void * const *)&objs[3], 2);
+  n = chFifoReceiveObjects(&of1, (void **)objs, 2, TIME_INFINITE);
+  test_assert(15, n == 2, "wrong objects count");
+  test_emit_token(objs[0]->token);
+  test_emit_token(objs[1]->token);
+  chFifoReturnObjects(&of1, (void * const *)objs, n);
+  n = chFifoReceiveObjects(&of1, (void **)objs, FIFO_SIZE, TIME_INFINITE);
+  test_assert(16, n == 3, "wrong objects count");
+  for (i = 0; i < (unsigned)n; i++)
+    test_emit_token(objs[i]->token);
+  chFifoReturnObjects(&of1, (void * const *)objs, n);
+  test_assert_sequence(17, "ABCDE");
+
+  /*
+   * Testing final conditions.
+   */
+  test_assert_lock(18, chFifoGetFreeCountI(&of1) == FIFO_SIZE, "not empty");
+  test_assert_lock(19, chFifoGetUsedCountI(&of1) == 0, "still full");
+  test_assert_lock(20, of1.of_rdptr == of1.of_wrptr, "pointers not aligned");
+}
+
+ROMCONST struct testcase testfifo1 = {
+  "Objects FIFOs, queuing and timeouts",
+  fifo1_setup,
+  NULL,
+  fifo1_execute
+};
+
+/**
+ * @page test_fifo_002 Blocking receivers
+ *
+ * <h2>Description</h2>
+ * Two threads wait on an empty objects FIFO, a batch of objects is then
+ * sent within a single critical zone.<br>
+ * The test expects both threads to be awakened in priority order, each
+ * one receiving objects in FIFO order.
+ */
+
+static void fifo2_setup(void) {
+
+  chFifoInit(&of1, sizeof (fifoobj_t), FIFO_SIZE,
+             test.wa.T0, (void **)test.wa.T1);
+}
+
+static msg_t thread1(void *p) {
+  fifoobj_t *objp;
+
+  (void)p;
+  if (chFifoReceiveObject(&of1, (void **)&objp, TIME_INFINITE) == RDY_OK) {
+    test_emit_token(objp->token);
+    chFifoReturnObject(&of1, objp);
+  }
+  return 0;
+}
+
+static void fifo2_execute(void) {
+  fifoobj_t *objs[2];
+  tprio_t prio = chThdGetPriority();
+
+  threads[0] = chThdCreateStatic(wa[2], WA_SIZE, prio + 1, thread1, NULL);
+  threads[1] = chThdCreateStatic(wa[3], WA_SIZE, prio + 2, thread1, NULL);
+  objs[0] = chFifoTakeObject(&of1, TIME_IMMEDIATE);
+  objs[0]->token = 'A';
+  objs[1] = chFifoTakeObject(&of1, TIME_IMMEDIATE);
+  objs[1]->token = 'B';
+  chFifoSendObjects(&of1, (void * const *)objs, 2);
+  test_wait_threads();
+  test_assert_sequence(1, "AB");
+  test_assert_lock(2, chFifoGetFreeCountI(&of1) == FIFO_SIZE, "not empty");
+  test_assert_lock(3, chFifoGetUsedCountI(&of1) == 0, "still full");
+}
+
+ROMCONST struct testcase testfifo2 = {
+  "Objects FIFOs, blocking receivers",
+  fifo2_setup,
+  NULL,
+  fifo2_execute
+};
+
+#endif /* CH_USE_OBJFIFOS */
+
+/**
+ * @brief   Test sequence for objects FIFOs.
+ */
+ROMCONST struct testcase * ROMCONST patternfifo[] = {
+#if CH_USE_OBJFIFOS || defined(__DOXYGEN__)
+  &testfifo1,
+  &testfifo2,
+#endif
+  NULL
+};
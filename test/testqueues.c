@@ -144,6 +144,22 @@ static void queues1_execute(void) {
 
   /* Timeout */
   test_assert(13, chIQGetTimeout(&iq, 10) == Q_TIMEOUT, "wrong timeout return");
+
+  /* Bulk writes, the second one wraps around and fills the queue */
+  chSysLock();
+  n = chIQWriteI(&iq, (const uint8_t *)"ABC", 3);
+  chSysUnlock();
+  test_assert(14, n == 3, "wrong returned size");
+  test_emit_token(chIQGet(&iq));
+  test_emit_token(chIQGet(&iq));
+  chSysLock();
+  n = chIQWriteI(&iq, (const uint8_t *)"DEFG", 4);
+  chSysUnlock();
+  test_assert(15, n == 3, "wrong returned size");
+  test_assert_lock(16, chIQIsFullI(&iq), "still has space");
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    test_emit_token(chIQGet(&iq));
+  test_assert_sequence(17, "ABCDEF");
 }
 
 ROMCONST struct testcase testqueues1 = {
@@ -177,6 +193,7 @@ static msg_t thread2(void *p) {
 static void queues2_execute(void) {
   unsigned i;
   size_t n;
+  uint8_t buf[TEST_QUEUES_SIZE * 2];
 
   /* Initial empty state */
   test_assert_lock(1, chOQIsEmptyI(&oq), "not empty");
@@ -222,6 +239,27 @@ static void queues2_execute(void) {
 
   /* Timeout */
   test_assert(13, chOQPutTimeout(&oq, 0, 10) == Q_TIMEOUT, "wrong timeout return");
+
+  /* Bulk reads, the second one wraps around and empties the queue */
+  chSysLock();
+  chOQResetI(&oq);
+  chSysUnlock();
+  for (i = 0; i < 3; i++)
+    chOQPut(&oq, 'A' + i);
+  chSysLock();
+  n = chOQReadI(&oq, buf, 2);
+  chSysUnlock();
+  test_assert(14, n == 2, "wrong returned size");
+  for (i = 0; i < 3; i++)
+    chOQPut(&oq, 'D' + i);
+  chSysLock();
+  n = chOQReadI(&oq, buf + 2, TEST_QUEUES_SIZE * 2 - 2);
+  chSysUnlock();
+  test_assert(15, n == TEST_QUEUES_SIZE, "wrong returned size");
+  test_assert_lock(16, chOQIsEmptyI(&oq), "not empty");
+  for (i = 0; i < 6; i++)
+    test_emit_token(buf[i]);
+  test_assert_sequence(17, "ABCDEF");
 }
 
 ROMCONST struct testcase testqueues2 = {
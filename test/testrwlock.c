@@ -0,0 +1,358 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_rwlock Reader-writer locks test
+ *
+ * File: @ref testrwlock.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref rwlocks subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref rwlocks
+ * subsystem code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_RWLOCKS
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_rwlock_001
+ * - @subpage test_rwlock_002
+ * - @subpage test_rwlock_003
+ * - @subpage test_rwlock_004
+ * .
+ * @file testrwlock.c
+ * @brief Reader-writer locks test source file
+ * @file testrwlock.h
+ * @brief Reader-writer locks test header file
+ */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+
+/*
+ * Note, the static initializer is not really required because the
+ * variable is explicitly initialized in each test case. It is done in order
+ * to test the macros.
+ */
+static RWLOCK_DECL(rw1, RW_PREFER_WRITERS);
+static RWLock rw2[CH_RWLOCK_READ_HOLDS];
+
+static msg_t reader(void *p) {
+
+  chRWLockReadLock(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockReadUnlock(&rw1);
+  return 0;
+}
+
+static msg_t writer(void *p) {
+
+  chRWLockWriteLock(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockWriteUnlock(&rw1);
+  return 0;
+}
+
+static msg_t sleeping_reader(void *p) {
+
+  (void)p;
+  chRWLockReadLock(&rw1);
+  chThdSleepMilliseconds(50);
+  chRWLockReadUnlock(&rw1);
+  return 0;
+}
+
+static msg_t timed_reader(void *p) {
+
+  if (chRWLockReadLockTimeout(&rw1, MS2ST(10)) == RDY_TIMEOUT)
+    test_emit_token(*(char *)p);
+  else
+    chRWLockReadUnlock(&rw1);
+  return 0;
+}
+
+static msg_t timed_writer(void *p) {
+
+  if (chRWLockWriteLockTimeout(&rw1, MS2ST(10)) == RDY_TIMEOUT)
+    test_emit_token(*(char *)p);
+  else
+    chRWLockWriteUnlock(&rw1);
+  return 0;
+}
+
+/**
+ * @page test_rwlock_001 Locking and timeouts
+ *
+ * <h2>Description</h2>
+ * The lock is taken for reading and writing using the non-blocking and
+ * the timeout APIs, a writer timing out while readers are waiting behind it
+ * is also tested.<br>
+ * The test expects a consistent lock state after each operation and the
+ * waiting readers to enter the lock when the writer times out.
+ */
+
+static void rwlock1_setup(void) {
+
+  chRWLockInit(&rw1, RW_PREFER_WRITERS);
+}
+
+static void rwlock1_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  /*
+   * Non-blocking locking.
+   */
+  test_assert(1, chRWLockTryReadLock(&rw1), "not locked");
+  test_assert_lock(2, chRWLockIsReadLockedS(&rw1), "not read locked");
+  chRWLockReadUnlock(&rw1);
+  test_assert(3, chRWLockTryWriteLock(&rw1), "not locked");
+  test_assert_lock(4, chRWLockIsWriteLockedS(&rw1), "not write locked");
+
+  /*
+   * Threads timing out on a write locked lock.
+   */
+  test_wait_tick();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 2,
+                                 timed_reader, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 1,
+                                 timed_writer, "B");
+  test_wait_threads();
+  test_assert_sequence(5, "AB");
+  test_assert_lock(6, chRWLockIsWriteLockedS(&rw1), "not write locked");
+  chRWLockWriteUnlock(&rw1);
+  test_assert_lock(7, !chRWLockIsWriteLockedS(&rw1), "still locked");
+
+  /*
+   * A writer timing out while a reader is waiting behind it.
+   */
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 1,
+                                 sleeping_reader, NULL);
+  chThdSleepMilliseconds(5);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 1,
+                                 timed_writer, "A");
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio + 2,
+                                 reader, "B");
+  test_wait_threads();
+  test_assert_sequence(8, "BA");
+
+  /*
+   * Testing final conditions.
+   */
+  test_assert_lock(9, !chRWLockIsReadLockedS(&rw1), "still locked");
+  test_assert_lock(10, isempty(&rw1.rw_rdqueue), "queue not empty");
+  test_assert_lock(11, isempty(&rw1.rw_wrqueue), "queue not empty");
+  test_assert(12, chThdGetPriority() == prio, "wrong priority level");
+}
+
+ROMCONST struct testcase testrwlock1 = {
+  "RWLocks, locking and timeouts",
+  rwlock1_setup,
+  NULL,
+  rwlock1_execute
+};
+
+/**
+ * @page test_rwlock_002 Policies
+ *
+ * <h2>Description</h2>
+ * The lock is held for reading while a writer and then a reader ask for the
+ * lock, the test is repeated for both the lock policies.<br>
+ * The test expects the reader to wait for the writer when writers are
+ * preferred and to enter the lock immediately when readers are preferred.
+ */
+
+static void rwlock2_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  chRWLockInit(&rw1, RW_PREFER_WRITERS);
+  chRWLockReadLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, writer, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 2, reader, "B");
+  chRWLockReadUnlock(&rw1);
+  test_wait_threads();
+  test_assert_sequence(1, "AB");
+
+  chRWLockInit(&rw1, RW_PREFER_READERS);
+  chRWLockReadLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, writer, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 2, reader, "B");
+  chRWLockReadUnlock(&rw1);
+  test_wait_threads();
+  test_assert_sequence(2, "BA");
+}
+
+ROMCONST struct testcase testrwlock2 = {
+  "RWLocks, policies",
+  NULL,
+  NULL,
+  rwlock2_execute
+};
+
+/**
+ * @page test_rwlock_003 Priority inheritance
+ *
+ * <h2>Description</h2>
+ * Higher priority threads ask for a lock held by the test thread or by a
+ * lower priority reader.<br>
+ * The test expects the writer or the readers holding the lock to inherit
+ * the priority of the waiting threads and to return to their base priority
+ * when the lock is released.
+ */
+
+static void rwlock3_setup(void) {
+
+  chRWLockInit(&rw1, RW_PREFER_WRITERS);
+}
+
+static void rwlock3_execute(void) {
+  tprio_t prio = chThdGetPriority();
+
+  /*
+   * A waiting writer boosts the readers.
+   */
+  chRWLockReadLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, writer, "A");
+  test_assert(1, chThdGetPriority() == prio + 1, "not boosted");
+  chRWLockReadUnlock(&rw1);
+  test_assert(2, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+
+  /*
+   * A waiting reader boosts the writer.
+   */
+  chRWLockWriteLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 2, reader, "B");
+  test_assert(3, chThdGetPriority() == prio + 2, "not boosted");
+  chRWLockWriteUnlock(&rw1);
+  test_assert(4, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+
+  /*
+   * A waiting writer boosts a lower priority reader.
+   */
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 1,
+                                 sleeping_reader, NULL);
+  chThdSleepMilliseconds(5);
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 1, writer, "C");
+  test_assert(5, threads[0]->p_prio == prio + 1, "not boosted");
+  test_wait_threads();
+  test_assert_sequence(6, "ABC");
+}
+
+ROMCONST struct testcase testrwlock3 = {
+  "RWLocks, priority inheritance",
+  rwlock3_setup,
+  NULL,
+  rwlock3_execute
+};
+
+/**
+ * @page test_rwlock_004 Nested and multiple read locks
+ *
+ * <h2>Description</h2>
+ * The lock is taken for reading several times while a writer is waiting,
+ * then the thread takes all the read locks it can hold and asks for one
+ * more, finally a lock held for writing is asked for reading.<br>
+ * The test expects the nested read locks to enter regardless of the
+ * waiting writer, the writer to enter after the last unlock and the read
+ * locks exceeding @p CH_RWLOCK_READ_HOLDS or conflicting with the write
+ * lock to be rejected with @p RDY_RESET.
+ */
+
+static void rwlock4_setup(void) {
+  unsigned i;
+
+  chRWLockInit(&rw1, RW_PREFER_WRITERS);
+  for (i = 0; i < CH_RWLOCK_READ_HOLDS; i++)
+    chRWLockInit(&rw2[i], RW_PREFER_WRITERS);
+}
+
+static void rwlock4_execute(void) {
+  tprio_t prio = chThdGetPriority();
+  unsigned i;
+
+  /*
+   * Nested read locks with a waiting writer.
+   */
+  test_assert(1, chRWLockReadLock(&rw1) == RDY_OK, "not locked");
+  test_assert(2, chRWLockReadLock(&rw1) == RDY_OK, "not nested");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio + 1, writer, "A");
+  test_assert(3, chRWLockTryReadLock(&rw1), "nested lock blocked by writer");
+
+  /*
+   * Read locks exceeding the thread's reader records.
+   */
+  for (i = 0; i < CH_RWLOCK_READ_HOLDS - 1; i++)
+    test_assert(4, chRWLockReadLock(&rw2[i]) == RDY_OK, "not locked");
+  test_assert(5, chRWLockReadLock(&rw2[i]) == RDY_RESET, "not rejected");
+  test_assert_lock(6, !chRWLockIsReadLockedS(&rw2[i]), "locked");
+  for (i = 0; i < CH_RWLOCK_READ_HOLDS - 1; i++)
+    chRWLockReadUnlock(&rw2[i]);
+
+  /*
+   * The writer enters after the last nested unlock.
+   */
+  chRWLockReadUnlock(&rw1);
+  chRWLockReadUnlock(&rw1);
+  test_assert_sequence(7, "");
+  test_assert(8, chThdGetPriority() == prio + 1, "not boosted");
+  chRWLockReadUnlock(&rw1);
+  test_wait_threads();
+  test_assert_sequence(9, "A");
+  test_assert(10, chThdGetPriority() == prio, "wrong priority level");
+
+  /*
+   * Read lock on a lock held for writing.
+   */
+  chRWLockWriteLock(&rw2[0]);
+  test_assert(11, chRWLockReadLock(&rw2[0]) == RDY_RESET, "not rejected");
+  chRWLockWriteUnlock(&rw2[0]);
+  test_assert_lock(12, !chRWLockIsWriteLockedS(&rw2[0]), "still locked");
+}
+
+ROMCONST struct testcase testrwlock4 = {
+  "RWLocks, nested and multiple read locks",
+  rwlock4_setup,
+  NULL,
+  rwlock4_execute
+};
+
+#endif /* CH_USE_RWLOCKS */
+
+/**
+ * @brief   Test sequence for reader-writer locks.
+ */
+ROMCONST struct testcase * ROMCONST patternrwlock[] = {
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  &testrwlock1,
+  &testrwlock2,
+  &testrwlock3,
+  &testrwlock4,
+#endif
+  NULL
+};
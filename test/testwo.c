@@ -0,0 +1,284 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_wo Multiple objects wait test
+ *
+ * File: @ref testwo.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref wait_objects
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref wait_objects
+ * subsystem code.<br>
+ * Note that the @ref wait_objects subsystem depends on the @ref events
+ * subsystem that has to met its testing objectives as well.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_WAITOBJECTS
+ * - @p CH_USE_MAILBOXES
+ * - @p CH_USE_QUEUES
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_wo_001
+ * - @subpage test_wo_002
+ * .
+ * @file testwo.c
+ * @brief Multiple objects wait test source file
+ * @file testwo.h
+ * @brief Multiple objects wait header file
+ */
+
+#if (CH_USE_WAITOBJECTS && CH_USE_MAILBOXES && CH_USE_QUEUES) ||           \
+    defined(__DOXYGEN__)
+
+#define ALLOWED_DELAY MS2ST(5)
+#define QUEUE_SIZE 4
+
+static EventSource es1;
+static Semaphore sem1;
+static msg_t mb1_buf[2];
+static Mailbox mb1;
+static uint8_t iq1_buf[QUEUE_SIZE];
+static InputQueue iq1;
+static uint8_t oq1_buf[QUEUE_SIZE];
+static OutputQueue oq1;
+
+static void wo_setup(void) {
+
+  chEvtInit(&es1);
+  chSemInit(&sem1, 0);
+  chMBInit(&mb1, mb1_buf, sizeof (mb1_buf) / sizeof (msg_t));
+  chIQInit(&iq1, iq1_buf, sizeof (iq1_buf), NULL, NULL);
+  chOQInit(&oq1, oq1_buf, sizeof (oq1_buf), NULL, NULL);
+}
+
+/**
+ * @page test_wo_001 Readiness and precedence
+ *
+ * <h2>Description</h2>
+ * A set composed of an event source, a semaphore, a mailbox and two I/O
+ * queues is registered, the objects are then made ready one at time and
+ * the readiness is polled.<br>
+ * The test expects the ready object index to be returned, lower indexes
+ * to have precedence and the timeout to be respected when no object is
+ * ready.
+ */
+
+static void wo1_execute(void) {
+  WaitObject wo[5];
+  systime_t target_time;
+  msg_t msg;
+
+  /*
+   * Filling the output queue so that all the objects are not ready.
+   */
+  while (chOQPutTimeout(&oq1, 0, TIME_IMMEDIATE) == Q_OK)
+    ;
+
+  chWOObjectInit(&wo[0], WO_SEMAPHORE, &sem1);
+  chWOObjectInit(&wo[1], WO_MAILBOX_FETCH, &mb1);
+  chWOObjectInit(&wo[2], WO_INPUTQUEUE, &iq1);
+  chWOObjectInit(&wo[3], WO_OUTPUTQUEUE, &oq1);
+  chWOObjectInit(&wo[4], WO_EVENTSOURCE, &es1);
+  chWORegister(wo, 5, 0);
+
+  msg = chWOWaitTimeout(wo, 5, TIME_IMMEDIATE);
+  test_assert(1, msg == RDY_TIMEOUT, "object ready");
+
+  /*
+   * Making each object ready in turn.
+   */
+  chSemSignal(&sem1);
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(2, msg == 0, "semaphore not ready");
+  chSemWait(&sem1);
+
+  (void)chMBPost(&mb1, 'A', TIME_IMMEDIATE);
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(3, msg == 1, "mailbox not ready");
+  (void)chMBFetch(&mb1, &msg, TIME_IMMEDIATE);
+
+  chSysLock();
+  chIQPutI(&iq1, 'A');
+  chSysUnlock();
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(4, msg == 2, "input queue not ready");
+  (void)chIQGetTimeout(&iq1, TIME_IMMEDIATE);
+
+  chSysLock();
+  chOQGetI(&oq1);
+  chSysUnlock();
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(5, msg == 3, "output queue not ready");
+  (void)chOQPutTimeout(&oq1, 0, TIME_IMMEDIATE);
+
+  chEvtBroadcast(&es1);
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(6, msg == 4, "event source not ready");
+  msg = chWOWaitTimeout(wo, 5, TIME_IMMEDIATE);
+  test_assert(7, msg == RDY_TIMEOUT, "event not consumed");
+
+  /*
+   * Testing precedence.
+   */
+  chEvtBroadcast(&es1);
+  chSemSignal(&sem1);
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(8, msg == 0, "wrong precedence");
+  chSemWait(&sem1);
+  msg = chWOWaitTimeout(wo, 5, TIME_INFINITE);
+  test_assert(9, msg == 4, "event lost");
+
+  /*
+   * Testing timeout.
+   */
+  test_wait_tick();
+  target_time = chTimeNow() + MS2ST(50);
+  msg = chWOWaitTimeout(wo, 5, MS2ST(50));
+  test_assert_time_window(10, target_time, target_time + ALLOWED_DELAY);
+  test_assert(11, msg == RDY_TIMEOUT, "object ready");
+
+  /*
+   * Testing final conditions.
+   */
+  chWOUnregister(wo, 5);
+  test_assert(12, !chEvtIsListeningI(&es1), "still listening");
+  test_assert(13, !chEvtIsListeningI(&sem1.s_event), "still listening");
+  test_assert(14, !chEvtIsListeningI(&mb1.mb_fullsem.s_event),
+              "still listening");
+  test_assert(15, !chEvtIsListeningI(&iq1.q_event), "still listening");
+  test_assert(16, !chEvtIsListeningI(&oq1.q_event), "still listening");
+}
+
+ROMCONST struct testcase testwo1 = {
+  "Wait objects, readiness and precedence",
+  wo_setup,
+  NULL,
+  wo1_execute
+};
+
+/**
+ * @page test_wo_002 Blocking wait
+ *
+ * <h2>Description</h2>
+ * A thread blocks on a set of objects, four threads make a different object
+ * ready after increasing delays.<br>
+ * The test expects the waiting thread to be awakened by each object in
+ * time order.
+ */
+
+static msg_t thread1(void *p) {
+  char token = (char)(intptr_t)p;
+
+  chThdSleepMilliseconds((token - 'A' + 1) * 10);
+  switch (token) {
+  case 'A':
+    (void)chMBPost(&mb1, 'A', TIME_INFINITE);
+    break;
+  case 'B':
+    chSemSignal(&sem1);
+    break;
+  case 'C':
+    chSysLock();
+    chIQPutI(&iq1, 'C');
+    chSchRescheduleS();
+    chSysUnlock();
+    break;
+  default:
+    chEvtBroadcast(&es1);
+  }
+  return 0;
+}
+
+static void wo2_execute(void) {
+  WaitObject wo[4] = {
+    _WAITOBJECT_DATA(WO_EVENTSOURCE, &es1),
+    _WAITOBJECT_DATA(WO_INPUTQUEUE, &iq1),
+    _WAITOBJECT_DATA(WO_SEMAPHORE, &sem1),
+    _WAITOBJECT_DATA(WO_MAILBOX_FETCH, &mb1)
+  };
+  tprio_t prio = chThdGetPriority();
+  systime_t target_time;
+  msg_t msg;
+  unsigned i;
+
+  chWORegister(wo, 4, 0);
+  test_wait_tick();
+  target_time = chTimeNow() + MS2ST(40);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 1,
+                                 thread1, (void *)'A');
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio - 1,
+                                 thread1, (void *)'B');
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio - 1,
+                                 thread1, (void *)'C');
+  threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio - 1,
+                                 thread1, (void *)'D');
+  for (i = 0; i < 4; i++) {
+    msg = chWOWaitTimeout(wo, 4, MS2ST(100));
+    test_assert(1, msg >= 0, "timeout");
+    test_emit_token('D' - msg);
+    switch (msg) {
+    case 1:
+      (void)chIQGetTimeout(&iq1, TIME_IMMEDIATE);
+      break;
+    case 2:
+      chSemWait(&sem1);
+      break;
+    case 3:
+      (void)chMBFetch(&mb1, &msg, TIME_IMMEDIATE);
+      break;
+    }
+  }
+  test_assert_time_window(2, target_time, target_time + ALLOWED_DELAY);
+  test_wait_threads();
+  chWOUnregister(wo, 4);
+  test_assert_sequence(3, "ABCD");
+}
+
+ROMCONST struct testcase testwo2 = {
+  "Wait objects, blocking wait",
+  wo_setup,
+  NULL,
+  wo2_execute
+};
+
+#endif /* CH_USE_WAITOBJECTS && CH_USE_MAILBOXES && CH_USE_QUEUES */
+
+/**
+ * @brief   Test sequence for multiple objects wait.
+ */
+ROMCONST struct testcase * ROMCONST patternwo[] = {
+#if (CH_USE_WAITOBJECTS && CH_USE_MAILBOXES && CH_USE_QUEUES) ||           \
+    defined(__DOXYGEN__)
+  &testwo1,
+  &testwo2,
+#endif
+  NULL
+};
@@ -0,0 +1,260 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "adc_stream.h"
+#include "simtest.h"
+
+/*
+ * Conversion buffer depth, each half becomes a block.
+ */
+#define ADC_DEPTH           512
+#define BLOCK_ROWS          (ADC_DEPTH / 2)
+#define NUM_CHANNELS        4
+#define NUM_BLOCKS          8
+
+/*
+ * Rate of the realtime test in rows per second.
+ */
+#define RATE                200000
+
+/*
+ * Duration of each test in milliseconds.
+ */
+#define TEST_TIME           1000
+
+/*
+ * Incremented by the idle thread, see IDLE_LOOP_HOOK in chconf.h.
+ */
+volatile unsigned long idle_counter;
+
+/*
+ * The periods are submultiples of the block size, so all the blocks have
+ * the same content regardless of the blocks lost.
+ */
+static const ADCSimChannel inputs[NUM_CHANNELS] = {
+  {ADC_SIM_SAWTOOTH, BLOCK_ROWS,     2048, 2000},
+  {ADC_SIM_SINE,     BLOCK_ROWS,     2048, 1000},
+  {ADC_SIM_SQUARE,   BLOCK_ROWS / 4, 1000,  500},
+  {ADC_SIM_NOISE,    0,              3000,  100}
+};
+
+static const ADCConfig adc_cfg = {0};
+
+/*
+ * The stream installs its own callbacks.
+ */
+static const ADCConversionGroup grp_rate = {
+  TRUE, NUM_CHANNELS, NULL, NULL, RATE, inputs
+};
+
+static const ADCConversionGroup grp_free = {
+  TRUE, NUM_CHANNELS, NULL, NULL, 0, inputs
+};
+
+static adcsample_t buffer[ADC_DEPTH * NUM_CHANNELS];
+static ADC_STREAM_BLOCKS_DECL(blocks, NUM_BLOCKS, NUM_CHANNELS, ADC_DEPTH);
+static msg_t queue[NUM_BLOCKS];
+
+static const ADCStreamConfig cfg_rate = {
+  &ADCD1, &grp_rate, buffer, ADC_DEPTH, blocks, queue, NUM_BLOCKS
+};
+
+static const ADCStreamConfig cfg_free = {
+  &ADCD1, &grp_free, buffer, ADC_DEPTH, blocks, queue, NUM_BLOCKS
+};
+
+static ADCStream AS1;
+
+/*
+ * Consumers statistics.
+ */
+typedef struct {
+  systime_t     delay;
+  uint32_t      received;
+  uint32_t      gaps;
+  uint32_t      last;
+  bool_t        corrupted;
+} consumer_t;
+
+static consumer_t consumers[2];
+
+static WORKING_AREA(waConsumer1, 2048);
+static WORKING_AREA(waConsumer2, 2048);
+
+/*
+ * Verifies the content of a block against the simulated inputs.
+ */
+static bool_t verify(ADCStreamBlock *bp) {
+  adcsample_t *sp = adcsBlockSamples(bp);
+  size_t r;
+
+  if (bp->n != BLOCK_ROWS)
+    return TRUE;
+  for (r = 0; r < BLOCK_ROWS; r++, sp += NUM_CHANNELS) {
+    if (sp[0] != 2048 - 2000 + (r * 2 * 2000) / BLOCK_ROWS)
+      return TRUE;
+    if ((r == 0) && (sp[1] != 2048))
+      return TRUE;
+    if ((r == BLOCK_ROWS / 4) && (sp[1] != 2048 + 1000))
+      return TRUE;
+    if ((r == 3 * BLOCK_ROWS / 4) && (sp[1] != 2048 - 1000))
+      return TRUE;
+    if (sp[2] != ((r % (BLOCK_ROWS / 4)) < BLOCK_ROWS / 8 ? 1500 : 500))
+      return TRUE;
+    if ((sp[3] < 3000 - 100) || (sp[3] > 3000 + 100))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+ * Consumer thread, it terminates when the stream is stopped.
+ */
+static msg_t Consumer(void *arg) {
+  consumer_t *cp = arg;
+  ADCStreamBlock *bp;
+
+  while ((bp = adcsGetBlock(&AS1, MS2ST(100))) != NULL) {
+    if (verify(bp))
+      cp->corrupted = TRUE;
+    if ((cp->received > 0) && (bp->seq != cp->last + 1))
+      cp->gaps += bp->seq - cp->last - 1;
+    cp->last = bp->seq;
+    cp->received++;
+    if (cp->delay > 0)
+      chThdSleep(cp->delay);
+    adcsReleaseBlock(&AS1, bp);
+  }
+  return 0;
+}
+
+/*
+ * Runs the stream for the test time with the specified consumers.
+ */
+static void run(const ADCStreamConfig *cfg, unsigned n, systime_t delay,
+                uint64_t *elapsed, unsigned long *idle) {
+  Thread *tp[2];
+  uint64_t start;
+  unsigned i;
+
+  for (i = 0; i < n; i++) {
+    consumers[i].delay = delay;
+    consumers[i].received = 0;
+    consumers[i].gaps = 0;
+    consumers[i].corrupted = FALSE;
+  }
+  *idle = idle_counter;
+  start = simtest_now_ns();
+  adcsStart(&AS1, cfg);
+  tp[0] = chThdCreateStatic(waConsumer1, sizeof(waConsumer1), NORMALPRIO + 1,
+                            Consumer, &consumers[0]);
+  if (n > 1)
+    tp[1] = chThdCreateStatic(waConsumer2, sizeof(waConsumer2),
+                              NORMALPRIO + 1, Consumer, &consumers[1]);
+
+  chThdSleepMilliseconds(TEST_TIME);
+  adcsStop(&AS1);
+  *elapsed = simtest_now_ns() - start;
+  *idle = idle_counter - *idle;
+
+  for (i = 0; i < n; i++)
+    chThdWait(tp[i]);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  uint64_t start, elapsed;
+  unsigned long idle;
+  double idle_ns;
+  uint32_t received;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  adcStart(&ADCD1, &adc_cfg);
+  adcsObjectInit(&AS1);
+
+  /*
+   * Idle loop cost.
+   */
+  idle = idle_counter;
+  start = simtest_now_ns();
+  chThdSleepMilliseconds(500);
+  idle_ns = (double)(simtest_now_ns() - start) / (idle_counter - idle);
+
+  /*
+   * Realtime rate, two consumers sharing the blocks.
+   */
+  run(&cfg_rate, 2, 0, &elapsed, &idle);
+  received = consumers[0].received + consumers[1].received;
+  printf("Realtime, %u rows/s, %u channels\n", RATE, NUM_CHANNELS);
+  printf("  %-38s: %u\n", "Blocks", received);
+  printf("  %-38s: %.1f %%\n", "CPU load",
+         100.0 * (1.0 - (idle * idle_ns) / (double)elapsed));
+  simtest_check(consumers[0].corrupted || consumers[1].corrupted,
+                "  Blocks content");
+  simtest_check((consumers[0].received == 0) || (consumers[1].received == 0),
+                "  Blocks shared by the consumers");
+  simtest_check(adcsGetOverruns(&AS1) != 0, "  No overruns");
+  simtest_check(AS1.seq - received > NUM_BLOCKS, "  Blocks accounting");
+  simtest_check((received < (uint32_t)((uint64_t)RATE * TEST_TIME / 1000 /
+                                       BLOCK_ROWS * 9 / 10)) ||
+                (received > (uint32_t)((uint64_t)RATE * elapsed /
+                                       1000000000ULL / BLOCK_ROWS + 1)),
+                "  Blocks rate");
+
+  /*
+   * Free running converter, single consumer.
+   */
+  run(&cfg_free, 1, 0, &elapsed, &idle);
+  received = consumers[0].received;
+  printf("Free running\n");
+  printf("  %-38s: %.2f Msamples/s\n", "Throughput",
+         (double)received * BLOCK_ROWS * NUM_CHANNELS * 1000.0 / elapsed);
+  printf("  %-38s: %u\n", "Overruns", adcsGetOverruns(&AS1));
+  simtest_check(consumers[0].corrupted, "  Blocks content");
+  simtest_check(consumers[0].gaps > adcsGetOverruns(&AS1), "  Gaps accounting");
+
+  /*
+   * Free running converter, slow consumer.
+   */
+  run(&cfg_free, 1, MS2ST(2), &elapsed, &idle);
+  received = consumers[0].received;
+  printf("Free running, slow consumer\n");
+  printf("  %-38s: %u\n", "Blocks", received);
+  printf("  %-38s: %u\n", "Overruns", adcsGetOverruns(&AS1));
+  simtest_check(consumers[0].corrupted, "  Blocks content");
+  simtest_check(adcsGetOverruns(&AS1) == 0, "  Overruns detected");
+  simtest_check((consumers[0].gaps > adcsGetOverruns(&AS1)) ||
+                (AS1.seq - received - adcsGetOverruns(&AS1) > NUM_BLOCKS),
+                "  Overruns accounting");
+
+  adcStop(&ADCD1);
+  return 0;
+}
@@ -0,0 +1,336 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+#if (CAN_RX_FIFO_SIZE < 64) || (CAN_TX_QUEUE_SIZE == 0)
+#error "this demo requires the CAN software queues, see halconf.h"
+#endif
+
+/*
+ * Bus bit rate.
+ */
+#define BITRATE             1000000
+
+/*
+ * Frames sent by the periodic node every millisecond.
+ */
+#define BURST               4
+
+/*
+ * Frames fetched by the receiver with each batch.
+ */
+#define BATCH               32
+
+/*
+ * Duration of each test in milliseconds.
+ */
+#define TEST_TIME           1000
+
+#define ID_PERIODIC         0x100
+#define ID_FLOOD            0x300
+
+/*
+ * Incremented by the idle thread, see IDLE_LOOP_HOOK in chconf.h.
+ */
+volatile unsigned long idle_counter;
+
+static const CANConfig cancfg = {BITRATE};
+
+/*
+ * Transmitters statistics.
+ */
+static volatile bool_t stop;
+static uint32_t sent[2];
+
+/*
+ * Receiver statistics.
+ */
+typedef struct {
+  unsigned      stall_every;
+  systime_t     stall;
+  uint32_t      received[2];
+  uint32_t      gaps[2];
+  uint32_t      last[2];
+  uint32_t      batches;
+  bool_t        corrupted;
+} receiver_t;
+
+static receiver_t rx;
+
+static WORKING_AREA(waPeriodic, 2048);
+static WORKING_AREA(waFlood, 2048);
+static WORKING_AREA(waReceiver, 4096);
+
+/*
+ * CPU load from the fraction of time spent in the idle loop, the idle loop
+ * iterations under load do not cost exactly as in the calibration so the
+ * result is clamped.
+ */
+static double cpu_load(double idle_fraction) {
+  double load = 100.0 * (1.0 - idle_fraction);
+
+  if (load < 0.0)
+    return 0.0;
+  if (load > 100.0)
+    return 100.0;
+  return load;
+}
+
+static void make_frame(CANTxFrame *ctfp, uint32_t id, uint32_t seq) {
+
+  ctfp->IDE = CAN_IDE_STD;
+  ctfp->RTR = CAN_RTR_DATA;
+  ctfp->DLC = 8;
+  ctfp->SID = id;
+  ctfp->data32[0] = seq;
+  ctfp->data32[1] = ~seq;
+}
+
+/*
+ * High priority node, a burst of frames every millisecond.
+ */
+static msg_t Periodic(void *arg) {
+  CANTxFrame txf;
+  systime_t time = chTimeNow(), interval;
+  unsigned i;
+
+  (void)arg;
+  while (!stop) {
+    for (i = 0; i < BURST; i++) {
+      make_frame(&txf, ID_PERIODIC, sent[0]);
+      if (canTransmit(&CAND1, CAN_ANY_MAILBOX, &txf, MS2ST(100)) != RDY_OK)
+        return 1;
+      sent[0]++;
+    }
+    /* A deadline already reached restarts the period from the current
+       time, chThdSleepUntil() would sleep for a whole counter wrap.*/
+    chSysLock();
+    time += MS2ST(1);
+    interval = time - chTimeNow();
+    if ((interval == 0) || (interval > MS2ST(1)))
+      time = chTimeNow();
+    else
+      chThdSleepS(interval);
+    chSysUnlock();
+  }
+  return 0;
+}
+
+/*
+ * Low priority node, it fills the bus.
+ */
+static msg_t Flood(void *arg) {
+  CANTxFrame txf;
+
+  (void)arg;
+  while (!stop) {
+    make_frame(&txf, ID_FLOOD, sent[1]);
+    if (canTransmit(&CAND2, CAN_ANY_MAILBOX, &txf, MS2ST(100)) != RDY_OK)
+      return 1;
+    sent[1]++;
+  }
+  return 0;
+}
+
+/*
+ * Receiver node, it stalls periodically, it terminates when the bus is
+ * silent.
+ */
+static msg_t Receiver(void *arg) {
+  CANRxFrame frames[BATCH];
+  size_t i, n;
+  unsigned s;
+
+  (void)arg;
+  while ((n = canReceiveBatch(&CAND3, CAN_ANY_MAILBOX, frames, BATCH,
+                              MS2ST(100))) > 0) {
+    for (i = 0; i < n; i++) {
+      s = frames[i].SID == ID_PERIODIC ? 0 : 1;
+      if ((frames[i].IDE != CAN_IDE_STD) || (frames[i].DLC != 8) ||
+          (frames[i].data32[1] != ~frames[i].data32[0]))
+        rx.corrupted = TRUE;
+      if ((rx.received[s] > 0) || (frames[i].data32[0] > 0))
+        rx.gaps[s] += frames[i].data32[0] -
+                      (rx.received[s] > 0 ? rx.last[s] + 1 : 0);
+      rx.last[s] = frames[i].data32[0];
+      rx.received[s]++;
+    }
+    if ((rx.stall > 0) && (++rx.batches % rx.stall_every == 0))
+      chThdSleep(rx.stall);
+  }
+  return 0;
+}
+
+/*
+ * Runs the traffic for the test time.
+ */
+static void run(unsigned stall_every, systime_t stall,
+                double *load, double *cpu) {
+  Thread *tp[3];
+  uint64_t start, elapsed, frames, bits0, bits1;
+  systime_t ticks;
+  unsigned long idle;
+
+  rx = (receiver_t){stall_every, stall, {0, 0}, {0, 0}, {0, 0}, 0, FALSE};
+  sent[0] = sent[1] = 0;
+  stop = FALSE;
+  tp[0] = chThdCreateStatic(waReceiver, sizeof(waReceiver), NORMALPRIO + 2,
+                            Receiver, NULL);
+  tp[1] = chThdCreateStatic(waPeriodic, sizeof(waPeriodic), NORMALPRIO + 1,
+                            Periodic, NULL);
+  tp[2] = chThdCreateStatic(waFlood, sizeof(waFlood), NORMALPRIO - 1,
+                            Flood, NULL);
+
+  /* Measuring the bus load and the CPU load at full load, the bus time
+     follows the system time.*/
+  chThdSleepMilliseconds(10);
+  canSimGetBusStats(&frames, &bits0);
+  idle = idle_counter;
+  ticks = chTimeNow();
+  start = simtest_now_ns();
+  chThdSleepMilliseconds(TEST_TIME);
+  canSimGetBusStats(&frames, &bits1);
+  elapsed = simtest_now_ns() - start;
+  ticks = chTimeNow() - ticks;
+  idle = idle_counter - idle;
+  *load = 100.0 * (bits1 - bits0) * CH_FREQUENCY /
+          ((double)ticks * BITRATE);
+  *cpu = (double)idle / elapsed;
+
+  stop = TRUE;
+  chThdWait(tp[2]);
+  chThdWait(tp[1]);
+  chThdWait(tp[0]);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static const uint32_t order[5] = {0x0FF, 0x100, 0x100, 0x100, 0x101};
+  CANTxFrame txf;
+  CANRxFrame rxf;
+  uint64_t start;
+  unsigned long idle;
+  double idle_ns, load, cpu;
+  uint32_t received, lost;
+  unsigned i;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  canStart(&CAND1, &cancfg);
+  canStart(&CAND2, &cancfg);
+  canStart(&CAND3, &cancfg);
+
+  /*
+   * Idle loop cost, measured with the nodes started and the bus silent for
+   * the same time of the load measurements.
+   */
+  idle = idle_counter;
+  start = simtest_now_ns();
+  chThdSleepMilliseconds(TEST_TIME);
+  idle_ns = (double)(simtest_now_ns() - start) / (idle_counter - idle);
+
+  /*
+   * Arbitration, all the frames are pending when the bus becomes idle.
+   */
+  txf.DLC = 0;
+  txf.RTR = CAN_RTR_DATA;
+  txf.IDE = CAN_IDE_EXT;
+  txf.EID = (0x100 << 18) | 5;
+  canTransmit(&CAND1, CAN_ANY_MAILBOX, &txf, TIME_INFINITE);
+  txf.IDE = CAN_IDE_STD;
+  txf.RTR = CAN_RTR_REMOTE;
+  txf.SID = 0x100;
+  canTransmit(&CAND1, CAN_ANY_MAILBOX, &txf, TIME_INFINITE);
+  txf.RTR = CAN_RTR_DATA;
+  canTransmit(&CAND1, CAN_ANY_MAILBOX, &txf, TIME_INFINITE);
+  txf.SID = 0x101;
+  canTransmit(&CAND2, CAN_ANY_MAILBOX, &txf, TIME_INFINITE);
+  txf.IDE = CAN_IDE_EXT;
+  txf.EID = (0x0FF << 18) | 0x3FFFF;
+  canTransmit(&CAND2, CAN_ANY_MAILBOX, &txf, TIME_INFINITE);
+  failed = FALSE;
+  for (i = 0; i < 5; i++) {
+    if (canReceive(&CAND3, CAN_ANY_MAILBOX, &rxf, MS2ST(100)) != RDY_OK) {
+      failed = TRUE;
+      break;
+    }
+    if ((uint32_t)(rxf.IDE ? rxf.EID >> 18 : rxf.SID) != order[i])
+      failed = TRUE;
+    if ((i == 1) && (rxf.IDE || rxf.RTR))
+      failed = TRUE;
+    if ((i == 2) && (rxf.IDE || !rxf.RTR))
+      failed = TRUE;
+    if ((i == 3) && !rxf.IDE)
+      failed = TRUE;
+  }
+  simtest_check(failed, "Arbitration order");
+
+  /*
+   * Full bus load, the receiver stalls for less than the FIFO duration.
+   */
+  run(20, MS2ST(3), &load, &cpu);
+  printf("Full load, %u bit/s\n", BITRATE);
+  printf("  %-38s: %.1f %%\n", "Bus load", load);
+  printf("  %-38s: %.1f %%\n", "CPU load", cpu_load(cpu * idle_ns));
+  printf("  %-38s: %u + %u\n", "Frames received",
+         rx.received[0], rx.received[1]);
+  printf("  %-38s: %.1f\n", "Frames per batch",
+         (double)(rx.received[0] + rx.received[1]) / rx.batches);
+  simtest_check(rx.corrupted, "  Frames content");
+  simtest_check(load < 90.0, "  Bus saturated");
+  simtest_check((rx.received[0] != sent[0]) || (rx.received[1] != sent[1]) ||
+                (rx.gaps[0] != 0) || (rx.gaps[1] != 0), "  No frames lost");
+  simtest_check((canGetRxOverflows(&CAND3) != 0) || (CAND3.rxlost != 0),
+                "  No overflows");
+  simtest_check(sent[0] < (uint32_t)(TEST_TIME - 10) * BURST,
+                "  High priority bandwidth");
+
+  /*
+   * Receiver stalls longer than the FIFO duration.
+   */
+  run(20, MS2ST(50), &load, &cpu);
+  received = rx.received[0] + rx.received[1];
+  lost = canGetRxOverflows(&CAND3) + CAND3.rxlost;
+  printf("Full load, slow receiver\n");
+  printf("  %-38s: %u\n", "Frames received", received);
+  printf("  %-38s: %u\n", "Overflows", lost);
+  simtest_check(rx.corrupted, "  Frames content");
+  simtest_check(lost == 0, "  Overflows detected");
+  simtest_check(received + lost != sent[0] + sent[1], "  Overflows accounting");
+  simtest_check(rx.gaps[0] + rx.gaps[1] + (sent[0] - rx.last[0] - 1) +
+                (sent[1] - rx.last[1] - 1) != lost, "  Gaps accounting");
+
+  canStop(&CAND3);
+  canStop(&CAND2);
+  canStop(&CAND1);
+  return 0;
+}
@@ -0,0 +1,403 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+#if !CAN_USE_SOFTWARE_FILTERS || (CAN_RX_FIFO_SIZE == 0)
+#error "this demo requires the CAN software filters and FIFO, see halconf.h"
+#endif
+
+/*
+ * Bus bit rate.
+ */
+#define BITRATE             1000000
+
+/*
+ * Rules, the first two rules are routed to a mailbox and to a callback,
+ * the other rules are counted by the receiver.
+ */
+#define N_EXT_EXACT         192
+#define N_STD_EXACT         64
+#define N_STD_RANGE         16
+#define N_EXT_SOURCE        24
+#define N_RULES             (2 + N_EXT_EXACT + N_STD_EXACT + N_STD_RANGE +  \
+                             N_EXT_SOURCE)
+#define N_SLOTS             1024
+
+/*
+ * Synthetic traffic, percentage of frames matching a rule.
+ */
+#define N_FRAMES            4096
+#define MATCHING            50
+
+/*
+ * Lookup benchmark repetitions.
+ */
+#define BENCH_ROUNDS        200
+
+/*
+ * Frames transmitted on the bus.
+ */
+#define BUS_FRAMES          8192
+
+/*
+ * Frames pool of the mailbox rule.
+ */
+#define POOL_SIZE           16
+
+static const CANConfig cancfg = {BITRATE};
+
+static CANFilterRule rules[N_RULES];
+static uint16_t slots[N_SLOTS];
+static CANFilterSet fs;
+static CANRxFrame pool[POOL_SIZE];
+static msg_t mb_buffer[POOL_SIZE];
+static MAILBOX_DECL(mb, mb_buffer, POOL_SIZE);
+
+static CANRxFrame traffic[N_FRAMES];
+static uint32_t expected[N_RULES], counted[N_RULES];
+static uint32_t expected_unmatched;
+static volatile uint32_t callbacks, mailed;
+static bool_t corrupted;
+
+static WORKING_AREA(waSender, 2048);
+static WORKING_AREA(waReceiver, 4096);
+static WORKING_AREA(waConsumer, 2048);
+
+static uint32_t rnd(void) {
+  static uint32_t x = 2463534242U;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+static uint32_t id_mask(uint8_t ide) {
+
+  return ide ? 0x1FFFFFFFU : 0x7FFU;
+}
+
+static uint32_t frame_id(const CANRxFrame *crfp) {
+
+  return crfp->IDE ? crfp->EID : crfp->SID;
+}
+
+/*
+ * Reference implementation, linear scan of the rules.
+ */
+static const CANFilterRule *linear_lookup(const CANRxFrame *crfp) {
+  uint32_t id = frame_id(crfp);
+  unsigned i;
+
+  for (i = 0; i < N_RULES; i++) {
+    if ((rules[i].ide == crfp->IDE) &&
+        (((id ^ rules[i].id) & rules[i].mask & id_mask(crfp->IDE)) == 0))
+      return &rules[i];
+  }
+  return NULL;
+}
+
+static bool_t hw_accepts(const CANFilter *cfp, unsigned n,
+                         const CANRxFrame *crfp) {
+  unsigned i;
+
+  for (i = 0; i < n; i++) {
+    if ((cfp[i].ide > CAN_IDE_EXT) ||
+        ((cfp[i].ide == crfp->IDE) &&
+         (((frame_id(crfp) ^ cfp[i].id) & cfp[i].mask) == 0)))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static void rule_cb(const CANFilterRule *rp, const CANRxFrame *crfp) {
+
+  (void)crfp;
+  if (rp == &rules[1])
+    callbacks++;
+}
+
+/*
+ * J1939-like rules set, exact parameter group numbers, standard ids and
+ * id ranges, parameter groups from any source address.
+ */
+static void make_rules(void) {
+  unsigned i, n = 0;
+
+  rules[n++] = (CANFilterRule){0x18FEF100, 0x1FFFFFFF, CAN_IDE_EXT,
+                               NULL, &mb, NULL};
+  rules[n++] = (CANFilterRule){0x123, 0x7FF, CAN_IDE_STD,
+                               rule_cb, NULL, NULL};
+  for (i = 0; i < N_EXT_EXACT; i++)
+    rules[n++] = (CANFilterRule){0x0C000000 | ((0xF000 + i * 7) << 8) |
+                                 (i & 0x1F), 0x1FFFFFFF, CAN_IDE_EXT,
+                                 NULL, NULL, NULL};
+  for (i = 0; i < N_STD_EXACT; i++)
+    rules[n++] = (CANFilterRule){0x200 + i * 3, 0x7FF, CAN_IDE_STD,
+                                 NULL, NULL, NULL};
+  for (i = 0; i < N_STD_RANGE; i++)
+    rules[n++] = (CANFilterRule){0x600 + (i << 4), 0x7F0, CAN_IDE_STD,
+                                 NULL, NULL, NULL};
+  for (i = 0; i < N_EXT_SOURCE; i++)
+    rules[n++] = (CANFilterRule){0x18EA0000 | (i << 8), 0x1FFFFF00,
+                                 CAN_IDE_EXT, NULL, NULL, NULL};
+}
+
+/*
+ * Synthetic traffic, frames matching a random rule mixed with random
+ * identifiers.
+ */
+static void make_traffic(void) {
+  unsigned i;
+
+  for (i = 0; i < N_FRAMES; i++) {
+    CANRxFrame *crfp = &traffic[i];
+    uint32_t id;
+
+    crfp->TIME = 0;
+    crfp->RTR = CAN_RTR_DATA;
+    crfp->DLC = 8;
+    if (rnd() % 100 < MATCHING) {
+      const CANFilterRule *rp = &rules[rnd() % N_RULES];
+      crfp->IDE = rp->ide;
+      id = (rp->id & rp->mask) | (rnd() & ~rp->mask);
+    }
+    else {
+      crfp->IDE = rnd() & 1;
+      id = rnd();
+    }
+    id &= id_mask(crfp->IDE);
+    if (crfp->IDE)
+      crfp->EID = id;
+    else
+      crfp->SID = id;
+    crfp->data32[0] = i;
+    crfp->data32[1] = ~i;
+  }
+}
+
+/*
+ * Transmits the synthetic traffic in a loop.
+ */
+static msg_t Sender(void *arg) {
+  CANTxFrame txf;
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < BUS_FRAMES; i++) {
+    const CANRxFrame *crfp = &traffic[i % N_FRAMES];
+    txf.IDE = crfp->IDE;
+    txf.RTR = crfp->RTR;
+    txf.DLC = crfp->DLC;
+    if (crfp->IDE)
+      txf.EID = crfp->EID;
+    else
+      txf.SID = crfp->SID;
+    txf.data32[0] = crfp->data32[0];
+    txf.data32[1] = crfp->data32[1];
+    if (canTransmit(&CAND1, CAN_ANY_MAILBOX, &txf, MS2ST(100)) != RDY_OK)
+      return 1;
+  }
+  return 0;
+}
+
+/*
+ * Receiver node, it dispatches the accepted frames, it terminates when
+ * the bus is silent.
+ */
+static msg_t Receiver(void *arg) {
+  CANRxFrame frames[32];
+  const CANFilterRule *rp;
+  size_t i, n;
+
+  (void)arg;
+  while ((n = canReceiveBatch(&CAND3, CAN_ANY_MAILBOX, frames, 32,
+                              MS2ST(100))) > 0) {
+    for (i = 0; i < n; i++) {
+      if (frames[i].data32[1] != ~frames[i].data32[0])
+        corrupted = TRUE;
+      rp = canFiltersDispatch(&fs, &frames[i]);
+      if (rp != NULL)
+        counted[rp - rules]++;
+    }
+  }
+  chMBPost(&mb, 0, TIME_INFINITE);
+  return 0;
+}
+
+/*
+ * Consumer of the frames routed to the mailbox rule.
+ */
+static msg_t Consumer(void *arg) {
+  msg_t msg;
+
+  (void)arg;
+  while ((chMBFetch(&mb, &msg, TIME_INFINITE) == RDY_OK) && (msg != 0)) {
+    CANRxFrame *crfp = (CANRxFrame *)msg;
+    if (!crfp->IDE || (crfp->EID != rules[0].id))
+      corrupted = TRUE;
+    mailed++;
+    canFiltersReleaseFrame(&fs, crfp);
+  }
+  return 0;
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static CANFilterMask masks[CAN_SIM_MAX_FILTERS];
+  static CANFilter filters[CAN_SIM_MAX_FILTERS];
+  const CANFilterRule *volatile sink;
+  Thread *tp[3];
+  uint64_t start, hash_ns, linear_ns;
+  uint32_t accepted, unmatched_accepted;
+  unsigned i, j, n;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  make_rules();
+  make_traffic();
+  canFiltersObjectInit(&fs, pool, POOL_SIZE);
+  simtest_check(canFiltersCompile(&fs, rules, N_RULES,
+                                  slots, N_SLOTS) != CH_SUCCESS,
+                "Rules compilation");
+  printf("  %-38s: %u\n", "Rules", N_RULES);
+  printf("  %-38s: %u\n", "Distinct masks", fs.nmasks);
+
+  /*
+   * Hashed lookup against the linear scan.
+   */
+  failed = FALSE;
+  for (i = 0; i < N_FRAMES; i++) {
+    if (canFiltersLookup(&fs, &traffic[i]) != linear_lookup(&traffic[i]))
+      failed = TRUE;
+  }
+  simtest_check(failed, "Lookup equivalence");
+
+  /*
+   * Hardware filters cover.
+   */
+  n = canFiltersCover(&fs, masks, CAN_SIM_MAX_FILTERS);
+  for (i = 0; i < n; i++) {
+    filters[i].id = masks[i].id;
+    filters[i].mask = masks[i].mask;
+    filters[i].ide = masks[i].ide;
+  }
+  failed = FALSE;
+  accepted = unmatched_accepted = 0;
+  expected_unmatched = 0;
+  for (i = 0; i < N_FRAMES; i++) {
+    const CANFilterRule *rp = linear_lookup(&traffic[i]);
+    bool_t hw = hw_accepts(filters, n, &traffic[i]);
+    if ((rp != NULL) && !hw)
+      failed = TRUE;
+    if (hw) {
+      accepted++;
+      if (rp == NULL)
+        unmatched_accepted++;
+    }
+  }
+  for (i = 0; i < BUS_FRAMES; i++) {
+    const CANFilterRule *rp = linear_lookup(&traffic[i % N_FRAMES]);
+    if (rp != NULL)
+      expected[rp - rules]++;
+    else if (hw_accepts(filters, n, &traffic[i % N_FRAMES]))
+      expected_unmatched++;
+  }
+  printf("Hardware filters cover\n");
+  printf("  %-38s: %u\n", "Filters", n);
+  printf("  %-38s: %.1f %%\n", "Accepted traffic",
+         100.0 * accepted / N_FRAMES);
+  printf("  %-38s: %.1f %%\n", "Accepted unmatched traffic",
+         100.0 * unmatched_accepted / N_FRAMES);
+  simtest_check(failed, "  All rules covered");
+  simtest_check(accepted == N_FRAMES, "  Unmatched traffic rejected");
+
+  /*
+   * Traffic on the simulated bus, the receiving node uses the computed
+   * hardware filters.
+   */
+  canStart(&CAND1, &cancfg);
+  canStart(&CAND3, &cancfg);
+  canSimSetFilters(&CAND3, n, filters);
+  tp[0] = chThdCreateStatic(waConsumer, sizeof(waConsumer), NORMALPRIO + 2,
+                            Consumer, NULL);
+  tp[1] = chThdCreateStatic(waReceiver, sizeof(waReceiver), NORMALPRIO + 1,
+                            Receiver, NULL);
+  tp[2] = chThdCreateStatic(waSender, sizeof(waSender), NORMALPRIO - 1,
+                            Sender, NULL);
+  failed = chThdWait(tp[2]) != 0;
+  chThdWait(tp[1]);
+  chThdWait(tp[0]);
+  printf("Bus traffic, %u frames\n", BUS_FRAMES);
+  printf("  %-38s: %u\n", "Rejected by the hardware", CAND3.rxrejected);
+  printf("  %-38s: %u\n", "Unmatched", canFiltersGetUnmatched(&fs));
+  printf("  %-38s: %u + %u\n", "Mailbox + callback", mailed, callbacks);
+  simtest_check(failed || corrupted, "  Frames content");
+  for (i = 0; i < N_RULES; i++) {
+    if (counted[i] != expected[i])
+      failed = TRUE;
+  }
+  simtest_check(failed, "  Frames routed to the rules");
+  simtest_check((mailed != expected[0]) || (callbacks != expected[1]) ||
+                (canFiltersGetDropped(&fs) != 0),
+                "  Mailbox and callback delivery");
+  simtest_check((canFiltersGetUnmatched(&fs) != expected_unmatched) ||
+                (CAND3.rxrejected + CAND3.rxframes != BUS_FRAMES) ||
+                (canGetRxOverflows(&CAND3) != 0) || (CAND3.rxlost != 0),
+                "  Frames accounting");
+
+  /*
+   * Lookup benchmark, it runs last because it does not yield and the
+   * simulated system tick falls behind.
+   */
+  start = simtest_now_ns();
+  for (j = 0; j < BENCH_ROUNDS; j++)
+    for (i = 0; i < N_FRAMES; i++)
+      sink = canFiltersLookup(&fs, &traffic[i]);
+  hash_ns = simtest_now_ns() - start;
+  start = simtest_now_ns();
+  for (j = 0; j < BENCH_ROUNDS; j++)
+    for (i = 0; i < N_FRAMES; i++)
+      sink = linear_lookup(&traffic[i]);
+  linear_ns = simtest_now_ns() - start;
+  (void)sink;
+  printf("Lookup benchmark, %u%% matching frames\n", MATCHING);
+  printf("  %-38s: %.1f ns/frame\n", "Hashed lookup",
+         (double)hash_ns / (BENCH_ROUNDS * N_FRAMES));
+  printf("  %-38s: %.1f ns/frame\n", "Linear scan",
+         (double)linear_ns / (BENCH_ROUNDS * N_FRAMES));
+  simtest_check(hash_ns >= linear_ns, "  Hashed lookup faster");
+
+  canStop(&CAND3);
+  canStop(&CAND1);
+  return 0;
+}
@@ -0,0 +1,198 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "crc.h"
+#include "simtest.h"
+
+/*
+ * Size of the benchmark buffer and number of passes for each measurement.
+ */
+#define BENCH_SIZE          4096
+#define BENCH_PASSES        2048
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT         "cycle"
+#define cycles()            __rdtsc()
+#else
+#define CYCLES_UNIT         "ns"
+static uint64_t cycles(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static uint8_t buffer[BENCH_SIZE + 8];
+
+/*
+ * Bit by bit reference implementations.
+ */
+static uint32_t ref7(uint32_t crc, const void *buf, size_t n) {
+  const uint8_t *p = buf;
+  int i;
+
+  while (n--) {
+    uint8_t b = *p++;
+    for (i = 0; i < 8; i++, b <<= 1) {
+      crc <<= 1;
+      if ((b ^ crc) & 0x80)
+        crc ^= 0x09;
+    }
+  }
+  return crc & 0x7F;
+}
+
+static uint32_t ref16(uint32_t crc, const void *buf, size_t n) {
+  const uint8_t *p = buf;
+  int i;
+
+  while (n--) {
+    crc ^= (uint32_t)*p++ << 8;
+    for (i = 0; i < 8; i++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc & 0xFFFF;
+}
+
+static uint32_t ref32(uint32_t crc, const void *buf, size_t n) {
+  const uint8_t *p = buf;
+  int i;
+
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    for (i = 0; i < 8; i++)
+      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+  }
+  return ~crc;
+}
+
+/*
+ * Adapters for the library functions.
+ */
+static uint32_t lib7(uint32_t crc, const void *buf, size_t n) {
+
+  return crc7Update((uint8_t)crc, buf, n);
+}
+
+static uint32_t lib16(uint32_t crc, const void *buf, size_t n) {
+
+  return crc16Update((uint16_t)crc, buf, n);
+}
+
+static uint32_t lib32(uint32_t crc, const void *buf, size_t n) {
+
+  return crc32Update(crc, buf, n);
+}
+
+typedef uint32_t (*crcfn_t)(uint32_t crc, const void *buf, size_t n);
+
+/*
+ * Compares a library function against its reference on all the offsets
+ * and lengths up to 64 bytes, also verifies the streaming.
+ */
+static bool_t compare(crcfn_t lib, crcfn_t ref, uint32_t init) {
+  size_t off, len, split;
+
+  for (off = 0; off < 8; off++) {
+    for (len = 0; len <= 64; len++) {
+      uint32_t crc = ref(init, buffer + off, len);
+
+      if (lib(init, buffer + off, len) != crc)
+        return TRUE;
+      for (split = 0; split <= len; split++)
+        if (lib(lib(init, buffer + off, split),
+                buffer + off + split, len - split) != crc)
+          return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static void bench(const char *msg, crcfn_t fn, unsigned passes) {
+  volatile uint32_t crc = 0;
+  uint64_t start, elapsed;
+  unsigned i;
+  double bpc;
+
+  start = cycles();
+  for (i = 0; i < passes; i++)
+    crc = fn(crc, buffer, BENCH_SIZE);
+  elapsed = cycles() - start;
+  bpc = (double)BENCH_SIZE * passes / (double)elapsed;
+  printf("%-40s: %.3f bytes/%s\n", msg, bpc, CYCLES_UNIT);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static const char check_string[] = "123456789";
+  static const uint8_t cmd0[] = {0x40, 0, 0, 0, 0};
+  unsigned i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  for (i = 0; i < sizeof(buffer); i++)
+    buffer[i] = (uint8_t)(i * 2654435761U >> 13);
+
+  /*
+   * Well known check values.
+   */
+  simtest_check(((crc7Update(CRC7_INIT_MMC, cmd0, 5) << 1) | 1) != 0x95,
+                "CRC7 of CMD0");
+  simtest_check(crc16Update(CRC16_INIT_CCITT, check_string, 9) != 0x29B1,
+                "CRC16-CCITT check value");
+  simtest_check(crc16Update(CRC16_INIT_MMC, check_string, 9) != 0x31C3,
+                "CRC16-XMODEM check value");
+  simtest_check(crc32Update(CRC32_INIT, check_string, 9) != 0xCBF43926,
+                "CRC32 check value");
+
+  /*
+   * Comparison against the reference implementations.
+   */
+  simtest_check(compare(lib7, ref7, CRC7_INIT_MMC), "CRC7 compare");
+  simtest_check(compare(lib16, ref16, CRC16_INIT_CCITT), "CRC16 compare");
+  simtest_check(compare(lib32, ref32, CRC32_INIT), "CRC32 compare");
+
+  /*
+   * Throughput.
+   */
+  printf("\nSlicing-by-%d, %d bytes buffer\n", CRC_SLICING, BENCH_SIZE);
+  bench("CRC7, bitwise reference", ref7, BENCH_PASSES / 16);
+  bench("CRC7, library", lib7, BENCH_PASSES);
+  bench("CRC16, bitwise reference", ref16, BENCH_PASSES / 16);
+  bench("CRC16, library", lib16, BENCH_PASSES);
+  bench("CRC32, bitwise reference", ref32, BENCH_PASSES / 16);
+  bench("CRC32, library", lib32, BENCH_PASSES);
+  return 0;
+}
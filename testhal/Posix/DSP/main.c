@@ -0,0 +1,327 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "dsp.h"
+#include "simtest.h"
+
+/*
+ * Signal length, block size and number of passes of the benchmarks.
+ */
+#define SIGNAL_SIZE         4096
+#define BLOCK_SIZE          256
+#define BENCH_PASSES        256
+
+#define FIR_TAPS            32
+#define DECIMATION          4
+#define BIQUAD_SECTIONS     2
+#define FFT_SIZE            256
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES_UNIT         "cycles"
+#define cycles()            __rdtsc()
+#else
+#define CYCLES_UNIT         "ns"
+static uint64_t cycles(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+static q15_t signal[SIGNAL_SIZE];
+static q15_t output[SIGNAL_SIZE];
+static q15_t reference[SIGNAL_SIZE];
+static q15_t buf1[BLOCK_SIZE], buf2[BLOCK_SIZE];
+
+static q15_t fir_coeffs[FIR_TAPS];
+static q15_t biquad_coeffs[BIQUAD_SECTIONS * 6];
+static q15_t fir_state[DSP_FIR_STATE_SIZE(FIR_TAPS, BLOCK_SIZE)];
+static q15_t dec_state[DSP_DECIMATOR_STATE_SIZE(FIR_TAPS, BLOCK_SIZE)];
+static q15_t biquad_state[DSP_BIQUAD_STATE_SIZE(BIQUAD_SECTIONS)];
+static q15_t fft_work[DSP_SPECTRUM_WORK_SIZE(FFT_SIZE)];
+
+static DSPFir fir;
+static DSPDecimator decimator;
+static DSPBiquad biquad;
+static DSPScaler scaler;
+static DSPLevel level;
+static DSPSpectrum spectrum;
+
+static q15_t sat(int64_t v) {
+
+  return v > 32767 ? 32767 : v < -32768 ? -32768 : (q15_t)v;
+}
+
+/*
+ * Test signal, two tones plus noise.
+ */
+static void make_signal(void) {
+  uint32_t seed = 1;
+  unsigned i;
+
+  for (i = 0; i < SIGNAL_SIZE; i++) {
+    seed = seed * 1664525 + 1013904223;
+    signal[i] = sat(lrint(12000.0 * sin(2 * M_PI * i / 64.0) +
+                          8000.0 * sin(2 * M_PI * i / 5.0) +
+                          (double)((int32_t)(seed >> 16) % 2000)));
+  }
+}
+
+/*
+ * Windowed sinc lowpass, cutoff at 1/8 of the sampling rate, stored in time
+ * reversed order as required by the FIR stages.
+ */
+static void make_fir(void) {
+  unsigned k;
+
+  for (k = 0; k < FIR_TAPS; k++) {
+    double t = k - (FIR_TAPS - 1) / 2.0;
+    double h = 0.25 * (t == 0 ? 1.0 : sin(M_PI * t / 4.0) / (M_PI * t / 4.0));
+
+    h *= 0.54 - 0.46 * cos(2 * M_PI * k / (FIR_TAPS - 1));
+    fir_coeffs[FIR_TAPS - 1 - k] = (q15_t)lrint(h * 32768.0);
+  }
+}
+
+/*
+ * Two identical lowpass sections, coefficients in Q14 with the feedback
+ * coefficients negated.
+ */
+static void make_biquad(void) {
+  double w = 2 * M_PI / 16.0, alpha = sin(w) / (2 * 0.707), a0;
+  unsigned s;
+
+  a0 = 1 + alpha;
+  for (s = 0; s < BIQUAD_SECTIONS; s++) {
+    q15_t *c = &biquad_coeffs[s * 6];
+
+    c[0] = (q15_t)lrint((1 - cos(w)) / 2 / a0 * 16384.0);
+    c[1] = 0;
+    c[2] = (q15_t)lrint((1 - cos(w)) / a0 * 16384.0);
+    c[3] = c[0];
+    c[4] = (q15_t)lrint(2 * cos(w) / a0 * 16384.0);
+    c[5] = (q15_t)lrint(-(1 - alpha) / a0 * 16384.0);
+  }
+}
+
+/*
+ * Direct form references on the whole signal.
+ */
+static void ref_fir(const q15_t *x, q15_t *y, size_t n) {
+  size_t i, k;
+
+  for (i = 0; i < n; i++) {
+    int64_t acc = 0;
+    for (k = 0; k < FIR_TAPS && k <= i; k++)
+      acc += (int32_t)fir_coeffs[FIR_TAPS - 1 - k] * x[i - k];
+    y[i] = sat(acc >> 15);
+  }
+}
+
+static void ref_biquad(const q15_t *x, q15_t *y, size_t n) {
+  size_t i, s;
+
+  memcpy(y, x, n * sizeof(q15_t));
+  for (s = 0; s < BIQUAD_SECTIONS; s++) {
+    const q15_t *c = &biquad_coeffs[s * 6];
+    int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    for (i = 0; i < n; i++) {
+      int64_t acc = (int64_t)c[0] * y[i] + (int64_t)c[2] * x1 +
+                    (int64_t)c[3] * x2 + (int64_t)c[4] * y1 +
+                    (int64_t)c[5] * y2;
+      x2 = x1;
+      x1 = y[i];
+      y2 = y1;
+      y1 = sat(acc >> 14);
+      y[i] = (q15_t)y1;
+    }
+  }
+}
+
+static const q15_t *process(DSPStage *sp, const q15_t *in, q15_t *out,
+                            size_t *np) {
+
+  return dspStageProcess(sp, in, out, np);
+}
+
+/*
+ * Runs a stage on the whole signal, the blocks have variable sizes in
+ * order to exercise the state handling.
+ */
+static size_t run(DSPStage *sp, size_t step) {
+  size_t i = 0, o = 0, n;
+
+  while (i < SIGNAL_SIZE) {
+    const q15_t *p;
+
+    n = SIGNAL_SIZE - i < step ? SIGNAL_SIZE - i : step;
+    p = dspStageProcess(sp, signal + i, buf1, &n);
+    memcpy(output + o, p, n * sizeof(q15_t));
+    i += step;
+    o += n;
+    step = step == BLOCK_SIZE ? DECIMATION * 8 : BLOCK_SIZE;
+  }
+  return o;
+}
+
+static void bench(const char *msg, DSPStage *sp, size_t n) {
+  uint64_t start, elapsed;
+  unsigned i, j;
+
+  start = cycles();
+  for (i = 0; i < BENCH_PASSES; i++) {
+    for (j = 0; j < SIGNAL_SIZE; j += n) {
+      size_t k = n;
+
+      (void)dspStageProcess(sp, signal + j, buf1, &k);
+    }
+  }
+  elapsed = cycles() - start;
+  printf("%-40s: %.2f %s/sample\n", msg,
+         (double)elapsed / ((double)BENCH_PASSES * SIGNAL_SIZE), CYCLES_UNIT);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static DSPStage * const chain[] = {
+    (DSPStage *)&scaler, (DSPStage *)&fir, (DSPStage *)&decimator,
+    (DSPStage *)&level
+  };
+  DSPPipeline pipeline;
+  const q15_t *p;
+  size_t i, n;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  make_signal();
+  make_fir();
+  make_biquad();
+
+  /*
+   * Filters against the references.
+   */
+  dspFirObjectInit(&fir, FIR_TAPS, fir_coeffs, fir_state, BLOCK_SIZE);
+  ref_fir(signal, reference, SIGNAL_SIZE);
+  simtest_check((run((DSPStage *)&fir, BLOCK_SIZE) != SIGNAL_SIZE) ||
+                (memcmp(output, reference, sizeof(output)) != 0), "FIR filter");
+
+  dspDecimatorObjectInit(&decimator, FIR_TAPS, DECIMATION, fir_coeffs,
+                         dec_state, BLOCK_SIZE);
+  failed = run((DSPStage *)&decimator, BLOCK_SIZE) !=
+           SIGNAL_SIZE / DECIMATION;
+  for (i = 0; i < SIGNAL_SIZE / DECIMATION; i++)
+    failed = failed || (output[i] != reference[i * DECIMATION]);
+  simtest_check(failed, "FIR decimator");
+
+  dspBiquadObjectInit(&biquad, BIQUAD_SECTIONS, biquad_coeffs,
+                      biquad_state, 1);
+  ref_biquad(signal, reference, SIGNAL_SIZE);
+  simtest_check((run((DSPStage *)&biquad, BLOCK_SIZE) != SIGNAL_SIZE) ||
+                (memcmp(output, reference, sizeof(output)) != 0),
+                "Biquad cascade");
+
+  dspScalerObjectInit(&scaler, 24576, 1);
+  run((DSPStage *)&scaler, BLOCK_SIZE);
+  failed = FALSE;
+  for (i = 0; i < SIGNAL_SIZE; i++)
+    failed = failed || (output[i] != sat(((int32_t)signal[i] * 24576) >> 14));
+  simtest_check(failed, "Scaler");
+
+  /*
+   * Measurements.
+   */
+  dspLevelObjectInit(&level);
+  for (i = 0; i < BLOCK_SIZE; i++)
+    buf2[i] = i & 1 ? -16384 : 16384;
+  n = BLOCK_SIZE;
+  p = process((DSPStage *)&level, buf2, buf1, &n);
+  simtest_check((p != buf2) || (n != BLOCK_SIZE) ||
+                (level.rms != 16384) || (level.peak != 16384),
+                "Level, square wave");
+  for (i = 0; i < BLOCK_SIZE; i++)
+    buf2[i] = (q15_t)lrint(20000.0 * sin(2 * M_PI * i / 32.0));
+  n = BLOCK_SIZE;
+  (void)process((DSPStage *)&level, buf2, buf1, &n);
+  simtest_check((abs(level.rms - 14142) > 2) || (level.peak != 20000),
+                "Level, sine wave");
+
+  dspSpectrumObjectInit(&spectrum, FFT_SIZE, fft_work);
+  for (i = 0; i < FFT_SIZE; i++)
+    buf2[i] = (q15_t)lrint(16000.0 * sin(2 * M_PI * 8 * i / FFT_SIZE));
+  n = FFT_SIZE;
+  p = process((DSPStage *)&spectrum, buf2, buf1, &n);
+  failed = (n != FFT_SIZE / 2) || (abs(p[8] - 8000) > 16);
+  for (i = 0; i < FFT_SIZE / 2; i++)
+    failed = failed || ((i != 8) && (p[i] > 16));
+  simtest_check(failed, "Spectrum, sine wave");
+
+  /*
+   * Pipeline against the stages invoked one by one.
+   */
+  dspScalerObjectInit(&scaler, 16384, 0);
+  dspFirObjectInit(&fir, FIR_TAPS, fir_coeffs, fir_state, BLOCK_SIZE);
+  dspDecimatorObjectInit(&decimator, FIR_TAPS, DECIMATION, fir_coeffs,
+                         dec_state, BLOCK_SIZE);
+  dspPipelineObjectInit(&pipeline, chain, 4, buf1, buf2);
+  n = BLOCK_SIZE;
+  p = dspPipelineProcess(&pipeline, signal, &n);
+  memcpy(output, p, n * sizeof(q15_t));
+  simtest_check(n != BLOCK_SIZE / DECIMATION, "Pipeline, output size");
+  dspFirObjectInit(&fir, FIR_TAPS, fir_coeffs, fir_state, BLOCK_SIZE);
+  dspDecimatorObjectInit(&decimator, FIR_TAPS, DECIMATION, fir_coeffs,
+                         dec_state, BLOCK_SIZE);
+  n = BLOCK_SIZE;
+  p = process((DSPStage *)&scaler, signal, reference, &n);
+  p = process((DSPStage *)&fir, p, buf1, &n);
+  p = process((DSPStage *)&decimator, p, buf2, &n);
+  simtest_check(memcmp(output, p, n * sizeof(q15_t)) != 0,
+                "Pipeline, output data");
+
+  /*
+   * Throughput.
+   */
+  printf("\n%s kernels, %d samples blocks\n",
+         DSP_USE_CMSIS ? "CMSIS" : "Portable", BLOCK_SIZE);
+  bench("FIR filter, 32 taps", (DSPStage *)&fir, BLOCK_SIZE);
+  bench("FIR decimator, 32 taps, M = 4", (DSPStage *)&decimator, BLOCK_SIZE);
+  bench("Biquad cascade, 2 sections", (DSPStage *)&biquad, BLOCK_SIZE);
+  bench("Scaler", (DSPStage *)&scaler, BLOCK_SIZE);
+  bench("Level", (DSPStage *)&level, BLOCK_SIZE);
+  bench("Spectrum, 256 points", (DSPStage *)&spectrum, FFT_SIZE);
+  return 0;
+}
@@ -0,0 +1,340 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+#if !I2C_USE_QUEUE
+#error "this demo requires the I2C transactions queue, see halconf.h"
+#endif
+
+/*
+ * Bus clock speed.
+ */
+#define CLOCK_SPEED         400000
+
+/*
+ * Number of sensors on the bus and address of the first one.
+ */
+#define N_SENSORS           8
+#define SENSOR_ADDR         0x40
+
+/*
+ * Address with no device attached.
+ */
+#define MISSING_ADDR        0x50
+
+/*
+ * Sensor registers.
+ */
+#define REG_DATA            0x00
+#define REG_CONFIG          0x08
+#define N_REGS              16
+#define DATA_SIZE           6
+
+/*
+ * Reading rounds for each test.
+ */
+#define ROUNDS              200
+
+/*
+ * Timeout of the operations, much longer than the transfers because the
+ * system ticks can run back to back while catching up after an host stall.
+ */
+#define TIMEOUT             MS2ST(1000)
+
+/*
+ * Simulated sensor, a register file with an auto-incrementing register
+ * pointer, the data registers are refreshed each time they are read from
+ * the first one.
+ */
+typedef struct {
+  const struct I2CSlaveModelVMT *vmt;
+  _i2c_slave_model_data
+  unsigned      index;
+  uint8_t       regs[N_REGS];
+  uint8_t       ptr;
+  bool_t        pointer;
+  uint32_t      samples;
+} sensor_t;
+
+static bool_t sensor_start(void *ip, bool_t read) {
+  sensor_t *sp = ip;
+
+  if (!read)
+    sp->pointer = TRUE;
+  else if (sp->ptr == REG_DATA) {
+    unsigned i;
+
+    sp->samples++;
+    for (i = 0; i < DATA_SIZE; i++)
+      sp->regs[REG_DATA + i] = (uint8_t)(sp->samples * (sp->index + 1) + i);
+  }
+  return TRUE;
+}
+
+static bool_t sensor_write(void *ip, uint8_t b) {
+  sensor_t *sp = ip;
+
+  if (sp->pointer) {
+    sp->pointer = FALSE;
+    if (b >= N_REGS)
+      return FALSE;
+    sp->ptr = b;
+  }
+  else {
+    sp->regs[sp->ptr] = b;
+    sp->ptr = (sp->ptr + 1) % N_REGS;
+  }
+  return TRUE;
+}
+
+static uint8_t sensor_read(void *ip) {
+  sensor_t *sp = ip;
+  uint8_t b = sp->regs[sp->ptr];
+
+  sp->ptr = (sp->ptr + 1) % N_REGS;
+  return b;
+}
+
+static void sensor_stop(void *ip) {
+
+  (void)ip;
+}
+
+static const struct I2CSlaveModelVMT sensor_vmt = {
+  sensor_start, sensor_write, sensor_read, sensor_stop
+};
+
+static const I2CConfig i2ccfg = {CLOCK_SPEED};
+
+static sensor_t sensors[N_SENSORS];
+static const uint8_t data_reg = REG_DATA;
+static uint8_t data[N_SENSORS][DATA_SIZE];
+static I2CTransaction transactions[N_SENSORS];
+
+static uint32_t callbacks, polls;
+static bool_t corrupted;
+
+/*
+ * Verifies the data read from a sensor, the sample number is the number
+ * of reads of the sensor.
+ */
+static void verify(unsigned i) {
+  unsigned j;
+
+  for (j = 0; j < DATA_SIZE; j++)
+    if (data[i][j] != (uint8_t)(sensors[i].samples * (i + 1) + j))
+      corrupted = TRUE;
+}
+
+static void counting_cb(I2CDriver *i2cp, I2CTransaction *itp) {
+
+  (void)i2cp;
+  if (itp->status == RDY_OK)
+    verify(itp - transactions);
+  callbacks++;
+}
+
+/*
+ * Continuous polling, each transaction submits itself again until the
+ * required number of polls has been performed.
+ */
+static void polling_cb(I2CDriver *i2cp, I2CTransaction *itp) {
+
+  verify(itp - transactions);
+  if (++polls <= ROUNDS * N_SENSORS - N_SENSORS) {
+    chSysLockFromIsr();
+    i2cQueueSubmitI(i2cp, itp, 1);
+    chSysUnlockFromIsr();
+  }
+}
+
+static void prepare(i2ccallback_t callback) {
+  unsigned i;
+
+  for (i = 0; i < N_SENSORS; i++) {
+    static const I2CTransaction t = _I2C_TRANSACTION_DATA(0, &data_reg, 1,
+                                                          NULL, DATA_SIZE,
+                                                          NULL, NULL);
+    transactions[i] = t;
+    transactions[i].addr = SENSOR_ADDR + i;
+    transactions[i].rxbuf = data[i];
+    transactions[i].callback = callback;
+  }
+}
+
+static void report(const char *name, uint64_t elapsed,
+                   uint32_t transfers, uint64_t busy, unsigned wakeups) {
+
+  printf("%s\n", name);
+  printf("  %-38s: %u\n", "Transactions", transfers);
+  printf("  %-38s: %u\n", "Thread wakeups per round", wakeups);
+  printf("  %-38s: %.1f us\n", "Time per round",
+         (double)elapsed / 1000.0 / ROUNDS);
+  printf("  %-38s: %.2f %%\n", "Bus utilization",
+         100.0 * busy / elapsed);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static const uint8_t config_write[3] = {REG_CONFIG, 0x5A, 0xA5};
+  static const uint8_t config_reg = REG_CONFIG;
+  static uint8_t config_read[N_SENSORS][2];
+  static I2CTransaction mixed[3 + N_SENSORS];
+  EventListener el;
+  uint64_t start, elapsed, busy0, busy1;
+  uint32_t transfers0, transfers1;
+  unsigned i, r;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  for (i = 0; i < N_SENSORS; i++) {
+    sensors[i].vmt = &sensor_vmt;
+    sensors[i].index = i;
+    i2cSimAttachSlave(&I2CD1, SENSOR_ADDR + i, (I2CSlaveModel *)&sensors[i]);
+  }
+  i2cStart(&I2CD1, &i2ccfg);
+
+  /*
+   * Blocking reads, one transfer and one thread wakeup for each sensor.
+   */
+  corrupted = FALSE;
+  i2cSimGetBusStats(&I2CD1, &transfers0, &busy0);
+  start = simtest_now_ns();
+  failed = FALSE;
+  for (r = 0; r < ROUNDS; r++) {
+    for (i = 0; i < N_SENSORS; i++) {
+      i2cAcquireBus(&I2CD1);
+      if (i2cMasterTransmitTimeout(&I2CD1, SENSOR_ADDR + i, &data_reg, 1,
+                                   data[i], DATA_SIZE, TIMEOUT) != RDY_OK)
+        failed = TRUE;
+      i2cReleaseBus(&I2CD1);
+      verify(i);
+    }
+  }
+  elapsed = simtest_now_ns() - start;
+  i2cSimGetBusStats(&I2CD1, &transfers1, &busy1);
+  report("Blocking reads", elapsed, transfers1 - transfers0, busy1 - busy0,
+         N_SENSORS);
+  simtest_check(failed || corrupted, "  Data");
+
+  /*
+   * Queued reads, one batch and one thread wakeup for each round.
+   */
+  prepare(counting_cb);
+  callbacks = 0;
+  i2cSimGetBusStats(&I2CD1, &transfers0, &busy0);
+  start = simtest_now_ns();
+  failed = FALSE;
+  for (r = 0; r < ROUNDS; r++) {
+    i2cAcquireBus(&I2CD1);
+    i2cQueueSubmit(&I2CD1, transactions, N_SENSORS);
+    if (i2cQueueWait(&I2CD1, TIMEOUT) != RDY_OK)
+      failed = TRUE;
+    i2cReleaseBus(&I2CD1);
+    for (i = 0; i < N_SENSORS; i++)
+      if (transactions[i].status != RDY_OK)
+        failed = TRUE;
+  }
+  elapsed = simtest_now_ns() - start;
+  i2cSimGetBusStats(&I2CD1, &transfers1, &busy1);
+  report("Queued reads", elapsed, transfers1 - transfers0, busy1 - busy0, 1);
+  simtest_check(failed || corrupted || (callbacks != ROUNDS * N_SENSORS),
+                "  Data and callbacks");
+  simtest_check(((busy1 - busy0) * 100) / elapsed < 95, "  Bus utilization");
+
+  /*
+   * Continuous polling from the callbacks, the queue becomes empty only
+   * at the end and the event is broadcasted once.
+   */
+  prepare(polling_cb);
+  polls = 0;
+  chEvtRegister(&I2CD1.queue_event, &el, 0);
+  chEvtGetAndClearEvents(ALL_EVENTS);
+  i2cSimGetBusStats(&I2CD1, &transfers0, &busy0);
+  start = simtest_now_ns();
+  i2cQueueSubmit(&I2CD1, transactions, N_SENSORS);
+  failed = chEvtWaitOneTimeout(EVENT_MASK(0), TIMEOUT) == 0;
+  elapsed = simtest_now_ns() - start;
+  i2cSimGetBusStats(&I2CD1, &transfers1, &busy1);
+  chEvtUnregister(&I2CD1.queue_event, &el);
+  report("Continuous polling", elapsed, transfers1 - transfers0,
+         busy1 - busy0, 0);
+  simtest_check(failed || corrupted || (polls != ROUNDS * N_SENSORS) ||
+                (I2CD1.state != I2C_READY), "  Data and completion event");
+  simtest_check(((busy1 - busy0) * 10000) / elapsed < 9900, "  Bus saturated");
+
+  /*
+   * Mixed batch, configuration writes, a missing device, a write-read and
+   * a read only transaction, a failure does not stop the queue.
+   */
+  prepare(NULL);
+  for (i = 0; i < N_SENSORS; i++) {
+    mixed[i] = transactions[i];
+    mixed[i].txbuf = config_write;
+    mixed[i].txbytes = sizeof(config_write);
+    mixed[i].rxbuf = NULL;
+    mixed[i].rxbytes = 0;
+  }
+  mixed[N_SENSORS] = transactions[0];
+  mixed[N_SENSORS].addr = MISSING_ADDR;
+  mixed[N_SENSORS + 1] = transactions[0];
+  mixed[N_SENSORS + 1].txbuf = &config_reg;
+  mixed[N_SENSORS + 1].rxbuf = config_read[0];
+  mixed[N_SENSORS + 1].rxbytes = 2;
+  mixed[N_SENSORS + 2] = transactions[N_SENSORS - 1];
+  mixed[N_SENSORS + 2].txbytes = 0;
+  mixed[N_SENSORS + 2].rxbuf = config_read[N_SENSORS - 1];
+  mixed[N_SENSORS + 2].rxbytes = 2;
+  sensors[N_SENSORS - 1].regs[REG_CONFIG + 2] = 0x11;
+  sensors[N_SENSORS - 1].regs[REG_CONFIG + 3] = 0x22;
+  i2cQueueSubmit(&I2CD1, mixed, 3 + N_SENSORS);
+  failed = i2cQueueWait(&I2CD1, TIMEOUT) != RDY_OK;
+  for (i = 0; i < N_SENSORS; i++)
+    if ((mixed[i].status != RDY_OK) ||
+        (memcmp(&sensors[i].regs[REG_CONFIG], &config_write[1], 2) != 0))
+      failed = TRUE;
+  simtest_check(failed, "Configuration writes");
+  simtest_check((mixed[N_SENSORS].status != RDY_RESET) ||
+                (mixed[N_SENSORS].errors != I2CD_ACK_FAILURE),
+                "Missing device");
+  simtest_check((mixed[N_SENSORS + 1].status != RDY_OK) ||
+                (memcmp(config_read[0], &config_write[1], 2) != 0),
+                "Write-read after a failure");
+  simtest_check((mixed[N_SENSORS + 2].status != RDY_OK) ||
+                (config_read[N_SENSORS - 1][0] != 0x11) ||
+                (config_read[N_SENSORS - 1][1] != 0x22),
+                "Read at the current pointer");
+
+  i2cStop(&I2CD1);
+  return 0;
+}
@@ -0,0 +1,369 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+/*
+ * Audio format, the buffers hold two halves of HALF_FRAMES frames.
+ */
+#define RATE                48000
+#define CHANNELS            2
+#define HALF_FRAMES         128
+#define BUFFER_SIZE         (HALF_FRAMES * 2 * CHANNELS)
+
+/*
+ * Input file length in frames, not a multiple of the half buffer so the
+ * circular reading is exercised.
+ */
+#define INPUT_FRAMES        4801
+#define IMPULSE_FRAME       100
+
+/*
+ * Duration of the realtime tests in milliseconds, the tests run for the
+ * equivalent number of half buffers.
+ */
+#define TEST_TIME           1000
+#define TEST_HALVES         (RATE / HALF_FRAMES * TEST_TIME / 1000)
+
+/*
+ * Duration of the free running test in half buffers, 2MB of output.
+ */
+#define FREE_HALVES         4096
+
+/*
+ * Processing time of the slow processing test in microseconds, longer
+ * than an half buffer period.
+ */
+#define SLOW_TIME           5000
+
+#define INPUT_FILE          "i2s_in.wav"
+#define OUTPUT_FILE         "i2s_out.wav"
+#define RAW_FILE            "i2s_out.raw"
+
+/*
+ * Incremented by the idle thread, see IDLE_LOOP_HOOK in chconf.h.
+ */
+volatile unsigned long idle_counter;
+
+static i2ssample_t tx_buffer[BUFFER_SIZE];
+static i2ssample_t rx_buffer[BUFFER_SIZE];
+
+static void i2s_cb(I2SDriver *i2sp, size_t offset, size_t n);
+
+static const I2SConfig cfg_rate = {
+  tx_buffer, rx_buffer, BUFFER_SIZE, i2s_cb,
+  RATE, CHANNELS, OUTPUT_FILE, INPUT_FILE
+};
+
+static const I2SConfig cfg_free = {
+  tx_buffer, rx_buffer, BUFFER_SIZE, i2s_cb,
+  0, CHANNELS, RAW_FILE, INPUT_FILE
+};
+
+/*
+ * Half buffers notified by the callback, the message is the offset.
+ */
+static msg_t mb_buffer[2];
+static MAILBOX_DECL(mb, mb_buffer, 2);
+
+/*
+ * Processing statistics.
+ */
+static uint64_t notified_ns;
+static uint64_t max_latency_ns;
+static uint32_t processed;
+static uint32_t callbacks;
+static uint32_t target;
+static uint64_t delay_ns;
+
+/*
+ * Signaled when the target number of callbacks has been reached.
+ */
+static SEMAPHORE_DECL(done, 0);
+
+static WORKING_AREA(waLoopback, 2048);
+
+/*
+ * Input signal, a ramp with an impulse on the first channel.
+ */
+static i2ssample_t input(size_t i) {
+
+  if (i == IMPULSE_FRAME * CHANNELS)
+    return 16000;
+  return (i2ssample_t)((i * 37) % 2000) - 1000;
+}
+
+static void put16(FILE *f, uint16_t v) {
+
+  fputc(v & 0xFF, f);
+  fputc(v >> 8, f);
+}
+
+static void put32(FILE *f, uint32_t v) {
+
+  put16(f, v & 0xFFFF);
+  put16(f, v >> 16);
+}
+
+/*
+ * Creates the input WAV file.
+ */
+static void make_input(void) {
+  FILE *f = fopen(INPUT_FILE, "wb");
+  uint32_t bytes = INPUT_FRAMES * CHANNELS * sizeof(i2ssample_t);
+  size_t i;
+
+  simtest_check(f == NULL, "Input file creation");
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + bytes);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1);
+  put16(f, CHANNELS);
+  put32(f, RATE);
+  put32(f, RATE * CHANNELS * sizeof(i2ssample_t));
+  put16(f, CHANNELS * sizeof(i2ssample_t));
+  put16(f, 16);
+  fwrite("data", 1, 4, f);
+  put32(f, bytes);
+  for (i = 0; i < INPUT_FRAMES * CHANNELS; i++)
+    put16(f, (uint16_t)input(i));
+  fclose(f);
+}
+
+/*
+ * Reads the samples of an output file.
+ */
+static i2ssample_t *read_output(const char *name, size_t header, size_t *np) {
+  FILE *f = fopen(name, "rb");
+  i2ssample_t *p;
+  long size;
+
+  if (f == NULL)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  size = ftell(f) - (long)header;
+  fseek(f, (long)header, SEEK_SET);
+  *np = size / sizeof(i2ssample_t);
+  p = malloc(size);
+  if (fread(p, sizeof(i2ssample_t), *np, f) != *np) {
+    free(p);
+    p = NULL;
+  }
+  fclose(f);
+  return p;
+}
+
+/*
+ * Verifies that the output is the input halved and delayed by a full
+ * buffer.
+ */
+static bool_t verify_output(const i2ssample_t *p, size_t n) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    if (i < BUFFER_SIZE) {
+      if (p[i] != 0)
+        return TRUE;
+    }
+    else if (p[i] != input((i - BUFFER_SIZE) %
+                           (INPUT_FRAMES * CHANNELS)) / 2)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+ * Half buffer notification, the processing is deferred to a thread.
+ */
+static void i2s_cb(I2SDriver *i2sp, size_t offset, size_t n) {
+
+  (void)i2sp;
+  (void)n;
+  chSysLockFromIsr();
+  notified_ns = simtest_now_ns();
+  if (++callbacks == target)
+    chSemSignalI(&done);
+  chMBPostI(&mb, (msg_t)offset);
+  chSysUnlockFromIsr();
+}
+
+/*
+ * Loopback thread, the received half buffer is halved and transmitted.
+ */
+static msg_t Loopback(void *arg) {
+  msg_t offset;
+  uint64_t latency;
+  size_t i;
+
+  (void)arg;
+  while (chMBFetch(&mb, &offset, MS2ST(100)) == RDY_OK) {
+    for (i = 0; i < BUFFER_SIZE / 2; i++)
+      tx_buffer[offset + i] = rx_buffer[offset + i] / 2;
+    /* The processing time is measured on the host clock, the system ticks
+       can run back to back while catching up after an host stall.*/
+    if (delay_ns > 0) {
+      uint64_t t = simtest_now_ns();
+
+      while (simtest_now_ns() - t < delay_ns)
+        chThdSleep(1);
+    }
+    latency = simtest_now_ns() - notified_ns;
+    if (latency > max_latency_ns)
+      max_latency_ns = latency;
+    processed++;
+    i2sReleaseBuffer(&I2SD1);
+  }
+  return 0;
+}
+
+/*
+ * Runs a continuous exchange for the specified number of half buffers, the
+ * exchange is stopped anyway after ten times the expected duration.
+ */
+static void run(const I2SConfig *cfg, uint64_t d, uint32_t halves,
+                uint64_t *elapsed, unsigned long *idle) {
+  Thread *tp;
+  uint64_t start;
+
+  memset(tx_buffer, 0, sizeof(tx_buffer));
+  delay_ns = d;
+  processed = 0;
+  callbacks = 0;
+  target = halves;
+  max_latency_ns = 0;
+  chMBReset(&mb);
+  chSemReset(&done, 0);
+  i2sStart(&I2SD1, cfg);
+  tp = chThdCreateStatic(waLoopback, sizeof(waLoopback), NORMALPRIO + 1,
+                         Loopback, NULL);
+  *idle = idle_counter;
+  start = simtest_now_ns();
+  i2sStartExchangeContinuous(&I2SD1);
+  chSemWaitTimeout(&done, MS2ST(TEST_TIME * 10));
+  i2sStopExchange(&I2SD1);
+  *elapsed = simtest_now_ns() - start;
+  *idle = idle_counter - *idle;
+  chThdWait(tp);
+  i2sStop(&I2SD1);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  uint64_t start, elapsed;
+  unsigned long idle;
+  double idle_ns;
+  i2ssample_t *p;
+  size_t n, i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  make_input();
+
+  /*
+   * Idle loop cost.
+   */
+  idle = idle_counter;
+  start = simtest_now_ns();
+  chThdSleepMilliseconds(500);
+  idle_ns = (double)(simtest_now_ns() - start) / (idle_counter - idle);
+
+  /*
+   * Realtime loopback from the input file to the output file.
+   */
+  run(&cfg_rate, 0, TEST_HALVES, &elapsed, &idle);
+  printf("Realtime loopback, %u Hz, %u channels\n", RATE, CHANNELS);
+  printf("  %-38s: %u\n", "Half buffers", processed);
+  printf("  %-38s: %.1f %%\n", "CPU load",
+         100.0 * (1.0 - (idle * idle_ns) / (double)elapsed));
+  printf("  %-38s: %.1f us\n", "Maximum processing latency",
+         max_latency_ns / 1000.0);
+  simtest_check((I2SD1.underruns != 0) || (I2SD1.overruns != 0),
+                "  No underruns or overruns");
+  simtest_check((processed < TEST_HALVES * 9 / 10) ||
+                (processed > (uint32_t)((uint64_t)RATE * elapsed /
+                                        1000000000ULL / HALF_FRAMES + 1)),
+                "  Sample clock");
+  p = read_output(OUTPUT_FILE, 44, &n);
+  simtest_check((p == NULL) || (n != processed * BUFFER_SIZE / 2),
+                "  Output file size");
+  simtest_check(verify_output(p, n), "  Output content");
+  for (i = 0; (i < n) && (p[i] != 8000); i++)
+    ;
+  printf("  %-38s: %u frames, %.2f ms\n", "End to end latency",
+         (unsigned)(i / CHANNELS - IMPULSE_FRAME),
+         (i / CHANNELS - IMPULSE_FRAME) * 1000.0 / RATE);
+  simtest_check(i / CHANNELS - IMPULSE_FRAME != BUFFER_SIZE / CHANNELS,
+                "  Latency of one full buffer");
+  free(p);
+
+  /*
+   * Free running interface, raw output file.
+   */
+  run(&cfg_free, 0, FREE_HALVES, &elapsed, &idle);
+  printf("Free running\n");
+  printf("  %-38s: %.2f Msamples/s\n", "Throughput",
+         (double)processed * (BUFFER_SIZE / 2) * 1000.0 / elapsed);
+  p = read_output(RAW_FILE, 0, &n);
+  simtest_check((p == NULL) || verify_output(p, n), "  Output content");
+  free(p);
+
+  /*
+   * Slow processing, longer than an half buffer period.
+   */
+  run(&cfg_rate, SLOW_TIME * 1000ULL, TEST_HALVES, &elapsed, &idle);
+  printf("Realtime, slow processing\n");
+  printf("  %-38s: %u\n", "Underruns", i2sGetUnderruns(&I2SD1));
+  printf("  %-38s: %u\n", "Overruns", i2sGetOverruns(&I2SD1));
+  simtest_check(i2sGetUnderruns(&I2SD1) == 0, "  Underruns detected");
+  simtest_check(i2sGetOverruns(&I2SD1) != i2sGetUnderruns(&I2SD1),
+                "  Overruns detected");
+  simtest_check(i2sGetUnderruns(&I2SD1) >= callbacks, "  Accounting");
+
+  /*
+   * Single exchange.
+   */
+  chMBReset(&mb);
+  callbacks = 0;
+  target = 0;
+  i2sStart(&I2SD1, &cfg_rate);
+  i2sStartExchange(&I2SD1);
+  chThdSleepMilliseconds(100);
+  simtest_check((I2SD1.state != I2S_READY) || (callbacks != 2),
+                "Single exchange");
+  i2sStop(&I2SD1);
+
+  remove(INPUT_FILE);
+  remove(OUTPUT_FILE);
+  remove(RAW_FILE);
+  return 0;
+}
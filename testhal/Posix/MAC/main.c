@@ -0,0 +1,292 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+#if !MAC_USE_ZERO_COPY
+#error "this demo requires the zero-copy API, see halconf.h"
+#endif
+
+/*
+ * Frames for the integrity and throughput tests.
+ */
+#define N_FRAMES            20000
+#define FRAME_SIZE          1514
+
+/*
+ * Round trips for the latency test.
+ */
+#define N_PINGS             2000
+
+static uint8_t addr1[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static uint8_t addr2[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+static const uint8_t other[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x03};
+static const uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static char wire[64];
+static MACConfig maccfg1 = {addr1, wire, 0};
+static MACConfig maccfg2 = {addr2, wire, 1};
+
+static uint8_t frame[FRAME_SIZE];
+static uint32_t received, corrupted;
+
+static WORKING_AREA(waReceiver, 1024);
+
+/*
+ * Builds a test frame, the sequence number is in the first payload bytes.
+ */
+static size_t build(const uint8_t *dst, uint32_t seq, size_t size) {
+  size_t i;
+
+  memcpy(&frame[0], dst, 6);
+  memcpy(&frame[6], addr1, 6);
+  frame[12] = 0x88;
+  frame[13] = 0xB5;
+  memcpy(&frame[14], &seq, sizeof (seq));
+  for (i = 18; i < size; i++)
+    frame[i] = (uint8_t)(seq + i);
+  return size;
+}
+
+static msg_t send_frame(MACDriver *macp, size_t n, systime_t time) {
+  MACTransmitDescriptor td;
+  msg_t msg;
+
+  msg = macWaitTransmitDescriptor(macp, &td, time);
+  if (msg == RDY_OK) {
+    macWriteTransmitDescriptor(&td, frame, n);
+    macReleaseTransmitDescriptor(&td);
+  }
+  return msg;
+}
+
+/*
+ * Verifies the received frames using the zero-copy API.
+ */
+static msg_t Receiver(void *arg) {
+  MACReceiveDescriptor rd;
+
+  (void)arg;
+  chRegSetThreadName("receiver");
+  while (!chThdShouldTerminate()) {
+    const uint8_t *p;
+    size_t n, i;
+    uint32_t seq;
+
+    if (macWaitReceiveDescriptor(&ETHD2, &rd, MS2ST(10)) != RDY_OK)
+      continue;
+    p = macGetNextReceiveBuffer(&rd, &n);
+    memcpy(&seq, &p[14], sizeof (seq));
+    for (i = 18; i < n; i++)
+      if (p[i] != (uint8_t)(seq + i))
+        break;
+    if ((i != n) || (n != FRAME_SIZE - (seq % 3) * 500))
+      corrupted++;
+    received++;
+    macReleaseReceiveDescriptor(&rd);
+  }
+  return 0;
+}
+
+/*
+ * Echoes the received frames back to the sender using the zero-copy API.
+ */
+static msg_t Echo(void *arg) {
+  MACReceiveDescriptor rd;
+  MACTransmitDescriptor td;
+
+  (void)arg;
+  chRegSetThreadName("echo");
+  while (!chThdShouldTerminate()) {
+    const uint8_t *p;
+    uint8_t *q;
+    size_t n, m;
+
+    if (macWaitReceiveDescriptor(&ETHD2, &rd, MS2ST(10)) != RDY_OK)
+      continue;
+    p = macGetNextReceiveBuffer(&rd, &n);
+    if (macWaitTransmitDescriptor(&ETHD2, &td, MS2ST(10)) == RDY_OK) {
+      q = macGetNextTransmitBuffer(&td, n, &m);
+      memcpy(q, addr1, 6);
+      memcpy(q + 6, addr2, 6);
+      memcpy(q + 12, p + 12, n - 12);
+      macReleaseTransmitDescriptor(&td);
+    }
+    macReleaseReceiveDescriptor(&rd);
+  }
+  return 0;
+}
+
+static unsigned drain(MACDriver *macp) {
+  MACReceiveDescriptor rd;
+  unsigned n = 0;
+
+  while (macWaitReceiveDescriptor(macp, &rd, TIME_IMMEDIATE) == RDY_OK) {
+    macReleaseReceiveDescriptor(&rd);
+    n++;
+  }
+  return n;
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  MACReceiveDescriptor rd;
+  Thread *tp;
+  uint64_t start, elapsed, best;
+  uint32_t i, lost;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  snprintf(wire, sizeof (wire), "/tmp/chibios-mac-%u", (unsigned)getpid());
+
+  /*
+   * Only one endpoint of the wire attached.
+   */
+  macStart(&ETHD1, &maccfg1);
+  simtest_check(macPollLinkStatus(&ETHD1) ||
+                (send_frame(&ETHD1, build(broadcast, 0, 60),
+                            MS2ST(10)) != RDY_TIMEOUT),
+                "Link down without a peer");
+
+  /*
+   * Both endpoints attached.
+   */
+  macStart(&ETHD2, &maccfg2);
+  simtest_check(!macPollLinkStatus(&ETHD1) || !macPollLinkStatus(&ETHD2),
+                "Link up with a peer");
+
+  /*
+   * Destination address filter.
+   */
+  failed = send_frame(&ETHD1, build(other, 0, 60), MS2ST(10)) != RDY_OK;
+  failed |= send_frame(&ETHD1, build(broadcast, 1, 60), MS2ST(10)) != RDY_OK;
+  failed |= send_frame(&ETHD1, build(addr2, 2, 60), MS2ST(10)) != RDY_OK;
+  for (i = 0; i < 2; i++) {
+    uint32_t seq;
+
+    if (macWaitReceiveDescriptor(&ETHD2, &rd, MS2ST(100)) != RDY_OK) {
+      failed = TRUE;
+      break;
+    }
+    macReadReceiveDescriptor(&rd, frame, sizeof (frame));
+    memcpy(&seq, &frame[14], sizeof (seq));
+    if ((seq != i + 1) || (rd.size != 60))
+      failed = TRUE;
+    macReleaseReceiveDescriptor(&rd);
+  }
+  simtest_check(failed || (ETHD2.rxfiltered != 1), "Address filter");
+
+  /*
+   * Receive ring overflow, the frames not fitting in the ring are lost.
+   */
+  for (i = 0; i < 3 * SIM_MAC_RECEIVE_BUFFERS; i++)
+    send_frame(&ETHD1, build(addr2, i, 60), MS2ST(10));
+  chThdSleepMilliseconds(50);
+  i = drain(&ETHD2);
+  simtest_check((i != SIM_MAC_RECEIVE_BUFFERS) ||
+                (ETHD2.rxlost != 2 * SIM_MAC_RECEIVE_BUFFERS),
+                "Receive overflow");
+
+  /*
+   * Throughput, frames of various sizes checked by a receiver thread.
+   */
+  received = corrupted = 0;
+  lost = ETHD2.rxlost;
+  tp = chThdCreateStatic(waReceiver, sizeof(waReceiver), NORMALPRIO + 1,
+                         Receiver, NULL);
+  start = simtest_now_ns();
+  failed = FALSE;
+  for (i = 0; i < N_FRAMES; i++)
+    if (send_frame(&ETHD1, build(addr2, i, FRAME_SIZE - (i % 3) * 500),
+             MS2ST(100)) != RDY_OK)
+      failed = TRUE;
+  while ((received + ETHD2.rxlost - lost < N_FRAMES) &&
+         (simtest_now_ns() - start < 5000000000ULL))
+    chThdSleepMilliseconds(1);
+  elapsed = simtest_now_ns() - start;
+  chThdTerminate(tp);
+  chThdWait(tp);
+  lost = ETHD2.rxlost - lost;
+  printf("Throughput\n");
+  printf("  %-38s: %u\n", "Frames received", received);
+  printf("  %-38s: %u\n", "Frames lost", lost);
+  printf("  %-38s: %u Mbit/s\n", "Payload rate",
+         (unsigned)(((uint64_t)received * (FRAME_SIZE - 500) * 8000) /
+                    elapsed));
+  simtest_check(failed || corrupted || (received + lost != N_FRAMES), "  Data");
+
+  /*
+   * Round trip latency through an echo thread.
+   */
+  drain(&ETHD1);
+  tp = chThdCreateStatic(waReceiver, sizeof(waReceiver), NORMALPRIO + 1,
+                         Echo, NULL);
+  failed = FALSE;
+  elapsed = 0;
+  best = ~0ULL;
+  for (i = 0; i < N_PINGS; i++) {
+    uint64_t t = simtest_now_ns();
+    uint32_t seq;
+
+    send_frame(&ETHD1, build(addr2, i, 64), MS2ST(10));
+    if (macWaitReceiveDescriptor(&ETHD1, &rd, MS2ST(100)) != RDY_OK) {
+      failed = TRUE;
+      break;
+    }
+    t = simtest_now_ns() - t;
+    elapsed += t;
+    if (t < best)
+      best = t;
+    macReadReceiveDescriptor(&rd, frame, sizeof (frame));
+    memcpy(&seq, &frame[14], sizeof (seq));
+    if ((seq != i) || (memcmp(frame, addr1, 6) != 0))
+      failed = TRUE;
+    macReleaseReceiveDescriptor(&rd);
+  }
+  chThdTerminate(tp);
+  chThdWait(tp);
+  printf("Latency\n");
+  printf("  %-38s: %u us\n", "Average round trip",
+         (unsigned)(elapsed / N_PINGS / 1000));
+  printf("  %-38s: %u us\n", "Best round trip", (unsigned)(best / 1000));
+  simtest_check(failed, "  Echoed frames");
+
+  /*
+   * Peer detached, the link goes down.
+   */
+  macStop(&ETHD2);
+  simtest_check(macPollLinkStatus(&ETHD1), "Link down after the peer stopped");
+  macStop(&ETHD1);
+
+  return 0;
+}
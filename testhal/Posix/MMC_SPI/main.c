@@ -0,0 +1,222 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simsdc.h"
+#include "simtest.h"
+
+/*
+ * Image file used as card content and its size.
+ */
+#define IMAGE_NAME          "sdcard.img"
+#define IMAGE_SIZE          (8 * 1024 * 1024)
+
+/*
+ * Blocks transferred in each operation of the throughput test.
+ */
+#define BENCH_BLOCKS        8
+
+/*
+ * Duration of each throughput test.
+ */
+#define BENCH_TIME          MS2ST(1000)
+
+static SimSDCard sdc;
+
+/*
+ * Both configurations select the simulated card.
+ */
+static const SPIConfig hs_spicfg = {NULL, (SPISlaveModel *)&sdc};
+static const SPIConfig ls_spicfg = {NULL, (SPISlaveModel *)&sdc};
+
+static const MMCConfig mmccfg = {&SPID1, &ls_spicfg, &hs_spicfg};
+
+static MMCDriver MMCD1;
+
+static uint8_t txbuf[MMCSD_BLOCK_SIZE * BENCH_BLOCKS];
+static uint8_t rxbuf[MMCSD_BLOCK_SIZE * BENCH_BLOCKS];
+
+static void fill(uint8_t *p, size_t n, uint32_t seed) {
+
+  while (n--) {
+    seed = seed * 1103515245 + 12345;
+    *p++ = (uint8_t)(seed >> 16);
+  }
+}
+
+/*
+ * The card image is closed before exiting on a failed check.
+ */
+static void check(bool_t failed, const char *msg) {
+
+  if (failed)
+    simsdcClose(&sdc);
+  simtest_check(failed, msg);
+}
+
+static unsigned cb_count;
+static const uint8_t *cb_last;
+
+static void read_cb(MMCDriver *mmcp, const uint8_t *buffer) {
+
+  (void)mmcp;
+  cb_count++;
+  cb_last = buffer;
+}
+
+/*
+ * Reads the blocks one at time using the non-pipelined API.
+ */
+static bool_t read_single(uint32_t startblk, uint8_t *buffer, uint32_t n) {
+
+  if (mmcStartSequentialRead(&MMCD1, startblk))
+    return CH_FAILED;
+  while (n-- > 0) {
+    if (mmcSequentialRead(&MMCD1, buffer))
+      return CH_FAILED;
+    buffer += MMCSD_BLOCK_SIZE;
+  }
+  return mmcStopSequentialRead(&MMCD1);
+}
+
+static void bench(const char *msg, int mode) {
+  uint32_t blk = 0, n = 0;
+  systime_t start;
+
+  start = chTimeNow();
+  while (chTimeElapsedSince(start) < BENCH_TIME) {
+    bool_t err;
+
+    switch (mode) {
+    case 0:
+      err = blkWrite(&MMCD1, blk, txbuf, BENCH_BLOCKS);
+      break;
+    case 1:
+      err = blkRead(&MMCD1, blk, rxbuf, BENCH_BLOCKS);
+      break;
+    default:
+      err = read_single(blk, rxbuf, BENCH_BLOCKS);
+    }
+    if (err)
+      check(TRUE, msg);
+    blk = (blk + BENCH_BLOCKS) % MMCD1.capacity;
+    n += BENCH_BLOCKS;
+  }
+  printf("%-40s: %u kB/s\n", msg, (unsigned)(n * MMCSD_BLOCK_SIZE / 1024));
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  FILE *f;
+  unsigned i;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  /*
+   * Creating a blank image and inserting the card.
+   */
+  f = fopen(IMAGE_NAME, "wb");
+  check((f == NULL) || (ftruncate(fileno(f), IMAGE_SIZE) != 0),
+        "Image creation");
+  fclose(f);
+  simsdcObjectInit(&sdc);
+  check(simsdcOpen(&sdc, IMAGE_NAME), "Card insertion");
+
+  /*
+   * Connection and card identification.
+   */
+  mmcObjectInit(&MMCD1);
+  mmcStart(&MMCD1, &mmccfg);
+  check(mmcConnect(&MMCD1), "Connection");
+  check(!MMCD1.block_addresses, "High capacity card detection");
+#if MMC_USE_CRC
+  check(!sdc.crc_enabled, "Card CRC checks enabled");
+#endif
+  check(MMCD1.capacity != IMAGE_SIZE / MMCSD_BLOCK_SIZE, "Card capacity");
+
+  /*
+   * Single and multiple blocks transfers.
+   */
+  fill(txbuf, MMCSD_BLOCK_SIZE, 1);
+  check(blkWrite(&MMCD1, 3, txbuf, 1), "Single block write");
+  check(blkRead(&MMCD1, 3, rxbuf, 1), "Single block read");
+  check(memcmp(txbuf, rxbuf, MMCSD_BLOCK_SIZE) != 0, "Single block compare");
+
+  fill(txbuf, sizeof(txbuf), 2);
+  check(blkWrite(&MMCD1, MMCD1.capacity - BENCH_BLOCKS, txbuf, BENCH_BLOCKS),
+        "Multiple blocks write");
+  check(blkRead(&MMCD1, MMCD1.capacity - BENCH_BLOCKS, rxbuf, BENCH_BLOCKS),
+        "Multiple blocks read");
+  check(memcmp(txbuf, rxbuf, sizeof(txbuf)) != 0, "Multiple blocks compare");
+  memset(rxbuf, 0, sizeof(rxbuf));
+  check(read_single(MMCD1.capacity - BENCH_BLOCKS, rxbuf, BENCH_BLOCKS),
+        "Block by block read");
+  check(memcmp(txbuf, rxbuf, sizeof(txbuf)) != 0, "Block by block compare");
+  memset(rxbuf, 0, sizeof(rxbuf));
+  check(mmcStartSequentialRead(&MMCD1, MMCD1.capacity - BENCH_BLOCKS) ||
+        mmcSequentialReadBlocks(&MMCD1, rxbuf, BENCH_BLOCKS, read_cb) ||
+        mmcStopSequentialRead(&MMCD1), "Pipelined read with callback");
+  check((cb_count != BENCH_BLOCKS) ||
+        (cb_last != &rxbuf[MMCSD_BLOCK_SIZE * (BENCH_BLOCKS - 1)]),
+        "Callback invocations");
+  check(memcmp(txbuf, rxbuf, sizeof(txbuf)) != 0, "Pipelined read compare");
+  check(blkRead(&MMCD1, MMCD1.capacity, rxbuf, 1) == CH_SUCCESS,
+        "Out of range read rejected");
+
+  /*
+   * Erase.
+   */
+  check(mmcErase(&MMCD1, MMCD1.capacity - BENCH_BLOCKS, MMCD1.capacity - 1),
+        "Erase");
+  check(blkRead(&MMCD1, MMCD1.capacity - BENCH_BLOCKS, rxbuf, BENCH_BLOCKS),
+        "Erased blocks read");
+  for (i = 0; i < sizeof(rxbuf); i++)
+    if (rxbuf[i] != 0)
+      break;
+  check(i < sizeof(rxbuf), "Erased blocks compare");
+
+  /*
+   * Throughput.
+   */
+  bench("Sequential write, 8 blocks per operation", 0);
+  bench("Sequential read, 8 blocks per operation", 1);
+  bench("Block by block read, 8 blocks", 2);
+  printf("%-40s: %u\n", "Blocks read by the card",
+         (unsigned)sdc.blocks_read);
+  printf("%-40s: %u\n", "Blocks written by the card",
+         (unsigned)sdc.blocks_written);
+  check(sdc.crc_errors != 0, "CRC errors");
+
+  check(mmcDisconnect(&MMCD1), "Disconnection");
+  mmcStop(&MMCD1);
+  simsdcClose(&sdc);
+  return 0;
+}
@@ -0,0 +1,234 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "simtest.h"
+
+/*
+ * Bytes transferred by the throughput test.
+ */
+#define BENCH_SIZE          (64 * 1024)
+
+/*
+ * Round trips performed by the latency test.
+ */
+#define LATENCY_LOOPS       200
+
+/*
+ * Incremented by the idle thread, see IDLE_LOOP_HOOK in chconf.h.
+ */
+volatile unsigned long idle_counter;
+
+static SerialUARTDriver SDUART1;
+
+/*
+ * The driver callbacks are replaced by the serial over UART ones.
+ */
+static const UARTConfig uart_cfg = {NULL, NULL, NULL, NULL, NULL};
+
+static const SerialUARTConfig sduart_cfg = {&UARTD1, &uart_cfg, MS2ST(1)};
+
+static uint8_t txbuf[BENCH_SIZE];
+static uint8_t rxbuf[BENCH_SIZE];
+
+/* Idle loop cost in nanoseconds, measured without traffic.*/
+static double idle_ns;
+
+/*
+ * Echo peer, it runs in a child process and echoes back everything
+ * received on both the simulated lines.
+ */
+static int peer_connect(uint16_t port) {
+  struct sockaddr_in sad;
+  int s;
+
+  memset(&sad, 0, sizeof(sad));
+  sad.sin_family = AF_INET;
+  sad.sin_addr.s_addr = inet_addr("127.0.0.1");
+  sad.sin_port = htons(port);
+  while (TRUE) {
+    s = socket(PF_INET, SOCK_STREAM, 0);
+    if (connect(s, (struct sockaddr *)&sad, sizeof(sad)) == 0)
+      return s;
+    close(s);
+    usleep(10000);
+  }
+}
+
+static void peer(void) {
+  struct pollfd fds[2];
+  uint8_t buf[4096];
+  int i;
+
+  fds[0].fd = peer_connect(SIM_SD1_PORT);
+  fds[1].fd = peer_connect(SIM_UART1_PORT);
+  fds[0].events = fds[1].events = POLLIN;
+  while (poll(fds, 2, -1) > 0) {
+    for (i = 0; i < 2; i++) {
+      if (fds[i].revents) {
+        ssize_t n = recv(fds[i].fd, buf, sizeof(buf), 0), k = 0;
+        if (n <= 0)
+          exit(0);
+        while (k < n) {
+          ssize_t w = send(fds[i].fd, buf + k, n - k, 0);
+          if (w <= 0)
+            exit(0);
+          k += w;
+        }
+      }
+    }
+  }
+  exit(0);
+}
+
+/*
+ * Writer thread for the throughput test.
+ */
+static WORKING_AREA(waWriter, 2048);
+static msg_t Writer(void *arg) {
+
+  chnWrite((BaseChannel *)arg, txbuf, BENCH_SIZE);
+  return 0;
+}
+
+static bool_t echo(BaseChannel *chp, size_t n) {
+
+  memset(rxbuf, 0, n);
+  if (chnWriteTimeout(chp, txbuf, n, MS2ST(1000)) != n)
+    return TRUE;
+  if (chnReadTimeout(chp, rxbuf, n, MS2ST(1000)) != n)
+    return TRUE;
+  return memcmp(txbuf, rxbuf, n) != 0;
+}
+
+static void bench(const char *name, BaseChannel *chp) {
+  uint64_t start, elapsed, rtt = 0;
+  unsigned long idle;
+  Thread *tp;
+  unsigned i;
+
+  /* Latency, single bytes round trips.*/
+  for (i = 0; i < LATENCY_LOOPS; i++) {
+    start = simtest_now_ns();
+    chnPutTimeout(chp, (uint8_t)i, MS2ST(100));
+    if (chnGetTimeout(chp, MS2ST(100)) != (uint8_t)i)
+      simtest_check(TRUE, name);
+    rtt += simtest_now_ns() - start;
+  }
+
+  /* Throughput and CPU time per byte, the CPU time is the part of the
+     elapsed time not spent in the idle loop.*/
+  idle = idle_counter;
+  start = simtest_now_ns();
+  tp = chThdCreateStatic(waWriter, sizeof(waWriter), NORMALPRIO + 1,
+                         Writer, chp);
+  if (chnReadTimeout(chp, rxbuf, BENCH_SIZE, S2ST(30)) != BENCH_SIZE)
+    simtest_check(TRUE, name);
+  chThdWait(tp);
+  elapsed = simtest_now_ns() - start;
+  idle = idle_counter - idle;
+
+  printf("%s\n", name);
+  printf("  %-38s: %.1f us\n", "Round trip latency",
+         (double)rtt / LATENCY_LOOPS / 1000.0);
+  printf("  %-38s: %.0f kB/s\n", "Echo throughput",
+         (double)BENCH_SIZE * 1000000000.0 / elapsed / 1024.0);
+  printf("  %-38s: %.1f ns\n", "CPU time per byte",
+         ((double)elapsed - idle * idle_ns) / (2.0 * BENCH_SIZE));
+  simtest_check(memcmp(txbuf, rxbuf, BENCH_SIZE) != 0, "  Data compare");
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  uint64_t start;
+  unsigned long idle;
+  pid_t pid;
+  unsigned i;
+
+  /*
+   * The echo peer process.
+   */
+  signal(SIGPIPE, SIG_IGN);
+  if ((pid = fork()) == 0)
+    peer();
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  for (i = 0; i < BENCH_SIZE; i++)
+    txbuf[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  /*
+   * Activates the serial driver and the serial over UART driver, then
+   * waits for the peer connections.
+   */
+  sdStart(&SD1, NULL);
+  sduartObjectInit(&SDUART1);
+  sduartStart(&SDUART1, &sduart_cfg);
+  start = simtest_now_ns();
+  while ((SD1.com_data == INVALID_SOCKET) ||
+         (UARTD1.com_data == INVALID_SOCKET)) {
+    if (simtest_now_ns() - start > 5000000000ULL)
+      simtest_check(TRUE, "Peer connection");
+    chThdSleepMilliseconds(10);
+  }
+  simtest_check(FALSE, "Peer connection");
+
+  /*
+   * Functional checks on the serial over UART driver.
+   */
+  simtest_check(echo((BaseChannel *)&SDUART1, 3), "Short message, idle flush");
+  simtest_check(echo((BaseChannel *)&SDUART1, SERIAL_UART_RX_CHUNK_SIZE * 2),
+                "Double buffer exact fill");
+  simtest_check(echo((BaseChannel *)&SDUART1, 1000), "Long message");
+  simtest_check(echo((BaseChannel *)&SD1, 1000), "Serial driver long message");
+
+  /*
+   * Idle loop cost.
+   */
+  idle = idle_counter;
+  start = simtest_now_ns();
+  chThdSleepMilliseconds(500);
+  idle_ns = (double)(simtest_now_ns() - start) / (idle_counter - idle);
+  printf("%-40s: %.1f ns\n\n", "Idle loop iteration", idle_ns);
+
+  bench("Serial driver (interrupt per byte)", (BaseChannel *)&SD1);
+  bench("Serial over UART driver", (BaseChannel *)&SDUART1);
+
+  sduartStop(&SDUART1);
+  sdStop(&SD1);
+  kill(pid, SIGTERM);
+  return 0;
+}
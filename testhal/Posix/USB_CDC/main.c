@@ -0,0 +1,402 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "usbcfg.h"
+#include "simtest.h"
+
+/*
+ * Round trips of the echo test.
+ */
+#define ECHO_ROUNDS         1000
+
+/*
+ * Bytes moved by the throughput tests.
+ */
+#define TOTAL_SIZE          (4 * 1024 * 1024)
+
+/*
+ * Host transfers size in the throughput tests.
+ */
+#define HOST_TRANSFER_SIZE  16384
+
+/*
+ * Device side writes and reads size in the throughput tests.
+ */
+#define DEVICE_CHUNK_SIZE   512
+
+/*
+ * Standard and class requests used by the host.
+ */
+#define RT_DEV_IN           (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+#define RT_DEV_OUT          (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+#define RT_EP_IN            (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_ENDPOINT)
+#define RT_EP_OUT           (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_ENDPOINT)
+#define RT_CLASS_IN         (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_CLASS | \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_CLASS_OUT        (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_CLASS | \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_VENDOR_IN        (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_VENDOR | \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+
+SerialUSBDriver SDU1;
+
+static WORKING_AREA(waDevice, 4096);
+
+static uint8_t hostbuf[HOST_TRANSFER_SIZE];
+static bool_t corrupted;
+
+/*
+ * Pattern of the data moved by the throughput tests.
+ */
+static uint8_t pattern(uint32_t i) {
+
+  return (uint8_t)(i + (i >> 8) + (i >> 16));
+}
+
+/*
+ * Host control transfer.
+ */
+static msg_t control(uint8_t rtype, uint8_t req, uint16_t value,
+                     uint16_t index, uint16_t length, uint8_t *buf,
+                     size_t *np) {
+  uint8_t setup[8];
+
+  setup[0] = rtype;
+  setup[1] = req;
+  setup[2] = (uint8_t)value;
+  setup[3] = (uint8_t)(value >> 8);
+  setup[4] = (uint8_t)index;
+  setup[5] = (uint8_t)(index >> 8);
+  setup[6] = (uint8_t)length;
+  setup[7] = (uint8_t)(length >> 8);
+  return usbSimHostControl(&USBD1, setup, buf, np, MS2ST(100));
+}
+
+/*
+ * Device side echo of single bytes.
+ */
+static msg_t echo_thread(void *arg) {
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < ECHO_ROUNDS; i++) {
+    msg_t b = chnGetTimeout(&SDU1, MS2ST(1000));
+
+    if (b < Q_OK)
+      return b;
+    chnPutTimeout(&SDU1, (uint8_t)b, MS2ST(1000));
+  }
+  return RDY_OK;
+}
+
+/*
+ * Device side writer of the throughput test data.
+ */
+static msg_t writer_thread(void *arg) {
+  static uint8_t buf[DEVICE_CHUNK_SIZE];
+  uint32_t i, j;
+
+  (void)arg;
+  for (i = 0; i < TOTAL_SIZE; i += DEVICE_CHUNK_SIZE) {
+    for (j = 0; j < DEVICE_CHUNK_SIZE; j++)
+      buf[j] = pattern(i + j);
+    if (chnWriteTimeout(&SDU1, buf, DEVICE_CHUNK_SIZE,
+                        MS2ST(1000)) != DEVICE_CHUNK_SIZE)
+      return RDY_TIMEOUT;
+  }
+  return RDY_OK;
+}
+
+/*
+ * Device side reader of the throughput test data.
+ */
+static msg_t reader_thread(void *arg) {
+  static uint8_t buf[DEVICE_CHUNK_SIZE];
+  uint32_t i = 0, j;
+
+  (void)arg;
+  while (i < TOTAL_SIZE) {
+    size_t n = chnReadTimeout(&SDU1, buf, DEVICE_CHUNK_SIZE, MS2ST(1000));
+
+    if (n == 0)
+      return RDY_TIMEOUT;
+    for (j = 0; j < n; j++)
+      if (buf[j] != pattern(i + j))
+        corrupted = TRUE;
+    i += n;
+  }
+  return RDY_OK;
+}
+
+static void report(const char *name, uint64_t elapsed, uint64_t bytes,
+                   const USBSimStats *s0, const USBSimStats *s1) {
+  uint64_t busy = (uint64_t)(s1->frames - s0->frames) * USB_SIM_FRAME_NS;
+
+  printf("%s\n", name);
+  printf("  %-38s: %u\n", "Frames", s1->frames - s0->frames);
+  printf("  %-38s: %u\n", "Packets", s1->packets - s0->packets);
+  printf("  %-38s: %u\n", "NAKed transactions", s1->naks - s0->naks);
+  printf("  %-38s: %.1f us\n", "Simulated bus time",
+         (double)busy / 1000.0);
+  if (bytes > 0) {
+    printf("  %-38s: %.2f MB/s\n", "Simulated bus throughput",
+           (double)bytes * 1000.0 / busy);
+    printf("  %-38s: %.2f MB/s\n", "Host throughput",
+           (double)bytes * 1000.0 / elapsed);
+  }
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static const uint8_t linecoding[7] = {0x00, 0xC2, 0x01, 0x00, 0, 0, 8};
+  uint8_t buf[256];
+  USBSimStats s0, s1;
+  Thread *tp;
+  uint64_t start, elapsed;
+  uint32_t i, received;
+  size_t n;
+  msg_t msg;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  printf("Simulated bus speed                     : %s\n",
+         USB_SIM_HIGH_SPEED ? "high" : "full");
+  printf("Linear transfers                        : %s\n",
+         SERIAL_USB_USE_LINEAR_TRANSFERS ? "yes" : "no");
+
+  /*
+   * Device side, Serial over USB on a disconnected bus.
+   */
+  sduObjectInit(&SDU1);
+  sduStart(&SDU1, &serusbcfg);
+  usbStart(&USBD1, &usbcfg);
+  simtest_check(usbSimHostReset(&USBD1) != RDY_RESET,
+                "Reset of a disconnected device");
+  usbConnectBus(&USBD1);
+  simtest_check(usbSimHostReset(&USBD1) != RDY_OK, "Bus reset");
+
+  /*
+   * Enumeration.
+   */
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                USB_DESCRIPTOR_DEVICE << 8, 0, 64, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != vcom_device_descriptor.ud_size) ||
+                (memcmp(buf, vcom_device_descriptor.ud_string, n) != 0),
+                "Device descriptor");
+  msg = control(RT_DEV_OUT, USB_REQ_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+  simtest_check((msg != RDY_OK) || (USBD1.address != 5) ||
+                (USBD1.state != USB_SELECTED), "Address");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                USB_DESCRIPTOR_CONFIGURATION << 8, 0, 9, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 9) ||
+                ((size_t)usbFetchWord(&buf[2]) !=
+                 vcom_configuration_descriptor.ud_size),
+                "Configuration descriptor header");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                USB_DESCRIPTOR_CONFIGURATION << 8, 0, 255, buf, &n);
+  simtest_check((msg != RDY_OK) ||
+                (n != vcom_configuration_descriptor.ud_size) ||
+                (memcmp(buf, vcom_configuration_descriptor.ud_string, n) != 0),
+                "Configuration descriptor, two packets");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                (USB_DESCRIPTOR_STRING << 8) | 2, 0x0409, 255, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 56) || (buf[0] != 56) ||
+                (buf[2] != 'C'), "String descriptor");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                (USB_DESCRIPTOR_STRING << 8) | 9, 0x0409, 255, buf, &n);
+  simtest_check(msg != RDY_RESET, "Missing descriptor stalled");
+  msg = control(RT_VENDOR_IN, 0x01, 0, 0, 4, buf, &n);
+  simtest_check(msg != RDY_RESET, "Unknown request stalled");
+  msg = control(RT_DEV_IN, USB_REQ_GET_STATUS, 0, 0, 2, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 2), "Setup after a stall");
+  n = sizeof (buf);
+  msg = usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n, MS2ST(100));
+  simtest_check(msg != RDY_RESET, "Data endpoint not configured");
+  msg = control(RT_DEV_OUT, USB_REQ_SET_CONFIGURATION, 1, 0, 0, NULL, NULL);
+  simtest_check((msg != RDY_OK) || (USBD1.state != USB_ACTIVE),
+                "Configuration");
+  msg = control(RT_DEV_IN, USB_REQ_GET_CONFIGURATION, 0, 0, 1, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 1) || (buf[0] != 1),
+                "Get configuration");
+
+  /*
+   * CDC class requests.
+   */
+  memcpy(buf, linecoding, sizeof (linecoding));
+  failed = control(RT_CLASS_OUT, CDC_SET_LINE_CODING, 0, 0,
+                   sizeof (linecoding), buf, &n) != RDY_OK;
+  memset(buf, 0, sizeof (linecoding));
+  failed |= control(RT_CLASS_IN, CDC_GET_LINE_CODING, 0, 0,
+                    sizeof (linecoding), buf, &n) != RDY_OK;
+  failed |= control(RT_CLASS_OUT, CDC_SET_CONTROL_LINE_STATE, 3, 0, 0,
+                    NULL, NULL) != RDY_OK;
+  simtest_check(failed || (memcmp(buf, linecoding, sizeof (linecoding)) != 0),
+                "Line coding");
+
+  /*
+   * Endpoint halt, the data transfers fail until the halt is cleared.
+   */
+  failed = control(RT_EP_OUT, USB_REQ_SET_FEATURE, USB_FEATURE_ENDPOINT_HALT,
+                   USB_CDC_DATA_REQUEST_EP | 0x80, 0, NULL, NULL) != RDY_OK;
+  n = sizeof (buf);
+  failed |= usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n,
+                         MS2ST(100)) != RDY_RESET;
+  failed |= control(RT_EP_IN, USB_REQ_GET_STATUS, 0,
+                    USB_CDC_DATA_REQUEST_EP | 0x80, 2, buf, &n) != RDY_OK;
+  failed |= buf[0] != 1;
+  failed |= control(RT_EP_OUT, USB_REQ_CLEAR_FEATURE,
+                    USB_FEATURE_ENDPOINT_HALT,
+                    USB_CDC_DATA_REQUEST_EP | 0x80, 0, NULL, NULL) != RDY_OK;
+  failed |= control(RT_EP_IN, USB_REQ_GET_STATUS, 0,
+                    USB_CDC_DATA_REQUEST_EP | 0x80, 2, buf, &n) != RDY_OK;
+  simtest_check(failed || (buf[0] != 0), "Endpoint halt");
+
+  /*
+   * Babble, a packet larger than the host buffer fails the transfer and
+   * only the bytes fitting the buffer are reported.
+   */
+  usbSimGetBusStats(&USBD1, &s0);
+  failed = chnWriteTimeout(&SDU1, (const uint8_t *)"babble", 6,
+                           TIME_IMMEDIATE) != 6;
+  n = 4;
+  failed |= usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n,
+                         MS2ST(100)) != RDY_RESET;
+  usbSimGetBusStats(&USBD1, &s1);
+  simtest_check(failed || (n != 4) || (memcmp(buf, "babb", 4) != 0) ||
+                (s1.babbles != s0.babbles + 1), "Babble");
+
+  /*
+   * Echo latency, one byte sent and received back.
+   */
+  tp = chThdCreateStatic(waDevice, sizeof(waDevice), NORMALPRIO + 1,
+                         echo_thread, NULL);
+  failed = FALSE;
+  usbSimGetBusStats(&USBD1, &s0);
+  start = simtest_now_ns();
+  for (i = 0; i < ECHO_ROUNDS; i++) {
+    uint8_t b = (uint8_t)i;
+
+    n = 1;
+    failed |= usbSimHostOut(&USBD1, USB_CDC_DATA_AVAILABLE_EP, &b, &n,
+                            MS2ST(100)) != RDY_OK;
+    n = sizeof (buf);
+    failed |= usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n,
+                           MS2ST(100)) != RDY_OK;
+    failed |= (n != 1) || (buf[0] != (uint8_t)i);
+  }
+  elapsed = simtest_now_ns() - start;
+  usbSimGetBusStats(&USBD1, &s1);
+  failed |= chThdWait(tp) != RDY_OK;
+  report("Echo", elapsed, 0, &s0, &s1);
+  printf("  %-38s: %.2f frames\n", "Round trip",
+         (double)(s1.frames - s0.frames) / ECHO_ROUNDS);
+  printf("  %-38s: %.2f us\n", "Host time per round trip",
+         (double)elapsed / 1000.0 / ECHO_ROUNDS);
+  simtest_check(failed, "  Echoed data");
+
+  /*
+   * Device to host throughput.
+   */
+  tp = chThdCreateStatic(waDevice, sizeof(waDevice), NORMALPRIO + 1,
+                         writer_thread, NULL);
+  failed = FALSE;
+  received = 0;
+  usbSimGetBusStats(&USBD1, &s0);
+  start = simtest_now_ns();
+  while (received < TOTAL_SIZE) {
+    n = TOTAL_SIZE - received;
+    if (n > HOST_TRANSFER_SIZE)
+      n = HOST_TRANSFER_SIZE;
+    if (usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, hostbuf, &n,
+                     MS2ST(1000)) != RDY_OK) {
+      failed = TRUE;
+      break;
+    }
+    for (i = 0; i < n; i++)
+      if (hostbuf[i] != pattern(received + i))
+        failed = TRUE;
+    received += n;
+  }
+  elapsed = simtest_now_ns() - start;
+  usbSimGetBusStats(&USBD1, &s1);
+  failed |= chThdWait(tp) != RDY_OK;
+  report("Device to host", elapsed, received, &s0, &s1);
+  simtest_check(failed, "  Received data");
+
+  /* A zero sized packet may terminate the last transfer.*/
+  n = sizeof (buf);
+  msg = usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n, MS2ST(10));
+  simtest_check(n != 0, "  No trailing data");
+
+  /*
+   * Host to device throughput.
+   */
+  tp = chThdCreateStatic(waDevice, sizeof(waDevice), NORMALPRIO + 1,
+                         reader_thread, NULL);
+  failed = FALSE;
+  usbSimGetBusStats(&USBD1, &s0);
+  start = simtest_now_ns();
+  for (i = 0; i < TOTAL_SIZE; i += HOST_TRANSFER_SIZE) {
+    uint32_t j;
+
+    for (j = 0; j < HOST_TRANSFER_SIZE; j++)
+      hostbuf[j] = pattern(i + j);
+    n = HOST_TRANSFER_SIZE;
+    if (usbSimHostOut(&USBD1, USB_CDC_DATA_AVAILABLE_EP, hostbuf, &n,
+                      MS2ST(1000)) != RDY_OK) {
+      failed = TRUE;
+      break;
+    }
+  }
+  failed |= chThdWait(tp) != RDY_OK;
+  elapsed = simtest_now_ns() - start;
+  usbSimGetBusStats(&USBD1, &s1);
+  report("Host to device", elapsed, TOTAL_SIZE, &s0, &s1);
+  simtest_check(failed || corrupted, "  Sent data");
+
+  /*
+   * Disconnection, the pending transfers fail.
+   */
+  usbDisconnectBus(&USBD1);
+  n = sizeof (buf);
+  simtest_check(usbSimHostIn(&USBD1, USB_CDC_DATA_REQUEST_EP, buf, &n,
+                             MS2ST(100)) != RDY_RESET, "Disconnection");
+
+  usbStop(&USBD1);
+  sduStop(&SDU1);
+  return 0;
+}
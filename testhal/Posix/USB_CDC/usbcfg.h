@@ -0,0 +1,39 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _USBCFG_H_
+#define _USBCFG_H_
+
+/*
+ * Endpoints, the bulk endpoints size depends on the simulated bus speed.
+ */
+#define USB_CDC_DATA_REQUEST_EP         1
+#define USB_CDC_DATA_AVAILABLE_EP       1
+#define USB_CDC_INTERRUPT_REQUEST_EP    2
+
+#if USB_SIM_HIGH_SPEED
+#define USB_CDC_PACKET_SIZE             512
+#else
+#define USB_CDC_PACKET_SIZE             64
+#endif
+
+extern SerialUSBDriver SDU1;
+extern const USBConfig usbcfg;
+extern const SerialUSBConfig serusbcfg;
+extern const USBDescriptor vcom_device_descriptor;
+extern const USBDescriptor vcom_configuration_descriptor;
+
+#endif  /* _USBCFG_H_ */
@@ -0,0 +1,339 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+
+#include "usbcfg.h"
+#include "simtest.h"
+
+/*
+ * Rounds of the concurrent functions test.
+ */
+#define ROUNDS              200
+
+/*
+ * Bytes echoed by the CDC function in each round.
+ */
+#define ECHO_SIZE           100
+
+/*
+ * Bytes looped back by the vendor function in each round, not a multiple
+ * of the packet size so the transfers are terminated by a short packet.
+ */
+#define LOOPBACK_SIZE       1000
+
+/*
+ * Standard, class and vendor requests used by the host.
+ */
+#define RT_DEV_IN           (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+#define RT_DEV_OUT          (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+#define RT_IF_IN            (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_IF_OUT           (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_STD |   \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_CLASS_IN         (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_CLASS | \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_CLASS_OUT        (USB_RTYPE_DIR_HOST2DEV | USB_RTYPE_TYPE_CLASS | \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_VENDOR_IN        (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_VENDOR | \
+                             USB_RTYPE_RECIPIENT_DEVICE)
+#define RT_VENDOR_IF_IN     (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_VENDOR | \
+                             USB_RTYPE_RECIPIENT_INTERFACE)
+#define RT_VENDOR_EP_IN     (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_VENDOR | \
+                             USB_RTYPE_RECIPIENT_ENDPOINT)
+
+static WORKING_AREA(waEcho, 4096);
+
+/*
+ * Host control transfer.
+ */
+static msg_t control(uint8_t rtype, uint8_t req, uint16_t value,
+                     uint16_t index, uint16_t length, uint8_t *buf,
+                     size_t *np) {
+  uint8_t setup[8];
+
+  setup[0] = rtype;
+  setup[1] = req;
+  setup[2] = (uint8_t)value;
+  setup[3] = (uint8_t)(value >> 8);
+  setup[4] = (uint8_t)index;
+  setup[5] = (uint8_t)(index >> 8);
+  setup[6] = (uint8_t)length;
+  setup[7] = (uint8_t)(length >> 8);
+  return usbSimHostControl(&USBD1, setup, buf, np, MS2ST(100));
+}
+
+/*
+ * Host side enumeration.
+ */
+static bool_t enumerate(void) {
+  bool_t failed;
+
+  failed = usbSimHostReset(&USBD1) != RDY_OK;
+  failed |= control(RT_DEV_OUT, USB_REQ_SET_ADDRESS, 7, 0, 0,
+                    NULL, NULL) != RDY_OK;
+  failed |= control(RT_DEV_OUT, USB_REQ_SET_CONFIGURATION, 1, 0, 0,
+                    NULL, NULL) != RDY_OK;
+  return failed || (USBD1.state != USB_ACTIVE);
+}
+
+/*
+ * Reads the loopback transfers counter using the interface or the
+ * endpoint as recipient.
+ */
+static bool_t loopback_count(bool_t endpoint, uint32_t *countp) {
+  size_t n;
+
+  if (control(endpoint ? RT_VENDOR_EP_IN : RT_VENDOR_IF_IN,
+              LOOPBACK_GET_COUNT, 0,
+              endpoint ? USB_LOOPBACK_EP | 0x80 : USB_LOOPBACK_INTERFACE,
+              4, (uint8_t *)countp, &n) != RDY_OK)
+    return TRUE;
+  return n != 4;
+}
+
+/*
+ * Pattern of the data moved by the functions.
+ */
+static uint8_t pattern(uint32_t i) {
+
+  return (uint8_t)(i * 7 + (i >> 8));
+}
+
+/*
+ * Device side echo on the Serial over USB driver.
+ */
+static msg_t echo_thread(void *arg) {
+  static uint8_t buf[ECHO_SIZE];
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < ROUNDS; i++) {
+    if (chnReadTimeout(&SDU1, buf, ECHO_SIZE, MS2ST(1000)) != ECHO_SIZE)
+      return RDY_TIMEOUT;
+    if (chnWriteTimeout(&SDU1, buf, ECHO_SIZE, MS2ST(1000)) != ECHO_SIZE)
+      return RDY_TIMEOUT;
+  }
+  return RDY_OK;
+}
+
+/*
+ * One round of traffic on both functions.
+ */
+static bool_t round_trip(uint32_t round) {
+  static uint8_t out[LOOPBACK_SIZE], in[LOOPBACK_SIZE];
+  size_t n, received;
+  uint32_t i;
+  bool_t failed;
+
+  for (i = 0; i < LOOPBACK_SIZE; i++)
+    out[i] = pattern(round * LOOPBACK_SIZE + i);
+
+  /* Both functions have their data in flight at the same time.*/
+  n = ECHO_SIZE;
+  failed = usbSimHostOut(&USBD1, USB_CDC_DATA_EP, out, &n,
+                         MS2ST(100)) != RDY_OK;
+  n = LOOPBACK_SIZE;
+  failed |= usbSimHostOut(&USBD1, USB_LOOPBACK_EP, out, &n,
+                          MS2ST(100)) != RDY_OK;
+  n = LOOPBACK_SIZE;
+  failed |= usbSimHostIn(&USBD1, USB_LOOPBACK_EP, in, &n,
+                         MS2ST(100)) != RDY_OK;
+  failed |= (n != LOOPBACK_SIZE) || (memcmp(in, out, LOOPBACK_SIZE) != 0);
+
+  received = 0;
+  while (!failed && (received < ECHO_SIZE)) {
+    n = ECHO_SIZE - received;
+    failed = usbSimHostIn(&USBD1, USB_CDC_DATA_EP, in + received, &n,
+                          MS2ST(100)) != RDY_OK;
+    received += n;
+  }
+  return failed || (memcmp(in, out, ECHO_SIZE) != 0);
+}
+
+/*
+ * Application entry point.
+ */
+int main(void) {
+  static const uint8_t linecoding[7] = {0x00, 0x96, 0x00, 0x00, 0, 0, 8};
+  uint8_t buf[256];
+  USBSimStats s0, s1;
+  Thread *tp;
+  uint32_t i, count;
+  size_t n;
+  msg_t msg;
+  bool_t failed;
+
+  /*
+   * System initializations.
+   * - HAL initialization, this also initializes the configured device drivers
+   *   and performs the board-specific initializations.
+   * - Kernel initialization, the main() function becomes a thread and the
+   *   RTOS is active.
+   */
+  halInit();
+  chSysInit();
+
+  printf("Simulated bus speed                     : %s\n",
+         USB_SIM_HIGH_SPEED ? "high" : "full");
+
+  /*
+   * Device side, Serial over USB and loopback functions.
+   */
+  sduObjectInit(&SDU1);
+  sduStart(&SDU1, &serusbcfg);
+  ucdObjectInit(&UCD1);
+  ucdStart(&UCD1, &ucdcfg);
+  usbConnectBus(&USBD1);
+  simtest_check(usbSimHostReset(&USBD1) != RDY_OK, "Bus reset");
+
+  /*
+   * Enumeration, the descriptors come from the composite tables.
+   */
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                USB_DESCRIPTOR_DEVICE << 8, 0, 64, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 18) || (buf[4] != 0xEF) ||
+                (memcmp(buf, composite_device_descriptor.ud_string, n) != 0),
+                "Device descriptor");
+  msg = control(RT_DEV_OUT, USB_REQ_SET_ADDRESS, 5, 0, 0, NULL, NULL);
+  simtest_check((msg != RDY_OK) || (USBD1.address != 5), "Address");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                USB_DESCRIPTOR_CONFIGURATION << 8, 0, 255, buf, &n);
+  simtest_check((msg != RDY_OK) ||
+                (n != composite_configuration_descriptor.ud_size) ||
+                ((size_t)usbFetchWord(&buf[2]) != n) ||
+                (buf[4] != USB_NUM_INTERFACES) ||
+                (buf[USB_COMPOSITE_CONFIGURATION_DESC_SIZE + 1] !=
+                 USB_DESCRIPTOR_INTERFACE_ASSOCIATION) ||
+                (memcmp(buf, composite_configuration_descriptor.ud_string,
+                        n) != 0),
+                "Configuration descriptor");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                (USB_DESCRIPTOR_STRING << 8) | 2, 0x0409, 255, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 52) || (buf[2] != 'C'),
+                "String descriptor");
+  msg = control(RT_DEV_IN, USB_REQ_GET_DESCRIPTOR,
+                (USB_DESCRIPTOR_STRING << 8) | 4, 0x0409, 255, buf, &n);
+  simtest_check(msg != RDY_RESET, "Missing string stalled");
+  n = sizeof (buf);
+  msg = usbSimHostIn(&USBD1, USB_LOOPBACK_EP, buf, &n, MS2ST(100));
+  simtest_check(msg != RDY_RESET, "Endpoints disabled before configuration");
+  msg = control(RT_DEV_OUT, USB_REQ_SET_CONFIGURATION, 1, 0, 0, NULL, NULL);
+  simtest_check((msg != RDY_OK) || (USBD1.state != USB_ACTIVE) ||
+                (loopback_stats.configurations != 1), "Configuration");
+
+  /*
+   * Requests dispatch by interface and endpoint.
+   */
+  memcpy(buf, linecoding, sizeof (linecoding));
+  failed = control(RT_CLASS_OUT, CDC_SET_LINE_CODING, 0, USB_CDC_INTERFACE,
+                   sizeof (linecoding), buf, &n) != RDY_OK;
+  memset(buf, 0, sizeof (linecoding));
+  failed |= control(RT_CLASS_IN, CDC_GET_LINE_CODING, 0, USB_CDC_INTERFACE,
+                    sizeof (linecoding), buf, &n) != RDY_OK;
+  simtest_check(failed || (memcmp(buf, linecoding, sizeof (linecoding)) != 0),
+                "CDC requests on the CDC interface");
+  msg = control(RT_CLASS_IN, CDC_GET_LINE_CODING, 0, USB_LOOPBACK_INTERFACE,
+                sizeof (linecoding), buf, &n);
+  simtest_check(msg != RDY_RESET, "CDC requests on another function stalled");
+  msg = control(RT_CLASS_IN, CDC_GET_LINE_CODING, 0, 5,
+                sizeof (linecoding), buf, &n);
+  simtest_check(msg != RDY_RESET, "Requests on a missing interface stalled");
+  count = 0xFFFFFFFF;
+  simtest_check(loopback_count(FALSE, &count) || (count != 0),
+                "Vendor request on the interface");
+  count = 0xFFFFFFFF;
+  simtest_check(loopback_count(TRUE, &count) || (count != 0),
+                "Vendor request on the endpoint");
+  msg = control(RT_VENDOR_IF_IN, LOOPBACK_GET_COUNT, 0, USB_CDC_INTERFACE,
+                4, buf, &n);
+  simtest_check(msg != RDY_RESET, "Vendor request on the CDC stalled");
+  msg = control(RT_VENDOR_IN, VENDOR_GET_VERSION, 0, 0, 2, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 2) ||
+                (usbFetchWord(buf) != VENDOR_VERSION),
+                "Device vendor request");
+  msg = control(RT_IF_IN, USB_REQ_GET_INTERFACE, 0, USB_CDC_INTERFACE + 1,
+                1, buf, &n);
+  simtest_check((msg != RDY_OK) || (n != 1) || (buf[0] != 0), "Get interface");
+  failed = control(RT_IF_OUT, USB_REQ_SET_INTERFACE, 0,
+                   USB_LOOPBACK_INTERFACE, 0, NULL, NULL) != RDY_OK;
+  failed |= control(RT_IF_OUT, USB_REQ_SET_INTERFACE, 1,
+                    USB_LOOPBACK_INTERFACE, 0, NULL, NULL) != RDY_RESET;
+  simtest_check(failed, "Set interface");
+
+  /*
+   * Both functions moving data at the same time.
+   */
+  tp = chThdCreateStatic(waEcho, sizeof(waEcho), NORMALPRIO + 1,
+                         echo_thread, NULL);
+  failed = FALSE;
+  usbSimGetBusStats(&USBD1, &s0);
+  for (i = 0; i < ROUNDS && !failed; i++)
+    failed = round_trip(i);
+  usbSimGetBusStats(&USBD1, &s1);
+  failed |= chThdWait(tp) != RDY_OK;
+  printf("Concurrent functions\n");
+  printf("  %-38s: %u\n", "Frames", s1.frames - s0.frames);
+  printf("  %-38s: %u\n", "Packets", s1.packets - s0.packets);
+  printf("  %-38s: %.2f frames\n", "Round",
+         (double)(s1.frames - s0.frames) / ROUNDS);
+  simtest_check(failed, "  Echoed and looped back data");
+  simtest_check(loopback_count(FALSE, &count) || (count != ROUNDS),
+                "  Loopback transfers");
+
+  /*
+   * Bus reset, the functions are notified and the endpoints are enabled
+   * again by the next configuration.
+   */
+  simtest_check(usbSimHostReset(&USBD1) != RDY_OK ||
+                (loopback_stats.resets != 2), "Functions reset");
+  n = sizeof (buf);
+  msg = usbSimHostIn(&USBD1, USB_LOOPBACK_EP, buf, &n, MS2ST(100));
+  simtest_check(msg != RDY_RESET, "Endpoints disabled by the reset");
+  simtest_check(enumerate() || (loopback_stats.configurations != 2),
+                "Enumeration after reset");
+  tp = chThdCreateStatic(waEcho, sizeof(waEcho), NORMALPRIO + 1,
+                         echo_thread, NULL);
+  failed = FALSE;
+  for (i = 0; i < ROUNDS && !failed; i++)
+    failed = round_trip(i);
+  failed |= chThdWait(tp) != RDY_OK;
+  simtest_check(failed, "  Echoed and looped back data");
+
+  /*
+   * Configuration zero, the endpoints are disabled.
+   */
+  msg = control(RT_DEV_OUT, USB_REQ_SET_CONFIGURATION, 0, 0, 0, NULL, NULL);
+  failed = (msg != RDY_OK) || (USBD1.state != USB_SELECTED);
+  n = sizeof (buf);
+  failed |= usbSimHostIn(&USBD1, USB_LOOPBACK_EP, buf, &n,
+                         MS2ST(100)) != RDY_RESET;
+  n = sizeof (buf);
+  failed |= usbSimHostIn(&USBD1, USB_CDC_DATA_EP, buf, &n,
+                         MS2ST(100)) != RDY_RESET;
+  simtest_check(failed, "Deconfiguration");
+
+  usbDisconnectBus(&USBD1);
+  ucdStop(&UCD1);
+  sduStop(&SDU1);
+  return 0;
+}
@@ -0,0 +1,379 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "hal.h"
+
+#include "usbcfg.h"
+
+/*
+ * Configuration descriptor size.
+ */
+#define CONFIGURATION_DESC_SIZE (USB_COMPOSITE_CONFIGURATION_DESC_SIZE +    \
+                                 USB_COMPOSITE_CDC_ACM_DESC_SIZE +          \
+                                 USB_COMPOSITE_BULK_DESC_SIZE)
+
+SerialUSBDriver SDU1;
+USBCompositeDriver UCD1;
+LoopbackStats loopback_stats;
+
+/*
+ * USB Device Descriptor.
+ */
+static const uint8_t composite_device_descriptor_data[18] = {
+  USB_COMPOSITE_DEVICE_DESC(0x0200,     /* bcdUSB (2.0).                    */
+                            0x40,       /* bMaxPacketSize.                  */
+                            0x0483,     /* idVendor (ST).                   */
+                            0x5743,     /* idProduct.                       */
+                            0x0200,     /* bcdDevice.                       */
+                            1,          /* iManufacturer.                   */
+                            2,          /* iProduct.                        */
+                            3)          /* iSerialNumber.                   */
+};
+
+/*
+ * Device Descriptor wrapper.
+ */
+const USBDescriptor composite_device_descriptor = {
+  sizeof composite_device_descriptor_data,
+  composite_device_descriptor_data
+};
+
+/*
+ * Configuration Descriptor tree, a CDC ACM function and a vendor loopback
+ * function.
+ */
+static const uint8_t
+composite_configuration_descriptor_data[CONFIGURATION_DESC_SIZE] = {
+  USB_COMPOSITE_CONFIGURATION_DESC(CONFIGURATION_DESC_SIZE,
+                                   USB_NUM_INTERFACES,
+                                   0xC0,    /* bmAttributes (self powered). */
+                                   50),     /* bMaxPower (100mA).           */
+  USB_COMPOSITE_CDC_ACM_DESC(USB_CDC_INTERFACE,
+                             USB_CDC_INTERRUPT_EP,
+                             0x0008,        /* Interrupt wMaxPacketSize.    */
+                             0xFF,          /* Interrupt bInterval.         */
+                             USB_CDC_DATA_EP,
+                             USB_CDC_DATA_EP,
+                             USB_BULK_PACKET_SIZE,
+                             0),            /* iFunction.                   */
+  USB_COMPOSITE_BULK_DESC(USB_LOOPBACK_INTERFACE,
+                          0xFF,             /* bInterfaceClass (vendor).    */
+                          0x00,             /* bInterfaceSubClass.          */
+                          0x00,             /* bInterfaceProtocol.          */
+                          USB_LOOPBACK_EP,
+                          USB_LOOPBACK_EP,
+                          USB_BULK_PACKET_SIZE,
+                          0)                /* iInterface.                  */
+};
+
+/*
+ * Configuration Descriptor wrapper.
+ */
+const USBDescriptor composite_configuration_descriptor = {
+  sizeof composite_configuration_descriptor_data,
+  composite_configuration_descriptor_data
+};
+
+/*
+ * U.S. English language identifier.
+ */
+static const uint8_t composite_string0[] = {
+  USB_DESC_BYTE(4),                     /* bLength.                         */
+  USB_DESC_BYTE(USB_DESCRIPTOR_STRING), /* bDescriptorType.                 */
+  USB_DESC_WORD(0x0409)                 /* wLANGID (U.S. English).          */
+};
+
+/*
+ * Vendor string.
+ */
+static const uint8_t composite_string1[] = {
+  USB_DESC_BYTE(38),                    /* bLength.                         */
+  USB_DESC_BYTE(USB_DESCRIPTOR_STRING), /* bDescriptorType.                 */
+  'S', 0, 'T', 0, 'M', 0, 'i', 0, 'c', 0, 'r', 0, 'o', 0, 'e', 0,
+  'l', 0, 'e', 0, 'c', 0, 't', 0, 'r', 0, 'o', 0, 'n', 0, 'i', 0,
+  'c', 0, 's', 0
+};
+
+/*
+ * Device Description string.
+ */
+static const uint8_t composite_string2[] = {
+  USB_DESC_BYTE(52),                    /* bLength.                         */
+  USB_DESC_BYTE(USB_DESCRIPTOR_STRING), /* bDescriptorType.                 */
+  'C', 0, 'h', 0, 'i', 0, 'b', 0, 'i', 0, 'O', 0, 'S', 0, '/', 0,
+  'R', 0, 'T', 0, ' ', 0, 'C', 0, 'o', 0, 'm', 0, 'p', 0, 'o', 0,
+  's', 0, 'i', 0, 't', 0, 'e', 0, ' ', 0, 'D', 0, 'e', 0, 'm', 0,
+  'o', 0
+};
+
+/*
+ * Serial Number string.
+ */
+static const uint8_t composite_string3[] = {
+  USB_DESC_BYTE(8),                     /* bLength.                         */
+  USB_DESC_BYTE(USB_DESCRIPTOR_STRING), /* bDescriptorType.                 */
+  '0' + CH_KERNEL_MAJOR, 0,
+  '0' + CH_KERNEL_MINOR, 0,
+  '0' + CH_KERNEL_PATCH, 0
+};
+
+/*
+ * Strings wrappers array.
+ */
+static const USBDescriptor composite_strings[] = {
+  {sizeof composite_string0, composite_string0},
+  {sizeof composite_string1, composite_string1},
+  {sizeof composite_string2, composite_string2},
+  {sizeof composite_string3, composite_string3}
+};
+
+/*===========================================================================*/
+/* CDC ACM function.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   IN EP1 state.
+ */
+static USBInEndpointState ep1instate;
+
+/**
+ * @brief   OUT EP1 state.
+ */
+static USBOutEndpointState ep1outstate;
+
+/**
+ * @brief   EP1 initialization structure (both IN and OUT).
+ */
+static const USBEndpointConfig ep1config = {
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
+  sduDataTransmitted,
+  sduDataReceived,
+  USB_BULK_PACKET_SIZE,
+  USB_BULK_PACKET_SIZE,
+  &ep1instate,
+  &ep1outstate,
+  1,
+  NULL
+};
+
+/**
+ * @brief   IN EP2 state.
+ */
+static USBInEndpointState ep2instate;
+
+/**
+ * @brief   EP2 initialization structure (IN only).
+ */
+static const USBEndpointConfig ep2config = {
+  USB_EP_MODE_TYPE_INTR,
+  NULL,
+  sduInterruptTransmitted,
+  NULL,
+  0x0010,
+  0x0000,
+  &ep2instate,
+  NULL,
+  1,
+  NULL
+};
+
+/**
+ * @brief   CDC ACM function endpoints.
+ */
+static const USBCompositeEndpoint cdc_endpoints[] = {
+  {USB_CDC_DATA_EP,       &ep1config},
+  {USB_CDC_INTERRUPT_EP,  &ep2config}
+};
+
+/*===========================================================================*/
+/* Loopback function.                                                        */
+/*===========================================================================*/
+
+static uint8_t loopback_buffer[LOOPBACK_BUFFER_SIZE];
+
+/*
+ * Starts receiving the next transfer.
+ */
+static void loopback_receive(USBDriver *usbp, usbep_t ep) {
+
+  usbPrepareReceive(usbp, ep, loopback_buffer, LOOPBACK_BUFFER_SIZE);
+  usbStartReceiveI(usbp, ep);
+}
+
+/*
+ * The received transfer has been sent back.
+ */
+static void loopback_transmitted(USBDriver *usbp, usbep_t ep) {
+
+  chSysLockFromIsr();
+  loopback_stats.transfers++;
+  loopback_receive(usbp, ep);
+  chSysUnlockFromIsr();
+}
+
+/*
+ * A transfer has been received, it is sent back as it is.
+ */
+static void loopback_received(USBDriver *usbp, usbep_t ep) {
+
+  chSysLockFromIsr();
+  usbPrepareTransmit(usbp, ep, loopback_buffer,
+                     usbGetReceiveTransactionSizeI(usbp, ep));
+  usbStartTransmitI(usbp, ep);
+  chSysUnlockFromIsr();
+}
+
+/*
+ * Vendor requests addressed to the loopback interface or endpoint.
+ */
+static bool_t loopback_requests_hook(USBDriver *usbp) {
+
+  if ((usbp->setup[0] & USB_RTYPE_TYPE_MASK) != USB_RTYPE_TYPE_VENDOR)
+    return FALSE;
+  switch (usbp->setup[1]) {
+  case LOOPBACK_GET_COUNT:
+    usbSetupTransfer(usbp, (uint8_t *)&loopback_stats.transfers,
+                     sizeof (loopback_stats.transfers), NULL);
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/*
+ * Loopback function events, the first transfer is started on
+ * configuration.
+ */
+static void loopback_event(USBDriver *usbp, usbevent_t event, void *arg) {
+
+  (void)arg;
+  switch (event) {
+  case USB_EVENT_RESET:
+    loopback_stats.resets++;
+    return;
+  case USB_EVENT_CONFIGURED:
+    if (usbp->state == USB_ACTIVE) {
+      loopback_stats.configurations++;
+      loopback_receive(usbp, USB_LOOPBACK_EP);
+    }
+    return;
+  default:
+    return;
+  }
+}
+
+/**
+ * @brief   IN EP3 state.
+ */
+static USBInEndpointState ep3instate;
+
+/**
+ * @brief   OUT EP3 state.
+ */
+static USBOutEndpointState ep3outstate;
+
+/**
+ * @brief   EP3 initialization structure (both IN and OUT).
+ */
+static const USBEndpointConfig ep3config = {
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
+  loopback_transmitted,
+  loopback_received,
+  USB_BULK_PACKET_SIZE,
+  USB_BULK_PACKET_SIZE,
+  &ep3instate,
+  &ep3outstate,
+  1,
+  NULL
+};
+
+/**
+ * @brief   Loopback function endpoints.
+ */
+static const USBCompositeEndpoint loopback_endpoints[] = {
+  {USB_LOOPBACK_EP,       &ep3config}
+};
+
+/*===========================================================================*/
+/* Composite device.                                                         */
+/*===========================================================================*/
+
+/*
+ * Functions of the device, the requests addressed to an interface or
+ * endpoint are dispatched to the owner function.
+ */
+static const USBCompositeFunction functions[] = {
+  {
+    USB_CDC_INTERFACE, 2,
+    2, cdc_endpoints,
+    sduRequestsHook,
+    ucdSerialUSBEventHookI,
+    &SDU1
+  },
+  {
+    USB_LOOPBACK_INTERFACE, 1,
+    1, loopback_endpoints,
+    loopback_requests_hook,
+    loopback_event,
+    NULL
+  }
+};
+
+/*
+ * Vendor requests addressed to the device.
+ */
+static const uint8_t vendor_version[2] = {USB_DESC_WORD(VENDOR_VERSION)};
+
+static bool_t device_requests_hook(USBDriver *usbp) {
+
+  if ((usbp->setup[0] == (USB_RTYPE_DIR_DEV2HOST | USB_RTYPE_TYPE_VENDOR |
+                          USB_RTYPE_RECIPIENT_DEVICE)) &&
+      (usbp->setup[1] == VENDOR_GET_VERSION)) {
+    usbSetupTransfer(usbp, (uint8_t *)vendor_version,
+                     sizeof (vendor_version), NULL);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/*
+ * Composite device configuration.
+ */
+const USBCompositeConfig ucdcfg = {
+  &USBD1,
+  &composite_device_descriptor,
+  &composite_configuration_descriptor,
+  composite_strings,
+  4,
+  2,
+  functions,
+  device_requests_hook,
+  NULL,
+  NULL
+};
+
+/*
+ * Serial over USB driver configuration.
+ */
+const SerialUSBConfig serusbcfg = {
+  &USBD1,
+  USB_CDC_DATA_EP,
+  USB_CDC_DATA_EP,
+  USB_CDC_INTERRUPT_EP
+};
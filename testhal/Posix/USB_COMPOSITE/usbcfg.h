@@ -0,0 +1,70 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef _USBCFG_H_
+#define _USBCFG_H_
+
+#include "usb_composite.h"
+
+/*
+ * Interfaces and endpoints, the bulk endpoints size depends on the
+ * simulated bus speed.
+ */
+#define USB_CDC_INTERFACE               0
+#define USB_LOOPBACK_INTERFACE          2
+#define USB_NUM_INTERFACES              3
+
+#define USB_CDC_DATA_EP                 1
+#define USB_CDC_INTERRUPT_EP            2
+#define USB_LOOPBACK_EP                 3
+
+#if USB_SIM_HIGH_SPEED
+#define USB_BULK_PACKET_SIZE            512
+#else
+#define USB_BULK_PACKET_SIZE            64
+#endif
+
+/*
+ * Loopback function, the data received on the OUT endpoint is sent back
+ * on the IN endpoint.
+ */
+#define LOOPBACK_BUFFER_SIZE            4096
+#define LOOPBACK_GET_COUNT              0x01
+
+/*
+ * Device vendor request, not addressed to a function.
+ */
+#define VENDOR_GET_VERSION              0x10
+#define VENDOR_VERSION                  0x0100
+
+/*
+ * Loopback function statistics.
+ */
+typedef struct {
+  uint32_t                      transfers;
+  uint32_t                      resets;
+  uint32_t                      configurations;
+} LoopbackStats;
+
+extern SerialUSBDriver SDU1;
+extern USBCompositeDriver UCD1;
+extern LoopbackStats loopback_stats;
+extern const USBCompositeConfig ucdcfg;
+extern const SerialUSBConfig serusbcfg;
+extern const USBDescriptor composite_device_descriptor;
+extern const USBDescriptor composite_configuration_descriptor;
+
+#endif  /* _USBCFG_H_ */
@@ -0,0 +1,56 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simtest.c
+ * @brief   Posix simulator test programs helpers code.
+ * @details Helpers shared by the test programs running in the simulator,
+ *          the results are printed one per line and the program exits
+ *          with a non zero code on the first failed check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ch.h"
+#include "simtest.h"
+
+/**
+ * @brief   Prints the result of a check.
+ * @details The program exits with code 1 if the check failed.
+ *
+ * @param[in] failed    the check result, @p TRUE if failed
+ * @param[in] msg       the check description
+ */
+void simtest_check(bool_t failed, const char *msg) {
+
+  printf("%-40s: %s\n", msg, failed ? "FAILED" : "OK");
+  if (failed)
+    exit(1);
+}
+
+/**
+ * @brief   Host monotonic time.
+ *
+ * @return              The time in nanoseconds.
+ */
+uint64_t simtest_now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
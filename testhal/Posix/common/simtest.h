@@ -0,0 +1,34 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    simtest.h
+ * @brief   Posix simulator test programs helpers header.
+ */
+
+#ifndef _SIMTEST_H_
+#define _SIMTEST_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void simtest_check(bool_t failed, const char *msg);
+  uint64_t simtest_now_ns(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SIMTEST_H_ */
@@ -0,0 +1,5 @@
+# Helpers shared by the Posix simulator test programs.
+SIMTESTSRC = ${CHIBIOS}/testhal/Posix/common/simtest.c
+
+# Required include directories
+SIMTESTINC = ${CHIBIOS}/testhal/Posix/common